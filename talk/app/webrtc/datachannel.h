@@ -49,6 +49,12 @@ class DataChannelProviderInterface {
   virtual bool SendData(const cricket::SendDataParams& params,
                         const rtc::Buffer& payload,
                         cricket::SendDataResult* result) = 0;
+  // Sends |count| messages with the same |params| to the transport, stopping
+  // at the first one that fails. Returns the number of messages sent.
+  virtual int SendDataBatch(const cricket::SendDataParams& params,
+                            const rtc::Buffer* payloads,
+                            int count,
+                            cricket::SendDataResult* result) = 0;
   // Connects to the transport signals.
   virtual bool ConnectDataChannel(DataChannel* data_channel) = 0;
   // Disconnects from the transport signals.
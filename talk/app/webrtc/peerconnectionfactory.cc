@@ -168,6 +168,7 @@ bool PeerConnectionFactory::Initialize() {
   if (!channel_manager_->Init()) {
     return false;
   }
+  channel_manager_->SetEnableGcmCiphers(options_.enable_gcm_crypto_suites);
 
   dtls_identity_store_.reset(
       new DtlsIdentityStore(signaling_thread_, worker_thread_));
@@ -176,6 +177,13 @@ bool PeerConnectionFactory::Initialize() {
   return true;
 }
 
+void PeerConnectionFactory::SetOptions(const Options& options) {
+  options_ = options;
+  if (channel_manager_) {
+    channel_manager_->SetEnableGcmCiphers(options.enable_gcm_crypto_suites);
+  }
+}
+
 rtc::scoped_refptr<AudioSourceInterface>
 PeerConnectionFactory::CreateAudioSource(
     const MediaConstraintsInterface* constraints) {
@@ -42,9 +42,7 @@ class DtlsIdentityStore;
 
 class PeerConnectionFactory : public PeerConnectionFactoryInterface {
  public:
-  virtual void SetOptions(const Options& options) {
-    options_ = options;
-  }
+  void SetOptions(const Options& options) override;
 
   virtual rtc::scoped_refptr<PeerConnectionInterface>
       CreatePeerConnection(
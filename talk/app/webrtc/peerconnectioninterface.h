@@ -525,7 +525,8 @@ class PeerConnectionFactoryInterface : public rtc::RefCountInterface {
       disable_encryption(false),
       disable_sctp_data_channels(false),
       network_ignore_mask(rtc::kDefaultNetworkIgnoreMask),
-      ssl_max_version(rtc::SSL_PROTOCOL_DTLS_10) {
+      ssl_max_version(rtc::SSL_PROTOCOL_DTLS_10),
+      enable_gcm_crypto_suites(false) {
     }
     bool disable_encryption;
     bool disable_sctp_data_channels;
@@ -539,6 +540,11 @@ class PeerConnectionFactoryInterface : public rtc::RefCountInterface {
     // supported by both ends will be used for the connection, i.e. if one
     // party supports DTLS 1.0 and the other DTLS 1.2, DTLS 1.0 will be used.
     rtc::SSLProtocolVersion ssl_max_version;
+
+    // Offers the AES-GCM SRTP cipher suites (RFC 7714) for DTLS-SRTP, ahead
+    // of the AES-CM ones, if the SRTP library supports them. They are never
+    // offered for SDES.
+    bool enable_gcm_crypto_suites;
   };
 
   virtual void SetOptions(const Options& options) = 0;
@@ -54,6 +54,17 @@ class FakeDataChannelProvider : public webrtc::DataChannelProviderInterface {
     return true;
   }
 
+  int SendDataBatch(const cricket::SendDataParams& params,
+                    const rtc::Buffer* payloads,
+                    int count,
+                    cricket::SendDataResult* result) override {
+    int sent = 0;
+    while (sent < count && SendData(params, payloads[sent], result)) {
+      ++sent;
+    }
+    return sent;
+  }
+
   bool ConnectDataChannel(webrtc::DataChannel* data_channel) override {
     ASSERT(connected_channels_.find(data_channel) == connected_channels_.end());
     if (!transport_available_) {
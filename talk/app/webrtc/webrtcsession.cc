@@ -493,6 +493,8 @@ WebRtcSession::WebRtcSession(
       older_version_remote_peer_(false),
       dtls_enabled_(false),
       data_channel_type_(cricket::DCT_NONE),
+      data_send_buffer_size_(0),
+      data_recv_buffer_size_(0),
       ice_restart_latch_(new IceRestartAnswerLatch),
       metrics_observer_(NULL) {
 }
@@ -1203,6 +1205,17 @@ bool WebRtcSession::SendData(const cricket::SendDataParams& params,
   return data_channel_->SendData(params, payload, result);
 }
 
+int WebRtcSession::SendDataBatch(const cricket::SendDataParams& params,
+                                 const rtc::Buffer* payloads,
+                                 int count,
+                                 cricket::SendDataResult* result) {
+  if (!data_channel_) {
+    LOG(LS_ERROR) << "SendDataBatch called when data_channel_ is NULL.";
+    return 0;
+  }
+  return data_channel_->SendDataBatch(params, payloads, count, result);
+}
+
 bool WebRtcSession::ConnectDataChannel(DataChannel* webrtc_data_channel) {
   if (!data_channel_) {
     LOG(LS_ERROR) << "ConnectDataChannel called when data_channel_ is NULL.";
@@ -1288,6 +1301,15 @@ cricket::DataChannelType WebRtcSession::data_channel_type() const {
   return data_channel_type_;
 }
 
+void WebRtcSession::SetDataBufferSizes(int send_buffer_size,
+                                       int recv_buffer_size) {
+  data_send_buffer_size_ = send_buffer_size;
+  data_recv_buffer_size_ = recv_buffer_size;
+  if (data_channel_ && data_channel_type_ == cricket::DCT_SCTP) {
+    data_channel_->SetBufferSizes(send_buffer_size, recv_buffer_size);
+  }
+}
+
 bool WebRtcSession::IceRestartPending() const {
   return ice_restart_latch_->Get();
 }
@@ -1672,6 +1694,10 @@ bool WebRtcSession::CreateDataChannel(const cricket::ContentInfo* content) {
   }
 
   if (sctp) {
+    if (data_send_buffer_size_ != 0 || data_recv_buffer_size_ != 0) {
+      data_channel_->SetBufferSizes(data_send_buffer_size_,
+                                    data_recv_buffer_size_);
+    }
     mediastream_signaling_->OnDataTransportCreatedForSctp();
     data_channel_->SignalDataReceived.connect(
         this, &WebRtcSession::OnDataChannelMessageReceived);
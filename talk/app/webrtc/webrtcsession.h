@@ -219,6 +219,10 @@ class WebRtcSession : public cricket::BaseSession,
   bool SendData(const cricket::SendDataParams& params,
                 const rtc::Buffer& payload,
                 cricket::SendDataResult* result) override;
+  int SendDataBatch(const cricket::SendDataParams& params,
+                    const rtc::Buffer* payloads,
+                    int count,
+                    cricket::SendDataResult* result) override;
   bool ConnectDataChannel(DataChannel* webrtc_data_channel) override;
   void DisconnectDataChannel(DataChannel* webrtc_data_channel) override;
   void AddSctpDataStream(int sid) override;
@@ -236,6 +240,11 @@ class WebRtcSession : public cricket::BaseSession,
 
   cricket::DataChannelType data_channel_type() const;
 
+  // Sets the sizes in bytes of the SCTP send and receive buffers, zero
+  // meaning usrsctp's default. Only affects an association that is set up
+  // afterwards.
+  void SetDataBufferSizes(int send_buffer_size, int recv_buffer_size);
+
   bool IceRestartPending() const;
 
   void ResetIceRestartLatch();
@@ -396,6 +405,9 @@ class WebRtcSession : public cricket::BaseSession,
   // 2. If constraint kEnableRtpDataChannels is true, RTP is allowed (DCT_RTP);
   // 3. If both 1&2 are false, data channel is not allowed (DCT_NONE).
   cricket::DataChannelType data_channel_type_;
+  // Buffer sizes for the SCTP data channel, or 0 for the defaults.
+  int data_send_buffer_size_;
+  int data_recv_buffer_size_;
   rtc::scoped_ptr<IceRestartAnswerLatch> ice_restart_latch_;
 
   rtc::scoped_ptr<WebRtcSessionDescriptionFactory>
@@ -45,6 +45,7 @@ class TurnFileAuth : public cricket::TurnAuthInterface {
                       std::string* key) {
     // File is stored as lines of <username>=<HA1>.
     // Generate HA1 via "echo -n "<username>:<realm>:<password>" | md5sum"
+    // Called on all the relay threads; OptionsFile is only read here.
     std::string hex;
     bool ret = file_.GetStringValue(username, &hex);
     if (ret) {
@@ -59,9 +60,9 @@ class TurnFileAuth : public cricket::TurnAuthInterface {
 };
 
 int main(int argc, char **argv) {
-  if (argc != 5) {
-    std::cerr << "usage: turnserver int-addr ext-ip realm auth-file"
-              << std::endl;
+  if (argc != 5 && argc != 6) {
+    std::cerr << "usage: turnserver int-addr ext-ip realm auth-file "
+              << "[num-threads]" << std::endl;
     return 1;
   }
 
@@ -77,7 +78,34 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  int num_threads = 1;
+  if (argc == 6 && (!rtc::FromString(argv[5], &num_threads) ||
+                    num_threads < 1)) {
+    std::cerr << "Invalid number of threads: " << argv[5] << std::endl;
+    return 1;
+  }
+
   rtc::Thread* main = rtc::Thread::Current();
+  TurnFileAuth auth(argv[4]);
+  if (num_threads > 1) {
+    cricket::ShardedTurnServer server(num_threads);
+    server.set_realm(argv[3]);
+    server.set_software(kSoftware);
+    server.set_auth_hook(&auth);
+    server.SetExternalAddress(rtc::SocketAddress(ext_addr, 0));
+    if (!server.AddInternalUdpSocket(int_addr, NULL)) {
+      std::cerr << "Failed to create a UDP socket bound at"
+                << int_addr.ToString() << std::endl;
+      return 1;
+    }
+
+    std::cout << "Listening internally at " << int_addr.ToString()
+              << " on " << num_threads << " threads" << std::endl;
+
+    main->Run();
+    return 0;
+  }
+
   rtc::AsyncUDPSocket* int_socket =
       rtc::AsyncUDPSocket::Create(main->socketserver(), int_addr);
   if (!int_socket) {
@@ -87,7 +115,6 @@ int main(int argc, char **argv) {
   }
 
   cricket::TurnServer server(main);
-  TurnFileAuth auth(argv[4]);
   server.set_realm(argv[3]);
   server.set_software(kSoftware);
   server.set_auth_hook(&auth);
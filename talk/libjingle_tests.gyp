@@ -78,6 +78,7 @@
       'type': 'executable',
       'dependencies': [
         '<(webrtc_root)/base/base_tests.gyp:rtc_base_tests_utils',
+        '<(webrtc_root)/test/test.gyp:test_support',
         'libjingle.gyp:libjingle_media',
         'libjingle_unittest_main',
       ],
@@ -96,7 +97,9 @@
         'media/base/videoengine_unittest.h',
         'media/devices/dummydevicemanager_unittest.cc',
         'media/devices/filevideocapturer_unittest.cc',
+        'media/sctp/sctpdataengine_perftest.cc',
         'media/sctp/sctpdataengine_unittest.cc',
+        'media/sctp/sctpfakenetworkinterface.h',
         'media/webrtc/simulcast_unittest.cc',
         'media/webrtc/webrtcpassthroughrender_unittest.cc',
         'media/webrtc/webrtcvideocapturer_unittest.cc',
@@ -134,6 +137,7 @@
         }],
         ['OS=="ios"', {
           'sources!': [
+            'media/sctp/sctpdataengine_perftest.cc',
             'media/sctp/sctpdataengine_unittest.cc',
           ],
         }],
@@ -144,6 +148,7 @@
       'type': 'executable',
       'dependencies': [
         '<(webrtc_root)/base/base_tests.gyp:rtc_base_tests_utils',
+        '<(webrtc_root)/test/test.gyp:test_support',
         'libjingle.gyp:libjingle',
         'libjingle.gyp:libjingle_p2p',
         'libjingle_unittest_main',
@@ -159,6 +164,7 @@
         'session/media/mediarecorder_unittest.cc',
         'session/media/mediasession_unittest.cc',
         'session/media/rtcpmuxfilter_unittest.cc',
+        'session/media/srtpfilter_perftest.cc',
         'session/media/srtpfilter_unittest.cc',
       ],
       'conditions': [
@@ -511,6 +511,15 @@ class MediaChannel : public sigslot::has_slots<> {
         rtc::DiffServCodePoint dscp = rtc::DSCP_NO_CHANGE) = 0;
     virtual int SetOption(SocketType type, rtc::Socket::Option opt,
                           int option) = 0;
+    // Sends an RTP packet that is only valid for the duration of the call,
+    // so an implementation that can send it right away needn't copy it.
+    virtual bool SendTransientPacket(
+        const uint8* data,
+        size_t size,
+        rtc::DiffServCodePoint dscp = rtc::DSCP_NO_CHANGE) {
+      rtc::Buffer packet(data, size);
+      return SendPacket(&packet, dscp);
+    }
     virtual ~NetworkInterface() {}
   };
 
@@ -570,6 +579,15 @@ class MediaChannel : public sigslot::has_slots<> {
     return DoSendPacket(packet, true);
   }
 
+  // Sends a packet which the caller may reuse once this returns.
+  bool SendTransientPacket(const uint8* data, size_t size) {
+    rtc::CritScope cs(&network_interface_crit_);
+    if (!network_interface_)
+      return false;
+
+    return network_interface_->SendTransientPacket(data, size);
+  }
+
   int SetOption(NetworkInterface::SocketType type,
                 rtc::Socket::Option opt,
                 int option) {
@@ -1221,6 +1239,24 @@ class DataMediaChannel : public MediaChannel {
       const SendDataParams& params,
       const rtc::Buffer& payload,
       SendDataResult* result = NULL) = 0;
+  // Sends |count| messages with the same |params|, stopping at the first one
+  // that fails. Returns the number of messages sent; |result| is set as by
+  // SendData for the last one tried.
+  virtual int SendDataBatch(
+      const SendDataParams& params,
+      const rtc::Buffer* payloads,
+      int count,
+      SendDataResult* result = NULL) {
+    int sent = 0;
+    while (sent < count && SendData(params, payloads[sent], result))
+      ++sent;
+    return sent;
+  }
+  // Sets the sizes in bytes of the transport's send and receive buffers, zero
+  // meaning the default. Returns false if the channel doesn't support it.
+  virtual bool SetBufferSizes(int send_buffer_size, int recv_buffer_size) {
+    return false;
+  }
   // Signals when data is received (params, data, len)
   sigslot::signal3<const ReceiveDataParams&,
                    const char*,
@@ -29,6 +29,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <sstream>
 #include <vector>
 
@@ -102,24 +103,17 @@ std::string ListArray(const uint16* array, int num_elems) {
 }  // namespace
 
 namespace cricket {
-typedef rtc::ScopedMessageData<SctpInboundPacket> InboundPacketMessage;
-typedef rtc::ScopedMessageData<rtc::Buffer> OutboundPacketMessage;
-
 // The biggest SCTP packet.  Starting from a 'safe' wire MTU value of 1280,
 // take off 80 bytes for DTLS/TURN/TCP/IP overhead.
 static const size_t kSctpMtu = 1200;
 
-enum {
-  MSG_SCTPINBOUNDPACKET = 1,   // MessageData is SctpInboundPacket
-  MSG_SCTPOUTBOUNDPACKET = 2,  // MessageData is rtc:Buffer
-};
+// The most buffers kept for reuse by outbound packets; about as many packets
+// as usrsctp's default 256 KB send buffer holds.
+static const size_t kMaxFreeBuffers = 256;
 
-struct SctpInboundPacket {
-  rtc::Buffer buffer;
-  ReceiveDataParams params;
-  // The |flags| parameter is used by SCTP to distinguish notification packets
-  // from other types of packets.
-  int flags;
+enum {
+  MSG_SCTPINBOUNDPACKETS = 1,   // Packets are in inbound_packets_
+  MSG_SCTPOUTBOUNDPACKETS = 2,  // Packets are in outbound_packets_
 };
 
 // Helper for logging SCTP messages.
@@ -199,10 +193,7 @@ static int OnSctpOutboundPacket(void* addr, void* data, size_t length,
                   << "; set_df: " << std::hex << static_cast<int>(set_df);
 
   VerboseLogPacket(addr, length, SCTP_DUMP_OUTBOUND);
-  // Note: We have to copy the data; the caller will delete it.
-  auto* msg = new OutboundPacketMessage(
-      new rtc::Buffer(reinterpret_cast<uint8_t*>(data), length));
-  channel->worker_thread()->Post(channel, MSG_SCTPOUTBOUNDPACKET, msg);
+  channel->OnSctpOutboundPacket(data, length);
   return 0;
 }
 
@@ -215,9 +206,8 @@ static int OnSctpInboundPacket(struct socket* sock, union sctp_sockstore addr,
                                struct sctp_rcvinfo rcv, int flags,
                                void* ulp_info) {
   SctpDataMediaChannel* channel = static_cast<SctpDataMediaChannel*>(ulp_info);
-  // Post data to the channel's receiver thread (copying it).
-  // TODO(ldixon): Unclear if copy is needed as this method is responsible for
-  // memory cleanup. But this does simplify code.
+  // Queue data for the channel's receiver thread. It takes over 'data', and
+  // frees it after passing it up.
   const SctpDataMediaChannel::PayloadProtocolIdentifier ppid =
       static_cast<SctpDataMediaChannel::PayloadProtocolIdentifier>(
           rtc::HostToNetwork32(rcv.rcv_ppid));
@@ -226,19 +216,18 @@ static int OnSctpInboundPacket(struct socket* sock, union sctp_sockstore addr,
     // It's neither a notification nor a recognized data packet.  Drop it.
     LOG(LS_ERROR) << "Received an unknown PPID " << ppid
                   << " on an SCTP packet.  Dropping.";
+    free(data);
   } else {
-    SctpInboundPacket* packet = new SctpInboundPacket;
-    packet->buffer.SetData(reinterpret_cast<uint8_t*>(data), length);
-    packet->params.ssrc = rcv.rcv_sid;
-    packet->params.seq_num = rcv.rcv_ssn;
-    packet->params.timestamp = rcv.rcv_tsn;
-    packet->params.type = type;
-    packet->flags = flags;
-    // The ownership of |packet| transfers to |msg|.
-    InboundPacketMessage* msg = new InboundPacketMessage(packet);
-    channel->worker_thread()->Post(channel, MSG_SCTPINBOUNDPACKET, msg);
-  }
-  free(data);
+    SctpInboundPacket packet;
+    packet.data = data;
+    packet.length = length;
+    packet.params.ssrc = rcv.rcv_sid;
+    packet.params.seq_num = rcv.rcv_ssn;
+    packet.params.timestamp = rcv.rcv_tsn;
+    packet.params.type = type;
+    packet.flags = flags;
+    channel->QueueInboundPacket(packet);
+  }
   return 1;
 }
 
@@ -322,11 +311,78 @@ SctpDataMediaChannel::SctpDataMediaChannel(rtc::Thread* thread)
       sock_(NULL),
       sending_(false),
       receiving_(false),
+      send_buffer_size_(0),
+      recv_buffer_size_(0),
       debug_name_("SctpDataMediaChannel") {
 }
 
 SctpDataMediaChannel::~SctpDataMediaChannel() {
   CloseSctpSocket();
+  // The worker thread won't get to the packets still queued.
+  rtc::CritScope cs(&packets_crit_);
+  for (size_t i = 0; i < inbound_packets_.size(); ++i) {
+    free(inbound_packets_[i].data);
+  }
+}
+
+void SctpDataMediaChannel::QueueInboundPacket(
+    const SctpInboundPacket& packet) {
+  bool post;
+  {
+    rtc::CritScope cs(&packets_crit_);
+    post = inbound_packets_.empty();
+    inbound_packets_.push_back(packet);
+  }
+  if (post) {
+    worker_thread_->Post(this, MSG_SCTPINBOUNDPACKETS);
+  }
+}
+
+void SctpDataMediaChannel::OnSctpOutboundPacket(const void* data,
+                                                size_t length) {
+  if (rtc::Thread::Current() != worker_thread_) {
+    // |data| is freed once this returns, so it has to be copied.
+    QueueOutboundPacket(data, length);
+    return;
+  }
+  // Keeps the packets in order behind any queued by another thread.
+  bool queued;
+  {
+    rtc::CritScope cs(&packets_crit_);
+    queued = !outbound_packets_.empty();
+  }
+  if (queued) {
+    OnOutboundPacketsFromSctp();
+  }
+  OnPacketFromSctpToNetwork(data, length);
+}
+
+void SctpDataMediaChannel::QueueOutboundPacket(const void* data,
+                                               size_t length) {
+  bool post;
+  {
+    rtc::CritScope cs(&packets_crit_);
+    post = outbound_packets_.empty();
+    if (free_buffers_.empty()) {
+      outbound_packets_.push_back(
+          rtc::Buffer(static_cast<const uint8_t*>(data), length));
+    } else {
+      // Reuses the buffer's memory, since packets are at most kSctpMtu.
+      free_buffers_.back().SetData(static_cast<const uint8_t*>(data), length);
+      outbound_packets_.push_back(free_buffers_.back().Pass());
+      free_buffers_.pop_back();
+    }
+  }
+  if (post) {
+    worker_thread_->Post(this, MSG_SCTPOUTBOUNDPACKETS);
+  }
+}
+
+bool SctpDataMediaChannel::SetBufferSizes(int send_buffer_size,
+                                          int recv_buffer_size) {
+  send_buffer_size_ = send_buffer_size;
+  recv_buffer_size_ = recv_buffer_size;
+  return true;
 }
 
 sockaddr_conn SctpDataMediaChannel::GetSctpSockAddr(int port) {
@@ -384,6 +440,21 @@ bool SctpDataMediaChannel::OpenSctpSocket() {
     return false;
   }
 
+  // The receive buffer has to be set before connecting, as its size is the
+  // window advertised in the INIT chunk.
+  if (send_buffer_size_ > 0 &&
+      usrsctp_setsockopt(sock_, SOL_SOCKET, SO_SNDBUF, &send_buffer_size_,
+                         sizeof(send_buffer_size_))) {
+    LOG_ERRNO(LS_ERROR) << debug_name_ << "Failed to set SO_SNDBUF.";
+    return false;
+  }
+  if (recv_buffer_size_ > 0 &&
+      usrsctp_setsockopt(sock_, SOL_SOCKET, SO_RCVBUF, &recv_buffer_size_,
+                         sizeof(recv_buffer_size_))) {
+    LOG_ERRNO(LS_ERROR) << debug_name_ << "Failed to set SO_RCVBUF.";
+    return false;
+  }
+
   // Nagle.
   uint32_t nodelay = 1;
   if (usrsctp_setsockopt(sock_, IPPROTO_SCTP, SCTP_NODELAY, &nodelay,
@@ -529,6 +600,14 @@ bool SctpDataMediaChannel::SendData(
     const SendDataParams& params,
     const rtc::Buffer& payload,
     SendDataResult* result) {
+  return SendDataBatch(params, &payload, 1, result) == 1;
+}
+
+int SctpDataMediaChannel::SendDataBatch(
+    const SendDataParams& params,
+    const rtc::Buffer* payloads,
+    int count,
+    SendDataResult* result) {
   if (result) {
     // Preset |result| to assume an error.  If SendData succeeds, we'll
     // overwrite |*result| once more at the end.
@@ -537,9 +616,9 @@ bool SctpDataMediaChannel::SendData(
 
   if (!sending_) {
     LOG(LS_WARNING) << debug_name_ << "->SendData(...): "
-                    << "Not sending packet with ssrc=" << params.ssrc
-                    << " len=" << payload.size() << " before SetSend(true).";
-    return false;
+                    << "Not sending " << count << " packets with ssrc="
+                    << params.ssrc << " before SetSend(true).";
+    return 0;
   }
 
   if (params.type != cricket::DMT_CONTROL &&
@@ -547,7 +626,7 @@ bool SctpDataMediaChannel::SendData(
     LOG(LS_WARNING) << debug_name_ << "->SendData(...): "
                     << "Not sending data because ssrc is unknown: "
                     << params.ssrc;
-    return false;
+    return 0;
   }
 
   //
@@ -574,25 +653,31 @@ bool SctpDataMediaChannel::SendData(
   }
 
   // We don't fragment.
-  send_res = usrsctp_sendv(
-      sock_, payload.data(), static_cast<size_t>(payload.size()), NULL, 0, &spa,
-      rtc::checked_cast<socklen_t>(sizeof(spa)), SCTP_SENDV_SPA, 0);
-  if (send_res < 0) {
-    if (errno == SCTP_EWOULDBLOCK) {
-      *result = SDR_BLOCK;
-      LOG(LS_INFO) << debug_name_ << "->SendData(...): EWOULDBLOCK returned";
-    } else {
-      LOG_ERRNO(LS_ERROR) << "ERROR:" << debug_name_
-                          << "->SendData(...): "
-                          << " usrsctp_sendv: ";
+  int sent = 0;
+  for (; sent < count; ++sent) {
+    const rtc::Buffer& payload = payloads[sent];
+    send_res = usrsctp_sendv(
+        sock_, payload.data(), static_cast<size_t>(payload.size()), NULL, 0,
+        &spa, rtc::checked_cast<socklen_t>(sizeof(spa)), SCTP_SENDV_SPA, 0);
+    if (send_res < 0) {
+      if (errno == SCTP_EWOULDBLOCK) {
+        if (result) {
+          *result = SDR_BLOCK;
+        }
+        LOG(LS_INFO) << debug_name_ << "->SendData(...): EWOULDBLOCK returned";
+      } else {
+        LOG_ERRNO(LS_ERROR) << "ERROR:" << debug_name_
+                            << "->SendData(...): "
+                            << " usrsctp_sendv: ";
+      }
+      return sent;
     }
-    return false;
   }
   if (result) {
     // Only way out now is success.
     *result = SDR_SUCCESS;
   }
-  return true;
+  return sent;
 }
 
 // Called by network interface when a packet has been received.
@@ -617,40 +702,55 @@ void SctpDataMediaChannel::OnPacketReceived(
   }
 }
 
+void SctpDataMediaChannel::OnInboundPacketsFromSctp() {
+  // Take the whole batch, so that packets queued while it's handled get a
+  // new message.
+  {
+    rtc::CritScope cs(&packets_crit_);
+    inbound_batch_.swap(inbound_packets_);
+  }
+  for (size_t i = 0; i < inbound_batch_.size(); ++i) {
+    OnInboundPacketFromSctpToChannel(inbound_batch_[i]);
+    free(inbound_batch_[i].data);
+  }
+  inbound_batch_.clear();
+}
+
 void SctpDataMediaChannel::OnInboundPacketFromSctpToChannel(
-    SctpInboundPacket* packet) {
+    const SctpInboundPacket& packet) {
   LOG(LS_VERBOSE) << debug_name_ << "->OnInboundPacketFromSctpToChannel(...): "
                   << "Received SCTP data:"
-                  << " ssrc=" << packet->params.ssrc
-                  << " notification: " << (packet->flags & MSG_NOTIFICATION)
-                  << " length=" << packet->buffer.size();
+                  << " ssrc=" << packet.params.ssrc
+                  << " notification: " << (packet.flags & MSG_NOTIFICATION)
+                  << " length=" << packet.length;
   // Sending a packet with data == NULL (no data) is SCTPs "close the
   // connection" message. This sets sock_ = NULL;
-  if (!packet->buffer.size() || !packet->buffer.data()) {
+  if (!packet.length || !packet.data) {
     LOG(LS_INFO) << debug_name_ << "->OnInboundPacketFromSctpToChannel(...): "
                                    "No data, closing.";
     return;
   }
-  if (packet->flags & MSG_NOTIFICATION) {
-    OnNotificationFromSctp(&packet->buffer);
+  const char* data = static_cast<const char*>(packet.data);
+  if (packet.flags & MSG_NOTIFICATION) {
+    OnNotificationFromSctp(data, packet.length);
   } else {
-    OnDataFromSctpToChannel(packet->params, &packet->buffer);
+    OnDataFromSctpToChannel(packet.params, data, packet.length);
   }
 }
 
 void SctpDataMediaChannel::OnDataFromSctpToChannel(
-    const ReceiveDataParams& params, rtc::Buffer* buffer) {
+    const ReceiveDataParams& params, const char* data, size_t length) {
   if (receiving_) {
     LOG(LS_VERBOSE) << debug_name_ << "->OnDataFromSctpToChannel(...): "
-                    << "Posting with length: " << buffer->size()
+                    << "Posting with length: " << length
                     << " on stream " << params.ssrc;
     // Reports all received messages to upper layers, no matter whether the sid
     // is known.
-    SignalDataReceived(params, buffer->data<char>(), buffer->size());
+    SignalDataReceived(params, data, length);
   } else {
     LOG(LS_WARNING) << debug_name_ << "->OnDataFromSctpToChannel(...): "
                     << "Not receiving packet with sid=" << params.ssrc
-                    << " len=" << buffer->size() << " before SetReceive(true).";
+                    << " len=" << length << " before SetReceive(true).";
   }
 }
 
@@ -707,10 +807,11 @@ bool SctpDataMediaChannel::ResetStream(uint32 ssrc) {
   return true;
 }
 
-void SctpDataMediaChannel::OnNotificationFromSctp(rtc::Buffer* buffer) {
+void SctpDataMediaChannel::OnNotificationFromSctp(const char* data,
+                                                  size_t length) {
   const sctp_notification& notification =
-      reinterpret_cast<const sctp_notification&>(*buffer->data());
-  ASSERT(notification.sn_header.sn_length == buffer->size());
+      reinterpret_cast<const sctp_notification&>(*data);
+  ASSERT(notification.sn_header.sn_length == length);
 
   // TODO(ldixon): handle notifications appropriately.
   switch (notification.sn_header.sn_type) {
@@ -902,14 +1003,33 @@ bool SctpDataMediaChannel::SetRecvCodecs(const std::vector<DataCodec>& codecs) {
       &local_port_);
 }
 
-void SctpDataMediaChannel::OnPacketFromSctpToNetwork(
-    rtc::Buffer* buffer) {
-  if (buffer->size() > kSctpMtu) {
+void SctpDataMediaChannel::OnOutboundPacketsFromSctp() {
+  {
+    rtc::CritScope cs(&packets_crit_);
+    outbound_batch_.swap(outbound_packets_);
+  }
+  for (size_t i = 0; i < outbound_batch_.size(); ++i) {
+    OnPacketFromSctpToNetwork(outbound_batch_[i].data(),
+                              outbound_batch_[i].size());
+  }
+  {
+    rtc::CritScope cs(&packets_crit_);
+    for (size_t i = 0; i < outbound_batch_.size() &&
+                       free_buffers_.size() < kMaxFreeBuffers; ++i) {
+      free_buffers_.push_back(outbound_batch_[i].Pass());
+    }
+  }
+  outbound_batch_.clear();
+}
+
+void SctpDataMediaChannel::OnPacketFromSctpToNetwork(const void* data,
+                                                     size_t length) {
+  if (length > kSctpMtu) {
     LOG(LS_ERROR) << debug_name_ << "->OnPacketFromSctpToNetwork(...): "
                   << "SCTP seems to have made a packet that is bigger "
                      "than its official MTU.";
   }
-  MediaChannel::SendPacket(buffer);
+  MediaChannel::SendTransientPacket(static_cast<const uint8*>(data), length);
 }
 
 bool SctpDataMediaChannel::SendQueuedStreamResets() {
@@ -954,18 +1074,12 @@ bool SctpDataMediaChannel::SendQueuedStreamResets() {
 
 void SctpDataMediaChannel::OnMessage(rtc::Message* msg) {
   switch (msg->message_id) {
-    case MSG_SCTPINBOUNDPACKET: {
-      rtc::scoped_ptr<InboundPacketMessage> pdata(
-          static_cast<InboundPacketMessage*>(msg->pdata));
-      OnInboundPacketFromSctpToChannel(pdata->data().get());
+    case MSG_SCTPINBOUNDPACKETS:
+      OnInboundPacketsFromSctp();
       break;
-    }
-    case MSG_SCTPOUTBOUNDPACKET: {
-      rtc::scoped_ptr<OutboundPacketMessage> pdata(
-          static_cast<OutboundPacketMessage*>(msg->pdata));
-      OnPacketFromSctpToNetwork(pdata->data().get());
+    case MSG_SCTPOUTBOUNDPACKETS:
+      OnOutboundPacketsFromSctp();
       break;
-    }
   }
 }
 }  // namespace cricket
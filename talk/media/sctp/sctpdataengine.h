@@ -45,6 +45,7 @@ enum PreservedErrno {
 #include "talk/media/base/mediachannel.h"
 #include "talk/media/base/mediaengine.h"
 #include "webrtc/base/buffer.h"
+#include "webrtc/base/criticalsection.h"
 #include "webrtc/base/scoped_ptr.h"
 
 // Defined by "usrsctplib/usrsctp.h"
@@ -70,24 +71,36 @@ const int kSctpDefaultPort = 5000;
 // [worker thread (although it can in princple be another thread)]
 //  1.  SctpDataMediaChannel::SendData(data)
 //  2.  usrsctp_sendv(data)
-// [worker thread returns; sctp thread then calls the following]
+// [usrsctp calls the following, on the worker thread while sending or on its
+//  timer thread for retransmissions]
 //  3.  OnSctpOutboundPacket(wrapped_data)
-// [sctp thread returns having posted a message for the worker thread]
-//  4.  SctpDataMediaChannel::OnMessage(wrapped_data)
-//  5.  SctpDataMediaChannel::OnPacketFromSctpToNetwork(wrapped_data)
-//  6.  NetworkInterface::SendPacket(wrapped_data)
-//  7.  ... across network ... a packet is sent back ...
-//  8.  SctpDataMediaChannel::OnPacketReceived(wrapped_data)
-//  9.  usrsctp_conninput(wrapped_data)
+//  4.  SctpDataMediaChannel::OnSctpOutboundPacket(wrapped_data)
+// [on the worker thread, the packet goes straight to step 7; other threads
+//  queue it and post a message for the worker thread, unless one was already
+//  pending]
+//  5.  SctpDataMediaChannel::OnMessage()
+//  6.  SctpDataMediaChannel::OnPacketFromSctpToNetwork(wrapped_data)
+//  7.  NetworkInterface::SendTransientPacket(wrapped_data)
+//  8.  ... across network ... a packet is sent back ...
+//  9.  SctpDataMediaChannel::OnPacketReceived(wrapped_data)
+//  10. usrsctp_conninput(wrapped_data)
 // [worker thread returns; sctp thread then calls the following]
-//  10.  OnSctpInboundData(data)
-// [sctp thread returns having posted a message fot the worker thread]
-//  11. SctpDataMediaChannel::OnMessage(inboundpacket)
-//  12. SctpDataMediaChannel::OnInboundPacketFromSctpToChannel(inboundpacket)
-//  13. SctpDataMediaChannel::OnDataFromSctpToChannel(data)
-//  14. SctpDataMediaChannel::SignalDataReceived(data)
+//  11. OnSctpInboundData(data)
+//  12. SctpDataMediaChannel::QueueInboundPacket(inboundpacket)
+// [sctp thread returns having posted a message fot the worker thread, unless
+//  one was already pending]
+//  13. SctpDataMediaChannel::OnMessage()
+//  14. SctpDataMediaChannel::OnInboundPacketFromSctpToChannel(inboundpacket)
+//  15. SctpDataMediaChannel::OnDataFromSctpToChannel(data)
+//  16. SctpDataMediaChannel::SignalDataReceived(data)
 // [from the same thread, methods registered/connected to
 //  SctpDataMediaChannel are called with the recieved data]
+//
+// Packets from other threads are queued on the channel and handed to the
+// worker thread in batches, so a burst of packets costs one Post. Outbound
+// packets made on the worker thread are sent from usrsctp's buffer, and
+// received data is passed up in the buffer usrsctp allocated for it, so
+// neither is copied.
 class SctpDataEngine : public DataEngineInterface {
  public:
   SctpDataEngine();
@@ -102,9 +115,16 @@ class SctpDataEngine : public DataEngineInterface {
   std::vector<DataCodec> codecs_;
 };
 
-// TODO(ldixon): Make into a special type of TypedMessageData.
-// Holds data to be passed on to a channel.
-struct SctpInboundPacket;
+// Holds data to be passed on to a channel. |data| is allocated by usrsctp,
+// and freed once the channel has handled the packet.
+struct SctpInboundPacket {
+  void* data;
+  size_t length;
+  ReceiveDataParams params;
+  // The |flags| parameter is used by SCTP to distinguish notification packets
+  // from other types of packets.
+  int flags;
+};
 
 class SctpDataMediaChannel : public DataMediaChannel,
                              public rtc::MessageHandler {
@@ -156,6 +176,15 @@ class SctpDataMediaChannel : public DataMediaChannel,
   virtual bool SendData(const SendDataParams& params,
                         const rtc::Buffer& payload,
                         SendDataResult* result = NULL);
+  // Sends |count| messages with the same |params|, stopping at the first one
+  // that doesn't fit in the send buffer. Returns the number of messages sent;
+  // |result| is set as by SendData for the last one tried. The stream is
+  // checked once for the whole batch. On the worker thread, the packets are
+  // sent on the network interface as usrsctp makes them.
+  virtual int SendDataBatch(const SendDataParams& params,
+                            const rtc::Buffer* payloads,
+                            int count,
+                            SendDataResult* result = NULL);
   // A packet is received from the network interface. Posted to OnMessage.
   virtual void OnPacketReceived(rtc::Buffer* packet,
                                 const rtc::PacketTime& packet_time);
@@ -163,6 +192,19 @@ class SctpDataMediaChannel : public DataMediaChannel,
   // Exposed to allow Post call from c-callbacks.
   rtc::Thread* worker_thread() const { return worker_thread_; }
 
+  // Called from the c-callbacks, on any thread. QueueInboundPacket queues a
+  // packet for the worker thread and takes ownership of |packet.data|.
+  // OnSctpOutboundPacket sends |data| on the worker thread and queues a copy
+  // of it on any other thread.
+  void QueueInboundPacket(const SctpInboundPacket& packet);
+  void OnSctpOutboundPacket(const void* data, size_t length);
+
+  // Sets the size in bytes of the socket's send buffer, which bounds the
+  // data queued for sending, and of its receive buffer, which is the window
+  // advertised to the peer. Zero leaves usrsctp's default. Only takes effect
+  // for a socket opened after the call, so call before SetSend(true).
+  virtual bool SetBufferSizes(int send_buffer_size, int recv_buffer_size);
+
   // TODO(ldixon): add a DataOptions class to mediachannel.h
   virtual bool SetOptions(int options) { return false; }
   virtual int GetOptions() const { return 0; }
@@ -211,13 +253,17 @@ class SctpDataMediaChannel : public DataMediaChannel,
   // Queues a stream for reset.
   bool ResetStream(uint32 ssrc);
 
-  // Called by OnMessage to send packet on the network.
-  void OnPacketFromSctpToNetwork(rtc::Buffer* buffer);
-  // Called by OnMessage to decide what to do with the packet.
-  void OnInboundPacketFromSctpToChannel(SctpInboundPacket* packet);
+  // Queues a copy of a packet for the worker thread.
+  void QueueOutboundPacket(const void* data, size_t length);
+  // Called by OnMessage to send the queued packets on the network.
+  void OnOutboundPacketsFromSctp();
+  void OnPacketFromSctpToNetwork(const void* data, size_t length);
+  // Called by OnMessage to decide what to do with the queued packets.
+  void OnInboundPacketsFromSctp();
+  void OnInboundPacketFromSctpToChannel(const SctpInboundPacket& packet);
   void OnDataFromSctpToChannel(const ReceiveDataParams& params,
-                               rtc::Buffer* buffer);
-  void OnNotificationFromSctp(rtc::Buffer* buffer);
+                               const char* data, size_t length);
+  void OnNotificationFromSctp(const char* data, size_t length);
   void OnNotificationAssocChange(const sctp_assoc_change& change);
 
   void OnStreamResetEvent(const struct sctp_stream_reset_event* evt);
@@ -249,6 +295,22 @@ class SctpDataMediaChannel : public DataMediaChannel,
   StreamSet queued_reset_streams_;
   StreamSet sent_reset_streams_;
 
+  // Sizes for SO_SNDBUF and SO_RCVBUF, or 0 for the defaults.
+  int send_buffer_size_;
+  int recv_buffer_size_;
+
+  // Packets queued by the usrsctp callbacks for the worker thread. A message
+  // is posted only when a queue goes from empty to non-empty.
+  rtc::CriticalSection packets_crit_;
+  std::vector<SctpInboundPacket> inbound_packets_;
+  std::vector<rtc::Buffer> outbound_packets_;
+  // Buffers of outbound packets already sent, reused for the next ones.
+  std::vector<rtc::Buffer> free_buffers_;
+  // The batches being handled on the worker thread. They are swapped with
+  // the queues above, so neither side reallocates once warmed up.
+  std::vector<SctpInboundPacket> inbound_batch_;
+  std::vector<rtc::Buffer> outbound_batch_;
+
   // A human-readable name for debugging messages.
   std::string debug_name_;
 };
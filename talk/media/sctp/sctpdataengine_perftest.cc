@@ -0,0 +1,236 @@
+/*
+ * libjingle
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "talk/media/base/mediachannel.h"
+#include "talk/media/sctp/sctpdataengine.h"
+#include "talk/media/sctp/sctpfakenetworkinterface.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/cpumonitor.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+#ifdef HAVE_NSS_SSL_H
+// TODO(thorcarpenter): Remove after webrtc switches over to BoringSSL.
+#include "webrtc/base/nssstreamadapter.h"
+#endif  // HAVE_NSS_SSL_H
+
+namespace cricket {
+namespace {
+
+const int kMessageSize = 1024;
+const int kTotalBytes = 16 * 1024 * 1024;
+const int kBatchSize = 32;
+const int kLargeBufferSize = 1024 * 1024;
+const int kPollMs = 10;
+const int kTimeoutMs = 60000;
+
+// Counts the bytes received on all streams.
+class ByteCounter : public sigslot::has_slots<> {
+ public:
+  ByteCounter() : bytes_(0) {}
+
+  int bytes() const { return bytes_; }
+
+  void OnDataReceived(const ReceiveDataParams& params, const char* data,
+                      size_t length) {
+    bytes_ += static_cast<int>(length);
+  }
+
+ private:
+  int bytes_;
+};
+
+class SctpDataMediaChannelPerfTest : public testing::Test {
+ protected:
+  // usrsctp uses the NSS random number generator on non-Android platforms,
+  // so we need to initialize SSL.
+  static void SetUpTestCase() {
+#ifdef HAVE_NSS_SSL_H
+    if (!rtc::NSSContext::InitializeSSL(NULL)) {
+      LOG(LS_WARNING) << "Unabled to initialize NSS.";
+    }
+#endif  // HAVE_NSS_SSL_H
+  }
+
+  SctpDataMediaChannelPerfTest()
+      : thread_(rtc::Thread::Current()),
+        engine_(new SctpDataEngine()),
+        net1_(thread_),
+        net2_(thread_) {}
+
+  // Sends |kTotalBytes| from one channel to the other, in |kMessageSize|
+  // messages spread round robin over |num_streams| streams, and prints the
+  // throughput and the CPU it took. Messages are sent one at a time with
+  // SendData, or |kBatchSize| at a time with SendDataBatch.
+  void MeasureThroughput(const std::string& trace, int num_streams,
+                         bool batched, int buffer_size) {
+    ConnectChannels(num_streams, buffer_size);
+    const std::vector<char> message(kMessageSize, 0x5a);
+    std::vector<rtc::Buffer> payloads;
+    for (int i = 0; i < kBatchSize; ++i)
+      payloads.push_back(rtc::Buffer(&message[0], message.size()));
+    SendDataParams params;
+    params.type = DMT_BINARY;
+    params.ordered = true;
+    params.reliable = true;
+
+    rtc::CpuSampler sampler;
+    sampler.set_load_interval(0);
+    const bool have_sampler = sampler.Init();
+    if (have_sampler)
+      sampler.GetProcessLoad();  // Starts the measurement.
+    const uint64 start_us = rtc::TimeMicros();
+    int bytes_sent = 0;
+    int stream = 0;
+    while (receiver_.bytes() < kTotalBytes &&
+           rtc::TimeMicros() - start_us < kTimeoutMs * 1000ULL) {
+      SendDataResult result = SDR_BLOCK;
+      if (bytes_sent < kTotalBytes) {
+        params.ssrc = stream + 1;
+        stream = (stream + 1) % num_streams;
+        const int max_count = std::min(
+            kBatchSize, (kTotalBytes - bytes_sent) / kMessageSize);
+        int count = 0;
+        if (batched) {
+          count = channel1_->SendDataBatch(params, &payloads[0], max_count,
+                                           &result);
+        } else {
+          while (count < max_count &&
+                 channel1_->SendData(params, payloads[count], &result)) {
+            ++count;
+          }
+        }
+        bytes_sent += count * kMessageSize;
+        ASSERT_NE(SDR_ERROR, result);
+      }
+      if (result != SDR_SUCCESS) {
+        // The send buffer is full; let some packets through.
+        rtc::Message msg;
+        if (thread_->Get(&msg, kPollMs))
+          thread_->Dispatch(&msg);
+      }
+    }
+    const uint64 elapsed_us = rtc::TimeMicros() - start_us;
+    EXPECT_EQ(kTotalBytes, receiver_.bytes());
+
+    webrtc::test::PrintResult("sctp_throughput", "", trace,
+                              8.0 * receiver_.bytes() / elapsed_us, "Mbps",
+                              true);
+    if (have_sampler) {
+      // Includes the usrsctp threads. 100% is one core.
+      webrtc::test::PrintResult("sctp_cpu_load", "", trace,
+                                100 * sampler.GetProcessLoad(), "%", true);
+    }
+  }
+
+  void ConnectChannels(int num_streams, int buffer_size) {
+    channel1_.reset(CreateChannel(&net1_, buffer_size));
+    channel2_.reset(CreateChannel(&net2_, buffer_size));
+    channel2_->SignalDataReceived.connect(&receiver_,
+                                          &ByteCounter::OnDataReceived);
+    net1_.SetDestination(channel2_.get());
+    net2_.SetDestination(channel1_.get());
+    for (int i = 1; i <= num_streams; ++i) {
+      StreamParams sp(StreamParams::CreateLegacy(i));
+      channel1_->AddSendStream(sp);
+      channel2_->AddSendStream(sp);
+    }
+    // As in the unit tests: the listener connects first, then the connector
+    // once the INIT has been delivered.
+    channel1_->SetReceive(true);
+    channel2_->SetReceive(true);
+    channel2_->SetSend(true);
+    ProcessMessagesUntilIdle();
+    channel1_->SetSend(true);
+  }
+
+  void TearDown() override {
+    channel1_->SetSend(false);
+    channel2_->SetSend(false);
+    ProcessMessagesUntilIdle();
+  }
+
+ private:
+  SctpDataMediaChannel* CreateChannel(SctpFakeNetworkInterface* net,
+                                      int buffer_size) {
+    SctpDataMediaChannel* channel = static_cast<SctpDataMediaChannel*>(
+        engine_->CreateChannel(DCT_SCTP));
+    channel->SetInterface(net);
+    channel->SetBufferSizes(buffer_size, buffer_size);
+    return channel;
+  }
+
+  void ProcessMessagesUntilIdle() {
+    while (!thread_->empty()) {
+      rtc::Message msg;
+      if (thread_->Get(&msg, rtc::Thread::kForever))
+        thread_->Dispatch(&msg);
+    }
+  }
+
+  rtc::Thread* thread_;
+  rtc::scoped_ptr<SctpDataEngine> engine_;
+  SctpFakeNetworkInterface net1_;
+  SctpFakeNetworkInterface net2_;
+  ByteCounter receiver_;
+  rtc::scoped_ptr<SctpDataMediaChannel> channel1_;
+  rtc::scoped_ptr<SctpDataMediaChannel> channel2_;
+};
+
+}  // namespace
+
+TEST_F(SctpDataMediaChannelPerfTest, OneStream) {
+  MeasureThroughput("1_stream", 1, false, 0);
+}
+
+TEST_F(SctpDataMediaChannelPerfTest, OneStreamBatched) {
+  MeasureThroughput("1_stream_batched", 1, true, 0);
+}
+
+TEST_F(SctpDataMediaChannelPerfTest, SixteenStreams) {
+  MeasureThroughput("16_streams", 16, false, 0);
+}
+
+TEST_F(SctpDataMediaChannelPerfTest, SixteenStreamsBatched) {
+  MeasureThroughput("16_streams_batched", 16, true, 0);
+}
+
+// Larger send and receive buffers than usrsctp's defaults.
+TEST_F(SctpDataMediaChannelPerfTest, SixteenStreamsBatchedLargeBuffers) {
+  MeasureThroughput("16_streams_batched_1mb_buffers", 16, true,
+                    kLargeBufferSize);
+}
+
+}  // namespace cricket
@@ -34,6 +34,7 @@
 #include "talk/media/base/constants.h"
 #include "talk/media/base/mediachannel.h"
 #include "talk/media/sctp/sctpdataengine.h"
+#include "talk/media/sctp/sctpfakenetworkinterface.h"
 #include "webrtc/base/bind.h"
 #include "webrtc/base/buffer.h"
 #include "webrtc/base/criticalsection.h"
@@ -50,72 +51,7 @@
 #include "webrtc/base/nssstreamadapter.h"
 #endif  // HAVE_NSS_SSL_H
 
-enum {
-  MSG_PACKET = 1,
-};
-
-// Fake NetworkInterface that sends/receives sctp packets.  The one in
-// talk/media/base/fakenetworkinterface.h only works with rtp/rtcp.
-class SctpFakeNetworkInterface : public cricket::MediaChannel::NetworkInterface,
-                                 public rtc::MessageHandler {
- public:
-  explicit SctpFakeNetworkInterface(rtc::Thread* thread)
-    : thread_(thread),
-      dest_(NULL) {
-  }
-
-  void SetDestination(cricket::DataMediaChannel* dest) { dest_ = dest; }
-
- protected:
-  // Called to send raw packet down the wire (e.g. SCTP an packet).
-  virtual bool SendPacket(rtc::Buffer* packet,
-                          rtc::DiffServCodePoint dscp) {
-    LOG(LS_VERBOSE) << "SctpFakeNetworkInterface::SendPacket";
-
-    // TODO(ldixon): Can/should we use Buffer.TransferTo here?
-    // Note: this assignment does a deep copy of data from packet.
-    rtc::Buffer* buffer = new rtc::Buffer(packet->data(), packet->size());
-    thread_->Post(this, MSG_PACKET, rtc::WrapMessageData(buffer));
-    LOG(LS_VERBOSE) << "SctpFakeNetworkInterface::SendPacket, Posted message.";
-    return true;
-  }
-
-  // Called when a raw packet has been recieved. This passes the data to the
-  // code that will interpret the packet. e.g. to get the content payload from
-  // an SCTP packet.
-  virtual void OnMessage(rtc::Message* msg) {
-    LOG(LS_VERBOSE) << "SctpFakeNetworkInterface::OnMessage";
-    rtc::scoped_ptr<rtc::Buffer> buffer(
-        static_cast<rtc::TypedMessageData<rtc::Buffer*>*>(
-            msg->pdata)->data());
-    if (dest_) {
-      dest_->OnPacketReceived(buffer.get(), rtc::PacketTime());
-    }
-    delete msg->pdata;
-  }
-
-  // Unsupported functions required to exist by NetworkInterface.
-  // TODO(ldixon): Refactor parent NetworkInterface class so these are not
-  // required. They are RTC specific and should be in an appropriate subclass.
-  virtual bool SendRtcp(rtc::Buffer* packet,
-                        rtc::DiffServCodePoint dscp) {
-    LOG(LS_WARNING) << "Unsupported: SctpFakeNetworkInterface::SendRtcp.";
-    return false;
-  }
-  virtual int SetOption(SocketType type, rtc::Socket::Option opt,
-                        int option) {
-    LOG(LS_WARNING) << "Unsupported: SctpFakeNetworkInterface::SetOption.";
-    return 0;
-  }
-  virtual void SetDefaultDSCPCode(rtc::DiffServCodePoint dscp) {
-    LOG(LS_WARNING) << "Unsupported: SctpFakeNetworkInterface::SetOption.";
-  }
-
- private:
-  // Not owned by this class.
-  rtc::Thread* thread_;
-  cricket::DataMediaChannel* dest_;
-};
+using cricket::SctpFakeNetworkInterface;
 
 // This is essentially a buffer to hold recieved data. It stores only the last
 // received data. Calling OnDataReceived twice overwrites old data with the
@@ -395,6 +331,26 @@ TEST_F(SctpDataMediaChannelTest, SendData) {
                   << ", recv1.last_data=" << receiver1()->last_data();
 }
 
+TEST_F(SctpDataMediaChannelTest, SendDataBatch) {
+  SetupConnectedChannels();
+
+  cricket::SendDataResult result;
+  cricket::SendDataParams params;
+  params.ssrc = 1;
+  params.ordered = true;
+  rtc::Buffer payloads[] = {
+    rtc::Buffer("one", 3), rtc::Buffer("two", 3), rtc::Buffer("three", 5)
+  };
+  EXPECT_EQ(3, channel1()->SendDataBatch(params, payloads, 3, &result));
+  EXPECT_EQ(cricket::SDR_SUCCESS, result);
+  EXPECT_TRUE_WAIT(ReceivedData(receiver2(), 1, "three"), 1000);
+
+  // Nothing is sent on a stream that isn't open.
+  params.ssrc = 3;
+  EXPECT_EQ(0, channel1()->SendDataBatch(params, payloads, 3, &result));
+  EXPECT_EQ(cricket::SDR_ERROR, result);
+}
+
 // Sends a lot of large messages at once and verifies SDR_BLOCK is returned.
 TEST_F(SctpDataMediaChannelTest, SendDataBlocked) {
   SetupConnectedChannels();
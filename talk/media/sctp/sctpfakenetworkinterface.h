@@ -0,0 +1,121 @@
+/*
+ * libjingle
+ * Copyright 2013 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TALK_MEDIA_SCTP_SCTPFAKENETWORKINTERFACE_H_
+#define TALK_MEDIA_SCTP_SCTPFAKENETWORKINTERFACE_H_
+
+#include "talk/media/base/mediachannel.h"
+#include "webrtc/base/buffer.h"
+#include "webrtc/base/dscp.h"
+#include "webrtc/base/logging.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/messagequeue.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/thread.h"
+
+namespace cricket {
+
+// Fake NetworkInterface that sends/receives sctp packets.  The one in
+// talk/media/base/fakenetworkinterface.h only works with rtp/rtcp.
+class SctpFakeNetworkInterface : public MediaChannel::NetworkInterface,
+                                 public rtc::MessageHandler {
+ public:
+  enum {
+    MSG_PACKET = 1,
+  };
+
+  explicit SctpFakeNetworkInterface(rtc::Thread* thread)
+    : thread_(thread),
+      dest_(NULL) {
+  }
+
+  void SetDestination(DataMediaChannel* dest) { dest_ = dest; }
+
+ protected:
+  // Called to send raw packet down the wire (e.g. SCTP an packet).
+  virtual bool SendPacket(rtc::Buffer* packet,
+                          rtc::DiffServCodePoint dscp) {
+    LOG(LS_VERBOSE) << "SctpFakeNetworkInterface::SendPacket";
+
+    // TODO(ldixon): Can/should we use Buffer.TransferTo here?
+    // Note: this assignment does a deep copy of data from packet.
+    rtc::Buffer* buffer = new rtc::Buffer(packet->data(), packet->size());
+    thread_->Post(this, MSG_PACKET, rtc::WrapMessageData(buffer));
+    LOG(LS_VERBOSE) << "SctpFakeNetworkInterface::SendPacket, Posted message.";
+    return true;
+  }
+
+  // Copies the packet once, straight into the posted buffer, rather than
+  // going through the default which copies it again in SendPacket.
+  virtual bool SendTransientPacket(const uint8* data,
+                                   size_t size,
+                                   rtc::DiffServCodePoint dscp) {
+    rtc::Buffer* buffer = new rtc::Buffer(data, size);
+    thread_->Post(this, MSG_PACKET, rtc::WrapMessageData(buffer));
+    return true;
+  }
+
+  // Called when a raw packet has been recieved. This passes the data to the
+  // code that will interpret the packet. e.g. to get the content payload from
+  // an SCTP packet.
+  virtual void OnMessage(rtc::Message* msg) {
+    LOG(LS_VERBOSE) << "SctpFakeNetworkInterface::OnMessage";
+    rtc::scoped_ptr<rtc::Buffer> buffer(
+        static_cast<rtc::TypedMessageData<rtc::Buffer*>*>(
+            msg->pdata)->data());
+    if (dest_) {
+      dest_->OnPacketReceived(buffer.get(), rtc::PacketTime());
+    }
+    delete msg->pdata;
+  }
+
+  // Unsupported functions required to exist by NetworkInterface.
+  // TODO(ldixon): Refactor parent NetworkInterface class so these are not
+  // required. They are RTC specific and should be in an appropriate subclass.
+  virtual bool SendRtcp(rtc::Buffer* packet,
+                        rtc::DiffServCodePoint dscp) {
+    LOG(LS_WARNING) << "Unsupported: SctpFakeNetworkInterface::SendRtcp.";
+    return false;
+  }
+  virtual int SetOption(SocketType type, rtc::Socket::Option opt,
+                        int option) {
+    LOG(LS_WARNING) << "Unsupported: SctpFakeNetworkInterface::SetOption.";
+    return 0;
+  }
+  virtual void SetDefaultDSCPCode(rtc::DiffServCodePoint dscp) {
+    LOG(LS_WARNING) << "Unsupported: SctpFakeNetworkInterface::SetOption.";
+  }
+
+ private:
+  // Not owned by this class.
+  rtc::Thread* thread_;
+  DataMediaChannel* dest_;
+};
+
+}  // namespace cricket
+
+#endif  // TALK_MEDIA_SCTP_SCTPFAKENETWORKINTERFACE_H_
@@ -128,11 +128,14 @@ static const char* PacketType(bool rtcp) {
   return (!rtcp) ? "RTP" : "RTCP";
 }
 
+static bool ValidPacketSize(bool rtcp, size_t size) {
+  return (size >= (!rtcp ? kMinRtpPacketLen : kMinRtcpPacketLen) &&
+          size <= kMaxRtpPacketLen);
+}
+
 static bool ValidPacket(bool rtcp, const rtc::Buffer* packet) {
   // Check the packet size. We could check the header too if needed.
-  return (packet &&
-          packet->size() >= (!rtcp ? kMinRtpPacketLen : kMinRtcpPacketLen) &&
-          packet->size() <= kMaxRtpPacketLen);
+  return packet && ValidPacketSize(rtcp, packet->size());
 }
 
 static bool IsReceiveContentDirection(MediaContentDirection direction) {
@@ -172,6 +175,7 @@ BaseChannel::BaseChannel(rtc::Thread* thread,
       has_received_packet_(false),
       dtls_keyed_(false),
       secure_required_(false),
+      enable_gcm_ciphers_(false),
       rtp_abs_sendtime_extn_id_(-1) {
   ASSERT(worker_thread_ == rtc::Thread::Current());
   LOG(LS_INFO) << "Created channel for " << content_name;
@@ -293,6 +297,7 @@ void BaseChannel::ConnectToTransportChannel(TransportChannel* tc) {
   tc->SignalWritableState.connect(this, &BaseChannel::OnWritableState);
   tc->SignalReadPacket.connect(this, &BaseChannel::OnChannelRead);
   tc->SignalReadyToSend.connect(this, &BaseChannel::OnReadyToSend);
+  tc->SetSrtpPacketSink(this, tc);
 }
 
 void BaseChannel::DisconnectFromTransportChannel(TransportChannel* tc) {
@@ -301,6 +306,7 @@ void BaseChannel::DisconnectFromTransportChannel(TransportChannel* tc) {
   tc->SignalWritableState.disconnect(this);
   tc->SignalReadPacket.disconnect(this);
   tc->SignalReadyToSend.disconnect(this);
+  tc->SetSrtpPacketSink(NULL, tc);
 }
 
 bool BaseChannel::Enable(bool enable) {
@@ -435,6 +441,13 @@ void BaseChannel::OnChannelRead(TransportChannel* channel,
   HandlePacket(rtcp, &packet, packet_time);
 }
 
+void BaseChannel::OnSrtpPacket(TransportChannel* channel,
+                               const char* data, size_t len,
+                               const rtc::PacketTime& packet_time,
+                               int flags) {
+  OnChannelRead(channel, data, len, packet_time, flags);
+}
+
 void BaseChannel::OnReadyToSend(TransportChannel* channel) {
   SetReadyToSend(channel, true);
 }
@@ -576,17 +589,56 @@ bool BaseChannel::SendPacket(bool rtcp, rtc::Buffer* packet,
     return false;
   }
 
+  return SendPacketToChannel(channel, rtcp, options, packet->data<char>(),
+                             packet->size());
+}
+
+bool BaseChannel::SendTransientPacket(const uint8* data,
+                                      size_t size,
+                                      rtc::DiffServCodePoint dscp) {
+  // Only an unprotected packet on the worker thread can be sent from the
+  // caller's memory; otherwise it is copied to be posted or protected.
+  if (rtc::Thread::Current() != worker_thread_ || srtp_filter_.IsActive() ||
+      secure_required_) {
+    rtc::Buffer packet(data, size, kMaxRtpPacketLen);
+    return SendPacket(false, &packet, dscp);
+  }
+
+  TransportChannel* channel = transport_channel_;
+  if (!channel || !channel->writable()) {
+    return false;
+  }
+
+  if (!ValidPacketSize(false, size)) {
+    LOG(LS_ERROR) << "Dropping outgoing " << content_name_ << " "
+                  << PacketType(false) << " packet: wrong size=" << size;
+    return false;
+  }
+
+  {
+    rtc::CritScope cs(&signal_send_packet_cs_);
+    SignalSendPacketPreCrypto(data, size, false);
+  }
+
+  return SendPacketToChannel(channel, false, rtc::PacketOptions(dscp),
+                             reinterpret_cast<const char*>(data), size);
+}
+
+bool BaseChannel::SendPacketToChannel(TransportChannel* channel,
+                                      bool rtcp,
+                                      const rtc::PacketOptions& options,
+                                      const char* data,
+                                      size_t size) {
   // Signal to the media sink after protecting the packet.
   {
     rtc::CritScope cs(&signal_send_packet_cs_);
-    SignalSendPacketPostCrypto(packet->data(), packet->size(), rtcp);
+    SignalSendPacketPostCrypto(data, size, rtcp);
   }
 
   // Bon voyage.
-  int ret =
-      channel->SendPacket(packet->data<char>(), packet->size(), options,
-                          (secure() && secure_dtls()) ? PF_SRTP_BYPASS : 0);
-  if (ret != static_cast<int>(packet->size())) {
+  int flags = (secure() && secure_dtls()) ? PF_SRTP_BYPASS : 0;
+  int ret = channel->SendPacket(data, size, options, flags);
+  if (ret != static_cast<int>(size)) {
     if (channel->GetError() == EWOULDBLOCK) {
       LOG(LS_WARNING) << "Got EWOULDBLOCK from socket.";
       SetReadyToSend(channel, false);
@@ -824,6 +876,11 @@ void BaseChannel::SignalDtlsSetupFailure_s(bool rtcp) {
 
 bool BaseChannel::SetDtlsSrtpCiphers(TransportChannel *tc, bool rtcp) {
   std::vector<std::string> ciphers;
+  // AES-GCM protects RTP and RTCP alike, so when it is enabled it is
+  // preferred for both.
+  if (enable_gcm_ciphers_) {
+    GetSupportedGcmCryptoSuites(&ciphers);
+  }
   // We always use the default SRTP ciphers for RTCP, but we may use different
   // ciphers for RTP depending on the media type.
   if (!rtcp) {
@@ -861,9 +918,15 @@ bool BaseChannel::SetupDtlsSrtp(bool rtcp_channel) {
                << content_name() << " "
                << PacketType(rtcp_channel);
 
+  int key_len;
+  int salt_len;
+  if (!GetSrtpKeyAndSaltLengths(selected_cipher, &key_len, &salt_len)) {
+    LOG(LS_ERROR) << "Unknown DTLS-SRTP cipher " << selected_cipher;
+    return false;
+  }
+
   // OK, we're now doing DTLS (RFC 5764)
-  std::vector<unsigned char> dtls_buffer(SRTP_MASTER_KEY_KEY_LEN * 2 +
-                                         SRTP_MASTER_KEY_SALT_LEN * 2);
+  std::vector<unsigned char> dtls_buffer(key_len * 2 + salt_len * 2);
 
   // RFC 5705 exporter using the RFC 5764 parameters
   if (!channel->ExportKeyingMaterial(
@@ -876,22 +939,16 @@ bool BaseChannel::SetupDtlsSrtp(bool rtcp_channel) {
   }
 
   // Sync up the keys with the DTLS-SRTP interface
-  std::vector<unsigned char> client_write_key(SRTP_MASTER_KEY_KEY_LEN +
-    SRTP_MASTER_KEY_SALT_LEN);
-  std::vector<unsigned char> server_write_key(SRTP_MASTER_KEY_KEY_LEN +
-    SRTP_MASTER_KEY_SALT_LEN);
+  std::vector<unsigned char> client_write_key(key_len + salt_len);
+  std::vector<unsigned char> server_write_key(key_len + salt_len);
   size_t offset = 0;
-  memcpy(&client_write_key[0], &dtls_buffer[offset],
-    SRTP_MASTER_KEY_KEY_LEN);
-  offset += SRTP_MASTER_KEY_KEY_LEN;
-  memcpy(&server_write_key[0], &dtls_buffer[offset],
-    SRTP_MASTER_KEY_KEY_LEN);
-  offset += SRTP_MASTER_KEY_KEY_LEN;
-  memcpy(&client_write_key[SRTP_MASTER_KEY_KEY_LEN],
-    &dtls_buffer[offset], SRTP_MASTER_KEY_SALT_LEN);
-  offset += SRTP_MASTER_KEY_SALT_LEN;
-  memcpy(&server_write_key[SRTP_MASTER_KEY_KEY_LEN],
-    &dtls_buffer[offset], SRTP_MASTER_KEY_SALT_LEN);
+  memcpy(&client_write_key[0], &dtls_buffer[offset], key_len);
+  offset += key_len;
+  memcpy(&server_write_key[0], &dtls_buffer[offset], key_len);
+  offset += key_len;
+  memcpy(&client_write_key[key_len], &dtls_buffer[offset], salt_len);
+  offset += salt_len;
+  memcpy(&server_write_key[key_len], &dtls_buffer[offset], salt_len);
 
   std::vector<unsigned char> *send_key, *recv_key;
   rtc::SSLRole role;
@@ -2216,6 +2273,21 @@ bool DataChannel::SendData(const SendDataParams& params,
                              media_channel(), params, payload, result));
 }
 
+int DataChannel::SendDataBatch(const SendDataParams& params,
+                               const rtc::Buffer* payloads,
+                               int count,
+                               SendDataResult* result) {
+  return worker_thread()->Invoke<int>(Bind(&DataMediaChannel::SendDataBatch,
+                                           media_channel(), params, payloads,
+                                           count, result));
+}
+
+bool DataChannel::SetBufferSizes(int send_buffer_size, int recv_buffer_size) {
+  return InvokeOnWorker(Bind(&DataMediaChannel::SetBufferSizes,
+                             media_channel(), send_buffer_size,
+                             recv_buffer_size));
+}
+
 const ContentInfo* DataChannel::GetFirstContent(
     const SessionDescription* sdesc) {
   return GetFirstDataContent(sdesc);
@@ -36,6 +36,7 @@
 #include "talk/media/base/streamparams.h"
 #include "talk/media/base/videocapturer.h"
 #include "webrtc/p2p/base/session.h"
+#include "webrtc/p2p/base/transportchannel.h"
 #include "webrtc/p2p/client/socketmonitor.h"
 #include "talk/session/media/audiomonitor.h"
 #include "talk/session/media/bundlefilter.h"
@@ -74,7 +75,8 @@ enum SinkType {
 class BaseChannel
     : public rtc::MessageHandler, public sigslot::has_slots<>,
       public MediaChannel::NetworkInterface,
-      public ConnectionStatsGetter {
+      public ConnectionStatsGetter,
+      public SrtpPacketSink {
  public:
   BaseChannel(rtc::Thread* thread, MediaEngineInterface* media_engine,
               MediaChannel* channel, BaseSession* session,
@@ -104,6 +106,9 @@ class BaseChannel
   bool secure_dtls() const { return dtls_keyed_; }
   // This function returns true if we require secure channel for call setup.
   bool secure_required() const { return secure_required_; }
+  // Whether the AES-GCM cipher suites are offered for DTLS-SRTP, in addition
+  // to the default ones. Must be called before Init().
+  void set_enable_gcm_ciphers(bool enable) { enable_gcm_ciphers_ = enable; }
 
   bool writable() const { return writable_; }
   bool IsStreamMuted(uint32 ssrc);
@@ -273,6 +278,9 @@ class BaseChannel
                           rtc::DiffServCodePoint dscp);
   virtual bool SendRtcp(rtc::Buffer* packet,
                         rtc::DiffServCodePoint dscp);
+  virtual bool SendTransientPacket(const uint8* data,
+                                   size_t size,
+                                   rtc::DiffServCodePoint dscp);
 
   // From TransportChannel
   void OnWritableState(TransportChannel* channel);
@@ -283,10 +291,23 @@ class BaseChannel
                              int flags);
   void OnReadyToSend(TransportChannel* channel);
 
+  // SrtpPacketSink implementation, the DTLS-SRTP fast path to OnChannelRead.
+  virtual void OnSrtpPacket(TransportChannel* channel,
+                            const char* data,
+                            size_t len,
+                            const rtc::PacketTime& packet_time,
+                            int flags);
+
   bool PacketIsRtcp(const TransportChannel* channel, const char* data,
                     size_t len);
   bool SendPacket(bool rtcp, rtc::Buffer* packet,
                   rtc::DiffServCodePoint dscp);
+  // Sends a packet that has been checked and protected, if needed.
+  bool SendPacketToChannel(TransportChannel* channel,
+                           bool rtcp,
+                           const rtc::PacketOptions& options,
+                           const char* data,
+                           size_t size);
   virtual bool WantsPacket(bool rtcp, rtc::Buffer* packet);
   void HandlePacket(bool rtcp, rtc::Buffer* packet,
                     const rtc::PacketTime& packet_time);
@@ -410,6 +431,7 @@ class BaseChannel
   bool has_received_packet_;
   bool dtls_keyed_;
   bool secure_required_;
+  bool enable_gcm_ciphers_;
   int rtp_abs_sendtime_extn_id_;
 };
 
@@ -627,6 +649,15 @@ class DataChannel : public BaseChannel {
   virtual bool SendData(const SendDataParams& params,
                         const rtc::Buffer& payload,
                         SendDataResult* result);
+  // Sends |count| messages with the same |params|, stopping at the first one
+  // that fails. Returns the number of messages sent.
+  virtual int SendDataBatch(const SendDataParams& params,
+                            const rtc::Buffer* payloads,
+                            int count,
+                            SendDataResult* result);
+  // Sizes the transport's send and receive buffers. For SCTP, this only
+  // affects a socket opened afterwards.
+  bool SetBufferSizes(int send_buffer_size, int recv_buffer_size);
 
   void StartMediaMonitor(int cms);
   void StopMediaMonitor();
@@ -45,6 +45,8 @@
 #include "webrtc/base/signalthread.h"
 #include "webrtc/base/ssladapter.h"
 #include "webrtc/base/sslidentity.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/base/stream.h"
 #include "webrtc/base/window.h"
 
 #define MAYBE_SKIP_TEST(feature)                    \
@@ -2214,6 +2216,30 @@ TEST_F(VoiceChannelTest, SendDtlsSrtpToDtlsSrtp) {
   Base::SendSrtpToSrtp(DTLS, DTLS);
 }
 
+// With AES-GCM enabled, only the suites the DTLS stack can negotiate are
+// offered, so Init() succeeds and the SSL adapter accepts the list.
+TEST_F(VoiceChannelTest, InitWithGcmCiphers) {
+  cricket::VoiceChannel channel(rtc::Thread::Current(), &media_engine_,
+                                new cricket::FakeVoiceMediaChannel(NULL),
+                                &session1_, cricket::CN_AUDIO, true);
+  channel.set_enable_gcm_ciphers(true);
+  ASSERT_TRUE(channel.Init());
+  // Creates the transport channel, which gets the ciphers set on its proxy.
+  session1_.Connect(&session2_);
+
+  cricket::FakeTransportChannel* transport_channel =
+      static_cast<cricket::FakeTransportChannel*>(
+          session1_.GetTransport(cricket::CN_AUDIO)->GetChannel(
+              cricket::ICE_CANDIDATE_COMPONENT_RTP));
+  ASSERT_TRUE(transport_channel != NULL);
+  const std::vector<std::string>& ciphers = transport_channel->srtp_ciphers();
+  ASSERT_FALSE(ciphers.empty());
+  MAYBE_SKIP_TEST(HaveDtlsSrtp);
+  rtc::scoped_ptr<rtc::SSLStreamAdapter> adapter(
+      rtc::SSLStreamAdapter::Create(new rtc::MemoryStream()));
+  EXPECT_TRUE(adapter->SetDtlsSrtpCiphers(ciphers));
+}
+
 TEST_F(VoiceChannelTest, SendDtlsSrtpToDtlsSrtpRtcpMux) {
   MAYBE_SKIP_TEST(HaveDtlsSrtp);
   Base::SendSrtpToSrtp(DTLS | RTCP_MUX, DTLS | RTCP_MUX);
@@ -3006,4 +3032,27 @@ TEST_F(DataChannelTest, TestSendData) {
   EXPECT_EQ("foo", media_channel1_->last_sent_data());
 }
 
+TEST_F(DataChannelTest, TestSendTransientPacket) {
+  CreateChannels(0, 0);
+  EXPECT_TRUE(SendInitiate());
+  EXPECT_TRUE(SendAccept());
+  EXPECT_TRUE(media_channel1_->SendTransientPacket(
+      reinterpret_cast<const uint8*>(rtp_packet_.data()), rtp_packet_.size()));
+  EXPECT_TRUE(CheckRtp2());
+  EXPECT_TRUE(CheckNoRtp2());
+}
+
+// A transient packet is copied to be protected.
+TEST_F(DataChannelTest, TestSendTransientPacketWithSrtp) {
+  CreateChannels(RTCP | SECURE, RTCP | SECURE);
+  EXPECT_TRUE(SendInitiate());
+  EXPECT_TRUE_WAIT(channel1_->writable(), kEventTimeout);
+  EXPECT_TRUE(SendAccept());
+  EXPECT_TRUE(channel1_->secure());
+  EXPECT_TRUE(media_channel1_->SendTransientPacket(
+      reinterpret_cast<const uint8*>(rtp_packet_.data()), rtp_packet_.size()));
+  EXPECT_TRUE(CheckRtp2());
+  EXPECT_TRUE(CheckNoRtp2());
+}
+
 // TODO(pthatcher): TestSetReceiver?
@@ -115,6 +115,7 @@ void ChannelManager::Construct(MediaEngineInterface* me,
   capturing_ = false;
   monitoring_ = false;
   enable_rtx_ = false;
+  enable_gcm_ciphers_ = false;
 
   // Init the device manager immediately, and set up our default video device.
   SignalDevicesChange.repeat(device_manager_->SignalDevicesChange);
@@ -155,6 +156,17 @@ bool ChannelManager::SetVideoRtxEnabled(bool enable) {
   }
 }
 
+void ChannelManager::SetEnableGcmCiphers(bool enable) {
+  // The channels are created on the worker thread.
+  worker_thread_->Invoke<void>(
+      Bind(&ChannelManager::SetEnableGcmCiphers_w, this, enable));
+}
+
+void ChannelManager::SetEnableGcmCiphers_w(bool enable) {
+  ASSERT(worker_thread_ == rtc::Thread::Current());
+  enable_gcm_ciphers_ = enable;
+}
+
 int ChannelManager::GetCapabilities() {
   return media_engine_->GetCapabilities() & device_manager_->GetCapabilities();
 }
@@ -340,6 +352,7 @@ VoiceChannel* ChannelManager::CreateVoiceChannel_w(
   VoiceChannel* voice_channel = new VoiceChannel(
       worker_thread_, media_engine_.get(), media_channel,
       session, content_name, rtcp);
+  voice_channel->set_enable_gcm_ciphers(enable_gcm_ciphers_);
   if (!voice_channel->Init()) {
     delete voice_channel;
     return nullptr;
@@ -424,6 +437,7 @@ VideoChannel* ChannelManager::CreateVideoChannel_w(
   VideoChannel* video_channel = new VideoChannel(
       worker_thread_, media_engine_.get(), media_channel,
       session, content_name, rtcp);
+  video_channel->set_enable_gcm_ciphers(enable_gcm_ciphers_);
   if (!video_channel->Init()) {
     delete video_channel;
     return NULL;
@@ -477,6 +491,7 @@ DataChannel* ChannelManager::CreateDataChannel_w(
   DataChannel* data_channel = new DataChannel(
       worker_thread_, media_channel,
       session, content_name, rtcp);
+  data_channel->set_enable_gcm_ciphers(enable_gcm_ciphers_);
   if (!data_channel->Init()) {
     LOG(LS_WARNING) << "Failed to init data channel.";
     delete data_channel;
@@ -162,6 +162,9 @@ class ChannelManager : public rtc::MessageHandler,
   // RTX will be enabled/disabled in engines that support it. The supporting
   // engines will start offering an RTX codec. Must be called before Init().
   bool SetVideoRtxEnabled(bool enable);
+  // Offers the AES-GCM cipher suites for DTLS-SRTP, where the SRTP library
+  // supports them, on the channels created from now on. Off by default.
+  void SetEnableGcmCiphers(bool enable);
 
   // Starts/stops the local microphone and enables polling of the input level.
   bool SetLocalMonitor(bool enable);
@@ -255,6 +258,7 @@ class ChannelManager : public rtc::MessageHandler,
   bool InitMediaEngine_w();
   void DestructorDeletes_w();
   void Terminate_w();
+  void SetEnableGcmCiphers_w(bool enable);
   VoiceChannel* CreateVoiceChannel_w(BaseSession* session,
                                      const std::string& content_name,
                                      bool rtcp,
@@ -307,6 +311,7 @@ class ChannelManager : public rtc::MessageHandler,
   VideoEncoderConfig default_video_encoder_config_;
   VideoRenderer* local_renderer_;
   bool enable_rtx_;
+  bool enable_gcm_ciphers_;
 
   bool capturing_;
   bool monitoring_;
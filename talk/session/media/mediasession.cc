@@ -36,6 +36,7 @@
 #include "talk/media/base/cryptoparams.h"
 #include "talk/session/media/channelmanager.h"
 #include "talk/session/media/srtpfilter.h"
+#include "webrtc/base/base64.h"
 #include "webrtc/base/helpers.h"
 #include "webrtc/base/logging.h"
 #include "webrtc/base/scoped_ptr.h"
@@ -87,16 +88,22 @@ static bool IsMediaContentOfType(const ContentInfo* content,
 
 static bool CreateCryptoParams(int tag, const std::string& cipher,
                                CryptoParams *out) {
-  std::string key;
-  key.reserve(SRTP_MASTER_KEY_BASE64_LEN);
+  int key_len;
+  int salt_len;
+  if (!GetSrtpKeyAndSaltLengths(cipher, &key_len, &salt_len)) {
+    return false;
+  }
 
-  if (!rtc::CreateRandomString(SRTP_MASTER_KEY_BASE64_LEN, &key)) {
+  // The master key and salt are random bytes, base64 encoded for the
+  // inline key parameter.
+  std::string master_key;
+  if (!rtc::CreateRandomData(key_len + salt_len, &master_key)) {
     return false;
   }
   out->tag = tag;
   out->cipher_suite = cipher;
   out->key_params = kInline;
-  out->key_params += key;
+  out->key_params += rtc::Base64::Encode(master_key);
   return true;
 }
 
@@ -35,6 +35,7 @@
 #include "webrtc/p2p/base/transportinfo.h"
 #include "talk/session/media/mediasession.h"
 #include "talk/session/media/srtpfilter.h"
+#include "webrtc/base/base64.h"
 #include "webrtc/base/fakesslidentity.h"
 #include "webrtc/base/gunit.h"
 #include "webrtc/base/messagedigest.h"
@@ -955,6 +956,42 @@ TEST_F(MediaSessionDescriptionFactoryTest, AudioOfferAnswerWithCryptoDisabled) {
   EXPECT_EQ(std::string(cricket::kMediaProtocolAvpf), answer_acd->protocol());
 }
 
+// Test that the SDES keys have the length of their cipher suite, and that
+// the AES-GCM suites are not offered for SDES.
+TEST_F(MediaSessionDescriptionFactoryTest, TestSdesKeyLengths) {
+  MediaSessionOptions opts;
+  opts.recv_video = true;
+  f1_.set_secure(SEC_ENABLED);
+  f2_.set_secure(SEC_ENABLED);
+  rtc::scoped_ptr<SessionDescription> offer(f1_.CreateOffer(opts, NULL));
+  ASSERT_TRUE(offer.get() != NULL);
+  rtc::scoped_ptr<SessionDescription> answer(
+      f2_.CreateAnswer(offer.get(), opts, NULL));
+  ASSERT_TRUE(answer.get() != NULL);
+
+  const SessionDescription* descs[] = { offer.get(), answer.get() };
+  for (int i = 0; i < ARRAY_SIZE(descs); ++i) {
+    for (const ContentInfo& content : descs[i]->contents()) {
+      const MediaContentDescription* mcd =
+          static_cast<const MediaContentDescription*>(content.description);
+      for (const cricket::CryptoParams& crypto : mcd->cryptos()) {
+        EXPECT_NE(std::string(cricket::CS_AEAD_AES_128_GCM),
+                  crypto.cipher_suite);
+        EXPECT_NE(std::string(cricket::CS_AEAD_AES_256_GCM),
+                  crypto.cipher_suite);
+        int key_len, salt_len;
+        ASSERT_TRUE(cricket::GetSrtpKeyAndSaltLengths(crypto.cipher_suite,
+                                                      &key_len, &salt_len));
+        ASSERT_EQ(0U, crypto.key_params.find("inline:"));
+        std::string key;
+        EXPECT_TRUE(rtc::Base64::Decode(crypto.key_params.substr(7),
+                                        rtc::Base64::DO_STRICT, &key, NULL));
+        EXPECT_EQ(static_cast<size_t>(key_len + salt_len), key.size());
+      }
+    }
+  }
+}
+
 // Create a video offer and answer and ensure the RTP header extensions
 // matches what we expect.
 TEST_F(MediaSessionDescriptionFactoryTest, TestOfferAnswerWithRtpExtensions) {
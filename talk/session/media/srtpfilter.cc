@@ -38,6 +38,7 @@
 #include "webrtc/base/byteorder.h"
 #include "webrtc/base/common.h"
 #include "webrtc/base/logging.h"
+#include "webrtc/base/sslstreamadapter.h"
 #include "webrtc/base/stringencode.h"
 #include "webrtc/base/timeutils.h"
 
@@ -75,10 +76,48 @@ namespace cricket {
 
 const char CS_AES_CM_128_HMAC_SHA1_80[] = "AES_CM_128_HMAC_SHA1_80";
 const char CS_AES_CM_128_HMAC_SHA1_32[] = "AES_CM_128_HMAC_SHA1_32";
+const char CS_AEAD_AES_128_GCM[] = "AEAD_AES_128_GCM";
+const char CS_AEAD_AES_256_GCM[] = "AEAD_AES_256_GCM";
 const int SRTP_MASTER_KEY_BASE64_LEN = SRTP_MASTER_KEY_LEN * 4 / 3;
 const int SRTP_MASTER_KEY_KEY_LEN = 16;
 const int SRTP_MASTER_KEY_SALT_LEN = 14;
 
+namespace {
+// RFC 7714 uses a 96-bit salt for both AES-GCM key sizes.
+const int kSrtpGcmSaltLen = 12;
+// The longest master key plus salt, that of AEAD_AES_256_GCM.
+const int kSrtpMaxMasterKeyLen = 32 + kSrtpGcmSaltLen;
+}  // namespace
+
+bool GetSrtpKeyAndSaltLengths(const std::string& cs, int* key_len,
+                              int* salt_len) {
+  if (cs == CS_AES_CM_128_HMAC_SHA1_80 || cs == CS_AES_CM_128_HMAC_SHA1_32) {
+    *key_len = SRTP_MASTER_KEY_KEY_LEN;
+    *salt_len = SRTP_MASTER_KEY_SALT_LEN;
+  } else if (cs == CS_AEAD_AES_128_GCM) {
+    *key_len = 16;
+    *salt_len = kSrtpGcmSaltLen;
+  } else if (cs == CS_AEAD_AES_256_GCM) {
+    *key_len = 32;
+    *salt_len = kSrtpGcmSaltLen;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void GetSupportedGcmCryptoSuites(std::vector<std::string>* crypto_suites) {
+#if defined(HAVE_SRTP) && defined(OPENSSL)
+  // libsrtp only has AES-GCM when it is built on OpenSSL/BoringSSL, and the
+  // DTLS stack may still lack the profiles.
+  if (!rtc::SSLStreamAdapter::HaveGcmSrtp()) {
+    return;
+  }
+  crypto_suites->push_back(CS_AEAD_AES_256_GCM);
+  crypto_suites->push_back(CS_AEAD_AES_128_GCM);
+#endif
+}
+
 #ifndef HAVE_SRTP
 
 // This helper function is used on systems that don't (yet) have SRTP,
@@ -263,6 +302,28 @@ bool SrtpFilter::UnprotectRtcp(void* p, int in_len, int* out_len) {
   }
 }
 
+int SrtpFilter::ProtectRtp(SrtpPacket* packets, int count) {
+  if (!IsActive()) {
+    LOG(LS_WARNING) << "Failed to ProtectRtp: SRTP not active";
+    for (int i = 0; i < count; ++i)
+      packets[i].len = -1;
+    return 0;
+  }
+  ASSERT(send_session_ != NULL);
+  return send_session_->ProtectRtp(packets, count);
+}
+
+int SrtpFilter::UnprotectRtp(SrtpPacket* packets, int count) {
+  if (!IsActive()) {
+    LOG(LS_WARNING) << "Failed to UnprotectRtp: SRTP not active";
+    for (int i = 0; i < count; ++i)
+      packets[i].len = -1;
+    return 0;
+  }
+  ASSERT(recv_session_ != NULL);
+  return recv_session_->UnprotectRtp(packets, count);
+}
+
 bool SrtpFilter::GetRtpAuthParams(uint8** key, int* key_len, int* tag_len) {
   if (!IsActive()) {
     LOG(LS_WARNING) << "Failed to GetRtpAuthParams: SRTP not active";
@@ -416,17 +477,29 @@ bool SrtpFilter::ApplyParams(const CryptoParams& send_params,
     // We do not want to reset the ROC if the keys are the same. So just return.
     return true;
   }
+  int send_key_len, send_salt_len, recv_key_len, recv_salt_len;
+  if (!GetSrtpKeyAndSaltLengths(send_params.cipher_suite, &send_key_len,
+                                &send_salt_len) ||
+      !GetSrtpKeyAndSaltLengths(recv_params.cipher_suite, &recv_key_len,
+                                &recv_salt_len)) {
+    LOG(LS_WARNING) << "Failed to apply negotiated SRTP parameters: "
+                    << "unsupported cipher_suite";
+    return false;
+  }
+  send_key_len += send_salt_len;
+  recv_key_len += recv_salt_len;
+
   // TODO(juberti): Zero these buffers after use.
   bool ret;
-  uint8 send_key[SRTP_MASTER_KEY_LEN], recv_key[SRTP_MASTER_KEY_LEN];
-  ret = (ParseKeyParams(send_params.key_params, send_key, sizeof(send_key)) &&
-         ParseKeyParams(recv_params.key_params, recv_key, sizeof(recv_key)));
+  uint8 send_key[kSrtpMaxMasterKeyLen], recv_key[kSrtpMaxMasterKeyLen];
+  ret = (ParseKeyParams(send_params.key_params, send_key, send_key_len) &&
+         ParseKeyParams(recv_params.key_params, recv_key, recv_key_len));
   if (ret) {
     CreateSrtpSessions();
     ret = (send_session_->SetSend(send_params.cipher_suite,
-                                  send_key, sizeof(send_key)) &&
+                                  send_key, send_key_len) &&
            recv_session_->SetRecv(recv_params.cipher_suite,
-                                  recv_key, sizeof(recv_key)));
+                                  recv_key, recv_key_len));
   }
   if (ret) {
     LOG(LS_INFO) << "SRTP activated with negotiated parameters:"
@@ -475,7 +548,9 @@ bool SrtpFilter::ParseKeyParams(const std::string& key_params,
 
 bool SrtpSession::inited_ = false;
 
-// This lock protects SrtpSession::inited_ and SrtpSession::sessions_.
+// This lock protects SrtpSession::inited_, and SrtpSession::sessions_ when
+// libsrtp has no user data. Protecting and unprotecting only take it for
+// libsrtp events, which are rare.
 rtc::GlobalLockPod SrtpSession::lock_;
 
 SrtpSession::SrtpSession()
@@ -484,18 +559,22 @@ SrtpSession::SrtpSession()
       rtcp_auth_tag_len_(0),
       srtp_stat_(new SrtpStat()),
       last_send_seq_num_(-1) {
+#ifndef HAVE_SRTP_USER_DATA
   {
     rtc::GlobalLockScope ls(&lock_);
     sessions()->push_back(this);
   }
+#endif
   SignalSrtpError.repeat(srtp_stat_->SignalSrtpError);
 }
 
 SrtpSession::~SrtpSession() {
+#ifndef HAVE_SRTP_USER_DATA
   {
     rtc::GlobalLockScope ls(&lock_);
     sessions()->erase(std::find(sessions()->begin(), sessions()->end(), this));
   }
+#endif
   if (session_) {
     srtp_dealloc(session_);
   }
@@ -606,6 +685,73 @@ bool SrtpSession::UnprotectRtcp(void* p, int in_len, int* out_len) {
   return true;
 }
 
+int SrtpSession::ProtectRtp(SrtpPacket* packets, int count) {
+  if (!session_) {
+    LOG(LS_WARNING) << "Failed to protect SRTP packets: no SRTP Session";
+    for (int i = 0; i < count; ++i)
+      packets[i].len = -1;
+    return 0;
+  }
+
+  // Unlike the single packet version, this only parses the headers and
+  // updates the statistics of the packets that fail, and the sequence number
+  // of the last one that succeeds.
+  int num_protected = 0;
+  const SrtpPacket* last_protected = NULL;
+  for (int i = 0; i < count; ++i) {
+    SrtpPacket* packet = &packets[i];
+    const int in_len = packet->len;
+    int err = err_status_bad_param;
+    if (packet->max_len >= in_len + rtp_auth_tag_len_)
+      err = srtp_protect(session_, packet->data, &packet->len);
+    if (err == err_status_ok) {
+      ++num_protected;
+      last_protected = packet;
+      continue;
+    }
+    uint32 ssrc;
+    if (GetRtpSsrc(packet->data, in_len, &ssrc))
+      srtp_stat_->AddProtectRtpResult(ssrc, err);
+    int seq_num;
+    GetRtpSeqNum(packet->data, in_len, &seq_num);
+    LOG(LS_WARNING) << "Failed to protect SRTP packet, seqnum="
+                    << seq_num << ", err=" << err << ", last seqnum="
+                    << last_send_seq_num_;
+    packet->len = -1;
+  }
+  if (last_protected) {
+    GetRtpSeqNum(last_protected->data, last_protected->len,
+                 &last_send_seq_num_);
+  }
+  return num_protected;
+}
+
+int SrtpSession::UnprotectRtp(SrtpPacket* packets, int count) {
+  if (!session_) {
+    LOG(LS_WARNING) << "Failed to unprotect SRTP packets: no SRTP Session";
+    for (int i = 0; i < count; ++i)
+      packets[i].len = -1;
+    return 0;
+  }
+
+  int num_unprotected = 0;
+  for (int i = 0; i < count; ++i) {
+    SrtpPacket* packet = &packets[i];
+    const int in_len = packet->len;
+    int err = srtp_unprotect(session_, packet->data, &packet->len);
+    if (err == err_status_ok) {
+      ++num_unprotected;
+      continue;
+    }
+    uint32 ssrc;
+    if (GetRtpSsrc(packet->data, in_len, &ssrc))
+      srtp_stat_->AddUnprotectRtpResult(ssrc, err);
+    LOG(LS_WARNING) << "Failed to unprotect SRTP packet, err=" << err;
+    packet->len = -1;
+  }
+  return num_unprotected;
+}
+
 bool SrtpSession::GetRtpAuthParams(uint8** key, int* key_len,
                                    int* tag_len) {
 #if defined(ENABLE_EXTERNAL_AUTH)
@@ -648,6 +794,11 @@ void SrtpSession::set_signal_silent_time(uint32 signal_silent_time_in_ms) {
   srtp_stat_->set_signal_silent_time(signal_silent_time_in_ms);
 }
 
+int SrtpSession::error_count(SrtpFilter::Mode mode,
+                             SrtpFilter::Error error) const {
+  return srtp_stat_->error_count(mode, error);
+}
+
 bool SrtpSession::SetKey(int type, const std::string& cs,
                          const uint8* key, int len) {
   if (session_) {
@@ -669,13 +820,24 @@ bool SrtpSession::SetKey(int type, const std::string& cs,
   } else if (cs == CS_AES_CM_128_HMAC_SHA1_32) {
     crypto_policy_set_aes_cm_128_hmac_sha1_32(&policy.rtp);   // rtp is 32,
     crypto_policy_set_aes_cm_128_hmac_sha1_80(&policy.rtcp);  // rtcp still 80
+#ifdef OPENSSL
+  // libsrtp only has AES-GCM when it is built on OpenSSL/BoringSSL.
+  } else if (cs == CS_AEAD_AES_128_GCM) {
+    crypto_policy_set_aes_gcm_128_16_auth(&policy.rtp);
+    crypto_policy_set_aes_gcm_128_16_auth(&policy.rtcp);
+  } else if (cs == CS_AEAD_AES_256_GCM) {
+    crypto_policy_set_aes_gcm_256_16_auth(&policy.rtp);
+    crypto_policy_set_aes_gcm_256_16_auth(&policy.rtcp);
+#endif  // OPENSSL
   } else {
     LOG(LS_WARNING) << "Failed to create SRTP session: unsupported"
                     << " cipher_suite " << cs.c_str();
     return false;
   }
 
-  if (!key || len != SRTP_MASTER_KEY_LEN) {
+  int key_len, salt_len;
+  if (!key || !GetSrtpKeyAndSaltLengths(cs, &key_len, &salt_len) ||
+      len != key_len + salt_len) {
     LOG(LS_WARNING) << "Failed to create SRTP session: invalid key";
     return false;
   }
@@ -704,7 +866,10 @@ bool SrtpSession::SetKey(int type, const std::string& cs,
     LOG(LS_ERROR) << "Failed to create SRTP session, err=" << err;
     return false;
   }
-
+#ifdef HAVE_SRTP_USER_DATA
+  // Lets HandleEventThunk find this session without a global list.
+  srtp_set_user_data(session_, this);
+#endif
 
   rtp_auth_tag_len_ = policy.rtp.auth_tag_len;
   rtcp_auth_tag_len_ = policy.rtcp.auth_tag_len;
@@ -774,6 +939,14 @@ void SrtpSession::HandleEvent(const srtp_event_data_t* ev) {
 }
 
 void SrtpSession::HandleEventThunk(srtp_event_data_t* ev) {
+#ifdef HAVE_SRTP_USER_DATA
+  // libsrtp raises events from within srtp_protect/srtp_unprotect, on the
+  // thread that uses the session.
+  SrtpSession* session =
+      static_cast<SrtpSession*>(srtp_get_user_data(ev->session));
+  if (session)
+    session->HandleEvent(ev);
+#else
   rtc::GlobalLockScope ls(&lock_);
 
   for (std::list<SrtpSession*>::iterator it = sessions()->begin();
@@ -783,12 +956,15 @@ void SrtpSession::HandleEventThunk(srtp_event_data_t* ev) {
       break;
     }
   }
+#endif  // HAVE_SRTP_USER_DATA
 }
 
+#ifndef HAVE_SRTP_USER_DATA
 std::list<SrtpSession*>* SrtpSession::sessions() {
   RTC_DEFINE_STATIC_LOCAL(std::list<SrtpSession*>, sessions, ());
   return &sessions;
 }
+#endif
 
 #else   // !HAVE_SRTP
 
@@ -827,10 +1003,25 @@ bool SrtpSession::UnprotectRtcp(void* data, int in_len, int* out_len) {
   return SrtpNotAvailable(__FUNCTION__);
 }
 
+int SrtpSession::ProtectRtp(SrtpPacket* packets, int count) {
+  SrtpNotAvailable(__FUNCTION__);
+  return 0;
+}
+
+int SrtpSession::UnprotectRtp(SrtpPacket* packets, int count) {
+  SrtpNotAvailable(__FUNCTION__);
+  return 0;
+}
+
 void SrtpSession::set_signal_silent_time(uint32 signal_silent_time) {
   // Do nothing.
 }
 
+int SrtpSession::error_count(SrtpFilter::Mode mode,
+                             SrtpFilter::Error error) const {
+  return 0;
+}
+
 #endif  // HAVE_SRTP
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -840,6 +1031,7 @@ void SrtpSession::set_signal_silent_time(uint32 signal_silent_time) {
 
 SrtpStat::SrtpStat()
     : signal_silent_time_(1000) {
+  memset(error_counts_, 0, sizeof(error_counts_));
 }
 
 void SrtpStat::AddProtectRtpResult(uint32 ssrc, int result) {
@@ -893,6 +1085,7 @@ void SrtpStat::HandleSrtpResult(const SrtpStat::FailureKey& key) {
   // errors, trigger error for the first time seeing it.  After that, silent
   // the same error for a certain amount of time (default 1 sec).
   if (key.error != SrtpFilter::ERROR_NONE) {
+    ++error_counts_[key.mode][key.error];
     // For errors, signal first time and wait for 1 sec.
     FailureStat* stat = &(failures_[key]);
     uint32 current_time = rtc::Time();
@@ -911,6 +1104,7 @@ void SrtpStat::HandleSrtpResult(const SrtpStat::FailureKey& key) {
 
 SrtpStat::SrtpStat()
     : signal_silent_time_(1000) {
+  memset(error_counts_, 0, sizeof(error_counts_));
   LOG(WARNING) << "SRTP implementation is missing.";
 }
 
@@ -54,6 +54,11 @@ namespace cricket {
 extern const char CS_AES_CM_128_HMAC_SHA1_80[];
 // 128-bit AES with 32-bit SHA-1 HMAC.
 extern const char CS_AES_CM_128_HMAC_SHA1_32[];
+// 128-bit and 256-bit AES-GCM with a 16-byte tag (RFC 7714), used for both
+// SRTP and SRTCP. These need a libsrtp built on OpenSSL/BoringSSL, which uses
+// the AES-NI/PCLMULQDQ accelerated EVP implementation where the CPU has it.
+extern const char CS_AEAD_AES_128_GCM[];
+extern const char CS_AEAD_AES_256_GCM[];
 // Key is 128 bits and salt is 112 bits == 30 bytes. B64 bloat => 40 bytes.
 extern const int SRTP_MASTER_KEY_BASE64_LEN;
 
@@ -61,6 +66,26 @@ extern const int SRTP_MASTER_KEY_BASE64_LEN;
 extern const int SRTP_MASTER_KEY_KEY_LEN;
 extern const int SRTP_MASTER_KEY_SALT_LEN;
 
+// Gets the master key and salt lengths, in bytes, of the cipher suite |cs|.
+// Returns false if |cs| is unknown.
+bool GetSrtpKeyAndSaltLengths(const std::string& cs, int* key_len,
+                              int* salt_len);
+
+// Gets the AES-GCM cipher suites that both the SRTP library and the DTLS
+// stack support, most preferred first. These are only offered for DTLS-SRTP,
+// and only when enabled, see BaseChannel::set_enable_gcm_ciphers().
+void GetSupportedGcmCryptoSuites(std::vector<std::string>* crypto_suites);
+
+// An RTP packet to protect or unprotect in place with the batch methods of
+// SrtpFilter and SrtpSession. |len| is the length of the packet on input and
+// its new length on output, or -1 if the packet failed. |max_len| is the size
+// of the buffer at |data|, and is only used when protecting.
+struct SrtpPacket {
+  void* data;
+  int len;
+  int max_len;
+};
+
 class SrtpSession;
 class SrtpStat;
 
@@ -131,6 +156,12 @@ class SrtpFilter {
   bool UnprotectRtp(void* data, int in_len, int* out_len);
   bool UnprotectRtcp(void* data, int in_len, int* out_len);
 
+  // Protects/unprotects |count| RTP packets in place, and returns how many of
+  // them succeeded. This is cheaper than a call per packet when a media
+  // server has many packets of the same session ready at once.
+  int ProtectRtp(SrtpPacket* packets, int count);
+  int UnprotectRtp(SrtpPacket* packets, int count);
+
   // Returns rtp auth params from srtp context.
   bool GetRtpAuthParams(uint8** key, int* key_len, int* tag_len);
 
@@ -215,12 +246,21 @@ class SrtpSession {
   bool UnprotectRtp(void* data, int in_len, int* out_len);
   bool UnprotectRtcp(void* data, int in_len, int* out_len);
 
+  // Protects/unprotects |count| RTP packets in place, and returns how many of
+  // them succeeded. This is cheaper than a call per packet when a media
+  // server has many packets of the same session ready at once.
+  int ProtectRtp(SrtpPacket* packets, int count);
+  int UnprotectRtp(SrtpPacket* packets, int count);
+
   // Helper method to get authentication params.
   bool GetRtpAuthParams(uint8** key, int* key_len, int* tag_len);
 
   // Update the silent threshold (in ms) for signaling errors.
   void set_signal_silent_time(uint32 signal_silent_time_in_ms);
 
+  // Gets the number of packets of this session that failed with |error|.
+  int error_count(SrtpFilter::Mode mode, SrtpFilter::Error error) const;
+
   // Calls srtp_shutdown if it's initialized.
   static void Terminate();
 
@@ -236,6 +276,8 @@ class SrtpSession {
   void HandleEvent(const srtp_event_data_t* ev);
   static void HandleEventThunk(srtp_event_data_t* ev);
 
+  // The sessions that HandleEventThunk looks up the event's session in, if
+  // libsrtp can't keep a pointer to the SrtpSession as user data.
   static std::list<SrtpSession*>* sessions();
 
   srtp_ctx_t* session_;
@@ -268,6 +310,10 @@ class SrtpStat {
   void set_signal_silent_time(uint32 signal_silent_time) {
     signal_silent_time_ = signal_silent_time;
   }
+  // Get the number of packets that failed with |error|, for all SSRCs.
+  int error_count(SrtpFilter::Mode mode, SrtpFilter::Error error) const {
+    return error_counts_[mode][error];
+  }
 
   // Sigslot for reporting errors.
   sigslot::signal3<uint32, SrtpFilter::Mode, SrtpFilter::Error>
@@ -319,6 +365,9 @@ class SrtpStat {
   std::map<FailureKey, FailureStat> failures_;
   // Threshold in ms to silent the signaling errors.
   uint32 signal_silent_time_;
+  // Number of failures by mode and error. These are not signaled, so they
+  // include the failures within the silent time.
+  int error_counts_[SrtpFilter::UNPROTECT + 1][SrtpFilter::ERROR_REPLAY + 1];
 
   DISALLOW_COPY_AND_ASSIGN(SrtpStat);
 };
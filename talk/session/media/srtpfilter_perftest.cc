@@ -0,0 +1,193 @@
+/*
+ * libjingle
+ * Copyright 2015 Google Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *  2. Redistributions in binary form must reproduce the above copyright notice,
+ *     this list of conditions and the following disclaimer in the documentation
+ *     and/or other materials provided with the distribution.
+ *  3. The name of the author may not be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF
+ * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "talk/session/media/srtpfilter.h"
+#include "webrtc/base/byteorder.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/systeminfo.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+// A video sized packet, protected and unprotected in batches the size of a
+// key frame.
+const int kRtpHeaderLen = 12;
+const int kPayloadLen = 1200;
+const int kMaxAuthTagLen = 16;
+const int kBatchSize = 32;
+const int kNumBatches = 1000;
+const uint8 kKey[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ123456789ABCDEFGHI";
+const int kMaxThreads = 8;
+
+struct Throughput {
+  Throughput() : protect_us(0), unprotect_us(0) {}
+  uint64 protect_us;
+  uint64 unprotect_us;
+};
+
+// Sends |kNumBatches| batches of packets from one session to another, and
+// returns the time spent on each side.
+Throughput MeasureThroughput(const std::string& cs) {
+  Throughput result;
+  int key_len, salt_len;
+  EXPECT_TRUE(GetSrtpKeyAndSaltLengths(cs, &key_len, &salt_len));
+  SrtpSession send_session;
+  SrtpSession recv_session;
+  if (!send_session.SetSend(cs, kKey, key_len + salt_len) ||
+      !recv_session.SetRecv(cs, kKey, key_len + salt_len)) {
+    ADD_FAILURE() << cs << " is not supported";
+    return result;
+  }
+
+  const int packet_len = kRtpHeaderLen + kPayloadLen;
+  const int max_len = packet_len + kMaxAuthTagLen;
+  std::vector<uint8> buffer(kBatchSize * max_len, 0x5a);
+  SrtpPacket packets[kBatchSize];
+  uint16 seq_num = 0;
+  for (int i = 0; i < kBatchSize; ++i) {
+    uint8* header = &buffer[i * max_len];
+    header[0] = 0x80;
+    header[1] = 96;
+    rtc::SetBE32(header + 8, 0x12345678);
+    packets[i].data = header;
+    packets[i].max_len = max_len;
+  }
+
+  for (int batch = 0; batch < kNumBatches; ++batch) {
+    for (int i = 0; i < kBatchSize; ++i) {
+      rtc::SetBE16(static_cast<uint8*>(packets[i].data) + 2, ++seq_num);
+      packets[i].len = packet_len;
+    }
+    uint64 start_us = rtc::TimeMicros();
+    EXPECT_EQ(kBatchSize, send_session.ProtectRtp(packets, kBatchSize));
+    uint64 protected_us = rtc::TimeMicros();
+    EXPECT_EQ(kBatchSize, recv_session.UnprotectRtp(packets, kBatchSize));
+    result.unprotect_us += rtc::TimeMicros() - protected_us;
+    result.protect_us += protected_us - start_us;
+  }
+  return result;
+}
+
+void PrintThroughput(const std::string& measurement, const std::string& cs,
+                     uint64 elapsed_us) {
+  const int num_packets = kBatchSize * kNumBatches;
+  elapsed_us = std::max<uint64>(elapsed_us, 1);
+  webrtc::test::PrintResult(measurement + "_packet_rate", "", cs,
+                            1e6 * num_packets / elapsed_us, "packets/s", true);
+  // Bytes per cycle is below one for AES-CM, so use a finer unit.
+  int cpu_mhz = rtc::SystemInfo().GetMaxCpuSpeed();
+  if (cpu_mhz > 0) {
+    double cycles = static_cast<double>(elapsed_us) * cpu_mhz;
+    webrtc::test::PrintResult(measurement + "_bytes_per_cycle", "", cs,
+                              1000.0 * num_packets * kPayloadLen / cycles,
+                              "bytes/kcycle", true);
+  }
+}
+
+// Runs MeasureThroughput with its own pair of sessions.
+class SessionPairRunner : public rtc::Runnable {
+ public:
+  explicit SessionPairRunner(const std::string& cs) : cs_(cs) {}
+  void Run(rtc::Thread* thread) override { MeasureThroughput(cs_); }
+
+ private:
+  const std::string cs_;
+};
+
+// Returns the packets per second protected and unprotected by
+// |num_threads| threads, each with its own sessions.
+double MeasureParallelPacketRate(const std::string& cs, int num_threads) {
+  SessionPairRunner runner(cs);
+  std::vector<rtc::Thread*> threads;
+  uint64 start_us = rtc::TimeMicros();
+  for (int i = 0; i < num_threads; ++i) {
+    threads.push_back(new rtc::Thread());
+    threads.back()->Start(&runner);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads[i]->Stop();
+    delete threads[i];
+  }
+  uint64 elapsed_us = std::max<uint64>(rtc::TimeMicros() - start_us, 1);
+  return 1e6 * 2 * num_threads * kBatchSize * kNumBatches / elapsed_us;
+}
+
+void TestCipherSuite(const std::string& cs) {
+  Throughput throughput = MeasureThroughput(cs);
+  PrintThroughput("srtp_protect", cs, throughput.protect_us);
+  PrintThroughput("srtp_unprotect", cs, throughput.unprotect_us);
+}
+
+}  // namespace
+
+TEST(SrtpPerfTest, AES_CM_128_HMAC_SHA1_80) {
+  TestCipherSuite(CS_AES_CM_128_HMAC_SHA1_80);
+}
+
+#if defined(OPENSSL)
+TEST(SrtpPerfTest, AEAD_AES_128_GCM) {
+  TestCipherSuite(CS_AEAD_AES_128_GCM);
+}
+
+TEST(SrtpPerfTest, AEAD_AES_256_GCM) {
+  TestCipherSuite(CS_AEAD_AES_256_GCM);
+}
+#endif  // OPENSSL
+
+// Measures how the packet rate of independent sessions changes with the
+// number of threads. Only thread counts up to the number of available CPUs
+// are measured, since more threads than CPUs say nothing about scaling.
+TEST(SrtpPerfTest, ParallelSessions) {
+  const int num_cpus = rtc::SystemInfo().GetCurCpus();
+  const int max_threads = std::min(kMaxThreads, num_cpus);
+  double single_thread_rate = 0;
+  for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    double rate =
+        MeasureParallelPacketRate(CS_AES_CM_128_HMAC_SHA1_80, num_threads);
+    if (num_threads == 1)
+      single_thread_rate = rate;
+    const std::string trace = rtc::ToString(num_threads) + "_threads";
+    webrtc::test::PrintResult("srtp_parallel_packet_rate", "", trace, rate,
+                              "packets/s", true);
+    // 100% when each thread is as fast as a single one.
+    webrtc::test::PrintResult("srtp_parallel_efficiency", "", trace,
+                              100 * rate / (num_threads * single_thread_rate),
+                              "%", true);
+  }
+  webrtc::test::PrintResult("srtp_parallel_cpus", "", "available",
+                            num_cpus, "cpus", false);
+}
+
+}  // namespace cricket
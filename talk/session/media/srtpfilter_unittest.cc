@@ -42,6 +42,8 @@ extern "C" {
 
 using cricket::CS_AES_CM_128_HMAC_SHA1_80;
 using cricket::CS_AES_CM_128_HMAC_SHA1_32;
+using cricket::CS_AEAD_AES_128_GCM;
+using cricket::CS_AEAD_AES_256_GCM;
 using cricket::CryptoParams;
 using cricket::CS_LOCAL;
 using cricket::CS_REMOTE;
@@ -49,6 +51,15 @@ using cricket::CS_REMOTE;
 static const uint8 kTestKey1[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ1234";
 static const uint8 kTestKey2[] = "4321ZYXWVUTSRQPONMLKJIHGFEDCBA";
 static const int kTestKeyLen = 30;
+// AEAD_AES_128_GCM uses the first 28 bytes, AEAD_AES_256_GCM all 44.
+static const uint8 kTestKeyGcm1[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ123456789ABCDEFGHI";
+static const uint8 kTestKeyGcm2[] =
+    "IHGFEDCBA987654321ZYXWVUTSRQPONMLKJIHGFEDCBA";
+static const int kTestKeyGcm128Len = 28;
+static const int kTestKeyGcm256Len = 44;
+// The longest auth tag, that of the AES-GCM cipher suites.
+static const int kMaxAuthTagLen = 16;
 static const std::string kTestKeyParams1 =
     "inline:WVNfX19zZW1jdGwgKCkgewkyMjA7fQp9CnVubGVz";
 static const std::string kTestKeyParams2 =
@@ -62,11 +73,16 @@ static const cricket::CryptoParams kTestCryptoParams1(
 static const cricket::CryptoParams kTestCryptoParams2(
     1, "AES_CM_128_HMAC_SHA1_80", kTestKeyParams2, "");
 
+static bool IsGcmCipherSuite(const std::string& cs) {
+  return cs == CS_AEAD_AES_128_GCM || cs == CS_AEAD_AES_256_GCM;
+}
 static int rtp_auth_tag_len(const std::string& cs) {
+  if (IsGcmCipherSuite(cs))
+    return kMaxAuthTagLen;
   return (cs == CS_AES_CM_128_HMAC_SHA1_32) ? 4 : 10;
 }
 static int rtcp_auth_tag_len(const std::string& cs) {
-  return 10;
+  return IsGcmCipherSuite(cs) ? kMaxAuthTagLen : 10;
 }
 
 class SrtpFilterTest : public testing::Test {
@@ -92,9 +108,9 @@ class SrtpFilterTest : public testing::Test {
     EXPECT_TRUE(f2_.IsActive());
   }
   void TestProtectUnprotect(const std::string& cs1, const std::string& cs2) {
-    char rtp_packet[sizeof(kPcmuFrame) + 10];
+    char rtp_packet[sizeof(kPcmuFrame) + kMaxAuthTagLen];
     char original_rtp_packet[sizeof(kPcmuFrame)];
-    char rtcp_packet[sizeof(kRtcpReport) + 4 + 10];
+    char rtcp_packet[sizeof(kRtcpReport) + 4 + kMaxAuthTagLen];
     int rtp_len = sizeof(kPcmuFrame), rtcp_len = sizeof(kRtcpReport), out_len;
     memcpy(rtp_packet, kPcmuFrame, rtp_len);
     // In order to be able to run this test function multiple times we can not
@@ -552,6 +568,71 @@ TEST_F(SrtpFilterTest, TestProtect_SetParamsDirect_AES_CM_128_HMAC_SHA1_32) {
   TestProtectUnprotect(CS_AES_CM_128_HMAC_SHA1_32, CS_AES_CM_128_HMAC_SHA1_32);
 }
 
+#if defined(OPENSSL)
+// Test directly setting the params with AEAD_AES_128_GCM
+TEST_F(SrtpFilterTest, TestProtect_SetParamsDirect_AEAD_AES_128_GCM) {
+  EXPECT_TRUE(f1_.SetRtpParams(CS_AEAD_AES_128_GCM,
+                               kTestKeyGcm1, kTestKeyGcm128Len,
+                               CS_AEAD_AES_128_GCM,
+                               kTestKeyGcm2, kTestKeyGcm128Len));
+  EXPECT_TRUE(f2_.SetRtpParams(CS_AEAD_AES_128_GCM,
+                               kTestKeyGcm2, kTestKeyGcm128Len,
+                               CS_AEAD_AES_128_GCM,
+                               kTestKeyGcm1, kTestKeyGcm128Len));
+  EXPECT_TRUE(f1_.IsActive());
+  EXPECT_TRUE(f2_.IsActive());
+  TestProtectUnprotect(CS_AEAD_AES_128_GCM, CS_AEAD_AES_128_GCM);
+}
+
+// Test directly setting the params with AEAD_AES_256_GCM
+TEST_F(SrtpFilterTest, TestProtect_SetParamsDirect_AEAD_AES_256_GCM) {
+  EXPECT_TRUE(f1_.SetRtpParams(CS_AEAD_AES_256_GCM,
+                               kTestKeyGcm1, kTestKeyGcm256Len,
+                               CS_AEAD_AES_256_GCM,
+                               kTestKeyGcm2, kTestKeyGcm256Len));
+  EXPECT_TRUE(f2_.SetRtpParams(CS_AEAD_AES_256_GCM,
+                               kTestKeyGcm2, kTestKeyGcm256Len,
+                               CS_AEAD_AES_256_GCM,
+                               kTestKeyGcm1, kTestKeyGcm256Len));
+  EXPECT_TRUE(f1_.IsActive());
+  EXPECT_TRUE(f2_.IsActive());
+  TestProtectUnprotect(CS_AEAD_AES_256_GCM, CS_AEAD_AES_256_GCM);
+}
+#endif  // OPENSSL
+
+// Test that the batch methods fail every packet until the filter is active.
+TEST_F(SrtpFilterTest, TestProtectPacketsNotActive) {
+  char rtp_packet[sizeof(kPcmuFrame) + kMaxAuthTagLen];
+  memcpy(rtp_packet, kPcmuFrame, sizeof(kPcmuFrame));
+  cricket::SrtpPacket packet = {
+      rtp_packet, sizeof(kPcmuFrame), sizeof(rtp_packet) };
+  EXPECT_EQ(0, f1_.ProtectRtp(&packet, 1));
+  EXPECT_EQ(-1, packet.len);
+  packet.len = sizeof(kPcmuFrame);
+  EXPECT_EQ(0, f1_.UnprotectRtp(&packet, 1));
+  EXPECT_EQ(-1, packet.len);
+}
+
+// Test the key and salt lengths of each cipher suite.
+TEST_F(SrtpFilterTest, TestKeyAndSaltLengths) {
+  int key_len = 0, salt_len = 0;
+  EXPECT_TRUE(cricket::GetSrtpKeyAndSaltLengths(CS_AES_CM_128_HMAC_SHA1_80,
+                                                &key_len, &salt_len));
+  EXPECT_EQ(kTestKeyLen, key_len + salt_len);
+  EXPECT_TRUE(cricket::GetSrtpKeyAndSaltLengths(CS_AES_CM_128_HMAC_SHA1_32,
+                                                &key_len, &salt_len));
+  EXPECT_EQ(kTestKeyLen, key_len + salt_len);
+  EXPECT_TRUE(cricket::GetSrtpKeyAndSaltLengths(CS_AEAD_AES_128_GCM,
+                                                &key_len, &salt_len));
+  EXPECT_EQ(16, key_len);
+  EXPECT_EQ(12, salt_len);
+  EXPECT_TRUE(cricket::GetSrtpKeyAndSaltLengths(CS_AEAD_AES_256_GCM,
+                                                &key_len, &salt_len));
+  EXPECT_EQ(32, key_len);
+  EXPECT_EQ(12, salt_len);
+  EXPECT_FALSE(cricket::GetSrtpKeyAndSaltLengths("FOO", &key_len, &salt_len));
+}
+
 // Test directly setting the params with bogus keys
 TEST_F(SrtpFilterTest, TestSetParamsKeyTooShort) {
   EXPECT_FALSE(f1_.SetRtpParams(CS_AES_CM_128_HMAC_SHA1_80,
@@ -621,8 +702,8 @@ class SrtpSessionTest : public testing::Test {
   }
   cricket::SrtpSession s1_;
   cricket::SrtpSession s2_;
-  char rtp_packet_[sizeof(kPcmuFrame) + 10];
-  char rtcp_packet_[sizeof(kRtcpReport) + 4 + 10];
+  char rtp_packet_[sizeof(kPcmuFrame) + kMaxAuthTagLen];
+  char rtcp_packet_[sizeof(kRtcpReport) + 4 + kMaxAuthTagLen];
   int rtp_len_;
   int rtcp_len_;
 };
@@ -667,6 +748,83 @@ TEST_F(SrtpSessionTest, TestProtect_AES_CM_128_HMAC_SHA1_32) {
   TestUnprotectRtcp(CS_AES_CM_128_HMAC_SHA1_32);
 }
 
+#if defined(OPENSSL)
+// Test that we can encrypt and decrypt RTP/RTCP using AEAD_AES_128_GCM.
+TEST_F(SrtpSessionTest, TestProtect_AEAD_AES_128_GCM) {
+  EXPECT_TRUE(s1_.SetSend(CS_AEAD_AES_128_GCM, kTestKeyGcm1,
+                          kTestKeyGcm128Len));
+  EXPECT_TRUE(s2_.SetRecv(CS_AEAD_AES_128_GCM, kTestKeyGcm1,
+                          kTestKeyGcm128Len));
+  TestProtectRtp(CS_AEAD_AES_128_GCM);
+  TestProtectRtcp(CS_AEAD_AES_128_GCM);
+  TestUnprotectRtp(CS_AEAD_AES_128_GCM);
+  TestUnprotectRtcp(CS_AEAD_AES_128_GCM);
+}
+
+// Test that we can encrypt and decrypt RTP/RTCP using AEAD_AES_256_GCM.
+TEST_F(SrtpSessionTest, TestProtect_AEAD_AES_256_GCM) {
+  EXPECT_TRUE(s1_.SetSend(CS_AEAD_AES_256_GCM, kTestKeyGcm1,
+                          kTestKeyGcm256Len));
+  EXPECT_TRUE(s2_.SetRecv(CS_AEAD_AES_256_GCM, kTestKeyGcm1,
+                          kTestKeyGcm256Len));
+  TestProtectRtp(CS_AEAD_AES_256_GCM);
+  TestProtectRtcp(CS_AEAD_AES_256_GCM);
+  TestUnprotectRtp(CS_AEAD_AES_256_GCM);
+  TestUnprotectRtcp(CS_AEAD_AES_256_GCM);
+}
+#endif  // OPENSSL
+
+// Test that AES-GCM keys must have their own length, not that of AES-CM.
+TEST_F(SrtpSessionTest, TestGcmKeysWrongLength) {
+  EXPECT_FALSE(s1_.SetSend(CS_AEAD_AES_128_GCM, kTestKey1, kTestKeyLen));
+  EXPECT_FALSE(s2_.SetRecv(CS_AEAD_AES_256_GCM, kTestKey1, kTestKeyLen));
+}
+
+// Test that a batch of packets is protected and unprotected like one packet
+// at a time, and that a packet that fails doesn't affect the others.
+TEST_F(SrtpSessionTest, TestProtectUnprotectBatch) {
+  static const int kNumPackets = 8;
+  EXPECT_TRUE(s1_.SetSend(CS_AES_CM_128_HMAC_SHA1_80, kTestKey1, kTestKeyLen));
+  EXPECT_TRUE(s2_.SetRecv(CS_AES_CM_128_HMAC_SHA1_80, kTestKey1, kTestKeyLen));
+
+  char buffers[kNumPackets][sizeof(kPcmuFrame) + kMaxAuthTagLen];
+  cricket::SrtpPacket packets[kNumPackets];
+  for (int i = 0; i < kNumPackets; ++i) {
+    memcpy(buffers[i], kPcmuFrame, sizeof(kPcmuFrame));
+    rtc::SetBE16(reinterpret_cast<uint8*>(buffers[i]) + 2, i + 1);
+    packets[i].data = buffers[i];
+    packets[i].len = sizeof(kPcmuFrame);
+    packets[i].max_len = sizeof(buffers[i]);
+  }
+  // No room for the auth tag.
+  packets[2].max_len = sizeof(kPcmuFrame);
+
+  EXPECT_EQ(kNumPackets - 1, s1_.ProtectRtp(packets, kNumPackets));
+  for (int i = 0; i < kNumPackets; ++i) {
+    if (i == 2) {
+      EXPECT_EQ(-1, packets[i].len);
+      packets[i].len = sizeof(kPcmuFrame);
+    } else {
+      EXPECT_EQ(static_cast<int>(sizeof(kPcmuFrame)) +
+                    rtp_auth_tag_len(CS_AES_CM_128_HMAC_SHA1_80),
+                packets[i].len);
+    }
+  }
+
+  // The unprotected packet 2 fails authentication.
+  EXPECT_EQ(kNumPackets - 1, s2_.UnprotectRtp(packets, kNumPackets));
+  for (int i = 0; i < kNumPackets; ++i) {
+    if (i == 2) {
+      EXPECT_EQ(-1, packets[i].len);
+      continue;
+    }
+    EXPECT_EQ(static_cast<int>(sizeof(kPcmuFrame)), packets[i].len);
+    EXPECT_EQ(i + 1, rtc::GetBE16(buffers[i] + 2));
+    EXPECT_EQ(0, memcmp(buffers[i] + 4, kPcmuFrame + 4,
+                        sizeof(kPcmuFrame) - 4));
+  }
+}
+
 TEST_F(SrtpSessionTest, TestGetSendStreamPacketIndex) {
   EXPECT_TRUE(s1_.SetSend(CS_AES_CM_128_HMAC_SHA1_32, kTestKey1, kTestKeyLen));
   int64 index;
@@ -691,6 +849,23 @@ TEST_F(SrtpSessionTest, TestTamperReject) {
   EXPECT_FALSE(s2_.UnprotectRtcp(rtcp_packet_, rtcp_len_, &out_len));
 }
 
+// Test that each session counts its own failures.
+TEST_F(SrtpSessionTest, TestErrorCounts) {
+  int out_len;
+  EXPECT_TRUE(s1_.SetSend(CS_AES_CM_128_HMAC_SHA1_80, kTestKey1, kTestKeyLen));
+  EXPECT_TRUE(s2_.SetRecv(CS_AES_CM_128_HMAC_SHA1_80, kTestKey1, kTestKeyLen));
+  TestProtectRtp(CS_AES_CM_128_HMAC_SHA1_80);
+  rtp_packet_[sizeof(kPcmuFrame)] ^= 0x01;
+  EXPECT_FALSE(s2_.UnprotectRtp(rtp_packet_, rtp_len_, &out_len));
+  EXPECT_FALSE(s2_.UnprotectRtp(rtp_packet_, rtp_len_, &out_len));
+  EXPECT_EQ(2, s2_.error_count(cricket::SrtpFilter::UNPROTECT,
+                               cricket::SrtpFilter::ERROR_AUTH));
+  EXPECT_EQ(0, s2_.error_count(cricket::SrtpFilter::UNPROTECT,
+                               cricket::SrtpFilter::ERROR_REPLAY));
+  EXPECT_EQ(0, s1_.error_count(cricket::SrtpFilter::UNPROTECT,
+                               cricket::SrtpFilter::ERROR_AUTH));
+}
+
 // Test that we fail to unprotect if the payloads are not authenticated.
 TEST_F(SrtpSessionTest, TestUnencryptReject) {
   int out_len;
@@ -873,6 +1048,23 @@ TEST_F(SrtpStatTest, TestUnprotectRtpError) {
   EXPECT_EQ(cricket::SrtpFilter::ERROR_FAIL, error_);
 }
 
+// Test that errors are counted even when they are not signaled.
+TEST_F(SrtpStatTest, TestErrorCounts) {
+  srtp_stat_.AddUnprotectRtpResult(1, err_status_ok);
+  srtp_stat_.AddUnprotectRtpResult(1, err_status_replay_fail);
+  srtp_stat_.AddUnprotectRtpResult(2, err_status_replay_old);
+  srtp_stat_.AddUnprotectRtpResult(1, err_status_replay_fail);
+  srtp_stat_.AddProtectRtcpResult(err_status_fail);
+  EXPECT_EQ(0, srtp_stat_.error_count(cricket::SrtpFilter::UNPROTECT,
+                                      cricket::SrtpFilter::ERROR_NONE));
+  EXPECT_EQ(3, srtp_stat_.error_count(cricket::SrtpFilter::UNPROTECT,
+                                      cricket::SrtpFilter::ERROR_REPLAY));
+  EXPECT_EQ(1, srtp_stat_.error_count(cricket::SrtpFilter::PROTECT,
+                                      cricket::SrtpFilter::ERROR_FAIL));
+  EXPECT_EQ(0, srtp_stat_.error_count(cricket::SrtpFilter::PROTECT,
+                                      cricket::SrtpFilter::ERROR_AUTH));
+}
+
 TEST_F(SrtpStatTest, TestProtectRtcpError) {
   Reset();
   srtp_stat_.AddProtectRtcpResult(err_status_ok);
@@ -20,6 +20,8 @@
 #include <windows.h>
 #endif  // defined(WEBRTC_WIN)
 
+#include <stdint.h>
+
 namespace rtc {
 class AtomicOps {
  public:
@@ -42,6 +44,39 @@ class AtomicOps {
                                         new_value,
                                         old_value);
   }
+  // Aligned int loads and stores are atomic, and volatile accesses have
+  // acquire and release semantics with MSVC.
+  static int AcquireLoad(volatile const int* i) {
+    return *i;
+  }
+  static void ReleaseStore(volatile int* i, int value) {
+    *i = value;
+  }
+  // MemoryBarrier() is a full fence.
+  static void AcquireFence() {
+    ::MemoryBarrier();
+  }
+  static void ReleaseFence() {
+    ::MemoryBarrier();
+  }
+  // Pointer loads and stores are atomic on Windows, and volatile accesses
+  // have acquire and release semantics with MSVC.
+  template <typename T>
+  static T* AcquireLoadPtr(T* const volatile* ptr) {
+    return *ptr;
+  }
+  template <typename T>
+  static void ReleaseStorePtr(T* volatile* ptr, T* value) {
+    *ptr = value;
+  }
+  // Aligned pointer sized loads and stores are atomic. Volatile accesses
+  // order more than relaxed ones need to.
+  static intptr_t RelaxedLoadWord(volatile const intptr_t* i) {
+    return *i;
+  }
+  static void RelaxedStoreWord(volatile intptr_t* i, intptr_t value) {
+    *i = value;
+  }
 #else
   static int Increment(volatile int* i) {
     return __sync_add_and_fetch(i, 1);
@@ -60,6 +95,38 @@ class AtomicOps {
   static int CompareAndSwap(volatile int* i, int old_value, int new_value) {
     return __sync_val_compare_and_swap(i, old_value, new_value);
   }
+  static int AcquireLoad(volatile const int* i) {
+    return __atomic_load_n(i, __ATOMIC_ACQUIRE);
+  }
+  static void ReleaseStore(volatile int* i, int value) {
+    __atomic_store_n(i, value, __ATOMIC_RELEASE);
+  }
+  // Keeps the loads before the fence from being reordered with the loads and
+  // stores after it.
+  static void AcquireFence() {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  }
+  // Keeps the loads and stores before the fence from being reordered with the
+  // stores after it.
+  static void ReleaseFence() {
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+  template <typename T>
+  static T* AcquireLoadPtr(T* const volatile* ptr) {
+    return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+  }
+  template <typename T>
+  static void ReleaseStorePtr(T* volatile* ptr, T* value) {
+    __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+  }
+  // Atomic, but unordered with respect to other memory accesses. Combined
+  // with the fences above, these copy data that is read while it is written.
+  static intptr_t RelaxedLoadWord(volatile const intptr_t* i) {
+    return __atomic_load_n(i, __ATOMIC_RELAXED);
+  }
+  static void RelaxedStoreWord(volatile intptr_t* i, intptr_t value) {
+    __atomic_store_n(i, value, __ATOMIC_RELAXED);
+  }
 #endif
 };
 
@@ -203,6 +203,25 @@ TEST(BitBufferTest, GolombUint32Values) {
   }
 }
 
+TEST(BitBufferTest, SignedGolombValues) {
+  uint8 golomb_bits[] = {
+      0x80,  // 1
+      0x40,  // 010
+      0x60,  // 011
+      0x20,  // 00100
+      0x38,  // 00111
+  };
+  int32 expected[] = {0, 1, -1, 2, -3};
+  for (size_t i = 0; i < sizeof(golomb_bits); ++i) {
+    BitBuffer buffer(&golomb_bits[i], 1);
+    int32 decoded_val;
+    ASSERT_TRUE(buffer.ReadSignedExponentialGolomb(&decoded_val));
+    EXPECT_EQ(expected[i], decoded_val)
+        << "Mismatch in expected/decoded value for golomb_bits[" << i
+        << "]: " << static_cast<int>(golomb_bits[i]);
+  }
+}
+
 TEST(BitBufferTest, NoGolombOverread) {
   const uint8 bytes[] = {0x00, 0xFF, 0xFF};
   // Make sure the bit buffer correctly enforces byte length on golomb reads.
@@ -221,6 +240,23 @@ TEST(BitBufferTest, NoGolombOverread) {
   EXPECT_EQ(0x01FEu, decoded_val);
 }
 
+TEST(BitBufferWriterTest, SymmetricSignedGolomb) {
+  uint8 bytes[64] = {0};
+  BitBufferWriter buffer(bytes, sizeof(bytes));
+  const int32 kValues[] = {0, 1, -1, 2, -2, 1000, -1000, 65535, -65535};
+  for (int32 value : kValues)
+    EXPECT_TRUE(buffer.WriteSignedExponentialGolomb(value));
+  EXPECT_FALSE(buffer.WriteSignedExponentialGolomb(
+      std::numeric_limits<int32>::min()));
+
+  buffer.Seek(0, 0);
+  for (int32 value : kValues) {
+    int32 decoded_val;
+    EXPECT_TRUE(buffer.ReadSignedExponentialGolomb(&decoded_val));
+    EXPECT_EQ(value, decoded_val);
+  }
+}
+
 TEST(BitBufferWriterTest, SymmetricReadWrite) {
   uint8 bytes[16] = {0};
   BitBufferWriter buffer(bytes, 4);
@@ -249,6 +249,17 @@ bool CreateRandomString(size_t len, const std::string& table,
                             static_cast<int>(table.size()), str);
 }
 
+bool CreateRandomData(size_t length, std::string* data) {
+  data->clear();
+  scoped_ptr<uint8[]> bytes(new uint8[length]);
+  if (!Rng().Generate(bytes.get(), length)) {
+    LOG(LS_ERROR) << "Failed to generate random data!";
+    return false;
+  }
+  data->assign(reinterpret_cast<const char*>(bytes.get()), length);
+  return true;
+}
+
 uint32 CreateRandomId() {
   uint32 id;
   if (!Rng().Generate(&id, sizeof(id))) {
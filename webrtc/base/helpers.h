@@ -39,6 +39,10 @@ bool CreateRandomString(size_t length, std::string* str);
 bool CreateRandomString(size_t length, const std::string& table,
                         std::string* str);
 
+// Generates (cryptographically) random data of the given length, e.g. for
+// keys. Return false if the random number generator failed.
+bool CreateRandomData(size_t length, std::string* data);
+
 // Generates a random id.
 uint32 CreateRandomId();
 
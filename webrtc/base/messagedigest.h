@@ -85,7 +85,14 @@ inline std::string MD5(const std::string& input) {
 size_t ComputeHmac(MessageDigest* digest, const void* key, size_t key_len,
                    const void* input, size_t in_len,
                    void* output, size_t out_len);
-// Like the previous function, but creates a digest implementation based on
+// Like the previous function, but computes the HMAC of |in_len1| bytes of
+// |input1| followed by |in_len2| bytes of |input2|, so that a part of a
+// message can be replaced without copying all of it.
+size_t ComputeHmac(MessageDigest* digest, const void* key, size_t key_len,
+                   const void* input1, size_t in_len1,
+                   const void* input2, size_t in_len2,
+                   void* output, size_t out_len);
+// Like ComputeHmac() above, but creates a digest implementation based on
 // the desired digest name |alg|, e.g. DIGEST_SHA_1. Returns 0 if there is no
 // digest with the given name.
 size_t ComputeHmac(const std::string& alg, const void* key, size_t key_len,
@@ -29,6 +29,9 @@ namespace rtc {
 
 const uint32 kMaxMsgLatency = 150;  // 150 ms
 
+// Nodes are allocated this many at a time.
+const size_t kNodesPerBlock = 64;
+
 //------------------------------------------------------------------
 // MessageQueueManager
 
@@ -118,7 +121,8 @@ void MessageQueueManager::ClearInternal(MessageHandler *handler) {
 
 MessageQueue::MessageQueue(SocketServer* ss)
     : ss_(ss), fStop_(false), fPeekKeep_(false),
-      dmsgq_next_num_(0) {
+      msgq_head_(NULL), msgq_tail_(NULL), msgq_size_(0),
+      dmsgq_next_num_(0), free_nodes_(NULL) {
   if (!ss_) {
     // Currently, MessageQueue holds a socket server, and is the base class for
     // Thread.  It seems like it makes more sense for Thread to hold the socket
@@ -142,6 +146,8 @@ MessageQueue::~MessageQueue() {
   if (ss_) {
     ss_->SetMessageQueue(NULL);
   }
+  for (size_t i = 0; i < node_blocks_.size(); ++i)
+    delete[] node_blocks_[i];
 }
 
 void MessageQueue::set_socketserver(SocketServer* ss) {
@@ -208,20 +214,20 @@ bool MessageQueue::Get(Message *pmsg, int cmsWait, bool process_io) {
         if (first_pass) {
           first_pass = false;
           while (!dmsgq_.empty()) {
-            if (TimeIsLater(msCurrent, dmsgq_.top().msTrigger_)) {
-              cmsDelayNext = TimeDiff(dmsgq_.top().msTrigger_, msCurrent);
+            if (TimeIsLater(msCurrent, dmsgq_[0].trigger)) {
+              cmsDelayNext = TimeDiff(dmsgq_[0].trigger, msCurrent);
               break;
             }
-            msgq_.push_back(dmsgq_.top().msg_);
-            dmsgq_.pop();
+            PushBack(PopDelayed());
           }
         }
         // Pull a message off the message queue, if available.
-        if (msgq_.empty()) {
+        if (!msgq_head_) {
           break;
         } else {
-          *pmsg = msgq_.front();
-          msgq_.pop_front();
+          Node* node = PopFront();
+          *pmsg = node->msg;
+          DeleteNode(node);
         }
       }  // crit_ is released here.
 
@@ -286,14 +292,11 @@ void MessageQueue::Post(MessageHandler *phandler, uint32 id,
   // Signal for the multiplexer to return
 
   CritScope cs(&crit_);
-  Message msg;
-  msg.phandler = phandler;
-  msg.message_id = id;
-  msg.pdata = pdata;
+  Node* node = NewNode(phandler, id, pdata);
   if (time_sensitive) {
-    msg.ts_sensitive = Time() + kMaxMsgLatency;
+    node->msg.ts_sensitive = Time() + kMaxMsgLatency;
   }
-  msgq_.push_back(msg);
+  PushBack(node);
   ss_->WakeUp();
 }
 
@@ -321,12 +324,11 @@ void MessageQueue::DoDelayPost(int cmsDelay, uint32 tstamp,
   // Signal for the multiplexer to return.
 
   CritScope cs(&crit_);
-  Message msg;
-  msg.phandler = phandler;
-  msg.message_id = id;
-  msg.pdata = pdata;
-  DelayedMessage dmsg(cmsDelay, tstamp, dmsgq_next_num_, msg);
-  dmsgq_.push(dmsg);
+  DelayedNode dnode;
+  dnode.trigger = tstamp;
+  dnode.num = dmsgq_next_num_;
+  dnode.node = NewNode(phandler, id, pdata);
+  PushDelayed(dnode);
   // If this message queue processes 1 message every millisecond for 50 days,
   // we will wrap this number.  Even then, only messages with identical times
   // will be misordered, and then only briefly.  This is probably ok.
@@ -337,11 +339,11 @@ void MessageQueue::DoDelayPost(int cmsDelay, uint32 tstamp,
 int MessageQueue::GetDelay() {
   CritScope cs(&crit_);
 
-  if (!msgq_.empty())
+  if (msgq_head_)
     return 0;
 
   if (!dmsgq_.empty()) {
-    int delay = TimeUntil(dmsgq_.top().msTrigger_);
+    int delay = TimeUntil(dmsgq_[0].trigger);
     if (delay < 0)
       delay = 0;
     return delay;
@@ -367,40 +369,154 @@ void MessageQueue::Clear(MessageHandler *phandler, uint32 id,
 
   // Remove from ordered message queue
 
-  for (MessageList::iterator it = msgq_.begin(); it != msgq_.end();) {
-    if (it->Match(phandler, id)) {
+  Node* prev = NULL;
+  for (Node* node = msgq_head_; node;) {
+    Node* next = node->next;
+    if (node->msg.Match(phandler, id)) {
       if (removed) {
-        removed->push_back(*it);
+        removed->push_back(node->msg);
+      } else {
+        delete node->msg.pdata;
+      }
+      if (prev) {
+        prev->next = next;
       } else {
-        delete it->pdata;
+        msgq_head_ = next;
       }
-      it = msgq_.erase(it);
+      if (msgq_tail_ == node)
+        msgq_tail_ = prev;
+      --msgq_size_;
+      DeleteNode(node);
     } else {
-      ++it;
+      prev = node;
     }
+    node = next;
   }
 
-  // Remove from priority queue. Not directly iterable, so use this approach
+  // Remove from the delayed messages, and restore the heap if any were
+  // removed.
 
-  PriorityQueue::container_type::iterator new_end = dmsgq_.container().begin();
-  for (PriorityQueue::container_type::iterator it = new_end;
-       it != dmsgq_.container().end(); ++it) {
-    if (it->msg_.Match(phandler, id)) {
+  std::vector<DelayedNode>::iterator new_end = dmsgq_.begin();
+  for (std::vector<DelayedNode>::iterator it = new_end; it != dmsgq_.end();
+       ++it) {
+    if (it->node->msg.Match(phandler, id)) {
       if (removed) {
-        removed->push_back(it->msg_);
+        removed->push_back(it->node->msg);
       } else {
-        delete it->msg_.pdata;
+        delete it->node->msg.pdata;
       }
+      DeleteNode(it->node);
     } else {
       *new_end++ = *it;
     }
   }
-  dmsgq_.container().erase(new_end, dmsgq_.container().end());
-  dmsgq_.reheap();
+  if (new_end != dmsgq_.end()) {
+    dmsgq_.erase(new_end, dmsgq_.end());
+    // Sift down every node that has children, from the last one up.
+    for (size_t i = dmsgq_.size() > 1 ? (dmsgq_.size() - 2) / 4 + 1 : 0;
+         i > 0; --i) {
+      SiftDown(i - 1);
+    }
+  }
 }
 
 void MessageQueue::Dispatch(Message *pmsg) {
   pmsg->phandler->OnMessage(pmsg);
 }
 
+MessageQueue::Node* MessageQueue::NewNode(MessageHandler* phandler,
+                                          uint32 id,
+                                          MessageData* pdata) {
+  if (!free_nodes_) {
+    Node* block = new Node[kNodesPerBlock];
+    node_blocks_.push_back(block);
+    for (size_t i = 0; i < kNodesPerBlock; ++i)
+      DeleteNode(&block[i]);
+  }
+  Node* node = free_nodes_;
+  free_nodes_ = node->next;
+  node->msg = Message();
+  node->msg.phandler = phandler;
+  node->msg.message_id = id;
+  node->msg.pdata = pdata;
+  node->next = NULL;
+  return node;
+}
+
+void MessageQueue::DeleteNode(Node* node) {
+  node->next = free_nodes_;
+  free_nodes_ = node;
+}
+
+void MessageQueue::PushBack(Node* node) {
+  node->next = NULL;
+  if (msgq_tail_) {
+    msgq_tail_->next = node;
+  } else {
+    msgq_head_ = node;
+  }
+  msgq_tail_ = node;
+  ++msgq_size_;
+}
+
+MessageQueue::Node* MessageQueue::PopFront() {
+  Node* node = msgq_head_;
+  msgq_head_ = node->next;
+  if (!msgq_head_)
+    msgq_tail_ = NULL;
+  --msgq_size_;
+  return node;
+}
+
+bool MessageQueue::IsDueBefore(const DelayedNode& a, const DelayedNode& b) {
+  return (a.trigger < b.trigger)
+         || ((a.trigger == b.trigger) && (a.num < b.num));
+}
+
+void MessageQueue::PushDelayed(const DelayedNode& dnode) {
+  dmsgq_.push_back(dnode);
+  SiftUp(dmsgq_.size() - 1);
+}
+
+MessageQueue::Node* MessageQueue::PopDelayed() {
+  Node* node = dmsgq_[0].node;
+  dmsgq_[0] = dmsgq_.back();
+  dmsgq_.pop_back();
+  if (!dmsgq_.empty())
+    SiftDown(0);
+  return node;
+}
+
+void MessageQueue::SiftUp(size_t index) {
+  DelayedNode dnode = dmsgq_[index];
+  while (index > 0) {
+    size_t parent = (index - 1) / 4;
+    if (!IsDueBefore(dnode, dmsgq_[parent]))
+      break;
+    dmsgq_[index] = dmsgq_[parent];
+    index = parent;
+  }
+  dmsgq_[index] = dnode;
+}
+
+void MessageQueue::SiftDown(size_t index) {
+  DelayedNode dnode = dmsgq_[index];
+  while (true) {
+    size_t first_child = 4 * index + 1;
+    if (first_child >= dmsgq_.size())
+      break;
+    size_t last_child = std::min(first_child + 4, dmsgq_.size());
+    size_t child = first_child;
+    for (size_t i = first_child + 1; i < last_child; ++i) {
+      if (IsDueBefore(dmsgq_[i], dmsgq_[child]))
+        child = i;
+    }
+    if (!IsDueBefore(dmsgq_[child], dnode))
+      break;
+    dmsgq_[index] = dmsgq_[child];
+    index = child;
+  }
+  dmsgq_[index] = dnode;
+}
+
 }  // namespace rtc
@@ -15,7 +15,6 @@
 
 #include <algorithm>
 #include <list>
-#include <queue>
 #include <vector>
 
 #include "webrtc/base/basictypes.h"
@@ -144,25 +143,6 @@ struct Message {
 
 typedef std::list<Message> MessageList;
 
-// DelayedMessage goes into a priority queue, sorted by trigger time.  Messages
-// with the same trigger time are processed in num_ (FIFO) order.
-
-class DelayedMessage {
- public:
-  DelayedMessage(int delay, uint32 trigger, uint32 num, const Message& msg)
-  : cmsDelay_(delay), msTrigger_(trigger), num_(num), msg_(msg) { }
-
-  bool operator< (const DelayedMessage& dmsg) const {
-    return (dmsg.msTrigger_ < msTrigger_)
-           || ((dmsg.msTrigger_ == msTrigger_) && (dmsg.num_ < num_));
-  }
-
-  int cmsDelay_;  // for debugging
-  uint32 msTrigger_;
-  uint32 num_;
-  Message msg_;
-};
-
 class MessageQueue {
  public:
   static const int kForever = -1;
@@ -211,7 +191,7 @@ class MessageQueue {
   bool empty() const { return size() == 0u; }
   size_t size() const {
     CritScope cs(&crit_);  // msgq_.size() is not thread safe.
-    return msgq_.size() + dmsgq_.size() + (fPeekKeep_ ? 1u : 0u);
+    return msgq_size_ + dmsgq_.size() + (fPeekKeep_ ? 1u : 0u);
   }
 
   // Internally posts a message which causes the doomed object to be deleted
@@ -226,15 +206,38 @@ class MessageQueue {
   sigslot::signal0<> SignalQueueDestroyed;
 
  protected:
-  class PriorityQueue : public std::priority_queue<DelayedMessage> {
-   public:
-    container_type& container() { return c; }
-    void reheap() { make_heap(c.begin(), c.end(), comp); }
+  // A queued message.  Nodes are recycled through |free_nodes_|, so that
+  // posting does not allocate once the queue has warmed up.
+  struct Node {
+    Message msg;
+    Node* next;
+  };
+
+  // An entry of the delayed message heap.  The sort keys are kept next to the
+  // node so that sifting does not have to touch the nodes.
+  struct DelayedNode {
+    uint32 trigger;  // When the message is due.
+    uint32 num;      // Orders the messages due at the same time.
+    Node* node;
   };
 
   void DoDelayPost(int cmsDelay, uint32 tstamp, MessageHandler *phandler,
                    uint32 id, MessageData* pdata);
 
+  // Must be called with |crit_| held.
+  Node* NewNode(MessageHandler* phandler, uint32 id, MessageData* pdata);
+  void DeleteNode(Node* node);
+  void PushBack(Node* node);
+  Node* PopFront();
+
+  // The delayed messages are kept in a 4-ary min-heap, which is shallower
+  // than a binary one and looks at adjacent children when sifting down.
+  static bool IsDueBefore(const DelayedNode& a, const DelayedNode& b);
+  void PushDelayed(const DelayedNode& dnode);
+  Node* PopDelayed();
+  void SiftUp(size_t index);
+  void SiftDown(size_t index);
+
   // The SocketServer is not owned by MessageQueue.
   SocketServer* ss_;
   // If a server isn't supplied in the constructor, use this one.
@@ -242,9 +245,16 @@ class MessageQueue {
   bool fStop_;
   bool fPeekKeep_;
   Message msgPeek_;
-  MessageList msgq_;
-  PriorityQueue dmsgq_;
+  // The messages ready to be dispatched, linked through Node::next.
+  Node* msgq_head_;
+  Node* msgq_tail_;
+  size_t msgq_size_;
+  std::vector<DelayedNode> dmsgq_;
   uint32 dmsgq_next_num_;
+  // Unused nodes, linked through Node::next, and the blocks of nodes they
+  // come from.
+  Node* free_nodes_;
+  std::vector<Node*> node_blocks_;
   mutable CriticalSection crit_;
 
  private:
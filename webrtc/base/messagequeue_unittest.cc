@@ -80,17 +80,6 @@ TEST_F(MessageQueueTest,
   DelayedPostsWithIdenticalTimesAreProcessedInFifoOrder(&q_nullss);
 }
 
-TEST_F(MessageQueueTest, DisposeNotLocked) {
-  bool was_locked = true;
-  bool deleted = false;
-  DeletedLockChecker* d = new DeletedLockChecker(this, &was_locked, &deleted);
-  Dispose(d);
-  Message msg;
-  EXPECT_FALSE(Get(&msg, 0));
-  EXPECT_TRUE(deleted);
-  EXPECT_FALSE(was_locked);
-}
-
 class DeletedMessageHandler : public MessageHandler {
  public:
   explicit DeletedMessageHandler(bool* deleted) : deleted_(deleted) { }
@@ -102,6 +91,72 @@ class DeletedMessageHandler : public MessageHandler {
   bool* deleted_;
 };
 
+TEST_F(MessageQueueTest, DelayedPostsAreProcessedInTimeOrder) {
+  const uint32 kNumMessages = 1000;
+  TimeStamp now = Time();
+  // Message i is due at now - kNumMessages + i, posted in shuffled order.
+  for (uint32 i = 0; i < kNumMessages; ++i) {
+    uint32 id = (i * 7919) % kNumMessages;
+    PostAt(now - kNumMessages + id, NULL, id);
+  }
+  EXPECT_EQ(kNumMessages, size());
+
+  Message msg;
+  for (uint32 i = 0; i < kNumMessages; ++i) {
+    EXPECT_TRUE(Get(&msg, 0));
+    EXPECT_EQ(i, msg.message_id);
+  }
+  EXPECT_FALSE(Get(&msg, 0));
+}
+
+TEST_F(MessageQueueTest, ClearKeepsTheOrderOfOtherMessages) {
+  const uint32 kNumMessages = 100;
+  bool deleted = false;
+  DeletedMessageHandler handler(&deleted);
+  TimeStamp now = Time();
+  for (uint32 i = 0; i < kNumMessages; ++i) {
+    uint32 id = (i * 37) % kNumMessages;
+    // Every third message, delayed or not, goes to |handler|.
+    MessageHandler* phandler = (id % 3 == 0) ? &handler : NULL;
+    PostAt(now - kNumMessages + id, phandler, id);
+    Post(phandler, kNumMessages + id);
+  }
+
+  MessageList removed;
+  Clear(&handler, MQID_ANY, &removed);
+  EXPECT_EQ(2 * (kNumMessages / 3 + 1), removed.size());
+  EXPECT_EQ(2 * kNumMessages - removed.size(), size());
+
+  // The remaining immediate messages come in the order they were posted,
+  // followed by the delayed ones in the order they are due.
+  Message msg;
+  for (uint32 i = 0; i < kNumMessages; ++i) {
+    uint32 id = (i * 37) % kNumMessages;
+    if (id % 3 != 0) {
+      EXPECT_TRUE(Get(&msg, 0));
+      EXPECT_EQ(kNumMessages + id, msg.message_id);
+    }
+  }
+  for (uint32 id = 0; id < kNumMessages; ++id) {
+    if (id % 3 != 0) {
+      EXPECT_TRUE(Get(&msg, 0));
+      EXPECT_EQ(id, msg.message_id);
+    }
+  }
+  EXPECT_FALSE(Get(&msg, 0));
+}
+
+TEST_F(MessageQueueTest, DisposeNotLocked) {
+  bool was_locked = true;
+  bool deleted = false;
+  DeletedLockChecker* d = new DeletedLockChecker(this, &was_locked, &deleted);
+  Dispose(d);
+  Message msg;
+  EXPECT_FALSE(Get(&msg, 0));
+  EXPECT_TRUE(deleted);
+  EXPECT_FALSE(was_locked);
+}
+
 TEST_F(MessageQueueTest, DiposeHandlerWithPostedMessagePending) {
   bool deleted = false;
   DeletedMessageHandler *handler = new DeletedMessageHandler(&deleted);
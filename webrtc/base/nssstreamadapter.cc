@@ -1093,6 +1093,10 @@ bool NSSStreamAdapter::HaveExporter() {
   return true;
 }
 
+bool NSSStreamAdapter::HaveGcmSrtp() {
+  return false;
+}
+
 std::string NSSStreamAdapter::GetDefaultSslCipher(SSLProtocolVersion version) {
   switch (version) {
     case SSL_PROTOCOL_TLS_10:
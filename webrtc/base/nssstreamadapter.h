@@ -91,6 +91,7 @@ class NSSStreamAdapter : public SSLStreamAdapterHelper {
   static bool HaveDtls();
   static bool HaveDtlsSrtp();
   static bool HaveExporter();
+  static bool HaveGcmSrtp();
   static std::string GetDefaultSslCipher(SSLProtocolVersion version);
 
  protected:
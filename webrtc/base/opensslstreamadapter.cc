@@ -42,6 +42,10 @@ namespace rtc {
 #define HAVE_DTLS_SRTP
 #endif
 
+#if defined(HAVE_DTLS_SRTP) && defined(SRTP_AEAD_AES_128_GCM)
+#define HAVE_DTLS_SRTP_GCM
+#endif
+
 #ifdef HAVE_DTLS_SRTP
 // SRTP cipher suite table
 struct SrtpCipherMapEntry {
@@ -53,6 +57,10 @@ struct SrtpCipherMapEntry {
 static SrtpCipherMapEntry SrtpCipherMap[] = {
   {"AES_CM_128_HMAC_SHA1_80", "SRTP_AES128_CM_SHA1_80"},
   {"AES_CM_128_HMAC_SHA1_32", "SRTP_AES128_CM_SHA1_32"},
+#ifdef HAVE_DTLS_SRTP_GCM
+  {"AEAD_AES_128_GCM", "SRTP_AEAD_AES_128_GCM"},
+  {"AEAD_AES_256_GCM", "SRTP_AEAD_AES_256_GCM"},
+#endif
   {NULL, NULL}
 };
 #endif
@@ -1117,6 +1125,14 @@ bool OpenSSLStreamAdapter::HaveExporter() {
 #endif
 }
 
+bool OpenSSLStreamAdapter::HaveGcmSrtp() {
+#ifdef HAVE_DTLS_SRTP_GCM
+  return true;
+#else
+  return false;
+#endif
+}
+
 std::string OpenSSLStreamAdapter::GetDefaultSslCipher(
     SSLProtocolVersion version) {
   switch (version) {
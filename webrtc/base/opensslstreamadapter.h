@@ -110,6 +110,7 @@ class OpenSSLStreamAdapter : public SSLStreamAdapter {
   static bool HaveDtls();
   static bool HaveDtlsSrtp();
   static bool HaveExporter();
+  static bool HaveGcmSrtp();
   static std::string GetDefaultSslCipher(SSLProtocolVersion version);
 
  protected:
@@ -532,6 +532,15 @@ class PhysicalSocket : public AsyncSocket, public sigslot::has_slots<> {
         return -1;
       case OPT_RTP_SENDTIME_EXTN_ID:
         return -1;  // No logging is necessary as this not a OS socket option.
+      case OPT_REUSEPORT:
+#if defined(WEBRTC_LINUX) && defined(SO_REUSEPORT)
+        *slevel = SOL_SOCKET;
+        *sopt = SO_REUSEPORT;
+        break;
+#else
+        LOG(LS_WARNING) << "Socket::OPT_REUSEPORT not supported.";
+        return -1;
+#endif
       default:
         ASSERT(false);
         return -1;
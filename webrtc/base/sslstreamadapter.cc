@@ -72,6 +72,7 @@ bool SSLStreamAdapter::GetDtlsSrtpCipher(std::string* cipher) {
 bool SSLStreamAdapter::HaveDtls() { return false; }
 bool SSLStreamAdapter::HaveDtlsSrtp() { return false; }
 bool SSLStreamAdapter::HaveExporter() { return false; }
+bool SSLStreamAdapter::HaveGcmSrtp() { return false; }
 std::string SSLStreamAdapter::GetDefaultSslCipher(SSLProtocolVersion version) {
   return std::string();
 }
@@ -85,6 +86,9 @@ bool SSLStreamAdapter::HaveDtlsSrtp() {
 bool SSLStreamAdapter::HaveExporter() {
   return OpenSSLStreamAdapter::HaveExporter();
 }
+bool SSLStreamAdapter::HaveGcmSrtp() {
+  return OpenSSLStreamAdapter::HaveGcmSrtp();
+}
 std::string SSLStreamAdapter::GetDefaultSslCipher(SSLProtocolVersion version) {
   return OpenSSLStreamAdapter::GetDefaultSslCipher(version);
 }
@@ -98,6 +102,9 @@ bool SSLStreamAdapter::HaveDtlsSrtp() {
 bool SSLStreamAdapter::HaveExporter() {
   return NSSStreamAdapter::HaveExporter();
 }
+bool SSLStreamAdapter::HaveGcmSrtp() {
+  return NSSStreamAdapter::HaveGcmSrtp();
+}
 std::string SSLStreamAdapter::GetDefaultSslCipher(SSLProtocolVersion version) {
   return NSSStreamAdapter::GetDefaultSslCipher(version);
 }
@@ -164,6 +164,8 @@ class SSLStreamAdapter : public StreamAdapterInterface {
   static bool HaveDtls();
   static bool HaveDtlsSrtp();
   static bool HaveExporter();
+  // True if the AES-GCM DTLS-SRTP profiles (RFC 7714) can be negotiated.
+  static bool HaveGcmSrtp();
 
   // Returns the default Ssl cipher used between streams of this class
   // for the given protocol version. This is used by the unit tests.
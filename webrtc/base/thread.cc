@@ -140,6 +140,8 @@ Thread::ScopedDisallowBlockingCalls::~ScopedDisallowBlockingCalls() {
 
 Thread::Thread(SocketServer* ss)
     : MessageQueue(ss),
+      sendlist_head_(NULL),
+      sendlist_tail_(NULL),
       priority_(PRIORITY_NORMAL),
       running_(true, false),
 #if defined(WEBRTC_WIN)
@@ -403,18 +405,29 @@ void Thread::Send(MessageHandler *phandler, uint32 id, MessageData *pdata) {
 
   AssertBlockingIsAllowedOnCurrentThread();
 
-  AutoThread thread;
+  // Only wrap the current thread if it isn't already, since creating a
+  // thread is much more expensive than the Send itself.
   Thread *current_thread = Thread::Current();
+  scoped_ptr<AutoThread> thread;
+  if (!current_thread) {
+    thread.reset(new AutoThread());
+    current_thread = Thread::Current();
+  }
   ASSERT(current_thread != NULL);  // AutoThread ensures this
 
   bool ready = false;
+  _SendMessage smsg;
+  smsg.thread = current_thread;
+  smsg.msg = msg;
+  smsg.ready = &ready;
   {
     CritScope cs(&crit_);
-    _SendMessage smsg;
-    smsg.thread = current_thread;
-    smsg.msg = msg;
-    smsg.ready = &ready;
-    sendlist_.push_back(smsg);
+    if (sendlist_tail_) {
+      sendlist_tail_->next = &smsg;
+    } else {
+      sendlist_head_ = &smsg;
+    }
+    sendlist_tail_ = &smsg;
   }
 
   // Wait for a reply
@@ -476,17 +489,28 @@ void Thread::ReceiveSendsFromThread(const Thread* source) {
 }
 
 bool Thread::PopSendMessageFromThread(const Thread* source, _SendMessage* msg) {
-  for (std::list<_SendMessage>::iterator it = sendlist_.begin();
-       it != sendlist_.end(); ++it) {
+  _SendMessage* prev = NULL;
+  for (_SendMessage* it = sendlist_head_; it; prev = it, it = it->next) {
     if (it->thread == source || source == NULL) {
       *msg = *it;
-      sendlist_.erase(it);
+      UnlinkSendMessage(prev, it);
       return true;
     }
   }
   return false;
 }
 
+void Thread::UnlinkSendMessage(_SendMessage* prev, _SendMessage* smsg) {
+  if (prev) {
+    prev->next = smsg->next;
+  } else {
+    sendlist_head_ = smsg->next;
+  }
+  if (sendlist_tail_ == smsg)
+    sendlist_tail_ = prev;
+  smsg->next = NULL;
+}
+
 void Thread::InvokeBegin() {
   TRACE_EVENT_BEGIN0("webrtc", "Thread::Invoke");
 }
@@ -503,8 +527,11 @@ void Thread::Clear(MessageHandler *phandler, uint32 id,
   // Object target cleared: remove from send list, wakeup/set ready
   // if sender not NULL.
 
-  std::list<_SendMessage>::iterator iter = sendlist_.begin();
-  while (iter != sendlist_.end()) {
+  _SendMessage* prev = NULL;
+  _SendMessage* iter = sendlist_head_;
+  while (iter) {
+    // The sender may return as soon as |crit_| is released after |ready| is
+    // set, so copy the message first.
     _SendMessage smsg = *iter;
     if (smsg.msg.Match(phandler, id)) {
       if (removed) {
@@ -512,12 +539,14 @@ void Thread::Clear(MessageHandler *phandler, uint32 id,
       } else {
         delete smsg.msg.pdata;
       }
-      iter = sendlist_.erase(iter);
+      UnlinkSendMessage(prev, iter);
       *smsg.ready = true;
       smsg.thread->socketserver()->WakeUp();
+      iter = smsg.next;
       continue;
     }
-    ++iter;
+    prev = iter;
+    iter = smsg.next;
   }
 
   MessageQueue::Clear(phandler, id, removed);
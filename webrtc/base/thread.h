@@ -71,11 +71,15 @@ class ThreadManager {
   DISALLOW_COPY_AND_ASSIGN(ThreadManager);
 };
 
+// A message sent to a thread.  It lives on the stack of the sending thread,
+// which waits for it to be handled, and is linked into the list of messages
+// sent to the receiving thread through |next|.
 struct _SendMessage {
-  _SendMessage() {}
+  _SendMessage() : thread(NULL), ready(NULL), next(NULL) {}
   Thread *thread;
   Message msg;
   bool *ready;
+  _SendMessage* next;
 };
 
 enum ThreadPriority {
@@ -264,11 +268,18 @@ class Thread : public MessageQueue {
   // Returns true if there is such a message.
   bool PopSendMessageFromThread(const Thread* source, _SendMessage* msg);
 
+  // Removes |smsg|, which follows |prev| (or is the first message if |prev|
+  // is NULL), from |sendlist_head_|.  The caller must lock |crit_|.
+  void UnlinkSendMessage(_SendMessage* prev, _SendMessage* smsg);
+
   // Used for tracking performance of Invoke calls.
   void InvokeBegin();
   void InvokeEnd();
 
-  std::list<_SendMessage> sendlist_;
+  // Messages sent to this thread and not yet handled, in the order they were
+  // sent.  Must be accessed with |crit_| held.
+  _SendMessage* sendlist_head_;
+  _SendMessage* sendlist_tail_;
   std::string name_;
   ThreadPriority priority_;
   Event running_;  // Signalled means running.
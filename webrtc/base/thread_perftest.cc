@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+
+#include "webrtc/base/event.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace rtc {
+namespace {
+
+const int kNumInvokes = 20000;
+const int kNumPosts = 200000;
+const int kNumDelayedPosts = 100000;
+
+int ReturnOne() {
+  return 1;
+}
+
+// Counts the messages it receives and signals |done| after the last one.
+class CountingHandler : public MessageHandler {
+ public:
+  explicit CountingHandler(int num_messages)
+      : num_messages_(num_messages), count_(0), done_(false, false) {}
+
+  void OnMessage(Message* msg) override {
+    if (++count_ == num_messages_)
+      done_.Set();
+  }
+
+  bool Wait(int ms) { return done_.Wait(ms); }
+
+ private:
+  const int num_messages_;
+  int count_;
+  Event done_;
+};
+
+void PrintRate(const std::string& measurement, const std::string& trace,
+               int count, uint64 elapsed_us, const std::string& units) {
+  webrtc::test::PrintResult(measurement, "", trace,
+                            1e6 * count / std::max<uint64>(elapsed_us, 1),
+                            units, true);
+}
+
+double InvokeLatencyUs(Thread* thread) {
+  int sum = 0;
+  uint64 start_us = TimeMicros();
+  for (int i = 0; i < kNumInvokes; ++i)
+    sum += thread->Invoke<int>(&ReturnOne);
+  uint64 elapsed_us = TimeMicros() - start_us;
+  EXPECT_EQ(kNumInvokes, sum);
+  return static_cast<double>(elapsed_us) / kNumInvokes;
+}
+
+}  // namespace
+
+TEST(ThreadPerfTest, CrossThreadInvoke) {
+  Thread worker;
+  worker.Start();
+
+  double latency_us = InvokeLatencyUs(&worker);
+  webrtc::test::PrintResult("invoke_latency", "", "rtc_thread",
+                            1000 * latency_us, "ns", true);
+
+  // Invokes from a thread that rtc doesn't know about, like an application
+  // thread calling into the API.
+  ThreadManager* manager = ThreadManager::Instance();
+  Thread* current = manager->CurrentThread();
+  manager->SetCurrentThread(NULL);
+  latency_us = InvokeLatencyUs(&worker);
+  manager->SetCurrentThread(current);
+  webrtc::test::PrintResult("invoke_latency", "", "foreign_thread",
+                            1000 * latency_us, "ns", true);
+}
+
+TEST(ThreadPerfTest, CrossThreadPost) {
+  Thread worker;
+  worker.Start();
+  CountingHandler handler(kNumPosts);
+
+  uint64 start_us = TimeMicros();
+  for (int i = 0; i < kNumPosts; ++i)
+    worker.Post(&handler);
+  EXPECT_TRUE(handler.Wait(30000));
+  PrintRate("post_rate", "cross_thread", kNumPosts, TimeMicros() - start_us,
+            "messages/s");
+}
+
+TEST(ThreadPerfTest, DelayedPosts) {
+  Thread* thread = Thread::Current();
+  CountingHandler handler(kNumDelayedPosts);
+
+  // All the messages are due, in shuffled order, so that they go through the
+  // delayed message queue without any waiting.
+  uint32 now = Time();
+  uint64 start_us = TimeMicros();
+  for (int i = 0; i < kNumDelayedPosts; ++i)
+    thread->PostAt(now - (i * 7919) % 1000, &handler);
+  Message msg;
+  while (thread->Get(&msg, 0))
+    thread->Dispatch(&msg);
+  EXPECT_TRUE(handler.Wait(0));
+  PrintRate("post_rate", "delayed", kNumDelayedPosts, TimeMicros() - start_us,
+            "messages/s");
+}
+
+}  // namespace rtc
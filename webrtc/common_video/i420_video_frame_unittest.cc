@@ -13,6 +13,8 @@
 #include <math.h>
 #include <string.h>
 
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 #include "webrtc/base/bind.h"
 #include "webrtc/base/scoped_ptr.h"
@@ -187,6 +189,44 @@ TEST(TestVideoFrame, Reset) {
   EXPECT_TRUE(frame.video_frame_buffer() == NULL);
 }
 
+TEST(TestVideoFrame, UpdatedRects) {
+  VideoFrame frame1;
+  ASSERT_EQ(0, frame1.CreateEmptyFrame(32, 32, 32, 16, 16));
+  EXPECT_FALSE(frame1.has_updated_rects());
+
+  std::vector<VideoFrame::UpdatedRect> rects;
+  VideoFrame::UpdatedRect rect = {4, 8, 16, 2};
+  rects.push_back(rect);
+  frame1.set_updated_rects(7, rects);
+
+  VideoFrame frame2;
+  frame2.ShallowCopy(frame1);
+  VideoFrame frame3;
+  ASSERT_EQ(0, frame3.CopyFrame(frame1));
+  for (const VideoFrame* frame : {&frame1, &frame2, &frame3}) {
+    EXPECT_TRUE(frame->has_updated_rects());
+    EXPECT_EQ(7u, frame->updated_rects_sequence_number());
+    ASSERT_EQ(1u, frame->updated_rects().size());
+    EXPECT_EQ(4, frame->updated_rects()[0].x);
+    EXPECT_EQ(8, frame->updated_rects()[0].y);
+    EXPECT_EQ(16, frame->updated_rects()[0].width);
+    EXPECT_EQ(2, frame->updated_rects()[0].height);
+  }
+
+  // An empty list is a valid "nothing changed" description.
+  frame2.set_updated_rects(8, std::vector<VideoFrame::UpdatedRect>());
+  EXPECT_TRUE(frame2.has_updated_rects());
+  EXPECT_TRUE(frame2.updated_rects().empty());
+
+  // Rewriting the frame content invalidates the description.
+  ASSERT_EQ(0, frame3.CreateEmptyFrame(32, 32, 32, 16, 16));
+  EXPECT_FALSE(frame3.has_updated_rects());
+
+  frame1.Reset();
+  EXPECT_FALSE(frame1.has_updated_rects());
+  EXPECT_TRUE(frame1.updated_rects().empty());
+}
+
 TEST(TestVideoFrame, CopyBuffer) {
   VideoFrame frame1, frame2;
   int width = 15;
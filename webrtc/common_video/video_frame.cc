@@ -53,6 +53,7 @@ int VideoFrame::CreateEmptyFrame(int width,
   ntp_time_ms_ = 0;
   render_time_ms_ = 0;
   rotation_ = kVideoRotation_0;
+  clear_updated_rects();
 
   // Check if it's safe to reuse allocation.
   if (video_frame_buffer_ && video_frame_buffer_->HasOneRef() &&
@@ -132,6 +133,7 @@ int VideoFrame::CopyFrame(const VideoFrame& videoFrame) {
   ntp_time_ms_ = videoFrame.ntp_time_ms_;
   render_time_ms_ = videoFrame.render_time_ms_;
   rotation_ = videoFrame.rotation_;
+  updated_rects_ = videoFrame.updated_rects_;
   return 0;
 }
 
@@ -141,6 +143,7 @@ void VideoFrame::ShallowCopy(const VideoFrame& videoFrame) {
   ntp_time_ms_ = videoFrame.ntp_time_ms_;
   render_time_ms_ = videoFrame.render_time_ms_;
   rotation_ = videoFrame.rotation_;
+  updated_rects_ = videoFrame.updated_rects_;
 }
 
 void VideoFrame::Reset() {
@@ -149,6 +152,7 @@ void VideoFrame::Reset() {
   ntp_time_ms_ = 0;
   render_time_ms_ = 0;
   rotation_ = kVideoRotation_0;
+  clear_updated_rects();
 }
 
 uint8_t* VideoFrame::buffer(PlaneType type) {
@@ -178,6 +182,17 @@ int VideoFrame::height() const {
   return video_frame_buffer_ ? video_frame_buffer_->height() : 0;
 }
 
+void VideoFrame::set_updated_rects(uint32_t sequence_number,
+                                   const std::vector<UpdatedRect>& rects) {
+  updated_rects_ =
+      new rtc::RefCountedObject<UpdatedRects>(sequence_number, rects);
+}
+
+const std::vector<VideoFrame::UpdatedRect>& VideoFrame::updated_rects() const {
+  static const std::vector<UpdatedRect> kNoRects;
+  return updated_rects_ ? updated_rects_->rects : kNoRects;
+}
+
 bool VideoFrame::IsZeroSize() const {
   return !video_frame_buffer_;
 }
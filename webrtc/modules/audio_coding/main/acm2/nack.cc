@@ -38,6 +38,8 @@ Nack::Nack(int nack_threshold_packets)
       any_rtp_decoded_(false),
       sample_rate_khz_(kDefaultSampleRateKhz),
       samples_per_packet_(sample_rate_khz_ * kDefaultPacketSizeMs),
+      nack_list_(kNackListSizeLimit + 1),
+      nack_elements_(nack_list_.capacity(), NackElement(0, 0, false)),
       max_nack_list_size_(kNackListSizeLimit) {}
 
 Nack::~Nack() = default;
@@ -72,7 +74,7 @@ void Nack::UpdateLastReceivedPacket(uint16_t sequence_number,
     return;
 
   // Received RTP should not be in the list.
-  nack_list_.erase(sequence_number);
+  nack_list_.Remove(sequence_number);
 
   // If this is an old sequence number, no more action is required, return.
   if (IsNewerSequenceNumber(sequence_num_last_received_rtp_, sequence_number))
@@ -108,12 +110,13 @@ void Nack::UpdateList(uint16_t sequence_number_current_received_rtp) {
 
 void Nack::ChangeFromLateToMissing(
     uint16_t sequence_number_current_received_rtp) {
-  NackList::const_iterator lower_bound = nack_list_.lower_bound(
-      static_cast<uint16_t>(sequence_number_current_received_rtp -
-                            nack_threshold_packets_));
+  const uint16_t lower_bound = static_cast<uint16_t>(
+      sequence_number_current_received_rtp - nack_threshold_packets_);
 
-  for (NackList::iterator it = nack_list_.begin(); it != lower_bound; ++it)
-    it->second.is_missing = true;
+  nack_list_.ForEach([this, lower_bound](uint16_t sequence_number) {
+    if (IsNewerSequenceNumber(lower_bound, sequence_number))
+      Element(sequence_number).is_missing = true;
+  });
 }
 
 uint32_t Nack::EstimateTimestamp(uint16_t sequence_num) {
@@ -130,22 +133,24 @@ void Nack::AddToList(uint16_t sequence_number_current_received_rtp) {
   uint16_t upper_bound_missing = sequence_number_current_received_rtp -
       nack_threshold_packets_;
 
-  for (uint16_t n = sequence_num_last_received_rtp_ + 1;
+  const uint16_t first = sequence_num_last_received_rtp_ + 1;
+  for (uint16_t n = first;
       IsNewerSequenceNumber(sequence_number_current_received_rtp, n); ++n) {
     bool is_missing = IsNewerSequenceNumber(upper_bound_missing, n);
     uint32_t timestamp = EstimateTimestamp(n);
-    NackElement nack_element(TimeToPlay(timestamp), timestamp, is_missing);
-    nack_list_.insert(nack_list_.end(), std::make_pair(n, nack_element));
+    Element(n) = NackElement(TimeToPlay(timestamp), timestamp, is_missing);
   }
+  nack_list_.AddMissing(first, sequence_number_current_received_rtp);
 }
 
 void Nack::UpdateEstimatedPlayoutTimeBy10ms() {
   while (!nack_list_.empty() &&
-      nack_list_.begin()->second.time_to_play_ms <= 10)
-    nack_list_.erase(nack_list_.begin());
+      Element(nack_list_.Oldest()).time_to_play_ms <= 10)
+    nack_list_.Remove(nack_list_.Oldest());
 
-  for (NackList::iterator it = nack_list_.begin(); it != nack_list_.end(); ++it)
-    it->second.time_to_play_ms -= 10;
+  nack_list_.ForEach([this](uint16_t sequence_number) {
+    Element(sequence_number).time_to_play_ms -= 10;
+  });
 }
 
 void Nack::UpdateLastDecodedPacket(uint16_t sequence_number,
@@ -157,13 +162,13 @@ void Nack::UpdateLastDecodedPacket(uint16_t sequence_number,
     // Packets in the list with sequence numbers less than the
     // sequence number of the decoded RTP should be removed from the lists.
     // They will be discarded by the jitter buffer if they arrive.
-    nack_list_.erase(nack_list_.begin(), nack_list_.upper_bound(
-        sequence_num_last_decoded_rtp_));
+    nack_list_.RemoveUpTo(sequence_num_last_decoded_rtp_);
 
     // Update estimated time-to-play.
-    for (NackList::iterator it = nack_list_.begin(); it != nack_list_.end();
-        ++it)
-      it->second.time_to_play_ms = TimeToPlay(it->second.estimated_timestamp);
+    nack_list_.ForEach([this](uint16_t sequence_number) {
+      NackElement& element = Element(sequence_number);
+      element.time_to_play_ms = TimeToPlay(element.estimated_timestamp);
+    });
   } else {
     assert(sequence_number == sequence_num_last_decoded_rtp_);
 
@@ -179,11 +184,16 @@ void Nack::UpdateLastDecodedPacket(uint16_t sequence_number,
 }
 
 Nack::NackList Nack::GetNackList() const {
-  return nack_list_;
+  NackList nack_list;
+  nack_list_.ForEach([this, &nack_list](uint16_t sequence_number) {
+    nack_list.insert(nack_list.end(),
+                     std::make_pair(sequence_number, Element(sequence_number)));
+  });
+  return nack_list;
 }
 
 void Nack::Reset() {
-  nack_list_.clear();
+  nack_list_.Clear();
 
   sequence_num_last_received_rtp_ = 0;
   timestamp_last_received_rtp_ = 0;
@@ -206,7 +216,7 @@ int Nack::SetMaxNackListSize(size_t max_nack_list_size) {
 void Nack::LimitNackListSize() {
   uint16_t limit = sequence_num_last_received_rtp_ -
       static_cast<uint16_t>(max_nack_list_size_) - 1;
-  nack_list_.erase(nack_list_.begin(), nack_list_.upper_bound(limit));
+  nack_list_.RemoveUpTo(limit);
 }
 
 int64_t Nack::TimeToPlay(uint32_t timestamp) const {
@@ -217,12 +227,12 @@ int64_t Nack::TimeToPlay(uint32_t timestamp) const {
 // We don't erase elements with time-to-play shorter than round-trip-time.
 std::vector<uint16_t> Nack::GetNackList(int64_t round_trip_time_ms) const {
   std::vector<uint16_t> sequence_numbers;
-  for (NackList::const_iterator it = nack_list_.begin(); it != nack_list_.end();
-      ++it) {
-    if (it->second.is_missing &&
-        it->second.time_to_play_ms > round_trip_time_ms)
-      sequence_numbers.push_back(it->first);
-  }
+  nack_list_.ForEach([this, round_trip_time_ms, &sequence_numbers](
+      uint16_t sequence_number) {
+    const NackElement& element = Element(sequence_number);
+    if (element.is_missing && element.time_to_play_ms > round_trip_time_ms)
+      sequence_numbers.push_back(sequence_number);
+  });
   return sequence_numbers;
 }
 
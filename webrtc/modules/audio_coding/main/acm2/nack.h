@@ -15,6 +15,7 @@
 #include <map>
 
 #include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/interface/nack_bitmap.h"
 #include "webrtc/modules/audio_coding/main/interface/audio_coding_module_typedefs.h"
 #include "webrtc/test/testsupport/gtest_prod_util.h"
 
@@ -139,6 +140,14 @@ class Nack {
   // computed correctly.
   NackList GetNackList() const;
 
+  // The state of |sequence_number|, which must be in |nack_list_|.
+  NackElement& Element(uint16_t sequence_number) {
+    return nack_elements_[nack_list_.Slot(sequence_number)];
+  }
+  const NackElement& Element(uint16_t sequence_number) const {
+    return nack_elements_[nack_list_.Slot(sequence_number)];
+  }
+
   // Given the |sequence_number_current_received_rtp| of currently received RTP,
   // recognize packets which are not arrive and add to the list.
   void AddToList(uint16_t sequence_number_current_received_rtp);
@@ -196,10 +205,11 @@ class Nack {
   // packet, not only for consecutive packets.
   int samples_per_packet_;
 
-  // A list of missing packets to be retransmitted. Components of the list
-  // contain the sequence number of missing packets and the estimated time that
-  // each pack is going to be played out.
-  NackList nack_list_;
+  // A list of missing packets to be retransmitted. The bitmap holds the
+  // sequence numbers in the list, and |nack_elements_| the estimated time that
+  // each of them is going to be played out, indexed by nack_list_.Slot().
+  NackBitmap nack_list_;
+  std::vector<NackElement> nack_elements_;
 
   // NACK list will not keep track of missing packets prior to
   // |sequence_num_last_received_rtp_| - |max_nack_list_size_|.
@@ -27,12 +27,22 @@ void SendTimeHistory::Clear() {
 
 void SendTimeHistory::AddAndRemoveOldSendTimes(uint16_t sequence_number,
                                                int64_t timestamp) {
+  AddAndRemoveOld(sequence_number, timestamp, 0, -1);
+}
+
+void SendTimeHistory::AddAndRemoveOld(uint16_t sequence_number,
+                                      int64_t timestamp,
+                                      size_t payload_size,
+                                      int probe_cluster_id) {
   EraseOld(timestamp - packet_age_limit_);
 
   if (history_.empty())
     oldest_sequence_number_ = sequence_number;
 
-  history_[sequence_number] = timestamp;
+  SentPacket& packet = history_[sequence_number];
+  packet.timestamp = timestamp;
+  packet.payload_size = payload_size;
+  packet.probe_cluster_id = probe_cluster_id;
 }
 
 void SendTimeHistory::EraseOld(int64_t limit) {
@@ -40,7 +50,7 @@ void SendTimeHistory::EraseOld(int64_t limit) {
     auto it = history_.find(oldest_sequence_number_);
     assert(it != history_.end());
 
-    if (it->second > limit)
+    if (it->second.timestamp > limit)
       return;  // Oldest packet within age limit, return.
 
     // TODO(sprang): Warn if erasing (too many) old items?
@@ -71,10 +81,23 @@ void SendTimeHistory::UpdateOldestSequenceNumber() {
 bool SendTimeHistory::GetSendTime(uint16_t sequence_number,
                                   int64_t* timestamp,
                                   bool remove) {
+  size_t payload_size;
+  int probe_cluster_id;
+  return GetInfo(sequence_number, timestamp, &payload_size, &probe_cluster_id,
+                 remove);
+}
+
+bool SendTimeHistory::GetInfo(uint16_t sequence_number,
+                              int64_t* timestamp,
+                              size_t* payload_size,
+                              int* probe_cluster_id,
+                              bool remove) {
   auto it = history_.find(sequence_number);
   if (it == history_.end())
     return false;
-  *timestamp = it->second;
+  *timestamp = it->second.timestamp;
+  *payload_size = it->second.payload_size;
+  *probe_cluster_id = it->second.probe_cluster_id;
   if (remove) {
     history_.erase(it);
     if (sequence_number == oldest_sequence_number_)
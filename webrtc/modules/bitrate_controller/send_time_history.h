@@ -25,15 +25,33 @@ class SendTimeHistory {
 
   void AddAndRemoveOldSendTimes(uint16_t sequence_number, int64_t timestamp);
   bool GetSendTime(uint16_t sequence_number, int64_t* timestamp, bool remove);
+  // As above, also keeping the payload size of each packet and the probe
+  // cluster it was sent in, which are needed to run a delay based estimator
+  // on transport feedback.
+  void AddAndRemoveOld(uint16_t sequence_number,
+                       int64_t timestamp,
+                       size_t payload_size,
+                       int probe_cluster_id);
+  bool GetInfo(uint16_t sequence_number,
+               int64_t* timestamp,
+               size_t* payload_size,
+               int* probe_cluster_id,
+               bool remove);
   void Clear();
 
  private:
+  struct SentPacket {
+    int64_t timestamp;
+    size_t payload_size;
+    int probe_cluster_id;
+  };
+
   void EraseOld(int64_t limit);
   void UpdateOldestSequenceNumber();
 
   const int64_t packet_age_limit_;
   uint16_t oldest_sequence_number_;  // Oldest may not be lowest.
-  std::map<uint16_t, int64_t> history_;
+  std::map<uint16_t, SentPacket> history_;
 
   DISALLOW_COPY_AND_ASSIGN(SendTimeHistory);
 };
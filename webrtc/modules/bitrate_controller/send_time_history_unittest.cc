@@ -146,4 +146,23 @@ TEST_F(SendTimeHistoryTest, InterlievedGetAndRemove) {
   EXPECT_EQ(kTimestamp + 2, time);
 }
 
+TEST_F(SendTimeHistoryTest, KeepsPayloadSize) {
+  const uint16_t kSeqNo = 10;
+  const int64_t kTimestamp = 20;
+  const size_t kPayloadSize = 1200;
+  const int kProbeClusterId = 2;
+  history_.AddAndRemoveOld(kSeqNo, kTimestamp, kPayloadSize, kProbeClusterId);
+
+  int64_t time = 0;
+  size_t payload_size = 0;
+  int probe_cluster_id = -1;
+  EXPECT_TRUE(history_.GetInfo(kSeqNo, &time, &payload_size,
+                               &probe_cluster_id, true));
+  EXPECT_EQ(kTimestamp, time);
+  EXPECT_EQ(kPayloadSize, payload_size);
+  EXPECT_EQ(kProbeClusterId, probe_cluster_id);
+  EXPECT_FALSE(history_.GetInfo(kSeqNo, &time, &payload_size,
+                                &probe_cluster_id, true));
+}
+
 }  // namespace webrtc
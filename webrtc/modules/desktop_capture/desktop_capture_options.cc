@@ -14,10 +14,13 @@ namespace webrtc {
 
 DesktopCaptureOptions::DesktopCaptureOptions()
     : use_update_notifications_(true),
-      disable_effects_(true) {
+      disable_effects_(true),
+      differ_threads_(1),
+      use_differ_block_hashes_(false) {
 #if defined(USE_X11)
   // XDamage is often broken, so don't use it by default.
   use_update_notifications_ = false;
+  use_xshm_frames_ = false;
 #endif
 
 #if defined(WEBRTC_WIN)
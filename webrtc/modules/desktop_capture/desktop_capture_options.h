@@ -42,6 +42,16 @@ class DesktopCaptureOptions {
   void set_x_display(rtc::scoped_refptr<SharedXDisplay> x_display) {
     x_display_ = x_display;
   }
+
+  // Flag indicating that the X11 screen capturer should allocate its frames in
+  // X shared memory pixmaps, letting the X server copy the updated (e.g.
+  // damaged) rectangles straight into the frame instead of blitting them from
+  // an intermediate buffer. Falls back to the regular path when shared memory
+  // pixmaps are not available.
+  bool use_xshm_frames() const { return use_xshm_frames_; }
+  void set_use_xshm_frames(bool use_xshm_frames) {
+    use_xshm_frames_ = use_xshm_frames;
+  }
 #endif
 
 #if defined(WEBRTC_MAC) && !defined(WEBRTC_IOS)
@@ -76,6 +86,21 @@ class DesktopCaptureOptions {
     disable_effects_ = disable_effects;
   }
 
+  // Number of threads the polling screen capturers use to find the changed
+  // blocks of each frame. See Differ::SetNumThreads().
+  int differ_threads() const { return differ_threads_; }
+  void set_differ_threads(int differ_threads) {
+    differ_threads_ = differ_threads;
+  }
+
+  // Flag indicating that the polling screen capturers should compare each
+  // block against a hash of the previous frame instead of its pixels. This
+  // is lossy, see Differ::EnableBlockHashCache(), so it is off by default.
+  bool use_differ_block_hashes() const { return use_differ_block_hashes_; }
+  void set_use_differ_block_hashes(bool use_differ_block_hashes) {
+    use_differ_block_hashes_ = use_differ_block_hashes;
+  }
+
 #if defined(WEBRTC_WIN)
   bool allow_use_magnification_api() const {
     return allow_use_magnification_api_;
@@ -88,6 +113,7 @@ class DesktopCaptureOptions {
  private:
 #if defined(USE_X11)
   rtc::scoped_refptr<SharedXDisplay> x_display_;
+  bool use_xshm_frames_;
 #endif
 
 #if defined(WEBRTC_MAC) && !defined(WEBRTC_IOS)
@@ -101,6 +127,8 @@ class DesktopCaptureOptions {
 #endif
   bool use_update_notifications_;
   bool disable_effects_;
+  int differ_threads_;
+  bool use_differ_block_hashes_;
 };
 
 }  // namespace webrtc
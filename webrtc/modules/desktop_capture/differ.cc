@@ -12,11 +12,100 @@
 
 #include "string.h"
 
+#include <algorithm>
+
 #include "webrtc/modules/desktop_capture/differ_block.h"
+#include "webrtc/system_wrappers/interface/event_wrapper.h"
 #include "webrtc/system_wrappers/interface/logging.h"
+#include "webrtc/system_wrappers/interface/thread_wrapper.h"
 
 namespace webrtc {
 
+namespace {
+
+// Time a worker waits for work before returning to its thread loop, so that
+// Stop() does not block for long.
+const unsigned long kWorkerWaitMs = 100;
+
+// 64-bit FNV-1a style hash over the rows of a block. Rows are consumed as
+// 64-bit words where possible, which keeps the cost well below a byte-wise
+// hash while still mixing every bit of the block.
+uint64_t HashBlock(const uint8_t* block, int stride, int width_bytes,
+                   int height) {
+  const uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int y = 0; y < height; ++y) {
+    int x = 0;
+    for (; x + 8 <= width_bytes; x += 8) {
+      uint64_t word;
+      memcpy(&word, block + x, sizeof(word));
+      hash = (hash ^ word) * kPrime;
+    }
+    for (; x < width_bytes; ++x)
+      hash = (hash ^ block[x]) * kPrime;
+    block += stride;
+  }
+  return hash;
+}
+
+}  // namespace
+
+// Diffs a stripe of block rows on a dedicated thread. Start() and Wait() are
+// called from the thread calling Differ::CalcDirtyRegion().
+class Differ::Worker {
+ public:
+  explicit Worker(Differ* differ)
+      : differ_(differ),
+        start_event_(EventWrapper::Create()),
+        done_event_(EventWrapper::Create()),
+        prev_buffer_(NULL),
+        curr_buffer_(NULL),
+        first_row_(0),
+        last_row_(0) {
+    thread_ = ThreadWrapper::CreateThread(&Worker::Run, this, "DifferWorker");
+    thread_->Start();
+  }
+
+  ~Worker() { thread_->Stop(); }
+
+  void Start(const uint8_t* prev_buffer,
+             const uint8_t* curr_buffer,
+             int first_row,
+             int last_row) {
+    prev_buffer_ = prev_buffer;
+    curr_buffer_ = curr_buffer;
+    first_row_ = first_row;
+    last_row_ = last_row;
+    start_event_->Set();
+  }
+
+  void Wait() { done_event_->Wait(WEBRTC_EVENT_INFINITE); }
+
+ private:
+  static bool Run(void* obj) { return static_cast<Worker*>(obj)->Process(); }
+
+  bool Process() {
+    if (start_event_->Wait(kWorkerWaitMs) != kEventSignaled)
+      return true;
+    differ_->MarkDirtyBlockRows(prev_buffer_, curr_buffer_, first_row_,
+                                last_row_);
+    done_event_->Set();
+    return true;
+  }
+
+  Differ* const differ_;
+  rtc::scoped_ptr<EventWrapper> start_event_;
+  rtc::scoped_ptr<EventWrapper> done_event_;
+  rtc::scoped_ptr<ThreadWrapper> thread_;
+
+  const uint8_t* prev_buffer_;
+  const uint8_t* curr_buffer_;
+  int first_row_;
+  int last_row_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
 Differ::Differ(int width, int height, int bpp, int stride) {
   // Dimensions of screen.
   width_ = width;
@@ -32,7 +121,42 @@ Differ::Differ(int width, int height, int bpp, int stride) {
   diff_info_.reset(new bool[diff_info_size_]);
 }
 
-Differ::~Differ() {}
+Differ::~Differ() {
+  SetNumThreads(1);
+}
+
+void Differ::SetNumThreads(int num_threads) {
+  // There is no point in having more stripes than block rows.
+  int max_threads = (height_ + kBlockSize - 1) / kBlockSize;
+  num_threads = std::max(1, std::min(num_threads, max_threads));
+  while (static_cast<int>(workers_.size()) > num_threads - 1) {
+    delete workers_.back();
+    workers_.pop_back();
+  }
+  while (static_cast<int>(workers_.size()) < num_threads - 1)
+    workers_.push_back(new Worker(this));
+}
+
+void Differ::EnableBlockHashCache(bool enable) {
+  if (!enable) {
+    block_hashes_.reset();
+    block_hash_valid_.reset();
+    return;
+  }
+  if (block_hashes_)
+    return;
+  int blocks = diff_info_width_ * diff_info_height_;
+  block_hashes_.reset(new uint64_t[blocks]);
+  block_hash_valid_.reset(new bool[blocks]);
+  ResetBlockHashCache();
+}
+
+void Differ::ResetBlockHashCache() {
+  if (block_hash_valid_) {
+    memset(block_hash_valid_.get(), 0,
+           diff_info_width_ * diff_info_height_ * sizeof(bool));
+  }
+}
 
 void Differ::CalcDirtyRegion(const uint8_t* prev_buffer,
                              const uint8_t* curr_buffer,
@@ -49,75 +173,109 @@ void Differ::MarkDirtyBlocks(const uint8_t* prev_buffer,
                              const uint8_t* curr_buffer) {
   memset(diff_info_.get(), 0, diff_info_size_);
 
+  // Number of block rows, including a partial one at the bottom.
+  int block_rows = (height_ + kBlockSize - 1) / kBlockSize;
+
+  if (workers_.empty()) {
+    MarkDirtyBlockRows(prev_buffer, curr_buffer, 0, block_rows);
+    return;
+  }
+
+  // Hand out stripes of (nearly) equal height to the workers and keep the
+  // last one for the calling thread.
+  int stripes = num_threads();
+  int first_row = 0;
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    int last_row = first_row + (block_rows - first_row) / (stripes - i);
+    workers_[i]->Start(prev_buffer, curr_buffer, first_row, last_row);
+    first_row = last_row;
+  }
+  MarkDirtyBlockRows(prev_buffer, curr_buffer, first_row, block_rows);
+  for (size_t i = 0; i < workers_.size(); ++i)
+    workers_[i]->Wait();
+}
+
+void Differ::MarkDirtyBlockRows(const uint8_t* prev_buffer,
+                                const uint8_t* curr_buffer,
+                                int first_row,
+                                int last_row) {
   // Calc number of full blocks.
   int x_full_blocks = width_ / kBlockSize;
-  int y_full_blocks = height_ / kBlockSize;
 
-  // Calc size of partial blocks which may be present on right and bottom edge.
+  // Calc size of partial column which may be present on the right edge.
   int partial_column_width = width_ - (x_full_blocks * kBlockSize);
-  int partial_row_height = height_ - (y_full_blocks * kBlockSize);
 
   // Offset from the start of one block-column to the next.
   int block_x_offset = bytes_per_pixel_ * kBlockSize;
   // Offset from the start of one block-row to the next.
-  int block_y_stride = (width_ * bytes_per_pixel_) * kBlockSize;
-  // Offset from the start of one diff_info row to the next.
-  int diff_info_stride = diff_info_width_ * sizeof(bool);
+  int block_y_stride = bytes_per_row_ * kBlockSize;
 
-  const uint8_t* prev_block_row_start = prev_buffer;
-  const uint8_t* curr_block_row_start = curr_buffer;
-  bool* diff_info_row_start = diff_info_.get();
+  const uint8_t* prev_block_row_start =
+      prev_buffer + first_row * block_y_stride;
+  const uint8_t* curr_block_row_start =
+      curr_buffer + first_row * block_y_stride;
 
-  for (int y = 0; y < y_full_blocks; y++) {
+  for (int y = first_row; y < last_row; y++) {
     const uint8_t* prev_block = prev_block_row_start;
     const uint8_t* curr_block = curr_block_row_start;
-    bool* diff_info = diff_info_row_start;
+    int block_index = y * diff_info_width_;
+    bool* diff_info = diff_info_.get() + block_index;
+
+    // If the screen height is not a multiple of the block size, then the last
+    // row is partial. This situation is far more common than the 'partial
+    // column' case.
+    int row_height = std::min(kBlockSize, height_ - y * kBlockSize);
 
     for (int x = 0; x < x_full_blocks; x++) {
       // Mark this block as being modified so that it gets incorporated into
       // a dirty rect.
-      *diff_info = BlockDifference(prev_block, curr_block, bytes_per_row_);
+      *diff_info = BlockChanged(prev_block, curr_block, kBlockSize, row_height,
+                                block_index);
       prev_block += block_x_offset;
       curr_block += block_x_offset;
       diff_info += sizeof(bool);
+      ++block_index;
     }
 
     // If there is a partial column at the end, handle it.
     // This condition should rarely, if ever, occur.
     if (partial_column_width != 0) {
-      *diff_info = !PartialBlocksEqual(prev_block, curr_block, bytes_per_row_,
-                                       partial_column_width, kBlockSize);
-      diff_info += sizeof(bool);
+      *diff_info = BlockChanged(prev_block, curr_block, partial_column_width,
+                                row_height, block_index);
     }
 
     // Update pointers for next row.
     prev_block_row_start += block_y_stride;
     curr_block_row_start += block_y_stride;
-    diff_info_row_start += diff_info_stride;
   }
+}
 
-  // If the screen height is not a multiple of the block size, then this
-  // handles the last partial row. This situation is far more common than the
-  // 'partial column' case.
-  if (partial_row_height != 0) {
-    const uint8_t* prev_block = prev_block_row_start;
-    const uint8_t* curr_block = curr_block_row_start;
-    bool* diff_info = diff_info_row_start;
-    for (int x = 0; x < x_full_blocks; x++) {
-      *diff_info = !PartialBlocksEqual(prev_block, curr_block,
-                                       bytes_per_row_,
-                                       kBlockSize, partial_row_height);
-      prev_block += block_x_offset;
-      curr_block += block_x_offset;
-      diff_info += sizeof(bool);
-    }
-    if (partial_column_width != 0) {
-      *diff_info = !PartialBlocksEqual(prev_block, curr_block, bytes_per_row_,
-                                       partial_column_width,
-                                       partial_row_height);
-      diff_info += sizeof(bool);
-    }
+bool Differ::BlockChanged(const uint8_t* prev_block,
+                          const uint8_t* curr_block,
+                          int width,
+                          int height,
+                          int block_index) {
+  bool full_block = width == kBlockSize && height == kBlockSize;
+  if (!block_hashes_) {
+    return full_block ? BlockDifference(prev_block, curr_block, bytes_per_row_)
+                      : !PartialBlocksEqual(prev_block, curr_block,
+                                            bytes_per_row_, width, height);
+  }
+
+  uint64_t hash = HashBlock(curr_block, bytes_per_row_,
+                            width * bytes_per_pixel_, height);
+  bool changed;
+  if (block_hash_valid_[block_index]) {
+    changed = hash != block_hashes_[block_index];
+  } else {
+    changed = full_block ? BlockDifference(prev_block, curr_block,
+                                           bytes_per_row_)
+                         : !PartialBlocksEqual(prev_block, curr_block,
+                                               bytes_per_row_, width, height);
+    block_hash_valid_[block_index] = true;
   }
+  block_hashes_[block_index] = hash;
+  return changed;
 }
 
 bool Differ::PartialBlocksEqual(const uint8_t* prev_buffer,
@@ -36,18 +36,58 @@ class Differ {
   int bytes_per_pixel() { return bytes_per_pixel_; }
   int bytes_per_row() { return bytes_per_row_; }
 
+  // Splits the block comparison into |num_threads| horizontal stripes of
+  // block rows, each diffed on its own thread. The calling thread handles one
+  // of the stripes, so 1 (the default) disables the worker threads.
+  void SetNumThreads(int num_threads);
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // When enabled, a 64-bit hash of every block of the last frame is kept and
+  // blocks are compared by hashing only the current frame, halving the memory
+  // traffic for mostly static content. This relies on CalcDirtyRegion() being
+  // called with consecutive frames, i.e. |prev_buffer| holding the contents
+  // of the previous call's |curr_buffer|; call ResetBlockHashCache() when a
+  // frame is skipped. Blocks without a cached hash (the first frame, or after
+  // ResetBlockHashCache()) are compared directly.
+  //
+  // The comparison is lossy: a block whose new contents hash to the same
+  // value as its old contents is reported unchanged, and stays stale until it
+  // changes again. Comparing the pixels of blocks with matching hashes would
+  // read the previous frame again and give up the saving, so it isn't done.
+  void EnableBlockHashCache(bool enable);
+  void ResetBlockHashCache();
+
   // Given the previous and current screen buffer, calculate the dirty region
   // that encloses all of the changed pixels in the new screen.
   void CalcDirtyRegion(const uint8_t* prev_buffer, const uint8_t* curr_buffer,
                        DesktopRegion* region);
 
  private:
+  class Worker;
+
   // Allow tests to access our private parts.
   friend class DifferTest;
 
   // Identify all of the blocks that contain changed pixels.
   void MarkDirtyBlocks(const uint8_t* prev_buffer, const uint8_t* curr_buffer);
 
+  // Identify the changed blocks in block rows [|first_row|, |last_row|). Only
+  // touches the diff info (and hash cache) entries of those rows, so disjoint
+  // ranges may be processed concurrently.
+  void MarkDirtyBlockRows(const uint8_t* prev_buffer,
+                          const uint8_t* curr_buffer,
+                          int first_row,
+                          int last_row);
+
+  // Returns whether the block at |prev_block| and |curr_block| of size
+  // |width| x |height| pixels differs, and updates the cached hash for block
+  // |block_index| if the hash cache is enabled.
+  bool BlockChanged(const uint8_t* prev_block,
+                    const uint8_t* curr_block,
+                    int width,
+                    int height,
+                    int block_index);
+
   // After the dirty blocks have been identified, this routine merges adjacent
   // blocks into a region.
   // The goal is to minimize the region that covers the dirty blocks.
@@ -81,6 +121,14 @@ class Differ {
   int diff_info_height_;
   int diff_info_size_;
 
+  // Per-block hash of the last frame and whether the entry is valid. Only
+  // allocated while the hash cache is enabled.
+  rtc::scoped_ptr<uint64_t[]> block_hashes_;
+  rtc::scoped_ptr<bool[]> block_hash_valid_;
+
+  // Threads diffing the stripes not handled by the calling thread. Owned.
+  std::vector<Worker*> workers_;
+
   DISALLOW_COPY_AND_ASSIGN(Differ);
 };
 
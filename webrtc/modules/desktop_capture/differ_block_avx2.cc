@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/desktop_capture/differ_block_avx2.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#include "webrtc/modules/desktop_capture/differ_block.h"
+
+namespace webrtc {
+
+// Unlike the SSE2 version there is no need to compute a SAD here: XOR-ing the
+// rows and OR-ing the results together gives a non-zero vector iff any byte
+// differs, which VPTEST checks without leaving the vector unit.
+
+extern bool BlockDifference_AVX2_W16(const uint8_t* image1,
+                                     const uint8_t* image2,
+                                     int stride) {
+  __m256i v0;
+  __m256i v1;
+  __m256i acc;
+  for (int y = 0; y < kBlockSize; ++y) {
+    const __m256i* i1 = reinterpret_cast<const __m256i*>(image1);
+    const __m256i* i2 = reinterpret_cast<const __m256i*>(image2);
+    v0 = _mm256_loadu_si256(i1);
+    v1 = _mm256_loadu_si256(i2);
+    acc = _mm256_xor_si256(v0, v1);
+    v0 = _mm256_loadu_si256(i1 + 1);
+    v1 = _mm256_loadu_si256(i2 + 1);
+    acc = _mm256_or_si256(acc, _mm256_xor_si256(v0, v1));
+    if (!_mm256_testz_si256(acc, acc))
+      return true;
+    image1 += stride;
+    image2 += stride;
+  }
+  return false;
+}
+
+extern bool BlockDifference_AVX2_W32(const uint8_t* image1,
+                                     const uint8_t* image2,
+                                     int stride) {
+  __m256i v0;
+  __m256i v1;
+  __m256i acc;
+  for (int y = 0; y < kBlockSize; ++y) {
+    const __m256i* i1 = reinterpret_cast<const __m256i*>(image1);
+    const __m256i* i2 = reinterpret_cast<const __m256i*>(image2);
+    v0 = _mm256_loadu_si256(i1);
+    v1 = _mm256_loadu_si256(i2);
+    acc = _mm256_xor_si256(v0, v1);
+    v0 = _mm256_loadu_si256(i1 + 1);
+    v1 = _mm256_loadu_si256(i2 + 1);
+    acc = _mm256_or_si256(acc, _mm256_xor_si256(v0, v1));
+    v0 = _mm256_loadu_si256(i1 + 2);
+    v1 = _mm256_loadu_si256(i2 + 2);
+    acc = _mm256_or_si256(acc, _mm256_xor_si256(v0, v1));
+    v0 = _mm256_loadu_si256(i1 + 3);
+    v1 = _mm256_loadu_si256(i2 + 3);
+    acc = _mm256_or_si256(acc, _mm256_xor_si256(v0, v1));
+    if (!_mm256_testz_si256(acc, acc))
+      return true;
+    image1 += stride;
+    image2 += stride;
+  }
+  return false;
+}
+
+}  // namespace webrtc
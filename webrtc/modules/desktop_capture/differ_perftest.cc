@@ -0,0 +1,100 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
+#include "webrtc/modules/desktop_capture/desktop_region.h"
+#include "webrtc/modules/desktop_capture/differ.h"
+#include "webrtc/modules/desktop_capture/differ_block.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/frame_generator.h"
+#include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kWidth = 1850;
+const int kHeight = 1110;
+// Each slide is shown for this many frames, so most frames are static and
+// every kFrameRepeatCount'th frame changes (almost) entirely.
+const int kFrameRepeatCount = 10;
+const int kNumFrames = 200;
+
+// Diffs |kNumFrames| consecutive BGRA screen frames built from the
+// screenshare slides and reports the average time per frame.
+void RunDifferBenchmark(const std::string& trace_name,
+                        int num_threads,
+                        bool hash_cache) {
+  std::vector<std::string> slides;
+  slides.push_back(test::ResourcePath("presentation_1850_1110", "yuv"));
+  slides.push_back(test::ResourcePath("photo_1850_1110", "yuv"));
+  rtc::scoped_ptr<test::FrameGenerator> frame_generator(
+      test::FrameGenerator::CreateFromYuvFile(slides, kWidth, kHeight,
+                                              kFrameRepeatCount));
+
+  const int stride = kWidth * kBytesPerPixel;
+  const size_t frame_size = CalcBufferSize(kARGB, kWidth, kHeight);
+  rtc::scoped_ptr<uint8_t[]> prev(new uint8_t[frame_size]);
+  rtc::scoped_ptr<uint8_t[]> curr(new uint8_t[frame_size]);
+  memset(prev.get(), 0, frame_size);
+
+  Differ differ(kWidth, kHeight, kBytesPerPixel, stride);
+  differ.SetNumThreads(num_threads);
+  differ.EnableBlockHashCache(hash_cache);
+
+  Clock* clock = Clock::GetRealTimeClock();
+  int64_t total_us = 0;
+  int64_t dirty_pixels = 0;
+  for (int i = 0; i < kNumFrames; ++i) {
+    ASSERT_EQ(0, ConvertFromI420(*frame_generator->NextFrame(), kARGB, 0,
+                                 curr.get()));
+    DesktopRegion region;
+    int64_t start_us = clock->TimeInMicroseconds();
+    differ.CalcDirtyRegion(prev.get(), curr.get(), &region);
+    total_us += clock->TimeInMicroseconds() - start_us;
+
+    for (DesktopRegion::Iterator it(region); !it.IsAtEnd(); it.Advance())
+      dirty_pixels += it.rect().width() * it.rect().height();
+    curr.swap(prev);
+  }
+
+  test::PrintResult("differ_time_per_frame", "", trace_name,
+                    static_cast<double>(total_us) / kNumFrames, "us", true);
+  test::PrintResult("differ_dirty_pixels_per_frame", "", trace_name,
+                    static_cast<double>(dirty_pixels) / kNumFrames, "pixels",
+                    false);
+}
+
+}  // namespace
+
+TEST(DifferPerfTest, SingleThread) {
+  RunDifferBenchmark("single_thread", 1, false);
+}
+
+TEST(DifferPerfTest, FourThreads) {
+  RunDifferBenchmark("four_threads", 4, false);
+}
+
+TEST(DifferPerfTest, SingleThreadHashCache) {
+  RunDifferBenchmark("single_thread_hash_cache", 1, true);
+}
+
+TEST(DifferPerfTest, FourThreadsHashCache) {
+  RunDifferBenchmark("four_threads_hash_cache", 4, true);
+}
+
+}  // namespace webrtc
@@ -269,6 +269,65 @@ TEST_F(DifferTest, MarkDirtyBlocks_Sampling) {
   EXPECT_FALSE(GetDiffInfo(2, 2));
 }
 
+TEST_F(DifferTest, MarkDirtyBlocks_MultiThreaded) {
+  InitDiffer(kPartialScreenWidth, kPartialScreenHeight);
+  differ_->SetNumThreads(3);
+  EXPECT_EQ(3, differ_->num_threads());
+  ClearDiffInfo();
+
+  // Touch one block in every row so that each stripe has work to do, including
+  // the partial block in the bottom-right corner.
+  WriteBlockPixel(curr_.get(), 0, 0, 10, 10, 0xff00ff);
+  WriteBlockPixel(curr_.get(), 1, 1, 10, 10, 0xff00ff);
+  WriteBlockPixel(curr_.get(), 2, 2, 1, 1, 0xff00ff);
+
+  MarkDirtyBlocks(prev_.get(), curr_.get());
+
+  for (int y = 0; y < GetDiffInfoHeight() - 1; y++) {
+    for (int x = 0; x < GetDiffInfoWidth() - 1; x++) {
+      EXPECT_EQ(x == y, GetDiffInfo(x, y))
+          << "when x = " << x << ", and y = " << y;
+    }
+  }
+
+  // Requests for more stripes than block rows are clamped.
+  differ_->SetNumThreads(100);
+  EXPECT_EQ(GetDiffInfoHeight() - 1, differ_->num_threads());
+  differ_->SetNumThreads(0);
+  EXPECT_EQ(1, differ_->num_threads());
+}
+
+TEST_F(DifferTest, MarkDirtyBlocks_HashCache) {
+  InitDiffer(kPartialScreenWidth, kPartialScreenHeight);
+  differ_->EnableBlockHashCache(true);
+
+  // The first frame has no cached hashes and is compared directly.
+  WriteBlockPixel(curr_.get(), 1, 0, 10, 10, 0xff00ff);
+  MarkDirtyBlocks(prev_.get(), curr_.get());
+  EXPECT_TRUE(GetDiffInfo(1, 0));
+  EXPECT_FALSE(GetDiffInfo(0, 0));
+  EXPECT_FALSE(GetDiffInfo(2, 2));
+
+  // Feed the frames in sequence: the unchanged frame yields no dirty blocks.
+  memcpy(prev_.get(), curr_.get(), buffer_size_);
+  MarkDirtyBlocks(prev_.get(), curr_.get());
+  for (int y = 0; y < GetDiffInfoHeight() - 1; y++) {
+    for (int x = 0; x < GetDiffInfoWidth() - 1; x++) {
+      EXPECT_FALSE(GetDiffInfo(x, y))
+          << "when x = " << x << ", and y = " << y;
+    }
+  }
+
+  // Changes are detected from the hashes, including in partial blocks.
+  WriteBlockPixel(curr_.get(), 0, 1, 0, 0, 0x00ff00);
+  WriteBlockPixel(curr_.get(), 2, 2, 5, 5, 0x00ff00);
+  MarkDirtyBlocks(prev_.get(), curr_.get());
+  EXPECT_TRUE(GetDiffInfo(0, 1));
+  EXPECT_TRUE(GetDiffInfo(2, 2));
+  EXPECT_FALSE(GetDiffInfo(1, 0));
+  EXPECT_FALSE(GetDiffInfo(1, 1));
+}
+
 TEST_F(DifferTest, DiffBlock) {
   InitDiffer(kScreenWidth, kScreenHeight);
 
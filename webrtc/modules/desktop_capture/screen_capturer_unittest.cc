@@ -102,6 +102,39 @@ TEST_F(ScreenCapturerTest, Capture) {
   delete frame;
 }
 
+#if defined(USE_X11)
+
+TEST_F(ScreenCapturerTest, UseXShmFrames) {
+  DesktopCaptureOptions options(DesktopCaptureOptions::CreateDefault());
+  options.set_use_update_notifications(true);
+  options.set_use_xshm_frames(true);
+  capturer_.reset(ScreenCapturer::Create(options));
+
+  DesktopFrame* frame = NULL;
+  EXPECT_CALL(callback_, OnCaptureCompleted(_))
+      .Times(2)
+      .WillRepeatedly(SaveArg<0>(&frame));
+
+  capturer_->Start(&callback_);
+  capturer_->Capture(DesktopRegion());
+  ASSERT_TRUE(frame);
+  EXPECT_TRUE(frame->updated_region().Equals(
+      DesktopRegion(DesktopRect::MakeSize(frame->size()))));
+  delete frame;
+
+  // Subsequent frames only carry the damaged area, which must lie within the
+  // screen.
+  frame = NULL;
+  capturer_->Capture(DesktopRegion());
+  ASSERT_TRUE(frame);
+  DesktopRegion outside(frame->updated_region());
+  outside.Subtract(DesktopRect::MakeSize(frame->size()));
+  EXPECT_TRUE(outside.is_empty());
+  delete frame;
+}
+
+#endif  // defined(USE_X11)
+
 #if defined(WEBRTC_WIN)
 
 TEST_F(ScreenCapturerTest, UseSharedBuffers) {
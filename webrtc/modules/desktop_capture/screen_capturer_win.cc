@@ -22,7 +22,7 @@ ScreenCapturer* ScreenCapturer::Create(const DesktopCaptureOptions& options) {
       new ScreenCapturerWinGdi(options));
 
   if (options.allow_use_magnification_api())
-    return new ScreenCapturerWinMagnifier(gdi_capturer.Pass());
+    return new ScreenCapturerWinMagnifier(gdi_capturer.Pass(), options);
 
   return gdi_capturer.release();
 }
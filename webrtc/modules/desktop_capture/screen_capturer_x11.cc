@@ -25,6 +25,7 @@
 #include "webrtc/modules/desktop_capture/screen_capture_frame_queue.h"
 #include "webrtc/modules/desktop_capture/screen_capturer_helper.h"
 #include "webrtc/modules/desktop_capture/x11/x_server_pixel_buffer.h"
+#include "webrtc/modules/desktop_capture/x11/x_shm_desktop_frame.h"
 #include "webrtc/system_wrappers/interface/logging.h"
 #include "webrtc/system_wrappers/interface/tick_util.h"
 
@@ -72,6 +73,10 @@ class ScreenCapturerLinux : public ScreenCapturer,
   // differences between this and the previous capture.
   DesktopFrame* CaptureScreen();
 
+  // Returns the current frame of the queue when frames are allocated in X
+  // shared memory.
+  XShmDesktopFrame* current_xshm_frame();
+
   // Called when the screen configuration is changed.
   void ScreenConfigurationChanged();
 
@@ -107,6 +112,10 @@ class ScreenCapturerLinux : public ScreenCapturer,
   // Access to the X Server's pixel buffer.
   XServerPixelBuffer x_server_pixel_buffer_;
 
+  // True when the frames in |queue_| are XShmDesktopFrames, which the X server
+  // writes into directly, bypassing |x_server_pixel_buffer_|.
+  bool use_xshm_frames_;
+
   // A thread-safe list of invalid rectangles, and the size of the most
   // recently captured screen.
   ScreenCapturerHelper helper_;
@@ -135,7 +144,8 @@ ScreenCapturerLinux::ScreenCapturerLinux()
       damage_handle_(0),
       damage_event_base_(-1),
       damage_error_base_(-1),
-      damage_region_(0) {
+      damage_region_(0),
+      use_xshm_frames_(false) {
   helper_.SetLogGridSize(4);
 }
 
@@ -188,6 +198,8 @@ bool ScreenCapturerLinux::Init(const DesktopCaptureOptions& options) {
     InitXDamage();
   }
 
+  use_xshm_frames_ = options_.use_xshm_frames();
+
   return true;
 }
 
@@ -260,8 +272,20 @@ void ScreenCapturerLinux::Capture(const DesktopRegion& region) {
   // Note that we can't reallocate other buffers at this point, since the caller
   // may still be reading from them.
   if (!queue_.current_frame()) {
-    rtc::scoped_ptr<DesktopFrame> frame(
-        new BasicDesktopFrame(x_server_pixel_buffer_.window_size()));
+    rtc::scoped_ptr<DesktopFrame> frame;
+    if (use_xshm_frames_) {
+      frame.reset(XShmDesktopFrame::Create(display(), root_window_));
+      if (!frame ||
+          !frame->size().equals(x_server_pixel_buffer_.window_size())) {
+        // Don't mix XShm and heap frames in the queue.
+        LOG(LS_INFO) << "X shared memory frames are not available.";
+        use_xshm_frames_ = false;
+        queue_.Reset();
+        frame.reset();
+      }
+    }
+    if (!frame)
+      frame.reset(new BasicDesktopFrame(x_server_pixel_buffer_.window_size()));
     queue_.ReplaceCurrentFrame(frame.release());
   }
 
@@ -275,6 +299,8 @@ void ScreenCapturerLinux::Capture(const DesktopRegion& region) {
     differ_.reset(new Differ(frame->size().width(), frame->size().height(),
                              DesktopFrame::kBytesPerPixel,
                              frame->stride()));
+    differ_->SetNumThreads(options_.differ_threads());
+    differ_->EnableBlockHashCache(options_.use_differ_block_hashes());
   }
 
   DesktopFrame* result = CaptureScreen();
@@ -325,12 +351,13 @@ DesktopFrame* ScreenCapturerLinux::CaptureScreen() {
   // if any.  If there isn't a previous frame, that means a screen-resolution
   // change occurred, and |invalid_rects| will be updated to include the whole
   // screen.
-  if (use_damage_ && queue_.previous_frame())
+  if (use_damage_ && queue_.previous_frame() && !use_xshm_frames_)
     SynchronizeFrame();
 
   DesktopRegion* updated_region = frame->mutable_updated_region();
 
-  x_server_pixel_buffer_.Synchronize();
+  if (!use_xshm_frames_)
+    x_server_pixel_buffer_.Synchronize();
   if (use_damage_ && queue_.previous_frame()) {
     // Atomically fetch and clear the damage region.
     XDamageSubtract(display(), damage_handle_, None, damage_region_);
@@ -354,15 +381,29 @@ DesktopFrame* ScreenCapturerLinux::CaptureScreen() {
     updated_region->IntersectWith(
         DesktopRect::MakeSize(x_server_pixel_buffer_.window_size()));
 
-    for (DesktopRegion::Iterator it(*updated_region);
-         !it.IsAtEnd(); it.Advance()) {
-      x_server_pixel_buffer_.CaptureRect(it.rect(), frame);
+    if (use_xshm_frames_) {
+      // Instead of SynchronizeFrame() copying the previous frame's updated
+      // region over from the previous buffer, let the X server refresh it
+      // together with the newly damaged rectangles.
+      DesktopRegion copy_region(*updated_region);
+      copy_region.AddRegion(last_invalid_region_);
+      copy_region.IntersectWith(DesktopRect::MakeSize(frame->size()));
+      current_xshm_frame()->CopyFromWindow(copy_region);
+    } else {
+      for (DesktopRegion::Iterator it(*updated_region);
+           !it.IsAtEnd(); it.Advance()) {
+        x_server_pixel_buffer_.CaptureRect(it.rect(), frame);
+      }
     }
   } else {
     // Doing full-screen polling, or this is the first capture after a
     // screen-resolution change.  In either case, need a full-screen capture.
     DesktopRect screen_rect = DesktopRect::MakeSize(frame->size());
-    x_server_pixel_buffer_.CaptureRect(screen_rect, frame);
+    if (use_xshm_frames_) {
+      current_xshm_frame()->CopyFromWindow(DesktopRegion(screen_rect));
+    } else {
+      x_server_pixel_buffer_.CaptureRect(screen_rect, frame);
+    }
 
     if (queue_.previous_frame()) {
       // Full-screen polling, so calculate the invalid rects here, based on the
@@ -377,12 +418,21 @@ DesktopFrame* ScreenCapturerLinux::CaptureScreen() {
       // full-screen notification after a screen-resolution change, so
       // this is done here.
       updated_region->SetRect(screen_rect);
+      // The differ didn't see this frame.
+      if (differ_.get())
+        differ_->ResetBlockHashCache();
     }
   }
 
   return frame;
 }
 
+XShmDesktopFrame* ScreenCapturerLinux::current_xshm_frame() {
+  DCHECK(use_xshm_frames_);
+  return static_cast<XShmDesktopFrame*>(
+      queue_.current_frame()->GetUnderlyingFrame());
+}
+
 void ScreenCapturerLinux::ScreenConfigurationChanged() {
   // Make sure the frame buffers will be reallocated.
   queue_.Reset();
@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Measures the X11 screen capturer while a small rectangle is animated on the
+// root window. Meant to be run against a virtual display, e.g.
+//   xvfb-run -s "-screen 0 1920x1080x24" out/Release/webrtc_perf_tests
+//       --gtest_filter=ScreenCapturerX11PerfTest.*
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/desktop_capture/desktop_capture_options.h"
+#include "webrtc/modules/desktop_capture/desktop_frame.h"
+#include "webrtc/modules/desktop_capture/desktop_region.h"
+#include "webrtc/modules/desktop_capture/screen_capturer.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+// Xlib defines macros (e.g. None, Bool) that clash with gtest, so it has to be
+// included last.
+#include <X11/Xlib.h>
+
+namespace webrtc {
+namespace {
+
+const int kNumFrames = 300;
+const int kRectSize = 64;
+
+class FrameSink : public DesktopCapturer::Callback {
+ public:
+  FrameSink() {}
+
+  SharedMemory* CreateSharedMemory(size_t size) override { return NULL; }
+  void OnCaptureCompleted(DesktopFrame* frame) override { frame_.reset(frame); }
+
+  DesktopFrame* frame() { return frame_.get(); }
+  void Reset() { frame_.reset(); }
+
+ private:
+  rtc::scoped_ptr<DesktopFrame> frame_;
+
+  DISALLOW_COPY_AND_ASSIGN(FrameSink);
+};
+
+void RunCapturerBenchmark(const std::string& trace_name,
+                          bool use_damage,
+                          bool use_xshm_frames) {
+  DesktopCaptureOptions options = DesktopCaptureOptions::CreateDefault();
+  if (!options.x_display()) {
+    LOG(LS_WARNING) << "No X display, skipping " << trace_name << ".";
+    return;
+  }
+  options.set_use_update_notifications(use_damage);
+  options.set_use_xshm_frames(use_xshm_frames);
+  rtc::scoped_ptr<ScreenCapturer> capturer(ScreenCapturer::Create(options));
+  ASSERT_TRUE(capturer.get() != NULL);
+
+  FrameSink sink;
+  capturer->Start(&sink);
+
+  Display* display = options.x_display()->display();
+  Window root = DefaultRootWindow(display);
+  GC gc = XCreateGC(display, root, 0, NULL);
+
+  // The first frame is always a full-screen capture.
+  capturer->Capture(DesktopRegion());
+  ASSERT_TRUE(sink.frame() != NULL);
+  const DesktopSize size = sink.frame()->size();
+  sink.Reset();
+
+  Clock* clock = Clock::GetRealTimeClock();
+  int64_t total_us = 0;
+  int64_t updated_bytes = 0;
+  for (int i = 0; i < kNumFrames; ++i) {
+    // Move a rectangle diagonally across the screen, leaving a trail.
+    int x = (i * 7) % (size.width() - kRectSize);
+    int y = (i * 5) % (size.height() - kRectSize);
+    XSetForeground(display, gc, 0x10101 * (i & 0xff));
+    XFillRectangle(display, root, gc, x, y, kRectSize, kRectSize);
+    XSync(display, False);
+
+    int64_t start_us = clock->TimeInMicroseconds();
+    capturer->Capture(DesktopRegion());
+    total_us += clock->TimeInMicroseconds() - start_us;
+
+    ASSERT_TRUE(sink.frame() != NULL);
+    for (DesktopRegion::Iterator it(sink.frame()->updated_region());
+         !it.IsAtEnd(); it.Advance()) {
+      updated_bytes += it.rect().width() * it.rect().height() *
+                       DesktopFrame::kBytesPerPixel;
+    }
+    sink.Reset();
+  }
+  XFreeGC(display, gc);
+
+  test::PrintResult("x11_capture_latency", "", trace_name,
+                    static_cast<double>(total_us) / kNumFrames, "us", true);
+  test::PrintResult("x11_capture_updated_bytes", "", trace_name,
+                    static_cast<double>(updated_bytes) / kNumFrames, "bytes",
+                    false);
+}
+
+}  // namespace
+
+TEST(ScreenCapturerX11PerfTest, Polling) {
+  RunCapturerBenchmark("polling", false, false);
+}
+
+TEST(ScreenCapturerX11PerfTest, PollingXShmFrames) {
+  RunCapturerBenchmark("polling_xshm_frames", false, true);
+}
+
+TEST(ScreenCapturerX11PerfTest, Damage) {
+  RunCapturerBenchmark("damage", true, false);
+}
+
+TEST(ScreenCapturerX11PerfTest, DamageXShmFrames) {
+  RunCapturerBenchmark("damage_xshm_frames", true, true);
+}
+
+}  // namespace webrtc
@@ -41,6 +41,8 @@ ScreenCapturerWinGdi::ScreenCapturerWinGdi(const DesktopCaptureOptions& options)
       current_screen_id_(kFullDesktopScreenId),
       desktop_dc_(NULL),
       memory_dc_(NULL),
+      differ_threads_(options.differ_threads()),
+      use_differ_block_hashes_(options.use_differ_block_hashes()),
       dwmapi_library_(NULL),
       composition_func_(NULL),
       set_thread_execution_state_failed_(false) {
@@ -105,6 +107,8 @@ void ScreenCapturerWinGdi::Capture(const DesktopRegion& region) {
                                current_frame->size().height(),
                                DesktopFrame::kBytesPerPixel,
                                current_frame->stride()));
+      differ_->SetNumThreads(differ_threads_);
+      differ_->EnableBlockHashCache(use_differ_block_hashes_);
     }
 
     // Calculate difference between the two last captured frames.
@@ -116,6 +120,9 @@ void ScreenCapturerWinGdi::Capture(const DesktopRegion& region) {
     // No previous frame is available, or the screen is resized. Invalidate the
     // whole screen.
     helper_.InvalidateScreen(current_frame->size());
+    // The differ didn't see this frame.
+    if (differ_.get())
+      differ_->ResetBlockHashCache();
   }
 
   helper_.set_size_most_recent(current_frame->size());
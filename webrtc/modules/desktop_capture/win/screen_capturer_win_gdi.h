@@ -74,6 +74,9 @@ class ScreenCapturerWinGdi : public ScreenCapturer {
 
   // Class to calculate the difference between two screen bitmaps.
   rtc::scoped_ptr<Differ> differ_;
+  // Differ settings from DesktopCaptureOptions.
+  const int differ_threads_;
+  const bool use_differ_block_hashes_;
 
   HMODULE dwmapi_library_;
   DwmEnableCompositionFunc composition_func_;
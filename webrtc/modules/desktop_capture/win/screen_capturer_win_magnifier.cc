@@ -36,12 +36,15 @@ static LPCTSTR kMagnifierWindowName = L"MagnifierWindow";
 Atomic32 ScreenCapturerWinMagnifier::tls_index_(TLS_OUT_OF_INDEXES);
 
 ScreenCapturerWinMagnifier::ScreenCapturerWinMagnifier(
-    rtc::scoped_ptr<ScreenCapturer> fallback_capturer)
+    rtc::scoped_ptr<ScreenCapturer> fallback_capturer,
+    const DesktopCaptureOptions& options)
     : fallback_capturer_(fallback_capturer.Pass()),
       fallback_capturer_started_(false),
       callback_(NULL),
       current_screen_id_(kFullDesktopScreenId),
       excluded_window_(NULL),
+      differ_threads_(options.differ_threads()),
+      use_differ_block_hashes_(options.use_differ_block_hashes()),
       set_thread_execution_state_failed_(false),
       desktop_dc_(NULL),
       mag_lib_handle_(NULL),
@@ -140,6 +143,8 @@ void ScreenCapturerWinMagnifier::Capture(const DesktopRegion& region) {
                                current_frame->size().height(),
                                DesktopFrame::kBytesPerPixel,
                                current_frame->stride()));
+      differ_->SetNumThreads(differ_threads_);
+      differ_->EnableBlockHashCache(use_differ_block_hashes_);
     }
 
     // Calculate difference between the two last captured frames.
@@ -151,6 +156,9 @@ void ScreenCapturerWinMagnifier::Capture(const DesktopRegion& region) {
     // No previous frame is available, or the screen is resized. Invalidate the
     // whole screen.
     helper_.InvalidateScreen(current_frame->size());
+    // The differ didn't see this frame.
+    if (differ_.get())
+      differ_->ResetBlockHashCache();
   }
 
   helper_.set_size_most_recent(current_frame->size());
@@ -38,8 +38,9 @@ class ScreenCapturerWinMagnifier : public ScreenCapturer {
   // |fallback_capturer| will be used to capture the screen if a non-primary
   // screen is being captured, or the OS does not support Magnification API, or
   // the magnifier capturer fails (e.g. in Windows8 Metro mode).
-  explicit ScreenCapturerWinMagnifier(
-      rtc::scoped_ptr<ScreenCapturer> fallback_capturer);
+  ScreenCapturerWinMagnifier(
+      rtc::scoped_ptr<ScreenCapturer> fallback_capturer,
+      const DesktopCaptureOptions& options);
   virtual ~ScreenCapturerWinMagnifier();
 
   // Overridden from ScreenCapturer:
@@ -117,6 +118,9 @@ class ScreenCapturerWinMagnifier : public ScreenCapturer {
 
   // Class to calculate the difference between two screen bitmaps.
   rtc::scoped_ptr<Differ> differ_;
+  // Differ settings from DesktopCaptureOptions.
+  const int differ_threads_;
+  const bool use_differ_block_hashes_;
 
   // Used to suppress duplicate logging of SetThreadExecutionState errors.
   bool set_thread_execution_state_failed_;
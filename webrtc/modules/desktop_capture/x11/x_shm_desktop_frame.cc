@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/desktop_capture/x11/x_shm_desktop_frame.h"
+
+#include <sys/shm.h>
+
+#include "webrtc/modules/desktop_capture/desktop_region.h"
+#include "webrtc/modules/desktop_capture/x11/x_error_trap.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+
+namespace webrtc {
+
+namespace {
+
+// Returns true if |image| can be used as a DesktopFrame buffer as is.
+bool IsXImageDesktopFrameFormat(XImage* image) {
+  return image->bits_per_pixel == 32 &&
+      image->red_mask == 0xff0000 &&
+      image->green_mask == 0xff00 &&
+      image->blue_mask == 0xff;
+}
+
+void DestroyShmImage(Display* display,
+                     XImage* x_image,
+                     XShmSegmentInfo* shm_segment_info,
+                     bool attached) {
+  if (attached)
+    XShmDetach(display, shm_segment_info);
+  if (shm_segment_info->shmaddr != reinterpret_cast<char*>(-1))
+    shmdt(shm_segment_info->shmaddr);
+  if (shm_segment_info->shmid != -1)
+    shmctl(shm_segment_info->shmid, IPC_RMID, 0);
+  XDestroyImage(x_image);
+  delete shm_segment_info;
+}
+
+}  // namespace
+
+XShmDesktopFrame::XShmDesktopFrame(Display* display,
+                                   Window window,
+                                   XImage* x_image,
+                                   XShmSegmentInfo* shm_segment_info,
+                                   Pixmap pixmap,
+                                   GC gc)
+    : DesktopFrame(DesktopSize(x_image->width, x_image->height),
+                   x_image->bytes_per_line,
+                   reinterpret_cast<uint8_t*>(x_image->data),
+                   NULL),
+      display_(display),
+      window_(window),
+      x_image_(x_image),
+      shm_segment_info_(shm_segment_info),
+      pixmap_(pixmap),
+      gc_(gc) {
+}
+
+XShmDesktopFrame::~XShmDesktopFrame() {
+  XFreeGC(display_, gc_);
+  XFreePixmap(display_, pixmap_);
+  DestroyShmImage(display_, x_image_, shm_segment_info_, true);
+}
+
+// static
+XShmDesktopFrame* XShmDesktopFrame::Create(Display* display, Window window) {
+  int major, minor;
+  Bool have_pixmaps;
+  if (!XShmQueryVersion(display, &major, &minor, &have_pixmaps) ||
+      !have_pixmaps || XShmPixmapFormat(display) != ZPixmap) {
+    return NULL;
+  }
+
+  XWindowAttributes attributes;
+  {
+    XErrorTrap error_trap(display);
+    if (!XGetWindowAttributes(display, window, &attributes) ||
+        error_trap.GetLastErrorAndDisable() != 0) {
+      return NULL;
+    }
+  }
+
+  XShmSegmentInfo* shm_segment_info = new XShmSegmentInfo;
+  shm_segment_info->shmid = -1;
+  shm_segment_info->shmaddr = reinterpret_cast<char*>(-1);
+  shm_segment_info->readOnly = False;
+  XImage* x_image = XShmCreateImage(display, attributes.visual,
+                                    attributes.depth, ZPixmap, 0,
+                                    shm_segment_info, attributes.width,
+                                    attributes.height);
+  if (!x_image) {
+    delete shm_segment_info;
+    return NULL;
+  }
+  if (!IsXImageDesktopFrameFormat(x_image)) {
+    DestroyShmImage(display, x_image, shm_segment_info, false);
+    return NULL;
+  }
+
+  shm_segment_info->shmid =
+      shmget(IPC_PRIVATE, x_image->bytes_per_line * x_image->height,
+             IPC_CREAT | 0600);
+  if (shm_segment_info->shmid == -1) {
+    LOG(LS_WARNING) << "Failed to get shared memory segment.";
+    DestroyShmImage(display, x_image, shm_segment_info, false);
+    return NULL;
+  }
+  shm_segment_info->shmaddr = x_image->data =
+      reinterpret_cast<char*>(shmat(shm_segment_info->shmid, 0, 0));
+  if (shm_segment_info->shmaddr == reinterpret_cast<char*>(-1)) {
+    DestroyShmImage(display, x_image, shm_segment_info, false);
+    return NULL;
+  }
+
+  {
+    XErrorTrap error_trap(display);
+    bool attached = XShmAttach(display, shm_segment_info);
+    XSync(display, False);
+    if (error_trap.GetLastErrorAndDisable() != 0 || !attached) {
+      DestroyShmImage(display, x_image, shm_segment_info, false);
+      return NULL;
+    }
+  }
+
+  // The segment is destroyed once both sides have detached.
+  shmctl(shm_segment_info->shmid, IPC_RMID, 0);
+  shm_segment_info->shmid = -1;
+
+  Pixmap pixmap;
+  {
+    XErrorTrap error_trap(display);
+    pixmap = XShmCreatePixmap(display, window, shm_segment_info->shmaddr,
+                              shm_segment_info, attributes.width,
+                              attributes.height, attributes.depth);
+    XSync(display, False);
+    if (error_trap.GetLastErrorAndDisable() != 0) {
+      DestroyShmImage(display, x_image, shm_segment_info, true);
+      return NULL;
+    }
+  }
+
+  GC gc;
+  {
+    XErrorTrap error_trap(display);
+    XGCValues gc_values;
+    gc_values.subwindow_mode = IncludeInferiors;
+    gc_values.graphics_exposures = False;
+    gc = XCreateGC(display, window, GCSubwindowMode | GCGraphicsExposures,
+                   &gc_values);
+    XSync(display, False);
+    if (error_trap.GetLastErrorAndDisable() != 0) {
+      XFreePixmap(display, pixmap);
+      DestroyShmImage(display, x_image, shm_segment_info, true);
+      return NULL;
+    }
+  }
+
+  return new XShmDesktopFrame(display, window, x_image, shm_segment_info,
+                              pixmap, gc);
+}
+
+void XShmDesktopFrame::CopyFromWindow(const DesktopRegion& region) {
+  if (region.is_empty())
+    return;
+
+  // Queue all the copies and wait for them with a single round trip.
+  // XCopyArea can fail if the display is being reconfigured.
+  XErrorTrap error_trap(display_);
+  for (DesktopRegion::Iterator it(region); !it.IsAtEnd(); it.Advance()) {
+    const DesktopRect& rect = it.rect();
+    XCopyArea(display_, window_, pixmap_, gc_,
+              rect.left(), rect.top(), rect.width(), rect.height(),
+              rect.left(), rect.top());
+  }
+  XSync(display_, False);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+// Don't include this file in any .h files because it pulls in some X headers.
+
+#ifndef WEBRTC_MODULES_DESKTOP_CAPTURE_X11_X_SHM_DESKTOP_FRAME_H_
+#define WEBRTC_MODULES_DESKTOP_CAPTURE_X11_X_SHM_DESKTOP_FRAME_H_
+
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+#include "webrtc/modules/desktop_capture/desktop_frame.h"
+
+namespace webrtc {
+
+class DesktopRegion;
+
+// A DesktopFrame whose buffer is an X shared memory segment that is also
+// attached to the X server as a pixmap. Screen contents are copied into the
+// frame by the X server itself (XCopyArea), so capturing a region does not
+// touch the pixels on the client side at all.
+class XShmDesktopFrame : public DesktopFrame {
+ public:
+  virtual ~XShmDesktopFrame();
+
+  // Creates a frame of the size of |window|. Returns NULL if the X server
+  // doesn't support shared memory pixmaps or the pixel format of the window
+  // is not 32-bit RGB, in which case the caller should fall back to
+  // XServerPixelBuffer.
+  static XShmDesktopFrame* Create(Display* display, Window window);
+
+  // Copies |region| of the window into the frame. Returns once the X server
+  // has finished writing the pixels.
+  void CopyFromWindow(const DesktopRegion& region);
+
+ private:
+  XShmDesktopFrame(Display* display,
+                   Window window,
+                   XImage* x_image,
+                   XShmSegmentInfo* shm_segment_info,
+                   Pixmap pixmap,
+                   GC gc);
+
+  Display* const display_;
+  const Window window_;
+  XImage* const x_image_;
+  XShmSegmentInfo* const shm_segment_info_;
+  const Pixmap pixmap_;
+  const GC gc_;
+
+  DISALLOW_COPY_AND_ASSIGN(XShmDesktopFrame);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_DESKTOP_CAPTURE_X11_X_SHM_DESKTOP_FRAME_H_
@@ -0,0 +1,275 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_INTERFACE_NACK_BITMAP_H_
+#define WEBRTC_MODULES_INTERFACE_NACK_BITMAP_H_
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/modules/interface/module_common_types.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Tracks the set of missing RTP sequence numbers of one stream as a sliding
+// bitmap. Sequence number s maps to bit (s mod capacity), so memory is fixed
+// at |capacity| / 8 bytes no matter how many packets are lost, and inserting,
+// removing and looking up a sequence number never allocates.
+//
+// The tracked window runs from the oldest missing sequence number to the
+// newest sequence number passed to AddMissing(), and never spans more than
+// |capacity| sequence numbers. When new losses would grow the window beyond
+// that, the oldest missing sequence numbers are dropped.
+//
+// Not thread safe.
+class NackBitmap {
+ public:
+  // The largest supported capacity. Larger windows would make the ordering of
+  // sequence numbers within the window ambiguous.
+  static const size_t kMaxCapacity = 1 << 15;
+
+  // |capacity| is rounded up to a power of two, and at least 64.
+  explicit NackBitmap(size_t capacity)
+      : mask_(RoundUpCapacity(capacity) - 1),
+        words_((mask_ + 1) / kBitsPerWord, 0),
+        oldest_(0),
+        end_(0),
+        size_(0) {}
+
+  size_t capacity() const { return mask_ + 1; }
+  // Callers which keep per-packet state in an array of capacity() entries can
+  // index it with this. Sequence numbers in the window never share a slot.
+  size_t Slot(uint16_t sequence_number) const {
+    return sequence_number & mask_;
+  }
+  // The number of missing sequence numbers.
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void Clear() {
+    if (size_ > 0)
+      ClearRange(oldest_, WindowLength());
+    assert(size_ == 0);
+  }
+
+  // Marks all sequence numbers from |begin| up to, but not including, |end| as
+  // missing. Sequence numbers which are not newer than the newest one already
+  // added are skipped. Returns the number of old missing sequence numbers
+  // which were dropped to make room.
+  size_t AddMissing(uint16_t begin, uint16_t end) {
+    if (!IsNewerSequenceNumber(end, begin))
+      return 0;
+    if (size_ == 0) {
+      // The window is empty, so it can be moved anywhere.
+      oldest_ = begin;
+      end_ = begin;
+    } else if (IsNewerSequenceNumber(end_, begin)) {
+      begin = end_;
+      if (!IsNewerSequenceNumber(end, begin))
+        return 0;
+    }
+    size_t dropped = 0;
+    if (size_ > 0 && static_cast<uint16_t>(end - oldest_) > capacity()) {
+      const size_t old_size = size_;
+      const uint16_t new_oldest = static_cast<uint16_t>(end - capacity());
+      if (IsNewerSequenceNumber(new_oldest, end_)) {
+        Clear();
+      } else {
+        ClearRange(oldest_, static_cast<uint16_t>(new_oldest - oldest_));
+        oldest_ = new_oldest;
+        AdvanceOldest();
+      }
+      dropped = old_size - size_;
+    }
+    // Only the newest |capacity| sequence numbers of a huge gap fit.
+    if (static_cast<uint16_t>(end - begin) > capacity())
+      begin = static_cast<uint16_t>(end - capacity());
+    if (size_ == 0)
+      oldest_ = begin;
+    SetRange(begin, static_cast<uint16_t>(end - begin));
+    end_ = end;
+    return dropped;
+  }
+
+  // Returns true if |sequence_number| was missing.
+  bool Remove(uint16_t sequence_number) {
+    if (!Contains(sequence_number))
+      return false;
+    words_[WordIndex(sequence_number)] &= ~BitMask(sequence_number);
+    --size_;
+    if (sequence_number == oldest_)
+      AdvanceOldest();
+    return true;
+  }
+
+  // Removes all missing sequence numbers which are not newer than
+  // |sequence_number|.
+  void RemoveUpTo(uint16_t sequence_number) {
+    if (size_ == 0 || IsNewerSequenceNumber(oldest_, sequence_number))
+      return;
+    const uint16_t next = sequence_number + 1;
+    if (!IsNewerSequenceNumber(end_, next)) {
+      Clear();
+      return;
+    }
+    ClearRange(oldest_, static_cast<uint16_t>(next - oldest_));
+    oldest_ = next;
+    AdvanceOldest();
+  }
+
+  bool Contains(uint16_t sequence_number) const {
+    if (size_ == 0 ||
+        static_cast<uint16_t>(sequence_number - oldest_) >= WindowLength()) {
+      return false;
+    }
+    return (words_[WordIndex(sequence_number)] &
+            BitMask(sequence_number)) != 0;
+  }
+
+  // The oldest missing sequence number. Must not be called when empty.
+  uint16_t Oldest() const {
+    assert(size_ > 0);
+    return oldest_;
+  }
+
+  // Calls |callback(sequence_number)| for each missing sequence number, from
+  // the oldest to the newest.
+  template <typename Callback>
+  void ForEach(Callback callback) const {
+    size_t remaining = size_;
+    if (remaining == 0)
+      return;
+    const size_t bit = oldest_ % kBitsPerWord;
+    uint16_t base = oldest_ - static_cast<uint16_t>(bit);
+    uint64_t word = words_[WordIndex(oldest_)] >> bit << bit;
+    while (true) {
+      while (word != 0) {
+        callback(static_cast<uint16_t>(base + CountTrailingZeros(word)));
+        if (--remaining == 0)
+          return;
+        word &= word - 1;
+      }
+      base += kBitsPerWord;
+      word = words_[WordIndex(base)];
+    }
+  }
+
+  // Replaces the content of |sequence_numbers| with all missing sequence
+  // numbers, from the oldest to the newest.
+  void GetSequenceNumbers(std::vector<uint16_t>* sequence_numbers) const {
+    sequence_numbers->clear();
+    sequence_numbers->reserve(size_);
+    ForEach([sequence_numbers](uint16_t sequence_number) {
+      sequence_numbers->push_back(sequence_number);
+    });
+  }
+
+ private:
+  static const size_t kBitsPerWord = 64;
+
+  static size_t RoundUpCapacity(size_t capacity) {
+    assert(capacity <= kMaxCapacity);
+    size_t rounded = kBitsPerWord;
+    while (rounded < capacity && rounded < kMaxCapacity)
+      rounded <<= 1;
+    return rounded;
+  }
+
+  static int PopCount(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+  }
+
+  // |x| must be nonzero.
+  static int CountTrailingZeros(uint64_t x) {
+    return PopCount((x & (~x + 1)) - 1);
+  }
+
+  size_t WordIndex(uint16_t sequence_number) const {
+    return (sequence_number & mask_) / kBitsPerWord;
+  }
+  static uint64_t BitMask(uint16_t sequence_number) {
+    return 1ULL << (sequence_number % kBitsPerWord);
+  }
+  uint16_t WindowLength() const {
+    return static_cast<uint16_t>(end_ - oldest_);
+  }
+
+  // Returns the mask of |*count| bits starting at |first| which lie in the
+  // same word as |first|, and reduces |*count| accordingly.
+  static uint64_t RangeMask(uint16_t first, size_t* count) {
+    const size_t bit = first % kBitsPerWord;
+    size_t bits = kBitsPerWord - bit;
+    if (bits > *count)
+      bits = *count;
+    *count -= bits;
+    const uint64_t mask =
+        bits == kBitsPerWord ? ~0ULL : ((1ULL << bits) - 1);
+    return mask << bit;
+  }
+
+  void SetRange(uint16_t first, size_t count) {
+    while (count > 0) {
+      const size_t before = count;
+      const uint64_t mask = RangeMask(first, &count);
+      uint64_t& word = words_[WordIndex(first)];
+      size_ += PopCount(mask & ~word);
+      word |= mask;
+      first += static_cast<uint16_t>(before - count);
+    }
+  }
+
+  void ClearRange(uint16_t first, size_t count) {
+    while (count > 0 && size_ > 0) {
+      const size_t before = count;
+      const uint64_t mask = RangeMask(first, &count);
+      uint64_t& word = words_[WordIndex(first)];
+      size_ -= PopCount(mask & word);
+      word &= ~mask;
+      first += static_cast<uint16_t>(before - count);
+    }
+  }
+
+  // Moves |oldest_| forward to the next missing sequence number.
+  void AdvanceOldest() {
+    if (size_ == 0) {
+      oldest_ = end_;
+      return;
+    }
+    const size_t bit = oldest_ % kBitsPerWord;
+    uint64_t word = words_[WordIndex(oldest_)] >> bit << bit;
+    oldest_ -= static_cast<uint16_t>(bit);
+    while (word == 0) {
+      oldest_ += kBitsPerWord;
+      word = words_[WordIndex(oldest_)];
+    }
+    oldest_ += static_cast<uint16_t>(CountTrailingZeros(word));
+  }
+
+  const size_t mask_;
+  std::vector<uint64_t> words_;
+  // The oldest missing sequence number when not empty.
+  uint16_t oldest_;
+  // One past the newest sequence number passed to AddMissing().
+  uint16_t end_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(NackBitmap);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_INTERFACE_NACK_BITMAP_H_
@@ -209,9 +209,11 @@
             'desktop_capture/win/cursor_unittest_resources.rc',
             'media_file/source/media_file_unittest.cc',
             'module_common_types_unittest.cc',
+            'nack_bitmap_unittest.cc',
             'pacing/bitrate_prober_unittest.cc',
             'pacing/paced_sender_unittest.cc',
             'pacing/packet_router_unittest.cc',
+            'pacing/probe_controller_unittest.cc',
             'remote_bitrate_estimator/bwe_simulations.cc',
             'remote_bitrate_estimator/include/mock/mock_remote_bitrate_observer.h',
             'remote_bitrate_estimator/inter_arrival_unittest.cc',
@@ -221,6 +223,8 @@
             'remote_bitrate_estimator/remote_bitrate_estimator_single_stream_unittest.cc',
             'remote_bitrate_estimator/remote_bitrate_estimator_unittest_helper.cc',
             'remote_bitrate_estimator/remote_bitrate_estimator_unittest_helper.h',
+            'remote_bitrate_estimator/remote_estimator_proxy_unittest.cc',
+            'remote_bitrate_estimator/transport_feedback_adapter_unittest.cc',
             'rtp_rtcp/source/mock/mock_rtp_payload_strategy.h',
             'rtp_rtcp/source/byte_io_unittest.cc',
             'rtp_rtcp/source/fec_receiver_unittest.cc',
@@ -233,6 +237,7 @@
             'rtp_rtcp/source/remote_ntp_time_estimator_unittest.cc',
             'rtp_rtcp/source/rtcp_format_remb_unittest.cc',
             'rtp_rtcp/source/rtcp_packet_unittest.cc',
+            'rtp_rtcp/source/rtcp_packet_view_unittest.cc',
             'rtp_rtcp/source/rtcp_receiver_unittest.cc',
             'rtp_rtcp/source/rtcp_sender_unittest.cc',
             'rtp_rtcp/source/rtcp_utility_unittest.cc',
@@ -246,6 +251,8 @@
             'rtp_rtcp/source/rtp_rtcp_impl_unittest.cc',
             'rtp_rtcp/source/rtp_header_extension_unittest.cc',
             'rtp_rtcp/source/rtp_sender_unittest.cc',
+            'rtp_rtcp/source/ssrc_table_unittest.cc',
+            'rtp_rtcp/source/transport_feedback_unittest.cc',
             'rtp_rtcp/source/vp8_partition_aggregator_unittest.cc',
             'rtp_rtcp/test/testAPI/test_api.cc',
             'rtp_rtcp/test/testAPI/test_api.h',
@@ -266,6 +273,7 @@
             'video_coding/codecs/vp8/simulcast_unittest.h',
             'video_coding/main/interface/mock/mock_vcm_callbacks.h',
             'video_coding/main/source/decoding_state_unittest.cc',
+            'video_coding/main/source/generic_decoder_unittest.cc',
             'video_coding/main/source/jitter_buffer_unittest.cc',
             'video_coding/main/source/jitter_estimator_tests.cc',
             'video_coding/main/source/media_optimization_unittest.cc',
@@ -278,6 +286,8 @@
             'video_coding/main/source/qm_select_unittest.cc',
             'video_coding/main/source/test/stream_generator.cc',
             'video_coding/main/source/test/stream_generator.h',
+            'video_coding/utility/decoder_buffer_pool_unittest.cc',
+            'video_coding/utility/h264_bitstream_parser_unittest.cc',
             'video_coding/utility/quality_scaler_unittest.cc',
             'video_processing/main/test/unit_test/brightness_detection_test.cc',
             'video_processing/main/test/unit_test/content_metrics_test.cc',
@@ -0,0 +1,144 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/modules/interface/nack_bitmap.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// 8 Mbps of 1200 byte packets for one minute.
+const int kPacketsPerSecond = 8000000 / (8 * 1200);
+const int kNumPackets = 60 * kPacketsPerSecond;
+// Retransmissions arrive one 100 ms round trip after the loss.
+const int kRttPackets = kPacketsPerSecond / 10;
+// Packets are decoded half a second after they are due.
+const int kDecodeDelayPackets = kPacketsPerSecond / 2;
+// The receiver asks for the NACK list every 10 packets.
+const int kNackInterval = 10;
+
+class SequenceNumberLessThan {
+ public:
+  bool operator()(uint16_t sequence_number1, uint16_t sequence_number2) const {
+    return IsNewerSequenceNumber(sequence_number2, sequence_number1);
+  }
+};
+
+// The std::set based NACK list which NackBitmap replaced.
+class SetTracker {
+ public:
+  void AddMissing(uint16_t begin, uint16_t end) {
+    for (uint16_t i = begin; i != end; ++i)
+      missing_.insert(missing_.end(), i);
+  }
+  void Remove(uint16_t sequence_number) { missing_.erase(sequence_number); }
+  void RemoveUpTo(uint16_t sequence_number) {
+    missing_.erase(missing_.begin(), missing_.upper_bound(sequence_number));
+  }
+  void GetSequenceNumbers(std::vector<uint16_t>* sequence_numbers) const {
+    sequence_numbers->assign(missing_.begin(), missing_.end());
+  }
+
+ private:
+  std::set<uint16_t, SequenceNumberLessThan> missing_;
+};
+
+class BitmapTracker {
+ public:
+  BitmapTracker() : missing_(NackBitmap::kMaxCapacity) {}
+  void AddMissing(uint16_t begin, uint16_t end) {
+    missing_.AddMissing(begin, end);
+  }
+  void Remove(uint16_t sequence_number) { missing_.Remove(sequence_number); }
+  void RemoveUpTo(uint16_t sequence_number) {
+    missing_.RemoveUpTo(sequence_number);
+  }
+  void GetSequenceNumbers(std::vector<uint16_t>* sequence_numbers) const {
+    missing_.GetSequenceNumbers(sequence_numbers);
+  }
+
+ private:
+  NackBitmap missing_;
+};
+
+// Feeds a stream with |loss_percent| random loss, where retransmissions may
+// be lost as well, through |tracker| the way the jitter buffer does. Returns
+// the number of NACKed sequence numbers, to check that both trackers agree.
+template <typename Tracker>
+size_t RunStream(int loss_percent, Tracker* tracker, int64_t* elapsed_us) {
+  Clock* clock = Clock::GetRealTimeClock();
+  // Sequence numbers to retransmit, indexed by arrival slot.
+  std::vector<std::vector<uint16_t>> retransmissions(kNumPackets +
+                                                     kRttPackets + 1);
+  std::vector<uint16_t> nack_list;
+  uint32_t random = 4711;
+  size_t nacked = 0;
+  uint16_t latest = 0;
+  const int64_t start_us = clock->TimeInMicroseconds();
+  for (int i = 1; i < kNumPackets; ++i) {
+    const uint16_t sequence_number = static_cast<uint16_t>(i);
+    random = random * 1103515245 + 12345;
+    if (static_cast<int>((random >> 16) % 100) >= loss_percent) {
+      tracker->AddMissing(latest + 1, sequence_number);
+      latest = sequence_number;
+    } else {
+      retransmissions[i + kRttPackets].push_back(sequence_number);
+    }
+    for (uint16_t retransmitted : retransmissions[i]) {
+      random = random * 1103515245 + 12345;
+      if (static_cast<int>((random >> 16) % 100) >= loss_percent)
+        tracker->Remove(retransmitted);
+      else
+        retransmissions[i + kRttPackets].push_back(retransmitted);
+    }
+    if (i > kDecodeDelayPackets)
+      tracker->RemoveUpTo(static_cast<uint16_t>(i - kDecodeDelayPackets));
+    if (i % kNackInterval == 0) {
+      tracker->GetSequenceNumbers(&nack_list);
+      nacked += nack_list.size();
+    }
+  }
+  *elapsed_us = clock->TimeInMicroseconds() - start_us;
+  return nacked;
+}
+
+void RunLossTest(int loss_percent) {
+  SetTracker set_tracker;
+  BitmapTracker bitmap_tracker;
+  int64_t set_us = 0;
+  int64_t bitmap_us = 0;
+  EXPECT_EQ(RunStream(loss_percent, &set_tracker, &set_us),
+            RunStream(loss_percent, &bitmap_tracker, &bitmap_us));
+
+  const std::string trace = rtc::ToString(loss_percent) + "pct_loss";
+  test::PrintResult("nack_list_packet_time", "_set", trace,
+                    1000.0 * set_us / kNumPackets, "ns", false);
+  test::PrintResult("nack_list_packet_time", "_bitmap", trace,
+                    1000.0 * bitmap_us / kNumPackets, "ns", true);
+}
+
+}  // namespace
+
+TEST(NackBitmapPerfTest, FivePercentLossAt8Mbps) {
+  RunLossTest(5);
+}
+
+TEST(NackBitmapPerfTest, TwentyPercentLossAt8Mbps) {
+  RunLossTest(20);
+}
+
+}  // namespace webrtc
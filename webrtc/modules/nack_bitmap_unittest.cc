@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <set>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/interface/nack_bitmap.h"
+
+namespace webrtc {
+namespace {
+
+class SequenceNumberLessThan {
+ public:
+  bool operator()(uint16_t sequence_number1, uint16_t sequence_number2) const {
+    return IsNewerSequenceNumber(sequence_number2, sequence_number1);
+  }
+};
+typedef std::set<uint16_t, SequenceNumberLessThan> SequenceNumberSet;
+
+std::vector<uint16_t> SequenceNumbers(const NackBitmap& bitmap) {
+  std::vector<uint16_t> sequence_numbers;
+  bitmap.GetSequenceNumbers(&sequence_numbers);
+  return sequence_numbers;
+}
+
+}  // namespace
+
+TEST(NackBitmapTest, CapacityIsRoundedUp) {
+  EXPECT_EQ(64u, NackBitmap(1).capacity());
+  EXPECT_EQ(512u, NackBitmap(501).capacity());
+  const size_t kMaxCapacity = NackBitmap::kMaxCapacity;
+  EXPECT_EQ(kMaxCapacity, NackBitmap(kMaxCapacity).capacity());
+}
+
+TEST(NackBitmapTest, AddAndRemove) {
+  NackBitmap bitmap(256);
+  EXPECT_TRUE(bitmap.empty());
+  EXPECT_EQ(0u, bitmap.AddMissing(10, 15));
+  EXPECT_EQ(5u, bitmap.size());
+  EXPECT_EQ(10, bitmap.Oldest());
+  EXPECT_TRUE(bitmap.Contains(14));
+  EXPECT_FALSE(bitmap.Contains(15));
+  EXPECT_FALSE(bitmap.Contains(9));
+
+  EXPECT_TRUE(bitmap.Remove(10));
+  EXPECT_FALSE(bitmap.Remove(10));
+  EXPECT_TRUE(bitmap.Remove(12));
+  EXPECT_EQ(11, bitmap.Oldest());
+  const uint16_t kExpected[] = {11, 13, 14};
+  EXPECT_EQ(std::vector<uint16_t>(kExpected, kExpected + 3),
+            SequenceNumbers(bitmap));
+
+  // Already covered sequence numbers are not added again.
+  bitmap.AddMissing(12, 16);
+  const uint16_t kExpected2[] = {11, 13, 14, 15};
+  EXPECT_EQ(std::vector<uint16_t>(kExpected2, kExpected2 + 4),
+            SequenceNumbers(bitmap));
+
+  bitmap.RemoveUpTo(13);
+  EXPECT_EQ(14, bitmap.Oldest());
+  EXPECT_EQ(2u, bitmap.size());
+  bitmap.Clear();
+  EXPECT_TRUE(bitmap.empty());
+}
+
+TEST(NackBitmapTest, WrapAround) {
+  NackBitmap bitmap(128);
+  bitmap.AddMissing(0xFFFE, 2);
+  const uint16_t kExpected[] = {0xFFFE, 0xFFFF, 0, 1};
+  EXPECT_EQ(std::vector<uint16_t>(kExpected, kExpected + 4),
+            SequenceNumbers(bitmap));
+  bitmap.RemoveUpTo(0xFFFF);
+  EXPECT_EQ(0, bitmap.Oldest());
+  EXPECT_EQ(2u, bitmap.size());
+}
+
+TEST(NackBitmapTest, DropsOldestWhenFull) {
+  NackBitmap bitmap(64);
+  bitmap.AddMissing(100, 110);
+  EXPECT_EQ(0u, bitmap.AddMissing(150, 160));
+  EXPECT_EQ(20u, bitmap.size());
+  // The window would span 100..179, so 100..115 have to go.
+  EXPECT_EQ(10u, bitmap.AddMissing(170, 180));
+  EXPECT_EQ(150, bitmap.Oldest());
+  EXPECT_EQ(20u, bitmap.size());
+  // A gap larger than the capacity keeps only its newest part.
+  EXPECT_EQ(20u, bitmap.AddMissing(1000, 2000));
+  EXPECT_EQ(64u, bitmap.size());
+  EXPECT_EQ(2000 - 64, bitmap.Oldest());
+}
+
+// Compares against a std::set driven with the same random operations.
+TEST(NackBitmapTest, MatchesSetModel) {
+  const size_t kCapacity = 1024;
+  NackBitmap bitmap(kCapacity);
+  SequenceNumberSet model;
+  uint32_t random = 1234;
+  uint16_t next = 0xFF00;
+  for (int i = 0; i < 20000; ++i) {
+    random = random * 1103515245 + 12345;
+    const uint32_t r = random >> 16;
+    if (r % 4 == 0) {
+      const uint16_t gap = static_cast<uint16_t>(1 + r % 40);
+      const uint16_t end = next + gap;
+      bitmap.AddMissing(next, end);
+      for (uint16_t s = next; s != end; ++s)
+        model.insert(s);
+      next = end + 1;
+      // The model keeps the same window as the bitmap.
+      while (!model.empty() &&
+             static_cast<uint16_t>(end - *model.begin()) > kCapacity) {
+        model.erase(model.begin());
+      }
+    } else if (r % 4 == 1 && !model.empty()) {
+      const uint16_t s = next - 1 - static_cast<uint16_t>(r % 300);
+      EXPECT_EQ(model.erase(s) == 1, bitmap.Remove(s));
+    } else if (r % 4 == 2 && !model.empty()) {
+      const uint16_t s = *model.begin() + static_cast<uint16_t>(r % 20);
+      model.erase(model.begin(), model.upper_bound(s));
+      bitmap.RemoveUpTo(s);
+    } else {
+      ++next;
+    }
+    ASSERT_EQ(model.size(), bitmap.size());
+    if (!model.empty()) {
+      ASSERT_EQ(*model.begin(), bitmap.Oldest());
+    }
+    if (i % 100 == 0) {
+      ASSERT_EQ(std::vector<uint16_t>(model.begin(), model.end()),
+                SequenceNumbers(bitmap));
+    }
+  }
+}
+
+}  // namespace webrtc
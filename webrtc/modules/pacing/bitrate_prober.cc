@@ -31,6 +31,8 @@ int ComputeDeltaFromBitrate(size_t packet_size, int bitrate_bps) {
 
 BitrateProber::BitrateProber()
     : probing_state_(kDisabled),
+      initial_probe_created_(false),
+      next_cluster_id_(0),
       packet_size_last_send_(0),
       time_last_send_ms_(-1) {
 }
@@ -43,6 +45,8 @@ void BitrateProber::SetEnabled(bool enable) {
     }
   } else {
     probing_state_ = kDisabled;
+    initial_probe_created_ = false;
+    clusters_ = std::queue<ProbeCluster>();
     LOG(LS_INFO) << "Initial bandwidth probing disabled";
   }
 }
@@ -52,45 +56,55 @@ bool BitrateProber::IsProbing() const {
 }
 
 void BitrateProber::MaybeInitializeProbe(int bitrate_bps) {
-  if (probing_state_ != kAllowedToProbe)
+  if (probing_state_ == kDisabled || initial_probe_created_)
     return;
-  probe_bitrates_.clear();
-  // Max number of packets used for probing.
+  initial_probe_created_ = true;
   const int kMaxNumProbes = 2;
   const int kPacketsPerProbe = 5;
   const float kProbeBitrateMultipliers[kMaxNumProbes] = {3, 6};
-  int bitrates_bps[kMaxNumProbes];
   std::stringstream bitrate_log;
   bitrate_log << "Start probing for bandwidth, bitrates:";
   for (int i = 0; i < kMaxNumProbes; ++i) {
-    bitrates_bps[i] = kProbeBitrateMultipliers[i] * bitrate_bps;
-    bitrate_log << " " << bitrates_bps[i];
+    int probe_bitrate_bps = kProbeBitrateMultipliers[i] * bitrate_bps;
+    bitrate_log << " " << probe_bitrate_bps;
     // We need one extra to get 5 deltas for the first probe.
-    if (i == 0)
-      probe_bitrates_.push_back(bitrates_bps[i]);
-    for (int j = 0; j < kPacketsPerProbe; ++j)
-      probe_bitrates_.push_back(bitrates_bps[i]);
+    CreateProbeCluster(probe_bitrate_bps,
+                       i == 0 ? kPacketsPerProbe + 1 : kPacketsPerProbe);
   }
-  bitrate_log << ", num packets: " << probe_bitrates_.size();
   LOG(LS_INFO) << bitrate_log.str().c_str();
-  probing_state_ = kProbing;
 }
 
-int BitrateProber::TimeUntilNextProbe(int64_t now_ms) {
-  if (probing_state_ != kDisabled && probe_bitrates_.empty()) {
-    probing_state_ = kWait;
+void BitrateProber::CreateProbeCluster(int bitrate_bps, int num_packets) {
+  assert(bitrate_bps > 0);
+  assert(num_packets > 0);
+  if (probing_state_ == kDisabled)
+    return;
+  if (probing_state_ != kProbing) {
+    probing_state_ = kProbing;
+    time_last_send_ms_ = -1;
   }
-  if (probe_bitrates_.empty()) {
-    // No probe started, or waiting for next probe.
+  clusters_.push(ProbeCluster(next_cluster_id_++, bitrate_bps, num_packets));
+  LOG(LS_INFO) << "Probe cluster " << clusters_.back().id << " created, "
+               << bitrate_bps << " bps, " << num_packets << " packets.";
+}
+
+int BitrateProber::CurrentClusterId() const {
+  assert(IsProbing());
+  return clusters_.front().id;
+}
+
+int BitrateProber::TimeUntilNextProbe(int64_t now_ms) {
+  if (probing_state_ != kProbing) {
+    // No probe started, or waiting for the next probe.
     return -1;
   }
-  int64_t elapsed_time_ms = now_ms - time_last_send_ms_;
   // We will send the first probe packet immediately if no packet has been
-  // sent before.
+  // sent before in this probing session.
   int time_until_probe_ms = 0;
-  if (packet_size_last_send_ > 0 && probing_state_ == kProbing) {
+  if (packet_size_last_send_ > 0 && time_last_send_ms_ != -1) {
+    int64_t elapsed_time_ms = now_ms - time_last_send_ms_;
     int next_delta_ms = ComputeDeltaFromBitrate(packet_size_last_send_,
-                                                probe_bitrates_.front());
+                                                clusters_.front().bitrate_bps);
     time_until_probe_ms = next_delta_ms - elapsed_time_ms;
     // There is no point in trying to probe with less than 1 ms between packets
     // as it essentially means trying to probe at infinite bandwidth.
@@ -100,12 +114,12 @@ int BitrateProber::TimeUntilNextProbe(int64_t now_ms) {
     const int kMaxProbeDelayMs = 3;
     if (next_delta_ms < kMinProbeDeltaMs ||
         time_until_probe_ms < -kMaxProbeDelayMs) {
-      // We currently disable probing after the first probe, as we only want
-      // to probe at the beginning of a connection. We should set this to
-      // kWait if we later want to probe periodically.
-      probing_state_ = kWait;
+      // The remaining clusters would be sent with gaps that the estimator
+      // can't tell apart from a congested link, so they are dropped as well.
+      clusters_ = std::queue<ProbeCluster>();
+      probing_state_ = kInactive;
       LOG(LS_INFO) << "Next delta too small, stop probing.";
-      time_until_probe_ms = 0;
+      return -1;
     }
   }
   return std::max(time_until_probe_ms, 0);
@@ -119,9 +133,13 @@ void BitrateProber::PacketSent(int64_t now_ms, size_t packet_size) {
   assert(packet_size > 0);
   packet_size_last_send_ = packet_size;
   time_last_send_ms_ = now_ms;
-  if (probing_state_ != kProbing)
+  if (probing_state_ != kProbing || clusters_.empty())
     return;
-  if (!probe_bitrates_.empty())
-    probe_bitrates_.pop_front();
+  ProbeCluster& cluster = clusters_.front();
+  if (++cluster.sent_packets == cluster.max_packets) {
+    clusters_.pop();
+    if (clusters_.empty())
+      probing_state_ = kInactive;
+  }
 }
 }  // namespace webrtc
@@ -12,12 +12,16 @@
 #define WEBRTC_MODULES_PACING_BITRATE_PROBER_H_
 
 #include <cstddef>
-#include <list>
+#include <queue>
 
 #include "webrtc/typedefs.h"
 
 namespace webrtc {
 
+// Schedules probe clusters: short trains of packets sent at a given bitrate,
+// which lets the bandwidth estimator measure the capacity of the link from
+// how the train is spread out on arrival. Clusters are sent back to back in
+// the order they are created.
 // Note that this class isn't thread-safe by itself and therefore relies
 // on being protected by the caller.
 class BitrateProber {
@@ -31,9 +35,19 @@ class BitrateProber {
   // TimeUntilNextProbe().
   bool IsProbing() const;
 
-  // Initializes a new probing session if the prober is allowed to probe.
+  // Schedules the probe clusters sent at the start of a call, if the prober is
+  // enabled and hasn't done so already. Clusters created before are sent
+  // first.
   void MaybeInitializeProbe(int bitrate_bps);
 
+  // Schedules a cluster of |num_packets| packets to be sent at |bitrate_bps|,
+  // after any cluster already scheduled. Ignored while probing is disabled.
+  void CreateProbeCluster(int bitrate_bps, int num_packets);
+
+  // Returns the id of the cluster the next packet sent belongs to. Ids are
+  // assigned in increasing order. Must only be called while IsProbing().
+  int CurrentClusterId() const;
+
   // Returns the number of milliseconds until the next packet should be sent to
   // get accurate probing.
   int TimeUntilNextProbe(int64_t now_ms);
@@ -47,14 +61,37 @@ class BitrateProber {
   void PacketSent(int64_t now_ms, size_t packet_size);
 
  private:
-  enum ProbingState { kDisabled, kAllowedToProbe, kProbing, kWait };
+  enum ProbingState {
+    // Probing will not be triggered.
+    kDisabled,
+    // Probing is enabled, but no cluster has been created yet.
+    kAllowedToProbe,
+    // Clusters are being sent.
+    kProbing,
+    // No cluster is scheduled, but new ones may be created.
+    kInactive
+  };
+
+  struct ProbeCluster {
+    ProbeCluster(int id, int bitrate_bps, int num_packets)
+        : id(id), bitrate_bps(bitrate_bps), max_packets(num_packets),
+          sent_packets(0) {}
+    int id;
+    // The bitrate used to compute the delta relative to the previous probe
+    // packet, based on the size and time when that packet was sent.
+    int bitrate_bps;
+    int max_packets;
+    int sent_packets;
+  };
 
   ProbingState probing_state_;
-  // Probe bitrate per packet. These are used to compute the delta relative to
-  // the previous probe packet based on the size and time when that packet was
-  // sent.
-  std::list<int> probe_bitrates_;
+  // True once the clusters of the start of the call have been created.
+  bool initial_probe_created_;
+  std::queue<ProbeCluster> clusters_;
+  int next_cluster_id_;
   size_t packet_size_last_send_;
+  // Reset to -1 when a probing session starts, so that its first packet is
+  // sent right away.
   int64_t time_last_send_ms_;
 };
 }  // namespace webrtc
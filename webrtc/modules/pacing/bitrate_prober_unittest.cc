@@ -48,4 +48,100 @@ TEST(BitrateProberTest, VerifyStatesAndTimeBetweenProbes) {
   EXPECT_EQ(-1, prober.TimeUntilNextProbe(now_ms));
   EXPECT_FALSE(prober.IsProbing());
 }
+
+TEST(BitrateProberTest, AssignsClusterIdsToPackets) {
+  BitrateProber prober;
+  prober.SetEnabled(true);
+  prober.MaybeInitializeProbe(300000);
+
+  int64_t now_ms = 0;
+  for (int i = 0; i < 6; ++i) {
+    now_ms += prober.TimeUntilNextProbe(now_ms);
+    EXPECT_EQ(0, prober.CurrentClusterId());
+    prober.PacketSent(now_ms, 1000);
+  }
+  for (int i = 0; i < 5; ++i) {
+    now_ms += prober.TimeUntilNextProbe(now_ms);
+    EXPECT_EQ(1, prober.CurrentClusterId());
+    prober.PacketSent(now_ms, 1000);
+  }
+  EXPECT_FALSE(prober.IsProbing());
+}
+
+TEST(BitrateProberTest, ProbesOnDemand) {
+  BitrateProber prober;
+  prober.CreateProbeCluster(1000000, 5);
+  EXPECT_FALSE(prober.IsProbing());
+
+  prober.SetEnabled(true);
+  int64_t now_ms = 0;
+  prober.PacketSent(now_ms, 1000);
+  now_ms += 1000;
+
+  // The first packet of a new session is sent right away, no matter how long
+  // ago the previous packet was sent.
+  prober.CreateProbeCluster(2000000, 3);
+  EXPECT_TRUE(prober.IsProbing());
+  EXPECT_EQ(0, prober.TimeUntilNextProbe(now_ms));
+  EXPECT_EQ(0, prober.CurrentClusterId());
+  prober.PacketSent(now_ms, 1000);
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(4, prober.TimeUntilNextProbe(now_ms));
+    now_ms += 4;
+    EXPECT_EQ(0, prober.CurrentClusterId());
+    prober.PacketSent(now_ms, 1000);
+  }
+  EXPECT_FALSE(prober.IsProbing());
+  EXPECT_EQ(-1, prober.TimeUntilNextProbe(now_ms));
+
+  // Clusters created early don't replace the initial probe.
+  prober.MaybeInitializeProbe(300000);
+  EXPECT_TRUE(prober.IsProbing());
+  EXPECT_EQ(1, prober.CurrentClusterId());
+}
+
+TEST(BitrateProberTest, InitialProbeFollowsEarlyClusters) {
+  BitrateProber prober;
+  prober.SetEnabled(true);
+  prober.CreateProbeCluster(1000000, 5);
+  prober.MaybeInitializeProbe(300000);
+  EXPECT_TRUE(prober.IsProbing());
+
+  int64_t now_ms = 0;
+  const int kExpectedClusterIds[] = {0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1,
+                                     2, 2, 2, 2, 2};
+  for (int cluster_id : kExpectedClusterIds) {
+    now_ms += prober.TimeUntilNextProbe(now_ms);
+    EXPECT_EQ(cluster_id, prober.CurrentClusterId());
+    prober.PacketSent(now_ms, 1000);
+  }
+  EXPECT_FALSE(prober.IsProbing());
+
+  // The initial probe is only sent once.
+  prober.MaybeInitializeProbe(300000);
+  EXPECT_FALSE(prober.IsProbing());
+}
+
+TEST(BitrateProberTest, StopsProbingWhenRunningOutOfPackets) {
+  BitrateProber prober;
+  prober.SetEnabled(true);
+  int64_t now_ms = 0;
+  prober.CreateProbeCluster(1000000, 5);
+  prober.CreateProbeCluster(2000000, 5);
+  EXPECT_EQ(0, prober.TimeUntilNextProbe(now_ms));
+  prober.PacketSent(now_ms, 1000);
+  EXPECT_EQ(8, prober.TimeUntilNextProbe(now_ms));
+
+  // No packet to probe with until long after it was due; the remaining
+  // clusters are dropped.
+  now_ms += 12;
+  EXPECT_EQ(-1, prober.TimeUntilNextProbe(now_ms));
+  EXPECT_FALSE(prober.IsProbing());
+
+  // New clusters can be created afterwards.
+  prober.CreateProbeCluster(1000000, 5);
+  EXPECT_TRUE(prober.IsProbing());
+  EXPECT_EQ(2, prober.CurrentClusterId());
+  EXPECT_EQ(0, prober.TimeUntilNextProbe(now_ms));
+}
 }  // namespace webrtc
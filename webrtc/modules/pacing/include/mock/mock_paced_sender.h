@@ -31,6 +31,8 @@ class MockPacedSender : public PacedSender {
                                 bool retransmission));
   MOCK_CONST_METHOD0(QueueInMs, int64_t());
   MOCK_CONST_METHOD0(QueueInPackets, int());
+  MOCK_METHOD1(CreateProbeCluster, void(int bitrate_bps));
+  MOCK_CONST_METHOD0(InApplicationLimitedRegion, bool());
 };
 
 }  // namespace webrtc
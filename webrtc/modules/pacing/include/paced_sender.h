@@ -44,20 +44,27 @@ class PacedSender : public Module {
    public:
     // Note: packets sent as a result of a callback should not pass by this
     // module again.
-    // Called when it's time to send a queued packet.
+    // Called when it's time to send a queued packet. |probe_cluster_id| is
+    // the probe cluster the packet is sent in, or kNotAProbe.
     // Returns false if packet cannot be sent.
     virtual bool TimeToSendPacket(uint32_t ssrc,
                                   uint16_t sequence_number,
                                   int64_t capture_time_ms,
-                                  bool retransmission) = 0;
+                                  bool retransmission,
+                                  int probe_cluster_id) = 0;
     // Called when it's a good time to send a padding data.
     // Returns the number of bytes sent.
-    virtual size_t TimeToSendPadding(size_t bytes) = 0;
+    virtual size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) = 0;
 
    protected:
     virtual ~Callback() {}
   };
 
+  // Probe cluster id of packets which aren't sent as part of a probe.
+  static const int kNotAProbe;
+  // Number of packets in the probe clusters created by CreateProbeCluster().
+  static const int kPacketsPerProbeCluster;
+
   static const int64_t kDefaultMaxQueueLengthMs = 2000;
   // Pace in kbits/s until we receive first estimate.
   static const int kDefaultInitialPaceKbps = 2000;
@@ -92,6 +99,18 @@ class PacedSender : public Module {
   // effect.
   void SetProbingEnabled(bool enabled);
 
+  // Sends a cluster of probe packets at |bitrate_bps|, for instance to find
+  // out how much of a lost bandwidth estimate can be regained without waiting
+  // for the estimate to ramp up. Media packets are used for probing when
+  // there are any, padding otherwise if the probing experiment is enabled.
+  // Has no effect if probing is disabled.
+  virtual void CreateProbeCluster(int bitrate_bps);
+
+  // Returns true if the media sent during the last second used less than
+  // half of the target bitrate, i.e. if the encoders rather than the network
+  // limit the send rate. A bandwidth estimate isn't tested in that state.
+  virtual bool InApplicationLimitedRegion() const;
+
   // Set target bitrates for the pacer.
   // We will pace out bursts of packets at a bitrate of |max_bitrate_kbps|.
   // |bitrate_kbps| is our estimate of what we are allowed to send on average.
@@ -134,9 +153,15 @@ class PacedSender : public Module {
   void UpdateBytesPerInterval(int64_t delta_time_in_ms)
       EXCLUSIVE_LOCKS_REQUIRED(critsect_);
 
+  // Closes the current application limited region detection window once it
+  // is complete.
+  void UpdateApplicationLimitedRegion(int64_t now_ms)
+      EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+
   bool SendPacket(const paced_sender::Packet& packet)
       EXCLUSIVE_LOCKS_REQUIRED(critsect_);
   void SendPadding(size_t padding_needed) EXCLUSIVE_LOCKS_REQUIRED(critsect_);
+  int CurrentProbeClusterId() const EXCLUSIVE_LOCKS_REQUIRED(critsect_);
 
   Clock* const clock_;
   Callback* const callback_;
@@ -160,6 +185,12 @@ class PacedSender : public Module {
 
   int64_t time_last_update_us_ GUARDED_BY(critsect_);
 
+  // Media bytes sent since |alr_window_start_ms_|, used to detect the
+  // application limited region.
+  int64_t alr_window_start_ms_ GUARDED_BY(critsect_);
+  size_t alr_window_bytes_ GUARDED_BY(critsect_);
+  bool in_alr_ GUARDED_BY(critsect_);
+
   rtc::scoped_ptr<paced_sender::PacketQueue> packets_ GUARDED_BY(critsect_);
   uint64_t packet_counter_;
 };
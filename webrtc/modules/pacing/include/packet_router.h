@@ -13,11 +13,13 @@
 
 #include <list>
 
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/constructormagic.h"
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/common_types.h"
 #include "webrtc/modules/pacing/include/paced_sender.h"
+#include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"
 
 namespace webrtc {
 
@@ -26,9 +28,16 @@ class RTPFragmentationHeader;
 class RtpRtcp;
 struct RTPVideoHeader;
 
+namespace rtcp {
+class TransportFeedback;
+}  // namespace rtcp
+
 // PacketRouter routes outgoing data to the correct sending RTP module, based
-// on the simulcast layer in RTPVideoHeader.
-class PacketRouter : public PacedSender::Callback {
+// on the simulcast layer in RTPVideoHeader. It also hands out the transport
+// wide sequence numbers shared by all of its modules, and sends transport
+// feedback on their behalf.
+class PacketRouter : public PacedSender::Callback,
+                     public TransportSequenceNumberAllocator {
  public:
   PacketRouter();
   virtual ~PacketRouter();
@@ -40,9 +49,18 @@ class PacketRouter : public PacedSender::Callback {
   bool TimeToSendPacket(uint32_t ssrc,
                         uint16_t sequence_number,
                         int64_t capture_timestamp,
-                        bool retransmission) override;
+                        bool retransmission,
+                        int probe_cluster_id) override;
+
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) override;
 
-  size_t TimeToSendPadding(size_t bytes) override;
+  void SetTransportWideSequenceNumber(uint16_t sequence_number);
+  // Implements TransportSequenceNumberAllocator. Thread safe, and lock free.
+  uint16_t AllocateSequenceNumber() override;
+
+  // Sends |packet| through the first module which has RTCP enabled. Returns
+  // false if there is no such module, or if sending failed.
+  virtual bool SendFeedback(rtcp::TransportFeedback* packet);
 
  private:
   // TODO(holmer): When the new video API has launched, remove crit_ and
@@ -53,6 +71,9 @@ class PacketRouter : public PacedSender::Callback {
   // Map from ssrc to sending rtp module.
   std::list<RtpRtcp*> rtp_modules_ GUARDED_BY(crit_.get());
 
+  // The next transport wide sequence number, in the low 16 bits.
+  volatile int transport_seq_;
+
   DISALLOW_COPY_AND_ASSIGN(PacketRouter);
 };
 }  // namespace webrtc
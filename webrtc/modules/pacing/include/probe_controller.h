@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_PACING_INCLUDE_PROBE_CONTROLLER_H_
+#define WEBRTC_MODULES_PACING_INCLUDE_PROBE_CONTROLLER_H_
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/thread_annotations.h"
+#include "webrtc/modules/interface/module.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+class Clock;
+class CriticalSectionWrapper;
+class PacedSender;
+
+// Decides when the pacer should send probe clusters after the start of the
+// call:
+// - When the loss that made the bandwidth estimate back off has cleared, the
+//   link is probed just below the estimate from before the backoff, so that a
+//   short loss burst doesn't cost a full ramp-up.
+// - While the encoders send well below the estimate (the application limited
+//   region), the estimate isn't tested by the media, so the link is probed
+//   above it periodically.
+// Only the send-side estimator can use probes sent mid-call; the receive-side
+// estimator infers probe clusters during the first seconds of the call only.
+// The controller must therefore not be wired up until the send-side estimator
+// is, or its probes will cost bandwidth without improving the estimate.
+class ProbeController : public Module {
+ public:
+  ProbeController(Clock* clock, PacedSender* pacer);
+  virtual ~ProbeController();
+
+  // Called with every new bandwidth estimate and the loss it is based on.
+  void OnNetworkChanged(uint32_t bitrate_bps, uint8_t fraction_loss);
+
+  int64_t TimeUntilNextProcess() override;
+  int32_t Process() override;
+
+  // Estimates lower than this percentage of the previous one at a loss above
+  // kBackoffFractionLoss are loss-based backoffs.
+  static const int kBackoffPercent;
+  static const uint8_t kBackoffFractionLoss;
+  // The loss has cleared once it is at most this high.
+  static const uint8_t kRecoveredFractionLoss;
+  // The probe after a backoff targets this percentage of the old estimate.
+  static const int kRecoveryProbePercent;
+  // A backoff is forgotten if the loss hasn't cleared within this time.
+  static const int64_t kMaxRecoveryTimeMs;
+  // Probes in the application limited region target this percentage of the
+  // estimate, and are repeated with this interval.
+  static const int kAlrProbePercent;
+  static const int64_t kAlrProbeIntervalMs;
+
+ private:
+  void MaybeProbe(int64_t bitrate_bps) EXCLUSIVE_LOCKS_REQUIRED(crit_sect_);
+
+  Clock* const clock_;
+  PacedSender* const pacer_;
+  const rtc::scoped_ptr<CriticalSectionWrapper> crit_sect_;
+  uint32_t estimated_bitrate_bps_ GUARDED_BY(crit_sect_);
+  // The estimate before the last loss-based backoff, 0 if the loss has
+  // cleared since.
+  uint32_t bitrate_before_backoff_bps_ GUARDED_BY(crit_sect_);
+  int64_t backoff_time_ms_ GUARDED_BY(crit_sect_);
+  int64_t last_alr_probe_ms_ GUARDED_BY(crit_sect_);
+  int64_t last_process_time_ms_ GUARDED_BY(crit_sect_);
+
+  DISALLOW_COPY_AND_ASSIGN(ProbeController);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_PACING_INCLUDE_PROBE_CONTROLLER_H_
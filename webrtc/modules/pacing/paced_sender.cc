@@ -206,6 +206,9 @@ class IntervalBudget {
 }  // namespace paced_sender
 
 const float PacedSender::kDefaultPaceMultiplier = 2.5f;
+const int PacedSender::kNotAProbe = -1;
+// One more than the number of deltas the estimator needs to detect a cluster.
+const int PacedSender::kPacketsPerProbeCluster = 6;
 
 PacedSender::PacedSender(Clock* clock,
                          Callback* callback,
@@ -223,6 +226,9 @@ PacedSender::PacedSender(Clock* clock,
       prober_(new BitrateProber()),
       bitrate_bps_(1000 * bitrate_kbps),
       time_last_update_us_(clock->TimeInMicroseconds()),
+      alr_window_start_ms_(clock->TimeInMilliseconds()),
+      alr_window_bytes_(0),
+      in_alr_(false),
       packets_(new paced_sender::PacketQueue()),
       packet_counter_(0) {
   UpdateBytesPerInterval(kMinPacketLimitMs);
@@ -245,6 +251,21 @@ void PacedSender::SetProbingEnabled(bool enabled) {
   probing_enabled_ = enabled;
 }
 
+void PacedSender::CreateProbeCluster(int bitrate_bps) {
+  CriticalSectionScoped cs(critsect_.get());
+  if (!probing_enabled_)
+    return;
+  // Probing may be requested before the first packet has been sent, which
+  // is when the prober normally gets enabled.
+  prober_->SetEnabled(true);
+  prober_->CreateProbeCluster(bitrate_bps, kPacketsPerProbeCluster);
+}
+
+bool PacedSender::InApplicationLimitedRegion() const {
+  CriticalSectionScoped cs(critsect_.get());
+  return in_alr_;
+}
+
 void PacedSender::SetStatus(bool enable) {
   CriticalSectionScoped cs(critsect_.get());
   enabled_ = enable;
@@ -311,7 +332,9 @@ int64_t PacedSender::QueueInMs() const {
 
 int64_t PacedSender::TimeUntilNextProcess() {
   CriticalSectionScoped cs(critsect_.get());
-  if (prober_->IsProbing()) {
+  // A cluster created on demand may have to wait for media to probe with.
+  if (prober_->IsProbing() &&
+      (!packets_->Empty() || ProbingExperimentIsEnabled())) {
     int64_t ret = prober_->TimeUntilNextProbe(clock_->TimeInMilliseconds());
     if (ret >= 0) {
       return ret;
@@ -330,6 +353,7 @@ int32_t PacedSender::Process() {
   if (!enabled_) {
     return 0;
   }
+  UpdateApplicationLimitedRegion(now_us / 1000);
   if (!paused_) {
     if (elapsed_time_ms > 0) {
       int64_t delta_time_ms = std::min(kMaxIntervalTimeMs, elapsed_time_ms);
@@ -370,11 +394,13 @@ int32_t PacedSender::Process() {
 }
 
 bool PacedSender::SendPacket(const paced_sender::Packet& packet) {
+  const int probe_cluster_id = CurrentProbeClusterId();
   critsect_->Leave();
   const bool success = callback_->TimeToSendPacket(packet.ssrc,
                                                    packet.sequence_number,
                                                    packet.capture_time_ms,
-                                                   packet.retransmission);
+                                                   packet.retransmission,
+                                                   probe_cluster_id);
   critsect_->Enter();
 
   if (success) {
@@ -382,14 +408,17 @@ bool PacedSender::SendPacket(const paced_sender::Packet& packet) {
     prober_->PacketSent(clock_->TimeInMilliseconds(), packet.bytes);
     media_budget_->UseBudget(packet.bytes);
     padding_budget_->UseBudget(packet.bytes);
+    alr_window_bytes_ += packet.bytes;
   }
 
   return success;
 }
 
 void PacedSender::SendPadding(size_t padding_needed) {
+  const int probe_cluster_id = CurrentProbeClusterId();
   critsect_->Leave();
-  size_t bytes_sent = callback_->TimeToSendPadding(padding_needed);
+  size_t bytes_sent =
+      callback_->TimeToSendPadding(padding_needed, probe_cluster_id);
   critsect_->Enter();
 
   if (bytes_sent > 0) {
@@ -399,6 +428,25 @@ void PacedSender::SendPadding(size_t padding_needed) {
   }
 }
 
+int PacedSender::CurrentProbeClusterId() const {
+  return prober_->IsProbing() ? prober_->CurrentClusterId() : kNotAProbe;
+}
+
+void PacedSender::UpdateApplicationLimitedRegion(int64_t now_ms) {
+  const int64_t kAlrWindowMs = 1000;
+  const int kAlrMaxUsagePercent = 50;
+  const int64_t window_ms = now_ms - alr_window_start_ms_;
+  if (window_ms < kAlrWindowMs)
+    return;
+  // Padding doesn't count, the encoders don't produce it.
+  in_alr_ = !paused_ &&
+            static_cast<int64_t>(alr_window_bytes_) * 8 * 1000 * 100 <
+                static_cast<int64_t>(bitrate_bps_) * window_ms *
+                    kAlrMaxUsagePercent;
+  alr_window_start_ms_ = now_ms;
+  alr_window_bytes_ = 0;
+}
+
 void PacedSender::UpdateBytesPerInterval(int64_t delta_time_ms) {
   media_budget_->IncreaseBudget(delta_time_ms);
   padding_budget_->IncreaseBudget(delta_time_ms);
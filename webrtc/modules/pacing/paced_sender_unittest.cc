@@ -9,6 +9,7 @@
  */
 
 #include <list>
+#include <vector>
 
 #include "testing/gmock/include/gmock/gmock.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -26,13 +27,14 @@ static const float kPaceMultiplier = 1.5f;
 
 class MockPacedSenderCallback : public PacedSender::Callback {
  public:
-  MOCK_METHOD4(TimeToSendPacket,
+  MOCK_METHOD5(TimeToSendPacket,
                bool(uint32_t ssrc,
                     uint16_t sequence_number,
                     int64_t capture_time_ms,
-                    bool retransmission));
-  MOCK_METHOD1(TimeToSendPadding,
-      size_t(size_t bytes));
+                    bool retransmission,
+                    int probe_cluster_id));
+  MOCK_METHOD2(TimeToSendPadding,
+      size_t(size_t bytes, int probe_cluster_id));
 };
 
 class PacedSenderPadding : public PacedSender::Callback {
@@ -42,11 +44,12 @@ class PacedSenderPadding : public PacedSender::Callback {
   bool TimeToSendPacket(uint32_t ssrc,
                         uint16_t sequence_number,
                         int64_t capture_time_ms,
-                        bool retransmission) {
+                        bool retransmission,
+                        int probe_cluster_id) {
     return true;
   }
 
-  size_t TimeToSendPadding(size_t bytes) {
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) {
     const size_t kPaddingPacketSize = 224;
     size_t num_packets = (bytes + kPaddingPacketSize - 1) / kPaddingPacketSize;
     padding_sent_ += kPaddingPacketSize * num_packets;
@@ -70,12 +73,13 @@ class PacedSenderProbing : public PacedSender::Callback {
   bool TimeToSendPacket(uint32_t ssrc,
                         uint16_t sequence_number,
                         int64_t capture_time_ms,
-                        bool retransmission) {
+                        bool retransmission,
+                        int probe_cluster_id) {
     ExpectAndCountPacket();
     return true;
   }
 
-  size_t TimeToSendPadding(size_t bytes) {
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) {
     ExpectAndCountPacket();
     return bytes;
   }
@@ -102,6 +106,37 @@ class PacedSenderProbing : public PacedSender::Callback {
   Clock* clock_;
 };
 
+// Records the probe cluster id of each packet sent, and when it was sent.
+class PacedSenderProbeClusters : public PacedSender::Callback {
+ public:
+  explicit PacedSenderProbeClusters(Clock* clock) : clock_(clock) {}
+
+  bool TimeToSendPacket(uint32_t ssrc,
+                        uint16_t sequence_number,
+                        int64_t capture_time_ms,
+                        bool retransmission,
+                        int probe_cluster_id) {
+    Record(probe_cluster_id);
+    return true;
+  }
+
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) {
+    Record(probe_cluster_id);
+    return bytes;
+  }
+
+  std::vector<int> cluster_ids_;
+  std::vector<int64_t> send_times_ms_;
+
+ private:
+  void Record(int probe_cluster_id) {
+    cluster_ids_.push_back(probe_cluster_id);
+    send_times_ms_.push_back(clock_->TimeInMilliseconds());
+  }
+
+  Clock* const clock_;
+};
+
 class PacedSenderTest : public ::testing::Test {
  protected:
   PacedSenderTest() : clock_(123456) {
@@ -126,8 +161,8 @@ class PacedSenderTest : public ::testing::Test {
                            bool retransmission) {
     EXPECT_FALSE(send_bucket_->SendPacket(priority, ssrc,
         sequence_number, capture_time_ms, size, retransmission));
-    EXPECT_CALL(callback_,
-                TimeToSendPacket(ssrc, sequence_number, capture_time_ms, false))
+    EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number,
+                                            capture_time_ms, false, _))
         .Times(1)
         .WillRepeatedly(Return(true));
   }
@@ -164,14 +199,15 @@ TEST_F(PacedSenderTest, QueuePacket) {
       sequence_number, queued_packet_timestamp, 250, false));
   send_bucket_->Process();
   EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   clock_.AdvanceTimeMilliseconds(4);
   EXPECT_EQ(1, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(1);
   EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
   EXPECT_CALL(
       callback_,
-      TimeToSendPacket(ssrc, sequence_number++, queued_packet_timestamp, false))
+      TimeToSendPacket(ssrc, sequence_number++, queued_packet_timestamp, false,
+                       _))
       .Times(1)
       .WillRepeatedly(Return(true));
   send_bucket_->Process();
@@ -211,11 +247,11 @@ TEST_F(PacedSenderTest, PaceQueuedPackets) {
         sequence_number++, clock_.TimeInMilliseconds(), 250, false));
   }
   send_bucket_->Process();
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   for (int k = 0; k < 10; ++k) {
     EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
     clock_.AdvanceTimeMilliseconds(5);
-    EXPECT_CALL(callback_, TimeToSendPacket(ssrc, _, _, false))
+    EXPECT_CALL(callback_, TimeToSendPacket(ssrc, _, _, false, _))
         .Times(3)
         .WillRepeatedly(Return(true));
     EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
@@ -271,7 +307,7 @@ TEST_F(PacedSenderTest, PaceQueuedPacketsWithDuplicates) {
     EXPECT_FALSE(send_bucket_->SendPacket(PacedSender::kNormalPriority, ssrc,
         sequence_number++, clock_.TimeInMilliseconds(), 250, false));
   }
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   send_bucket_->Process();
   for (int k = 0; k < 10; ++k) {
     EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
@@ -279,7 +315,7 @@ TEST_F(PacedSenderTest, PaceQueuedPacketsWithDuplicates) {
 
     for (int i = 0; i < 3; ++i) {
       EXPECT_CALL(callback_,
-                  TimeToSendPacket(ssrc, queued_sequence_number++, _, false))
+                  TimeToSendPacket(ssrc, queued_sequence_number++, _, false, _))
           .Times(1)
           .WillRepeatedly(Return(true));
    }
@@ -362,14 +398,14 @@ TEST_F(PacedSenderTest, Padding) {
                       250,
                       false);
   // No padding is expected since we have sent too much already.
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(5);
   EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
   EXPECT_EQ(0, send_bucket_->Process());
 
   // 5 milliseconds later we have enough budget to send some padding.
-  EXPECT_CALL(callback_, TimeToSendPadding(250)).Times(1).
+  EXPECT_CALL(callback_, TimeToSendPadding(250, _)).Times(1).
       WillOnce(Return(250));
   EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(5);
@@ -382,12 +418,12 @@ TEST_F(PacedSenderTest, NoPaddingWhenDisabled) {
   send_bucket_->UpdateBitrate(
       kTargetBitrate, kPaceMultiplier * kTargetBitrate, kTargetBitrate);
   // No padding is expected since the pacer is disabled.
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(5);
   EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
   EXPECT_EQ(0, send_bucket_->Process());
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
   clock_.AdvanceTimeMilliseconds(5);
   EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
@@ -411,7 +447,7 @@ TEST_F(PacedSenderTest, VerifyPaddingUpToBitrate) {
                         250,
                         false);
     clock_.AdvanceTimeMilliseconds(kTimeStep);
-    EXPECT_CALL(callback_, TimeToSendPadding(250)).Times(1).
+    EXPECT_CALL(callback_, TimeToSendPadding(250, _)).Times(1).
         WillOnce(Return(250));
     send_bucket_->Process();
   }
@@ -485,8 +521,8 @@ TEST_F(PacedSenderTest, Priority) {
       ssrc, sequence_number++, capture_time_ms, 250, false));
 
   // Expect all high and normal priority to be sent out first.
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
-  EXPECT_CALL(callback_, TimeToSendPacket(ssrc, _, capture_time_ms, false))
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPacket(ssrc, _, capture_time_ms, false, _))
       .Times(3)
       .WillRepeatedly(Return(true));
 
@@ -497,7 +533,7 @@ TEST_F(PacedSenderTest, Priority) {
 
   EXPECT_CALL(callback_,
               TimeToSendPacket(
-                  ssrc_low_priority, _, capture_time_ms_low_priority, false))
+                  ssrc_low_priority, _, capture_time_ms_low_priority, false, _))
       .Times(1)
       .WillRepeatedly(Return(true));
 
@@ -557,8 +593,8 @@ TEST_F(PacedSenderTest, Pause) {
             send_bucket_->QueueInMs());
 
   // Expect no packet to come out while paused.
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
-  EXPECT_CALL(callback_, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPacket(_, _, _, _, _)).Times(0);
 
   for (int i = 0; i < 10; ++i) {
     clock_.AdvanceTimeMilliseconds(5);
@@ -567,7 +603,7 @@ TEST_F(PacedSenderTest, Pause) {
   }
   // Expect high prio packets to come out first followed by all packets in the
   // way they were added.
-  EXPECT_CALL(callback_, TimeToSendPacket(_, _, capture_time_ms, false))
+  EXPECT_CALL(callback_, TimeToSendPacket(_, _, capture_time_ms, false, _))
       .Times(3)
       .WillRepeatedly(Return(true));
   send_bucket_->Resume();
@@ -577,7 +613,8 @@ TEST_F(PacedSenderTest, Pause) {
   EXPECT_EQ(0, send_bucket_->TimeUntilNextProcess());
   EXPECT_EQ(0, send_bucket_->Process());
 
-  EXPECT_CALL(callback_, TimeToSendPacket(_, _, second_capture_time_ms, false))
+  EXPECT_CALL(callback_,
+              TimeToSendPacket(_, _, second_capture_time_ms, false, _))
       .Times(1)
       .WillRepeatedly(Return(true));
   EXPECT_EQ(5, send_bucket_->TimeUntilNextProcess());
@@ -610,8 +647,8 @@ TEST_F(PacedSenderTest, ResendPacket) {
   EXPECT_EQ(clock_.TimeInMilliseconds() - capture_time_ms,
             send_bucket_->QueueInMs());
   // Fails to send first packet so only one call.
-  EXPECT_CALL(callback_,
-              TimeToSendPacket(ssrc, sequence_number, capture_time_ms, false))
+  EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number,
+                                          capture_time_ms, false, _))
       .Times(1)
       .WillOnce(Return(false));
   clock_.AdvanceTimeMilliseconds(10000);
@@ -622,13 +659,14 @@ TEST_F(PacedSenderTest, ResendPacket) {
             send_bucket_->QueueInMs());
 
   // Fails to send second packet.
-  EXPECT_CALL(callback_,
-              TimeToSendPacket(ssrc, sequence_number, capture_time_ms, false))
+  EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number,
+                                          capture_time_ms, false, _))
       .Times(1)
       .WillOnce(Return(true));
   EXPECT_CALL(
       callback_,
-      TimeToSendPacket(ssrc, sequence_number + 1, capture_time_ms + 1, false))
+      TimeToSendPacket(ssrc, sequence_number + 1, capture_time_ms + 1, false,
+                       _))
       .Times(1)
       .WillOnce(Return(false));
   clock_.AdvanceTimeMilliseconds(10000);
@@ -641,7 +679,8 @@ TEST_F(PacedSenderTest, ResendPacket) {
   // Send second packet and queue becomes empty.
   EXPECT_CALL(
       callback_,
-      TimeToSendPacket(ssrc, sequence_number + 1, capture_time_ms + 1, false))
+      TimeToSendPacket(ssrc, sequence_number + 1, capture_time_ms + 1, false,
+                       _))
       .Times(1)
       .WillOnce(Return(true));
   clock_.AdvanceTimeMilliseconds(10000);
@@ -795,6 +834,55 @@ TEST_F(PacedSenderTest, ProbingWithTooSmallInitialFrame) {
   EXPECT_EQ(kNumPackets, callback.packets_sent());
 }
 
+TEST_F(PacedSenderTest, ProbeClustersOnDemand) {
+  const size_t kPacketSize = 1200;
+  uint32_t ssrc = 12346;
+  uint16_t sequence_number = 1234;
+  PacedSenderProbeClusters callback(&clock_);
+  send_bucket_.reset(new ProbingPacedSender(&clock_, &callback, kTargetBitrate,
+                                            kPaceMultiplier * kTargetBitrate,
+                                            0));
+  // A cluster created before the first packet goes ahead of the initial
+  // probe, which follows as clusters 1 and 2.
+  send_bucket_->CreateProbeCluster(1200000);
+  std::vector<int> expected_ids(PacedSender::kPacketsPerProbeCluster, 0);
+  expected_ids.resize(expected_ids.size() +
+                      PacedSender::kPacketsPerProbeCluster, 1);
+  expected_ids.resize(expected_ids.size() +
+                      PacedSender::kPacketsPerProbeCluster - 1, 2);
+  expected_ids.resize(expected_ids.size() + 2, PacedSender::kNotAProbe);
+  const int kNumPackets = static_cast<int>(expected_ids.size());
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_FALSE(send_bucket_->SendPacket(
+        PacedSender::kNormalPriority, ssrc, sequence_number++,
+        clock_.TimeInMilliseconds(), kPacketSize, false));
+  }
+  while (send_bucket_->QueueSizePackets() > 0) {
+    int time_until_process = send_bucket_->TimeUntilNextProcess();
+    if (time_until_process <= 0) {
+      send_bucket_->Process();
+    } else {
+      clock_.AdvanceTimeMilliseconds(time_until_process);
+    }
+  }
+  // The first probe is sent at 1.2 Mbps, the packets after the probes are
+  // paced out at the target bitrate without being tagged.
+  EXPECT_EQ(expected_ids, callback.cluster_ids_);
+  for (int i = 1; i < PacedSender::kPacketsPerProbeCluster; ++i)
+    EXPECT_EQ(8, callback.send_times_ms_[i] - callback.send_times_ms_[i - 1]);
+
+  // Without media to probe with, the next cluster is made up of padding.
+  clock_.AdvanceTimeMilliseconds(1000);
+  callback.cluster_ids_.clear();
+  send_bucket_->CreateProbeCluster(2400000);
+  for (int i = 0; i < PacedSender::kPacketsPerProbeCluster; ++i) {
+    clock_.AdvanceTimeMilliseconds(send_bucket_->TimeUntilNextProcess());
+    send_bucket_->Process();
+  }
+  EXPECT_EQ(std::vector<int>(PacedSender::kPacketsPerProbeCluster, 3),
+            callback.cluster_ids_);
+}
+
 TEST_F(PacedSenderTest, PriorityInversion) {
   uint32_t ssrc = 12346;
   uint16_t sequence_number = 1234;
@@ -819,18 +907,20 @@ TEST_F(PacedSenderTest, PriorityInversion) {
   // Packets from earlier frames should be sent first.
   {
     ::testing::InSequence sequence;
-    EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number,
-                                            clock_.TimeInMilliseconds(), true))
+    EXPECT_CALL(callback_,
+                TimeToSendPacket(ssrc, sequence_number,
+                                 clock_.TimeInMilliseconds(), true, _))
         .WillOnce(Return(true));
-    EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number + 1,
-                                            clock_.TimeInMilliseconds(), true))
+    EXPECT_CALL(callback_,
+                TimeToSendPacket(ssrc, sequence_number + 1,
+                                 clock_.TimeInMilliseconds(), true, _))
         .WillOnce(Return(true));
     EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number + 3,
                                             clock_.TimeInMilliseconds() + 33,
-                                            true)).WillOnce(Return(true));
+                                            true, _)).WillOnce(Return(true));
     EXPECT_CALL(callback_, TimeToSendPacket(ssrc, sequence_number + 2,
                                             clock_.TimeInMilliseconds() + 33,
-                                            true)).WillOnce(Return(true));
+                                            true, _)).WillOnce(Return(true));
 
     while (send_bucket_->QueueSizePackets() > 0) {
       int time_until_process = send_bucket_->TimeUntilNextProcess();
@@ -864,9 +954,36 @@ TEST_F(PacedSenderTest, PaddingOveruse) {
       clock_.TimeInMilliseconds(), kPacketSize, false));
 
   // Don't send padding if queue is non-empty, even if padding budget > 0.
-  EXPECT_CALL(callback_, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(callback_, TimeToSendPadding(_, _)).Times(0);
   send_bucket_->Process();
 }
 
+TEST_F(PacedSenderTest, DetectsApplicationLimitedRegion) {
+  uint32_t ssrc = 12346;
+  uint16_t sequence_number = 1234;
+  // 60% of the 800 kbps target bitrate.
+  const size_t kPacketSize = 300;
+  EXPECT_CALL(callback_, TimeToSendPacket(_, _, _, _, _))
+      .WillRepeatedly(Return(true));
+  EXPECT_FALSE(send_bucket_->InApplicationLimitedRegion());
+
+  // Nothing is sent during the first second.
+  for (int i = 0; i < 200; ++i) {
+    clock_.AdvanceTimeMilliseconds(5);
+    send_bucket_->Process();
+  }
+  EXPECT_TRUE(send_bucket_->InApplicationLimitedRegion());
+
+  // The region is left once the media uses more than half the bitrate.
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_FALSE(send_bucket_->SendPacket(
+        PacedSender::kNormalPriority, ssrc, sequence_number++,
+        clock_.TimeInMilliseconds(), kPacketSize, false));
+    clock_.AdvanceTimeMilliseconds(5);
+    send_bucket_->Process();
+  }
+  EXPECT_FALSE(send_bucket_->InApplicationLimitedRegion());
+}
+
 }  // namespace test
 }  // namespace webrtc
@@ -13,12 +13,14 @@
 #include "webrtc/base/checks.h"
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp.h"
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
 
 namespace webrtc {
 
 PacketRouter::PacketRouter()
-    : crit_(CriticalSectionWrapper::CreateCriticalSection()) {
+    : crit_(CriticalSectionWrapper::CreateCriticalSection()),
+      transport_seq_(0) {
 }
 
 PacketRouter::~PacketRouter() {
@@ -39,23 +41,45 @@ void PacketRouter::RemoveRtpModule(RtpRtcp* rtp_module) {
 bool PacketRouter::TimeToSendPacket(uint32_t ssrc,
                                     uint16_t sequence_number,
                                     int64_t capture_timestamp,
-                                    bool retransmission) {
+                                    bool retransmission,
+                                    int probe_cluster_id) {
   CriticalSectionScoped cs(crit_.get());
   for (auto* rtp_module : rtp_modules_) {
     if (rtp_module->SendingMedia() && ssrc == rtp_module->SSRC()) {
       return rtp_module->TimeToSendPacket(ssrc, sequence_number,
-                                          capture_timestamp, retransmission);
+                                          capture_timestamp, retransmission,
+                                          probe_cluster_id);
     }
   }
   return true;
 }
 
-size_t PacketRouter::TimeToSendPadding(size_t bytes) {
+size_t PacketRouter::TimeToSendPadding(size_t bytes, int probe_cluster_id) {
   CriticalSectionScoped cs(crit_.get());
   for (auto* rtp_module : rtp_modules_) {
     if (rtp_module->SendingMedia())
-      return rtp_module->TimeToSendPadding(bytes);
+      return rtp_module->TimeToSendPadding(bytes, probe_cluster_id);
   }
   return 0;
 }
+
+void PacketRouter::SetTransportWideSequenceNumber(uint16_t sequence_number) {
+  rtc::AtomicOps::Store(&transport_seq_, sequence_number);
+}
+
+uint16_t PacketRouter::AllocateSequenceNumber() {
+  // Only the low 16 bits are used, so wrapping the int is harmless.
+  return static_cast<uint16_t>(rtc::AtomicOps::Increment(&transport_seq_) - 1);
+}
+
+bool PacketRouter::SendFeedback(rtcp::TransportFeedback* packet) {
+  CriticalSectionScoped cs(crit_.get());
+  for (auto* rtp_module : rtp_modules_) {
+    if (rtp_module->RTCP() == kRtcpOff)
+      continue;
+    packet->WithPacketSenderSsrc(rtp_module->SSRC());
+    return rtp_module->SendFeedbackPacket(*packet);
+  }
+  return false;
+}
 }  // namespace webrtc
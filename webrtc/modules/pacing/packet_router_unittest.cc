@@ -16,6 +16,7 @@
 #include "webrtc/modules/pacing/include/packet_router.h"
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp.h"
 #include "webrtc/modules/rtp_rtcp/mocks/mock_rtp_rtcp.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 #include "webrtc/base/scoped_ptr.h"
 
 using ::testing::_;
@@ -42,17 +43,19 @@ TEST_F(PacketRouterTest, TimeToSendPacket) {
   uint16_t sequence_number = 17;
   uint64_t timestamp = 7890;
   bool retransmission = false;
+  int probe_cluster_id = 2;
 
   // Send on the first module by letting rtp_1 be sending with correct ssrc.
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(true));
   EXPECT_CALL(rtp_1, SSRC()).Times(1).WillOnce(Return(kSsrc1));
   EXPECT_CALL(rtp_1, TimeToSendPacket(kSsrc1, sequence_number, timestamp,
-                                      retransmission))
+                                      retransmission, probe_cluster_id))
       .Times(1)
       .WillOnce(Return(true));
-  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _, _)).Times(0);
   EXPECT_TRUE(packet_router_->TimeToSendPacket(kSsrc1, sequence_number,
-                                               timestamp, retransmission));
+                                               timestamp, retransmission,
+                                               probe_cluster_id));
 
   // Send on the second module by letting rtp_2 be sending, but not rtp_1.
   ++sequence_number;
@@ -62,31 +65,34 @@ TEST_F(PacketRouterTest, TimeToSendPacket) {
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(false));
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(true));
   EXPECT_CALL(rtp_2, SSRC()).Times(1).WillOnce(Return(kSsrc2));
-  EXPECT_CALL(rtp_1, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_1, TimeToSendPacket(_, _, _, _, _)).Times(0);
   EXPECT_CALL(rtp_2, TimeToSendPacket(kSsrc2, sequence_number, timestamp,
-                                      retransmission))
+                                      retransmission, probe_cluster_id))
       .Times(1)
       .WillOnce(Return(true));
   EXPECT_TRUE(packet_router_->TimeToSendPacket(kSsrc2, sequence_number,
-                                               timestamp, retransmission));
+                                               timestamp, retransmission,
+                                               probe_cluster_id));
 
   // No module is sending, hence no packet should be sent.
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(false));
-  EXPECT_CALL(rtp_1, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_1, TimeToSendPacket(_, _, _, _, _)).Times(0);
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(false));
-  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _, _)).Times(0);
   EXPECT_TRUE(packet_router_->TimeToSendPacket(kSsrc1, sequence_number,
-                                               timestamp, retransmission));
+                                               timestamp, retransmission,
+                                               probe_cluster_id));
 
   // Add a packet with incorrect ssrc and test it's dropped in the router.
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(true));
   EXPECT_CALL(rtp_1, SSRC()).Times(1).WillOnce(Return(kSsrc1));
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(true));
   EXPECT_CALL(rtp_2, SSRC()).Times(1).WillOnce(Return(kSsrc2));
-  EXPECT_CALL(rtp_1, TimeToSendPacket(_, _, _, _)).Times(0);
-  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_1, TimeToSendPacket(_, _, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _, _)).Times(0);
   EXPECT_TRUE(packet_router_->TimeToSendPacket(kSsrc1 + kSsrc2, sequence_number,
-                                               timestamp, retransmission));
+                                               timestamp, retransmission,
+                                               probe_cluster_id));
 
   packet_router_->RemoveRtpModule(&rtp_1);
 
@@ -94,9 +100,10 @@ TEST_F(PacketRouterTest, TimeToSendPacket) {
   // it is dropped as expected by not expecting any calls to rtp_1.
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(true));
   EXPECT_CALL(rtp_2, SSRC()).Times(1).WillOnce(Return(kSsrc2));
-  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _)).Times(0);
+  EXPECT_CALL(rtp_2, TimeToSendPacket(_, _, _, _, _)).Times(0);
   EXPECT_TRUE(packet_router_->TimeToSendPacket(kSsrc1, sequence_number,
-                                               timestamp, retransmission));
+                                               timestamp, retransmission,
+                                               probe_cluster_id));
 
   packet_router_->RemoveRtpModule(&rtp_2);
 }
@@ -110,42 +117,94 @@ TEST_F(PacketRouterTest, TimeToSendPadding) {
   // Default configuration, sending padding on the first sending module.
   const size_t requested_padding_bytes = 1000;
   const size_t sent_padding_bytes = 890;
+  const int kProbeClusterId = 3;
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(true));
-  EXPECT_CALL(rtp_1, TimeToSendPadding(requested_padding_bytes))
+  EXPECT_CALL(rtp_1,
+              TimeToSendPadding(requested_padding_bytes, kProbeClusterId))
       .Times(1)
       .WillOnce(Return(sent_padding_bytes));
-  EXPECT_CALL(rtp_2, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(rtp_2, TimeToSendPadding(_, _)).Times(0);
   EXPECT_EQ(sent_padding_bytes,
-            packet_router_->TimeToSendPadding(requested_padding_bytes));
+            packet_router_->TimeToSendPadding(requested_padding_bytes,
+                                              kProbeClusterId));
 
   // Let only the second module be sending and verify the padding request is
   // routed there.
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(false));
-  EXPECT_CALL(rtp_1, TimeToSendPadding(requested_padding_bytes)).Times(0);
+  EXPECT_CALL(rtp_1,
+              TimeToSendPadding(requested_padding_bytes, kProbeClusterId))
+      .Times(0);
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(true));
-  EXPECT_CALL(rtp_2, TimeToSendPadding(_))
+  EXPECT_CALL(rtp_2, TimeToSendPadding(_, _))
       .Times(1)
       .WillOnce(Return(sent_padding_bytes));
   EXPECT_EQ(sent_padding_bytes,
-            packet_router_->TimeToSendPadding(requested_padding_bytes));
+            packet_router_->TimeToSendPadding(requested_padding_bytes,
+                                              kProbeClusterId));
 
   // No sending module at all.
   EXPECT_CALL(rtp_1, SendingMedia()).Times(1).WillOnce(Return(false));
-  EXPECT_CALL(rtp_1, TimeToSendPadding(requested_padding_bytes)).Times(0);
+  EXPECT_CALL(rtp_1,
+              TimeToSendPadding(requested_padding_bytes, kProbeClusterId))
+      .Times(0);
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(false));
-  EXPECT_CALL(rtp_2, TimeToSendPadding(_)).Times(0);
+  EXPECT_CALL(rtp_2, TimeToSendPadding(_, _)).Times(0);
   EXPECT_EQ(static_cast<size_t>(0),
-            packet_router_->TimeToSendPadding(requested_padding_bytes));
+            packet_router_->TimeToSendPadding(requested_padding_bytes,
+                                              kProbeClusterId));
 
   packet_router_->RemoveRtpModule(&rtp_1);
 
   // rtp_1 has been removed, try sending padding and make sure rtp_1 isn't asked
   // to send by not expecting any calls. Instead verify rtp_2 is called.
   EXPECT_CALL(rtp_2, SendingMedia()).Times(1).WillOnce(Return(true));
-  EXPECT_CALL(rtp_2, TimeToSendPadding(requested_padding_bytes)).Times(1);
+  EXPECT_CALL(rtp_2,
+              TimeToSendPadding(requested_padding_bytes, kProbeClusterId))
+      .Times(1);
   EXPECT_EQ(static_cast<size_t>(0),
-            packet_router_->TimeToSendPadding(requested_padding_bytes));
+            packet_router_->TimeToSendPadding(requested_padding_bytes,
+                                              kProbeClusterId));
 
   packet_router_->RemoveRtpModule(&rtp_2);
 }
+
+TEST_F(PacketRouterTest, AllocateSequenceNumbers) {
+  const uint16_t kStartSeq = 0xFFF0;
+  const size_t kNumPackets = 32;
+
+  packet_router_->SetTransportWideSequenceNumber(kStartSeq);
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    uint16_t seq = packet_router_->AllocateSequenceNumber();
+    EXPECT_EQ(static_cast<uint16_t>(kStartSeq + i), seq);
+  }
+}
+
+TEST_F(PacketRouterTest, SendFeedback) {
+  const uint32_t kSsrc = 1234;
+  MockRtpRtcp rtp_1;
+  MockRtpRtcp rtp_2;
+  packet_router_->AddRtpModule(&rtp_1);
+  packet_router_->AddRtpModule(&rtp_2);
+
+  rtcp::TransportFeedback feedback;
+  feedback.WithBase(0, 0);
+
+  // The first module with RTCP enabled sends the feedback.
+  EXPECT_CALL(rtp_1, RTCP()).WillOnce(Return(kRtcpOff));
+  EXPECT_CALL(rtp_1, SendFeedbackPacket(_)).Times(0);
+  EXPECT_CALL(rtp_2, RTCP()).WillOnce(Return(kRtcpCompound));
+  EXPECT_CALL(rtp_2, SSRC()).WillOnce(Return(kSsrc));
+  EXPECT_CALL(rtp_2, SendFeedbackPacket(_)).WillOnce(Return(true));
+  EXPECT_TRUE(packet_router_->SendFeedback(&feedback));
+  EXPECT_EQ(kSsrc, feedback.GetPacketSenderSsrc());
+
+  // No module can send it.
+  EXPECT_CALL(rtp_1, RTCP()).WillOnce(Return(kRtcpOff));
+  EXPECT_CALL(rtp_2, RTCP()).WillOnce(Return(kRtcpOff));
+  EXPECT_CALL(rtp_2, SendFeedbackPacket(_)).Times(0);
+  EXPECT_FALSE(packet_router_->SendFeedback(&feedback));
+
+  packet_router_->RemoveRtpModule(&rtp_1);
+  packet_router_->RemoveRtpModule(&rtp_2);
+}
 }  // namespace webrtc
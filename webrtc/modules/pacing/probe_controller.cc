@@ -0,0 +1,113 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/pacing/include/probe_controller.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "webrtc/modules/pacing/include/paced_sender.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+
+namespace webrtc {
+
+namespace {
+// How often the application limited region is checked.
+const int64_t kProcessIntervalMs = 500;
+}  // namespace
+
+const int ProbeController::kBackoffPercent = 95;
+// 10%, above which SendSideBandwidthEstimation lowers the estimate.
+const uint8_t ProbeController::kBackoffFractionLoss = 26;
+// 2%, below which SendSideBandwidthEstimation increases the estimate.
+const uint8_t ProbeController::kRecoveredFractionLoss = 5;
+const int ProbeController::kRecoveryProbePercent = 85;
+const int64_t ProbeController::kMaxRecoveryTimeMs = 10000;
+const int ProbeController::kAlrProbePercent = 200;
+const int64_t ProbeController::kAlrProbeIntervalMs = 5000;
+
+ProbeController::ProbeController(Clock* clock, PacedSender* pacer)
+    : clock_(clock),
+      pacer_(pacer),
+      crit_sect_(CriticalSectionWrapper::CreateCriticalSection()),
+      estimated_bitrate_bps_(0),
+      bitrate_before_backoff_bps_(0),
+      backoff_time_ms_(0),
+      last_alr_probe_ms_(-1),
+      last_process_time_ms_(clock->TimeInMilliseconds()) {
+}
+
+ProbeController::~ProbeController() {
+}
+
+void ProbeController::OnNetworkChanged(uint32_t bitrate_bps,
+                                       uint8_t fraction_loss) {
+  CriticalSectionScoped cs(crit_sect_.get());
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  if (bitrate_before_backoff_bps_ != 0 &&
+      now_ms - backoff_time_ms_ > kMaxRecoveryTimeMs) {
+    bitrate_before_backoff_bps_ = 0;
+  }
+  if (fraction_loss > kBackoffFractionLoss &&
+      static_cast<int64_t>(bitrate_bps) * 100 <
+          static_cast<int64_t>(estimated_bitrate_bps_) * kBackoffPercent) {
+    // Remember the estimate from before the first of successive backoffs.
+    if (bitrate_before_backoff_bps_ == 0) {
+      bitrate_before_backoff_bps_ = estimated_bitrate_bps_;
+      backoff_time_ms_ = now_ms;
+    }
+  } else if (fraction_loss <= kRecoveredFractionLoss &&
+             bitrate_before_backoff_bps_ != 0) {
+    const int64_t probe_bitrate_bps =
+        static_cast<int64_t>(bitrate_before_backoff_bps_) *
+        kRecoveryProbePercent / 100;
+    bitrate_before_backoff_bps_ = 0;
+    if (probe_bitrate_bps > bitrate_bps) {
+      LOG(LS_INFO) << "Loss cleared, probing at " << probe_bitrate_bps
+                   << " bps.";
+      MaybeProbe(probe_bitrate_bps);
+    }
+  }
+  estimated_bitrate_bps_ = bitrate_bps;
+}
+
+int64_t ProbeController::TimeUntilNextProcess() {
+  CriticalSectionScoped cs(crit_sect_.get());
+  return std::max<int64_t>(
+      last_process_time_ms_ + kProcessIntervalMs - clock_->TimeInMilliseconds(),
+      0);
+}
+
+int32_t ProbeController::Process() {
+  CriticalSectionScoped cs(crit_sect_.get());
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  last_process_time_ms_ = now_ms;
+  if (!pacer_->InApplicationLimitedRegion()) {
+    last_alr_probe_ms_ = -1;
+    return 0;
+  }
+  // Probe right away when entering the region, then periodically.
+  if (last_alr_probe_ms_ == -1 ||
+      now_ms - last_alr_probe_ms_ >= kAlrProbeIntervalMs) {
+    last_alr_probe_ms_ = now_ms;
+    MaybeProbe(static_cast<int64_t>(estimated_bitrate_bps_) *
+               kAlrProbePercent / 100);
+  }
+  return 0;
+}
+
+void ProbeController::MaybeProbe(int64_t bitrate_bps) {
+  if (bitrate_bps > 0 && bitrate_bps <= std::numeric_limits<int>::max())
+    pacer_->CreateProbeCluster(static_cast<int>(bitrate_bps));
+}
+
+}  // namespace webrtc
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/pacing/include/mock/mock_paced_sender.h"
+#include "webrtc/modules/pacing/include/probe_controller.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::_;
+
+namespace webrtc {
+
+class ProbeControllerTest : public ::testing::Test {
+ protected:
+  ProbeControllerTest() : clock_(123456789), controller_(&clock_, &pacer_) {}
+
+  void AdvanceAndProcess(int64_t time_ms) {
+    clock_.AdvanceTimeMilliseconds(time_ms);
+    if (controller_.TimeUntilNextProcess() == 0)
+      controller_.Process();
+  }
+
+  SimulatedClock clock_;
+  NiceMock<MockPacedSender> pacer_;
+  ProbeController controller_;
+};
+
+TEST_F(ProbeControllerTest, ProbesWhenLossClearsAfterBackoff) {
+  EXPECT_CALL(pacer_, CreateProbeCluster(_)).Times(0);
+  controller_.OnNetworkChanged(1000000, 0);
+  controller_.OnNetworkChanged(900000, 60);
+  controller_.OnNetworkChanged(800000, 60);
+  // Still lossy, no probe yet.
+  controller_.OnNetworkChanged(800000, 20);
+  testing::Mock::VerifyAndClearExpectations(&pacer_);
+
+  // Probe below the estimate from before the first backoff, once.
+  EXPECT_CALL(pacer_, CreateProbeCluster(850000)).Times(1);
+  controller_.OnNetworkChanged(800000, 0);
+  controller_.OnNetworkChanged(800000, 0);
+}
+
+TEST_F(ProbeControllerTest, NoProbeForDelayBasedDecrease) {
+  EXPECT_CALL(pacer_, CreateProbeCluster(_)).Times(0);
+  controller_.OnNetworkChanged(1000000, 0);
+  controller_.OnNetworkChanged(500000, 0);
+  controller_.OnNetworkChanged(500000, 0);
+}
+
+TEST_F(ProbeControllerTest, ForgetsBackoffIfLossPersists) {
+  EXPECT_CALL(pacer_, CreateProbeCluster(_)).Times(0);
+  controller_.OnNetworkChanged(1000000, 0);
+  controller_.OnNetworkChanged(800000, 60);
+  clock_.AdvanceTimeMilliseconds(ProbeController::kMaxRecoveryTimeMs + 1);
+  controller_.OnNetworkChanged(300000, 0);
+}
+
+TEST_F(ProbeControllerTest, ProbesPeriodicallyInApplicationLimitedRegion) {
+  controller_.OnNetworkChanged(1000000, 0);
+  EXPECT_CALL(pacer_, InApplicationLimitedRegion())
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(pacer_, CreateProbeCluster(_)).Times(0);
+  for (int i = 0; i < 20; ++i)
+    AdvanceAndProcess(500);
+  testing::Mock::VerifyAndClearExpectations(&pacer_);
+
+  // Probing starts when entering the region, and is repeated while in it.
+  EXPECT_CALL(pacer_, InApplicationLimitedRegion())
+      .WillRepeatedly(Return(true));
+  EXPECT_CALL(pacer_, CreateProbeCluster(2000000)).Times(2);
+  for (int64_t elapsed_ms = 0;
+       elapsed_ms <= ProbeController::kAlrProbeIntervalMs; elapsed_ms += 500) {
+    AdvanceAndProcess(500);
+  }
+}
+
+}  // namespace webrtc
@@ -63,12 +63,14 @@ struct PacketInfo {
              int64_t send_time_ms,
              uint16_t sequence_number,
              size_t payload_size,
-             bool was_paced)
+             bool was_paced,
+             int probe_cluster_id)
       : arrival_time_ms(arrival_time_ms),
         send_time_ms(send_time_ms),
         sequence_number(sequence_number),
         payload_size(payload_size),
-        was_paced(was_paced) {}
+        was_paced(was_paced),
+        probe_cluster_id(probe_cluster_id) {}
   // Time corresponding to when the packet was received. Timestamped with the
   // receiver's clock.
   int64_t arrival_time_ms;
@@ -82,6 +84,8 @@ struct PacketInfo {
   size_t payload_size;
   // True if the packet was paced out by the pacer.
   bool was_paced;
+  // The probe cluster the pacer sent the packet in, or PacedSender::kNotAProbe.
+  int probe_cluster_id;
 };
 
 class RemoteBitrateEstimator : public CallStatsObserver, public Module {
@@ -12,9 +12,12 @@
 
 #include <math.h>
 
+#include <algorithm>
+
 #include "webrtc/base/constructormagic.h"
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/base/thread_annotations.h"
+#include "webrtc/modules/pacing/include/paced_sender.h"
 #include "webrtc/modules/remote_bitrate_estimator/include/remote_bitrate_estimator.h"
 #include "webrtc/system_wrappers/interface/clock.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
@@ -41,10 +44,11 @@ static const double kTimestampToMs = 1000.0 /
 
 // Removes the entries at |index| of |time| and |value|, if time[index] is
 // smaller than or equal to |deadline|. |time| must be sorted ascendingly.
+template <typename TimeContainer, typename ValueContainer>
 static void RemoveStaleEntries(
-    std::vector<int64_t>* time, std::vector<int>* value, int64_t deadline) {
+    TimeContainer* time, ValueContainer* value, int64_t deadline) {
   assert(time->size() == value->size());
-  std::vector<int64_t>::iterator end_of_removal = std::upper_bound(
+  typename TimeContainer::iterator end_of_removal = std::upper_bound(
       time->begin(), time->end(), deadline);
   size_t end_of_removal_index = end_of_removal - time->begin();
 
@@ -53,16 +57,40 @@ static void RemoveStaleEntries(
 }
 
 template<typename K, typename V>
-std::vector<K> Keys(const std::map<K, V>& map) {
+std::vector<K> Keys(const std::vector<std::pair<K, V> >& pairs) {
   std::vector<K> keys;
-  keys.reserve(map.size());
-  for (typename std::map<K, V>::const_iterator it = map.begin();
-      it != map.end(); ++it) {
-    keys.push_back(it->first);
-  }
+  keys.reserve(pairs.size());
+  for (const auto& pair : pairs)
+    keys.push_back(pair.first);
   return keys;
 }
 
+static bool SsrcLess(const std::pair<unsigned int, int64_t>& entry,
+                     unsigned int ssrc) {
+  return entry.first < ssrc;
+}
+
+void RemoteBitrateEstimatorAbsSendTime::ProbeBuffer::push_back(
+    const Probe& probe) {
+  static_assert(kMaxProbes == kMaxProbePackets,
+                "The probe buffer must hold kMaxProbePackets probes");
+  if (size_ == kMaxProbes) {
+    first_ = (first_ + 1) % kMaxProbes;
+    --size_;
+  }
+  probes_[(first_ + size_) % kMaxProbes] = probe;
+  ++size_;
+  ++total_;
+}
+
+void RemoteBitrateEstimatorAbsSendTime::ProbeBuffer::pop_front() {
+  // Dropping probes which have already been overwritten is not supported.
+  assert(size_ == total_ && size_ > 0);
+  first_ = (first_ + 1) % kMaxProbes;
+  --size_;
+  --total_;
+}
+
 bool RemoteBitrateEstimatorAbsSendTime::IsWithinClusterBounds(
     int send_delta_ms,
     const Cluster& cluster_aggregate) {
@@ -74,7 +102,7 @@ bool RemoteBitrateEstimatorAbsSendTime::IsWithinClusterBounds(
   }
 
   void RemoteBitrateEstimatorAbsSendTime::AddCluster(
-      std::list<Cluster>* clusters,
+      std::vector<Cluster>* clusters,
       Cluster* cluster) {
     cluster->send_mean_ms /= static_cast<float>(cluster->count);
     cluster->recv_mean_ms /= static_cast<float>(cluster->count);
@@ -103,49 +131,60 @@ bool RemoteBitrateEstimatorAbsSendTime::IsWithinClusterBounds(
         process_interval_ms_(kProcessIntervalMs),
         total_propagation_delta_ms_(0),
         total_probes_received_(0),
-        first_packet_time_ms_(-1) {
+        first_packet_time_ms_(-1),
+        labeled_cluster_id_(PacedSender::kNotAProbe) {
   assert(observer_);
   assert(clock_);
   LOG(LS_INFO) << "RemoteBitrateEstimatorAbsSendTime: Instantiating.";
 }
 
-void RemoteBitrateEstimatorAbsSendTime::ComputeClusters(
-    std::list<Cluster>* clusters) const {
-  Cluster current;
-  int64_t prev_send_time = -1;
-  int64_t prev_recv_time = -1;
-  for (std::list<Probe>::const_iterator it = probes_.begin();
-       it != probes_.end();
-       ++it) {
-    if (prev_send_time >= 0) {
-      int send_delta_ms = it->send_time_ms - prev_send_time;
-      int recv_delta_ms = it->recv_time_ms - prev_recv_time;
-      if (send_delta_ms >= 1 && recv_delta_ms >= 1) {
-        ++current.num_above_min_delta;
-      }
-      if (!IsWithinClusterBounds(send_delta_ms, current)) {
-        if (current.count >= kMinClusterSize)
-          AddCluster(clusters, &current);
-        current = Cluster();
-      }
-      current.send_mean_ms += send_delta_ms;
-      current.recv_mean_ms += recv_delta_ms;
-      current.mean_size += it->payload_size;
-      ++current.count;
-    }
-    prev_send_time = it->send_time_ms;
-    prev_recv_time = it->recv_time_ms;
+void RemoteBitrateEstimatorAbsSendTime::AddProbe(const Probe& probe) {
+  if (!probes_.empty())
+    UpdateClusters(probes_.back(), probe);
+  probes_.push_back(probe);
+}
+
+void RemoteBitrateEstimatorAbsSendTime::UpdateClusters(const Probe& prev,
+                                                       const Probe& probe) {
+  int send_delta_ms = probe.send_time_ms - prev.send_time_ms;
+  int recv_delta_ms = probe.recv_time_ms - prev.recv_time_ms;
+  if (send_delta_ms >= 1 && recv_delta_ms >= 1) {
+    ++current_cluster_.num_above_min_delta;
   }
-  if (current.count >= kMinClusterSize)
+  if (!IsWithinClusterBounds(send_delta_ms, current_cluster_)) {
+    if (current_cluster_.count >= kMinClusterSize)
+      AddCluster(&completed_clusters_, &current_cluster_);
+    current_cluster_ = Cluster();
+  }
+  current_cluster_.send_mean_ms += send_delta_ms;
+  current_cluster_.recv_mean_ms += recv_delta_ms;
+  current_cluster_.mean_size += probe.payload_size;
+  ++current_cluster_.count;
+}
+
+void RemoteBitrateEstimatorAbsSendTime::RecomputeClusters() {
+  assert(probes_.retained() == probes_.size());
+  completed_clusters_.clear();
+  current_cluster_ = Cluster();
+  for (size_t i = 1; i < probes_.retained(); ++i)
+    UpdateClusters(probes_.at(i - 1), probes_.at(i));
+}
+
+void RemoteBitrateEstimatorAbsSendTime::ComputeClusters(
+    std::vector<Cluster>* clusters) const {
+  *clusters = completed_clusters_;
+  if (current_cluster_.count >= kMinClusterSize) {
+    Cluster current = current_cluster_;
     AddCluster(clusters, &current);
+  }
 }
 
-std::list<Cluster>::const_iterator
+std::vector<Cluster>::const_iterator
 RemoteBitrateEstimatorAbsSendTime::FindBestProbe(
-    const std::list<Cluster>& clusters) const {
+    const std::vector<Cluster>& clusters) const {
   int highest_probe_bitrate_bps = 0;
-  std::list<Cluster>::const_iterator best_it = clusters.end();
-  for (std::list<Cluster>::const_iterator it = clusters.begin();
+  std::vector<Cluster>::const_iterator best_it = clusters.end();
+  for (std::vector<Cluster>::const_iterator it = clusters.begin();
        it != clusters.end();
        ++it) {
     if (it->send_mean_ms == 0 || it->recv_mean_ms == 0)
@@ -174,35 +213,80 @@ RemoteBitrateEstimatorAbsSendTime::FindBestProbe(
 }
 
 void RemoteBitrateEstimatorAbsSendTime::ProcessClusters(int64_t now_ms) {
-  std::list<Cluster> clusters;
+  std::vector<Cluster>& clusters = clusters_;
   ComputeClusters(&clusters);
   if (clusters.empty()) {
     // If we reach the max number of probe packets and still have no clusters,
     // we will remove the oldest one.
-    if (probes_.size() >= kMaxProbePackets)
+    if (probes_.size() >= kMaxProbePackets) {
       probes_.pop_front();
+      RecomputeClusters();
+    }
     return;
   }
 
-  std::list<Cluster>::const_iterator best_it = FindBestProbe(clusters);
-  if (best_it != clusters.end()) {
-    int probe_bitrate_bps =
-        std::min(best_it->GetSendBitrateBps(), best_it->GetRecvBitrateBps());
-    if (IsBitrateImproving(probe_bitrate_bps)) {
-      LOG(LS_INFO) << "Probe successful, sent at "
-                   << best_it->GetSendBitrateBps() << " bps, received at "
-                   << best_it->GetRecvBitrateBps()
-                   << " bps. Mean send delta: " << best_it->send_mean_ms
-                   << " ms, mean recv delta: " << best_it->recv_mean_ms
-                   << " ms, num probes: " << best_it->count;
-      remote_rate_.SetEstimate(probe_bitrate_bps, now_ms);
-    }
-  }
+  std::vector<Cluster>::const_iterator best_it = FindBestProbe(clusters);
+  if (best_it != clusters.end())
+    UpdateEstimateFromProbe(*best_it, now_ms);
 
   // Not probing and received non-probe packet, or finished with current set
   // of probes.
-  if (clusters.size() >= kExpectedNumberOfProbes)
-    probes_.clear();
+  if (clusters.size() >= kExpectedNumberOfProbes) {
+    probes_.Clear();
+    completed_clusters_.clear();
+    current_cluster_ = Cluster();
+  }
+}
+
+void RemoteBitrateEstimatorAbsSendTime::AddLabeledProbe(int probe_cluster_id,
+                                                        const Probe& probe,
+                                                        int64_t now_ms) {
+  if (probe_cluster_id != labeled_cluster_id_) {
+    FinishLabeledCluster(now_ms);
+    labeled_cluster_id_ = probe_cluster_id;
+    last_labeled_probe_ = probe;
+    return;
+  }
+  // Unlike inferred clusters, a labeled cluster is known to have been sent at
+  // a single rate, so every delta belongs to it.
+  int send_delta_ms = probe.send_time_ms - last_labeled_probe_.send_time_ms;
+  int recv_delta_ms = probe.recv_time_ms - last_labeled_probe_.recv_time_ms;
+  if (send_delta_ms >= 1 && recv_delta_ms >= 1)
+    ++labeled_cluster_.num_above_min_delta;
+  labeled_cluster_.send_mean_ms += send_delta_ms;
+  labeled_cluster_.recv_mean_ms += recv_delta_ms;
+  labeled_cluster_.mean_size += probe.payload_size;
+  ++labeled_cluster_.count;
+  last_labeled_probe_ = probe;
+}
+
+void RemoteBitrateEstimatorAbsSendTime::FinishLabeledCluster(int64_t now_ms) {
+  if (labeled_cluster_id_ == PacedSender::kNotAProbe)
+    return;
+  if (labeled_cluster_.count >= kMinClusterSize) {
+    clusters_.clear();
+    AddCluster(&clusters_, &labeled_cluster_);
+    std::vector<Cluster>::const_iterator best_it = FindBestProbe(clusters_);
+    if (best_it != clusters_.end())
+      UpdateEstimateFromProbe(*best_it, now_ms);
+  }
+  labeled_cluster_id_ = PacedSender::kNotAProbe;
+  labeled_cluster_ = Cluster();
+}
+
+void RemoteBitrateEstimatorAbsSendTime::UpdateEstimateFromProbe(
+    const Cluster& cluster,
+    int64_t now_ms) {
+  int probe_bitrate_bps =
+      std::min(cluster.GetSendBitrateBps(), cluster.GetRecvBitrateBps());
+  if (IsBitrateImproving(probe_bitrate_bps)) {
+    LOG(LS_INFO) << "Probe successful, sent at " << cluster.GetSendBitrateBps()
+                 << " bps, received at " << cluster.GetRecvBitrateBps()
+                 << " bps. Mean send delta: " << cluster.send_mean_ms
+                 << " ms, mean recv delta: " << cluster.recv_mean_ms
+                 << " ms, num probes: " << cluster.count;
+    remote_rate_.SetEstimate(probe_bitrate_bps, now_ms);
+  }
 }
 
 bool RemoteBitrateEstimatorAbsSendTime::IsBitrateImproving(
@@ -223,7 +307,8 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketFeedbackVector(
     uint32_t send_time_24bits =
         send_time_32bits >> kAbsSendTimeInterArrivalUpshift;
     IncomingPacketInfo(packet_info.arrival_time_ms, send_time_24bits,
-                       packet_info.payload_size, 0, packet_info.was_paced);
+                       packet_info.payload_size, 0, packet_info.was_paced,
+                       packet_info.probe_cluster_id);
   }
 }
 
@@ -236,7 +321,8 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacket(int64_t arrival_time_ms,
                        "is missing absolute send time extension!";
   }
   IncomingPacketInfo(arrival_time_ms, header.extension.absoluteSendTime,
-                     payload_size, header.ssrc, was_paced);
+                     payload_size, header.ssrc, was_paced,
+                     PacedSender::kNotAProbe);
 }
 
 void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
@@ -244,7 +330,8 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
     uint32_t send_time_24bits,
     size_t payload_size,
     uint32_t ssrc,
-    bool was_paced) {
+    bool was_paced,
+    int probe_cluster_id) {
   assert(send_time_24bits < (1ul << 24));
   // Shift up send time to use the full 32 bits that inter_arrival works with,
   // so wrapping works properly.
@@ -255,7 +342,12 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
   int64_t now_ms = clock_->TimeInMilliseconds();
   // TODO(holmer): SSRCs are only needed for REMB, should be broken out from
   // here.
-  ssrcs_[ssrc] = now_ms;
+  Ssrcs::iterator ssrc_it =
+      std::lower_bound(ssrcs_.begin(), ssrcs_.end(), ssrc, SsrcLess);
+  if (ssrc_it != ssrcs_.end() && ssrc_it->first == ssrc)
+    ssrc_it->second = now_ms;
+  else
+    ssrcs_.insert(ssrc_it, std::make_pair(ssrc, now_ms));
   incoming_bitrate_.Update(payload_size, now_ms);
   const BandwidthUsage prior_state = detector_.State();
 
@@ -265,10 +357,18 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
   uint32_t ts_delta = 0;
   int64_t t_delta = 0;
   int size_delta = 0;
-  // For now only try to detect probes while we don't have a valid estimate.
-  if (was_paced &&
-      (!remote_rate_.ValidEstimate() ||
-       now_ms - first_packet_time_ms_ < kInitialProbingIntervalMs)) {
+  if (probe_cluster_id != PacedSender::kNotAProbe) {
+    // The sender told us which packets are probes, so they can be used at
+    // any time during the call.
+    AddLabeledProbe(probe_cluster_id,
+                    Probe(send_time_ms, arrival_time_ms, payload_size), now_ms);
+  } else if (labeled_cluster_id_ != PacedSender::kNotAProbe) {
+    FinishLabeledCluster(now_ms);
+  } else if (was_paced &&
+             (!remote_rate_.ValidEstimate() ||
+              now_ms - first_packet_time_ms_ < kInitialProbingIntervalMs)) {
+    // Otherwise we have to infer the probes, which for now we only try while
+    // we don't have a valid estimate.
     // TODO(holmer): Use a map instead to get correct order?
     if (total_probes_received_ < kMaxProbePackets) {
       int send_delta_ms = -1;
@@ -282,7 +382,7 @@ void RemoteBitrateEstimatorAbsSendTime::IncomingPacketInfo(
                    << " ms, send delta=" << send_delta_ms
                    << " ms, recv delta=" << recv_delta_ms << " ms.";
     }
-    probes_.push_back(Probe(send_time_ms, arrival_time_ms, payload_size));
+    AddProbe(Probe(send_time_ms, arrival_time_ms, payload_size));
     ++total_probes_received_;
     ProcessClusters(now_ms);
   }
@@ -339,13 +439,12 @@ void RemoteBitrateEstimatorAbsSendTime::UpdateEstimate(int64_t now_ms) {
     // No packets have been received on the active streams.
     return;
   }
-  for (Ssrcs::iterator it = ssrcs_.begin(); it != ssrcs_.end();) {
-    if ((now_ms - it->second) > kStreamTimeOutMs) {
-      ssrcs_.erase(it++);
-    } else {
-      ++it;
-    }
-  }
+  ssrcs_.erase(
+      std::remove_if(ssrcs_.begin(), ssrcs_.end(),
+                     [now_ms](const std::pair<unsigned int, int64_t>& entry) {
+                       return now_ms - entry.second > kStreamTimeOutMs;
+                     }),
+      ssrcs_.end());
   if (ssrcs_.empty()) {
     // We can't update the estimate if we don't have any active streams.
     inter_arrival_.reset();
@@ -373,7 +472,10 @@ void RemoteBitrateEstimatorAbsSendTime::OnRttUpdate(int64_t rtt) {
 
 void RemoteBitrateEstimatorAbsSendTime::RemoveStream(unsigned int ssrc) {
   CriticalSectionScoped cs(crit_sect_.get());
-  ssrcs_.erase(ssrc);
+  Ssrcs::iterator it =
+      std::lower_bound(ssrcs_.begin(), ssrcs_.end(), ssrc, SsrcLess);
+  if (it != ssrcs_.end() && it->first == ssrc)
+    ssrcs_.erase(it);
 }
 
 bool RemoteBitrateEstimatorAbsSendTime::LatestEstimate(
@@ -398,8 +500,11 @@ bool RemoteBitrateEstimatorAbsSendTime::GetStats(
     ReceiveBandwidthEstimatorStats* output) const {
   {
     CriticalSectionScoped cs(crit_sect_.get());
-    output->recent_propagation_time_delta_ms = recent_propagation_delta_ms_;
-    output->recent_arrival_time_ms = recent_update_time_ms_;
+    output->recent_propagation_time_delta_ms.assign(
+        recent_propagation_delta_ms_.begin(),
+        recent_propagation_delta_ms_.end());
+    output->recent_arrival_time_ms.assign(recent_update_time_ms_.begin(),
+                                          recent_update_time_ms_.end());
     output->total_propagation_time_delta_ms = total_propagation_delta_ms_;
   }
   RemoveStaleEntries(
@@ -415,8 +520,8 @@ void RemoteBitrateEstimatorAbsSendTime::UpdateStats(int propagation_delta_ms,
 
   // Remove the oldest entry if the size limit is reached.
   if (recent_update_time_ms_.size() == kPropagationDeltaQueueMaxSize) {
-    recent_update_time_ms_.erase(recent_update_time_ms_.begin());
-    recent_propagation_delta_ms_.erase(recent_propagation_delta_ms_.begin());
+    recent_update_time_ms_.pop_front();
+    recent_propagation_delta_ms_.pop_front();
   }
 
   recent_propagation_delta_ms_.push_back(propagation_delta_ms);
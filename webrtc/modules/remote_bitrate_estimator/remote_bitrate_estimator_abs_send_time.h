@@ -11,8 +11,8 @@
 #ifndef WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_BITRATE_ESTIMATOR_ABS_SEND_TIME_H_
 #define WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_BITRATE_ESTIMATOR_ABS_SEND_TIME_H_
 
-#include <list>
-#include <map>
+#include <deque>
+#include <utility>
 #include <vector>
 
 #include "webrtc/base/checks.h"
@@ -28,6 +28,7 @@
 namespace webrtc {
 
 struct Probe {
+  Probe() : send_time_ms(-1), recv_time_ms(-1), payload_size(0) {}
   Probe(int64_t send_time_ms, int64_t recv_time_ms, size_t payload_size)
       : send_time_ms(send_time_ms),
         recv_time_ms(recv_time_ms),
@@ -90,12 +91,47 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
   bool GetStats(ReceiveBandwidthEstimatorStats* output) const override;
 
  private:
-  typedef std::map<unsigned int, int64_t> Ssrcs;
+  // The SSRCs being received, sorted by SSRC, and the time each was last seen.
+  // A sorted vector keeps per-packet lookups cheap and allocation free for
+  // transports carrying many streams.
+  typedef std::vector<std::pair<unsigned int, int64_t> > Ssrcs;
+
+  // The probes of the current probing attempt. Only the last kMaxProbes
+  // probes are kept, as older ones are never needed again: once a cluster has
+  // been found no probe is dropped until all of them are.
+  class ProbeBuffer {
+   public:
+    static const size_t kMaxProbes = 15;
+
+    ProbeBuffer() : first_(0), size_(0), total_(0) {}
+
+    // The number of probes added since the last Clear().
+    size_t size() const { return total_; }
+    bool empty() const { return total_ == 0; }
+    const Probe& back() const {
+      return probes_[(first_ + size_ - 1) % kMaxProbes];
+    }
+    const Probe& at(size_t index) const {
+      return probes_[(first_ + index) % kMaxProbes];
+    }
+    // The number of probes retained, which is min(size(), kMaxProbes).
+    size_t retained() const { return size_; }
+
+    void push_back(const Probe& probe);
+    void pop_front();
+    void Clear() { first_ = size_ = total_ = 0; }
+
+   private:
+    Probe probes_[kMaxProbes];
+    size_t first_;
+    size_t size_;
+    size_t total_;
+  };
 
   static bool IsWithinClusterBounds(int send_delta_ms,
                                     const Cluster& cluster_aggregate);
 
-  static void AddCluster(std::list<Cluster>* clusters, Cluster* cluster);
+  static void AddCluster(std::vector<Cluster>* clusters, Cluster* cluster);
 
   int Id() const;
 
@@ -103,7 +139,8 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
                           uint32_t send_time_24bits,
                           size_t payload_size,
                           uint32_t ssrc,
-                          bool was_paced);
+                          bool was_paced,
+                          int probe_cluster_id);
 
   bool IsProbe(int64_t send_time_ms, int payload_size) const
       EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
@@ -115,15 +152,39 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
   void UpdateStats(int propagation_delta_ms, int64_t now_ms)
       EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
 
-  void ComputeClusters(std::list<Cluster>* clusters) const;
+  // Adds |probe| to |probes_| and folds it into the clusters.
+  void AddProbe(const Probe& probe) EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
+  // Folds the probe following |prev| into |completed_clusters_| and
+  // |current_cluster_|.
+  void UpdateClusters(const Probe& prev, const Probe& probe)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
+  // Rebuilds the clusters from the retained probes. Only needed when a probe
+  // is dropped, which only happens while there are at most kMaxProbes probes.
+  void RecomputeClusters() EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
+
+  void ComputeClusters(std::vector<Cluster>* clusters) const
+      EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
 
-  std::list<Cluster>::const_iterator FindBestProbe(
-      const std::list<Cluster>& clusters) const
+  std::vector<Cluster>::const_iterator FindBestProbe(
+      const std::vector<Cluster>& clusters) const
       EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
 
   void ProcessClusters(int64_t now_ms)
       EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
 
+  // Adds a probe the sender has labeled with |probe_cluster_id|. Probes of the
+  // same cluster are folded into |labeled_cluster_|, which is evaluated once
+  // the next cluster, or a packet which isn't a probe, arrives.
+  void AddLabeledProbe(int probe_cluster_id, const Probe& probe, int64_t now_ms)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
+  void FinishLabeledCluster(int64_t now_ms)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
+
+  // Sets the estimate to the bitrate probed by |cluster| if it's an
+  // improvement.
+  void UpdateEstimateFromProbe(const Cluster& cluster, int64_t now_ms)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
+
   bool IsBitrateImproving(int probe_bitrate_bps) const
       EXCLUSIVE_LOCKS_REQUIRED(crit_sect_.get());
 
@@ -137,15 +198,28 @@ class RemoteBitrateEstimatorAbsSendTime : public RemoteBitrateEstimator {
   RateStatistics incoming_bitrate_ GUARDED_BY(crit_sect_.get());
   AimdRateControl remote_rate_ GUARDED_BY(crit_sect_.get());
   int64_t last_process_time_;
-  std::vector<int> recent_propagation_delta_ms_ GUARDED_BY(crit_sect_.get());
-  std::vector<int64_t> recent_update_time_ms_ GUARDED_BY(crit_sect_.get());
+  std::deque<int> recent_propagation_delta_ms_ GUARDED_BY(crit_sect_.get());
+  std::deque<int64_t> recent_update_time_ms_ GUARDED_BY(crit_sect_.get());
   int64_t process_interval_ms_ GUARDED_BY(crit_sect_.get());
   int total_propagation_delta_ms_ GUARDED_BY(crit_sect_.get());
 
-  std::list<Probe> probes_;
+  ProbeBuffer probes_ GUARDED_BY(crit_sect_.get());
+  // The clusters of |probes_|, maintained as each probe arrives instead of
+  // being recomputed from all probes. |completed_clusters_| have been averaged
+  // by AddCluster(), while |current_cluster_| still holds sums.
+  std::vector<Cluster> completed_clusters_ GUARDED_BY(crit_sect_.get());
+  Cluster current_cluster_ GUARDED_BY(crit_sect_.get());
+  // Scratch space for ProcessClusters(), kept to avoid reallocating.
+  std::vector<Cluster> clusters_ GUARDED_BY(crit_sect_.get());
   size_t total_probes_received_;
   int64_t first_packet_time_ms_;
 
+  // The probe cluster currently being received, when the sender labels its
+  // probes (see PacketInfo::probe_cluster_id). -1 when there is none.
+  int labeled_cluster_id_ GUARDED_BY(crit_sect_.get());
+  Probe last_labeled_probe_ GUARDED_BY(crit_sect_.get());
+  Cluster labeled_cluster_ GUARDED_BY(crit_sect_.get());
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(RemoteBitrateEstimatorAbsSendTime);
 };
 
@@ -0,0 +1,91 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/modules/remote_bitrate_estimator/remote_bitrate_estimator_abs_send_time.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// An SFU transport receiving 10 Mbps of paced 1000 byte packets spread over
+// many SSRCs, for 10 seconds.
+const int kBitrateBps = 10000000;
+const int kPacketSize = 1000;
+const int kPacketsPerSecond = kBitrateBps / (8 * kPacketSize);
+const int kDurationMs = 10000;
+
+class NullObserver : public RemoteBitrateObserver {
+ public:
+  NullObserver() : num_updates_(0) {}
+  void OnReceiveBitrateChanged(const std::vector<unsigned int>& ssrcs,
+                               unsigned int bitrate) override {
+    ++num_updates_;
+  }
+  int num_updates() const { return num_updates_; }
+
+ private:
+  int num_updates_;
+};
+
+uint32_t AbsSendTime(int64_t t_us) {
+  return static_cast<uint32_t>(((t_us << 18) + 500000) / 1000000) &
+         0x00ffffff;
+}
+
+void RunStreams(int num_ssrcs) {
+  SimulatedClock clock(1000000);
+  NullObserver observer;
+  RemoteBitrateEstimatorAbsSendTime estimator(&observer, &clock, 30000);
+  Clock* real_clock = Clock::GetRealTimeClock();
+  const int64_t interval_us = 1000000 / kPacketsPerSecond;
+  const int num_packets = kDurationMs * kPacketsPerSecond / 1000;
+  RTPHeader header;
+  header.extension.hasAbsoluteSendTime = true;
+  uint32_t random = 17;
+
+  const int64_t start_us = real_clock->TimeInMicroseconds();
+  for (int i = 0; i < num_packets; ++i) {
+    const int64_t send_time_us = i * interval_us;
+    // Up to 1 ms of network jitter.
+    random = random * 1103515245 + 12345;
+    const int64_t arrival_us = send_time_us + 20000 + (random >> 16) % 1000;
+    if (arrival_us / 1000 > clock.TimeInMilliseconds() - 1000000) {
+      clock.AdvanceTimeMilliseconds(arrival_us / 1000 -
+                                    (clock.TimeInMilliseconds() - 1000000));
+    }
+    header.ssrc = 0x10000 + i % num_ssrcs;
+    header.extension.absoluteSendTime = AbsSendTime(send_time_us);
+    estimator.IncomingPacket(clock.TimeInMilliseconds(), kPacketSize, header,
+                             true);
+    if (estimator.TimeUntilNextProcess() <= 0)
+      estimator.Process();
+  }
+  const int64_t elapsed_us = real_clock->TimeInMicroseconds() - start_us;
+  EXPECT_GT(observer.num_updates(), 0);
+
+  test::PrintResult("rbe_abs_send_time_packet_time", "",
+                    rtc::ToString(num_ssrcs) + "_ssrcs",
+                    1000.0 * elapsed_us / num_packets, "ns", true);
+}
+
+}  // namespace
+
+TEST(RemoteBitrateEstimatorAbsSendTimePerfTest, ManySsrcs) {
+  RunStreams(1);
+  RunStreams(16);
+  RunStreams(64);
+}
+
+}  // namespace webrtc
@@ -8,7 +8,10 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <vector>
+
 #include "webrtc/base/constructormagic.h"
+#include "webrtc/modules/pacing/include/paced_sender.h"
 #include "webrtc/modules/remote_bitrate_estimator/remote_bitrate_estimator_abs_send_time.h"
 #include "webrtc/modules/remote_bitrate_estimator/remote_bitrate_estimator_unittest_helper.h"
 
@@ -259,4 +262,102 @@ TEST_F(RemoteBitrateEstimatorAbsSendTimeTest,
   EXPECT_TRUE(bitrate_observer_->updated());
   EXPECT_NEAR(bitrate_observer_->latest_bitrate(), 4000000u, 10000);
 }
+
+// Paced packets which don't form a cluster are dropped once there are
+// kMaxProbePackets of them, and must not affect a later probe.
+TEST_F(RemoteBitrateEstimatorAbsSendTimeTest,
+       TestProbeDetectionAfterDroppedProbes) {
+  int64_t now_ms = clock_.TimeInMilliseconds();
+  // Send deltas alternating between 10 and 20 ms never form a cluster.
+  for (int i = 0; i < 20; ++i) {
+    clock_.AdvanceTimeMilliseconds(i % 2 == 0 ? 10 : 20);
+    now_ms = clock_.TimeInMilliseconds();
+    IncomingPacket(0, 1000, now_ms, 90 * now_ms, AbsSendTime(now_ms, 1000),
+                   true);
+  }
+
+  // Burst sent at 8 * 1000 / 5 = 1600 kbps.
+  for (int i = 0; i < 5; ++i) {
+    clock_.AdvanceTimeMilliseconds(5);
+    now_ms = clock_.TimeInMilliseconds();
+    IncomingPacket(0, 1000, now_ms, 90 * now_ms, AbsSendTime(now_ms, 1000),
+                   true);
+  }
+
+  EXPECT_EQ(0, bitrate_estimator_->Process());
+  EXPECT_TRUE(bitrate_observer_->updated());
+  EXPECT_NEAR(bitrate_observer_->latest_bitrate(), 1600000u, 10000);
+}
+
+// Once a cluster has been found, more than kMaxProbePackets probes may arrive
+// before the probing attempt ends, and later clusters must still be found.
+TEST_F(RemoteBitrateEstimatorAbsSendTimeTest,
+       TestProbeDetectionManyProbesAfterCluster) {
+  int64_t now_ms = clock_.TimeInMilliseconds();
+  // First burst sent at 8 * 1000 / 10 = 800 kbps.
+  for (int i = 0; i < 5; ++i) {
+    clock_.AdvanceTimeMilliseconds(10);
+    now_ms = clock_.TimeInMilliseconds();
+    IncomingPacket(0, 1000, now_ms, 90 * now_ms, AbsSendTime(now_ms, 1000),
+                   true);
+  }
+
+  // Packets which don't form a cluster.
+  for (int i = 0; i < 12; ++i) {
+    clock_.AdvanceTimeMilliseconds(i % 2 == 0 ? 20 : 30);
+    now_ms = clock_.TimeInMilliseconds();
+    IncomingPacket(0, 1000, now_ms, 90 * now_ms, AbsSendTime(now_ms, 1000),
+                   true);
+  }
+
+  // Second burst sent at 8 * 1000 / 5 = 1600 kbps.
+  for (int i = 0; i < 5; ++i) {
+    clock_.AdvanceTimeMilliseconds(5);
+    now_ms = clock_.TimeInMilliseconds();
+    IncomingPacket(0, 1000, now_ms, 90 * now_ms, AbsSendTime(now_ms, 1000),
+                   true);
+  }
+
+  EXPECT_EQ(0, bitrate_estimator_->Process());
+  EXPECT_TRUE(bitrate_observer_->updated());
+  EXPECT_GT(bitrate_observer_->latest_bitrate(), 1500000u);
+}
+
+TEST_F(RemoteBitrateEstimatorAbsSendTimeTest, TestLabeledProbesAfterStartup) {
+  // Establish an estimate well after the initial probing interval, sending
+  // 1000 byte packets at 8 * 1000 / 40 = 200 kbps.
+  uint16_t sequence_number = 0;
+  for (int i = 0; i < 100; ++i) {
+    clock_.AdvanceTimeMilliseconds(40);
+    const int64_t now_ms = clock_.TimeInMilliseconds();
+    bitrate_estimator_->IncomingPacketFeedbackVector(std::vector<PacketInfo>(
+        1, PacketInfo(now_ms, now_ms, sequence_number++, 1000, true,
+                      PacedSender::kNotAProbe)));
+    if (bitrate_estimator_->TimeUntilNextProcess() <= 0)
+      bitrate_estimator_->Process();
+  }
+  ASSERT_TRUE(bitrate_observer_->updated());
+  const unsigned int initial_bitrate = bitrate_observer_->latest_bitrate();
+  ASSERT_LT(initial_bitrate, 1000000u);
+
+  // A cluster sent at 8 * 1000 / 4 = 2000 kbps, followed by regular media.
+  // Since the sender has labeled it, it's used even though it's not at the
+  // start of the call.
+  const int kProbeClusterId = 7;
+  std::vector<PacketInfo> feedback;
+  for (int i = 0; i < 6; ++i) {
+    clock_.AdvanceTimeMilliseconds(4);
+    const int64_t now_ms = clock_.TimeInMilliseconds();
+    feedback.push_back(PacketInfo(now_ms, now_ms, sequence_number++, 1000,
+                                  true, kProbeClusterId));
+  }
+  clock_.AdvanceTimeMilliseconds(40);
+  const int64_t now_ms = clock_.TimeInMilliseconds();
+  feedback.push_back(PacketInfo(now_ms, now_ms, sequence_number++, 1000, true,
+                                PacedSender::kNotAProbe));
+  bitrate_estimator_->IncomingPacketFeedbackVector(feedback);
+  clock_.AdvanceTimeMilliseconds(1000);
+  bitrate_estimator_->Process();
+  EXPECT_GT(bitrate_observer_->latest_bitrate(), 1500000u);
+}
 }  // namespace webrtc
@@ -0,0 +1,142 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/remote_bitrate_estimator/remote_estimator_proxy.h"
+
+#include "webrtc/base/checks.h"
+#include "webrtc/modules/pacing/include/packet_router.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+
+namespace webrtc {
+
+const int RemoteEstimatorProxy::kDefaultProcessIntervalMs = 100;
+const int RemoteEstimatorProxy::kBackWindowPackets = 1 << 14;
+
+RemoteEstimatorProxy::RemoteEstimatorProxy(Clock* clock,
+                                           PacketRouter* packet_router)
+    : clock_(clock),
+      packet_router_(packet_router),
+      last_process_time_ms_(-1),
+      crit_(CriticalSectionWrapper::CreateCriticalSection()),
+      media_ssrc_(0),
+      feedback_sequence_(0),
+      has_packets_(false),
+      last_unwrapped_sequence_(0),
+      window_start_sequence_(0) {
+}
+
+RemoteEstimatorProxy::~RemoteEstimatorProxy() {
+}
+
+void RemoteEstimatorProxy::IncomingPacket(int64_t arrival_time_ms,
+                                          size_t payload_size,
+                                          const RTPHeader& header,
+                                          bool was_paced) {
+  if (!header.extension.hasTransportSequenceNumber) {
+    LOG(LS_WARNING) << "RemoteEstimatorProxy: Incoming packet is missing the "
+                       "transport sequence number extension.";
+    return;
+  }
+  CriticalSectionScoped cs(crit_.get());
+  media_ssrc_ = header.ssrc;
+  OnPacketArrival(header.extension.transportSequenceNumber, arrival_time_ms);
+}
+
+bool RemoteEstimatorProxy::LatestEstimate(std::vector<unsigned int>* ssrcs,
+                                          unsigned int* bitrate_bps) const {
+  return false;
+}
+
+bool RemoteEstimatorProxy::GetStats(
+    ReceiveBandwidthEstimatorStats* output) const {
+  return false;
+}
+
+int64_t RemoteEstimatorProxy::TimeUntilNextProcess() {
+  if (last_process_time_ms_ == -1)
+    return 0;
+  return last_process_time_ms_ + kDefaultProcessIntervalMs -
+         clock_->TimeInMilliseconds();
+}
+
+int32_t RemoteEstimatorProxy::Process() {
+  last_process_time_ms_ = clock_->TimeInMilliseconds();
+  bool more_to_build = true;
+  while (more_to_build) {
+    rtcp::TransportFeedback feedback_packet;
+    {
+      CriticalSectionScoped cs(crit_.get());
+      if (!BuildFeedbackPacket(&feedback_packet))
+        return 0;
+      more_to_build = !packet_arrival_times_.empty();
+    }
+    // Sent without holding the lock, since sending takes the lock of the RTP
+    // modules, which may in turn be delivering packets to us.
+    packet_router_->SendFeedback(&feedback_packet);
+  }
+  return 0;
+}
+
+void RemoteEstimatorProxy::OnPacketArrival(uint16_t sequence_number,
+                                           int64_t arrival_time_ms) {
+  int64_t unwrapped_sequence = sequence_number;
+  if (has_packets_) {
+    const int16_t delta = static_cast<int16_t>(
+        sequence_number - static_cast<uint16_t>(last_unwrapped_sequence_));
+    unwrapped_sequence = last_unwrapped_sequence_ + delta;
+  } else {
+    window_start_sequence_ = unwrapped_sequence;
+    has_packets_ = true;
+  }
+  if (unwrapped_sequence > last_unwrapped_sequence_)
+    last_unwrapped_sequence_ = unwrapped_sequence;
+
+  // Already reported, or so late that the sender has given up on it.
+  if (unwrapped_sequence < window_start_sequence_)
+    return;
+  // Bound the memory used if nobody calls Process().
+  const int64_t oldest_kept = last_unwrapped_sequence_ - kBackWindowPackets;
+  if (window_start_sequence_ < oldest_kept) {
+    window_start_sequence_ = oldest_kept;
+    packet_arrival_times_.erase(packet_arrival_times_.begin(),
+                                packet_arrival_times_.lower_bound(oldest_kept));
+  }
+  // Keep the first arrival of duplicated packets.
+  packet_arrival_times_.insert(
+      std::make_pair(unwrapped_sequence, arrival_time_ms));
+}
+
+bool RemoteEstimatorProxy::BuildFeedbackPacket(
+    rtcp::TransportFeedback* feedback_packet) {
+  if (packet_arrival_times_.empty())
+    return false;
+  auto it = packet_arrival_times_.begin();
+  feedback_packet->WithMediaSourceSsrc(media_ssrc_);
+  feedback_packet->WithFeedbackSequenceNumber(feedback_sequence_++);
+  feedback_packet->WithBase(static_cast<uint16_t>(it->first),
+                            it->second * 1000);
+  for (; it != packet_arrival_times_.end(); ++it) {
+    if (!feedback_packet->WithReceivedPacket(static_cast<uint16_t>(it->first),
+                                             it->second * 1000)) {
+      // The packet is full, or the arrival time jumped too far; the rest goes
+      // into the next packet.
+      break;
+    }
+    window_start_sequence_ = it->first + 1;
+  }
+  DCHECK(it != packet_arrival_times_.begin());
+  packet_arrival_times_.erase(packet_arrival_times_.begin(), it);
+  return true;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_ESTIMATOR_PROXY_H_
+#define WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_ESTIMATOR_PROXY_H_
+
+#include <map>
+#include <vector>
+
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/thread_annotations.h"
+#include "webrtc/modules/remote_bitrate_estimator/include/remote_bitrate_estimator.h"
+
+namespace webrtc {
+
+class Clock;
+class CriticalSectionWrapper;
+class PacketRouter;
+namespace rtcp {
+class TransportFeedback;
+}  // namespace rtcp
+
+// Receive side of the send-side bandwidth estimation. Rather than estimating
+// the bandwidth itself, it records the arrival time of every packet carrying
+// a transport-wide sequence number, and periodically reports them back to the
+// sender in RTCP transport feedback packets sent through |packet_router|.
+class RemoteEstimatorProxy : public RemoteBitrateEstimator {
+ public:
+  RemoteEstimatorProxy(Clock* clock, PacketRouter* packet_router);
+  virtual ~RemoteEstimatorProxy();
+
+  void IncomingPacket(int64_t arrival_time_ms,
+                      size_t payload_size,
+                      const RTPHeader& header,
+                      bool was_paced) override;
+  void RemoveStream(unsigned int ssrc) override {}
+  bool LatestEstimate(std::vector<unsigned int>* ssrcs,
+                      unsigned int* bitrate_bps) const override;
+  bool GetStats(ReceiveBandwidthEstimatorStats* output) const override;
+  void OnRttUpdate(int64_t rtt_ms) override {}
+  int64_t TimeUntilNextProcess() override;
+  int32_t Process() override;
+
+  static const int kDefaultProcessIntervalMs;
+  // Arrivals this far behind the newest one are no longer reported.
+  static const int kBackWindowPackets;
+
+ private:
+  void OnPacketArrival(uint16_t sequence_number, int64_t arrival_time_ms)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_.get());
+  // Fills |feedback_packet| with as many pending arrivals as fit, and removes
+  // them. Returns false if there was nothing to report.
+  bool BuildFeedbackPacket(rtcp::TransportFeedback* feedback_packet)
+      EXCLUSIVE_LOCKS_REQUIRED(crit_.get());
+
+  Clock* const clock_;
+  PacketRouter* const packet_router_;
+  int64_t last_process_time_ms_;
+
+  const rtc::scoped_ptr<CriticalSectionWrapper> crit_;
+  uint32_t media_ssrc_ GUARDED_BY(crit_.get());
+  uint8_t feedback_sequence_ GUARDED_BY(crit_.get());
+  // Sequence numbers are unwrapped to 64 bits, relative to the first one.
+  bool has_packets_ GUARDED_BY(crit_.get());
+  int64_t last_unwrapped_sequence_ GUARDED_BY(crit_.get());
+  // The first sequence number not yet reported.
+  int64_t window_start_sequence_ GUARDED_BY(crit_.get());
+  // Unwrapped sequence number -> arrival time in ms, not yet reported.
+  std::map<int64_t, int64_t> packet_arrival_times_ GUARDED_BY(crit_.get());
+
+  DISALLOW_COPY_AND_ASSIGN(RemoteEstimatorProxy);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_REMOTE_ESTIMATOR_PROXY_H_
@@ -0,0 +1,162 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/pacing/include/packet_router.h"
+#include "webrtc/modules/remote_bitrate_estimator/remote_estimator_proxy.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+
+namespace webrtc {
+namespace {
+
+const uint32_t kMediaSsrc = 456;
+const size_t kPayloadSize = 100;
+
+typedef rtcp::TransportFeedback::StatusSymbol StatusSymbol;
+
+// Keeps a parsed copy of each feedback packet sent.
+class FeedbackRecorder : public PacketRouter {
+ public:
+  bool SendFeedback(rtcp::TransportFeedback* packet) override {
+    rtc::scoped_ptr<rtcp::RawPacket> raw_packet(packet->Build());
+    rtc::scoped_ptr<rtcp::TransportFeedback> parsed(
+        rtcp::TransportFeedback::ParseFrom(raw_packet->Buffer(),
+                                           raw_packet->Length()));
+    EXPECT_TRUE(parsed.get() != nullptr);
+    if (parsed.get() == nullptr)
+      return false;
+    feedback_packets_.push_back(parsed.release());
+    return true;
+  }
+
+  ~FeedbackRecorder() {
+    for (rtcp::TransportFeedback* packet : feedback_packets_)
+      delete packet;
+  }
+
+  std::vector<rtcp::TransportFeedback*> feedback_packets_;
+};
+
+class RemoteEstimatorProxyTest : public ::testing::Test {
+ public:
+  RemoteEstimatorProxyTest() : clock_(0), proxy_(&clock_, &router_) {}
+
+ protected:
+  void IncomingPacket(uint16_t sequence_number, int64_t arrival_time_ms) {
+    RTPHeader header;
+    header.ssrc = kMediaSsrc;
+    header.extension.hasTransportSequenceNumber = true;
+    header.extension.transportSequenceNumber = sequence_number;
+    proxy_.IncomingPacket(arrival_time_ms, kPayloadSize, header, true);
+  }
+
+  void Process() {
+    clock_.AdvanceTimeMilliseconds(
+        RemoteEstimatorProxy::kDefaultProcessIntervalMs);
+    EXPECT_LE(proxy_.TimeUntilNextProcess(), 0);
+    proxy_.Process();
+  }
+
+  // Returns the arrival times in ms of the received packets.
+  static std::vector<int64_t> ArrivalTimesMs(
+      const rtcp::TransportFeedback& feedback) {
+    std::vector<int64_t> times;
+    int64_t time_us = feedback.GetBaseTimeUs();
+    for (int64_t delta_us : feedback.GetReceiveDeltasUs()) {
+      time_us += delta_us;
+      times.push_back(time_us / 1000);
+    }
+    return times;
+  }
+
+  SimulatedClock clock_;
+  FeedbackRecorder router_;
+  RemoteEstimatorProxy proxy_;
+};
+
+TEST_F(RemoteEstimatorProxyTest, SendsSinglePacketFeedback) {
+  IncomingPacket(10, 1000);
+  IncomingPacket(11, 1005);
+  IncomingPacket(13, 1012);
+  Process();
+
+  ASSERT_EQ(1u, router_.feedback_packets_.size());
+  const rtcp::TransportFeedback& feedback = *router_.feedback_packets_[0];
+  EXPECT_EQ(kMediaSsrc, feedback.GetMediaSourceSsrc());
+  EXPECT_EQ(10u, feedback.GetBaseSequence());
+  const StatusSymbol kExpected[] = {StatusSymbol::kReceivedSmallDelta,
+                                    StatusSymbol::kReceivedSmallDelta,
+                                    StatusSymbol::kNotReceived,
+                                    StatusSymbol::kReceivedSmallDelta};
+  EXPECT_EQ(std::vector<StatusSymbol>(kExpected, kExpected + 4),
+            feedback.GetStatusVector());
+  const int64_t kExpectedTimes[] = {1000, 1005, 1012};
+  EXPECT_EQ(std::vector<int64_t>(kExpectedTimes, kExpectedTimes + 3),
+            ArrivalTimesMs(feedback));
+
+  // Nothing new to report.
+  Process();
+  EXPECT_EQ(1u, router_.feedback_packets_.size());
+}
+
+TEST_F(RemoteEstimatorProxyTest, HandlesReorderingDuplicatesAndWrapAround) {
+  IncomingPacket(0xfffe, 1000);
+  IncomingPacket(0, 1002);
+  IncomingPacket(0xffff, 1003);
+  IncomingPacket(0xffff, 1004);
+  Process();
+
+  ASSERT_EQ(1u, router_.feedback_packets_.size());
+  const rtcp::TransportFeedback& feedback = *router_.feedback_packets_[0];
+  EXPECT_EQ(0xfffeu, feedback.GetBaseSequence());
+  EXPECT_EQ(3u, feedback.GetStatusVector().size());
+  // The first arrival of the duplicated packet is kept.
+  const int64_t kExpectedTimes[] = {1000, 1003, 1002};
+  EXPECT_EQ(std::vector<int64_t>(kExpectedTimes, kExpectedTimes + 3),
+            ArrivalTimesMs(feedback));
+
+  // Late arrivals of packets already reported as missing are dropped.
+  IncomingPacket(0xfffd, 1010);
+  IncomingPacket(1, 1011);
+  Process();
+  ASSERT_EQ(2u, router_.feedback_packets_.size());
+  EXPECT_EQ(1u, router_.feedback_packets_[1]->GetBaseSequence());
+  EXPECT_EQ(1u, router_.feedback_packets_[1]->GetStatusVector().size());
+}
+
+TEST_F(RemoteEstimatorProxyTest, SplitsFeedbackOnLargeTimeGap) {
+  IncomingPacket(1, 1000);
+  // Too far apart for a receive delta.
+  IncomingPacket(2, 1000 + 10000);
+  Process();
+
+  ASSERT_EQ(2u, router_.feedback_packets_.size());
+  EXPECT_EQ(1u, router_.feedback_packets_[0]->GetBaseSequence());
+  EXPECT_EQ(2u, router_.feedback_packets_[1]->GetBaseSequence());
+  EXPECT_EQ(static_cast<uint8_t>(
+                router_.feedback_packets_[0]->GetFeedbackSequenceNumber() + 1),
+            router_.feedback_packets_[1]->GetFeedbackSequenceNumber());
+  EXPECT_EQ(std::vector<int64_t>(1, 11000),
+            ArrivalTimesMs(*router_.feedback_packets_[1]));
+}
+
+TEST_F(RemoteEstimatorProxyTest, IgnoresPacketsWithoutSequenceNumber) {
+  RTPHeader header;
+  header.ssrc = kMediaSsrc;
+  proxy_.IncomingPacket(1000, kPayloadSize, header, true);
+  Process();
+  EXPECT_TRUE(router_.feedback_packets_.empty());
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -190,9 +190,10 @@ SendSideBweFeedback::SendSideBweFeedback(
     int flow_id,
     int64_t send_time_us,
     int64_t last_send_time_ms,
-    const std::vector<PacketInfo>& packet_feedback_vector)
+    rtc::scoped_ptr<rtcp::TransportFeedback> feedback)
     : FeedbackPacket(flow_id, send_time_us, last_send_time_ms),
-      packet_feedback_vector_(packet_feedback_vector) {
+      transport_feedback_(feedback.Pass()) {
+  assert(transport_feedback_.get() != nullptr);
 }
 
 bool IsTimeSorted(const Packets& packets) {
@@ -10,9 +10,11 @@
 
 #include "webrtc/modules/remote_bitrate_estimator/test/estimators/send_side.h"
 
-#include "webrtc/base/logging.h"
-#include "webrtc/modules/remote_bitrate_estimator/remote_bitrate_estimator_abs_send_time.h"
+#include <algorithm>
+
+#include "webrtc/modules/pacing/include/paced_sender.h"
 #include "webrtc/modules/remote_bitrate_estimator/test/bwe_test_logging.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 
 namespace webrtc {
 namespace testing {
@@ -23,12 +25,11 @@ const int kFeedbackIntervalMs = 50;
 FullBweSender::FullBweSender(int kbps, BitrateObserver* observer, Clock* clock)
     : bitrate_controller_(
           BitrateController::CreateBitrateController(clock, observer)),
-      rbe_(new RemoteBitrateEstimatorAbsSendTime(this,
-                                                 clock,
-                                                 1000 * kMinBitrateKbps)),
       feedback_observer_(bitrate_controller_->CreateRtcpBandwidthObserver()),
+      feedback_adapter_(new TransportFeedbackAdapter(feedback_observer_.get(),
+                                                     clock,
+                                                     1000 * kMinBitrateKbps)),
       clock_(clock),
-      send_time_history_(10000),
       has_received_ack_(false),
       last_acked_seq_num_(0) {
   assert(kbps >= kMinBitrateKbps);
@@ -46,36 +47,39 @@ int FullBweSender::GetFeedbackIntervalMs() const {
 }
 
 void FullBweSender::GiveFeedback(const FeedbackPacket& feedback) {
-  const SendSideBweFeedback& fb =
-      static_cast<const SendSideBweFeedback&>(feedback);
-  if (fb.packet_feedback_vector().empty())
-    return;
-  // TODO(sprang): Unconstify PacketInfo so we don't need temp copy?
-  std::vector<PacketInfo> packet_feedback_vector(fb.packet_feedback_vector());
-  for (PacketInfo& packet : packet_feedback_vector) {
-    if (!send_time_history_.GetSendTime(packet.sequence_number,
-                                        &packet.send_time_ms, true)) {
-      LOG(LS_WARNING) << "Ack arrived too late.";
-    }
-  }
+  const rtcp::TransportFeedback& transport_feedback =
+      static_cast<const SendSideBweFeedback&>(feedback).transport_feedback();
 
   int64_t rtt_ms =
       clock_->TimeInMilliseconds() - feedback.latest_send_time_ms();
-  rbe_->OnRttUpdate(rtt_ms);
+  feedback_adapter_->OnRttUpdate(rtt_ms);
   BWE_TEST_LOGGING_PLOT(1, "RTT", clock_->TimeInMilliseconds(), rtt_ms);
 
-  rbe_->IncomingPacketFeedbackVector(packet_feedback_vector);
+  feedback_adapter_->OnTransportFeedback(transport_feedback);
+
+  // Find the newest packet received, and how many were.
+  int received_packets = 0;
+  uint16_t last_received_seq_num = 0;
+  uint16_t sequence_number = transport_feedback.GetBaseSequence();
+  for (const auto symbol : transport_feedback.GetStatusVector()) {
+    if (symbol != rtcp::TransportFeedback::StatusSymbol::kNotReceived) {
+      ++received_packets;
+      last_received_seq_num = sequence_number;
+    }
+    ++sequence_number;
+  }
+  if (received_packets == 0)
+    return;
+
   if (has_received_ack_) {
-    int expected_packets = fb.packet_feedback_vector().back().sequence_number -
-                           last_acked_seq_num_;
+    int expected_packets = static_cast<uint16_t>(last_received_seq_num -
+                                                 last_acked_seq_num_);
     // Assuming no reordering for now.
     if (expected_packets > 0) {
-      int lost_packets = expected_packets -
-                         static_cast<int>(fb.packet_feedback_vector().size());
+      int lost_packets = expected_packets - received_packets;
       report_block_.fractionLost = (lost_packets << 8) / expected_packets;
       report_block_.cumulativeLost += lost_packets;
-      report_block_.extendedHighSeqNum =
-          packet_feedback_vector.back().sequence_number;
+      report_block_.extendedHighSeqNum = last_received_seq_num;
       ReportBlockList report_blocks;
       report_blocks.push_back(report_block_);
       feedback_observer_->OnReceivedRtcpReceiverReport(
@@ -83,10 +87,10 @@ void FullBweSender::GiveFeedback(const FeedbackPacket& feedback) {
     }
     bitrate_controller_->Process();
 
-    last_acked_seq_num_ = LatestSequenceNumber(
-        packet_feedback_vector.back().sequence_number, last_acked_seq_num_);
+    last_acked_seq_num_ =
+        LatestSequenceNumber(last_received_seq_num, last_acked_seq_num_);
   } else {
-    last_acked_seq_num_ = packet_feedback_vector.back().sequence_number;
+    last_acked_seq_num_ = last_received_seq_num;
     has_received_ack_ = true;
   }
 }
@@ -95,30 +99,28 @@ void FullBweSender::OnPacketsSent(const Packets& packets) {
   for (Packet* packet : packets) {
     if (packet->GetPacketType() == Packet::kMedia) {
       MediaPacket* media_packet = static_cast<MediaPacket*>(packet);
-      send_time_history_.AddAndRemoveOldSendTimes(
-          media_packet->header().sequenceNumber,
-          media_packet->GetAbsSendTimeInMs());
+      feedback_adapter_->OnSentPacket(media_packet->header().sequenceNumber,
+                                      media_packet->GetAbsSendTimeInMs(),
+                                      media_packet->payload_size(),
+                                      PacedSender::kNotAProbe);
     }
   }
 }
 
-void FullBweSender::OnReceiveBitrateChanged(
-    const std::vector<unsigned int>& ssrcs,
-    unsigned int bitrate) {
-  feedback_observer_->OnReceivedEstimatedBitrate(bitrate);
-}
-
 int64_t FullBweSender::TimeUntilNextProcess() {
   return bitrate_controller_->TimeUntilNextProcess();
 }
 
 int FullBweSender::Process() {
-  rbe_->Process();
+  feedback_adapter_->Process();
   return bitrate_controller_->Process();
 }
 
 SendSideBweReceiver::SendSideBweReceiver(int flow_id)
-    : BweReceiver(flow_id), last_feedback_ms_(0) {
+    : BweReceiver(flow_id),
+      last_feedback_ms_(0),
+      last_arrival_send_time_ms_(0),
+      last_arrival_time_ms_(0) {
 }
 
 SendSideBweReceiver::~SendSideBweReceiver() {
@@ -126,9 +128,10 @@ SendSideBweReceiver::~SendSideBweReceiver() {
 
 void SendSideBweReceiver::ReceivePacket(int64_t arrival_time_ms,
                                         const MediaPacket& media_packet) {
-  packet_feedback_vector_.push_back(PacketInfo(
-      arrival_time_ms, media_packet.sender_timestamp_us() / 1000,
-      media_packet.header().sequenceNumber, media_packet.payload_size(), true));
+  arrivals_.push_back(
+      std::make_pair(media_packet.header().sequenceNumber, arrival_time_ms));
+  last_arrival_send_time_ms_ = media_packet.sender_timestamp_us() / 1000;
+  last_arrival_time_ms_ = arrival_time_ms;
 
   received_packets_.Insert(media_packet.sequence_number(),
                            media_packet.send_time_ms(), arrival_time_ms,
@@ -136,16 +139,41 @@ void SendSideBweReceiver::ReceivePacket(int64_t arrival_time_ms,
 }
 
 FeedbackPacket* SendSideBweReceiver::GetFeedback(int64_t now_ms) {
-  if (now_ms - last_feedback_ms_ < kFeedbackIntervalMs)
+  if (now_ms - last_feedback_ms_ < kFeedbackIntervalMs || arrivals_.empty())
     return NULL;
   last_feedback_ms_ = now_ms;
+
+  // Sequence numbers must be added in increasing order.
+  const uint16_t base_sequence = arrivals_.front().first;
+  std::sort(arrivals_.begin(), arrivals_.end(),
+            [base_sequence](const std::pair<uint16_t, int64_t>& a,
+                            const std::pair<uint16_t, int64_t>& b) {
+              return static_cast<uint16_t>(a.first - base_sequence) <
+                     static_cast<uint16_t>(b.first - base_sequence);
+            });
+  rtcp::TransportFeedback feedback;
+  feedback.WithMediaSourceSsrc(flow_id_);
+  feedback.WithBase(arrivals_.front().first, arrivals_.front().second * 1000);
+  auto it = arrivals_.begin();
+  for (; it != arrivals_.end(); ++it) {
+    if (!feedback.WithReceivedPacket(it->first, it->second * 1000) &&
+        IsNewerSequenceNumber(it->first, (it - 1)->first)) {
+      // Full; the remaining arrivals go into the next feedback.
+      break;
+    }
+  }
+  arrivals_.erase(arrivals_.begin(), it);
+
+  rtc::scoped_ptr<rtcp::RawPacket> raw_packet(feedback.Build());
+  rtc::scoped_ptr<rtcp::TransportFeedback> parsed(
+      rtcp::TransportFeedback::ParseFrom(raw_packet->Buffer(),
+                                         raw_packet->Length()));
+  assert(parsed.get() != nullptr);
+
   int64_t corrected_send_time_ms =
-      packet_feedback_vector_.back().send_time_ms + now_ms -
-      packet_feedback_vector_.back().arrival_time_ms;
-  FeedbackPacket* fb = new SendSideBweFeedback(
-      flow_id_, now_ms * 1000, corrected_send_time_ms, packet_feedback_vector_);
-  packet_feedback_vector_.clear();
-  return fb;
+      last_arrival_send_time_ms_ + now_ms - last_arrival_time_ms_;
+  return new SendSideBweFeedback(flow_id_, now_ms * 1000,
+                                 corrected_send_time_ms, parsed.Pass());
 }
 
 }  // namespace bwe
@@ -11,16 +11,20 @@
 #ifndef WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_TEST_ESTIMATORS_SEND_SIDE_H_
 #define WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_TEST_ESTIMATORS_SEND_SIDE_H_
 
+#include <utility>
 #include <vector>
 
-#include "webrtc/modules/bitrate_controller/send_time_history.h"
 #include "webrtc/modules/remote_bitrate_estimator/test/bwe.h"
+#include "webrtc/modules/remote_bitrate_estimator/transport_feedback_adapter.h"
 
 namespace webrtc {
 namespace testing {
 namespace bwe {
 
-class FullBweSender : public BweSender, public RemoteBitrateObserver {
+// Runs the real send-side pipeline: transport feedback packets are joined
+// with the send times by a TransportFeedbackAdapter, whose delay based
+// estimate bounds the loss based one of the BitrateController.
+class FullBweSender : public BweSender {
  public:
   FullBweSender(int kbps, BitrateObserver* observer, Clock* clock);
   virtual ~FullBweSender();
@@ -28,26 +32,25 @@ class FullBweSender : public BweSender, public RemoteBitrateObserver {
   int GetFeedbackIntervalMs() const override;
   void GiveFeedback(const FeedbackPacket& feedback) override;
   void OnPacketsSent(const Packets& packets) override;
-  void OnReceiveBitrateChanged(const std::vector<unsigned int>& ssrcs,
-                               unsigned int bitrate) override;
   int64_t TimeUntilNextProcess() override;
   int Process() override;
 
  protected:
   rtc::scoped_ptr<BitrateController> bitrate_controller_;
-  rtc::scoped_ptr<RemoteBitrateEstimator> rbe_;
   rtc::scoped_ptr<RtcpBandwidthObserver> feedback_observer_;
+  rtc::scoped_ptr<TransportFeedbackAdapter> feedback_adapter_;
 
  private:
   Clock* const clock_;
   RTCPReportBlock report_block_;
-  SendTimeHistory send_time_history_;
   bool has_received_ack_;
   uint16_t last_acked_seq_num_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(FullBweSender);
 };
 
+// Reports the arrival times of the received packets in RTCP transport
+// feedback packets, which go through a build and parse round trip.
 class SendSideBweReceiver : public BweReceiver {
  public:
   explicit SendSideBweReceiver(int flow_id);
@@ -59,7 +62,10 @@ class SendSideBweReceiver : public BweReceiver {
 
  private:
   int64_t last_feedback_ms_;
-  std::vector<PacketInfo> packet_feedback_vector_;
+  // Arrivals not yet reported, as (transport sequence number, arrival time).
+  std::vector<std::pair<uint16_t, int64_t>> arrivals_;
+  int64_t last_arrival_send_time_ms_;
+  int64_t last_arrival_time_ms_;
 };
 
 }  // namespace bwe
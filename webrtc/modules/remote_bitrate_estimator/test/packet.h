@@ -15,9 +15,11 @@
 #include <map>
 #include <vector>
 
+#include "webrtc/base/scoped_ptr.h"
 #include "webrtc/common_types.h"
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"
 #include "webrtc/modules/remote_bitrate_estimator/include/remote_bitrate_estimator.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 
 namespace webrtc {
 namespace testing {
@@ -119,21 +121,21 @@ class RembFeedback : public FeedbackPacket {
   const RTCPReportBlock report_block_;
 };
 
+// Carries an RTCP transport feedback packet, as parsed from the wire.
 class SendSideBweFeedback : public FeedbackPacket {
  public:
-  typedef std::map<uint16_t, int64_t> ArrivalTimesMap;
   SendSideBweFeedback(int flow_id,
                       int64_t send_time_us,
                       int64_t latest_send_time_ms,
-                      const std::vector<PacketInfo>& packet_feedback_vector);
+                      rtc::scoped_ptr<rtcp::TransportFeedback> feedback);
   virtual ~SendSideBweFeedback() {}
 
-  const std::vector<PacketInfo>& packet_feedback_vector() const {
-    return packet_feedback_vector_;
+  const rtcp::TransportFeedback& transport_feedback() const {
+    return *transport_feedback_;
   }
 
  private:
-  const std::vector<PacketInfo> packet_feedback_vector_;
+  const rtc::scoped_ptr<rtcp::TransportFeedback> transport_feedback_;
 };
 
 class NadaFeedback : public FeedbackPacket {
@@ -90,8 +90,9 @@ class PacedVideoSender : public VideoSender, public PacedSender::Callback {
   bool TimeToSendPacket(uint32_t ssrc,
                         uint16_t sequence_number,
                         int64_t capture_time_ms,
-                        bool retransmission) override;
-  size_t TimeToSendPadding(size_t bytes) override;
+                        bool retransmission,
+                        int probe_cluster_id) override;
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) override;
 
   // Implements BitrateObserver.
   void OnNetworkChanged(uint32_t target_bitrate_bps,
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/remote_bitrate_estimator/transport_feedback_adapter.h"
+
+#include "webrtc/base/checks.h"
+#include "webrtc/modules/remote_bitrate_estimator/remote_bitrate_estimator_abs_send_time.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+#include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+
+namespace webrtc {
+
+const int64_t TransportFeedbackAdapter::kSendTimeHistoryWindowMs = 10000;
+
+TransportFeedbackAdapter::TransportFeedbackAdapter(
+    RtcpBandwidthObserver* bandwidth_observer,
+    Clock* clock,
+    uint32_t min_bitrate_bps)
+    : bandwidth_observer_(bandwidth_observer),
+      crit_(CriticalSectionWrapper::CreateCriticalSection()),
+      send_time_history_(kSendTimeHistoryWindowMs),
+      bitrate_estimator_(
+          new RemoteBitrateEstimatorAbsSendTime(this, clock, min_bitrate_bps)) {
+  DCHECK(bandwidth_observer_ != nullptr);
+}
+
+TransportFeedbackAdapter::~TransportFeedbackAdapter() {
+}
+
+void TransportFeedbackAdapter::OnSentPacket(uint16_t sequence_number,
+                                            int64_t send_time_ms,
+                                            size_t payload_size,
+                                            int probe_cluster_id) {
+  CriticalSectionScoped cs(crit_.get());
+  send_time_history_.AddAndRemoveOld(sequence_number, send_time_ms,
+                                     payload_size, probe_cluster_id);
+}
+
+void TransportFeedbackAdapter::OnTransportFeedback(
+    const rtcp::TransportFeedback& feedback) {
+  const std::vector<rtcp::TransportFeedback::StatusSymbol>& status_vector =
+      feedback.GetStatusVector();
+  const std::vector<int64_t> delta_vector = feedback.GetReceiveDeltasUs();
+  std::vector<PacketInfo> packet_feedback_vector;
+  packet_feedback_vector.reserve(delta_vector.size());
+
+  int64_t arrival_time_us = feedback.GetBaseTimeUs();
+  auto delta_it = delta_vector.begin();
+  uint16_t sequence_number = feedback.GetBaseSequence();
+  {
+    CriticalSectionScoped cs(crit_.get());
+    for (const auto symbol : status_vector) {
+      if (symbol != rtcp::TransportFeedback::StatusSymbol::kNotReceived) {
+        DCHECK(delta_it != delta_vector.end());
+        arrival_time_us += *delta_it++;
+        int64_t send_time_ms;
+        size_t payload_size;
+        int probe_cluster_id;
+        if (send_time_history_.GetInfo(sequence_number, &send_time_ms,
+                                       &payload_size, &probe_cluster_id,
+                                       true)) {
+          // The pacer sends all packets, so all of them may be probes.
+          packet_feedback_vector.push_back(PacketInfo(
+              arrival_time_us / 1000, send_time_ms, sequence_number,
+              payload_size, true, probe_cluster_id));
+        } else {
+          LOG(LS_WARNING) << "Ack arrived too late.";
+        }
+      }
+      ++sequence_number;
+    }
+  }
+  DCHECK(delta_it == delta_vector.end());
+  if (!packet_feedback_vector.empty())
+    bitrate_estimator_->IncomingPacketFeedbackVector(packet_feedback_vector);
+}
+
+void TransportFeedbackAdapter::OnRttUpdate(int64_t rtt_ms) {
+  bitrate_estimator_->OnRttUpdate(rtt_ms);
+}
+
+void TransportFeedbackAdapter::OnReceiveBitrateChanged(
+    const std::vector<unsigned int>& ssrcs,
+    unsigned int bitrate) {
+  bandwidth_observer_->OnReceivedEstimatedBitrate(bitrate);
+}
+
+int64_t TransportFeedbackAdapter::TimeUntilNextProcess() {
+  return bitrate_estimator_->TimeUntilNextProcess();
+}
+
+int32_t TransportFeedbackAdapter::Process() {
+  return bitrate_estimator_->Process();
+}
+
+}  // namespace webrtc
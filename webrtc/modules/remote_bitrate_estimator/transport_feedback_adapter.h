@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_TRANSPORT_FEEDBACK_ADAPTER_H_
+#define WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_TRANSPORT_FEEDBACK_ADAPTER_H_
+
+#include <vector>
+
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/thread_annotations.h"
+#include "webrtc/modules/bitrate_controller/send_time_history.h"
+#include "webrtc/modules/interface/module_common_types.h"
+#include "webrtc/modules/remote_bitrate_estimator/include/remote_bitrate_estimator.h"
+#include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"
+
+namespace webrtc {
+
+class Clock;
+class CriticalSectionWrapper;
+
+// Send side of the send-side bandwidth estimation. Remembers when each packet
+// with a transport-wide sequence number was sent, joins that with the arrival
+// times reported in transport feedback, and runs a delay based estimator on
+// the result. Its estimates are handed to |bandwidth_observer|, usually the
+// RtcpBandwidthObserver of the BitrateController, where they bound the loss
+// based estimate of SendSideBandwidthEstimation just like a REMB would.
+class TransportFeedbackAdapter : public TransportFeedbackObserver,
+                                 public CallStatsObserver,
+                                 public RemoteBitrateObserver,
+                                 public Module {
+ public:
+  TransportFeedbackAdapter(RtcpBandwidthObserver* bandwidth_observer,
+                           Clock* clock,
+                           uint32_t min_bitrate_bps);
+  virtual ~TransportFeedbackAdapter();
+
+  // Implements TransportFeedbackObserver.
+  void OnSentPacket(uint16_t sequence_number,
+                    int64_t send_time_ms,
+                    size_t payload_size,
+                    int probe_cluster_id) override;
+  void OnTransportFeedback(const rtcp::TransportFeedback& feedback) override;
+
+  // Implements CallStatsObserver.
+  void OnRttUpdate(int64_t rtt_ms) override;
+
+  // Implements RemoteBitrateObserver.
+  void OnReceiveBitrateChanged(const std::vector<unsigned int>& ssrcs,
+                               unsigned int bitrate) override;
+
+  // Implements Module.
+  int64_t TimeUntilNextProcess() override;
+  int32_t Process() override;
+
+  static const int64_t kSendTimeHistoryWindowMs;
+
+ private:
+  RtcpBandwidthObserver* const bandwidth_observer_;
+  const rtc::scoped_ptr<CriticalSectionWrapper> crit_;
+  SendTimeHistory send_time_history_ GUARDED_BY(crit_.get());
+  const rtc::scoped_ptr<RemoteBitrateEstimator> bitrate_estimator_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransportFeedbackAdapter);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_REMOTE_BITRATE_ESTIMATOR_TRANSPORT_FEEDBACK_ADAPTER_H_
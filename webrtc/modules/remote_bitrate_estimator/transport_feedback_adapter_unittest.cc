@@ -0,0 +1,123 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/pacing/include/paced_sender.h"
+#include "webrtc/modules/remote_bitrate_estimator/transport_feedback_adapter.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+
+namespace webrtc {
+namespace {
+
+const uint32_t kMinBitrateBps = 30000;
+const size_t kPayloadSize = 1000;
+const int64_t kFeedbackIntervalMs = 100;
+
+class BandwidthRecorder : public RtcpBandwidthObserver {
+ public:
+  BandwidthRecorder() : last_bitrate_bps_(0), num_estimates_(0) {}
+
+  void OnReceivedEstimatedBitrate(uint32_t bitrate) override {
+    last_bitrate_bps_ = bitrate;
+    ++num_estimates_;
+  }
+  void OnReceivedRtcpReceiverReport(const ReportBlockList& report_blocks,
+                                    int64_t rtt,
+                                    int64_t now_ms) override {}
+
+  uint32_t last_bitrate_bps_;
+  int num_estimates_;
+};
+
+class TransportFeedbackAdapterTest : public ::testing::Test {
+ public:
+  TransportFeedbackAdapterTest()
+      : clock_(0),
+        adapter_(&bandwidth_recorder_, &clock_, kMinBitrateBps),
+        next_sequence_number_(0),
+        link_free_at_us_(0) {}
+
+ protected:
+  // Sends |kPayloadSize| byte packets at |send_bitrate_bps| over a link with
+  // |capacity_bps| and 50 ms of propagation delay for |duration_ms|, and
+  // reports their arrival every |kFeedbackIntervalMs|.
+  void Run(int send_bitrate_bps, int capacity_bps, int64_t duration_ms) {
+    const int64_t send_interval_us =
+        8000000LL * kPayloadSize / send_bitrate_bps;
+    const int64_t transmit_time_us = 8000000LL * kPayloadSize / capacity_bps;
+    const int64_t end_ms = clock_.TimeInMilliseconds() + duration_ms;
+    int64_t last_feedback_ms = clock_.TimeInMilliseconds();
+    rtc::scoped_ptr<rtcp::TransportFeedback> feedback;
+    while (clock_.TimeInMilliseconds() < end_ms) {
+      const int64_t now_us = clock_.TimeInMicroseconds();
+      const uint16_t sequence_number = next_sequence_number_++;
+      adapter_.OnSentPacket(sequence_number, now_us / 1000, kPayloadSize,
+                            PacedSender::kNotAProbe);
+      link_free_at_us_ = std::max(link_free_at_us_, now_us) + transmit_time_us;
+      const int64_t arrival_us = link_free_at_us_ + 50000;
+      if (!feedback.get()) {
+        feedback.reset(new rtcp::TransportFeedback());
+        feedback->WithBase(sequence_number, arrival_us);
+      }
+      EXPECT_TRUE(feedback->WithReceivedPacket(sequence_number, arrival_us));
+
+      clock_.AdvanceTimeMicroseconds(send_interval_us);
+      if (clock_.TimeInMilliseconds() - last_feedback_ms >=
+          kFeedbackIntervalMs) {
+        adapter_.OnTransportFeedback(*feedback);
+        feedback.reset();
+        last_feedback_ms = clock_.TimeInMilliseconds();
+      }
+      if (adapter_.TimeUntilNextProcess() <= 0)
+        adapter_.Process();
+    }
+  }
+
+  SimulatedClock clock_;
+  BandwidthRecorder bandwidth_recorder_;
+  TransportFeedbackAdapter adapter_;
+  uint16_t next_sequence_number_;
+  int64_t link_free_at_us_;
+};
+
+TEST_F(TransportFeedbackAdapterTest, EstimatesFromFeedback) {
+  adapter_.OnRttUpdate(100);
+  Run(500000, 2000000, 5000);
+  EXPECT_GT(bandwidth_recorder_.num_estimates_, 0);
+  EXPECT_GT(bandwidth_recorder_.last_bitrate_bps_, 400000u);
+}
+
+TEST_F(TransportFeedbackAdapterTest, BacksOffOnQueueBuildup) {
+  adapter_.OnRttUpdate(100);
+  Run(500000, 2000000, 5000);
+  const uint32_t uncongested_bitrate_bps =
+      bandwidth_recorder_.last_bitrate_bps_;
+  // The link suddenly drains at half the rate sent, building a queue.
+  Run(500000, 250000, 2000);
+  EXPECT_LT(bandwidth_recorder_.last_bitrate_bps_,
+            uncongested_bitrate_bps * 9 / 10);
+}
+
+TEST_F(TransportFeedbackAdapterTest, IgnoresFeedbackForUnknownPackets) {
+  rtcp::TransportFeedback feedback;
+  feedback.WithBase(100, 1000000);
+  EXPECT_TRUE(feedback.WithReceivedPacket(100, 1000000));
+  EXPECT_TRUE(feedback.WithReceivedPacket(102, 1001000));
+  adapter_.OnTransportFeedback(feedback);
+  clock_.AdvanceTimeMilliseconds(1000);
+  adapter_.Process();
+  EXPECT_EQ(0, bandwidth_recorder_.num_estimates_);
+}
+
+}  // namespace
+}  // namespace webrtc
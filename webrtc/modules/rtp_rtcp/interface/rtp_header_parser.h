@@ -28,7 +28,8 @@ class RtpHeaderParser {
   // Parses the packet and stores the parsed packet in |header|. Returns true on
   // success, false otherwise.
   // This method is thread-safe in the sense that it can parse multiple packets
-  // at once.
+  // at once. It doesn't take any lock, so it never waits for a concurrent
+  // (de)registration of a header extension.
   virtual bool Parse(const uint8_t* packet,
                      size_t length,
                      RTPHeader* header) const = 0;
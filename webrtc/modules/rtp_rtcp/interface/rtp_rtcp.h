@@ -52,6 +52,12 @@ class RtpRtcp : public Module {
     *                             streams from the same client.
     *  paced_sender             - Spread any bursts of packets into smaller
     *                             bursts to minimize packet loss.
+    *  transport_sequence_number_allocator - Hands out transport-wide sequence
+    *                             numbers, if that header extension is
+    *                             registered.
+    *  transport_feedback_callback - Called for each packet sent with a
+    *                             transport-wide sequence number, and for each
+    *                             received transport feedback packet.
     */
     int32_t id;
     bool audio;
@@ -69,6 +75,8 @@ class RtpRtcp : public Module {
     BitrateStatisticsObserver* send_bitrate_observer;
     FrameCountObserver* send_frame_count_observer;
     SendSideDelayObserver* send_side_delay_observer;
+    TransportSequenceNumberAllocator* transport_sequence_number_allocator;
+    TransportFeedbackObserver* transport_feedback_callback;
   };
 
   /*
@@ -302,12 +310,15 @@ class RtpRtcp : public Module {
         const RTPFragmentationHeader* fragmentation = NULL,
         const RTPVideoHeader* rtpVideoHdr = NULL) = 0;
 
+    // |probe_cluster_id| is the probe cluster the packet is sent in, or
+    // PacedSender::kNotAProbe.
     virtual bool TimeToSendPacket(uint32_t ssrc,
                                   uint16_t sequence_number,
                                   int64_t capture_time_ms,
-                                  bool retransmission) = 0;
+                                  bool retransmission,
+                                  int probe_cluster_id) = 0;
 
-    virtual size_t TimeToSendPadding(size_t bytes) = 0;
+    virtual size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) = 0;
 
     // Called on generation of new statistics after an RTP send.
     virtual void RegisterSendChannelRtpStatisticsCallback(
@@ -486,6 +497,13 @@ class RtpRtcp : public Module {
     virtual void SetREMBData(uint32_t bitrate,
                              const std::vector<uint32_t>& ssrcs) = 0;
 
+    /*
+    *   Sends a transport-wide congestion control feedback packet on its own,
+    *   outside of the regular compound reports. Returns false on failure.
+    */
+    virtual bool SendFeedbackPacket(
+        const rtcp::TransportFeedback& packet) = 0;
+
     /*
     *   (IJ) Extended jitter report.
     */
@@ -24,6 +24,9 @@
 #define TIMEOUT_SEI_MESSAGES_MS 30000   // in milliseconds
 
 namespace webrtc {
+namespace rtcp {
+class TransportFeedback;
+}
 
 const int kVideoPayloadTypeFrequency = 90000;
 
@@ -108,7 +111,8 @@ enum RTCPPacketType : uint32_t {
   kRtcpRemb = 0x10000,
   kRtcpTransmissionTimeOffset = 0x20000,
   kRtcpXrReceiverReferenceTime = 0x40000,
-  kRtcpXrDlrrReportBlock = 0x80000
+  kRtcpXrDlrrReportBlock = 0x80000,
+  kRtcpTransportFeedback = 0x100000
 };
 
 enum KeyFrameRequestMethod
@@ -304,6 +308,31 @@ class RtcpRttStats {
   virtual ~RtcpRttStats() {};
 };
 
+// Hands out the transport-wide sequence numbers, shared by all RTP modules
+// sending on the same transport.
+class TransportSequenceNumberAllocator {
+ public:
+  virtual uint16_t AllocateSequenceNumber() = 0;
+
+  virtual ~TransportSequenceNumberAllocator() {}
+};
+
+class TransportFeedbackObserver {
+ public:
+  // Called for each packet sent with a transport-wide sequence number.
+  // |probe_cluster_id| is the probe cluster the packet was sent in, or
+  // PacedSender::kNotAProbe.
+  virtual void OnSentPacket(uint16_t sequence_number,
+                            int64_t send_time_ms,
+                            size_t payload_size,
+                            int probe_cluster_id) = 0;
+
+  virtual void OnTransportFeedback(
+      const rtcp::TransportFeedback& feedback) = 0;
+
+  virtual ~TransportFeedbackObserver() {}
+};
+
 // Null object version of RtpFeedback.
 class NullRtpFeedback : public RtpFeedback {
  public:
@@ -33,9 +33,13 @@ Bitrate::Bitrate(Clock* clock, Observer* observer)
 Bitrate::~Bitrate() {}
 
 void Bitrate::Update(const size_t bytes) {
+  Update(bytes, 1);
+}
+
+void Bitrate::Update(size_t bytes, uint32_t packets) {
   CriticalSectionScoped cs(crit_.get());
   bytes_count_ += bytes;
-  packet_count_++;
+  packet_count_ += packets;
 }
 
 uint32_t Bitrate::PacketRate() const {
@@ -11,121 +11,210 @@
 #include "webrtc/modules/rtp_rtcp/source/receive_statistics_impl.h"
 
 #include <math.h>
+#include <string.h>
 
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/modules/rtp_rtcp/source/bitrate.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/system_wrappers/interface/sleep.h"
 
 namespace webrtc {
 
 const int64_t kStatisticsTimeoutMs = 8000;
 const int64_t kStatisticsProcessIntervalMs = 1000;
+// Must be a power of two.
+const size_t kInitialStatisticianTableSize = 16;
+// Attempts at copying the state of a stream before yielding to a packet path
+// that may have been preempted while publishing it.
+const int kReadAttemptsBeforeYield = 4;
+
+const size_t StreamStatisticianImpl::kStateWords;
 
 StreamStatistician::~StreamStatistician() {}
 
+StreamStatisticianImpl::ReceiveState::ReceiveState()
+    : jitter_q4(0),
+      jitter_q4_transmission_time_offset(0),
+      last_receive_time_ms(0),
+      last_receive_time_secs(0),
+      last_receive_time_frac(0),
+      last_received_timestamp(0),
+      last_received_transmission_time_offset(0),
+      received_seq_first(0),
+      received_seq_max(0),
+      received_seq_wraps(0),
+      received_packet_overhead(12),
+      applied_resets(0) {}
+
 StreamStatisticianImpl::StreamStatisticianImpl(
+    uint32_t ssrc,
     Clock* clock,
     RtcpStatisticsCallback* rtcp_callback,
     StreamDataCountersCallback* rtp_callback)
-    : clock_(clock),
-      stream_lock_(CriticalSectionWrapper::CreateCriticalSection()),
-      incoming_bitrate_(clock, NULL),
-      ssrc_(0),
+    : ssrc_(ssrc),
+      clock_(clock),
+      published_version_(0),
       max_reordering_threshold_(kDefaultMaxReorderingThreshold),
-      jitter_q4_(0),
+      requested_resets_(0),
+      data_counters_callbacks_(0),
+      report_lock_(CriticalSectionWrapper::CreateCriticalSection()),
+      incoming_bitrate_(clock, NULL),
+      bitrate_bytes_(0),
+      bitrate_packets_(0),
       cumulative_loss_(0),
-      jitter_q4_transmission_time_offset_(0),
-      last_receive_time_ms_(0),
-      last_receive_time_secs_(0),
-      last_receive_time_frac_(0),
-      last_received_timestamp_(0),
-      last_received_transmission_time_offset_(0),
-      received_seq_first_(0),
-      received_seq_max_(0),
-      received_seq_wraps_(0),
-      received_packet_overhead_(12),
       last_report_inorder_packets_(0),
       last_report_old_packets_(0),
       last_report_seq_max_(0),
       rtcp_callback_(rtcp_callback),
-      rtp_callback_(rtp_callback) {}
+      rtp_callback_(rtp_callback) {
+  PublishState();
+}
+
+void StreamStatisticianImpl::PublishState() {
+  intptr_t words[kStateWords];
+  memcpy(words, &state_, sizeof(state_));
+  const int version = published_version_;
+  rtc::AtomicOps::ReleaseStore(&published_version_, version + 1);
+  // Readers must not see any of the new words without the odd version.
+  rtc::AtomicOps::ReleaseFence();
+  for (size_t i = 0; i < kStateWords; ++i)
+    rtc::AtomicOps::RelaxedStoreWord(&published_state_[i], words[i]);
+  rtc::AtomicOps::ReleaseStore(&published_version_, version + 2);
+}
+
+StreamStatisticianImpl::ReceiveState StreamStatisticianImpl::ReadReceiveState()
+    const {
+  intptr_t words[kStateWords];
+  for (int attempt = 1;; ++attempt) {
+    const int version = rtc::AtomicOps::AcquireLoad(&published_version_);
+    if ((version & 1) == 0) {
+      for (size_t i = 0; i < kStateWords; ++i)
+        words[i] = rtc::AtomicOps::RelaxedLoadWord(&published_state_[i]);
+      // The copy must be complete before the version is checked again.
+      rtc::AtomicOps::AcquireFence();
+      if (version == rtc::AtomicOps::AcquireLoad(&published_version_))
+        break;
+    }
+    if (attempt % kReadAttemptsBeforeYield == 0)
+      SleepMs(0);
+  }
+  ReceiveState state;
+  memcpy(&state, words, sizeof(state));
+  // Apply resets the packet path hasn't picked up yet.
+  if (state.applied_resets != rtc::AtomicOps::AcquireLoad(&requested_resets_))
+    Reset(&state);
+  return state;
+}
+
+void StreamStatisticianImpl::ApplyRequestedResets() {
+  const int requested_resets = rtc::AtomicOps::AcquireLoad(&requested_resets_);
+  if (state_.applied_resets != requested_resets) {
+    Reset(&state_);
+    state_.applied_resets = requested_resets;
+  }
+}
+
+void StreamStatisticianImpl::Reset(ReceiveState* state) {
+  state->jitter_q4 = 0;
+  state->jitter_q4_transmission_time_offset = 0;
+  state->received_seq_wraps = 0;
+  state->received_seq_max = 0;
+  state->received_seq_first = 0;
+  state->stored_sum_receive_counters.Add(state->receive_counters);
+  state->receive_counters = StreamDataCounters();
+}
 
 void StreamStatisticianImpl::ResetStatistics() {
-  CriticalSectionScoped cs(stream_lock_.get());
+  CriticalSectionScoped cs(report_lock_.get());
   last_report_inorder_packets_ = 0;
   last_report_old_packets_ = 0;
   last_report_seq_max_ = 0;
   last_reported_statistics_ = RtcpStatistics();
-  jitter_q4_ = 0;
   cumulative_loss_ = 0;
-  jitter_q4_transmission_time_offset_ = 0;
-  received_seq_wraps_ = 0;
-  received_seq_max_ = 0;
-  received_seq_first_ = 0;
-  stored_sum_receive_counters_.Add(receive_counters_);
-  receive_counters_ = StreamDataCounters();
+  // The packet path resets |state_| with its next packet, readers reset
+  // their copy until then.
+  rtc::AtomicOps::Increment(&requested_resets_);
 }
 
 void StreamStatisticianImpl::IncomingPacket(const RTPHeader& header,
                                             size_t packet_length,
                                             bool retransmitted) {
-  UpdateCounters(header, packet_length, retransmitted);
-  NotifyRtpCallback();
-}
-
-void StreamStatisticianImpl::UpdateCounters(const RTPHeader& header,
-                                            size_t packet_length,
-                                            bool retransmitted) {
-  CriticalSectionScoped cs(stream_lock_.get());
-  bool in_order = InOrderPacketInternal(header.sequenceNumber);
-  ssrc_ = header.ssrc;
-  incoming_bitrate_.Update(packet_length);
-  receive_counters_.transmitted.AddPacket(packet_length, header);
+  NotifyDataCountersUpdated(
+      UpdateCounters(header, packet_length, retransmitted));
+}
+
+void StreamStatisticianImpl::NotifyDataCountersUpdated(
+    const StreamDataCounters& counters) {
+  // Full barrier, which WaitForDataCountersCallbacks() relies on.
+  rtc::AtomicOps::Increment(&data_counters_callbacks_);
+  rtp_callback_->DataCountersUpdated(counters, ssrc_);
+  rtc::AtomicOps::Decrement(&data_counters_callbacks_);
+}
+
+void StreamStatisticianImpl::WaitForDataCountersCallbacks() {
+  while (rtc::AtomicOps::CompareAndSwap(&data_counters_callbacks_, 0, 0) != 0)
+    SleepMs(0);
+}
+
+StreamDataCounters StreamStatisticianImpl::UpdateCounters(
+    const RTPHeader& header,
+    size_t packet_length,
+    bool retransmitted) {
+  // Current time in samples.
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  uint32_t receive_time_secs;
+  uint32_t receive_time_frac;
+  clock_->CurrentNtp(receive_time_secs, receive_time_frac);
+
+  ApplyRequestedResets();
+  bool in_order = InOrderPacketInternal(
+      state_, rtc::AtomicOps::AcquireLoad(&max_reordering_threshold_),
+      header.sequenceNumber);
+  StreamDataCounters& counters = state_.receive_counters;
+  counters.transmitted.AddPacket(packet_length, header);
   if (!in_order && retransmitted) {
-    receive_counters_.retransmitted.AddPacket(packet_length, header);
+    counters.retransmitted.AddPacket(packet_length, header);
   }
 
-  if (receive_counters_.transmitted.packets == 1) {
-    received_seq_first_ = header.sequenceNumber;
-    receive_counters_.first_packet_time_ms = clock_->TimeInMilliseconds();
+  if (counters.transmitted.packets == 1) {
+    state_.received_seq_first = header.sequenceNumber;
+    counters.first_packet_time_ms = now_ms;
   }
 
   // Count only the new packets received. That is, if packets 1, 2, 3, 5, 4, 6
   // are received, 4 will be ignored.
   if (in_order) {
-    // Current time in samples.
-    uint32_t receive_time_secs;
-    uint32_t receive_time_frac;
-    clock_->CurrentNtp(receive_time_secs, receive_time_frac);
-
     // Wrong if we use RetransmitOfOldPacket.
-    if (receive_counters_.transmitted.packets > 1 &&
-        received_seq_max_ > header.sequenceNumber) {
+    if (counters.transmitted.packets > 1 &&
+        state_.received_seq_max > header.sequenceNumber) {
       // Wrap around detected.
-      received_seq_wraps_++;
+      state_.received_seq_wraps++;
     }
     // New max.
-    received_seq_max_ = header.sequenceNumber;
+    state_.received_seq_max = header.sequenceNumber;
 
     // If new time stamp and more than one in-order packet received, calculate
     // new jitter statistics.
-    if (header.timestamp != last_received_timestamp_ &&
-        (receive_counters_.transmitted.packets -
-         receive_counters_.retransmitted.packets) > 1) {
+    if (header.timestamp != state_.last_received_timestamp &&
+        (counters.transmitted.packets - counters.retransmitted.packets) > 1) {
       UpdateJitter(header, receive_time_secs, receive_time_frac);
     }
-    last_received_timestamp_ = header.timestamp;
-    last_receive_time_secs_ = receive_time_secs;
-    last_receive_time_frac_ = receive_time_frac;
-    last_receive_time_ms_ = clock_->TimeInMilliseconds();
+    state_.last_received_timestamp = header.timestamp;
+    state_.last_receive_time_secs = receive_time_secs;
+    state_.last_receive_time_frac = receive_time_frac;
+    state_.last_receive_time_ms = now_ms;
   }
 
   size_t packet_oh = header.headerLength + header.paddingLength;
 
   // Our measured overhead. Filter from RFC 5104 4.2.1.2:
   // avg_OH (new) = 15/16*avg_OH (old) + 1/16*pckt_OH,
-  received_packet_overhead_ = (15 * received_packet_overhead_ + packet_oh) >> 4;
+  state_.received_packet_overhead =
+      (15 * state_.received_packet_overhead + packet_oh) >> 4;
+  PublishState();
+  return counters;
 }
 
 void StreamStatisticianImpl::UpdateJitter(const RTPHeader& header,
@@ -134,11 +223,11 @@ void StreamStatisticianImpl::UpdateJitter(const RTPHeader& header,
   uint32_t receive_time_rtp = RtpUtility::ConvertNTPTimeToRTP(
       receive_time_secs, receive_time_frac, header.payload_type_frequency);
   uint32_t last_receive_time_rtp =
-      RtpUtility::ConvertNTPTimeToRTP(last_receive_time_secs_,
-                                      last_receive_time_frac_,
+      RtpUtility::ConvertNTPTimeToRTP(state_.last_receive_time_secs,
+                                      state_.last_receive_time_frac,
                                       header.payload_type_frequency);
   int32_t time_diff_samples = (receive_time_rtp - last_receive_time_rtp) -
-      (header.timestamp - last_received_timestamp_);
+      (header.timestamp - state_.last_received_timestamp);
 
   time_diff_samples = abs(time_diff_samples);
 
@@ -147,8 +236,8 @@ void StreamStatisticianImpl::UpdateJitter(const RTPHeader& header,
   // as the threshold.
   if (time_diff_samples < 450000) {
     // Note we calculate in Q4 to avoid using float.
-    int32_t jitter_diff_q4 = (time_diff_samples << 4) - jitter_q4_;
-    jitter_q4_ += ((jitter_diff_q4 + 8) >> 4);
+    int32_t jitter_diff_q4 = (time_diff_samples << 4) - state_.jitter_q4;
+    state_.jitter_q4 += ((jitter_diff_q4 + 8) >> 4);
   }
 
   // Extended jitter report, RFC 5450.
@@ -157,62 +246,42 @@ void StreamStatisticianImpl::UpdateJitter(const RTPHeader& header,
     (receive_time_rtp - last_receive_time_rtp) -
     ((header.timestamp +
       header.extension.transmissionTimeOffset) -
-     (last_received_timestamp_ +
-      last_received_transmission_time_offset_));
+     (state_.last_received_timestamp +
+      state_.last_received_transmission_time_offset));
 
   time_diff_samples_ext = abs(time_diff_samples_ext);
 
   if (time_diff_samples_ext < 450000) {
     int32_t jitter_diffQ4TransmissionTimeOffset =
-      (time_diff_samples_ext << 4) - jitter_q4_transmission_time_offset_;
-    jitter_q4_transmission_time_offset_ +=
+      (time_diff_samples_ext << 4) - state_.jitter_q4_transmission_time_offset;
+    state_.jitter_q4_transmission_time_offset +=
       ((jitter_diffQ4TransmissionTimeOffset + 8) >> 4);
   }
 }
 
-void StreamStatisticianImpl::NotifyRtpCallback() {
-  StreamDataCounters data;
-  uint32_t ssrc;
-  {
-    CriticalSectionScoped cs(stream_lock_.get());
-    data = receive_counters_;
-    ssrc = ssrc_;
-  }
-  rtp_callback_->DataCountersUpdated(data, ssrc);
-}
-
-void StreamStatisticianImpl::NotifyRtcpCallback() {
-  RtcpStatistics data;
-  uint32_t ssrc;
-  {
-    CriticalSectionScoped cs(stream_lock_.get());
-    data = last_reported_statistics_;
-    ssrc = ssrc_;
-  }
-  rtcp_callback_->StatisticsUpdated(data, ssrc);
-}
-
 void StreamStatisticianImpl::FecPacketReceived(const RTPHeader& header,
                                                size_t packet_length) {
-  {
-    CriticalSectionScoped cs(stream_lock_.get());
-    receive_counters_.fec.AddPacket(packet_length, header);
-  }
-  NotifyRtpCallback();
+  ApplyRequestedResets();
+  state_.receive_counters.fec.AddPacket(packet_length, header);
+  PublishState();
+  NotifyDataCountersUpdated(state_.receive_counters);
 }
 
 void StreamStatisticianImpl::SetMaxReorderingThreshold(
     int max_reordering_threshold) {
-  CriticalSectionScoped cs(stream_lock_.get());
-  max_reordering_threshold_ = max_reordering_threshold;
+  rtc::AtomicOps::ReleaseStore(&max_reordering_threshold_,
+                               max_reordering_threshold);
 }
 
 bool StreamStatisticianImpl::GetStatistics(RtcpStatistics* statistics,
                                            bool reset) {
   {
-    CriticalSectionScoped cs(stream_lock_.get());
-    if (received_seq_first_ == 0 &&
-        receive_counters_.transmitted.payload_bytes == 0) {
+    CriticalSectionScoped cs(report_lock_.get());
+    // Read under |report_lock_| so that a concurrent ResetStatistics() can't
+    // land between the read and the update of the report bookkeeping.
+    const ReceiveState state = ReadReceiveState();
+    if (state.received_seq_first == 0 &&
+        state.receive_counters.transmitted.payload_bytes == 0) {
       // We have not received anything.
       return false;
     }
@@ -227,26 +296,28 @@ bool StreamStatisticianImpl::GetStatistics(RtcpStatistics* statistics,
       return true;
     }
 
-    *statistics = CalculateRtcpStatistics();
+    *statistics = CalculateRtcpStatistics(state);
   }
 
-  NotifyRtcpCallback();
+  rtcp_callback_->StatisticsUpdated(*statistics, ssrc_);
 
   return true;
 }
 
-RtcpStatistics StreamStatisticianImpl::CalculateRtcpStatistics() {
+RtcpStatistics StreamStatisticianImpl::CalculateRtcpStatistics(
+    const ReceiveState& state) {
   RtcpStatistics stats;
+  const StreamDataCounters& counters = state.receive_counters;
 
   if (last_report_inorder_packets_ == 0) {
     // First time we send a report.
-    last_report_seq_max_ = received_seq_first_ - 1;
+    last_report_seq_max_ = state.received_seq_first - 1;
   }
 
   // Calculate fraction lost.
-  uint16_t exp_since_last = (received_seq_max_ - last_report_seq_max_);
+  uint16_t exp_since_last = (state.received_seq_max - last_report_seq_max_);
 
-  if (last_report_seq_max_ > received_seq_max_) {
+  if (last_report_seq_max_ > state.received_seq_max) {
     // Can we assume that the seq_num can't go decrease over a full RTCP period?
     exp_since_last = 0;
   }
@@ -254,8 +325,8 @@ RtcpStatistics StreamStatisticianImpl::CalculateRtcpStatistics() {
   // Number of received RTP packets since last report, counts all packets but
   // not re-transmissions.
   uint32_t rec_since_last =
-      (receive_counters_.transmitted.packets -
-       receive_counters_.retransmitted.packets) - last_report_inorder_packets_;
+      (counters.transmitted.packets - counters.retransmitted.packets) -
+      last_report_inorder_packets_;
 
   // With NACK we don't know the expected retransmissions during the last
   // second. We know how many "old" packets we have received. We just count
@@ -267,7 +338,7 @@ RtcpStatistics StreamStatisticianImpl::CalculateRtcpStatistics() {
   // re-transmitted. We use RTT to decide if a packet is re-ordered or
   // re-transmitted.
   uint32_t retransmitted_packets =
-      receive_counters_.retransmitted.packets - last_report_old_packets_;
+      counters.retransmitted.packets - last_report_old_packets_;
   rec_since_last += retransmitted_packets;
 
   int32_t missing = 0;
@@ -286,80 +357,98 @@ RtcpStatistics StreamStatisticianImpl::CalculateRtcpStatistics() {
   cumulative_loss_ += missing;
   stats.cumulative_lost = cumulative_loss_;
   stats.extended_max_sequence_number =
-      (received_seq_wraps_ << 16) + received_seq_max_;
+      (state.received_seq_wraps << 16) + state.received_seq_max;
   // Note: internal jitter value is in Q4 and needs to be scaled by 1/16.
-  stats.jitter = jitter_q4_ >> 4;
+  stats.jitter = state.jitter_q4 >> 4;
 
   // Store this report.
   last_reported_statistics_ = stats;
 
   // Only for report blocks in RTCP SR and RR.
   last_report_inorder_packets_ =
-      receive_counters_.transmitted.packets -
-      receive_counters_.retransmitted.packets;
-  last_report_old_packets_ = receive_counters_.retransmitted.packets;
-  last_report_seq_max_ = received_seq_max_;
+      counters.transmitted.packets - counters.retransmitted.packets;
+  last_report_old_packets_ = counters.retransmitted.packets;
+  last_report_seq_max_ = state.received_seq_max;
 
   return stats;
 }
 
 void StreamStatisticianImpl::GetDataCounters(
     size_t* bytes_received, uint32_t* packets_received) const {
-  CriticalSectionScoped cs(stream_lock_.get());
+  const ReceiveState state = ReadReceiveState();
   if (bytes_received) {
-    *bytes_received = receive_counters_.transmitted.payload_bytes +
-                      receive_counters_.transmitted.header_bytes +
-                      receive_counters_.transmitted.padding_bytes;
+    *bytes_received = state.receive_counters.transmitted.TotalBytes();
   }
   if (packets_received) {
-    *packets_received = receive_counters_.transmitted.packets;
+    *packets_received = state.receive_counters.transmitted.packets;
   }
 }
 
 void StreamStatisticianImpl::GetReceiveStreamDataCounters(
     StreamDataCounters* data_counters) const {
-  CriticalSectionScoped cs(stream_lock_.get());
-  *data_counters = receive_counters_;
-  data_counters->Add(stored_sum_receive_counters_);
+  const ReceiveState state = ReadReceiveState();
+  *data_counters = state.receive_counters;
+  data_counters->Add(state.stored_sum_receive_counters);
+}
+
+void StreamStatisticianImpl::UpdateBitrate() const {
+  const ReceiveState state = ReadReceiveState();
+  // Counters moved to |stored_sum_receive_counters| by a reset still count.
+  const size_t bytes =
+      state.receive_counters.transmitted.TotalBytes() +
+      state.stored_sum_receive_counters.transmitted.TotalBytes();
+  const uint32_t packets =
+      state.receive_counters.transmitted.packets +
+      state.stored_sum_receive_counters.transmitted.packets;
+  if (packets != bitrate_packets_) {
+    incoming_bitrate_.Update(bytes - bitrate_bytes_,
+                             packets - bitrate_packets_);
+    bitrate_bytes_ = bytes;
+    bitrate_packets_ = packets;
+  }
 }
 
 uint32_t StreamStatisticianImpl::BitrateReceived() const {
-  CriticalSectionScoped cs(stream_lock_.get());
+  CriticalSectionScoped cs(report_lock_.get());
+  UpdateBitrate();
   return incoming_bitrate_.BitrateNow();
 }
 
 void StreamStatisticianImpl::ProcessBitrate() {
-  CriticalSectionScoped cs(stream_lock_.get());
+  CriticalSectionScoped cs(report_lock_.get());
+  UpdateBitrate();
   incoming_bitrate_.Process();
 }
 
 void StreamStatisticianImpl::LastReceiveTimeNtp(uint32_t* secs,
                                                 uint32_t* frac) const {
-  CriticalSectionScoped cs(stream_lock_.get());
-  *secs = last_receive_time_secs_;
-  *frac = last_receive_time_frac_;
+  const ReceiveState state = ReadReceiveState();
+  *secs = state.last_receive_time_secs;
+  *frac = state.last_receive_time_frac;
 }
 
 bool StreamStatisticianImpl::IsRetransmitOfOldPacket(
     const RTPHeader& header, int64_t min_rtt) const {
-  CriticalSectionScoped cs(stream_lock_.get());
-  if (InOrderPacketInternal(header.sequenceNumber)) {
+  const ReceiveState state = ReadReceiveState();
+  if (InOrderPacketInternal(
+          state, rtc::AtomicOps::AcquireLoad(&max_reordering_threshold_),
+          header.sequenceNumber)) {
     return false;
   }
   uint32_t frequency_khz = header.payload_type_frequency / 1000;
   assert(frequency_khz > 0);
 
   int64_t time_diff_ms = clock_->TimeInMilliseconds() -
-      last_receive_time_ms_;
+      state.last_receive_time_ms;
 
   // Diff in time stamp since last received in order.
-  uint32_t timestamp_diff = header.timestamp - last_received_timestamp_;
+  uint32_t timestamp_diff = header.timestamp - state.last_received_timestamp;
   uint32_t rtp_time_stamp_diff_ms = timestamp_diff / frequency_khz;
 
   int64_t max_delay_ms = 0;
   if (min_rtt == 0) {
     // Jitter standard deviation in samples.
-    float jitter_std = sqrt(static_cast<float>(jitter_q4_ >> 4));
+    float jitter_std = sqrt(static_cast<float>(state.jitter_q4 >> 4));
 
     // 2 times the standard deviation => 95% confidence.
     // And transform to milliseconds by dividing by the frequency in kHz.
@@ -376,25 +465,65 @@ bool StreamStatisticianImpl::IsRetransmitOfOldPacket(
 }
 
 bool StreamStatisticianImpl::IsPacketInOrder(uint16_t sequence_number) const {
-  CriticalSectionScoped cs(stream_lock_.get());
-  return InOrderPacketInternal(sequence_number);
+  return InOrderPacketInternal(
+      ReadReceiveState(),
+      rtc::AtomicOps::AcquireLoad(&max_reordering_threshold_), sequence_number);
 }
 
 bool StreamStatisticianImpl::InOrderPacketInternal(
-    uint16_t sequence_number) const {
+    const ReceiveState& state,
+    int max_reordering_threshold,
+    uint16_t sequence_number) {
   // First packet is always in order.
-  if (last_receive_time_ms_ == 0)
+  if (state.last_receive_time_ms == 0)
     return true;
 
-  if (IsNewerSequenceNumber(sequence_number, received_seq_max_)) {
+  if (IsNewerSequenceNumber(sequence_number, state.received_seq_max)) {
     return true;
   } else {
     // If we have a restart of the remote side this packet is still in order.
-    return !IsNewerSequenceNumber(sequence_number, received_seq_max_ -
-                                  max_reordering_threshold_);
+    return !IsNewerSequenceNumber(sequence_number, state.received_seq_max -
+                                  max_reordering_threshold);
   }
 }
 
+ReceiveStatisticsImpl::StatisticianTable::StatisticianTable(size_t capacity)
+    : capacity_(capacity),
+      size_(0),
+      slots_(new StreamStatisticianImpl* volatile[capacity]()) {
+  assert((capacity & (capacity - 1)) == 0);
+}
+
+StreamStatisticianImpl* ReceiveStatisticsImpl::StatisticianTable::Find(
+    uint32_t ssrc) const {
+  for (size_t slot = (ssrc * 2654435761u) & (capacity_ - 1);;
+       slot = (slot + 1) & (capacity_ - 1)) {
+    StreamStatisticianImpl* statistician = at(slot);
+    if (statistician == NULL || statistician->ssrc() == ssrc)
+      return statistician;
+  }
+}
+
+bool ReceiveStatisticsImpl::StatisticianTable::Insert(
+    StreamStatisticianImpl* statistician) {
+  // Keep the table at most half full, so that searches stay short and always
+  // end at an empty slot.
+  if (2 * (size_ + 1) > capacity_)
+    return false;
+  size_t slot = (statistician->ssrc() * 2654435761u) & (capacity_ - 1);
+  while (slots_[slot] != NULL)
+    slot = (slot + 1) & (capacity_ - 1);
+  // Publishes the statistician, which is fully constructed, to Find().
+  rtc::AtomicOps::ReleaseStorePtr(&slots_[slot], statistician);
+  ++size_;
+  return true;
+}
+
+StreamStatisticianImpl* ReceiveStatisticsImpl::StatisticianTable::at(
+    size_t slot) const {
+  return rtc::AtomicOps::AcquireLoadPtr(&slots_[slot]);
+}
+
 ReceiveStatistics* ReceiveStatistics::Create(Clock* clock) {
   return new ReceiveStatisticsImpl(clock);
 }
@@ -403,87 +532,96 @@ ReceiveStatisticsImpl::ReceiveStatisticsImpl(Clock* clock)
     : clock_(clock),
       receive_statistics_lock_(CriticalSectionWrapper::CreateCriticalSection()),
       last_rate_update_ms_(0),
+      current_table_(NULL),
+      rtcp_callback_lock_(CriticalSectionWrapper::CreateCriticalSection()),
       rtcp_stats_callback_(NULL),
-      rtp_stats_callback_(NULL) {}
+      rtp_stats_callback_(NULL) {
+  CriticalSectionScoped cs(receive_statistics_lock_.get());
+  tables_.push_back(new StatisticianTable(kInitialStatisticianTableSize));
+  current_table_ = tables_.back();
+}
 
-ReceiveStatisticsImpl::~ReceiveStatisticsImpl() {
-  while (!statisticians_.empty()) {
-    delete statisticians_.begin()->second;
-    statisticians_.erase(statisticians_.begin());
+ReceiveStatisticsImpl::~ReceiveStatisticsImpl() {}
+
+const ReceiveStatisticsImpl::StatisticianTable* ReceiveStatisticsImpl::table()
+    const {
+  return rtc::AtomicOps::AcquireLoadPtr(&current_table_);
+}
+
+StreamStatisticianImpl* ReceiveStatisticsImpl::GetOrCreateStatistician(
+    uint32_t ssrc) {
+  StreamStatisticianImpl* impl = table()->Find(ssrc);
+  if (impl != NULL)
+    return impl;
+
+  CriticalSectionScoped cs(receive_statistics_lock_.get());
+  // Another thread may have added it since the search above.
+  impl = current_table_->Find(ssrc);
+  if (impl != NULL)
+    return impl;
+  impl = new StreamStatisticianImpl(ssrc, clock_, this, this);
+  statisticians_.push_back(impl);
+  if (!current_table_->Insert(impl)) {
+    StatisticianTable* bigger =
+        new StatisticianTable(2 * current_table_->capacity());
+    for (StreamStatisticianImpl* statistician : statisticians_)
+      bigger->Insert(statistician);
+    tables_.push_back(bigger);
+    rtc::AtomicOps::ReleaseStorePtr(&current_table_, bigger);
   }
+  return impl;
 }
 
 void ReceiveStatisticsImpl::IncomingPacket(const RTPHeader& header,
                                            size_t packet_length,
                                            bool retransmitted) {
-  StreamStatisticianImpl* impl;
-  {
-    CriticalSectionScoped cs(receive_statistics_lock_.get());
-    StatisticianImplMap::iterator it = statisticians_.find(header.ssrc);
-    if (it != statisticians_.end()) {
-      impl = it->second;
-    } else {
-      impl = new StreamStatisticianImpl(clock_, this, this);
-      statisticians_[header.ssrc] = impl;
-    }
-  }
   // StreamStatisticianImpl instance is created once and only destroyed when
-  // this whole ReceiveStatisticsImpl is destroyed. StreamStatisticianImpl has
-  // it's own locking so don't hold receive_statistics_lock_ (potential
-  // deadlock).
-  impl->IncomingPacket(header, packet_length, retransmitted);
+  // this whole ReceiveStatisticsImpl is destroyed.
+  GetOrCreateStatistician(header.ssrc)->IncomingPacket(header, packet_length,
+                                                        retransmitted);
 }
 
 void ReceiveStatisticsImpl::FecPacketReceived(const RTPHeader& header,
                                               size_t packet_length) {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
-  StatisticianImplMap::iterator it = statisticians_.find(header.ssrc);
+  StreamStatisticianImpl* impl = table()->Find(header.ssrc);
   // Ignore FEC if it is the first packet.
-  if (it != statisticians_.end()) {
-    it->second->FecPacketReceived(header, packet_length);
-  }
+  if (impl != NULL)
+    impl->FecPacketReceived(header, packet_length);
 }
 
 StatisticianMap ReceiveStatisticsImpl::GetActiveStatisticians() const {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
+  const StatisticianTable* statisticians = table();
+  const int64_t now_ms = clock_->CurrentNtpInMilliseconds();
   StatisticianMap active_statisticians;
-  for (StatisticianImplMap::const_iterator it = statisticians_.begin();
-       it != statisticians_.end(); ++it) {
+  for (size_t i = 0; i < statisticians->capacity(); ++i) {
+    StreamStatisticianImpl* statistician = statisticians->at(i);
+    if (statistician == NULL)
+      continue;
     uint32_t secs;
     uint32_t frac;
-    it->second->LastReceiveTimeNtp(&secs, &frac);
-    if (clock_->CurrentNtpInMilliseconds() -
-        Clock::NtpToMs(secs, frac) < kStatisticsTimeoutMs) {
-      active_statisticians[it->first] = it->second;
-    }
+    statistician->LastReceiveTimeNtp(&secs, &frac);
+    if (now_ms - Clock::NtpToMs(secs, frac) < kStatisticsTimeoutMs)
+      active_statisticians[statistician->ssrc()] = statistician;
   }
   return active_statisticians;
 }
 
 StreamStatistician* ReceiveStatisticsImpl::GetStatistician(
     uint32_t ssrc) const {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
-  StatisticianImplMap::const_iterator it = statisticians_.find(ssrc);
-  if (it == statisticians_.end())
-    return NULL;
-  return it->second;
+  return table()->Find(ssrc);
 }
 
 void ReceiveStatisticsImpl::SetMaxReorderingThreshold(
     int max_reordering_threshold) {
   CriticalSectionScoped cs(receive_statistics_lock_.get());
-  for (StatisticianImplMap::iterator it = statisticians_.begin();
-       it != statisticians_.end(); ++it) {
-    it->second->SetMaxReorderingThreshold(max_reordering_threshold);
-  }
+  for (StreamStatisticianImpl* statistician : statisticians_)
+    statistician->SetMaxReorderingThreshold(max_reordering_threshold);
 }
 
 int32_t ReceiveStatisticsImpl::Process() {
   CriticalSectionScoped cs(receive_statistics_lock_.get());
-  for (StatisticianImplMap::iterator it = statisticians_.begin();
-       it != statisticians_.end(); ++it) {
-    it->second->ProcessBitrate();
-  }
+  for (StreamStatisticianImpl* statistician : statisticians_)
+    statistician->ProcessBitrate();
   last_rate_update_ms_ = clock_->TimeInMilliseconds();
   return 0;
 }
@@ -498,7 +636,7 @@ int64_t ReceiveStatisticsImpl::TimeUntilNextProcess() {
 
 void ReceiveStatisticsImpl::RegisterRtcpStatisticsCallback(
     RtcpStatisticsCallback* callback) {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
+  CriticalSectionScoped cs(rtcp_callback_lock_.get());
   if (callback != NULL)
     assert(rtcp_stats_callback_ == NULL);
   rtcp_stats_callback_ = callback;
@@ -506,13 +644,13 @@ void ReceiveStatisticsImpl::RegisterRtcpStatisticsCallback(
 
 void ReceiveStatisticsImpl::StatisticsUpdated(const RtcpStatistics& statistics,
                                               uint32_t ssrc) {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
+  CriticalSectionScoped cs(rtcp_callback_lock_.get());
   if (rtcp_stats_callback_)
     rtcp_stats_callback_->StatisticsUpdated(statistics, ssrc);
 }
 
 void ReceiveStatisticsImpl::CNameChanged(const char* cname, uint32_t ssrc) {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
+  CriticalSectionScoped cs(rtcp_callback_lock_.get());
   if (rtcp_stats_callback_)
     rtcp_stats_callback_->CNameChanged(cname, ssrc);
 }
@@ -522,15 +660,19 @@ void ReceiveStatisticsImpl::RegisterRtpStatisticsCallback(
   CriticalSectionScoped cs(receive_statistics_lock_.get());
   if (callback != NULL)
     assert(rtp_stats_callback_ == NULL);
-  rtp_stats_callback_ = callback;
+  rtc::AtomicOps::ReleaseStorePtr(&rtp_stats_callback_, callback);
+  // Packets that loaded the previous callback may still be calling it.
+  // Statisticians added from here on only see the new one.
+  for (StreamStatisticianImpl* statistician : statisticians_)
+    statistician->WaitForDataCountersCallbacks();
 }
 
 void ReceiveStatisticsImpl::DataCountersUpdated(const StreamDataCounters& stats,
                                                 uint32_t ssrc) {
-  CriticalSectionScoped cs(receive_statistics_lock_.get());
-  if (rtp_stats_callback_) {
-    rtp_stats_callback_->DataCountersUpdated(stats, ssrc);
-  }
+  StreamDataCountersCallback* callback =
+      rtc::AtomicOps::AcquireLoadPtr(&rtp_stats_callback_);
+  if (callback)
+    callback->DataCountersUpdated(stats, ssrc);
 }
 
 void NullReceiveStatistics::IncomingPacket(const RTPHeader& rtp_header,
@@ -16,8 +16,10 @@
 #include <algorithm>
 
 #include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/rtp_rtcp/source/bitrate.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/system_wrappers/interface/scoped_vector.h"
 
 namespace webrtc {
 
@@ -25,7 +27,8 @@ class CriticalSectionWrapper;
 
 class StreamStatisticianImpl : public StreamStatistician {
  public:
-  StreamStatisticianImpl(Clock* clock,
+  StreamStatisticianImpl(uint32_t ssrc,
+                         Clock* clock,
                          RtcpStatisticsCallback* rtcp_callback,
                          StreamDataCountersCallback* rtp_callback);
   virtual ~StreamStatisticianImpl() {}
@@ -41,6 +44,8 @@ class StreamStatisticianImpl : public StreamStatistician {
                                int64_t min_rtt) const override;
   bool IsPacketInOrder(uint16_t sequence_number) const override;
 
+  // IncomingPacket() and FecPacketReceived() update the stream without a
+  // lock, so they must not be called concurrently with each other.
   void IncomingPacket(const RTPHeader& rtp_header,
                       size_t packet_length,
                       bool retransmitted);
@@ -48,51 +53,99 @@ class StreamStatisticianImpl : public StreamStatistician {
   void SetMaxReorderingThreshold(int max_reordering_threshold);
   void ProcessBitrate();
   virtual void LastReceiveTimeNtp(uint32_t* secs, uint32_t* frac) const;
+  // Returns once no packet is calling a StreamDataCountersCallback it loaded
+  // before this was called.
+  void WaitForDataCountersCallbacks();
+
+  uint32_t ssrc() const { return ssrc_; }
 
  private:
-  bool InOrderPacketInternal(uint16_t sequence_number) const;
-  RtcpStatistics CalculateRtcpStatistics();
+  // Everything the packet path updates. Readers copy it out with
+  // ReadReceiveState() rather than locking out the packet path.
+  struct ReceiveState {
+    ReceiveState();
+
+    uint32_t jitter_q4;
+    uint32_t jitter_q4_transmission_time_offset;
+    int64_t last_receive_time_ms;
+    uint32_t last_receive_time_secs;
+    uint32_t last_receive_time_frac;
+    uint32_t last_received_timestamp;
+    int32_t last_received_transmission_time_offset;
+    uint16_t received_seq_first;
+    uint16_t received_seq_max;
+    uint16_t received_seq_wraps;
+
+    // Current counter values.
+    size_t received_packet_overhead;
+    StreamDataCounters receive_counters;
+
+    // Stored counter values. Includes sum of reset counter values for the
+    // stream.
+    StreamDataCounters stored_sum_receive_counters;
+
+    // The number of ResetStatistics() calls applied to this state.
+    int applied_resets;
+  };
+  static const size_t kStateWords =
+      (sizeof(ReceiveState) + sizeof(intptr_t) - 1) / sizeof(intptr_t);
+
+  // Copies |state_| to |published_state_|, seqlock style: the version is odd
+  // while the copy is written, and readers retry unless they copied it
+  // between two reads of the same even version. Both sides copy word by word
+  // with relaxed atomics, so a reader racing the packet path gets a torn copy
+  // it throws away rather than undefined behavior.
+  void PublishState();
+  // Returns the published state with any pending reset applied.
+  ReceiveState ReadReceiveState() const;
+  // Applies the resets requested since |state_| was last published.
+  void ApplyRequestedResets();
+  static void Reset(ReceiveState* state);
+
+  static bool InOrderPacketInternal(const ReceiveState& state,
+                                    int max_reordering_threshold,
+                                    uint16_t sequence_number);
+  RtcpStatistics CalculateRtcpStatistics(const ReceiveState& state)
+      EXCLUSIVE_LOCKS_REQUIRED(report_lock_);
   void UpdateJitter(const RTPHeader& header,
                     uint32_t receive_time_secs,
                     uint32_t receive_time_frac);
-  void UpdateCounters(const RTPHeader& rtp_header,
-                      size_t packet_length,
-                      bool retransmitted);
-  void NotifyRtpCallback() LOCKS_EXCLUDED(stream_lock_.get());
-  void NotifyRtcpCallback() LOCKS_EXCLUDED(stream_lock_.get());
+  StreamDataCounters UpdateCounters(const RTPHeader& rtp_header,
+                                    size_t packet_length,
+                                    bool retransmitted);
+  void NotifyDataCountersUpdated(const StreamDataCounters& counters);
+  void UpdateBitrate() const EXCLUSIVE_LOCKS_REQUIRED(report_lock_);
 
+  const uint32_t ssrc_;
   Clock* clock_;
-  rtc::scoped_ptr<CriticalSectionWrapper> stream_lock_;
-  Bitrate incoming_bitrate_;
-  uint32_t ssrc_;
-  int max_reordering_threshold_;  // In number of packets or sequence numbers.
-
-  // Stats on received RTP packets.
-  uint32_t jitter_q4_;
-  uint32_t cumulative_loss_;
-  uint32_t jitter_q4_transmission_time_offset_;
-
-  int64_t last_receive_time_ms_;
-  uint32_t last_receive_time_secs_;
-  uint32_t last_receive_time_frac_;
-  uint32_t last_received_timestamp_;
-  int32_t last_received_transmission_time_offset_;
-  uint16_t received_seq_first_;
-  uint16_t received_seq_max_;
-  uint16_t received_seq_wraps_;
-
-  // Current counter values.
-  size_t received_packet_overhead_;
-  StreamDataCounters receive_counters_;
-
-  // Stored counter values. Includes sum of reset counter values for the stream.
-  StreamDataCounters stored_sum_receive_counters_;
+
+  // Only accessed by the packet path.
+  ReceiveState state_;
+  volatile int published_version_;
+  volatile intptr_t published_state_[kStateWords];
+
+  // Set from other threads, read by the packet path.
+  volatile int max_reordering_threshold_;  // In number of packets or sequence
+                                           // numbers.
+  volatile int requested_resets_;
+  // The number of packets calling |rtp_callback_|.
+  volatile int data_counters_callbacks_;
+
+  // Guards the RTCP report bookkeeping and the bitrate. Never taken by the
+  // packet path.
+  rtc::scoped_ptr<CriticalSectionWrapper> report_lock_;
+  // The bytes and packets received are handed to |incoming_bitrate_| when it
+  // is read or processed instead of per packet, as it has a lock of its own.
+  mutable Bitrate incoming_bitrate_ GUARDED_BY(report_lock_);
+  mutable size_t bitrate_bytes_ GUARDED_BY(report_lock_);
+  mutable uint32_t bitrate_packets_ GUARDED_BY(report_lock_);
 
   // Counter values when we sent the last report.
-  uint32_t last_report_inorder_packets_;
-  uint32_t last_report_old_packets_;
-  uint16_t last_report_seq_max_;
-  RtcpStatistics last_reported_statistics_;
+  uint32_t cumulative_loss_ GUARDED_BY(report_lock_);
+  uint32_t last_report_inorder_packets_ GUARDED_BY(report_lock_);
+  uint32_t last_report_old_packets_ GUARDED_BY(report_lock_);
+  uint16_t last_report_seq_max_ GUARDED_BY(report_lock_);
+  RtcpStatistics last_reported_statistics_ GUARDED_BY(report_lock_);
 
   RtcpStatisticsCallback* const rtcp_callback_;
   StreamDataCountersCallback* const rtp_callback_;
@@ -127,21 +180,56 @@ class ReceiveStatisticsImpl : public ReceiveStatistics,
       StreamDataCountersCallback* callback) override;
 
  private:
+  // Open addressed hash table from SSRC to statistician. Statisticians are
+  // only added, so the table can be searched without taking a lock while
+  // another thread adds to it.
+  class StatisticianTable {
+   public:
+    explicit StatisticianTable(size_t capacity);
+
+    StreamStatisticianImpl* Find(uint32_t ssrc) const;
+    // Adds |statistician| if there is room for it, otherwise returns false.
+    bool Insert(StreamStatisticianImpl* statistician);
+
+    size_t capacity() const { return capacity_; }
+    // Returns the statistician in |slot|, which may be NULL.
+    StreamStatisticianImpl* at(size_t slot) const;
+
+   private:
+    const size_t capacity_;
+    size_t size_;
+    rtc::scoped_ptr<StreamStatisticianImpl* volatile[]> slots_;
+  };
+
   void StatisticsUpdated(const RtcpStatistics& statistics,
                          uint32_t ssrc) override;
   void CNameChanged(const char* cname, uint32_t ssrc) override;
   void DataCountersUpdated(const StreamDataCounters& counters,
                            uint32_t ssrc) override;
 
-  typedef std::map<uint32_t, StreamStatisticianImpl*> StatisticianImplMap;
+  const StatisticianTable* table() const;
+  StreamStatisticianImpl* GetOrCreateStatistician(uint32_t ssrc);
 
   Clock* clock_;
+  // Serializes adding statisticians, and guards the list of all of them.
   rtc::scoped_ptr<CriticalSectionWrapper> receive_statistics_lock_;
-  int64_t last_rate_update_ms_;
-  StatisticianImplMap statisticians_;
-
-  RtcpStatisticsCallback* rtcp_stats_callback_;
-  StreamDataCountersCallback* rtp_stats_callback_;
+  int64_t last_rate_update_ms_ GUARDED_BY(receive_statistics_lock_);
+  ScopedVector<StreamStatisticianImpl> statisticians_
+      GUARDED_BY(receive_statistics_lock_);
+  // Every table ever published. A reader may still be searching a table after
+  // it has been replaced by a bigger one, so they are kept until |this| is
+  // destroyed. Tables double in size, so this at most doubles their memory.
+  ScopedVector<StatisticianTable> tables_ GUARDED_BY(receive_statistics_lock_);
+  StatisticianTable* volatile current_table_;
+
+  // The RTCP callback is called with its lock held, so that it isn't called
+  // after having been deregistered.
+  rtc::scoped_ptr<CriticalSectionWrapper> rtcp_callback_lock_;
+  RtcpStatisticsCallback* rtcp_stats_callback_ GUARDED_BY(rtcp_callback_lock_);
+  // The RTP callback is called for every packet, so it is loaded without a
+  // lock. Registering a callback waits for the packets still calling the old
+  // one instead.
+  StreamDataCountersCallback* volatile rtp_stats_callback_;
 };
 }  // namespace webrtc
 #endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_RECEIVE_STATISTICS_IMPL_H_
@@ -0,0 +1,151 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/rtp_rtcp/interface/receive_statistics.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/thread_wrapper.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// An SFU receiving from a large conference.
+const size_t kNumSsrcs = 200;
+const int kNumPackets = 1000000;
+const size_t kPacketSize = 1200;
+const uint32_t kFirstSsrc = 0x12345678;
+
+// Generates RTP packets for |kNumSsrcs| streams, round robin.
+class PacketGenerator {
+ public:
+  PacketGenerator() : next_(0), headers_(kNumSsrcs) {
+    for (size_t i = 0; i < kNumSsrcs; ++i) {
+      memset(&headers_[i], 0, sizeof(headers_[i]));
+      headers_[i].ssrc = kFirstSsrc + 7919 * i;
+      headers_[i].sequenceNumber = static_cast<uint16_t>(i);
+      headers_[i].timestamp = 1000 * i;
+      headers_[i].headerLength = 12;
+      headers_[i].payload_type_frequency = 90000;
+    }
+  }
+
+  const RTPHeader& NextPacket() {
+    RTPHeader* header = &headers_[next_];
+    next_ = (next_ + 1) % kNumSsrcs;
+    ++header->sequenceNumber;
+    header->timestamp += 3000;
+    return *header;
+  }
+
+ private:
+  size_t next_;
+  std::vector<RTPHeader> headers_;
+};
+
+// Builds the report blocks of an RTCP receiver report over and over again, in
+// a thread of its own.
+class ReportGenerator {
+ public:
+  explicit ReportGenerator(ReceiveStatistics* receive_statistics)
+      : receive_statistics_(receive_statistics),
+        num_reports_(0),
+        thread_(ThreadWrapper::CreateThread(&ReportGenerator::Run, this,
+                                            "ReportGenerator")) {}
+
+  void Start() { EXPECT_TRUE(thread_->Start()); }
+  // Returns the number of reports built.
+  int Stop() {
+    EXPECT_TRUE(thread_->Stop());
+    return num_reports_;
+  }
+
+ private:
+  static bool Run(void* obj) {
+    static_cast<ReportGenerator*>(obj)->BuildReport();
+    return true;
+  }
+
+  // What RTCPSender does for a receiver report, plus the stats polling done
+  // by the receive streams.
+  void BuildReport() {
+    StatisticianMap statisticians =
+        receive_statistics_->GetActiveStatisticians();
+    for (StatisticianMap::const_iterator it = statisticians.begin();
+         it != statisticians.end(); ++it) {
+      RtcpStatistics statistics;
+      it->second->GetStatistics(&statistics, true);
+      StreamDataCounters counters;
+      it->second->GetReceiveStreamDataCounters(&counters);
+    }
+    ++num_reports_;
+  }
+
+  ReceiveStatistics* const receive_statistics_;
+  int num_reports_;
+  rtc::scoped_ptr<ThreadWrapper> thread_;
+};
+
+// Feeds |kNumPackets| packets to |receive_statistics| the way ViEReceiver
+// does, and returns the time it took in microseconds.
+int64_t IngestPackets(ReceiveStatistics* receive_statistics) {
+  PacketGenerator generator;
+  Clock* clock = Clock::GetRealTimeClock();
+  const int64_t start_us = clock->TimeInMicroseconds();
+  for (int i = 0; i < kNumPackets; ++i) {
+    const RTPHeader& header = generator.NextPacket();
+    StreamStatistician* statistician =
+        receive_statistics->GetStatistician(header.ssrc);
+    const bool in_order =
+        statistician == NULL ||
+        statistician->IsPacketInOrder(header.sequenceNumber);
+    receive_statistics->IncomingPacket(header, kPacketSize, !in_order);
+  }
+  return clock->TimeInMicroseconds() - start_us;
+}
+
+double PacketsPerSecond(int64_t elapsed_us) {
+  return 1e6 * kNumPackets / std::max<int64_t>(elapsed_us, 1);
+}
+
+}  // namespace
+
+TEST(ReceiveStatisticsPerfTest, IngestWithConcurrentReports) {
+  Clock* clock = Clock::GetRealTimeClock();
+  rtc::scoped_ptr<ReceiveStatistics> idle(ReceiveStatistics::Create(clock));
+  const int64_t idle_us = IngestPackets(idle.get());
+
+  rtc::scoped_ptr<ReceiveStatistics> receive_statistics(
+      ReceiveStatistics::Create(clock));
+  ReportGenerator reports(receive_statistics.get());
+  reports.Start();
+  const int64_t busy_us = IngestPackets(receive_statistics.get());
+  const int num_reports = reports.Stop();
+  EXPECT_EQ(kNumSsrcs,
+            receive_statistics->GetActiveStatisticians().size());
+
+  test::PrintResult("rtp_receive_statistics_ingest_rate", "_no_reports",
+                    "200_ssrcs", PacketsPerSecond(idle_us), "packets/s",
+                    false);
+  test::PrintResult("rtp_receive_statistics_ingest_rate", "_with_reports",
+                    "200_ssrcs", PacketsPerSecond(busy_us), "packets/s",
+                    true);
+  test::PrintResult("rtp_receive_statistics_report_rate", "", "200_ssrcs",
+                    1e6 * num_reports / std::max<int64_t>(busy_us, 1),
+                    "reports/s", false);
+}
+
+}  // namespace webrtc
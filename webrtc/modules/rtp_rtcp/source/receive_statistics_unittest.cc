@@ -132,6 +132,28 @@ TEST_F(ReceiveStatisticsTest, ActiveStatisticians) {
   EXPECT_EQ(2u, packets_received);
 }
 
+TEST_F(ReceiveStatisticsTest, ManySsrcs) {
+  // Enough streams to make the statistician table grow a few times.
+  const uint32_t kNumSsrcs = 200;
+  for (uint32_t ssrc = 1; ssrc <= kNumSsrcs; ++ssrc) {
+    header1_.ssrc = ssrc;
+    for (uint32_t i = 0; i < ssrc % 3 + 1; ++i) {
+      receive_statistics_->IncomingPacket(header1_, kPacketSize1, false);
+      ++header1_.sequenceNumber;
+    }
+  }
+  EXPECT_EQ(kNumSsrcs, receive_statistics_->GetActiveStatisticians().size());
+  for (uint32_t ssrc = 1; ssrc <= kNumSsrcs; ++ssrc) {
+    StreamStatistician* statistician =
+        receive_statistics_->GetStatistician(ssrc);
+    ASSERT_TRUE(statistician != NULL);
+    uint32_t packets_received = 0;
+    statistician->GetDataCounters(NULL, &packets_received);
+    EXPECT_EQ(ssrc % 3 + 1, packets_received);
+  }
+  EXPECT_TRUE(receive_statistics_->GetStatistician(kNumSsrcs + 1) == NULL);
+}
+
 TEST_F(ReceiveStatisticsTest, GetReceiveStreamDataCounters) {
   receive_statistics_->IncomingPacket(header1_, kPacketSize1, false);
   StreamStatistician* statistician =
@@ -148,11 +170,20 @@ TEST_F(ReceiveStatisticsTest, GetReceiveStreamDataCounters) {
   statistician->GetReceiveStreamDataCounters(&counters);
   EXPECT_GT(counters.first_packet_time_ms, -1);
   EXPECT_EQ(1u, counters.transmitted.packets);
+  // GetDataCounters doesn't, even before the next packet.
+  size_t bytes_received = 0;
+  uint32_t packets_received = 0;
+  statistician->GetDataCounters(&bytes_received, &packets_received);
+  EXPECT_EQ(0u, bytes_received);
+  EXPECT_EQ(0u, packets_received);
 
   receive_statistics_->IncomingPacket(header1_, kPacketSize1, false);
   statistician->GetReceiveStreamDataCounters(&counters);
   EXPECT_GT(counters.first_packet_time_ms, -1);
   EXPECT_EQ(2u, counters.transmitted.packets);
+  statistician->GetDataCounters(&bytes_received, &packets_received);
+  EXPECT_EQ(kPacketSize1, bytes_received);
+  EXPECT_EQ(1u, packets_received);
 }
 
 TEST_F(ReceiveStatisticsTest, RtcpCallbacks) {
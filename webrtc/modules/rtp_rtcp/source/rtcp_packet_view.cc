@@ -0,0 +1,310 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet_view.h"
+
+namespace webrtc {
+namespace rtcp {
+
+namespace {
+
+const uint8_t kRtcpVersion = 2;
+const uint8_t kSdesEndItem = 0;
+const uint8_t kSdesCnameItem = 1;
+const size_t kXrBlockHeaderLength = 4;
+
+size_t AlignTo4(size_t length) {
+  return (length + 3) & ~static_cast<size_t>(3);
+}
+
+}  // namespace
+
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |V=2|P|    IC   |      PT       |             length            |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+CompoundPacketReader::CompoundPacketReader(const uint8_t* buffer,
+                                           size_t length)
+    : next_(buffer), end_(buffer + length), error_(false) {}
+
+bool CompoundPacketReader::Next(PacketView* packet) {
+  if (next_ == end_ || error_)
+    return false;
+  const size_t remaining = end_ - next_;
+  if (remaining < PacketView::kHeaderLength ||
+      (next_[0] >> 6) != kRtcpVersion) {
+    error_ = true;
+    return false;
+  }
+  const size_t packet_length =
+      (ByteReader<uint16_t>::ReadBigEndian(&next_[2]) + 1) * 4;
+  if (packet_length > remaining) {
+    error_ = true;
+    return false;
+  }
+  size_t payload_length = packet_length - PacketView::kHeaderLength;
+  const bool has_padding = (next_[0] & 0x20) != 0;
+  if (has_padding) {
+    // The last octet holds the number of padding octets, itself included.
+    const uint8_t padding_length = next_[packet_length - 1];
+    if (padding_length == 0 || padding_length > payload_length) {
+      error_ = true;
+      return false;
+    }
+    payload_length -= padding_length;
+  }
+  packet->header_ = next_;
+  packet->payload_length_ = payload_length;
+  next_ += packet_length;
+  return true;
+}
+
+bool SenderReportView::Parse(const PacketView& packet) {
+  if (packet.packet_type() != kPacketType)
+    return false;
+  const size_t num_report_blocks = packet.count();
+  if (packet.payload_length() <
+      kSenderInfoLength + num_report_blocks * ReportBlockView::kLength) {
+    return false;
+  }
+  payload_ = packet.payload();
+  num_report_blocks_ = num_report_blocks;
+  return true;
+}
+
+bool ReceiverReportView::Parse(const PacketView& packet) {
+  if (packet.packet_type() != kPacketType)
+    return false;
+  const size_t num_report_blocks = packet.count();
+  if (packet.payload_length() <
+      4 + num_report_blocks * ReportBlockView::kLength) {
+    return false;
+  }
+  payload_ = packet.payload();
+  num_report_blocks_ = num_report_blocks;
+  return true;
+}
+
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+// |                          SSRC/CSRC_1                          |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |                           SDES items                          |
+// |                              ...                              |
+// +=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+=+
+//
+// Items are type (1 octet), length (1 octet) and text, terminated by a null
+// octet and padded to a 32-bit boundary.
+bool SdesView::Parse(const PacketView& packet) {
+  if (packet.packet_type() != kPacketType)
+    return false;
+  payload_ = packet.payload();
+  payload_length_ = packet.payload_length();
+  num_chunks_ = packet.count();
+  num_chunks_read_ = 0;
+  next_ = 0;
+
+  size_t offset = 0;
+  for (size_t i = 0; i < num_chunks_; ++i) {
+    const size_t chunk_begin = offset;
+    if (payload_length_ - offset < 4)
+      return false;
+    offset += 4;
+    while (true) {
+      if (offset >= payload_length_)
+        return false;
+      if (payload_[offset] == kSdesEndItem) {
+        ++offset;
+        break;
+      }
+      if (payload_length_ - offset < 2 ||
+          payload_length_ - offset - 2 < payload_[offset + 1]) {
+        return false;
+      }
+      offset += 2 + payload_[offset + 1];
+    }
+    offset = chunk_begin + AlignTo4(offset - chunk_begin);
+    if (offset > payload_length_)
+      return false;
+  }
+  return true;
+}
+
+bool SdesView::NextChunk(Chunk* chunk) {
+  if (num_chunks_read_ == num_chunks_)
+    return false;
+  // Parse() has validated the chunk.
+  const size_t chunk_begin = next_;
+  chunk->ssrc = ByteReader<uint32_t>::ReadBigEndian(&payload_[next_]);
+  chunk->cname = NULL;
+  chunk->cname_length = 0;
+  size_t offset = next_ + 4;
+  while (payload_[offset] != kSdesEndItem) {
+    const uint8_t item_length = payload_[offset + 1];
+    if (payload_[offset] == kSdesCnameItem) {
+      chunk->cname = reinterpret_cast<const char*>(&payload_[offset + 2]);
+      chunk->cname_length = item_length;
+    }
+    offset += 2 + item_length;
+  }
+  next_ = chunk_begin + AlignTo4(offset + 1 - chunk_begin);
+  ++num_chunks_read_;
+  return true;
+}
+
+bool ByeView::Parse(const PacketView& packet) {
+  if (packet.packet_type() != kPacketType)
+    return false;
+  const size_t num_ssrcs = packet.count();
+  if (packet.payload_length() < 4 * num_ssrcs)
+    return false;
+  payload_ = packet.payload();
+  num_ssrcs_ = num_ssrcs;
+  return true;
+}
+
+bool FeedbackView::ParseCommon(const PacketView& packet,
+                               uint8_t packet_type,
+                               uint8_t format) {
+  if (packet.packet_type() != packet_type || packet.count() != format ||
+      packet.payload_length() < kCommonFeedbackLength) {
+    return false;
+  }
+  payload_ = packet.payload();
+  fci_length_ = packet.payload_length() - kCommonFeedbackLength;
+  return true;
+}
+
+bool NackView::Parse(const PacketView& packet) {
+  if (!ParseCommon(packet, kPacketType, kFormat))
+    return false;
+  num_items_ = fci_length() / kItemLength;
+  return true;
+}
+
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |                              SSRC                             |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// | MxTBR Exp |  MxTBR Mantissa                 |Measured Overhead|
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+bool TmmbItemsView::ParseItems(const PacketView& packet, uint8_t format) {
+  if (!ParseCommon(packet, kPacketType, format))
+    return false;
+  num_items_ = fci_length() / kItemLength;
+  return true;
+}
+
+uint64_t TmmbItemsView::bitrate_bps(size_t index) const {
+  const uint32_t word = Read32(12 + index * kItemLength);
+  const uint8_t exponent = word >> 26;
+  const uint64_t mantissa = (word >> 9) & 0x1ffff;
+  return mantissa << exponent;
+}
+
+uint16_t TmmbItemsView::packet_overhead(size_t index) const {
+  return Read32(12 + index * kItemLength) & 0x1ff;
+}
+
+bool FirView::Parse(const PacketView& packet) {
+  if (!ParseCommon(packet, kPacketType, kFormat))
+    return false;
+  num_items_ = fci_length() / kItemLength;
+  return true;
+}
+
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |  Unique identifier 'R' 'E' 'M' 'B'                            |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |  Num SSRC     | BR Exp    |  BR Mantissa                      |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |   SSRC feedback                                               |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+bool RembView::Parse(const PacketView& packet) {
+  if (!ParseCommon(packet, kPacketType, kFormat) || fci_length() < 8 ||
+      fci()[0] != 'R' || fci()[1] != 'E' || fci()[2] != 'M' ||
+      fci()[3] != 'B') {
+    return false;
+  }
+  const size_t num_ssrcs = fci()[4];
+  if (fci_length() < 8 + 4 * num_ssrcs)
+    return false;
+  num_ssrcs_ = num_ssrcs;
+  return true;
+}
+
+uint64_t RembView::bitrate_bps() const {
+  const uint8_t exponent = fci()[5] >> 2;
+  const uint64_t mantissa =
+      ByteReader<uint32_t, 3>::ReadBigEndian(&fci()[5]) & 0x3ffff;
+  return mantissa << exponent;
+}
+
+//  0                   1                   2                   3
+//  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// |      BT       | type-specific |         block length          |
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+// :             type-specific block contents                      :
+// +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+bool XrView::Parse(const PacketView& packet) {
+  if (packet.packet_type() != kPacketType || packet.payload_length() < 4)
+    return false;
+  payload_ = packet.payload();
+  payload_length_ = packet.payload_length();
+  next_ = 4;
+  for (size_t offset = 4; offset < payload_length_;) {
+    if (payload_length_ - offset < kXrBlockHeaderLength)
+      return false;
+    const size_t contents_length =
+        4 * ByteReader<uint16_t>::ReadBigEndian(&payload_[offset + 2]);
+    offset += kXrBlockHeaderLength;
+    if (payload_length_ - offset < contents_length)
+      return false;
+    offset += contents_length;
+  }
+  return true;
+}
+
+bool XrView::NextBlock(XrBlockView* block) {
+  if (next_ >= payload_length_)
+    return false;
+  // Parse() has validated the block.
+  block->header_ = &payload_[next_];
+  block->contents_length_ =
+      4 * ByteReader<uint16_t>::ReadBigEndian(&payload_[next_ + 2]);
+  next_ += kXrBlockHeaderLength + block->contents_length_;
+  return true;
+}
+
+bool RrtrView::Parse(const XrBlockView& block) {
+  if (block.block_type() != kBlockType || block.contents_length() != 8)
+    return false;
+  contents_ = block.contents();
+  return true;
+}
+
+bool DlrrView::Parse(const XrBlockView& block) {
+  if (block.block_type() != kBlockType ||
+      block.contents_length() % kSubBlockLength != 0) {
+    return false;
+  }
+  contents_ = block.contents();
+  num_sub_blocks_ = block.contents_length() / kSubBlockLength;
+  return true;
+}
+
+}  // namespace rtcp
+}  // namespace webrtc
@@ -0,0 +1,448 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTCP_PACKET_VIEW_H_
+#define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTCP_PACKET_VIEW_H_
+
+#include <stddef.h>
+
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/typedefs.h"
+
+// Read-only views of received RTCP packets.
+//
+// Unlike RTCPUtility::RTCPParserV2, which copies every item into an
+// RTCPPacket union while stepping through a state machine, these views only
+// validate lengths and then read fields straight from the packet buffer on
+// access. A compound packet is walked once with CompoundPacketReader, and each
+// packet is interpreted by the view matching its type. No memory is allocated
+// and the views must not outlive the buffer.
+//
+// Example:
+//
+//  rtcp::CompoundPacketReader reader(buffer, length);
+//  rtcp::PacketView packet;
+//  while (reader.Next(&packet)) {
+//    rtcp::ReceiverReportView rr;
+//    if (packet.packet_type() == rtcp::ReceiverReportView::kPacketType &&
+//        rr.Parse(packet)) {
+//      for (size_t i = 0; i < rr.num_report_blocks(); ++i)
+//        HandleReportBlock(rr.sender_ssrc(), rr.report_block(i));
+//    }
+//  }
+//  if (reader.error())
+//    ...
+
+namespace webrtc {
+namespace rtcp {
+
+// One packet of a compound RTCP packet.
+class PacketView {
+ public:
+  static const size_t kHeaderLength = 4;
+
+  PacketView() : header_(NULL), payload_length_(0) {}
+
+  uint8_t packet_type() const { return header_[1]; }
+  // The 5-bit count, subtype or feedback message type field.
+  uint8_t count() const { return header_[0] & 0x1f; }
+  // Everything following the common header, without padding.
+  const uint8_t* payload() const { return header_ + kHeaderLength; }
+  size_t payload_length() const { return payload_length_; }
+
+ private:
+  friend class CompoundPacketReader;
+
+  const uint8_t* header_;
+  size_t payload_length_;
+};
+
+// Splits a compound packet into its packets, validating the common headers.
+class CompoundPacketReader {
+ public:
+  CompoundPacketReader(const uint8_t* buffer, size_t length);
+
+  // Returns the next packet in |packet|, or false when all packets have been
+  // read or the rest of the buffer is malformed.
+  bool Next(PacketView* packet);
+
+  // True if reading stopped at a malformed header.
+  bool error() const { return error_; }
+
+ private:
+  const uint8_t* next_;
+  const uint8_t* const end_;
+  bool error_;
+};
+
+// RFC 3550 report block, as found in SR and RR packets.
+class ReportBlockView {
+ public:
+  static const size_t kLength = 24;
+
+  explicit ReportBlockView(const uint8_t* data) : data_(data) {}
+
+  uint32_t source_ssrc() const { return Read32(0); }
+  uint8_t fraction_lost() const { return data_[4]; }
+  uint32_t cumulative_lost() const {
+    return ByteReader<uint32_t, 3>::ReadBigEndian(&data_[5]);
+  }
+  uint32_t extended_high_seq_num() const { return Read32(8); }
+  uint32_t jitter() const { return Read32(12); }
+  uint32_t last_sr() const { return Read32(16); }
+  uint32_t delay_since_last_sr() const { return Read32(20); }
+
+ private:
+  uint32_t Read32(size_t offset) const {
+    return ByteReader<uint32_t>::ReadBigEndian(&data_[offset]);
+  }
+
+  const uint8_t* data_;
+};
+
+// Sender report (PT=200).
+class SenderReportView {
+ public:
+  static const uint8_t kPacketType = 200;
+
+  SenderReportView() : payload_(NULL), num_report_blocks_(0) {}
+
+  bool Parse(const PacketView& packet);
+
+  uint32_t sender_ssrc() const { return Read32(0); }
+  uint32_t ntp_seconds() const { return Read32(4); }
+  uint32_t ntp_fraction() const { return Read32(8); }
+  uint32_t rtp_timestamp() const { return Read32(12); }
+  uint32_t packet_count() const { return Read32(16); }
+  uint32_t octet_count() const { return Read32(20); }
+
+  size_t num_report_blocks() const { return num_report_blocks_; }
+  ReportBlockView report_block(size_t index) const {
+    return ReportBlockView(
+        &payload_[kSenderInfoLength + index * ReportBlockView::kLength]);
+  }
+
+ private:
+  // Sender SSRC and sender info.
+  static const size_t kSenderInfoLength = 24;
+
+  uint32_t Read32(size_t offset) const {
+    return ByteReader<uint32_t>::ReadBigEndian(&payload_[offset]);
+  }
+
+  const uint8_t* payload_;
+  size_t num_report_blocks_;
+};
+
+// Receiver report (PT=201).
+class ReceiverReportView {
+ public:
+  static const uint8_t kPacketType = 201;
+
+  ReceiverReportView() : payload_(NULL), num_report_blocks_(0) {}
+
+  bool Parse(const PacketView& packet);
+
+  uint32_t sender_ssrc() const {
+    return ByteReader<uint32_t>::ReadBigEndian(payload_);
+  }
+
+  size_t num_report_blocks() const { return num_report_blocks_; }
+  ReportBlockView report_block(size_t index) const {
+    return ReportBlockView(&payload_[4 + index * ReportBlockView::kLength]);
+  }
+
+ private:
+  const uint8_t* payload_;
+  size_t num_report_blocks_;
+};
+
+// Source description (PT=202). Only the CNAME item is exposed.
+class SdesView {
+ public:
+  static const uint8_t kPacketType = 202;
+
+  struct Chunk {
+    uint32_t ssrc;
+    // Not null terminated. NULL if the chunk has no CNAME item.
+    const char* cname;
+    size_t cname_length;
+  };
+
+  SdesView()
+      : payload_(NULL),
+        payload_length_(0),
+        num_chunks_(0),
+        num_chunks_read_(0),
+        next_(0) {}
+
+  // Validates all chunks.
+  bool Parse(const PacketView& packet);
+
+  size_t num_chunks() const { return num_chunks_; }
+  // Returns the chunks in order, false after the last one.
+  bool NextChunk(Chunk* chunk);
+
+ private:
+  const uint8_t* payload_;
+  size_t payload_length_;
+  size_t num_chunks_;
+  size_t num_chunks_read_;
+  // Offset of the next chunk in |payload_|.
+  size_t next_;
+};
+
+// Goodbye (PT=203).
+class ByeView {
+ public:
+  static const uint8_t kPacketType = 203;
+
+  ByeView() : payload_(NULL), num_ssrcs_(0) {}
+
+  bool Parse(const PacketView& packet);
+
+  size_t num_ssrcs() const { return num_ssrcs_; }
+  uint32_t ssrc(size_t index) const {
+    return ByteReader<uint32_t>::ReadBigEndian(&payload_[4 * index]);
+  }
+
+ private:
+  const uint8_t* payload_;
+  size_t num_ssrcs_;
+};
+
+// Common part of the RFC 4585 feedback messages.
+class FeedbackView {
+ public:
+  static const size_t kCommonFeedbackLength = 8;
+
+  uint32_t sender_ssrc() const { return Read32(0); }
+  uint32_t media_ssrc() const { return Read32(4); }
+
+ protected:
+  FeedbackView() : payload_(NULL), fci_length_(0) {}
+
+  // Checks the packet type and format and that the common part is complete.
+  bool ParseCommon(const PacketView& packet,
+                   uint8_t packet_type,
+                   uint8_t format);
+
+  const uint8_t* fci() const { return &payload_[kCommonFeedbackLength]; }
+  size_t fci_length() const { return fci_length_; }
+  uint32_t Read32(size_t offset) const {
+    return ByteReader<uint32_t>::ReadBigEndian(&payload_[offset]);
+  }
+
+ private:
+  const uint8_t* payload_;
+  size_t fci_length_;
+};
+
+// Generic NACK (RTPFB, FMT=1).
+class NackView : public FeedbackView {
+ public:
+  static const uint8_t kPacketType = 205;
+  static const uint8_t kFormat = 1;
+  static const size_t kItemLength = 4;
+
+  NackView() : num_items_(0) {}
+
+  bool Parse(const PacketView& packet);
+
+  size_t num_items() const { return num_items_; }
+  // The first lost packet of item |index|.
+  uint16_t packet_id(size_t index) const {
+    return ByteReader<uint16_t>::ReadBigEndian(&fci()[index * kItemLength]);
+  }
+  // Bit i set means that packet_id() + i + 1 was lost too.
+  uint16_t bitmask(size_t index) const {
+    return ByteReader<uint16_t>::ReadBigEndian(
+        &fci()[index * kItemLength + 2]);
+  }
+
+ private:
+  size_t num_items_;
+};
+
+// TMMBR (RTPFB, FMT=3) and TMMBN (RTPFB, FMT=4), RFC 5104, which share the
+// item format.
+class TmmbItemsView : public FeedbackView {
+ public:
+  static const uint8_t kPacketType = 205;
+  static const size_t kItemLength = 8;
+
+  size_t num_items() const { return num_items_; }
+  uint32_t ssrc(size_t index) const { return Read32(8 + index * kItemLength); }
+  uint64_t bitrate_bps(size_t index) const;
+  uint16_t packet_overhead(size_t index) const;
+
+ protected:
+  TmmbItemsView() : num_items_(0) {}
+
+  bool ParseItems(const PacketView& packet, uint8_t format);
+
+ private:
+  size_t num_items_;
+};
+
+class TmmbrView : public TmmbItemsView {
+ public:
+  static const uint8_t kFormat = 3;
+
+  bool Parse(const PacketView& packet) { return ParseItems(packet, kFormat); }
+};
+
+class TmmbnView : public TmmbItemsView {
+ public:
+  static const uint8_t kFormat = 4;
+
+  bool Parse(const PacketView& packet) { return ParseItems(packet, kFormat); }
+};
+
+// Picture loss indication (PSFB, FMT=1).
+class PliView : public FeedbackView {
+ public:
+  static const uint8_t kPacketType = 206;
+  static const uint8_t kFormat = 1;
+
+  bool Parse(const PacketView& packet) {
+    return ParseCommon(packet, kPacketType, kFormat);
+  }
+};
+
+// Full intra request (PSFB, FMT=4), RFC 5104.
+class FirView : public FeedbackView {
+ public:
+  static const uint8_t kPacketType = 206;
+  static const uint8_t kFormat = 4;
+  static const size_t kItemLength = 8;
+
+  FirView() : num_items_(0) {}
+
+  bool Parse(const PacketView& packet);
+
+  size_t num_items() const { return num_items_; }
+  uint32_t ssrc(size_t index) const { return Read32(8 + index * kItemLength); }
+  uint8_t seq_nr(size_t index) const { return fci()[index * kItemLength + 4]; }
+
+ private:
+  size_t num_items_;
+};
+
+// Receiver estimated max bitrate (PSFB, FMT=15, "REMB"),
+// draft-alvestrand-rmcat-remb.
+class RembView : public FeedbackView {
+ public:
+  static const uint8_t kPacketType = 206;
+  static const uint8_t kFormat = 15;
+
+  RembView() : num_ssrcs_(0) {}
+
+  // Fails for application layer feedback other than REMB.
+  bool Parse(const PacketView& packet);
+
+  uint64_t bitrate_bps() const;
+  size_t num_ssrcs() const { return num_ssrcs_; }
+  uint32_t ssrc(size_t index) const { return Read32(16 + 4 * index); }
+
+ private:
+  size_t num_ssrcs_;
+};
+
+// One report block of an XR packet.
+class XrBlockView {
+ public:
+  XrBlockView() : header_(NULL), contents_length_(0) {}
+
+  uint8_t block_type() const { return header_[0]; }
+  const uint8_t* contents() const { return &header_[4]; }
+  size_t contents_length() const { return contents_length_; }
+
+ private:
+  friend class XrView;
+
+  const uint8_t* header_;
+  size_t contents_length_;
+};
+
+// Extended report (PT=207), RFC 3611.
+class XrView {
+ public:
+  static const uint8_t kPacketType = 207;
+
+  XrView() : payload_(NULL), payload_length_(0), next_(0) {}
+
+  // Validates the lengths of all report blocks.
+  bool Parse(const PacketView& packet);
+
+  uint32_t sender_ssrc() const {
+    return ByteReader<uint32_t>::ReadBigEndian(payload_);
+  }
+  // Returns the report blocks in order, false after the last one.
+  bool NextBlock(XrBlockView* block);
+
+ private:
+  const uint8_t* payload_;
+  size_t payload_length_;
+  // Offset of the next report block in |payload_|.
+  size_t next_;
+};
+
+// Receiver reference time report block (BT=4).
+class RrtrView {
+ public:
+  static const uint8_t kBlockType = 4;
+
+  RrtrView() : contents_(NULL) {}
+
+  bool Parse(const XrBlockView& block);
+
+  uint32_t ntp_seconds() const {
+    return ByteReader<uint32_t>::ReadBigEndian(contents_);
+  }
+  uint32_t ntp_fraction() const {
+    return ByteReader<uint32_t>::ReadBigEndian(&contents_[4]);
+  }
+
+ private:
+  const uint8_t* contents_;
+};
+
+// DLRR report block (BT=5).
+class DlrrView {
+ public:
+  static const uint8_t kBlockType = 5;
+  static const size_t kSubBlockLength = 12;
+
+  DlrrView() : contents_(NULL), num_sub_blocks_(0) {}
+
+  bool Parse(const XrBlockView& block);
+
+  size_t num_sub_blocks() const { return num_sub_blocks_; }
+  uint32_t ssrc(size_t index) const { return Read32(index, 0); }
+  uint32_t last_rr(size_t index) const { return Read32(index, 4); }
+  uint32_t delay_since_last_rr(size_t index) const {
+    return Read32(index, 8);
+  }
+
+ private:
+  uint32_t Read32(size_t index, size_t offset) const {
+    return ByteReader<uint32_t>::ReadBigEndian(
+        &contents_[index * kSubBlockLength + offset]);
+  }
+
+  const uint8_t* contents_;
+  size_t num_sub_blocks_;
+};
+
+}  // namespace rtcp
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_RTCP_PACKET_VIEW_H_
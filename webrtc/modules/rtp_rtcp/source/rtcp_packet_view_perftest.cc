@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet_view.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_utility.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kNumIterations = 200000;
+const uint32_t kSenderSsrc = 0x12345678;
+const uint32_t kMediaSsrc = 0x23456789;
+
+// A typical compound packet of a video receiver: RR, SDES, REMB and NACK.
+std::vector<uint8_t> BuildReceiverPacket() {
+  rtcp::ReceiverReport rr;
+  rr.From(kSenderSsrc);
+  for (uint32_t i = 0; i < 4; ++i) {
+    rtcp::ReportBlock rb;
+    rb.To(kMediaSsrc + i);
+    rb.WithExtHighestSeqNum(1000 + i);
+    rb.WithJitter(i);
+    rr.WithReportBlock(rb);
+  }
+  rtcp::Sdes sdes;
+  sdes.WithCName(kSenderSsrc, "zCfFsDJGvJ7ZRgD5");
+  rtcp::Remb remb;
+  remb.From(kSenderSsrc);
+  remb.AppliesTo(kMediaSsrc);
+  remb.WithBitrateBps(2500000);
+  rtcp::Nack nack;
+  nack.From(kSenderSsrc);
+  nack.To(kMediaSsrc);
+  const uint16_t kNackList[] = {100, 101, 105, 130, 170, 171};
+  nack.WithList(kNackList, sizeof(kNackList) / sizeof(kNackList[0]));
+  rr.Append(&sdes);
+  rr.Append(&remb);
+  rr.Append(&nack);
+  rtc::scoped_ptr<rtcp::RawPacket> packet(rr.Build());
+  return std::vector<uint8_t>(packet->Buffer(),
+                              packet->Buffer() + packet->Length());
+}
+
+// Reads the same fields with both parsers, so that the work is comparable.
+uint32_t ParseWithParserV2(const std::vector<uint8_t>& buffer) {
+  uint32_t sum = 0;
+  RTCPUtility::RTCPParserV2 parser(&buffer[0], buffer.size(), true);
+  for (RTCPUtility::RTCPPacketTypes type = parser.Begin();
+       type != RTCPUtility::RTCPPacketTypes::kInvalid;
+       type = parser.Iterate()) {
+    const RTCPUtility::RTCPPacket& packet = parser.Packet();
+    switch (type) {
+      case RTCPUtility::RTCPPacketTypes::kRr:
+        sum += packet.RR.SenderSSRC;
+        break;
+      case RTCPUtility::RTCPPacketTypes::kReportBlockItem:
+        sum += packet.ReportBlockItem.ExtendedHighestSequenceNumber +
+               packet.ReportBlockItem.Jitter;
+        break;
+      case RTCPUtility::RTCPPacketTypes::kSdesChunk:
+        sum += packet.CName.SenderSSRC + packet.CName.CName[0];
+        break;
+      case RTCPUtility::RTCPPacketTypes::kPsfbRembItem:
+        sum += packet.REMBItem.BitRate + packet.REMBItem.SSRCs[0];
+        break;
+      case RTCPUtility::RTCPPacketTypes::kRtpfbNackItem:
+        sum += packet.NACKItem.PacketID + packet.NACKItem.BitMask;
+        break;
+      default:
+        break;
+    }
+  }
+  return sum;
+}
+
+uint32_t ParseWithViews(const std::vector<uint8_t>& buffer) {
+  uint32_t sum = 0;
+  rtcp::CompoundPacketReader reader(&buffer[0], buffer.size());
+  rtcp::PacketView packet;
+  while (reader.Next(&packet)) {
+    switch (packet.packet_type()) {
+      case rtcp::ReceiverReportView::kPacketType: {
+        rtcp::ReceiverReportView rr;
+        if (!rr.Parse(packet))
+          break;
+        sum += rr.sender_ssrc();
+        for (size_t i = 0; i < rr.num_report_blocks(); ++i) {
+          rtcp::ReportBlockView block = rr.report_block(i);
+          sum += block.extended_high_seq_num() + block.jitter();
+        }
+        break;
+      }
+      case rtcp::SdesView::kPacketType: {
+        rtcp::SdesView sdes;
+        rtcp::SdesView::Chunk chunk;
+        if (!sdes.Parse(packet))
+          break;
+        while (sdes.NextChunk(&chunk)) {
+          if (chunk.cname && chunk.cname_length > 0)
+            sum += chunk.ssrc + chunk.cname[0];
+        }
+        break;
+      }
+      case rtcp::RembView::kPacketType: {
+        rtcp::RembView remb;
+        if (remb.Parse(packet) && remb.num_ssrcs() > 0) {
+          sum += static_cast<uint32_t>(remb.bitrate_bps()) + remb.ssrc(0);
+        }
+        break;
+      }
+      case rtcp::NackView::kPacketType: {
+        rtcp::NackView nack;
+        if (!nack.Parse(packet))
+          break;
+        for (size_t i = 0; i < nack.num_items(); ++i)
+          sum += nack.packet_id(i) + nack.bitmask(i);
+        break;
+      }
+    }
+  }
+  return sum;
+}
+
+}  // namespace
+
+TEST(RtcpPacketViewPerfTest, ParseThroughput) {
+  const std::vector<uint8_t> buffer = BuildReceiverPacket();
+  ASSERT_EQ(ParseWithParserV2(buffer), ParseWithViews(buffer));
+  Clock* clock = Clock::GetRealTimeClock();
+
+  uint32_t sum = 0;
+  int64_t start_us = clock->TimeInMicroseconds();
+  for (int i = 0; i < kNumIterations; ++i)
+    sum += ParseWithParserV2(buffer);
+  const int64_t parser_v2_us = clock->TimeInMicroseconds() - start_us;
+
+  start_us = clock->TimeInMicroseconds();
+  for (int i = 0; i < kNumIterations; ++i)
+    sum -= ParseWithViews(buffer);
+  const int64_t views_us = clock->TimeInMicroseconds() - start_us;
+  EXPECT_EQ(0u, sum);
+
+  test::PrintResult("rtcp_parse_rate", "", "parser_v2",
+                    kNumIterations * 1e6 / parser_v2_us, "packets/s", false);
+  test::PrintResult("rtcp_parse_rate", "", "views",
+                    kNumIterations * 1e6 / views_us, "packets/s", true);
+}
+
+}  // namespace webrtc
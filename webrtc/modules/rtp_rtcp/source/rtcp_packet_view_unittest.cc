@@ -0,0 +1,435 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet_view.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet.h"
+
+namespace webrtc {
+namespace rtcp {
+namespace {
+
+const uint32_t kSenderSsrc = 0x12345678;
+const uint32_t kRemoteSsrc = 0x23456789;
+
+std::vector<uint8_t> Serialize(const RtcpPacket& packet) {
+  rtc::scoped_ptr<RawPacket> raw(packet.Build());
+  return std::vector<uint8_t>(raw->Buffer(), raw->Buffer() + raw->Length());
+}
+
+// Reads the single packet in |buffer|.
+PacketView ReadOnePacket(const std::vector<uint8_t>& buffer) {
+  CompoundPacketReader reader(&buffer[0], buffer.size());
+  PacketView packet;
+  EXPECT_TRUE(reader.Next(&packet));
+  PacketView next;
+  EXPECT_FALSE(reader.Next(&next));
+  EXPECT_FALSE(reader.error());
+  return packet;
+}
+
+class BoundsChecker {
+ public:
+  BoundsChecker(const uint8_t* begin, size_t length)
+      : begin_(begin), end_(begin + length) {}
+
+  void Check(const uint8_t* data, size_t length) const {
+    ASSERT_TRUE(data >= begin_ && data + length <= end_);
+  }
+
+ private:
+  const uint8_t* const begin_;
+  const uint8_t* const end_;
+};
+
+// Parses |buffer| with every view, checking that nothing outside of it is
+// referenced. Returns the number of packets that parsed as a known type.
+int ParseEverything(const std::vector<uint8_t>& buffer) {
+  // Exactly sized heap copy, so that memory tools catch overreads.
+  rtc::scoped_ptr<uint8_t[]> data(new uint8_t[buffer.size()]);
+  if (!buffer.empty())
+    memcpy(data.get(), &buffer[0], buffer.size());
+  const BoundsChecker bounds(data.get(), buffer.size());
+  int num_parsed = 0;
+  uint64_t sum = 0;
+
+  CompoundPacketReader reader(data.get(), buffer.size());
+  PacketView packet;
+  while (reader.Next(&packet)) {
+    bounds.Check(packet.payload(), packet.payload_length());
+    SenderReportView sr;
+    ReceiverReportView rr;
+    SdesView sdes;
+    ByeView bye;
+    NackView nack;
+    TmmbrView tmmbr;
+    TmmbnView tmmbn;
+    PliView pli;
+    FirView fir;
+    RembView remb;
+    XrView xr;
+    if (sr.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 24);
+      sum += sr.sender_ssrc() + sr.ntp_seconds() + sr.octet_count();
+      for (size_t i = 0; i < sr.num_report_blocks(); ++i) {
+        bounds.Check(packet.payload() + 24 + 24 * i, ReportBlockView::kLength);
+        sum += sr.report_block(i).delay_since_last_sr();
+      }
+    } else if (rr.Parse(packet)) {
+      ++num_parsed;
+      sum += rr.sender_ssrc();
+      for (size_t i = 0; i < rr.num_report_blocks(); ++i) {
+        bounds.Check(packet.payload() + 4 + 24 * i, ReportBlockView::kLength);
+        sum += rr.report_block(i).delay_since_last_sr();
+      }
+    } else if (sdes.Parse(packet)) {
+      ++num_parsed;
+      SdesView::Chunk chunk;
+      size_t num_chunks = 0;
+      while (sdes.NextChunk(&chunk)) {
+        ++num_chunks;
+        if (chunk.cname) {
+          bounds.Check(reinterpret_cast<const uint8_t*>(chunk.cname),
+                       chunk.cname_length);
+        }
+      }
+      EXPECT_EQ(sdes.num_chunks(), num_chunks);
+    } else if (bye.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 4 * bye.num_ssrcs());
+    } else if (nack.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 8 + 4 * nack.num_items());
+      for (size_t i = 0; i < nack.num_items(); ++i)
+        sum += nack.packet_id(i) + nack.bitmask(i);
+    } else if (tmmbr.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 8 + 8 * tmmbr.num_items());
+      for (size_t i = 0; i < tmmbr.num_items(); ++i)
+        sum += tmmbr.bitrate_bps(i) + tmmbr.packet_overhead(i);
+    } else if (tmmbn.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 8 + 8 * tmmbn.num_items());
+      for (size_t i = 0; i < tmmbn.num_items(); ++i)
+        sum += tmmbn.bitrate_bps(i) + tmmbn.packet_overhead(i);
+    } else if (pli.Parse(packet)) {
+      ++num_parsed;
+      sum += pli.media_ssrc();
+    } else if (fir.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 8 + 8 * fir.num_items());
+      for (size_t i = 0; i < fir.num_items(); ++i)
+        sum += fir.ssrc(i) + fir.seq_nr(i);
+    } else if (remb.Parse(packet)) {
+      ++num_parsed;
+      bounds.Check(packet.payload(), 16 + 4 * remb.num_ssrcs());
+      sum += remb.bitrate_bps();
+    } else if (xr.Parse(packet)) {
+      ++num_parsed;
+      XrBlockView block;
+      while (xr.NextBlock(&block)) {
+        bounds.Check(block.contents(), block.contents_length());
+        RrtrView rrtr;
+        DlrrView dlrr;
+        if (rrtr.Parse(block))
+          sum += rrtr.ntp_seconds() + rrtr.ntp_fraction();
+        if (dlrr.Parse(block)) {
+          for (size_t i = 0; i < dlrr.num_sub_blocks(); ++i)
+            sum += dlrr.delay_since_last_rr(i);
+        }
+      }
+    }
+  }
+  // Keep the reads from being optimized away.
+  volatile uint64_t sink = sum;
+  static_cast<void>(sink);
+  return num_parsed;
+}
+
+std::vector<uint8_t> BuildCompoundPacket() {
+  ReceiverReport rr;
+  rr.From(kSenderSsrc);
+  for (uint32_t i = 0; i < 3; ++i) {
+    ReportBlock rb;
+    rb.To(kRemoteSsrc + i);
+    rb.WithJitter(i);
+    EXPECT_TRUE(rr.WithReportBlock(rb));
+  }
+  Sdes sdes;
+  EXPECT_TRUE(sdes.WithCName(kSenderSsrc, "alice@example.com"));
+  EXPECT_TRUE(sdes.WithCName(kSenderSsrc + 1, ""));
+  Remb remb;
+  remb.From(kSenderSsrc);
+  remb.AppliesTo(kRemoteSsrc);
+  remb.WithBitrateBps(1234567);
+  Nack nack;
+  nack.From(kSenderSsrc);
+  nack.To(kRemoteSsrc);
+  const uint16_t kNackList[] = {1, 2, 3, 50, 100};
+  nack.WithList(kNackList, 5);
+  Fir fir;
+  fir.From(kSenderSsrc);
+  fir.To(kRemoteSsrc);
+  fir.WithCommandSeqNum(7);
+  Tmmbr tmmbr;
+  tmmbr.From(kSenderSsrc);
+  tmmbr.To(kRemoteSsrc);
+  tmmbr.WithBitrateKbps(300);
+  Xr xr;
+  xr.From(kSenderSsrc);
+  Rrtr rrtr;
+  rrtr.WithNtpSec(1);
+  rrtr.WithNtpFrac(2);
+  EXPECT_TRUE(xr.WithRrtr(&rrtr));
+  Dlrr dlrr;
+  EXPECT_TRUE(dlrr.WithDlrrItem(kRemoteSsrc, 3, 4));
+  EXPECT_TRUE(xr.WithDlrr(&dlrr));
+  rr.Append(&sdes);
+  rr.Append(&remb);
+  rr.Append(&nack);
+  rr.Append(&fir);
+  rr.Append(&tmmbr);
+  rr.Append(&xr);
+  return Serialize(rr);
+}
+
+}  // namespace
+
+TEST(RtcpPacketViewTest, SenderReport) {
+  SenderReport sr;
+  sr.From(kSenderSsrc);
+  sr.WithNtpSec(0x11111111);
+  sr.WithNtpFrac(0x22222222);
+  sr.WithRtpTimestamp(0x33333333);
+  sr.WithPacketCount(0x44444444);
+  sr.WithOctetCount(0x55555555);
+  ReportBlock rb;
+  rb.To(kRemoteSsrc);
+  rb.WithFractionLost(55);
+  rb.WithCumulativeLost(0x111111);
+  rb.WithExtHighestSeqNum(0x22222222);
+  rb.WithJitter(0x33333333);
+  rb.WithLastSr(0x44444444);
+  rb.WithDelayLastSr(0x55555555);
+  EXPECT_TRUE(sr.WithReportBlock(rb));
+  std::vector<uint8_t> buffer = Serialize(sr);
+
+  SenderReportView view;
+  ASSERT_TRUE(view.Parse(ReadOnePacket(buffer)));
+  EXPECT_EQ(kSenderSsrc, view.sender_ssrc());
+  EXPECT_EQ(0x11111111u, view.ntp_seconds());
+  EXPECT_EQ(0x22222222u, view.ntp_fraction());
+  EXPECT_EQ(0x33333333u, view.rtp_timestamp());
+  EXPECT_EQ(0x44444444u, view.packet_count());
+  EXPECT_EQ(0x55555555u, view.octet_count());
+  ASSERT_EQ(1u, view.num_report_blocks());
+  ReportBlockView block = view.report_block(0);
+  EXPECT_EQ(kRemoteSsrc, block.source_ssrc());
+  EXPECT_EQ(55u, block.fraction_lost());
+  EXPECT_EQ(0x111111u, block.cumulative_lost());
+  EXPECT_EQ(0x22222222u, block.extended_high_seq_num());
+  EXPECT_EQ(0x33333333u, block.jitter());
+  EXPECT_EQ(0x44444444u, block.last_sr());
+  EXPECT_EQ(0x55555555u, block.delay_since_last_sr());
+
+  ReceiverReportView rr_view;
+  EXPECT_FALSE(rr_view.Parse(ReadOnePacket(buffer)));
+}
+
+TEST(RtcpPacketViewTest, CompoundPacket) {
+  std::vector<uint8_t> buffer = BuildCompoundPacket();
+  CompoundPacketReader reader(&buffer[0], buffer.size());
+  PacketView packet;
+
+  ASSERT_TRUE(reader.Next(&packet));
+  ReceiverReportView rr;
+  ASSERT_TRUE(rr.Parse(packet));
+  EXPECT_EQ(kSenderSsrc, rr.sender_ssrc());
+  ASSERT_EQ(3u, rr.num_report_blocks());
+  EXPECT_EQ(kRemoteSsrc + 2, rr.report_block(2).source_ssrc());
+  EXPECT_EQ(2u, rr.report_block(2).jitter());
+
+  ASSERT_TRUE(reader.Next(&packet));
+  SdesView sdes;
+  ASSERT_TRUE(sdes.Parse(packet));
+  ASSERT_EQ(2u, sdes.num_chunks());
+  SdesView::Chunk chunk;
+  ASSERT_TRUE(sdes.NextChunk(&chunk));
+  EXPECT_EQ(kSenderSsrc, chunk.ssrc);
+  EXPECT_EQ("alice@example.com", std::string(chunk.cname, chunk.cname_length));
+  ASSERT_TRUE(sdes.NextChunk(&chunk));
+  EXPECT_EQ(kSenderSsrc + 1, chunk.ssrc);
+  ASSERT_TRUE(chunk.cname != NULL);
+  EXPECT_EQ(0u, chunk.cname_length);
+  EXPECT_FALSE(sdes.NextChunk(&chunk));
+
+  ASSERT_TRUE(reader.Next(&packet));
+  RembView remb;
+  ASSERT_TRUE(remb.Parse(packet));
+  EXPECT_EQ(kSenderSsrc, remb.sender_ssrc());
+  ASSERT_EQ(1u, remb.num_ssrcs());
+  EXPECT_EQ(kRemoteSsrc, remb.ssrc(0));
+  // The mantissa has 18 bits, so the low bits are lost.
+  EXPECT_NEAR(1234567.0, static_cast<double>(remb.bitrate_bps()), 8.0);
+  EXPECT_LE(remb.bitrate_bps(), 1234567u);
+
+  ASSERT_TRUE(reader.Next(&packet));
+  NackView nack;
+  ASSERT_TRUE(nack.Parse(packet));
+  EXPECT_EQ(kRemoteSsrc, nack.media_ssrc());
+  ASSERT_EQ(3u, nack.num_items());
+  EXPECT_EQ(1u, nack.packet_id(0));
+  EXPECT_EQ(0x3u, nack.bitmask(0));
+  EXPECT_EQ(50u, nack.packet_id(1));
+  EXPECT_EQ(0u, nack.bitmask(1));
+  EXPECT_EQ(100u, nack.packet_id(2));
+
+  ASSERT_TRUE(reader.Next(&packet));
+  FirView fir;
+  EXPECT_FALSE(PliView().Parse(packet));
+  ASSERT_TRUE(fir.Parse(packet));
+  ASSERT_EQ(1u, fir.num_items());
+  EXPECT_EQ(kRemoteSsrc, fir.ssrc(0));
+  EXPECT_EQ(7u, fir.seq_nr(0));
+
+  ASSERT_TRUE(reader.Next(&packet));
+  TmmbrView tmmbr;
+  EXPECT_FALSE(TmmbnView().Parse(packet));
+  ASSERT_TRUE(tmmbr.Parse(packet));
+  ASSERT_EQ(1u, tmmbr.num_items());
+  EXPECT_EQ(kRemoteSsrc, tmmbr.ssrc(0));
+  EXPECT_EQ(300000u, tmmbr.bitrate_bps(0));
+
+  ASSERT_TRUE(reader.Next(&packet));
+  XrView xr;
+  ASSERT_TRUE(xr.Parse(packet));
+  EXPECT_EQ(kSenderSsrc, xr.sender_ssrc());
+  XrBlockView block;
+  ASSERT_TRUE(xr.NextBlock(&block));
+  RrtrView rrtr;
+  ASSERT_TRUE(rrtr.Parse(block));
+  EXPECT_EQ(1u, rrtr.ntp_seconds());
+  EXPECT_EQ(2u, rrtr.ntp_fraction());
+  ASSERT_TRUE(xr.NextBlock(&block));
+  DlrrView dlrr;
+  ASSERT_TRUE(dlrr.Parse(block));
+  ASSERT_EQ(1u, dlrr.num_sub_blocks());
+  EXPECT_EQ(kRemoteSsrc, dlrr.ssrc(0));
+  EXPECT_EQ(3u, dlrr.last_rr(0));
+  EXPECT_EQ(4u, dlrr.delay_since_last_rr(0));
+  EXPECT_FALSE(xr.NextBlock(&block));
+
+  EXPECT_FALSE(reader.Next(&packet));
+  EXPECT_FALSE(reader.error());
+}
+
+TEST(RtcpPacketViewTest, Padding) {
+  ReceiverReport rr;
+  rr.From(kSenderSsrc);
+  std::vector<uint8_t> buffer = Serialize(rr);
+  // Append 4 octets of padding to the RR.
+  buffer[0] |= 0x20;
+  buffer[3] += 1;
+  buffer.insert(buffer.end(), 3, 0);
+  buffer.push_back(4);
+
+  PacketView packet = ReadOnePacket(buffer);
+  EXPECT_EQ(4u, packet.payload_length());
+
+  // Padding longer than the payload.
+  buffer.back() = 9;
+  CompoundPacketReader reader(&buffer[0], buffer.size());
+  EXPECT_FALSE(reader.Next(&packet));
+  EXPECT_TRUE(reader.error());
+}
+
+TEST(RtcpPacketViewTest, RejectsTruncatedPackets) {
+  std::vector<uint8_t> buffer = BuildCompoundPacket();
+  for (size_t length = 0; length < buffer.size(); ++length) {
+    CompoundPacketReader reader(&buffer[0], length);
+    PacketView packet;
+    while (reader.Next(&packet)) {
+    }
+    // Packets end on 4 octet boundaries, so anything else is malformed.
+    if (length % 4 != 0)
+      EXPECT_TRUE(reader.error()) << length;
+  }
+}
+
+TEST(RtcpPacketViewTest, RejectsWrongVersion) {
+  std::vector<uint8_t> buffer = BuildCompoundPacket();
+  buffer[0] &= 0x3f;
+  CompoundPacketReader reader(&buffer[0], buffer.size());
+  PacketView packet;
+  EXPECT_FALSE(reader.Next(&packet));
+  EXPECT_TRUE(reader.error());
+}
+
+TEST(RtcpPacketViewTest, RejectsCountsBeyondPacket) {
+  ReceiverReport rr;
+  rr.From(kSenderSsrc);
+  std::vector<uint8_t> buffer = Serialize(rr);
+  // Claim a report block that isn't there.
+  buffer[0] |= 1;
+  EXPECT_FALSE(ReceiverReportView().Parse(ReadOnePacket(buffer)));
+
+  Sdes sdes;
+  EXPECT_TRUE(sdes.WithCName(kSenderSsrc, "cname"));
+  buffer = Serialize(sdes);
+  // Claim a second chunk.
+  buffer[0] += 1;
+  EXPECT_FALSE(SdesView().Parse(ReadOnePacket(buffer)));
+}
+
+// Feeds random and randomly corrupted packets to all views. Every accessor is
+// called on whatever parses, which must stay within the buffer.
+TEST(RtcpPacketViewTest, Fuzz) {
+  const std::vector<uint8_t> valid = BuildCompoundPacket();
+  EXPECT_EQ(7, ParseEverything(valid));
+
+  uint32_t random = 0x1234;
+  for (int i = 0; i < 20000; ++i) {
+    std::vector<uint8_t> buffer;
+    random = random * 1664525 + 1013904223;
+    if (i % 4 == 0) {
+      // Random bytes with a valid version in front, to get past the reader.
+      buffer.resize((random >> 16) % 200);
+      for (size_t j = 0; j < buffer.size(); ++j) {
+        random = random * 1664525 + 1013904223;
+        buffer[j] = random >> 24;
+      }
+      if (!buffer.empty())
+        buffer[0] = 0x80 | (buffer[0] & 0x3f);
+    } else {
+      // Corrupt a few octets and maybe truncate.
+      buffer = valid;
+      const int num_flips = 1 + (random >> 28);
+      for (int j = 0; j < num_flips; ++j) {
+        random = random * 1664525 + 1013904223;
+        buffer[(random >> 8) % buffer.size()] ^= 1 << ((random >> 4) % 8);
+      }
+      random = random * 1664525 + 1013904223;
+      if ((random >> 30) == 0)
+        buffer.resize((random >> 8) % buffer.size());
+    }
+    ParseEverything(buffer);
+  }
+}
+
+}  // namespace rtcp
+}  // namespace webrtc
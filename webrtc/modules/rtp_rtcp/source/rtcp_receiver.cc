@@ -29,6 +29,18 @@ using namespace RTCPHelp;
 // The number of RTCP time intervals needed to trigger a timeout.
 const int kRrTimeoutIntervals = 3;
 
+namespace {
+
+uint64_t ReportBlockKey(uint32_t source_ssrc, uint32_t remote_ssrc) {
+  return (static_cast<uint64_t>(source_ssrc) << 32) | remote_ssrc;
+}
+
+uint32_t RemoteSsrc(uint64_t report_block_key) {
+  return static_cast<uint32_t>(report_block_key);
+}
+
+}  // namespace
+
 RTCPReceiver::RTCPReceiver(
     int32_t id,
     Clock* clock,
@@ -36,6 +48,7 @@ RTCPReceiver::RTCPReceiver(
     RtcpPacketTypeCounterObserver* packet_type_counter_observer,
     RtcpBandwidthObserver* rtcp_bandwidth_observer,
     RtcpIntraFrameObserver* rtcp_intra_frame_observer,
+    TransportFeedbackObserver* transport_feedback_observer,
     ModuleRtpRtcpImpl* owner)
     : TMMBRHelp(),
       _clock(clock),
@@ -47,6 +60,7 @@ RTCPReceiver::RTCPReceiver(
           CriticalSectionWrapper::CreateCriticalSection()),
       _cbRtcpBandwidthObserver(rtcp_bandwidth_observer),
       _cbRtcpIntraFrameObserver(rtcp_intra_frame_observer),
+      _cbTransportFeedbackObserver(transport_feedback_observer),
       _criticalSectionRTCPReceiver(
           CriticalSectionWrapper::CreateCriticalSection()),
       main_ssrc_(0),
@@ -57,7 +71,6 @@ RTCPReceiver::RTCPReceiver(
       _lastReceivedXRNTPsecs(0),
       _lastReceivedXRNTPfrac(0),
       xr_rr_rtt_ms_(0),
-      _receivedInfoMap(),
       _packetTimeOutMS(0),
       _lastReceivedRrMs(0),
       _lastIncreasedSequenceNumberMs(0),
@@ -69,28 +82,6 @@ RTCPReceiver::RTCPReceiver(
 RTCPReceiver::~RTCPReceiver() {
   delete _criticalSectionRTCPReceiver;
   delete _criticalSectionFeedbacks;
-
-  ReportBlockMap::iterator it = _receivedReportBlockMap.begin();
-  for (; it != _receivedReportBlockMap.end(); ++it) {
-    ReportBlockInfoMap* info_map = &(it->second);
-    while (!info_map->empty()) {
-      ReportBlockInfoMap::iterator it_info = info_map->begin();
-      delete it_info->second;
-      info_map->erase(it_info);
-    }
-  }
-  while (!_receivedInfoMap.empty()) {
-    std::map<uint32_t, RTCPReceiveInformation*>::iterator first =
-        _receivedInfoMap.begin();
-    delete first->second;
-    _receivedInfoMap.erase(first);
-  }
-  while (!_receivedCnameMap.empty()) {
-    std::map<uint32_t, RTCPCnameInformation*>::iterator first =
-        _receivedCnameMap.begin();
-    delete first->second;
-    _receivedCnameMap.erase(first);
-  }
 }
 
 RTCPMethod RTCPReceiver::Status() const {
@@ -111,12 +102,10 @@ int64_t RTCPReceiver::LastReceived() {
 int64_t RTCPReceiver::LastReceivedReceiverReport() const {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
   int64_t last_received_rr = -1;
-  for (ReceivedInfoMap::const_iterator it = _receivedInfoMap.begin();
-       it != _receivedInfoMap.end(); ++it) {
-    if (it->second->lastTimeReceived > last_received_rr) {
-      last_received_rr = it->second->lastTimeReceived;
-    }
-  }
+  _receivedInfoMap.ForEach(
+      [&last_received_rr](uint32_t ssrc, const RTCPReceiveInformation* info) {
+        last_received_rr = std::max(last_received_rr, info->lastTimeReceived);
+      });
   return last_received_rr;
 }
 
@@ -261,14 +250,18 @@ int32_t RTCPReceiver::StatisticsReceived(
     std::vector<RTCPReportBlock>* receiveBlocks) const {
   assert(receiveBlocks);
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
-  ReportBlockMap::const_iterator it = _receivedReportBlockMap.begin();
-  for (; it != _receivedReportBlockMap.end(); ++it) {
-    const ReportBlockInfoMap* info_map = &(it->second);
-    ReportBlockInfoMap::const_iterator it_info = info_map->begin();
-    for (; it_info != info_map->end(); ++it_info) {
-      receiveBlocks->push_back(it_info->second->remoteReceiveBlock);
-    }
-  }
+  // The table is unordered; report the blocks ordered by source and remote
+  // SSRC, which is the order of the keys.
+  std::vector<std::pair<uint64_t, const RTCPReportBlockInformation*>> blocks;
+  blocks.reserve(_receivedReportBlockMap.size());
+  _receivedReportBlockMap.ForEach(
+      [&blocks](uint64_t key, const RTCPReportBlockInformation* info) {
+        blocks.push_back(std::make_pair(key, info));
+      });
+  std::sort(blocks.begin(), blocks.end());
+  receiveBlocks->reserve(receiveBlocks->size() + blocks.size());
+  for (const auto& block : blocks)
+    receiveBlocks->push_back(block.second->remoteReceiveBlock);
   return 0;
 }
 
@@ -350,6 +343,9 @@ RTCPReceiver::IncomingRTCPPacket(RTCPPacketInformation& rtcpPacketInformation,
             // generic application messages
             HandleAPPItem(*rtcpParser, rtcpPacketInformation);
             break;
+          case RTCPPacketTypes::kTransportFeedback:
+            HandleTransportFeedback(rtcpParser, &rtcpPacketInformation);
+            break;
         default:
             rtcpParser->Iterate();
             break;
@@ -563,84 +559,45 @@ void RTCPReceiver::HandleReportBlock(
 RTCPReportBlockInformation* RTCPReceiver::CreateOrGetReportBlockInformation(
     uint32_t remote_ssrc,
     uint32_t source_ssrc) {
-  RTCPReportBlockInformation* info =
-      GetReportBlockInformation(remote_ssrc, source_ssrc);
-  if (info == NULL) {
-    info = new RTCPReportBlockInformation;
-    _receivedReportBlockMap[source_ssrc][remote_ssrc] = info;
-  }
-  return info;
+  return _receivedReportBlockMap.FindOrInsert(
+      ReportBlockKey(source_ssrc, remote_ssrc));
 }
 
 RTCPReportBlockInformation* RTCPReceiver::GetReportBlockInformation(
     uint32_t remote_ssrc,
     uint32_t source_ssrc) const {
-  ReportBlockMap::const_iterator it = _receivedReportBlockMap.find(source_ssrc);
-  if (it == _receivedReportBlockMap.end()) {
-    return NULL;
-  }
-  const ReportBlockInfoMap* info_map = &(it->second);
-  ReportBlockInfoMap::const_iterator it_info = info_map->find(remote_ssrc);
-  if (it_info == info_map->end()) {
-    return NULL;
-  }
-  return it_info->second;
+  return const_cast<RTCPReportBlockInformation*>(
+      _receivedReportBlockMap.Find(ReportBlockKey(source_ssrc, remote_ssrc)));
 }
 
 RTCPCnameInformation*
 RTCPReceiver::CreateCnameInformation(uint32_t remoteSSRC) {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
 
-  std::map<uint32_t, RTCPCnameInformation*>::iterator it =
-      _receivedCnameMap.find(remoteSSRC);
-
-  if (it != _receivedCnameMap.end()) {
-    return it->second;
-  }
-  RTCPCnameInformation* cnameInfo = new RTCPCnameInformation;
-  memset(cnameInfo->name, 0, RTCP_CNAME_SIZE);
-  _receivedCnameMap[remoteSSRC] = cnameInfo;
-  return cnameInfo;
+  // New entries are zero-initialized.
+  return _receivedCnameMap.FindOrInsert(remoteSSRC);
 }
 
 RTCPCnameInformation*
 RTCPReceiver::GetCnameInformation(uint32_t remoteSSRC) const {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
 
-  std::map<uint32_t, RTCPCnameInformation*>::const_iterator it =
-      _receivedCnameMap.find(remoteSSRC);
-
-  if (it == _receivedCnameMap.end()) {
-    return NULL;
-  }
-  return it->second;
+  return const_cast<RTCPCnameInformation*>(
+      _receivedCnameMap.Find(remoteSSRC));
 }
 
 RTCPReceiveInformation*
 RTCPReceiver::CreateReceiveInformation(uint32_t remoteSSRC) {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
 
-  std::map<uint32_t, RTCPReceiveInformation*>::iterator it =
-      _receivedInfoMap.find(remoteSSRC);
-
-  if (it != _receivedInfoMap.end()) {
-    return it->second;
-  }
-  RTCPReceiveInformation* receiveInfo = new RTCPReceiveInformation;
-  _receivedInfoMap[remoteSSRC] = receiveInfo;
-  return receiveInfo;
+  return _receivedInfoMap.FindOrInsert(remoteSSRC);
 }
 
 RTCPReceiveInformation*
 RTCPReceiver::GetReceiveInformation(uint32_t remoteSSRC) {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
 
-  std::map<uint32_t, RTCPReceiveInformation*>::iterator it =
-      _receivedInfoMap.find(remoteSSRC);
-  if (it == _receivedInfoMap.end()) {
-    return NULL;
-  }
-  return it->second;
+  return _receivedInfoMap.Find(remoteSSRC);
 }
 
 void RTCPReceiver::UpdateReceiveInformation(
@@ -684,14 +641,10 @@ bool RTCPReceiver::UpdateRTCPReceiveInformationTimers() {
   bool updateBoundingSet = false;
   int64_t timeNow = _clock->TimeInMilliseconds();
 
-  std::map<uint32_t, RTCPReceiveInformation*>::iterator receiveInfoIt =
-      _receivedInfoMap.begin();
-
-  while (receiveInfoIt != _receivedInfoMap.end()) {
-    RTCPReceiveInformation* receiveInfo = receiveInfoIt->second;
-    if (receiveInfo == NULL) {
-      return updateBoundingSet;
-    }
+  // A single sweep resets timed out TMMBR sets and removes the entries
+  // marked by BYE once they have timed out.
+  _receivedInfoMap.EraseIf([timeNow, &updateBoundingSet](
+      uint32_t ssrc, RTCPReceiveInformation* receiveInfo) {
     // time since last received rtcp packet
     // when we dont have a lastTimeReceived and the object is marked
     // readyForDelete it's removed from the map
@@ -707,31 +660,18 @@ bool RTCPReceiver::UpdateRTCPReceiveInformationTimers() {
         // send new TMMBN to all channels using the default codec
         updateBoundingSet = true;
       }
-      receiveInfoIt++;
-    } else if (receiveInfo->readyForDelete) {
-      // store our current receiveInfoItem
-      std::map<uint32_t, RTCPReceiveInformation*>::iterator
-      receiveInfoItemToBeErased = receiveInfoIt;
-      receiveInfoIt++;
-      delete receiveInfoItemToBeErased->second;
-      _receivedInfoMap.erase(receiveInfoItemToBeErased);
-    } else {
-      receiveInfoIt++;
+      return false;
     }
-  }
+    return receiveInfo->readyForDelete;
+  });
   return updateBoundingSet;
 }
 
 int32_t RTCPReceiver::BoundingSet(bool &tmmbrOwner, TMMBRSet* boundingSetRec) {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
 
-  std::map<uint32_t, RTCPReceiveInformation*>::iterator receiveInfoIt =
-      _receivedInfoMap.find(_remoteSSRC);
-
-  if (receiveInfoIt == _receivedInfoMap.end()) {
-    return -1;
-  }
-  RTCPReceiveInformation* receiveInfo = receiveInfoIt->second;
+  const RTCPReceiveInformation* receiveInfo =
+      _receivedInfoMap.Find(_remoteSSRC);
   if (receiveInfo == NULL) {
     return -1;
   }
@@ -830,32 +770,19 @@ void RTCPReceiver::HandleBYE(RTCPUtility::RTCPParserV2& rtcpParser) {
 
   // clear our lists
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
-  ReportBlockMap::iterator it = _receivedReportBlockMap.begin();
-  for (; it != _receivedReportBlockMap.end(); ++it) {
-    ReportBlockInfoMap* info_map = &(it->second);
-    ReportBlockInfoMap::iterator it_info = info_map->find(
-        rtcpPacket.BYE.SenderSSRC);
-    if (it_info != info_map->end()) {
-      delete it_info->second;
-      info_map->erase(it_info);
-    }
-  }
+  const uint32_t sender_ssrc = rtcpPacket.BYE.SenderSSRC;
+  _receivedReportBlockMap.EraseIf(
+      [sender_ssrc](uint64_t key, RTCPReportBlockInformation* info) {
+        return RemoteSsrc(key) == sender_ssrc;
+      });
 
   //  we can't delete it due to TMMBR
-  std::map<uint32_t, RTCPReceiveInformation*>::iterator receiveInfoIt =
-      _receivedInfoMap.find(rtcpPacket.BYE.SenderSSRC);
-
-  if (receiveInfoIt != _receivedInfoMap.end()) {
-    receiveInfoIt->second->readyForDelete = true;
+  RTCPReceiveInformation* receiveInfo = _receivedInfoMap.Find(sender_ssrc);
+  if (receiveInfo != NULL) {
+    receiveInfo->readyForDelete = true;
   }
 
-  std::map<uint32_t, RTCPCnameInformation*>::iterator cnameInfoIt =
-      _receivedCnameMap.find(rtcpPacket.BYE.SenderSSRC);
-
-  if (cnameInfoIt != _receivedCnameMap.end()) {
-    delete cnameInfoIt->second;
-    _receivedCnameMap.erase(cnameInfoIt);
-  }
+  _receivedCnameMap.Erase(sender_ssrc);
   xr_rr_rtt_ms_ = 0;
   rtcpParser.Iterate();
 }
@@ -1304,6 +1231,26 @@ RtcpStatisticsCallback* RTCPReceiver::GetRtcpStatisticsCallback() {
   return stats_callback_;
 }
 
+// no need for critsect we have _criticalSectionRTCPReceiver
+void RTCPReceiver::HandleTransportFeedback(
+    RTCPUtility::RTCPParserV2* rtcp_parser,
+    RTCPHelp::RTCPPacketInformation* rtcp_packet_information) {
+  rtc::scoped_ptr<rtcp::RtcpPacket> packet(rtcp_parser->ReleaseRtcpPacket());
+  DCHECK(packet.get() != NULL);
+  rtcp_parser->Iterate();
+  rtc::scoped_ptr<rtcp::TransportFeedback> feedback(
+      static_cast<rtcp::TransportFeedback*>(packet.release()));
+  // The same compound packet may reach the modules of several streams; only
+  // the one sending the media source reports the feedback.
+  const uint32_t media_source_ssrc = feedback->GetMediaSourceSsrc();
+  if (media_source_ssrc != main_ssrc_ &&
+      registered_ssrcs_.find(media_source_ssrc) == registered_ssrcs_.end()) {
+    return;
+  }
+  rtcp_packet_information->rtcpPacketTypeFlags |= kRtcpTransportFeedback;
+  rtcp_packet_information->transport_feedback_ = feedback.Pass();
+}
+
 // Holding no Critical section
 void RTCPReceiver::TriggerCallbacksFromRTCPPacket(
     RTCPPacketInformation& rtcpPacketInformation) {
@@ -1377,6 +1324,12 @@ void RTCPReceiver::TriggerCallbacksFromRTCPPacket(
     }
   }
 
+  if (_cbTransportFeedbackObserver &&
+      (rtcpPacketInformation.rtcpPacketTypeFlags & kRtcpTransportFeedback)) {
+    _cbTransportFeedbackObserver->OnTransportFeedback(
+        *rtcpPacketInformation.transport_feedback_.get());
+  }
+
   if (!receiver_only_) {
     CriticalSectionScoped cs(_criticalSectionFeedbacks);
     if (stats_callback_) {
@@ -1416,36 +1369,34 @@ int32_t RTCPReceiver::TMMBRReceived(uint32_t size,
                                     TMMBRSet* candidateSet) const {
   CriticalSectionScoped lock(_criticalSectionRTCPReceiver);
 
-  std::map<uint32_t, RTCPReceiveInformation*>::const_iterator
-      receiveInfoIt = _receivedInfoMap.begin();
-  if (receiveInfoIt == _receivedInfoMap.end()) {
+  if (_receivedInfoMap.empty()) {
     return -1;
   }
   uint32_t num = accNumCandidates;
   if (candidateSet) {
-    while( num < size && receiveInfoIt != _receivedInfoMap.end()) {
-      RTCPReceiveInformation* receiveInfo = receiveInfoIt->second;
-      if (receiveInfo == NULL) {
-        return 0;
-      }
+    // Collect candidates in SSRC order, as the table itself is unordered.
+    std::vector<uint32_t> ssrcs;
+    ssrcs.reserve(_receivedInfoMap.size());
+    _receivedInfoMap.ForEach(
+        [&ssrcs](uint32_t ssrc, const RTCPReceiveInformation* receiveInfo) {
+          ssrcs.push_back(ssrc);
+        });
+    std::sort(ssrcs.begin(), ssrcs.end());
+    const int64_t now_ms = _clock->TimeInMilliseconds();
+    for (size_t j = 0; num < size && j < ssrcs.size(); ++j) {
+      RTCPReceiveInformation* receiveInfo = _receivedInfoMap.Find(ssrcs[j]);
       for (uint32_t i = 0;
            (num < size) && (i < receiveInfo->TmmbrSet.lengthOfSet()); i++) {
-        if (receiveInfo->GetTMMBRSet(i, num, candidateSet,
-                                     _clock->TimeInMilliseconds()) == 0) {
+        if (receiveInfo->GetTMMBRSet(i, num, candidateSet, now_ms) == 0) {
           num++;
         }
       }
-      receiveInfoIt++;
     }
   } else {
-    while (receiveInfoIt != _receivedInfoMap.end()) {
-      RTCPReceiveInformation* receiveInfo = receiveInfoIt->second;
-      if(receiveInfo == NULL) {
-        return -1;
-      }
-      num += receiveInfo->TmmbrSet.lengthOfSet();
-      receiveInfoIt++;
-    }
+    _receivedInfoMap.ForEach(
+        [&num](uint32_t ssrc, const RTCPReceiveInformation* receiveInfo) {
+          num += receiveInfo->TmmbrSet.lengthOfSet();
+        });
   }
   return num;
 }
@@ -11,7 +11,6 @@
 #ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_RTCP_RECEIVER_H_
 #define WEBRTC_MODULES_RTP_RTCP_SOURCE_RTCP_RECEIVER_H_
 
-#include <map>
 #include <vector>
 #include <set>
 
@@ -20,6 +19,7 @@
 #include "webrtc/modules/rtp_rtcp/source/rtcp_receiver_help.h"
 #include "webrtc/modules/rtp_rtcp/source/rtcp_utility.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
+#include "webrtc/modules/rtp_rtcp/source/ssrc_table.h"
 #include "webrtc/modules/rtp_rtcp/source/tmmbr_help.h"
 #include "webrtc/typedefs.h"
 
@@ -35,6 +35,7 @@ public:
               RtcpPacketTypeCounterObserver* packet_type_counter_observer,
               RtcpBandwidthObserver* rtcp_bandwidth_observer,
               RtcpIntraFrameObserver* rtcp_intra_frame_observer,
+              TransportFeedbackObserver* transport_feedback_observer,
               ModuleRtpRtcpImpl* owner);
     virtual ~RTCPReceiver();
 
@@ -216,14 +217,15 @@ protected:
     void HandleAPPItem(RTCPUtility::RTCPParserV2& rtcpParser,
                        RTCPHelp::RTCPPacketInformation& rtcpPacketInformation);
 
+    void HandleTransportFeedback(
+        RTCPUtility::RTCPParserV2* rtcp_parser,
+        RTCPHelp::RTCPPacketInformation* rtcp_packet_information);
+
  private:
-  typedef std::map<uint32_t, RTCPHelp::RTCPReceiveInformation*>
-      ReceivedInfoMap;
-  // RTCP report block information mapped by remote SSRC.
-  typedef std::map<uint32_t, RTCPHelp::RTCPReportBlockInformation*>
-      ReportBlockInfoMap;
-  // RTCP report block information map mapped by source SSRC.
-  typedef std::map<uint32_t, ReportBlockInfoMap> ReportBlockMap;
+  // RTCP report block information mapped by source and remote SSRC, see
+  // ReportBlockKey().
+  typedef SsrcTable<RTCPHelp::RTCPReportBlockInformation, uint64_t>
+      ReportBlockMap;
 
   RTCPHelp::RTCPReportBlockInformation* CreateOrGetReportBlockInformation(
       uint32_t remote_ssrc, uint32_t source_ssrc)
@@ -241,6 +243,7 @@ protected:
   CriticalSectionWrapper* _criticalSectionFeedbacks;
   RtcpBandwidthObserver* const _cbRtcpBandwidthObserver;
   RtcpIntraFrameObserver* const _cbRtcpIntraFrameObserver;
+  TransportFeedbackObserver* const _cbTransportFeedbackObserver;
 
   CriticalSectionWrapper* _criticalSectionRTCPReceiver;
   uint32_t main_ssrc_;
@@ -264,8 +267,11 @@ protected:
   // Received report blocks.
   ReportBlockMap _receivedReportBlockMap
       GUARDED_BY(_criticalSectionRTCPReceiver);
-  ReceivedInfoMap _receivedInfoMap;
-  std::map<uint32_t, RTCPUtility::RTCPCnameInformation*> _receivedCnameMap;
+  // Mutable since TMMBRReceived() drops timed out TMMBR entries.
+  mutable SsrcTable<RTCPHelp::RTCPReceiveInformation> _receivedInfoMap
+      GUARDED_BY(_criticalSectionRTCPReceiver);
+  SsrcTable<RTCPUtility::RTCPCnameInformation> _receivedCnameMap
+      GUARDED_BY(_criticalSectionRTCPReceiver);
 
   uint32_t _packetTimeOutMS;
 
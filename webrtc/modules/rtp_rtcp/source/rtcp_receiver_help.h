@@ -17,6 +17,7 @@
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"  // RTCPReportBlock
 #include "webrtc/modules/rtp_rtcp/source/rtcp_utility.h"
 #include "webrtc/modules/rtp_rtcp/source/tmmbr_help.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 #include "webrtc/typedefs.h"
 
 namespace webrtc {
@@ -84,6 +85,8 @@ public:
     bool xr_dlrr_item;
     RTCPVoIPMetric*  VoIPMetric;
 
+    rtc::scoped_ptr<rtcp::TransportFeedback> transport_feedback_;
+
 private:
     DISALLOW_COPY_AND_ASSIGN(RTCPPacketInformation);
 };
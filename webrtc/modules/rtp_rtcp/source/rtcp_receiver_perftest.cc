@@ -0,0 +1,118 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_receiver.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_rtcp_impl.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// A conference where every remote participant reports on all local streams.
+const int kNumLocalSsrcs = 16;
+const int kNumRemoteSsrcs = 300;
+const int kNumRounds = 20;
+const uint32_t kLocalSsrcBase = 0x10000;
+const uint32_t kRemoteSsrcBase = 0x20000;
+
+class RtcpReceiverPerfTest : public ::testing::Test {
+ protected:
+  RtcpReceiverPerfTest() : clock_(1335900000) {
+    RtpRtcp::Configuration configuration;
+    configuration.clock = &clock_;
+    rtp_rtcp_impl_.reset(new ModuleRtpRtcpImpl(configuration));
+    rtcp_receiver_.reset(new RTCPReceiver(0, &clock_, false, NULL, NULL, NULL,
+                                          NULL, rtp_rtcp_impl_.get()));
+    std::set<uint32_t> ssrcs;
+    for (int i = 0; i < kNumLocalSsrcs; ++i)
+      ssrcs.insert(kLocalSsrcBase + i);
+    rtcp_receiver_->SetSsrcs(kLocalSsrcBase, ssrcs);
+  }
+
+  // Builds one compound RR + SDES packet per remote participant.
+  void BuildPackets(uint32_t round) {
+    packets_.clear();
+    for (int i = 0; i < kNumRemoteSsrcs; ++i) {
+      const uint32_t remote_ssrc = kRemoteSsrcBase + i;
+      rtcp::ReceiverReport rr;
+      rr.From(remote_ssrc);
+      for (int j = 0; j < kNumLocalSsrcs; ++j) {
+        rtcp::ReportBlock rb;
+        rb.To(kLocalSsrcBase + j);
+        rb.WithExtHighestSeqNum(round * 100 + j);
+        rb.WithJitter(j);
+        rr.WithReportBlock(rb);
+      }
+      rtcp::Sdes sdes;
+      sdes.WithCName(remote_ssrc, "participant" + rtc::ToString(i));
+      rr.Append(&sdes);
+      rtc::scoped_ptr<rtcp::RawPacket> packet(rr.Build());
+      packets_.push_back(std::vector<uint8_t>(
+          packet->Buffer(), packet->Buffer() + packet->Length()));
+    }
+  }
+
+  SimulatedClock clock_;
+  rtc::scoped_ptr<ModuleRtpRtcpImpl> rtp_rtcp_impl_;
+  rtc::scoped_ptr<RTCPReceiver> rtcp_receiver_;
+  std::vector<std::vector<uint8_t>> packets_;
+};
+
+}  // namespace
+
+TEST_F(RtcpReceiverPerfTest, ReportStorm) {
+  Clock* real_clock = Clock::GetRealTimeClock();
+  int64_t parse_us = 0;
+  int64_t timers_us = 0;
+  int64_t stats_us = 0;
+  std::vector<RTCPReportBlock> report_blocks;
+  for (uint32_t round = 0; round < kNumRounds; ++round) {
+    BuildPackets(round);
+    int64_t start_us = real_clock->TimeInMicroseconds();
+    for (const std::vector<uint8_t>& packet : packets_) {
+      RTCPUtility::RTCPParserV2 parser(&packet[0], packet.size(), true);
+      RTCPHelp::RTCPPacketInformation packet_information;
+      ASSERT_EQ(0, rtcp_receiver_->IncomingRTCPPacket(packet_information,
+                                                      &parser));
+    }
+    parse_us += real_clock->TimeInMicroseconds() - start_us;
+
+    start_us = real_clock->TimeInMicroseconds();
+    rtcp_receiver_->UpdateRTCPReceiveInformationTimers();
+    timers_us += real_clock->TimeInMicroseconds() - start_us;
+
+    report_blocks.clear();
+    start_us = real_clock->TimeInMicroseconds();
+    rtcp_receiver_->StatisticsReceived(&report_blocks);
+    stats_us += real_clock->TimeInMicroseconds() - start_us;
+    ASSERT_EQ(static_cast<size_t>(kNumRemoteSsrcs * kNumLocalSsrcs),
+              report_blocks.size());
+    clock_.AdvanceTimeMilliseconds(1000);
+  }
+
+  test::PrintResult("rtcp_receiver_packet_time", "", "report_storm",
+                    1000.0 * parse_us / (kNumRounds * kNumRemoteSsrcs),
+                    "ns", true);
+  test::PrintResult("rtcp_receiver_timer_update_time", "", "report_storm",
+                    static_cast<double>(timers_us) / kNumRounds, "us", false);
+  test::PrintResult("rtcp_receiver_statistics_time", "", "report_storm",
+                    static_cast<double>(stats_us) / kNumRounds, "us", false);
+}
+
+}  // namespace webrtc
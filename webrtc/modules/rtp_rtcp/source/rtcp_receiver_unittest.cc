@@ -24,6 +24,7 @@
 #include "webrtc/modules/rtp_rtcp/source/rtcp_sender.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_rtcp_impl.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 
 namespace webrtc {
 
@@ -83,7 +84,7 @@ class RtcpReceiverTest : public ::testing::Test {
     configuration.remote_bitrate_estimator = remote_bitrate_estimator_.get();
     rtp_rtcp_impl_ = new ModuleRtpRtcpImpl(configuration);
     rtcp_receiver_ = new RTCPReceiver(0, &system_clock_, false, NULL, NULL,
-                                      NULL, rtp_rtcp_impl_);
+                                      NULL, NULL, rtp_rtcp_impl_);
     test_transport_->SetRTCPReceiver(rtcp_receiver_);
   }
   ~RtcpReceiverTest() {
@@ -1031,6 +1032,62 @@ TEST_F(RtcpReceiverTest, Callbacks) {
                                kCumulativeLoss, kJitter));
 }
 
+class TransportFeedbackCounter : public TransportFeedbackObserver {
+ public:
+  TransportFeedbackCounter() : num_feedback_(0), last_status_count_(0) {}
+  void OnSentPacket(uint16_t sequence_number,
+                    int64_t send_time_ms,
+                    size_t payload_size,
+                    int probe_cluster_id) override {}
+  void OnTransportFeedback(const rtcp::TransportFeedback& feedback) override {
+    ++num_feedback_;
+    last_status_count_ = feedback.GetStatusVector().size();
+  }
+
+  int num_feedback_;
+  size_t last_status_count_;
+};
+
+TEST_F(RtcpReceiverTest, TransportFeedbackForUsIsForwarded) {
+  const uint32_t kSenderSsrc = 0x10203;
+  const uint32_t kSourceSsrc = 0x123456;
+  const uint32_t kOtherSsrc = 0x654321;
+  TransportFeedbackCounter observer;
+  RTCPReceiver receiver(0, &system_clock_, false, NULL, NULL, NULL, &observer,
+                        rtp_rtcp_impl_);
+  std::set<uint32_t> ssrcs;
+  ssrcs.insert(kSourceSsrc);
+  receiver.SetSsrcs(kSourceSsrc, ssrcs);
+
+  rtcp::TransportFeedback feedback;
+  feedback.WithPacketSenderSsrc(kSenderSsrc);
+  feedback.WithMediaSourceSsrc(kOtherSsrc);
+  feedback.WithBase(1, 1000000);
+  EXPECT_TRUE(feedback.WithReceivedPacket(1, 1000000));
+  EXPECT_TRUE(feedback.WithReceivedPacket(3, 1002000));
+
+  // Feedback about another stream is left to the module sending that stream.
+  rtc::scoped_ptr<rtcp::RawPacket> packet(feedback.Build());
+  RTCPUtility::RTCPParserV2 other_parser(packet->Buffer(), packet->Length(),
+                                         true);
+  RTCPHelp::RTCPPacketInformation other_info;
+  EXPECT_EQ(0, receiver.IncomingRTCPPacket(other_info, &other_parser));
+  receiver.TriggerCallbacksFromRTCPPacket(other_info);
+  EXPECT_EQ(0u, other_info.rtcpPacketTypeFlags & kRtcpTransportFeedback);
+  EXPECT_EQ(0, observer.num_feedback_);
+
+  feedback.WithMediaSourceSsrc(kSourceSsrc);
+  packet.reset(feedback.Build().release());
+  RTCPUtility::RTCPParserV2 parser(packet->Buffer(), packet->Length(), true);
+  RTCPHelp::RTCPPacketInformation info;
+  EXPECT_EQ(0, receiver.IncomingRTCPPacket(info, &parser));
+  receiver.TriggerCallbacksFromRTCPPacket(info);
+  EXPECT_EQ(kRtcpTransportFeedback,
+            info.rtcpPacketTypeFlags & kRtcpTransportFeedback);
+  EXPECT_EQ(1, observer.num_feedback_);
+  EXPECT_EQ(3u, observer.last_status_count_);
+}
+
 }  // Anonymous namespace
 
 }  // namespace webrtc
@@ -21,6 +21,7 @@
 #include "webrtc/common_types.h"
 #include "webrtc/modules/rtp_rtcp/source/byte_io.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_rtcp_impl.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
 #include "webrtc/system_wrappers/interface/logging.h"
 #include "webrtc/system_wrappers/interface/trace_event.h"
@@ -1478,6 +1479,32 @@ int32_t RTCPSender::SendToNetwork(const uint8_t* dataBuffer, size_t length) {
   return -1;
 }
 
+bool RTCPSender::SendFeedbackPacket(const rtcp::TransportFeedback& packet) {
+  {
+    CriticalSectionScoped lock(critical_section_rtcp_sender_.get());
+    if (method_ == kRtcpOff)
+      return false;
+  }
+
+  class Sender : public rtcp::RtcpPacket::PacketReadyCallback {
+   public:
+    explicit Sender(RTCPSender* sender)
+        : sender_(sender), send_failure_(false) {}
+
+    void OnPacketReady(uint8_t* data, size_t length) override {
+      if (sender_->SendToNetwork(data, length) != 0)
+        send_failure_ = true;
+    }
+
+    RTCPSender* const sender_;
+    bool send_failure_;
+  } sender(this);
+
+  uint8_t buffer[IP_PACKET_SIZE];
+  return packet.BuildExternalBuffer(buffer, IP_PACKET_SIZE, &sender) &&
+         !sender.send_failure_;
+}
+
 void RTCPSender::SetCsrcs(const std::vector<uint32_t>& csrcs) {
   assert(csrcs.size() <= kRtpCsrcSize);
   CriticalSectionScoped lock(critical_section_rtcp_sender_.get());
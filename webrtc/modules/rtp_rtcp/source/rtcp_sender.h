@@ -153,6 +153,8 @@ public:
 
  void SetTargetBitrate(unsigned int target_bitrate);
 
+ bool SendFeedbackPacket(const rtcp::TransportFeedback& packet);
+
 private:
  struct RtcpContext;
 
@@ -302,7 +302,8 @@ class RtcpSenderTest : public ::testing::Test {
     rtcp_sender_ =
         new RTCPSender(0, false, &clock_, receive_statistics_.get(), NULL);
     rtcp_receiver_ =
-        new RTCPReceiver(0, &clock_, false, NULL, NULL, NULL, rtp_rtcp_impl_);
+        new RTCPReceiver(0, &clock_, false, NULL, NULL, NULL, NULL,
+                         rtp_rtcp_impl_);
     test_transport_->SetRTCPReceiver(rtcp_receiver_);
     // Initialize
     EXPECT_EQ(0, rtcp_sender_->RegisterSendTransport(test_transport_));
@@ -14,6 +14,8 @@
 #include <math.h>   // ceil
 #include <string.h> // memcpy
 
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+
 namespace webrtc {
 
 namespace RTCPUtility {
@@ -58,6 +60,11 @@ RTCPUtility::RTCPParserV2::RTCPParserV2(const uint8_t* rtcpData,
 RTCPUtility::RTCPParserV2::~RTCPParserV2() {
 }
 
+rtc::scoped_ptr<webrtc::rtcp::RtcpPacket>
+RTCPUtility::RTCPParserV2::ReleaseRtcpPacket() {
+  return rtcp_packet_.Pass();
+}
+
 ptrdiff_t
 RTCPUtility::RTCPParserV2::LengthLeft() const
 {
@@ -1217,6 +1224,18 @@ RTCPUtility::RTCPParserV2::ParseFBCommon(const RTCPCommonHeader& header)
             // Note: No state transition, SR REQ is empty!
             return true;
         }
+        case 15:
+        {
+            // Transport-wide congestion control feedback. Parsed as a whole,
+            // so stay at the top level and skip the rest of the block.
+            rtcp_packet_ = rtcp::TransportFeedback::ParseFrom(
+                _ptrRTCPData - 12, _ptrRTCPBlockEnd - (_ptrRTCPData - 12));
+            EndCurrentBlock();
+            if (rtcp_packet_.get() == NULL)
+                return false;
+            _packetType = RTCPPacketTypes::kTransportFeedback;
+            return true;
+        }
         default:
             break;
         }
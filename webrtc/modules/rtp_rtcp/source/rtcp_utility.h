@@ -13,11 +13,15 @@
 
 #include <stddef.h> // size_t, ptrdiff_t
 
+#include "webrtc/base/scoped_ptr.h"
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_rtcp_config.h"
 #include "webrtc/typedefs.h"
 
 namespace webrtc {
+namespace rtcp {
+class RtcpPacket;
+}
 namespace RTCPUtility {
 
 class NackStats {
@@ -294,6 +298,9 @@ enum class RTCPPacketTypes {
 
   kApp,
   kAppItem,
+
+  // draft-holmer-rmcat-transport-wide-cc-extensions
+  kTransportFeedback,
 };
 
 struct RTCPRawPacket {
@@ -355,6 +362,10 @@ class RTCPParserV2 {
   RTCPPacketTypes Begin();
   RTCPPacketTypes Iterate();
 
+  // Packet types parsed as a whole into an rtcp::RtcpPacket, such as
+  // kTransportFeedback, hand it over here. Returns NULL for other types.
+  rtc::scoped_ptr<rtcp::RtcpPacket> ReleaseRtcpPacket();
+
  private:
   enum class ParseState {
     State_TopLevel,            // Top level packet
@@ -445,6 +456,7 @@ class RTCPParserV2 {
 
   RTCPPacketTypes _packetType;
   RTCPPacket _packet;
+  rtc::scoped_ptr<rtcp::RtcpPacket> rtcp_packet_;
 };
 
 class RTCPPacketIterator {
@@ -0,0 +1,169 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/interface/module_common_types.h"
+#include "webrtc/modules/pacing/include/paced_sender.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_sender.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// A 1080p keyframe at a few Mbps is in the order of 150 kB.
+const size_t kKeyFrameSize = 150000;
+const size_t kMaxPayloadLength = 1200;
+const int kNumFrames = 1000;
+// Number of packets a video sender keeps for retransmission.
+const size_t kHistorySize = 600;
+
+struct Frame {
+  RtpVideoCodecTypes codec;
+  std::vector<uint8_t> payload;
+  RTPFragmentationHeader fragmentation;
+  RTPVideoTypeHeader codec_header;
+};
+
+// Fills |frame| with a keyframe of |codec|. H.264 keyframes are SPS, PPS and
+// a few IDR slices.
+void CreateKeyFrame(RtpVideoCodecTypes codec, Frame* frame) {
+  frame->codec = codec;
+  frame->payload.resize(kKeyFrameSize);
+  uint32_t random = 1;
+  for (size_t i = 0; i < kKeyFrameSize; ++i) {
+    random = random * 1103515245 + 12345;
+    frame->payload[i] = static_cast<uint8_t>(random >> 16);
+  }
+  memset(&frame->codec_header, 0, sizeof(frame->codec_header));
+  frame->codec_header.VP8.InitRTPVideoHeaderVP8();
+  frame->codec_header.VP8.pictureId = 17;
+
+  const size_t kSpsSize = 20;
+  const size_t kPpsSize = 8;
+  const size_t kNumSlices = 4;
+  const size_t slice_size = (kKeyFrameSize - kSpsSize - kPpsSize) / kNumSlices;
+  frame->fragmentation.VerifyAndAllocateFragmentationHeader(2 + kNumSlices);
+  size_t offset = 0;
+  for (size_t i = 0; i < 2 + kNumSlices; ++i) {
+    size_t length = i == 0 ? kSpsSize : (i == 1 ? kPpsSize : slice_size);
+    if (i == 1 + kNumSlices)
+      length = kKeyFrameSize - offset;
+    frame->fragmentation.fragmentationOffset[i] = offset;
+    frame->fragmentation.fragmentationLength[i] = length;
+    frame->payload[offset] = i == 0 ? 0x67 : (i == 1 ? 0x68 : 0x65);
+    offset += length;
+  }
+}
+
+// Queues every packet, as the pacer does while a keyframe is sent out.
+class QueueingPacer : public PacedSender {
+ public:
+  explicit QueueingPacer(Clock* clock)
+      : PacedSender(clock, nullptr, 1000, 1000, 0) {}
+
+  bool SendPacket(Priority priority,
+                  uint32_t ssrc,
+                  uint16_t sequence_number,
+                  int64_t capture_time_ms,
+                  size_t bytes,
+                  bool retransmission) override {
+    queue_.push_back(std::make_pair(sequence_number, capture_time_ms));
+    return false;
+  }
+
+  // Lets |sender| send all queued packets from its history.
+  void SendQueuedPackets(RTPSender* sender) {
+    for (const auto& packet : queue_)
+      sender->TimeToSendPacket(packet.first, packet.second, false, kNotAProbe);
+    queue_.clear();
+  }
+
+ private:
+  std::vector<std::pair<uint16_t, int64_t> > queue_;
+};
+
+class CountingTransport : public Transport {
+ public:
+  CountingTransport() : num_packets_(0), total_length_(0) {}
+
+  int SendPacket(int channel, const void* data, size_t len) override {
+    ++num_packets_;
+    total_length_ += len;
+    return static_cast<int>(len);
+  }
+  int SendRTCPPacket(int channel, const void* data, size_t len) override {
+    return static_cast<int>(len);
+  }
+
+  size_t num_packets() const { return num_packets_; }
+  size_t total_length() const { return total_length_; }
+
+ private:
+  size_t num_packets_;
+  size_t total_length_;
+};
+
+// Sends |frame| through RTPSenderVideo and the packet history into the pacer
+// queue, and then from the history to the transport as the pacer does.
+void RunCodec(RtpVideoCodecTypes codec,
+              const char* payload_name,
+              const std::string& name) {
+  Frame frame;
+  CreateKeyFrame(codec, &frame);
+  Clock* clock = Clock::GetRealTimeClock();
+  CountingTransport transport;
+  QueueingPacer pacer(clock);
+  RTPSender sender(0, false, clock, &transport, nullptr, &pacer, nullptr,
+                   nullptr, nullptr, nullptr, nullptr);
+  const int8_t kPayloadType = 100;
+  ASSERT_EQ(0, sender.RegisterPayload(payload_name, kPayloadType, 90000, 0, 0));
+  sender.RegisterRtpHeaderExtension(kRtpExtensionTransmissionTimeOffset, 1);
+  sender.RegisterRtpHeaderExtension(kRtpExtensionAbsoluteSendTime, 2);
+  sender.SetMaxPayloadLength(kMaxPayloadLength + sender.RTPHeaderLength(), 0);
+  sender.SetStorePacketsStatus(true, kHistorySize);
+  sender.SetSendingMediaStatus(true);
+  RTPVideoHeader video_header;
+  memset(&video_header, 0, sizeof(video_header));
+  video_header.codecHeader = frame.codec_header;
+
+  const int64_t start_us = clock->TimeInMicroseconds();
+  for (int i = 0; i < kNumFrames; ++i) {
+    const int64_t capture_time_ms = clock->TimeInMilliseconds();
+    ASSERT_EQ(0, sender.SendOutgoingData(
+                     kVideoFrameKey, kPayloadType, i * 3000, capture_time_ms,
+                     &frame.payload[0], frame.payload.size(),
+                     &frame.fragmentation, &video_header));
+    pacer.SendQueuedPackets(&sender);
+  }
+  const int64_t elapsed_us = clock->TimeInMicroseconds() - start_us;
+  EXPECT_GT(transport.total_length(), kNumFrames * kKeyFrameSize);
+
+  test::PrintResult("rtp_send_keyframe_time", "", name,
+                    static_cast<double>(elapsed_us) / kNumFrames, "us", true);
+  test::PrintResult("rtp_packets_per_keyframe", "", name,
+                    transport.num_packets() / kNumFrames, "packets", false);
+}
+
+}  // namespace
+
+TEST(RtpSenderVideoPerfTest, KeyFrames1080p) {
+  RunCodec(kRtpVideoVp8, "VP8", "vp8");
+  RunCodec(kRtpVideoH264, "H264", "h264");
+  RunCodec(kRtpVideoGeneric, "GENERIC", "generic");
+}
+
+}  // namespace webrtc
@@ -10,6 +10,8 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "webrtc/common_types.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_header_extension.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
@@ -226,4 +228,19 @@ void RtpHeaderExtensionMap::GetCopy(RtpHeaderExtensionMap* map) const {
     it++;
   }
 }
+
+const uint8_t RtpHeaderExtensionSnapshot::kMaxId;
+
+RtpHeaderExtensionSnapshot::RtpHeaderExtensionSnapshot() {
+  std::fill(types_, types_ + kMaxId + 1, kRtpExtensionNone);
+}
+
+RtpHeaderExtensionSnapshot::RtpHeaderExtensionSnapshot(
+    const RtpHeaderExtensionMap& map) {
+  std::fill(types_, types_ + kMaxId + 1, kRtpExtensionNone);
+  for (const auto& kv : map.extensionMap_) {
+    if (kv.first <= kMaxId)
+      types_[kv.first] = kv.second->type;
+  }
+}
 }  // namespace webrtc
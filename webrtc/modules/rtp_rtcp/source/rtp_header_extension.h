@@ -109,9 +109,33 @@ class RtpHeaderExtensionMap {
   RTPExtensionType Next(RTPExtensionType type) const;
 
  private:
+  friend class RtpHeaderExtensionSnapshot;
+
   int32_t Register(const RTPExtensionType type, const uint8_t id, bool active);
   std::map<uint8_t, HeaderExtension*> extensionMap_;
 };
+
+// An immutable copy of the id to type mapping of an RtpHeaderExtensionMap,
+// stored as an array indexed by the one-byte header extension id. Meant for
+// parsing incoming packets, where looking up each extension in the map is
+// too costly. Like RtpHeaderExtensionMap::GetType(), it includes inactive
+// extensions.
+class RtpHeaderExtensionSnapshot {
+ public:
+  // One-byte header extension ids are 4 bits, and 15 is reserved.
+  static const uint8_t kMaxId = 14;
+
+  RtpHeaderExtensionSnapshot();
+  explicit RtpHeaderExtensionSnapshot(const RtpHeaderExtensionMap& map);
+
+  // Returns kRtpExtensionNone if no extension is registered with |id|.
+  RTPExtensionType GetType(uint8_t id) const {
+    return id <= kMaxId ? types_[id] : kRtpExtensionNone;
+  }
+
+ private:
+  RTPExtensionType types_[kMaxId + 1];
+};
 }
 
 #endif // WEBRTC_MODULES_RTP_RTCP_RTP_HEADER_EXTENSION_H_
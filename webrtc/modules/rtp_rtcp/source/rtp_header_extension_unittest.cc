@@ -130,6 +130,23 @@ TEST_F(RtpHeaderExtensionTest, GetCopy) {
   EXPECT_EQ(kRtpExtensionTransmissionTimeOffset, mapOut.First());
 }
 
+TEST_F(RtpHeaderExtensionTest, Snapshot) {
+  EXPECT_EQ(0, map_.Register(kRtpExtensionTransmissionTimeOffset, kId));
+  EXPECT_EQ(0, map_.RegisterInactive(kRtpExtensionAbsoluteSendTime, kId + 1));
+
+  const RtpHeaderExtensionSnapshot snapshot(map_);
+  EXPECT_EQ(kRtpExtensionTransmissionTimeOffset, snapshot.GetType(kId));
+  EXPECT_EQ(kRtpExtensionAbsoluteSendTime, snapshot.GetType(kId + 1));
+  EXPECT_EQ(kRtpExtensionNone, snapshot.GetType(0));
+  EXPECT_EQ(kRtpExtensionNone, snapshot.GetType(kId + 2));
+  EXPECT_EQ(kRtpExtensionNone, snapshot.GetType(15));
+
+  // Later changes to the map don't affect the snapshot.
+  map_.Erase();
+  EXPECT_EQ(kRtpExtensionTransmissionTimeOffset, snapshot.GetType(kId));
+  EXPECT_EQ(kRtpExtensionNone, RtpHeaderExtensionSnapshot().GetType(kId));
+}
+
 TEST_F(RtpHeaderExtensionTest, Erase) {
   EXPECT_EQ(0, map_.Register(kRtpExtensionTransmissionTimeOffset, kId));
   EXPECT_EQ(1, map_.Size());
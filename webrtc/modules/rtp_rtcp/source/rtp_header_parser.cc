@@ -9,10 +9,12 @@
  */
 #include "webrtc/modules/rtp_rtcp/interface/rtp_header_parser.h"
 
+#include "webrtc/base/atomicops.h"
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_header_extension.h"
 #include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/system_wrappers/interface/scoped_vector.h"
 
 namespace webrtc {
 
@@ -30,8 +32,18 @@ class RtpHeaderParserImpl : public RtpHeaderParser {
   bool DeregisterRtpHeaderExtension(RTPExtensionType type) override;
 
  private:
+  // Publishes a snapshot of |rtp_header_extension_map_| for Parse().
+  void UpdateSnapshot() EXCLUSIVE_LOCKS_REQUIRED(critical_section_);
+
   rtc::scoped_ptr<CriticalSectionWrapper> critical_section_;
   RtpHeaderExtensionMap rtp_header_extension_map_ GUARDED_BY(critical_section_);
+  // Every snapshot ever published. Parse() reads |current_snapshot_| without
+  // taking the lock, so a replaced snapshot may still be in use and can't be
+  // deleted until the parser is. Extensions are only (re)negotiated a handful
+  // of times per call, so this doesn't grow much.
+  ScopedVector<const RtpHeaderExtensionSnapshot> snapshots_
+      GUARDED_BY(critical_section_);
+  const RtpHeaderExtensionSnapshot* volatile current_snapshot_;
 };
 
 RtpHeaderParser* RtpHeaderParser::Create() {
@@ -39,7 +51,11 @@ RtpHeaderParser* RtpHeaderParser::Create() {
 }
 
 RtpHeaderParserImpl::RtpHeaderParserImpl()
-    : critical_section_(CriticalSectionWrapper::CreateCriticalSection()) {}
+    : critical_section_(CriticalSectionWrapper::CreateCriticalSection()),
+      current_snapshot_(nullptr) {
+  CriticalSectionScoped cs(critical_section_.get());
+  UpdateSnapshot();
+}
 
 bool RtpHeaderParser::IsRtcp(const uint8_t* packet, size_t length) {
   RtpUtility::RtpHeaderParser rtp_parser(packet, length);
@@ -52,27 +68,32 @@ bool RtpHeaderParserImpl::Parse(const uint8_t* packet,
   RtpUtility::RtpHeaderParser rtp_parser(packet, length);
   memset(header, 0, sizeof(*header));
 
-  RtpHeaderExtensionMap map;
-  {
-    CriticalSectionScoped cs(critical_section_.get());
-    rtp_header_extension_map_.GetCopy(&map);
-  }
-
-  const bool valid_rtpheader = rtp_parser.Parse(*header, &map);
-  if (!valid_rtpheader) {
-    return false;
-  }
-  return true;
+  const RtpHeaderExtensionSnapshot* snapshot =
+      rtc::AtomicOps::AcquireLoadPtr(&current_snapshot_);
+  return rtp_parser.Parse(*header, *snapshot);
 }
 
 bool RtpHeaderParserImpl::RegisterRtpHeaderExtension(RTPExtensionType type,
                                                      uint8_t id) {
   CriticalSectionScoped cs(critical_section_.get());
-  return rtp_header_extension_map_.Register(type, id) == 0;
+  if (rtp_header_extension_map_.Register(type, id) != 0)
+    return false;
+  UpdateSnapshot();
+  return true;
 }
 
 bool RtpHeaderParserImpl::DeregisterRtpHeaderExtension(RTPExtensionType type) {
   CriticalSectionScoped cs(critical_section_.get());
-  return rtp_header_extension_map_.Deregister(type) == 0;
+  if (rtp_header_extension_map_.Deregister(type) != 0)
+    return false;
+  UpdateSnapshot();
+  return true;
+}
+
+void RtpHeaderParserImpl::UpdateSnapshot() {
+  const RtpHeaderExtensionSnapshot* snapshot =
+      new RtpHeaderExtensionSnapshot(rtp_header_extension_map_);
+  snapshots_.push_back(snapshot);
+  rtc::AtomicOps::ReleaseStorePtr(&current_snapshot_, snapshot);
 }
 }  // namespace webrtc
@@ -0,0 +1,162 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/rtp_rtcp/interface/rtp_header_parser.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_header_extension.h"
+#include "webrtc/modules/rtp_rtcp/source/rtp_utility.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
+#include "webrtc/test/rtp_file_reader.h"
+#include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kNumPasses = 200;
+const uint8_t kTransmissionTimeOffsetId = 1;
+const uint8_t kAbsoluteSendTimeId = 3;
+const uint8_t kTransportSequenceNumberId = 5;
+
+typedef std::vector<std::vector<uint8_t> > Packets;
+
+void ReadPackets(test::RtpFileReader::FileFormat format,
+                 const std::string& filename,
+                 const std::string& extension,
+                 Packets* packets) {
+  rtc::scoped_ptr<test::RtpFileReader> reader(test::RtpFileReader::Create(
+      format, test::ResourcePath("video_coding/" + filename, extension)));
+  ASSERT_TRUE(reader.get() != NULL) << filename;
+  test::RtpPacket packet;
+  while (reader->NextPacket(&packet)) {
+    if (!RtpHeaderParser::IsRtcp(packet.data, packet.length))
+      packets->push_back(
+          std::vector<uint8_t>(packet.data, packet.data + packet.length));
+  }
+}
+
+// A video packet as sent by a current sender, with transmission time offset,
+// absolute send time and transport sequence number extensions.
+std::vector<uint8_t> BuildPacketWithExtensions() {
+  const uint8_t kPacket[] = {
+      0x90, 0x64, 0x12, 0x34, 0x00, 0x01, 0x02, 0x03,  // V=2, X, PT, seq, ts.
+      0x11, 0x22, 0x33, 0x44,                          // SSRC.
+      0xbe, 0xde, 0x00, 0x03,                          // 3 words.
+      (kTransmissionTimeOffsetId << 4) | 2, 0x00, 0x01, 0x02,
+      (kAbsoluteSendTimeId << 4) | 2, 0x12, 0x34, 0x56,
+      (kTransportSequenceNumberId << 4) | 1, 0x43, 0x21, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // Payload.
+  };
+  return std::vector<uint8_t>(kPacket, kPacket + sizeof(kPacket));
+}
+
+// How RtpHeaderParser::Parse() used to work: copy the extension map under a
+// lock for every packet, and look up each extension in the copy.
+class MapCopyingParser {
+ public:
+  MapCopyingParser()
+      : critical_section_(CriticalSectionWrapper::CreateCriticalSection()) {}
+
+  void RegisterRtpHeaderExtension(RTPExtensionType type, uint8_t id) {
+    CriticalSectionScoped cs(critical_section_.get());
+    map_.Register(type, id);
+  }
+
+  bool Parse(const uint8_t* packet, size_t length, RTPHeader* header) const {
+    RtpUtility::RtpHeaderParser rtp_parser(packet, length);
+    RtpHeaderExtensionMap map;
+    {
+      CriticalSectionScoped cs(critical_section_.get());
+      map_.GetCopy(&map);
+    }
+    return rtp_parser.Parse(*header, &map);
+  }
+
+ private:
+  rtc::scoped_ptr<CriticalSectionWrapper> critical_section_;
+  RtpHeaderExtensionMap map_;
+};
+
+template <typename Parser>
+uint32_t ParseAll(const Parser& parser, const Packets& packets) {
+  uint32_t sum = 0;
+  RTPHeader header;
+  for (const std::vector<uint8_t>& packet : packets) {
+    if (!parser.Parse(&packet[0], packet.size(), &header))
+      continue;
+    sum += header.ssrc + header.sequenceNumber +
+           header.extension.absoluteSendTime +
+           header.extension.transportSequenceNumber;
+  }
+  return sum;
+}
+
+template <typename Parser>
+double PacketsPerSecond(const Parser& parser,
+                        const Packets& packets,
+                        uint32_t* sum) {
+  Clock* clock = Clock::GetRealTimeClock();
+  const int64_t start_us = clock->TimeInMicroseconds();
+  for (int i = 0; i < kNumPasses; ++i)
+    *sum += ParseAll(parser, packets);
+  const int64_t elapsed_us = clock->TimeInMicroseconds() - start_us;
+  return 1e6 * kNumPasses * packets.size() / std::max<int64_t>(elapsed_us, 1);
+}
+
+void RunParsers(const std::string& trace, const Packets& packets) {
+  MapCopyingParser map_parser;
+  rtc::scoped_ptr<RtpHeaderParser> parser(RtpHeaderParser::Create());
+  const RTPExtensionType kTypes[] = {kRtpExtensionTransmissionTimeOffset,
+                                     kRtpExtensionAbsoluteSendTime,
+                                     kRtpExtensionTransportSequenceNumber};
+  const uint8_t kIds[] = {kTransmissionTimeOffsetId, kAbsoluteSendTimeId,
+                          kTransportSequenceNumberId};
+  for (size_t i = 0; i < sizeof(kIds) / sizeof(kIds[0]); ++i) {
+    map_parser.RegisterRtpHeaderExtension(kTypes[i], kIds[i]);
+    parser->RegisterRtpHeaderExtension(kTypes[i], kIds[i]);
+  }
+
+  uint32_t map_sum = 0;
+  uint32_t snapshot_sum = 0;
+  const double map_rate = PacketsPerSecond(map_parser, packets, &map_sum);
+  const double snapshot_rate =
+      PacketsPerSecond(*parser, packets, &snapshot_sum);
+  EXPECT_EQ(map_sum, snapshot_sum);
+
+  test::PrintResult("rtp_header_parse_rate", "_map_copy", trace, map_rate,
+                    "packets/s", false);
+  test::PrintResult("rtp_header_parse_rate", "_snapshot", trace,
+                    snapshot_rate, "packets/s", true);
+}
+
+}  // namespace
+
+TEST(RtpHeaderParserPerfTest, RecordedDumps) {
+  Packets packets;
+  ReadPackets(test::RtpFileReader::kRtpDump, "pltype103", "rtp", &packets);
+  ReadPackets(test::RtpFileReader::kPcap, "ssrcs-3", "pcap", &packets);
+  ReadPackets(test::RtpFileReader::kPcap, "frame-ethernet-ii", "pcap",
+              &packets);
+  ASSERT_FALSE(packets.empty());
+  RunParsers("recorded_dumps", packets);
+}
+
+TEST(RtpHeaderParserPerfTest, PacketsWithExtensions) {
+  // The recorded dumps predate most header extensions.
+  RunParsers("with_extensions", Packets(1000, BuildPacketWithExtensions()));
+}
+
+}  // namespace webrtc
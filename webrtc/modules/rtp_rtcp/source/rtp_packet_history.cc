@@ -13,6 +13,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>   // memset
+#include <algorithm>
 #include <limits>
 #include <set>
 
@@ -55,6 +56,8 @@ void RTPPacketHistory::Allocate(size_t number_to_store) {
   assert(number_to_store <= kMaxHistoryCapacity);
   store_ = true;
   stored_packets_.resize(number_to_store);
+  stored_batches_.resize(number_to_store);
+  stored_offsets_.resize(number_to_store);
   stored_seq_nums_.resize(number_to_store);
   stored_lengths_.resize(number_to_store);
   stored_times_.resize(number_to_store);
@@ -73,6 +76,8 @@ void RTPPacketHistory::Free() {
   }
 
   stored_packets_.clear();
+  stored_batches_.clear();
+  stored_offsets_.clear();
   stored_seq_nums_.clear();
   stored_lengths_.clear();
   stored_times_.clear();
@@ -89,33 +94,50 @@ bool RTPPacketHistory::StorePackets() const {
   return store_;
 }
 
-void RTPPacketHistory::VerifyAndAllocatePacketLength(size_t packet_length,
-                                                     uint32_t start_index) {
-  assert(packet_length > 0);
-  if (!store_) {
-    return;
+int32_t RTPPacketHistory::PutRTPPacket(const uint8_t* packet,
+                                       size_t packet_length,
+                                       size_t max_packet_length,
+                                       int64_t capture_time_ms,
+                                       StorageType type) {
+  if (type == kDontStore) {
+    return 0;
   }
 
-  // If start_index > 0 this is a resize and we must check any new (empty)
-  // packets created during the resize.
-  if (start_index == 0 && packet_length <= max_packet_length_) {
-    return;
+  CriticalSectionScoped cs(critsect_.get());
+  if (!store_) {
+    return 0;
   }
 
-  max_packet_length_ = std::max(packet_length, max_packet_length_);
+  assert(packet);
+  assert(packet_length > 3);
+
+  const uint16_t seq_num = (packet[2] << 8) + packet[3];
+  int index = StoreEntry(seq_num, packet_length, max_packet_length,
+                         capture_time_ms, type);
+  if (index < 0) {
+    return -1;
+  }
 
-  std::vector<std::vector<uint8_t> >::iterator it;
-  for (it = stored_packets_.begin() + start_index; it != stored_packets_.end();
-       ++it) {
-    it->resize(max_packet_length_);
+  // Copies are only allocated when needed, packets stored by reference don't
+  // use them.
+  std::vector<uint8_t>& stored_packet = stored_packets_[index];
+  if (stored_packet.size() < max_packet_length_) {
+    stored_packet.resize(max_packet_length_);
   }
+  // TODO(sprang): Overhaul this class and get rid of this copy step.
+  //               (Finally introduce the RtpPacket class?)
+  std::copy(packet, packet + packet_length, stored_packet.begin());
+  stored_batches_[index] = nullptr;
+  return 0;
 }
 
-int32_t RTPPacketHistory::PutRTPPacket(const uint8_t* packet,
-                                       size_t packet_length,
-                                       size_t max_packet_length,
-                                       int64_t capture_time_ms,
-                                       StorageType type) {
+int32_t RTPPacketHistory::PutRTPPacket(
+    const rtc::scoped_refptr<RtpPacketBatch>& batch,
+    size_t offset,
+    size_t packet_length,
+    size_t max_packet_length,
+    int64_t capture_time_ms,
+    StorageType type) {
   if (type == kDontStore) {
     return 0;
   }
@@ -125,19 +147,34 @@ int32_t RTPPacketHistory::PutRTPPacket(const uint8_t* packet,
     return 0;
   }
 
-  assert(packet);
+  assert(batch);
   assert(packet_length > 3);
+  assert(offset + packet_length <= batch->size());
 
-  VerifyAndAllocatePacketLength(max_packet_length, 0);
+  const uint8_t* packet = &(*batch)[offset];
+  const uint16_t seq_num = (packet[2] << 8) + packet[3];
+  int index = StoreEntry(seq_num, packet_length, max_packet_length,
+                         capture_time_ms, type);
+  if (index < 0) {
+    return -1;
+  }
+  stored_batches_[index] = batch;
+  stored_offsets_[index] = offset;
+  return 0;
+}
 
+int RTPPacketHistory::StoreEntry(uint16_t sequence_number,
+                                 size_t packet_length,
+                                 size_t max_packet_length,
+                                 int64_t capture_time_ms,
+                                 StorageType type) {
+  max_packet_length_ = std::max(max_packet_length, max_packet_length_);
   if (packet_length > max_packet_length_) {
     LOG(LS_WARNING) << "Failed to store RTP packet with length: "
                     << packet_length;
     return -1;
   }
 
-  const uint16_t seq_num = (packet[2] << 8) + packet[3];
-
   // If index we're about to overwrite contains a packet that has not
   // yet been sent (probably pending in paced sender), we need to expand
   // the buffer.
@@ -148,32 +185,25 @@ int32_t RTPPacketHistory::PutRTPPacket(const uint8_t* packet,
       size_t expanded_size = std::max(current_size * 3 / 2, current_size + 1);
       expanded_size = std::min(expanded_size, kMaxHistoryCapacity);
       Allocate(expanded_size);
-      VerifyAndAllocatePacketLength(max_packet_length, current_size);
       // Causes discontinuity, but that's OK-ish. FindSeqNum() will still work,
       // but may be slower - at least until buffer has wrapped around once.
       prev_index_ = current_size;
     }
   }
 
-  // Store packet
-  std::vector<std::vector<uint8_t> >::iterator it =
-      stored_packets_.begin() + prev_index_;
-  // TODO(sprang): Overhaul this class and get rid of this copy step.
-  //               (Finally introduce the RtpPacket class?)
-  std::copy(packet, packet + packet_length, it->begin());
-
-  stored_seq_nums_[prev_index_] = seq_num;
-  stored_lengths_[prev_index_] = packet_length;
-  stored_times_[prev_index_] = (capture_time_ms > 0) ? capture_time_ms :
+  const int index = prev_index_;
+  stored_seq_nums_[index] = sequence_number;
+  stored_lengths_[index] = packet_length;
+  stored_times_[index] = (capture_time_ms > 0) ? capture_time_ms :
       clock_->TimeInMilliseconds();
-  stored_send_times_[prev_index_] = 0;  // Packet not sent.
-  stored_types_[prev_index_] = type;
+  stored_send_times_[index] = 0;  // Packet not sent.
+  stored_types_[index] = type;
 
   ++prev_index_;
   if (prev_index_ >= stored_seq_nums_.size()) {
     prev_index_ = 0;
   }
-  return 0;
+  return index;
 }
 
 bool RTPPacketHistory::HasRTPPacket(uint16_t sequence_number) const {
@@ -267,10 +297,11 @@ void RTPPacketHistory::GetPacket(int index,
                                  int64_t* stored_time_ms) const {
   // Get packet.
   size_t length = stored_lengths_.at(index);
-  std::vector<std::vector<uint8_t> >::const_iterator it_found_packet =
-      stored_packets_.begin() + index;
-  std::copy(it_found_packet->begin(), it_found_packet->begin() + length,
-            packet);
+  const uint8_t* stored_packet =
+      stored_batches_[index]
+          ? &(*stored_batches_[index])[stored_offsets_[index]]
+          : &stored_packets_[index][0];
+  std::copy(stored_packet, stored_packet + length, packet);
   *packet_length = length;
   *stored_time_ms = stored_times_.at(index);
 }
@@ -15,6 +15,8 @@
 
 #include <vector>
 
+#include "webrtc/base/refcount.h"
+#include "webrtc/base/scoped_ref_ptr.h"
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/interface/module_common_types.h"
 #include "webrtc/modules/rtp_rtcp/interface/rtp_rtcp_defines.h"
@@ -27,6 +29,11 @@ class CriticalSectionWrapper;
 
 static const size_t kMaxHistoryCapacity = 9600;
 
+// RTP packets written back to back into one buffer, e.g. all packets of a
+// video frame. The packet history keeps references to the batch instead of
+// copies of its packets, so packets must not be modified once stored.
+typedef rtc::RefCountedObject<std::vector<uint8_t> > RtpPacketBatch;
+
 class RTPPacketHistory {
  public:
   RTPPacketHistory(Clock* clock);
@@ -43,6 +50,14 @@ class RTPPacketHistory {
                        int64_t capture_time_ms,
                        StorageType type);
 
+  // Stores a reference to the RTP packet at |offset| in |batch|.
+  int32_t PutRTPPacket(const rtc::scoped_refptr<RtpPacketBatch>& batch,
+                       size_t offset,
+                       size_t packet_length,
+                       size_t max_packet_length,
+                       int64_t capture_time_ms,
+                       StorageType type);
+
   // Gets stored RTP packet corresponding to the input sequence number.
   // The packet is copied to the buffer pointed to by ptr_rtp_packet.
   // The rtp_packet_length should show the available buffer size.
@@ -74,10 +89,15 @@ class RTPPacketHistory {
                  size_t* packet_length,
                  int64_t* stored_time_ms) const
       EXCLUSIVE_LOCKS_REQUIRED(*critsect_);
+  // Returns the index to store a packet with |sequence_number| at, expanding
+  // the history if needed, or -1 if the packet is too long.
+  int StoreEntry(uint16_t sequence_number,
+                 size_t packet_length,
+                 size_t max_packet_length,
+                 int64_t capture_time_ms,
+                 StorageType type) EXCLUSIVE_LOCKS_REQUIRED(*critsect_);
   void Allocate(size_t number_to_store) EXCLUSIVE_LOCKS_REQUIRED(*critsect_);
   void Free() EXCLUSIVE_LOCKS_REQUIRED(*critsect_);
-  void VerifyAndAllocatePacketLength(size_t packet_length, uint32_t start_index)
-      EXCLUSIVE_LOCKS_REQUIRED(*critsect_);
   bool FindSeqNum(uint16_t sequence_number, int32_t* index) const
       EXCLUSIVE_LOCKS_REQUIRED(*critsect_);
   int FindBestFittingPacket(size_t size) const
@@ -91,6 +111,11 @@ class RTPPacketHistory {
   size_t max_packet_length_ GUARDED_BY(critsect_);
 
   std::vector<std::vector<uint8_t> > stored_packets_ GUARDED_BY(critsect_);
+  // Packets stored by reference are at |stored_offsets_| in the batch, and
+  // have no copy in |stored_packets_|.
+  std::vector<rtc::scoped_refptr<RtpPacketBatch> > stored_batches_
+      GUARDED_BY(critsect_);
+  std::vector<size_t> stored_offsets_ GUARDED_BY(critsect_);
   std::vector<uint16_t> stored_seq_nums_ GUARDED_BY(critsect_);
   std::vector<size_t> stored_lengths_ GUARDED_BY(critsect_);
   std::vector<int64_t> stored_times_ GUARDED_BY(critsect_);
@@ -143,6 +143,36 @@ TEST_F(RtpPacketHistoryTest, GetRtpPacket) {
   }
 }
 
+TEST_F(RtpPacketHistoryTest, GetRtpPacketFromBatch) {
+  hist_->SetStorePacketsStatus(true, 10);
+  rtc::scoped_refptr<RtpPacketBatch> batch(new RtpPacketBatch());
+  batch->resize(2 * kMaxPacketLength);
+  size_t len = 0;
+  CreateRtpPacket(kSeqNum, kSsrc, kPayload, kTimestamp, &(*batch)[0], &len);
+  const size_t offset = len;
+  CreateRtpPacket(kSeqNum + 1, kSsrc, kPayload, kTimestamp, &(*batch)[0],
+                  &len);
+  int64_t capture_time_ms = 1;
+  EXPECT_EQ(0, hist_->PutRTPPacket(batch, 0, offset, kMaxPacketLength,
+                                   capture_time_ms, kAllowRetransmission));
+  EXPECT_EQ(0, hist_->PutRTPPacket(batch, offset, len - offset,
+                                   kMaxPacketLength, capture_time_ms,
+                                   kAllowRetransmission));
+  // The history keeps the batch alive.
+  std::vector<uint8_t> expected_packets(*batch);
+  batch = nullptr;
+
+  size_t len_out = kMaxPacketLength;
+  int64_t time;
+  EXPECT_TRUE(hist_->GetPacketAndSetSendTime(kSeqNum + 1, 0, false,
+                                             packet_out_, &len_out, &time));
+  EXPECT_EQ(len - offset, len_out);
+  EXPECT_EQ(capture_time_ms, time);
+  for (size_t i = 0; i < len_out; i++) {
+    EXPECT_EQ(expected_packets[offset + i], packet_out_[i]);
+  }
+}
+
 TEST_F(RtpPacketHistoryTest, NoCaptureTime) {
   hist_->SetStorePacketsStatus(true, 10);
   size_t len = 0;
@@ -42,7 +42,9 @@ RtpRtcp::Configuration::Configuration()
       paced_sender(NULL),
       send_bitrate_observer(NULL),
       send_frame_count_observer(NULL),
-      send_side_delay_observer(NULL) {
+      send_side_delay_observer(NULL),
+      transport_sequence_number_allocator(NULL),
+      transport_feedback_callback(NULL) {
 }
 
 RtpRtcp* RtpRtcp::CreateRtpRtcp(const RtpRtcp::Configuration& configuration) {
@@ -67,7 +69,9 @@ ModuleRtpRtcpImpl::ModuleRtpRtcpImpl(const Configuration& configuration)
                   configuration.paced_sender,
                   configuration.send_bitrate_observer,
                   configuration.send_frame_count_observer,
-                  configuration.send_side_delay_observer),
+                  configuration.send_side_delay_observer,
+                  configuration.transport_sequence_number_allocator,
+                  configuration.transport_feedback_callback),
       rtcp_sender_(configuration.id,
                    configuration.audio,
                    configuration.clock,
@@ -79,6 +83,7 @@ ModuleRtpRtcpImpl::ModuleRtpRtcpImpl(const Configuration& configuration)
                      configuration.rtcp_packet_type_counter_observer,
                      configuration.bandwidth_callback,
                      configuration.intra_frame_callback,
+                     configuration.transport_feedback_callback,
                      this),
       clock_(configuration.clock),
       id_(configuration.id),
@@ -416,17 +421,19 @@ int32_t ModuleRtpRtcpImpl::SendOutgoingData(
 bool ModuleRtpRtcpImpl::TimeToSendPacket(uint32_t ssrc,
                                          uint16_t sequence_number,
                                          int64_t capture_time_ms,
-                                         bool retransmission) {
+                                         bool retransmission,
+                                         int probe_cluster_id) {
   if (SendingMedia() && ssrc == rtp_sender_.SSRC()) {
-    return rtp_sender_.TimeToSendPacket(
-        sequence_number, capture_time_ms, retransmission);
+    return rtp_sender_.TimeToSendPacket(sequence_number, capture_time_ms,
+                                        retransmission, probe_cluster_id);
   }
   // No RTP sender is interested in sending this packet.
   return true;
 }
 
-size_t ModuleRtpRtcpImpl::TimeToSendPadding(size_t bytes) {
-  return rtp_sender_.TimeToSendPadding(bytes);
+size_t ModuleRtpRtcpImpl::TimeToSendPadding(size_t bytes,
+                                            int probe_cluster_id) {
+  return rtp_sender_.TimeToSendPadding(bytes, probe_cluster_id);
 }
 
 uint16_t ModuleRtpRtcpImpl::MaxPayloadLength() const {
@@ -634,6 +641,11 @@ void ModuleRtpRtcpImpl::SetREMBData(const uint32_t bitrate,
   rtcp_sender_.SetREMBData(bitrate, ssrcs);
 }
 
+bool ModuleRtpRtcpImpl::SendFeedbackPacket(
+    const rtcp::TransportFeedback& packet) {
+  return rtcp_sender_.SendFeedbackPacket(packet);
+}
+
 // (IJ) Extended jitter report.
 bool ModuleRtpRtcpImpl::IJ() const {
   return rtcp_sender_.IJ();
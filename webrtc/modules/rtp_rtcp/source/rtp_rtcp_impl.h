@@ -116,11 +116,12 @@ class ModuleRtpRtcpImpl : public RtpRtcp {
   bool TimeToSendPacket(uint32_t ssrc,
                         uint16_t sequence_number,
                         int64_t capture_time_ms,
-                        bool retransmission) override;
+                        bool retransmission,
+                        int probe_cluster_id) override;
 
   // Returns the number of padding bytes actually sent, which can be more or
   // less than |bytes|.
-  size_t TimeToSendPadding(size_t bytes) override;
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id) override;
 
   // RTCP part.
 
@@ -187,6 +188,8 @@ class ModuleRtpRtcpImpl : public RtpRtcp {
   void SetREMBData(uint32_t bitrate,
                    const std::vector<uint32_t>& ssrcs) override;
 
+  bool SendFeedbackPacket(const rtcp::TransportFeedback& packet) override;
+
   // (IJ) Extended jitter report.
   bool IJ() const override;
 
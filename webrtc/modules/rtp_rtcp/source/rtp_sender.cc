@@ -97,15 +97,18 @@ class BitrateAggregator {
   uint32_t ssrc_;
 };
 
-RTPSender::RTPSender(int32_t id,
-                     bool audio,
-                     Clock* clock,
-                     Transport* transport,
-                     RtpAudioFeedback* audio_feedback,
-                     PacedSender* paced_sender,
-                     BitrateStatisticsObserver* bitrate_callback,
-                     FrameCountObserver* frame_count_observer,
-                     SendSideDelayObserver* send_side_delay_observer)
+RTPSender::RTPSender(
+    int32_t id,
+    bool audio,
+    Clock* clock,
+    Transport* transport,
+    RtpAudioFeedback* audio_feedback,
+    PacedSender* paced_sender,
+    BitrateStatisticsObserver* bitrate_callback,
+    FrameCountObserver* frame_count_observer,
+    SendSideDelayObserver* send_side_delay_observer,
+    TransportSequenceNumberAllocator* sequence_number_allocator,
+    TransportFeedbackObserver* transport_feedback_observer)
     : clock_(clock),
       // TODO(holmer): Remove this conversion when we remove the use of
       // TickTime.
@@ -143,6 +146,8 @@ RTPSender::RTPSender(int32_t id,
       rtp_stats_callback_(NULL),
       frame_count_observer_(frame_count_observer),
       send_side_delay_observer_(send_side_delay_observer),
+      transport_sequence_number_allocator_(sequence_number_allocator),
+      transport_feedback_observer_(transport_feedback_observer),
       // RTP variables
       start_timestamp_forced_(false),
       start_timestamp_(0),
@@ -541,7 +546,8 @@ int32_t RTPSender::SendOutgoingData(FrameType frame_type,
   return ret_val;
 }
 
-size_t RTPSender::TrySendRedundantPayloads(size_t bytes_to_send) {
+size_t RTPSender::TrySendRedundantPayloads(size_t bytes_to_send,
+                                           int probe_cluster_id) {
   {
     CriticalSectionScoped cs(send_critsect_.get());
     if ((rtx_ & kRtxRedundantPayloads) == 0)
@@ -557,8 +563,10 @@ size_t RTPSender::TrySendRedundantPayloads(size_t bytes_to_send) {
                                               &capture_time_ms)) {
       break;
     }
-    if (!PrepareAndSendPacket(buffer, length, capture_time_ms, true, false))
+    if (!PrepareAndSendPacket(buffer, length, capture_time_ms, true, false,
+                              probe_cluster_id)) {
       break;
+    }
     RtpUtility::RtpHeaderParser rtp_parser(buffer, length);
     RTPHeader rtp_header;
     rtp_parser.Parse(rtp_header);
@@ -583,7 +591,7 @@ size_t RTPSender::BuildPaddingPacket(uint8_t* packet, size_t header_length) {
   return padding_bytes_in_packet;
 }
 
-size_t RTPSender::TrySendPadData(size_t bytes) {
+size_t RTPSender::TrySendPadData(size_t bytes, int probe_cluster_id) {
   int64_t capture_time_ms;
   uint32_t timestamp;
   {
@@ -597,12 +605,13 @@ size_t RTPSender::TrySendPadData(size_t bytes) {
           (clock_->TimeInMilliseconds() - last_timestamp_time_ms_);
     }
   }
-  return SendPadData(timestamp, capture_time_ms, bytes);
+  return SendPadData(timestamp, capture_time_ms, bytes, probe_cluster_id);
 }
 
 size_t RTPSender::SendPadData(uint32_t timestamp,
                               int64_t capture_time_ms,
-                              size_t bytes) {
+                              size_t bytes,
+                              int probe_cluster_id) {
   size_t padding_bytes_in_packet = 0;
   size_t bytes_sent = 0;
   for (; bytes > 0; bytes -= padding_bytes_in_packet) {
@@ -661,6 +670,8 @@ size_t RTPSender::SendPadData(uint32_t timestamp,
     }
 
     UpdateAbsoluteSendTime(padding_packet, length, rtp_header, now_ms);
+    UpdateTransportSequenceNumber(padding_packet, length, rtp_header, now_ms,
+                                  probe_cluster_id);
     if (!SendPacketToNetwork(padding_packet, length))
       break;
     bytes_sent += padding_bytes_in_packet;
@@ -713,7 +724,8 @@ int32_t RTPSender::ReSendPacket(uint16_t packet_id, int64_t min_resend_time) {
     rtx = rtx_;
   }
   return PrepareAndSendPacket(data_buffer, length, capture_time_ms,
-                              (rtx & kRtxRetransmitted) > 0, true) ?
+                              (rtx & kRtxRetransmitted) > 0, true,
+                              PacedSender::kNotAProbe) ?
       static_cast<int32_t>(length) : -1;
 }
 
@@ -840,7 +852,8 @@ void RTPSender::UpdateNACKBitRate(uint32_t bytes, int64_t now) {
 // Called from pacer when we can send the packet.
 bool RTPSender::TimeToSendPacket(uint16_t sequence_number,
                                  int64_t capture_time_ms,
-                                 bool retransmission) {
+                                 bool retransmission,
+                                 int probe_cluster_id) {
   size_t length = IP_PACKET_SIZE;
   uint8_t data_buffer[IP_PACKET_SIZE];
   int64_t stored_time_ms;
@@ -866,14 +879,16 @@ bool RTPSender::TimeToSendPacket(uint16_t sequence_number,
                               length,
                               capture_time_ms,
                               retransmission && (rtx & kRtxRetransmitted) > 0,
-                              retransmission);
+                              retransmission,
+                              probe_cluster_id);
 }
 
 bool RTPSender::PrepareAndSendPacket(uint8_t* buffer,
                                      size_t length,
                                      int64_t capture_time_ms,
                                      bool send_over_rtx,
-                                     bool is_retransmit) {
+                                     bool is_retransmit,
+                                     int probe_cluster_id) {
   uint8_t *buffer_to_send_ptr = buffer;
 
   RtpUtility::RtpHeaderParser rtp_parser(buffer, length);
@@ -899,6 +914,8 @@ bool RTPSender::PrepareAndSendPacket(uint8_t* buffer,
   UpdateTransmissionTimeOffset(buffer_to_send_ptr, length, rtp_header,
                                diff_ms);
   UpdateAbsoluteSendTime(buffer_to_send_ptr, length, rtp_header, now_ms);
+  UpdateTransportSequenceNumber(buffer_to_send_ptr, length, rtp_header,
+                                now_ms, probe_cluster_id);
   bool ret = SendPacketToNetwork(buffer_to_send_ptr, length);
   if (ret) {
     CriticalSectionScoped lock(send_critsect_.get());
@@ -957,16 +974,16 @@ bool RTPSender::IsFecPacket(const uint8_t* buffer,
       buffer[header.headerLength] == pt_fec;
 }
 
-size_t RTPSender::TimeToSendPadding(size_t bytes) {
+size_t RTPSender::TimeToSendPadding(size_t bytes, int probe_cluster_id) {
   if (bytes == 0)
     return 0;
   {
     CriticalSectionScoped cs(send_critsect_.get());
     if (!sending_media_) return 0;
   }
-  size_t bytes_sent = TrySendRedundantPayloads(bytes);
+  size_t bytes_sent = TrySendRedundantPayloads(bytes, probe_cluster_id);
   if (bytes_sent < bytes)
-    bytes_sent += TrySendPadData(bytes - bytes_sent);
+    bytes_sent += TrySendPadData(bytes - bytes_sent, probe_cluster_id);
   return bytes_sent;
 }
 
@@ -975,6 +992,26 @@ int32_t RTPSender::SendToNetwork(
     uint8_t *buffer, size_t payload_length, size_t rtp_header_length,
     int64_t capture_time_ms, StorageType storage,
     PacedSender::Priority priority) {
+  return SendToNetworkInternal(buffer, nullptr, 0, payload_length,
+                               rtp_header_length, capture_time_ms, storage,
+                               priority);
+}
+
+int32_t RTPSender::SendToNetwork(
+    const rtc::scoped_refptr<RtpPacketBatch>& batch, size_t offset,
+    size_t payload_length, size_t rtp_header_length,
+    int64_t capture_time_ms, StorageType storage,
+    PacedSender::Priority priority) {
+  return SendToNetworkInternal(&(*batch)[offset], batch, offset,
+                               payload_length, rtp_header_length,
+                               capture_time_ms, storage, priority);
+}
+
+int32_t RTPSender::SendToNetworkInternal(
+    uint8_t* buffer, const rtc::scoped_refptr<RtpPacketBatch>& batch,
+    size_t offset, size_t payload_length, size_t rtp_header_length,
+    int64_t capture_time_ms, StorageType storage,
+    PacedSender::Priority priority) {
   RtpUtility::RtpHeaderParser rtp_parser(buffer,
                                          payload_length + rtp_header_length);
   RTPHeader rtp_header;
@@ -994,9 +1031,14 @@ int32_t RTPSender::SendToNetwork(
                          rtp_header, now_ms);
 
   // Used for NACK and to spread out the transmission of packets.
-  if (packet_history_.PutRTPPacket(buffer, rtp_header_length + payload_length,
-                                   max_payload_length_, capture_time_ms,
-                                   storage) != 0) {
+  int32_t stored =
+      batch ? packet_history_.PutRTPPacket(
+                  batch, offset, rtp_header_length + payload_length,
+                  max_payload_length_, capture_time_ms, storage)
+            : packet_history_.PutRTPPacket(
+                  buffer, rtp_header_length + payload_length,
+                  max_payload_length_, capture_time_ms, storage);
+  if (stored != 0) {
     return -1;
   }
 
@@ -1024,6 +1066,17 @@ int32_t RTPSender::SendToNetwork(
   }
 
   size_t length = payload_length + rtp_header_length;
+  // The history may already share a packet from a batch, which must not
+  // change once stored.
+  uint8_t send_buffer[IP_PACKET_SIZE];
+  if (batch && storage != kDontStore) {
+    memcpy(send_buffer, buffer, length);
+    buffer = send_buffer;
+  }
+  // Not paced, so the packet goes out now and gets its transport-wide
+  // sequence number now.
+  UpdateTransportSequenceNumber(buffer, length, rtp_header, now_ms,
+                                PacedSender::kNotAProbe);
   bool sent = SendPacketToNetwork(buffer, length);
 
   if (storage != kDontStore) {
@@ -1596,6 +1649,60 @@ void RTPSender::UpdateAbsoluteSendTime(uint8_t* rtp_packet,
                                           ((now_ms << 18) / 1000) & 0x00ffffff);
 }
 
+void RTPSender::UpdateTransportSequenceNumber(uint8_t* rtp_packet,
+                                              size_t rtp_packet_length,
+                                              const RTPHeader& rtp_header,
+                                              int64_t now_ms,
+                                              int probe_cluster_id) const {
+  if (!transport_sequence_number_allocator_)
+    return;
+  size_t block_pos;
+  {
+    CriticalSectionScoped cs(send_critsect_.get());
+    uint8_t id = 0;
+    if (rtp_header_extension_map_.GetId(kRtpExtensionTransportSequenceNumber,
+                                        &id) != 0) {
+      // Not registered.
+      return;
+    }
+    int extension_block_pos =
+        rtp_header_extension_map_.GetLengthUntilBlockStartInBytes(
+            kRtpExtensionTransportSequenceNumber);
+    if (extension_block_pos < 0)
+      return;
+    block_pos = kRtpHeaderLength + rtp_header.numCSRCs + extension_block_pos;
+    if (rtp_packet_length < block_pos + kTransportSequenceNumberLength ||
+        rtp_header.headerLength <
+            block_pos + kTransportSequenceNumberLength) {
+      LOG(LS_WARNING)
+          << "Failed to update transport sequence number, invalid length.";
+      return;
+    }
+    // Verify that header contains extension.
+    if (!((rtp_packet[kRtpHeaderLength + rtp_header.numCSRCs] == 0xBE) &&
+          (rtp_packet[kRtpHeaderLength + rtp_header.numCSRCs + 1] == 0xDE))) {
+      LOG(LS_WARNING) << "Failed to update transport sequence number, hdr "
+                         "extension not found.";
+      return;
+    }
+    // Verify first byte in block.
+    const uint8_t first_block_byte = (id << 4) + 1;
+    if (rtp_packet[block_pos] != first_block_byte) {
+      LOG(LS_WARNING) << "Failed to update transport sequence number.";
+      return;
+    }
+  }
+  const uint16_t sequence_number =
+      transport_sequence_number_allocator_->AllocateSequenceNumber();
+  ByteWriter<uint16_t>::WriteBigEndian(rtp_packet + block_pos + 1,
+                                       sequence_number);
+  if (transport_feedback_observer_) {
+    transport_feedback_observer_->OnSentPacket(
+        sequence_number, now_ms, rtp_packet_length - rtp_header.headerLength,
+        probe_cluster_id);
+  }
+}
+
 void RTPSender::SetSendingStatus(bool enabled) {
   if (enabled) {
     uint32_t frequency_hz = SendPayloadFrequency();
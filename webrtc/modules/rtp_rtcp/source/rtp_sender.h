@@ -74,6 +74,13 @@ class RTPSenderInterface {
       uint8_t *data_buffer, size_t payload_length, size_t rtp_header_length,
       int64_t capture_time_ms, StorageType storage,
       PacedSender::Priority priority) = 0;
+  // Same as above for the packet at |offset| in |batch|. The packet history
+  // keeps a reference to the batch instead of a copy of the packet.
+  virtual int32_t SendToNetwork(
+      const rtc::scoped_refptr<RtpPacketBatch>& batch, size_t offset,
+      size_t payload_length, size_t rtp_header_length,
+      int64_t capture_time_ms, StorageType storage,
+      PacedSender::Priority priority) = 0;
 
   virtual bool UpdateVideoRotation(uint8_t* rtp_packet,
                                    size_t rtp_packet_length,
@@ -93,7 +100,9 @@ class RTPSender : public RTPSenderInterface {
             PacedSender* paced_sender,
             BitrateStatisticsObserver* bitrate_callback,
             FrameCountObserver* frame_count_observer,
-            SendSideDelayObserver* send_side_delay_observer);
+            SendSideDelayObserver* send_side_delay_observer,
+            TransportSequenceNumberAllocator* sequence_number_allocator,
+            TransportFeedbackObserver* transport_feedback_observer);
   virtual ~RTPSender();
 
   void ProcessBitrate();
@@ -187,8 +196,8 @@ class RTPSender : public RTPSenderInterface {
                                    VideoRotation rotation) const override;
 
   bool TimeToSendPacket(uint16_t sequence_number, int64_t capture_time_ms,
-                        bool retransmission);
-  size_t TimeToSendPadding(size_t bytes);
+                        bool retransmission, int probe_cluster_id);
+  size_t TimeToSendPadding(size_t bytes, int probe_cluster_id);
 
   // NACK.
   int SelectiveRetransmissions() const;
@@ -238,6 +247,13 @@ class RTPSender : public RTPSenderInterface {
                         int64_t capture_time_ms,
                         StorageType storage,
                         PacedSender::Priority priority) override;
+  int32_t SendToNetwork(const rtc::scoped_refptr<RtpPacketBatch>& batch,
+                        size_t offset,
+                        size_t payload_length,
+                        size_t rtp_header_length,
+                        int64_t capture_time_ms,
+                        StorageType storage,
+                        PacedSender::Priority priority) override;
 
   // Audio.
 
@@ -277,7 +293,8 @@ class RTPSender : public RTPSenderInterface {
 
   size_t SendPadData(uint32_t timestamp,
                      int64_t capture_time_ms,
-                     size_t bytes);
+                     size_t bytes,
+                     int probe_cluster_id);
 
   // Called on update of RTP statistics.
   void RegisterRtpStatisticsCallback(StreamDataCountersCallback* callback);
@@ -310,16 +327,29 @@ class RTPSender : public RTPSenderInterface {
 
   void UpdateNACKBitRate(uint32_t bytes, int64_t now);
 
+  // Sends the packet in |buffer|, which is at |offset| in |batch| if |batch|
+  // is set.
+  int32_t SendToNetworkInternal(
+      uint8_t* buffer,
+      const rtc::scoped_refptr<RtpPacketBatch>& batch,
+      size_t offset,
+      size_t payload_length,
+      size_t rtp_header_length,
+      int64_t capture_time_ms,
+      StorageType storage,
+      PacedSender::Priority priority);
+
   bool PrepareAndSendPacket(uint8_t* buffer,
                             size_t length,
                             int64_t capture_time_ms,
                             bool send_over_rtx,
-                            bool is_retransmit);
+                            bool is_retransmit,
+                            int probe_cluster_id);
 
   // Return the number of bytes sent.  Note that both of these functions may
   // return a larger value that their argument.
-  size_t TrySendRedundantPayloads(size_t bytes);
-  size_t TrySendPadData(size_t bytes);
+  size_t TrySendRedundantPayloads(size_t bytes, int probe_cluster_id);
+  size_t TrySendPadData(size_t bytes, int probe_cluster_id);
 
   size_t BuildPaddingPacket(uint8_t* packet, size_t header_length);
 
@@ -346,6 +376,14 @@ class RTPSender : public RTPSenderInterface {
                               size_t rtp_packet_length,
                               const RTPHeader& rtp_header,
                               int64_t now_ms) const;
+  // Writes the next transport-wide sequence number into |rtp_packet|, if it
+  // has that header extension, and reports the packet as sent as part of
+  // probe cluster |probe_cluster_id|.
+  void UpdateTransportSequenceNumber(uint8_t* rtp_packet,
+                                     size_t rtp_packet_length,
+                                     const RTPHeader& rtp_header,
+                                     int64_t now_ms,
+                                     int probe_cluster_id) const;
 
   void UpdateRtpStats(const uint8_t* buffer,
                       size_t packet_length,
@@ -402,6 +440,8 @@ class RTPSender : public RTPSenderInterface {
   StreamDataCountersCallback* rtp_stats_callback_ GUARDED_BY(statistics_crit_);
   FrameCountObserver* const frame_count_observer_;
   SendSideDelayObserver* const send_side_delay_observer_;
+  TransportSequenceNumberAllocator* const transport_sequence_number_allocator_;
+  TransportFeedbackObserver* const transport_feedback_observer_;
 
   // RTP variables
   bool start_timestamp_forced_ GUARDED_BY(send_critsect_);
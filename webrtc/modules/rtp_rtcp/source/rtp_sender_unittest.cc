@@ -115,7 +115,8 @@ class RtpSenderTest : public ::testing::Test {
 
   void SetUp() override {
     rtp_sender_.reset(new RTPSender(0, false, &fake_clock_, &transport_, NULL,
-                                    &mock_paced_sender_, NULL, NULL, NULL));
+                                    &mock_paced_sender_, NULL, NULL, NULL,
+                                    NULL, NULL));
     rtp_sender_->SetSequenceNumber(kSeqNum);
   }
 
@@ -424,6 +425,35 @@ TEST_F(RtpSenderTest, BuildRTPPacketWithAbsoluteSendTimeExtension) {
   EXPECT_EQ(0u, rtp_header2.extension.absoluteSendTime);
 }
 
+TEST_F(RtpSenderTest, ParseWithRenegotiatedExtensions) {
+  EXPECT_EQ(0, rtp_sender_->SetAbsoluteSendTime(kAbsoluteSendTime));
+  EXPECT_EQ(0, rtp_sender_->RegisterRtpHeaderExtension(
+      kRtpExtensionAbsoluteSendTime, kAbsoluteSendTimeExtensionId));
+  size_t length = static_cast<size_t>(rtp_sender_->BuildRTPheader(
+      packet_, kPayload, kMarkerBit, kTimestamp, 0));
+
+  rtc::scoped_ptr<RtpHeaderParser> parser(RtpHeaderParser::Create());
+  webrtc::RTPHeader rtp_header;
+  ASSERT_TRUE(parser->Parse(packet_, length, &rtp_header));
+  EXPECT_FALSE(rtp_header.extension.hasAbsoluteSendTime);
+
+  EXPECT_TRUE(parser->RegisterRtpHeaderExtension(
+      kRtpExtensionAbsoluteSendTime, kAbsoluteSendTimeExtensionId));
+  ASSERT_TRUE(parser->Parse(packet_, length, &rtp_header));
+  VerifyRTPHeaderCommon(rtp_header);
+  EXPECT_TRUE(rtp_header.extension.hasAbsoluteSendTime);
+  EXPECT_EQ(kAbsoluteSendTime, rtp_header.extension.absoluteSendTime);
+
+  // The id is now used by another extension.
+  EXPECT_TRUE(parser->DeregisterRtpHeaderExtension(
+      kRtpExtensionAbsoluteSendTime));
+  EXPECT_TRUE(parser->RegisterRtpHeaderExtension(
+      kRtpExtensionTransmissionTimeOffset, kAbsoluteSendTimeExtensionId));
+  ASSERT_TRUE(parser->Parse(packet_, length, &rtp_header));
+  EXPECT_FALSE(rtp_header.extension.hasAbsoluteSendTime);
+  EXPECT_TRUE(rtp_header.extension.hasTransmissionTimeOffset);
+}
+
 // Test CVO header extension is only set when marker bit is true.
 TEST_F(RtpSenderTest, BuildRTPPacketWithVideoRotation_MarkerBit) {
   rtp_sender_->SetVideoRotation(kRotation);
@@ -617,7 +647,8 @@ TEST_F(RtpSenderTest, TrafficSmoothingWithExtensions) {
   const int kStoredTimeInMs = 100;
   fake_clock_.AdvanceTimeMilliseconds(kStoredTimeInMs);
 
-  rtp_sender_->TimeToSendPacket(kSeqNum, capture_time_ms, false);
+  rtp_sender_->TimeToSendPacket(kSeqNum, capture_time_ms, false,
+                                PacedSender::kNotAProbe);
 
   // Process send bucket. Packet should now be sent.
   EXPECT_EQ(1, transport_.packets_sent_);
@@ -640,6 +671,83 @@ TEST_F(RtpSenderTest, TrafficSmoothingWithExtensions) {
   EXPECT_EQ(expected_send_time, rtp_header.extension.absoluteSendTime);
 }
 
+class TransportSequenceNumberCounter
+    : public TransportSequenceNumberAllocator,
+      public TransportFeedbackObserver {
+ public:
+  explicit TransportSequenceNumberCounter(uint16_t first)
+      : next_(first), last_sent_(0), last_send_time_ms_(-1),
+        last_payload_size_(0), last_probe_cluster_id_(0) {}
+  uint16_t AllocateSequenceNumber() override { return next_++; }
+  void OnSentPacket(uint16_t sequence_number,
+                    int64_t send_time_ms,
+                    size_t payload_size,
+                    int probe_cluster_id) override {
+    last_sent_ = sequence_number;
+    last_send_time_ms_ = send_time_ms;
+    last_payload_size_ = payload_size;
+    last_probe_cluster_id_ = probe_cluster_id;
+  }
+  void OnTransportFeedback(const rtcp::TransportFeedback& feedback) override {}
+
+  uint16_t next_;
+  uint16_t last_sent_;
+  int64_t last_send_time_ms_;
+  size_t last_payload_size_;
+  int last_probe_cluster_id_;
+};
+
+TEST_F(RtpSenderTest, TrafficSmoothingWithTransportSequenceNumber) {
+  TransportSequenceNumberCounter counter(kTransportSequenceNumber);
+  rtp_sender_.reset(new RTPSender(0, false, &fake_clock_, &transport_, NULL,
+                                  &mock_paced_sender_, NULL, NULL, NULL,
+                                  &counter, &counter));
+  rtp_sender_->SetSequenceNumber(kSeqNum);
+  EXPECT_CALL(mock_paced_sender_,
+              SendPacket(PacedSender::kNormalPriority, _, kSeqNum, _, _, _)).
+                  WillOnce(testing::Return(false));
+
+  rtp_sender_->SetStorePacketsStatus(true, 10);
+  EXPECT_EQ(0, rtp_sender_->RegisterRtpHeaderExtension(
+                   kRtpExtensionTransportSequenceNumber,
+                   kTransportSequenceNumberExtensionId));
+  int64_t capture_time_ms = fake_clock_.TimeInMilliseconds();
+  int rtp_length_int = rtp_sender_->BuildRTPheader(
+      packet_, kPayload, kMarkerBit, kTimestamp, capture_time_ms);
+  ASSERT_NE(-1, rtp_length_int);
+  size_t rtp_length = static_cast<size_t>(rtp_length_int);
+  const size_t kPayloadLength = 100;
+  memset(packet_ + rtp_length, 0, kPayloadLength);
+  EXPECT_EQ(0, rtp_sender_->SendToNetwork(packet_, kPayloadLength, rtp_length,
+                                          capture_time_ms,
+                                          kAllowRetransmission,
+                                          PacedSender::kNormalPriority));
+  // The transport-wide sequence number is only allocated when sending.
+  EXPECT_EQ(kTransportSequenceNumber, counter.next_);
+
+  fake_clock_.AdvanceTimeMilliseconds(100);
+  const int kProbeClusterId = 3;
+  rtp_sender_->TimeToSendPacket(kSeqNum, capture_time_ms, false,
+                                kProbeClusterId);
+  ASSERT_EQ(1, transport_.packets_sent_);
+
+  webrtc::RtpUtility::RtpHeaderParser rtp_parser(
+      transport_.last_sent_packet_, transport_.last_sent_packet_len_);
+  webrtc::RTPHeader rtp_header;
+  RtpHeaderExtensionMap map;
+  map.Register(kRtpExtensionTransportSequenceNumber,
+               kTransportSequenceNumberExtensionId);
+  ASSERT_TRUE(rtp_parser.Parse(rtp_header, &map));
+  EXPECT_TRUE(rtp_header.extension.hasTransportSequenceNumber);
+  EXPECT_EQ(kTransportSequenceNumber,
+            rtp_header.extension.transportSequenceNumber);
+  EXPECT_EQ(kTransportSequenceNumber + 1, counter.next_);
+  EXPECT_EQ(kTransportSequenceNumber, counter.last_sent_);
+  EXPECT_EQ(fake_clock_.TimeInMilliseconds(), counter.last_send_time_ms_);
+  EXPECT_EQ(kPayloadLength, counter.last_payload_size_);
+  EXPECT_EQ(kProbeClusterId, counter.last_probe_cluster_id_);
+}
+
 TEST_F(RtpSenderTest, TrafficSmoothingRetransmits) {
   EXPECT_CALL(mock_paced_sender_,
               SendPacket(PacedSender::kNormalPriority, _, kSeqNum, _, _, _)).
@@ -677,7 +785,8 @@ TEST_F(RtpSenderTest, TrafficSmoothingRetransmits) {
   EXPECT_EQ(rtp_length_int, rtp_sender_->ReSendPacket(kSeqNum));
   EXPECT_EQ(0, transport_.packets_sent_);
 
-  rtp_sender_->TimeToSendPacket(kSeqNum, capture_time_ms, false);
+  rtp_sender_->TimeToSendPacket(kSeqNum, capture_time_ms, false,
+                                PacedSender::kNotAProbe);
 
   // Process send bucket. Packet should now be sent.
   EXPECT_EQ(1, transport_.packets_sent_);
@@ -751,7 +860,8 @@ TEST_F(RtpSenderTest, SendPadding) {
 
   const int kStoredTimeInMs = 100;
   fake_clock_.AdvanceTimeMilliseconds(kStoredTimeInMs);
-  rtp_sender_->TimeToSendPacket(seq_num++, capture_time_ms, false);
+  rtp_sender_->TimeToSendPacket(seq_num++, capture_time_ms, false,
+                                PacedSender::kNotAProbe);
   // Packet should now be sent. This test doesn't verify the regular video
   // packet, since it is tested in another test.
   EXPECT_EQ(++total_packets_sent, transport_.packets_sent_);
@@ -763,7 +873,9 @@ TEST_F(RtpSenderTest, SendPadding) {
     const size_t kPaddingBytes = 100;
     const size_t kMaxPaddingLength = 224;  // Value taken from rtp_sender.cc.
     // Padding will be forced to full packets.
-    EXPECT_EQ(kMaxPaddingLength, rtp_sender_->TimeToSendPadding(kPaddingBytes));
+    EXPECT_EQ(kMaxPaddingLength,
+              rtp_sender_->TimeToSendPadding(kPaddingBytes,
+                                             PacedSender::kNotAProbe));
 
     // Process send bucket. Padding should now be sent.
     EXPECT_EQ(++total_packets_sent, transport_.packets_sent_);
@@ -802,7 +914,8 @@ TEST_F(RtpSenderTest, SendPadding) {
                                           kAllowRetransmission,
                                           PacedSender::kNormalPriority));
 
-  rtp_sender_->TimeToSendPacket(seq_num, capture_time_ms, false);
+  rtp_sender_->TimeToSendPacket(seq_num, capture_time_ms, false,
+                                PacedSender::kNotAProbe);
   // Process send bucket.
   EXPECT_EQ(++total_packets_sent, transport_.packets_sent_);
   EXPECT_EQ(rtp_length, transport_.last_sent_packet_len_);
@@ -823,7 +936,8 @@ TEST_F(RtpSenderTest, SendPadding) {
 TEST_F(RtpSenderTest, SendRedundantPayloads) {
   MockTransport transport;
   rtp_sender_.reset(new RTPSender(0, false, &fake_clock_, &transport, NULL,
-                                  &mock_paced_sender_, NULL, NULL, NULL));
+                                  &mock_paced_sender_, NULL, NULL, NULL,
+                                  NULL, NULL));
   rtp_sender_->SetSequenceNumber(kSeqNum);
   rtp_sender_->SetRtxPayloadType(kRtxPayload, kPayload);
   // Make all packets go through the pacer.
@@ -860,19 +974,22 @@ TEST_F(RtpSenderTest, SendRedundantPayloads) {
     EXPECT_CALL(transport, SendPacket(_, _, _))
         .WillOnce(testing::ReturnArg<2>());
     SendPacket(capture_time_ms, kPayloadSizes[i]);
-    rtp_sender_->TimeToSendPacket(seq_num++, capture_time_ms, false);
+    rtp_sender_->TimeToSendPacket(seq_num++, capture_time_ms, false,
+                                  PacedSender::kNotAProbe);
     fake_clock_.AdvanceTimeMilliseconds(33);
   }
   // The amount of padding to send it too small to send a payload packet.
   EXPECT_CALL(transport,
               SendPacket(_, _, kMaxPaddingSize + rtp_header_len))
       .WillOnce(testing::ReturnArg<2>());
-  EXPECT_EQ(kMaxPaddingSize, rtp_sender_->TimeToSendPadding(49));
+  EXPECT_EQ(kMaxPaddingSize,
+            rtp_sender_->TimeToSendPadding(49, PacedSender::kNotAProbe));
 
   EXPECT_CALL(transport, SendPacket(_, _, kPayloadSizes[0] +
                                     rtp_header_len + kRtxHeaderSize))
       .WillOnce(testing::ReturnArg<2>());
-  EXPECT_EQ(kPayloadSizes[0], rtp_sender_->TimeToSendPadding(500));
+  EXPECT_EQ(kPayloadSizes[0],
+            rtp_sender_->TimeToSendPadding(500, PacedSender::kNotAProbe));
 
   EXPECT_CALL(transport, SendPacket(_, _, kPayloadSizes[kNumPayloadSizes - 1] +
                                     rtp_header_len + kRtxHeaderSize))
@@ -880,7 +997,7 @@ TEST_F(RtpSenderTest, SendRedundantPayloads) {
   EXPECT_CALL(transport, SendPacket(_, _, kMaxPaddingSize + rtp_header_len))
       .WillOnce(testing::ReturnArg<2>());
   EXPECT_EQ(kPayloadSizes[kNumPayloadSizes - 1] + kMaxPaddingSize,
-            rtp_sender_->TimeToSendPadding(999));
+            rtp_sender_->TimeToSendPadding(999, PacedSender::kNotAProbe));
 }
 
 TEST_F(RtpSenderTest, SendGenericVideo) {
@@ -956,7 +1073,8 @@ TEST_F(RtpSenderTest, FrameCountCallbacks) {
   } callback;
 
   rtp_sender_.reset(new RTPSender(0, false, &fake_clock_, &transport_, NULL,
-                                  &mock_paced_sender_, NULL, &callback, NULL));
+                                  &mock_paced_sender_, NULL, &callback, NULL,
+                                  NULL, NULL));
 
   char payload_name[RTP_PAYLOAD_NAME_SIZE] = "GENERIC";
   const uint8_t payload_type = 127;
@@ -1008,7 +1126,8 @@ TEST_F(RtpSenderTest, BitrateCallbacks) {
     BitrateStatistics retransmit_stats_;
   } callback;
   rtp_sender_.reset(new RTPSender(0, false, &fake_clock_, &transport_, NULL,
-                                  &mock_paced_sender_, &callback, NULL, NULL));
+                                  &mock_paced_sender_, &callback, NULL, NULL,
+                                  NULL, NULL));
 
   // Simulate kNumPackets sent with kPacketInterval ms intervals.
   const uint32_t kNumPackets = 15;
@@ -1066,7 +1185,8 @@ class RtpSenderAudioTest : public RtpSenderTest {
   void SetUp() override {
     payload_ = kAudioPayload;
     rtp_sender_.reset(new RTPSender(0, true, &fake_clock_, &transport_, NULL,
-                                    &mock_paced_sender_, NULL, NULL, NULL));
+                                    &mock_paced_sender_, NULL, NULL, NULL,
+                                    NULL, NULL));
     rtp_sender_->SetSequenceNumber(kSeqNum);
   }
 };
@@ -1145,7 +1265,7 @@ TEST_F(RtpSenderTest, StreamDataCountersCallbacks) {
   callback.Matches(ssrc, expected);
 
   // Send padding.
-  rtp_sender_->TimeToSendPadding(kMaxPaddingSize);
+  rtp_sender_->TimeToSendPadding(kMaxPaddingSize, PacedSender::kNotAProbe);
   expected.transmitted.payload_bytes = 12;
   expected.transmitted.header_bytes = 36;
   expected.transmitted.padding_bytes = kMaxPaddingSize;
@@ -1313,8 +1433,8 @@ TEST_F(RtpSenderTest, BytesReportedCorrectly) {
                                           0));
 
   // Will send 2 full-size padding packets.
-  rtp_sender_->TimeToSendPadding(1);
-  rtp_sender_->TimeToSendPadding(1);
+  rtp_sender_->TimeToSendPadding(1, PacedSender::kNotAProbe);
+  rtp_sender_->TimeToSendPadding(1, PacedSender::kNotAProbe);
 
   StreamDataCounters rtp_stats;
   StreamDataCounters rtx_stats;
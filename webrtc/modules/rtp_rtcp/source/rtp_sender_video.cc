@@ -92,15 +92,18 @@ RtpUtility::Payload* RTPSenderVideo::CreateVideoPayload(
   return payload;
 }
 
-void RTPSenderVideo::SendVideoPacket(uint8_t* data_buffer,
-                                     const size_t payload_length,
-                                     const size_t rtp_header_length,
-                                     uint16_t seq_num,
-                                     const uint32_t capture_timestamp,
-                                     int64_t capture_time_ms,
-                                     StorageType storage) {
-  if (_rtpSender.SendToNetwork(data_buffer, payload_length, rtp_header_length,
-                               capture_time_ms, storage,
+void RTPSenderVideo::SendVideoPacket(
+    const rtc::scoped_refptr<RtpPacketBatch>& batch,
+    size_t offset,
+    const size_t payload_length,
+    const size_t rtp_header_length,
+    const uint32_t capture_timestamp,
+    int64_t capture_time_ms,
+    StorageType storage) {
+  const uint16_t seq_num =
+      ByteReader<uint16_t>::ReadBigEndian(&(*batch)[offset + 2]);
+  if (_rtpSender.SendToNetwork(batch, offset, payload_length,
+                               rtp_header_length, capture_time_ms, storage,
                                PacedSender::kNormalPriority) == 0) {
     _videoBitrate.Update(payload_length + rtp_header_length);
     TRACE_EVENT_INSTANT2(TRACE_DISABLED_BY_DEFAULT("webrtc_rtp"),
@@ -252,8 +255,9 @@ int32_t RTPSenderVideo::SendVideo(const RtpVideoCodecTypes videoType,
     return -1;
   }
 
+  const size_t max_payload_length = _rtpSender.MaxDataPayloadLength();
   rtc::scoped_ptr<RtpPacketizer> packetizer(
-      RtpPacketizer::Create(videoType, _rtpSender.MaxDataPayloadLength(),
+      RtpPacketizer::Create(videoType, max_payload_length,
                             &(rtpHdr->codecHeader), frameType));
 
   StorageType storage = kDontStore;
@@ -286,9 +290,36 @@ int32_t RTPSenderVideo::SendVideo(const RtpVideoCodecTypes videoType,
 
   packetizer->SetPayloadData(data, payload_bytes_to_send, frag);
 
+  // Without FEC the whole frame is packetized into one batch before any
+  // packet is sent, and the packet history keeps references into the batch
+  // rather than copies. RED packets are copies anyway, so with FEC every
+  // packet is built on the stack and sent right away.
+  const size_t max_packet_length = rtp_header_length + max_payload_length;
+  rtc::scoped_refptr<RtpPacketBatch> batch;
+  std::vector<size_t> packet_offsets;
+  std::vector<size_t> packet_payload_lengths;
+  if (!fec_enabled) {
+    // Leave room for the payload headers, so that the batch rarely has to
+    // grow.
+    size_t num_packets = (payloadSize + payloadSize / 16) / max_payload_length +
+                         (frag ? frag->fragmentationVectorSize : 0) + 2;
+    batch = new RtpPacketBatch();
+    batch->reserve(num_packets * max_packet_length);
+    packet_offsets.reserve(num_packets);
+    packet_payload_lengths.reserve(num_packets);
+  }
+
   bool last = false;
   while (!last) {
-    uint8_t dataBuffer[IP_PACKET_SIZE] = {0};
+    uint8_t stack_buffer[IP_PACKET_SIZE];
+    uint8_t* dataBuffer = stack_buffer;
+    if (batch) {
+      packet_offsets.push_back(batch->size());
+      batch->resize(batch->size() + max_packet_length);
+      dataBuffer = &(*batch)[packet_offsets.back()];
+    } else {
+      memset(stack_buffer, 0, sizeof(stack_buffer));
+    }
     size_t payload_bytes_in_packet = 0;
     if (!packetizer->NextPacket(&dataBuffer[rtp_header_length],
                                 &payload_bytes_in_packet, &last)) {
@@ -325,17 +356,24 @@ int32_t RTPSenderVideo::SendVideo(const RtpVideoCodecTypes videoType,
       _rtpSender.UpdateVideoRotation(dataBuffer, packetSize, rtp_header,
                                      rtpHdr->rotation);
     }
-    if (fec_enabled) {
+    if (batch) {
+      batch->resize(packet_offsets.back() + rtp_header_length +
+                    payload_bytes_in_packet);
+      packet_payload_lengths.push_back(payload_bytes_in_packet);
+    } else {
       SendVideoPacketAsRed(dataBuffer, payload_bytes_in_packet,
                            rtp_header_length, _rtpSender.SequenceNumber(),
                            captureTimeStamp, capture_time_ms, storage,
                            packetizer->GetProtectionType() == kProtectedPacket);
-    } else {
-      SendVideoPacket(dataBuffer, payload_bytes_in_packet, rtp_header_length,
-                      _rtpSender.SequenceNumber(), captureTimeStamp,
-                      capture_time_ms, storage);
     }
   }
+  // The batch is complete and isn't resized anymore, so the history can
+  // share it.
+  for (size_t i = 0; i < packet_offsets.size(); ++i) {
+    SendVideoPacket(batch, packet_offsets[i], packet_payload_lengths[i],
+                    rtp_header_length, captureTimeStamp, capture_time_ms,
+                    storage);
+  }
 
   TRACE_EVENT_ASYNC_END1(
       "webrtc", "Video", capture_time_ms, "timestamp", _rtpSender.Timestamp());
@@ -83,10 +83,10 @@ class RTPSenderVideo {
   void SetSelectiveRetransmissions(uint8_t settings);
 
 private:
-  void SendVideoPacket(uint8_t* dataBuffer,
+  void SendVideoPacket(const rtc::scoped_refptr<RtpPacketBatch>& batch,
+                       size_t offset,
                        const size_t payloadLength,
                        const size_t rtpHeaderLength,
-                       uint16_t seq_num,
                        const uint32_t capture_timestamp,
                        int64_t capture_time_ms,
                        StorageType storage);
@@ -248,6 +248,19 @@ bool RtpHeaderParser::ParseRtcp(RTPHeader* header) const {
 
 bool RtpHeaderParser::Parse(RTPHeader& header,
                             RtpHeaderExtensionMap* ptrExtensionMap) const {
+  return Parse(header, ptrExtensionMap, NULL);
+}
+
+bool RtpHeaderParser::Parse(
+    RTPHeader& header,
+    const RtpHeaderExtensionSnapshot& extensions) const {
+  return Parse(header, NULL, &extensions);
+}
+
+bool RtpHeaderParser::Parse(
+    RTPHeader& header,
+    const RtpHeaderExtensionMap* ptrExtensionMap,
+    const RtpHeaderExtensionSnapshot* extensions) const {
   const ptrdiff_t length = _ptrRTPDataEnd - _ptrRTPDataBegin;
   if (length < kRtpMinParseLength) {
     return false;
@@ -348,10 +361,14 @@ bool RtpHeaderParser::Parse(RTPHeader& header,
     }
     if (definedByProfile == kRtpOneByteHeaderExtensionId) {
       const uint8_t* ptrRTPDataExtensionEnd = ptr + XLen;
-      ParseOneByteExtensionHeader(header,
-                                  ptrExtensionMap,
-                                  ptrRTPDataExtensionEnd,
-                                  ptr);
+      if (extensions) {
+        ParseOneByteExtensionHeader(header, *extensions,
+                                    ptrRTPDataExtensionEnd, ptr);
+      } else if (ptrExtensionMap) {
+        ParseOneByteExtensionHeader(
+            header, RtpHeaderExtensionSnapshot(*ptrExtensionMap),
+            ptrRTPDataExtensionEnd, ptr);
+      }
     }
     header.headerLength += XLen;
   }
@@ -362,13 +379,9 @@ bool RtpHeaderParser::Parse(RTPHeader& header,
 
 void RtpHeaderParser::ParseOneByteExtensionHeader(
     RTPHeader& header,
-    const RtpHeaderExtensionMap* ptrExtensionMap,
+    const RtpHeaderExtensionSnapshot& extensions,
     const uint8_t* ptrRTPDataExtensionEnd,
     const uint8_t* ptr) const {
-  if (!ptrExtensionMap) {
-    return;
-  }
-
   while (ptrRTPDataExtensionEnd - ptr > 0) {
     //  0
     //  0 1 2 3 4 5 6 7
@@ -388,8 +401,8 @@ void RtpHeaderParser::ParseOneByteExtensionHeader(
       return;
     }
 
-    RTPExtensionType type;
-    if (ptrExtensionMap->GetType(id, &type) != 0) {
+    const RTPExtensionType type = extensions.GetType(id);
+    if (type == kRtpExtensionNone) {
       // If we encounter an unknown extension, just skip over it.
       LOG(LS_WARNING) << "Failed to find extension id: "
                       << static_cast<int>(id);
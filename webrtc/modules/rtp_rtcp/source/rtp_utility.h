@@ -78,11 +78,19 @@ namespace RtpUtility {
         bool ParseRtcp(RTPHeader* header) const;
         bool Parse(RTPHeader& parsedPacket,
                    RtpHeaderExtensionMap* ptrExtensionMap = NULL) const;
+        // As above, but looks up the header extensions in |extensions|,
+        // which is much cheaper than looking them up in a map.
+        bool Parse(RTPHeader& parsedPacket,
+                   const RtpHeaderExtensionSnapshot& extensions) const;
 
     private:
+        bool Parse(RTPHeader& parsedPacket,
+                   const RtpHeaderExtensionMap* ptrExtensionMap,
+                   const RtpHeaderExtensionSnapshot* extensions) const;
+
         void ParseOneByteExtensionHeader(
             RTPHeader& parsedPacket,
-            const RtpHeaderExtensionMap* ptrExtensionMap,
+            const RtpHeaderExtensionSnapshot& extensions,
             const uint8_t* ptrRTPDataExtensionEnd,
             const uint8_t* ptr) const;
 
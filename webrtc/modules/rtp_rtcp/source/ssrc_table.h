@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_SSRC_TABLE_H_
+#define WEBRTC_MODULES_RTP_RTCP_SOURCE_SSRC_TABLE_H_
+
+#include <stddef.h>
+
+#include <utility>
+#include <vector>
+
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Hash table mapping SSRCs (or other integer keys) to values stored inline in
+// one flat array, using open addressing with linear probing. Compared to a
+// std::map of heap-allocated values, lookups touch a single cache line or two
+// and no memory is allocated per SSRC, which matters when hundreds of SSRCs
+// are reported on by every incoming compound RTCP packet.
+//
+// Pointers to values are invalidated by FindOrInsert(), Erase() and EraseIf().
+// Iteration order is unspecified.
+template <typename Value, typename Key = uint32_t>
+class SsrcTable {
+ public:
+  SsrcTable() : size_(0), capacity_bits_(0) {}
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  Value* Find(Key key) {
+    return const_cast<Value*>(static_cast<const SsrcTable*>(this)->Find(key));
+  }
+  const Value* Find(Key key) const {
+    if (size_ == 0)
+      return nullptr;
+    for (size_t i = Index(key);; i = Next(i)) {
+      if (!slots_[i].used)
+        return nullptr;
+      if (slots_[i].key == key)
+        return &slots_[i].value;
+    }
+  }
+
+  // Returns the value of |key|, value-initialized if it wasn't in the table.
+  Value* FindOrInsert(Key key) {
+    Value* value = Find(key);
+    if (value)
+      return value;
+    // Keep the load factor at most 1/2 so that probe sequences stay short.
+    if (2 * (size_ + 1) > slots_.size())
+      Rehash(slots_.empty() ? kInitialCapacityBits : capacity_bits_ + 1);
+    size_t i = Index(key);
+    while (slots_[i].used)
+      i = Next(i);
+    slots_[i].used = true;
+    slots_[i].key = key;
+    ++size_;
+    return &slots_[i].value;
+  }
+
+  // Returns true if |key| was in the table.
+  bool Erase(Key key) {
+    if (size_ == 0)
+      return false;
+    size_t i = Index(key);
+    while (slots_[i].used && slots_[i].key != key)
+      i = Next(i);
+    if (!slots_[i].used)
+      return false;
+    // Shift following entries of the probe sequence back into the hole, so
+    // that lookups never need tombstones.
+    for (size_t j = Next(i); slots_[j].used; j = Next(j)) {
+      const size_t home = Index(slots_[j].key);
+      // Entry |j| may move to |i| unless its home slot lies cyclically in
+      // (i, j].
+      const bool home_after_hole =
+          (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+      if (!home_after_hole) {
+        slots_[i] = std::move(slots_[j]);
+        i = j;
+      }
+    }
+    slots_[i] = Slot();
+    --size_;
+    return true;
+  }
+
+  // Erases every entry for which |predicate(key, &value)| returns true, with
+  // a single pass over the table. The predicate may modify the values it keeps.
+  template <typename Predicate>
+  size_t EraseIf(Predicate predicate) {
+    size_t num_erased = 0;
+    for (Slot& slot : slots_) {
+      if (slot.used && predicate(slot.key, &slot.value)) {
+        slot = Slot();
+        ++num_erased;
+      }
+    }
+    if (num_erased > 0) {
+      size_ -= num_erased;
+      // Removed entries may have broken probe sequences, reinsert the rest.
+      Rehash(capacity_bits_);
+    }
+    return num_erased;
+  }
+
+  // Calls |function(key, &value)| for every entry.
+  template <typename Function>
+  void ForEach(Function function) {
+    for (Slot& slot : slots_) {
+      if (slot.used)
+        function(slot.key, &slot.value);
+    }
+  }
+  template <typename Function>
+  void ForEach(Function function) const {
+    for (const Slot& slot : slots_) {
+      if (slot.used)
+        function(slot.key, &slot.value);
+    }
+  }
+
+  void Clear() {
+    slots_.clear();
+    size_ = 0;
+    capacity_bits_ = 0;
+  }
+
+ private:
+  static const int kInitialCapacityBits = 3;
+
+  struct Slot {
+    Slot() : used(false), key(0), value() {}
+
+    bool used;
+    Key key;
+    Value value;
+  };
+
+  // Fibonacci hashing; SSRCs are random but other keys may not be.
+  size_t Index(Key key) const {
+    return static_cast<size_t>((static_cast<uint64_t>(key) *
+                                0x9E3779B97F4A7C15ULL) >>
+                               (64 - capacity_bits_));
+  }
+  size_t Next(size_t i) const { return (i + 1) & (slots_.size() - 1); }
+
+  void Rehash(int capacity_bits) {
+    std::vector<Slot> old_slots(static_cast<size_t>(1) << capacity_bits);
+    old_slots.swap(slots_);
+    capacity_bits_ = capacity_bits;
+    for (Slot& old_slot : old_slots) {
+      if (!old_slot.used)
+        continue;
+      size_t i = Index(old_slot.key);
+      while (slots_[i].used)
+        i = Next(i);
+      slots_[i] = std::move(old_slot);
+    }
+  }
+
+  std::vector<Slot> slots_;
+  size_t size_;
+  int capacity_bits_;
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_SSRC_TABLE_H_
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/ssrc_table.h"
+
+#include <map>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace webrtc {
+
+TEST(SsrcTableTest, FindOrInsertValueInitializes) {
+  SsrcTable<int> table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(nullptr, table.Find(1234));
+
+  int* value = table.FindOrInsert(1234);
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(0, *value);
+  *value = 17;
+  EXPECT_EQ(1u, table.size());
+  EXPECT_EQ(value, table.FindOrInsert(1234));
+  EXPECT_EQ(17, *table.Find(1234));
+  EXPECT_EQ(1u, table.size());
+}
+
+TEST(SsrcTableTest, KeepsEntriesWhenGrowing) {
+  SsrcTable<uint32_t> table;
+  for (uint32_t ssrc = 0; ssrc < 1000; ++ssrc)
+    *table.FindOrInsert(ssrc) = ssrc + 1;
+  EXPECT_EQ(1000u, table.size());
+  for (uint32_t ssrc = 0; ssrc < 1000; ++ssrc) {
+    ASSERT_NE(nullptr, table.Find(ssrc));
+    EXPECT_EQ(ssrc + 1, *table.Find(ssrc));
+  }
+  EXPECT_EQ(nullptr, table.Find(1000));
+}
+
+TEST(SsrcTableTest, Erase) {
+  SsrcTable<int> table;
+  *table.FindOrInsert(1) = 1;
+  *table.FindOrInsert(2) = 2;
+  EXPECT_FALSE(table.Erase(3));
+  EXPECT_TRUE(table.Erase(1));
+  EXPECT_FALSE(table.Erase(1));
+  EXPECT_EQ(nullptr, table.Find(1));
+  EXPECT_EQ(2, *table.Find(2));
+  EXPECT_EQ(1u, table.size());
+}
+
+// Compares against std::map while erasing random keys, which exercises the
+// backward shifting of colliding entries.
+TEST(SsrcTableTest, MatchesMapUnderRandomInsertAndErase) {
+  SsrcTable<uint32_t> table;
+  std::map<uint32_t, uint32_t> reference;
+  uint32_t random = 0x1234;
+  for (int i = 0; i < 10000; ++i) {
+    random = random * 1664525 + 1013904223;
+    // Few distinct keys, so that inserts and erases hit the same entries.
+    const uint32_t ssrc = (random >> 26) * 0x10001;
+    if ((random >> 8) % 3 == 0) {
+      EXPECT_EQ(reference.erase(ssrc) > 0, table.Erase(ssrc));
+    } else {
+      *table.FindOrInsert(ssrc) = i;
+      reference[ssrc] = i;
+    }
+    ASSERT_EQ(reference.size(), table.size());
+  }
+  for (uint32_t key = 0; key < 64; ++key) {
+    const uint32_t ssrc = key * 0x10001;
+    auto it = reference.find(ssrc);
+    if (it == reference.end()) {
+      EXPECT_EQ(nullptr, table.Find(ssrc));
+    } else {
+      ASSERT_NE(nullptr, table.Find(ssrc));
+      EXPECT_EQ(it->second, *table.Find(ssrc));
+    }
+  }
+}
+
+TEST(SsrcTableTest, EraseIfKeepsModifiedValues) {
+  SsrcTable<int, uint64_t> table;
+  for (uint64_t key = 0; key < 100; ++key)
+    *table.FindOrInsert(key << 32 | key) = static_cast<int>(key);
+
+  EXPECT_EQ(50u, table.EraseIf([](uint64_t key, int* value) {
+    ++*value;
+    return key % 2 == 0;
+  }));
+  EXPECT_EQ(50u, table.size());
+  for (uint64_t key = 0; key < 100; ++key) {
+    const int* value = table.Find(key << 32 | key);
+    if (key % 2 == 0) {
+      EXPECT_EQ(nullptr, value);
+    } else {
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(static_cast<int>(key) + 1, *value);
+    }
+  }
+}
+
+TEST(SsrcTableTest, ForEachVisitsEveryEntryOnce) {
+  SsrcTable<int> table;
+  for (uint32_t ssrc = 1; ssrc <= 20; ++ssrc)
+    *table.FindOrInsert(ssrc * 0x9E3779B9u) = 1;
+  int visits = 0;
+  const SsrcTable<int>& const_table = table;
+  const_table.ForEach([&visits](uint32_t ssrc, const int* value) {
+    visits += *value;
+  });
+  EXPECT_EQ(20, visits);
+
+  table.Clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(nullptr, table.Find(0x9E3779B9u));
+}
+
+}  // namespace webrtc
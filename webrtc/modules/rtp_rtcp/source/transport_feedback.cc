@@ -0,0 +1,408 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+
+#include <limits>
+
+#include "webrtc/base/checks.h"
+#include "webrtc/modules/rtp_rtcp/source/byte_io.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_utility.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+
+namespace webrtc {
+namespace rtcp {
+namespace {
+
+const uint8_t kFeedbackMessageType = 15;
+const size_t kHeaderSizeBytes = 20;
+const size_t kChunkSizeBytes = 2;
+const uint16_t kMaxStatusCount = 0xffff;
+
+int64_t FloorDiv(int64_t dividend, int64_t divisor) {
+  int64_t quotient = dividend / divisor;
+  if (dividend % divisor < 0)
+    --quotient;
+  return quotient;
+}
+
+size_t DeltaSize(TransportFeedback::StatusSymbol symbol) {
+  switch (symbol) {
+    case TransportFeedback::StatusSymbol::kNotReceived:
+      return 0;
+    case TransportFeedback::StatusSymbol::kReceivedSmallDelta:
+      return 1;
+    case TransportFeedback::StatusSymbol::kReceivedLargeDelta:
+      return 2;
+  }
+  RTC_NOTREACHED();
+  return 0;
+}
+
+}  // namespace
+
+const int64_t TransportFeedback::kDeltaScaleFactor;
+const int64_t TransportFeedback::kBaseScaleFactor;
+const size_t TransportFeedback::kMaxSizeBytes;
+const size_t TransportFeedback::LastChunk::kMaxRunLength;
+const size_t TransportFeedback::LastChunk::kMaxOneBitCapacity;
+const size_t TransportFeedback::LastChunk::kMaxTwoBitCapacity;
+
+// Packet chunks:
+//
+// Run length chunk, |length| packets with status |S|:
+//    0                   1
+//    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |0| S |       Run Length        |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// Status vector chunk, 14 one bit symbols (s=0) or 7 two bit symbols (s=1):
+//    0                   1
+//    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |1|s|       symbol list         |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// A one bit symbol is 1 for a packet received with a small delta, and 0 for a
+// packet not received. Two bit symbols are the values of StatusSymbol.
+TransportFeedback::LastChunk::LastChunk()
+    : size_(0), all_same_(true), has_large_delta_(false) {
+}
+
+bool TransportFeedback::LastChunk::CanAdd(StatusSymbol symbol) const {
+  if (size_ < kMaxTwoBitCapacity)
+    return true;
+  if (size_ < kMaxOneBitCapacity && !has_large_delta_ &&
+      symbol != StatusSymbol::kReceivedLargeDelta) {
+    return true;
+  }
+  return size_ < kMaxRunLength && all_same_ && symbols_[0] == symbol;
+}
+
+void TransportFeedback::LastChunk::Add(StatusSymbol symbol) {
+  DCHECK(CanAdd(symbol));
+  if (size_ < kMaxOneBitCapacity)
+    symbols_[size_] = symbol;
+  all_same_ = all_same_ && (size_ == 0 || symbols_[0] == symbol);
+  has_large_delta_ =
+      has_large_delta_ || symbol == StatusSymbol::kReceivedLargeDelta;
+  ++size_;
+}
+
+uint16_t TransportFeedback::LastChunk::Emit() {
+  DCHECK(!empty());
+  if (all_same_) {
+    const uint16_t chunk = EncodeRunLength();
+    size_ = 0;
+    all_same_ = true;
+    has_large_delta_ = false;
+    return chunk;
+  }
+  if (size_ == kMaxOneBitCapacity) {
+    const uint16_t chunk = EncodeOneBit();
+    size_ = 0;
+    all_same_ = true;
+    has_large_delta_ = false;
+    return chunk;
+  }
+  // Only the oldest symbols fit in a two bit vector; keep the others pending.
+  DCHECK_GE(size_, kMaxTwoBitCapacity);
+  const uint16_t chunk = EncodeTwoBit(kMaxTwoBitCapacity);
+  const size_t remaining = size_ - kMaxTwoBitCapacity;
+  size_ = 0;
+  all_same_ = true;
+  has_large_delta_ = false;
+  for (size_t i = 0; i < remaining; ++i)
+    Add(symbols_[kMaxTwoBitCapacity + i]);
+  return chunk;
+}
+
+uint16_t TransportFeedback::LastChunk::EncodeLast() const {
+  DCHECK(!empty());
+  if (all_same_)
+    return EncodeRunLength();
+  if (size_ <= kMaxTwoBitCapacity)
+    return EncodeTwoBit(size_);
+  return EncodeOneBit();
+}
+
+uint16_t TransportFeedback::LastChunk::EncodeRunLength() const {
+  DCHECK(all_same_);
+  DCHECK_LE(size_, kMaxRunLength);
+  return (static_cast<uint16_t>(symbols_[0]) << 13) |
+         static_cast<uint16_t>(size_);
+}
+
+uint16_t TransportFeedback::LastChunk::EncodeOneBit() const {
+  DCHECK(!has_large_delta_);
+  DCHECK_LE(size_, kMaxOneBitCapacity);
+  uint16_t chunk = 0x8000;
+  for (size_t i = 0; i < size_; ++i) {
+    if (symbols_[i] == StatusSymbol::kReceivedSmallDelta)
+      chunk |= 1 << (kMaxOneBitCapacity - 1 - i);
+  }
+  return chunk;
+}
+
+uint16_t TransportFeedback::LastChunk::EncodeTwoBit(size_t size) const {
+  DCHECK_LE(size, size_);
+  DCHECK_LE(size, kMaxTwoBitCapacity);
+  uint16_t chunk = 0xc000;
+  for (size_t i = 0; i < size; ++i) {
+    chunk |= static_cast<uint16_t>(symbols_[i])
+             << (2 * (kMaxTwoBitCapacity - 1 - i));
+  }
+  return chunk;
+}
+
+TransportFeedback::TransportFeedback()
+    : packet_sender_ssrc_(0),
+      media_source_ssrc_(0),
+      base_sequence_(0),
+      base_time_(0),
+      feedback_sequence_(0),
+      last_timestamp_(0),
+      delta_bytes_(0) {
+}
+
+TransportFeedback::~TransportFeedback() {
+}
+
+void TransportFeedback::WithBase(uint16_t base_sequence,
+                                 int64_t ref_timestamp_us) {
+  DCHECK(symbols_.empty());
+  base_sequence_ = base_sequence;
+  base_time_ = FloorDiv(ref_timestamp_us, kBaseScaleFactor);
+  last_timestamp_ = base_time_ * (kBaseScaleFactor / kDeltaScaleFactor);
+}
+
+bool TransportFeedback::WithReceivedPacket(uint16_t sequence_number,
+                                           int64_t timestamp_us) {
+  const uint16_t next_sequence =
+      static_cast<uint16_t>(base_sequence_ + symbols_.size());
+  const uint16_t skipped = sequence_number - next_sequence;
+  if (skipped >= 0x8000 ||
+      symbols_.size() + skipped + 1 > kMaxStatusCount) {
+    return false;
+  }
+  const int64_t timestamp = FloorDiv(timestamp_us, kDeltaScaleFactor);
+  const int64_t delta = timestamp - last_timestamp_;
+  if (delta < std::numeric_limits<int16_t>::min() ||
+      delta > std::numeric_limits<int16_t>::max()) {
+    return false;
+  }
+  const StatusSymbol symbol = (delta >= 0 && delta <= 0xff)
+                                  ? StatusSymbol::kReceivedSmallDelta
+                                  : StatusSymbol::kReceivedLargeDelta;
+
+  const size_t num_symbols = symbols_.size();
+  const size_t num_chunks = encoded_chunks_.size();
+  const LastChunk last_chunk = last_chunk_;
+  for (uint16_t i = 0; i < skipped; ++i)
+    AddSymbol(StatusSymbol::kNotReceived);
+  AddSymbol(symbol);
+  delta_bytes_ += DeltaSize(symbol);
+  if (BlockLength() > kMaxSizeBytes) {
+    symbols_.resize(num_symbols);
+    encoded_chunks_.resize(num_chunks);
+    last_chunk_ = last_chunk;
+    delta_bytes_ -= DeltaSize(symbol);
+    return false;
+  }
+  receive_deltas_.push_back(static_cast<int16_t>(delta));
+  last_timestamp_ = timestamp;
+  return true;
+}
+
+std::vector<int64_t> TransportFeedback::GetReceiveDeltasUs() const {
+  std::vector<int64_t> deltas_us;
+  deltas_us.reserve(receive_deltas_.size());
+  for (int16_t delta : receive_deltas_)
+    deltas_us.push_back(delta * kDeltaScaleFactor);
+  return deltas_us;
+}
+
+void TransportFeedback::AddSymbol(StatusSymbol symbol) {
+  if (!last_chunk_.CanAdd(symbol))
+    encoded_chunks_.push_back(last_chunk_.Emit());
+  last_chunk_.Add(symbol);
+  symbols_.push_back(symbol);
+}
+
+size_t TransportFeedback::BlockLength() const {
+  size_t num_chunks = encoded_chunks_.size();
+  if (!last_chunk_.empty())
+    ++num_chunks;
+  const size_t length =
+      kHeaderSizeBytes + num_chunks * kChunkSizeBytes + delta_bytes_;
+  // Padded to a multiple of 32 bits.
+  return (length + 3) & ~static_cast<size_t>(3);
+}
+
+bool TransportFeedback::Create(
+    uint8_t* packet,
+    size_t* index,
+    size_t max_length,
+    RtcpPacket::PacketReadyCallback* callback) const {
+  DCHECK(!symbols_.empty());
+  while (*index + BlockLength() > max_length) {
+    if (!OnBufferFull(packet, index, callback))
+      return false;
+  }
+  const size_t end = *index + BlockLength();
+
+  packet[(*index)++] = 0x80 | kFeedbackMessageType;
+  packet[(*index)++] = RTCPUtility::PT_RTPFB;
+  ByteWriter<uint16_t>::WriteBigEndian(&packet[*index],
+                                       BlockLength() / 4 - 1);
+  *index += 2;
+  ByteWriter<uint32_t>::WriteBigEndian(&packet[*index], packet_sender_ssrc_);
+  *index += 4;
+  ByteWriter<uint32_t>::WriteBigEndian(&packet[*index], media_source_ssrc_);
+  *index += 4;
+  ByteWriter<uint16_t>::WriteBigEndian(&packet[*index], base_sequence_);
+  *index += 2;
+  ByteWriter<uint16_t>::WriteBigEndian(&packet[*index],
+                                       static_cast<uint16_t>(symbols_.size()));
+  *index += 2;
+  ByteWriter<int32_t, 3>::WriteBigEndian(&packet[*index],
+                                         static_cast<int32_t>(base_time_));
+  *index += 3;
+  packet[(*index)++] = feedback_sequence_;
+
+  for (uint16_t chunk : encoded_chunks_) {
+    ByteWriter<uint16_t>::WriteBigEndian(&packet[*index], chunk);
+    *index += 2;
+  }
+  if (!last_chunk_.empty()) {
+    ByteWriter<uint16_t>::WriteBigEndian(&packet[*index],
+                                         last_chunk_.EncodeLast());
+    *index += 2;
+  }
+
+  std::vector<int16_t>::const_iterator delta = receive_deltas_.begin();
+  for (StatusSymbol symbol : symbols_) {
+    switch (symbol) {
+      case StatusSymbol::kNotReceived:
+        break;
+      case StatusSymbol::kReceivedSmallDelta:
+        packet[(*index)++] = static_cast<uint8_t>(*delta++);
+        break;
+      case StatusSymbol::kReceivedLargeDelta:
+        ByteWriter<int16_t>::WriteBigEndian(&packet[*index], *delta++);
+        *index += 2;
+        break;
+    }
+  }
+
+  while (*index < end)
+    packet[(*index)++] = 0;
+  return true;
+}
+
+rtc::scoped_ptr<TransportFeedback> TransportFeedback::ParseFrom(
+    const uint8_t* buffer,
+    size_t length) {
+  rtc::scoped_ptr<TransportFeedback> packet(new TransportFeedback());
+
+  RTCPUtility::RTCPCommonHeader header;
+  if (!RTCPUtility::RTCPParseCommonHeader(buffer, buffer + length, header))
+    return nullptr;
+  if (header.PT != RTCPUtility::PT_RTPFB ||
+      header.IC != kFeedbackMessageType) {
+    LOG(LS_WARNING) << "Not a transport feedback packet.";
+    return nullptr;
+  }
+  const size_t packet_length = header.LengthInOctets;
+  if (packet_length < kHeaderSizeBytes || packet_length > length) {
+    LOG(LS_WARNING) << "Invalid transport feedback packet length: "
+                    << packet_length;
+    return nullptr;
+  }
+
+  packet->packet_sender_ssrc_ = ByteReader<uint32_t>::ReadBigEndian(&buffer[4]);
+  packet->media_source_ssrc_ = ByteReader<uint32_t>::ReadBigEndian(&buffer[8]);
+  const uint16_t base_sequence =
+      ByteReader<uint16_t>::ReadBigEndian(&buffer[12]);
+  const size_t status_count = ByteReader<uint16_t>::ReadBigEndian(&buffer[14]);
+  const int64_t base_time_us =
+      ByteReader<int32_t, 3>::ReadBigEndian(&buffer[16]) * kBaseScaleFactor;
+  packet->WithBase(base_sequence, base_time_us);
+  packet->feedback_sequence_ = buffer[19];
+  if (status_count == 0) {
+    LOG(LS_WARNING) << "Empty transport feedback packet.";
+    return nullptr;
+  }
+
+  size_t index = kHeaderSizeBytes;
+  std::vector<StatusSymbol> symbols;
+  symbols.reserve(status_count);
+  while (symbols.size() < status_count) {
+    if (index + kChunkSizeBytes > packet_length) {
+      LOG(LS_WARNING) << "Transport feedback status chunks truncated.";
+      return nullptr;
+    }
+    const uint16_t chunk = ByteReader<uint16_t>::ReadBigEndian(&buffer[index]);
+    index += kChunkSizeBytes;
+    const size_t remaining = status_count - symbols.size();
+    if ((chunk & 0x8000) == 0) {
+      const uint8_t symbol = (chunk >> 13) & 0x3;
+      const size_t run_length = chunk & 0x1fff;
+      if (symbol > static_cast<uint8_t>(StatusSymbol::kReceivedLargeDelta) ||
+          run_length > remaining) {
+        LOG(LS_WARNING) << "Invalid transport feedback run length chunk.";
+        return nullptr;
+      }
+      symbols.insert(symbols.end(), run_length,
+                     static_cast<StatusSymbol>(symbol));
+    } else if ((chunk & 0x4000) == 0) {
+      for (int i = 13; i >= 0 && symbols.size() < status_count; --i) {
+        symbols.push_back((chunk >> i) & 0x1
+                              ? StatusSymbol::kReceivedSmallDelta
+                              : StatusSymbol::kNotReceived);
+      }
+    } else {
+      for (int i = 12; i >= 0 && symbols.size() < status_count; i -= 2) {
+        const uint8_t symbol = (chunk >> i) & 0x3;
+        if (symbol > static_cast<uint8_t>(StatusSymbol::kReceivedLargeDelta)) {
+          LOG(LS_WARNING) << "Invalid transport feedback status symbol.";
+          return nullptr;
+        }
+        symbols.push_back(static_cast<StatusSymbol>(symbol));
+      }
+    }
+  }
+
+  for (StatusSymbol symbol : symbols) {
+    const size_t delta_size = DeltaSize(symbol);
+    if (index + delta_size > packet_length) {
+      LOG(LS_WARNING) << "Transport feedback receive deltas truncated.";
+      return nullptr;
+    }
+    packet->AddSymbol(symbol);
+    if (delta_size == 0)
+      continue;
+    int16_t delta;
+    if (delta_size == 1) {
+      delta = buffer[index];
+    } else {
+      delta = ByteReader<int16_t>::ReadBigEndian(&buffer[index]);
+    }
+    index += delta_size;
+    packet->delta_bytes_ += delta_size;
+    packet->receive_deltas_.push_back(delta);
+    packet->last_timestamp_ += delta;
+  }
+  return packet;
+}
+
+}  // namespace rtcp
+}  // namespace webrtc
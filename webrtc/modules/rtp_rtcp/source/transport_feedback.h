@@ -0,0 +1,170 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_RTP_RTCP_SOURCE_TRANSPORT_FEEDBACK_H_
+#define WEBRTC_MODULES_RTP_RTCP_SOURCE_TRANSPORT_FEEDBACK_H_
+
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/modules/rtp_rtcp/source/rtcp_packet.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+namespace rtcp {
+
+// Transport-wide congestion control feedback
+// (draft-holmer-rmcat-transport-wide-cc-extensions-01). Reports which of a
+// range of transport-wide sequence numbers were received, and when.
+//
+//    0                   1                   2                   3
+//    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |V=2|P|  FMT=15 |    PT=205     |           length              |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |                     SSRC of packet sender                     |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |                      SSRC of media source                     |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |      base sequence number     |      packet status count      |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |                 reference time                | fb pkt. count |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |          packet chunk         |         packet chunk          |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   .                                                               .
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |         packet chunk          |  recv delta   |  recv delta   |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   .                                                               .
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//   |           recv delta          |  recv delta   | zero padding  |
+//   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+//
+// Packet chunks hold the status of each sequence number, either as a run
+// length or as a vector of one or two bit symbols. Each received packet has a
+// receive delta: one unsigned byte if small, two signed bytes otherwise.
+class TransportFeedback : public RtcpPacket {
+ public:
+  // Unit of the receive deltas.
+  static const int64_t kDeltaScaleFactor = 250;  // us.
+  // Unit of the reference time.
+  static const int64_t kBaseScaleFactor = kDeltaScaleFactor * (1 << 8);
+  // Largest packet built, to fit within a typical MTU together with SRTCP and
+  // transport overhead.
+  static const size_t kMaxSizeBytes = 1200;
+
+  enum class StatusSymbol {
+    kNotReceived,
+    kReceivedSmallDelta,
+    kReceivedLargeDelta,
+  };
+
+  TransportFeedback();
+  virtual ~TransportFeedback();
+
+  void WithPacketSenderSsrc(uint32_t ssrc) { packet_sender_ssrc_ = ssrc; }
+  void WithMediaSourceSsrc(uint32_t ssrc) { media_source_ssrc_ = ssrc; }
+  // Must be called once, before any call to WithReceivedPacket().
+  // |base_sequence| is the first sequence number reported, and
+  // |ref_timestamp_us| is rounded down to a multiple of kBaseScaleFactor to
+  // give the reference time the receive deltas start from.
+  void WithBase(uint16_t base_sequence, int64_t ref_timestamp_us);
+  void WithFeedbackSequenceNumber(uint8_t feedback_sequence) {
+    feedback_sequence_ = feedback_sequence;
+  }
+  // Sequence numbers must be added in increasing order; the ones skipped are
+  // reported as not received. Returns false, leaving the packet unchanged, if
+  // |sequence_number| is not newer than the last one added, if its receive
+  // delta cannot be represented, or if the packet would grow beyond
+  // kMaxSizeBytes.
+  bool WithReceivedPacket(uint16_t sequence_number, int64_t timestamp_us);
+
+  uint32_t GetPacketSenderSsrc() const { return packet_sender_ssrc_; }
+  uint32_t GetMediaSourceSsrc() const { return media_source_ssrc_; }
+  uint16_t GetBaseSequence() const { return base_sequence_; }
+  uint8_t GetFeedbackSequenceNumber() const { return feedback_sequence_; }
+  int64_t GetBaseTimeUs() const { return base_time_ * kBaseScaleFactor; }
+  // One symbol per sequence number, starting at the base sequence number.
+  const std::vector<StatusSymbol>& GetStatusVector() const {
+    return symbols_;
+  }
+  // One delta per received packet, in units of kDeltaScaleFactor. The first
+  // is relative to the reference time, the others to the previous packet.
+  const std::vector<int16_t>& GetReceiveDeltas() const {
+    return receive_deltas_;
+  }
+  std::vector<int64_t> GetReceiveDeltasUs() const;
+
+  // Returns NULL if |buffer| does not hold a valid transport feedback packet.
+  static rtc::scoped_ptr<TransportFeedback> ParseFrom(const uint8_t* buffer,
+                                                      size_t length);
+
+ protected:
+  bool Create(uint8_t* packet,
+              size_t* index,
+              size_t max_length,
+              RtcpPacket::PacketReadyCallback* callback) const override;
+
+ private:
+  // Status symbols which are not yet encoded into a packet chunk. Symbols are
+  // kept here until the next one could not join them in a single chunk.
+  class LastChunk {
+   public:
+    LastChunk();
+
+    bool empty() const { return size_ == 0; }
+    bool CanAdd(StatusSymbol symbol) const;
+    void Add(StatusSymbol symbol);
+    // Encodes as many of the oldest pending symbols as fit in one chunk, and
+    // removes them. Called once CanAdd() returns false.
+    uint16_t Emit();
+    // Encodes all pending symbols into one chunk, leaving them pending.
+    uint16_t EncodeLast() const;
+
+   private:
+    static const size_t kMaxRunLength = 0x1fff;
+    static const size_t kMaxOneBitCapacity = 14;
+    static const size_t kMaxTwoBitCapacity = 7;
+
+    uint16_t EncodeRunLength() const;
+    uint16_t EncodeOneBit() const;
+    uint16_t EncodeTwoBit(size_t size) const;
+
+    size_t size_;
+    bool all_same_;
+    bool has_large_delta_;
+    StatusSymbol symbols_[kMaxOneBitCapacity];
+  };
+
+  void AddSymbol(StatusSymbol symbol);
+  size_t BlockLength() const;
+
+  uint32_t packet_sender_ssrc_;
+  uint32_t media_source_ssrc_;
+  uint16_t base_sequence_;
+  // Reference time, in units of kBaseScaleFactor.
+  int64_t base_time_;
+  uint8_t feedback_sequence_;
+  // Receive time of the last packet added, in units of kDeltaScaleFactor.
+  int64_t last_timestamp_;
+  std::vector<StatusSymbol> symbols_;
+  std::vector<int16_t> receive_deltas_;
+  std::vector<uint16_t> encoded_chunks_;
+  LastChunk last_chunk_;
+  size_t delta_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(TransportFeedback);
+};
+
+}  // namespace rtcp
+}  // namespace webrtc
+#endif  // WEBRTC_MODULES_RTP_RTCP_SOURCE_TRANSPORT_FEEDBACK_H_
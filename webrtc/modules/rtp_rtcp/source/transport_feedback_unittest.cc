@@ -0,0 +1,227 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/rtp_rtcp/source/transport_feedback.h"
+
+namespace webrtc {
+namespace rtcp {
+namespace {
+
+typedef TransportFeedback::StatusSymbol StatusSymbol;
+
+const uint32_t kSenderSsrc = 0x12345678;
+const uint32_t kMediaSsrc = 0x23456789;
+const int64_t kDeltaUs = TransportFeedback::kDeltaScaleFactor;
+const int64_t kBaseTimeUs = 1000 * TransportFeedback::kBaseScaleFactor;
+
+rtc::scoped_ptr<TransportFeedback> BuildAndParse(
+    const TransportFeedback& feedback) {
+  rtc::scoped_ptr<RawPacket> raw_packet(feedback.Build());
+  EXPECT_EQ(0u, raw_packet->Length() % 4);
+  EXPECT_LE(raw_packet->Length(), TransportFeedback::kMaxSizeBytes);
+  return TransportFeedback::ParseFrom(raw_packet->Buffer(),
+                                      raw_packet->Length());
+}
+
+void VerifyEqual(const TransportFeedback& expected,
+                 const TransportFeedback& actual) {
+  EXPECT_EQ(expected.GetPacketSenderSsrc(), actual.GetPacketSenderSsrc());
+  EXPECT_EQ(expected.GetMediaSourceSsrc(), actual.GetMediaSourceSsrc());
+  EXPECT_EQ(expected.GetBaseSequence(), actual.GetBaseSequence());
+  EXPECT_EQ(expected.GetFeedbackSequenceNumber(),
+            actual.GetFeedbackSequenceNumber());
+  EXPECT_EQ(expected.GetBaseTimeUs(), actual.GetBaseTimeUs());
+  EXPECT_EQ(expected.GetStatusVector(), actual.GetStatusVector());
+  EXPECT_EQ(expected.GetReceiveDeltas(), actual.GetReceiveDeltas());
+}
+
+TEST(TransportFeedbackTest, BuildsAndParsesHeader) {
+  TransportFeedback feedback;
+  feedback.WithPacketSenderSsrc(kSenderSsrc);
+  feedback.WithMediaSourceSsrc(kMediaSsrc);
+  feedback.WithBase(1000, kBaseTimeUs + 1000);
+  feedback.WithFeedbackSequenceNumber(17);
+  EXPECT_TRUE(feedback.WithReceivedPacket(1000, kBaseTimeUs + 2000));
+  EXPECT_EQ(kBaseTimeUs, feedback.GetBaseTimeUs());
+
+  rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+  ASSERT_TRUE(parsed.get() != nullptr);
+  VerifyEqual(feedback, *parsed);
+  EXPECT_EQ(std::vector<int64_t>(1, 2000), parsed->GetReceiveDeltasUs());
+}
+
+TEST(TransportFeedbackTest, ReportsMissingPackets) {
+  TransportFeedback feedback;
+  feedback.WithBase(10, kBaseTimeUs);
+  EXPECT_TRUE(feedback.WithReceivedPacket(10, kBaseTimeUs));
+  EXPECT_TRUE(feedback.WithReceivedPacket(13, kBaseTimeUs + 10 * kDeltaUs));
+  EXPECT_TRUE(feedback.WithReceivedPacket(14, kBaseTimeUs + 10 * kDeltaUs));
+
+  const StatusSymbol kExpected[] = {
+      StatusSymbol::kReceivedSmallDelta, StatusSymbol::kNotReceived,
+      StatusSymbol::kNotReceived, StatusSymbol::kReceivedSmallDelta,
+      StatusSymbol::kReceivedSmallDelta};
+  EXPECT_EQ(std::vector<StatusSymbol>(kExpected, kExpected + 5),
+            feedback.GetStatusVector());
+  const int16_t kExpectedDeltas[] = {0, 10, 0};
+  EXPECT_EQ(std::vector<int16_t>(kExpectedDeltas, kExpectedDeltas + 3),
+            feedback.GetReceiveDeltas());
+
+  rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+  ASSERT_TRUE(parsed.get() != nullptr);
+  VerifyEqual(feedback, *parsed);
+}
+
+TEST(TransportFeedbackTest, LargeAndNegativeDeltas) {
+  TransportFeedback feedback;
+  feedback.WithBase(0, kBaseTimeUs);
+  EXPECT_TRUE(feedback.WithReceivedPacket(0, kBaseTimeUs + 256 * kDeltaUs));
+  EXPECT_TRUE(feedback.WithReceivedPacket(1, kBaseTimeUs + 200 * kDeltaUs));
+  EXPECT_TRUE(feedback.WithReceivedPacket(2, kBaseTimeUs + 201 * kDeltaUs));
+
+  const StatusSymbol kExpected[] = {StatusSymbol::kReceivedLargeDelta,
+                                    StatusSymbol::kReceivedLargeDelta,
+                                    StatusSymbol::kReceivedSmallDelta};
+  EXPECT_EQ(std::vector<StatusSymbol>(kExpected, kExpected + 3),
+            feedback.GetStatusVector());
+  const int16_t kExpectedDeltas[] = {256, -56, 1};
+  EXPECT_EQ(std::vector<int16_t>(kExpectedDeltas, kExpectedDeltas + 3),
+            feedback.GetReceiveDeltas());
+
+  rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+  ASSERT_TRUE(parsed.get() != nullptr);
+  VerifyEqual(feedback, *parsed);
+}
+
+TEST(TransportFeedbackTest, RejectsUnrepresentablePackets) {
+  TransportFeedback feedback;
+  feedback.WithBase(100, kBaseTimeUs);
+  EXPECT_TRUE(feedback.WithReceivedPacket(101, kBaseTimeUs));
+  // Not newer than the last one added.
+  EXPECT_FALSE(feedback.WithReceivedPacket(101, kBaseTimeUs));
+  EXPECT_FALSE(feedback.WithReceivedPacket(99, kBaseTimeUs));
+  // Delta out of range.
+  EXPECT_FALSE(feedback.WithReceivedPacket(
+      102, kBaseTimeUs + (1 << 15) * kDeltaUs));
+  EXPECT_FALSE(feedback.WithReceivedPacket(
+      102, kBaseTimeUs - ((1 << 15) + 1) * kDeltaUs));
+  EXPECT_EQ(2u, feedback.GetStatusVector().size());
+  EXPECT_EQ(1u, feedback.GetReceiveDeltas().size());
+
+  EXPECT_TRUE(feedback.WithReceivedPacket(
+      102, kBaseTimeUs - (1 << 15) * kDeltaUs));
+  rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+  ASSERT_TRUE(parsed.get() != nullptr);
+  VerifyEqual(feedback, *parsed);
+}
+
+TEST(TransportFeedbackTest, LongGapsUseRunLengthChunks) {
+  TransportFeedback feedback;
+  feedback.WithBase(0xfff0, kBaseTimeUs);
+  EXPECT_TRUE(feedback.WithReceivedPacket(0xfff0, kBaseTimeUs));
+  // Wraps around, with a gap far longer than one run length chunk holds.
+  EXPECT_TRUE(feedback.WithReceivedPacket(20000, kBaseTimeUs));
+  EXPECT_EQ(20017u, feedback.GetStatusVector().size());
+
+  rtc::scoped_ptr<RawPacket> raw_packet(feedback.Build());
+  EXPECT_LE(raw_packet->Length(), 40u);
+  rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+  ASSERT_TRUE(parsed.get() != nullptr);
+  VerifyEqual(feedback, *parsed);
+}
+
+TEST(TransportFeedbackTest, StopsAtMaxSize) {
+  TransportFeedback feedback;
+  feedback.WithBase(0, kBaseTimeUs);
+  uint16_t sequence_number = 0;
+  int64_t timestamp_us = kBaseTimeUs;
+  // Alternate received and lost packets with large deltas, the least compact
+  // pattern.
+  while (feedback.WithReceivedPacket(sequence_number, timestamp_us)) {
+    sequence_number += 2;
+    timestamp_us += 1000 * kDeltaUs;
+  }
+  const size_t num_symbols = feedback.GetStatusVector().size();
+  EXPECT_GT(num_symbols, 300u);
+  EXPECT_EQ(num_symbols, 2 * feedback.GetReceiveDeltas().size() - 1);
+
+  rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+  ASSERT_TRUE(parsed.get() != nullptr);
+  VerifyEqual(feedback, *parsed);
+}
+
+TEST(TransportFeedbackTest, RandomPacketsRoundTrip) {
+  uint32_t random = 1234;
+  for (int round = 0; round < 50; ++round) {
+    TransportFeedback feedback;
+    const uint16_t base_sequence = static_cast<uint16_t>(random);
+    feedback.WithBase(base_sequence, kBaseTimeUs);
+    feedback.WithFeedbackSequenceNumber(static_cast<uint8_t>(round));
+    uint16_t sequence_number = base_sequence;
+    int64_t timestamp_us = kBaseTimeUs;
+    for (int i = 0; i < 200; ++i) {
+      random = random * 1103515245 + 12345;
+      const uint32_t r = random >> 16;
+      // Mostly consecutive packets, with occasional bursts of losses.
+      sequence_number += (r % 10 == 0) ? 1 + (r >> 4) % 20 : 1;
+      // Mostly small deltas, with occasional large and negative ones.
+      const int64_t delta = (r % 7 == 0)
+                                ? static_cast<int64_t>((r >> 3) % 4000) - 1000
+                                : (r >> 3) % 40;
+      timestamp_us += delta * kDeltaUs;
+      if (!feedback.WithReceivedPacket(sequence_number, timestamp_us))
+        break;
+    }
+    rtc::scoped_ptr<TransportFeedback> parsed = BuildAndParse(feedback);
+    ASSERT_TRUE(parsed.get() != nullptr);
+    VerifyEqual(feedback, *parsed);
+
+    // The parsed packet builds into the same bytes.
+    rtc::scoped_ptr<RawPacket> raw_packet(feedback.Build());
+    rtc::scoped_ptr<RawPacket> reparsed(parsed->Build());
+    ASSERT_EQ(raw_packet->Length(), reparsed->Length());
+    EXPECT_EQ(0, memcmp(raw_packet->Buffer(), reparsed->Buffer(),
+                        raw_packet->Length()));
+  }
+}
+
+TEST(TransportFeedbackTest, ParseRejectsInvalidPackets) {
+  TransportFeedback feedback;
+  feedback.WithBase(0, kBaseTimeUs);
+  EXPECT_TRUE(feedback.WithReceivedPacket(0, kBaseTimeUs));
+  EXPECT_TRUE(feedback.WithReceivedPacket(5, kBaseTimeUs + 1000 * kDeltaUs));
+  rtc::scoped_ptr<RawPacket> raw_packet(feedback.Build());
+  std::vector<uint8_t> buffer(raw_packet->Buffer(),
+                              raw_packet->Buffer() + raw_packet->Length());
+  ASSERT_TRUE(TransportFeedback::ParseFrom(&buffer[0], buffer.size()).get() !=
+              nullptr);
+
+  // Truncated.
+  EXPECT_TRUE(TransportFeedback::ParseFrom(&buffer[0], buffer.size() - 4)
+                  .get() == nullptr);
+  // Wrong feedback message type.
+  std::vector<uint8_t> wrong_type = buffer;
+  wrong_type[0] = 0x80 | 1;
+  EXPECT_TRUE(TransportFeedback::ParseFrom(&wrong_type[0], wrong_type.size())
+                  .get() == nullptr);
+  // More statuses than the chunks and deltas hold.
+  std::vector<uint8_t> wrong_count = buffer;
+  wrong_count[15] = 100;
+  EXPECT_TRUE(TransportFeedback::ParseFrom(&wrong_count[0],
+                                           wrong_count.size()).get() ==
+              nullptr);
+}
+
+}  // namespace
+}  // namespace rtcp
+}  // namespace webrtc
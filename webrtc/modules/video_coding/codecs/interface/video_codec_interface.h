@@ -68,6 +68,21 @@ union CodecSpecificInfoUnion {
   CodecSpecificInfoH264 H264;
 };
 
+// Threading of the libvpx based decoders. By default a decoder runs on the
+// thread calling Decode() and outputs every frame before Decode() returns.
+struct VideoDecoderThreading {
+  VideoDecoderThreading() : max_threads(1), frame_parallel(false) {}
+
+  // Upper bound for the number of decoder threads. The number of cores given
+  // to InitDecode() limits it further.
+  int max_threads;
+  // Decode consecutive frames on separate threads instead of splitting each
+  // frame between them. A frame is then output, in decode order, up to
+  // |max_threads| - 1 calls to Decode() later, so the decoder becomes a
+  // pipeline of that depth. Ignored by decoders that don't support it (VP8).
+  bool frame_parallel;
+};
+
 // Note: if any pointers are added to this struct or its sub-structs, it
 // must be fitted with a copy-constructor. This is because it is copied
 // in the copy-constructor of VCMEncodedFrame.
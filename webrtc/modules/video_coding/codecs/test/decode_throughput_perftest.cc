@@ -0,0 +1,190 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/common_video/libyuv/include/scaler.h"
+#include "webrtc/modules/video_coding/codecs/interface/video_codec_interface.h"
+#include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
+#include "webrtc/modules/video_coding/codecs/vp9/include/vp9.h"
+#include "webrtc/modules/video_coding/main/interface/video_coding.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/test/frame_generator.h"
+#include "webrtc/test/testsupport/fileutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+const int kSourceWidth = 352;
+const int kSourceHeight = 288;
+const int kWidth = 1920;
+const int kHeight = 1080;
+const int kFramerate = 30;
+const int kBitrateKbps = 4000;
+const int kNumFrames = 90;
+
+struct RecordedFrame {
+  std::vector<uint8_t> data;
+  uint32_t timestamp;
+  VideoFrameType frame_type;
+};
+
+class FrameRecorder : public EncodedImageCallback {
+ public:
+  explicit FrameRecorder(std::vector<RecordedFrame>* frames)
+      : frames_(frames) {}
+
+  int32_t Encoded(const EncodedImage& encoded_image,
+                  const CodecSpecificInfo* codec_specific_info,
+                  const RTPFragmentationHeader* fragmentation) override {
+    RecordedFrame frame;
+    frame.data.assign(encoded_image._buffer,
+                      encoded_image._buffer + encoded_image._length);
+    frame.timestamp = encoded_image._timeStamp;
+    frame.frame_type = encoded_image._frameType;
+    frames_->push_back(frame);
+    return 0;
+  }
+
+ private:
+  std::vector<RecordedFrame>* const frames_;
+};
+
+class FrameCounter : public DecodedImageCallback {
+ public:
+  FrameCounter() : num_frames_(0) {}
+
+  int32_t Decoded(VideoFrame& decoded_image) override {
+    ++num_frames_;
+    return 0;
+  }
+
+  int num_frames() const { return num_frames_; }
+
+ private:
+  int num_frames_;
+};
+
+// Encodes foreman, upscaled to 1080p, into a stream held in memory.
+void RecordStream(VideoCodecType codec_type,
+                  VideoEncoder* encoder,
+                  VideoCodec* codec,
+                  std::vector<RecordedFrame>* frames) {
+  VideoCodingModule::Codec(codec_type, codec);
+  codec->width = kWidth;
+  codec->height = kHeight;
+  codec->maxFramerate = kFramerate;
+  codec->startBitrate = kBitrateKbps;
+  codec->maxBitrate = kBitrateKbps;
+
+  FrameRecorder recorder(frames);
+  encoder->RegisterEncodeCompleteCallback(&recorder);
+  ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK, encoder->InitEncode(codec, 4, 1440));
+
+  std::vector<std::string> files;
+  files.push_back(test::ResourcePath("foreman_cif", "yuv"));
+  rtc::scoped_ptr<test::FrameGenerator> frame_generator(
+      test::FrameGenerator::CreateFromYuvFile(files, kSourceWidth,
+                                              kSourceHeight, 1));
+  Scaler scaler;
+  ASSERT_EQ(0, scaler.Set(kSourceWidth, kSourceHeight, kWidth, kHeight, kI420,
+                          kI420, kScaleBox));
+  VideoFrame frame;
+  for (int i = 0; i < kNumFrames; ++i) {
+    ASSERT_EQ(0, scaler.Scale(*frame_generator->NextFrame(), &frame));
+    frame.set_timestamp(static_cast<uint32_t>(i) * 90000 / kFramerate);
+    ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK, encoder->Encode(frame, NULL, NULL));
+  }
+  encoder->Release();
+  ASSERT_FALSE(frames->empty());
+  ASSERT_EQ(kKeyFrame, frames->front().frame_type);
+}
+
+// Decodes the recorded stream as fast as possible and reports the frame rate.
+void RunDecodeBenchmark(const std::string& trace_name,
+                        const VideoCodec& codec,
+                        const std::vector<RecordedFrame>& frames,
+                        VideoDecoder* decoder) {
+  FrameCounter counter;
+  decoder->RegisterDecodeCompleteCallback(&counter);
+  ASSERT_EQ(WEBRTC_VIDEO_CODEC_OK, decoder->InitDecode(&codec, 4));
+
+  Clock* clock = Clock::GetRealTimeClock();
+  int64_t start_us = clock->TimeInMicroseconds();
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const RecordedFrame& recorded = frames[i];
+    EncodedImage image(const_cast<uint8_t*>(&recorded.data[0]),
+                       recorded.data.size(), recorded.data.size());
+    image._timeStamp = recorded.timestamp;
+    image._frameType = recorded.frame_type;
+    image._encodedWidth = kWidth;
+    image._encodedHeight = kHeight;
+    image._completeFrame = true;
+    ASSERT_LE(WEBRTC_VIDEO_CODEC_OK,
+              decoder->Decode(image, false, NULL, NULL, 0));
+  }
+  int64_t elapsed_us = clock->TimeInMicroseconds() - start_us;
+  decoder->Release();
+
+  // A frame-parallel decoder still holds the last few frames.
+  EXPECT_GE(counter.num_frames(), static_cast<int>(frames.size()) - 8);
+  test::PrintResult("decode_fps", "", trace_name,
+                    counter.num_frames() * 1e6 / elapsed_us, "fps", true);
+}
+
+VideoDecoderThreading Threading(int max_threads, bool frame_parallel) {
+  VideoDecoderThreading threading;
+  threading.max_threads = max_threads;
+  threading.frame_parallel = frame_parallel;
+  return threading;
+}
+
+}  // namespace
+
+TEST(DecodeThroughputPerfTest, Vp8) {
+  VideoCodec codec;
+  std::vector<RecordedFrame> frames;
+  rtc::scoped_ptr<VideoEncoder> encoder(VP8Encoder::Create());
+  RecordStream(kVideoCodecVP8, encoder.get(), &codec, &frames);
+
+  const int kThreads[] = {1, 2, 4};
+  for (size_t i = 0; i < sizeof(kThreads) / sizeof(kThreads[0]); ++i) {
+    rtc::scoped_ptr<VideoDecoder> decoder(
+        VP8Decoder::Create(Threading(kThreads[i], false)));
+    RunDecodeBenchmark("vp8_" + rtc::ToString(kThreads[i]) + "_threads",
+                       codec, frames, decoder.get());
+  }
+}
+
+TEST(DecodeThroughputPerfTest, Vp9) {
+  VideoCodec codec;
+  std::vector<RecordedFrame> frames;
+  rtc::scoped_ptr<VideoEncoder> encoder(VP9Encoder::Create());
+  RecordStream(kVideoCodecVP9, encoder.get(), &codec, &frames);
+
+  const int kThreads[] = {1, 2, 4};
+  for (size_t i = 0; i < sizeof(kThreads) / sizeof(kThreads[0]); ++i) {
+    rtc::scoped_ptr<VideoDecoder> decoder(
+        VP9Decoder::Create(Threading(kThreads[i], false)));
+    RunDecodeBenchmark("vp9_" + rtc::ToString(kThreads[i]) + "_threads",
+                       codec, frames, decoder.get());
+  }
+  rtc::scoped_ptr<VideoDecoder> decoder(
+      VP9Decoder::Create(Threading(4, true)));
+  RunDecodeBenchmark("vp9_4_threads_frame_parallel", codec, frames,
+                     decoder.get());
+}
+
+}  // namespace webrtc
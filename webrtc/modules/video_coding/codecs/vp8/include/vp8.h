@@ -28,6 +28,7 @@ class VP8Encoder : public VideoEncoder {
 class VP8Decoder : public VideoDecoder {
  public:
   static VP8Decoder* Create();
+  static VP8Decoder* Create(const VideoDecoderThreading& threading);
 
   virtual ~VP8Decoder() {};
 };  // end of VP8Decoder class
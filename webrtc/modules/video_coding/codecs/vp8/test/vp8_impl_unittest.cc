@@ -10,6 +10,8 @@
 
 #include <stdio.h>
 
+#include <vector>
+
 #include "testing/gtest/include/gtest/gtest.h"
 #include "webrtc/base/scoped_ptr.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
@@ -270,4 +272,70 @@ TEST_F(TestVp8Impl, TestReset) {
       0, memcmp(second_frame_buffer.get(), first_frame_buffer.get(), length));
 }
 
+TEST_F(TestVp8Impl, DISABLED_ON_ANDROID(SkipsStaticMacroblocks)) {
+  codec_inst_.mode = kScreensharing;
+  codec_inst_.startBitrate = 300;
+  codec_inst_.maxBitrate = 4000;
+  codec_inst_.qpMax = 56;
+  codec_inst_.codecSpecific.VP8.denoisingOn = false;
+  codec_inst_.codecSpecific.VP8.numberOfTemporalLayers = 1;
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+            encoder_->InitEncode(&codec_inst_, 1, 1440));
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK, decoder_->InitDecode(&codec_inst_, 1));
+
+  std::vector<VideoFrame::UpdatedRect> rects;
+  VideoFrame::UpdatedRect full_frame = {0, 0, kWidth, kHeight};
+  rects.push_back(full_frame);
+  input_frame_.set_updated_rects(0, rects);
+  EXPECT_EQ(0, encoder_->Encode(input_frame_, NULL, NULL));
+  ASSERT_GT(WaitForEncodedFrame(), 0u);
+  encoded_frame_._frameType = kKeyFrame;
+  EXPECT_EQ(0, decoder_->Decode(encoded_frame_, false, NULL));
+  ASSERT_GT(WaitForDecodedFrame(), 0u);
+
+  // The macroblocks of the key frame may be refined by the next frames, at
+  // most VP8EncoderImpl's kActiveMapRefinementFrames of them.
+  const uint32_t kRefinementFrames = 10;
+  rects.clear();
+  for (uint32_t i = 1; i <= kRefinementFrames; ++i) {
+    input_frame_.set_updated_rects(i, rects);
+    input_frame_.set_timestamp(kTestTimestamp + i * 3000);
+    EXPECT_EQ(0, encoder_->Encode(input_frame_, NULL, NULL));
+    ASSERT_GT(WaitForEncodedFrame(), 0u);
+    EXPECT_EQ(0, decoder_->Decode(encoded_frame_, false, NULL));
+    ASSERT_GT(WaitForDecodedFrame(), 0u);
+  }
+  VideoFrame refined_frame;
+  refined_frame.CopyFrame(decoded_frame_);
+
+  // Invert the whole picture, but claim that only the top left macroblock
+  // changed. All other macroblocks must be copied from the refined frame.
+  VideoFrame next_frame;
+  next_frame.CopyFrame(input_frame_);
+  for (int y = 0; y < kHeight; ++y) {
+    uint8_t* row = next_frame.buffer(kYPlane) + y * next_frame.stride(kYPlane);
+    for (int x = 0; x < kWidth; ++x)
+      row[x] = 255 - row[x];
+  }
+  VideoFrame::UpdatedRect top_left = {0, 0, 16, 16};
+  rects.push_back(top_left);
+  next_frame.set_updated_rects(kRefinementFrames + 1, rects);
+  next_frame.set_timestamp(kTestTimestamp + (kRefinementFrames + 1) * 3000);
+  EXPECT_EQ(0, encoder_->Encode(next_frame, NULL, NULL));
+  ASSERT_GT(WaitForEncodedFrame(), 0u);
+  EXPECT_EQ(kDeltaFrame, encoded_frame_._frameType);
+  EXPECT_EQ(0, decoder_->Decode(encoded_frame_, false, NULL));
+  ASSERT_GT(WaitForDecodedFrame(), 0u);
+
+  // Compare the inside of a static macroblock, which isn't touched by the
+  // loop filter.
+  for (int y = 4 * 16 + 4; y < 4 * 16 + 12; ++y) {
+    const uint8_t* refined_row =
+        refined_frame.buffer(kYPlane) + y * refined_frame.stride(kYPlane);
+    const uint8_t* row =
+        decoded_frame_.buffer(kYPlane) + y * decoded_frame_.stride(kYPlane);
+    EXPECT_EQ(0, memcmp(refined_row + 4 * 16 + 4, row + 4 * 16 + 4, 8));
+  }
+}
+
 }  // namespace webrtc
@@ -35,7 +35,11 @@ VP8Encoder* VP8Encoder::Create() {
 }
 
 VP8Decoder* VP8Decoder::Create() {
-  return new VP8DecoderImpl();
+  return new VP8DecoderImpl(VideoDecoderThreading());
+}
+
+VP8Decoder* VP8Decoder::Create(const VideoDecoderThreading& threading) {
+  return new VP8DecoderImpl(threading);
 }
 
 }  // namespace webrtc
@@ -136,6 +136,13 @@ bool ValidSimulcastResolutions(const VideoCodec& codec, int num_streams) {
 
 const float kTl1MaxTimeToDropFrames = 20.0f;
 
+// A macroblock that changed stays in the active map until this many frames
+// updating LAST have been encoded since, so that it is refined after being
+// coded at a high QP. A frame encoded at a QP of at most kActiveMapRefinedQp,
+// on the 0-63 scale, ends the refinement of all macroblocks.
+const int kActiveMapRefinementFrames = 10;
+const int kActiveMapRefinedQp = 30;
+
 VP8EncoderImpl::VP8EncoderImpl()
     : encoded_complete_callback_(NULL),
       inited_(false),
@@ -149,7 +156,9 @@ VP8EncoderImpl::VP8EncoderImpl()
       down_scale_bitrate_(0),
       tl0_frame_dropper_(),
       tl1_frame_dropper_(kTl1MaxTimeToDropFrames),
-      key_frame_request_(kMaxSimulcastStreams, false) {
+      key_frame_request_(kMaxSimulcastStreams, false),
+      has_updated_rects_sequence_number_(false),
+      updated_rects_sequence_number_(0) {
   uint32_t seed = static_cast<uint32_t>(TickTime::MillisecondTimestamp());
   srand(seed);
 
@@ -672,6 +681,7 @@ int VP8EncoderImpl::InitAndSetControlSettings() {
     vpx_codec_control(&(encoders_[i]), VP8E_SET_SCREEN_CONTENT_MODE,
                       codec_.mode == kScreensharing ? 2 : 0);
   }
+  ResetChangedMacroblocks();
   inited_ = true;
   return WEBRTC_VIDEO_CODEC_OK;
 }
@@ -719,6 +729,11 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
       return ret;
   }
 
+  // Track the changed area before any frame is dropped below, since the next
+  // frame is only described relative to this one.
+  if (encoders_.size() == 1)
+    AccumulateChangedMacroblocks(frame, &input_image != &frame);
+
   // Since we are extracting raw pointers from |input_image| to
   // |raw_images_[0]|, the resolution of these frames must match. Note that
   // |input_image| might be scaled from |frame|. In that case, the resolution of
@@ -862,6 +877,8 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
                       VP8E_SET_TEMPORAL_LAYER_ID,
                       temporal_layers_[stream_idx]->CurrentLayerId());
   }
+  if (encoders_.size() == 1)
+    SetActiveMap(flags[0]);
   // TODO(holmer): Ideally the duration should be the timestamp diff of this
   // frame and the next frame to be encoded, which we don't have. Instead we
   // would like to use the duration of the previous frame. Unfortunately the
@@ -882,7 +899,93 @@ int VP8EncoderImpl::Encode(const VideoFrame& frame,
   if (error)
     return WEBRTC_VIDEO_CODEC_ERROR;
   timestamp_ += duration;
-  return GetEncodedPartitions(input_image, only_predict_from_key_frame);
+  int ret = GetEncodedPartitions(input_image, only_predict_from_key_frame);
+  // Once LAST holds this frame, only later changes and the macroblocks still
+  // being refined need to be encoded.
+  if (encoders_.size() == 1 && encoded_images_[0]._length > 0 &&
+      (encoded_images_[0]._frameType == kKeyFrame ||
+       !(flags[0] & VP8_EFLAG_NO_UPD_LAST))) {
+    int qp = -1;
+    vpx_codec_control(&encoders_[0], VP8E_GET_LAST_QUANTIZER_64, &qp);
+    UpdateRefinement(encoded_images_[0]._frameType == kKeyFrame ||
+                         (flags[0] & VP8_EFLAG_NO_REF_LAST) != 0,
+                     qp);
+  }
+  return ret;
+}
+
+void VP8EncoderImpl::ResetChangedMacroblocks() {
+  const int mb_cols = (codec_.width + 15) / 16;
+  const int mb_rows = (codec_.height + 15) / 16;
+  changed_macroblocks_.assign(mb_cols * mb_rows, 1);
+  refinement_frames_left_.assign(mb_cols * mb_rows, 0);
+  active_macroblocks_.assign(mb_cols * mb_rows, 1);
+  has_updated_rects_sequence_number_ = false;
+}
+
+void VP8EncoderImpl::AccumulateChangedMacroblocks(const VideoFrame& frame,
+                                                  bool scaled) {
+  const bool consecutive =
+      frame.has_updated_rects() && has_updated_rects_sequence_number_ &&
+      frame.updated_rects_sequence_number() ==
+          updated_rects_sequence_number_ + 1;
+  has_updated_rects_sequence_number_ = frame.has_updated_rects();
+  updated_rects_sequence_number_ = frame.updated_rects_sequence_number();
+  if (!consecutive || scaled || frame.width() != codec_.width ||
+      frame.height() != codec_.height) {
+    std::fill(changed_macroblocks_.begin(), changed_macroblocks_.end(), 1);
+    return;
+  }
+
+  const int mb_cols = (codec_.width + 15) / 16;
+  for (const VideoFrame::UpdatedRect& rect : frame.updated_rects()) {
+    const int left = std::max(rect.x, 0);
+    const int top = std::max(rect.y, 0);
+    const int right = std::min(rect.x + rect.width, frame.width());
+    const int bottom = std::min(rect.y + rect.height, frame.height());
+    if (left >= right || top >= bottom)
+      continue;
+    for (int mb_row = top / 16; mb_row <= (bottom - 1) / 16; ++mb_row) {
+      uint8_t* row = &changed_macroblocks_[mb_row * mb_cols];
+      std::fill(row + left / 16, row + (right - 1) / 16 + 1, 1);
+    }
+  }
+}
+
+void VP8EncoderImpl::SetActiveMap(vpx_enc_frame_flags_t flags) {
+  for (size_t i = 0; i < active_macroblocks_.size(); ++i) {
+    active_macroblocks_[i] =
+        changed_macroblocks_[i] || refinement_frames_left_[i] > 0;
+  }
+  // Inactive macroblocks are coded as unchanged from LAST, which only holds
+  // when the frame predicts from it. Key frames ignore the map.
+  const bool use_map =
+      !(flags & (VPX_EFLAG_FORCE_KF | VP8_EFLAG_NO_REF_LAST)) &&
+      std::find(active_macroblocks_.begin(), active_macroblocks_.end(), 0) !=
+          active_macroblocks_.end();
+  vpx_active_map_t active_map;
+  active_map.rows = (codec_.height + 15) / 16;
+  active_map.cols = (codec_.width + 15) / 16;
+  active_map.active_map = use_map ? &active_macroblocks_[0] : NULL;
+  vpx_codec_control(&encoders_[0], VP8E_SET_ACTIVEMAP, &active_map);
+}
+
+void VP8EncoderImpl::UpdateRefinement(bool whole_frame, int qp) {
+  // Like the top-off pass of a remote desktop encoder: a change is first
+  // coded at whatever QP the rate control affords, and then kept active so
+  // that the following frames can spend their bits improving it.
+  if (qp >= 0 && qp <= kActiveMapRefinedQp) {
+    std::fill(refinement_frames_left_.begin(), refinement_frames_left_.end(),
+              0);
+  } else {
+    for (size_t i = 0; i < refinement_frames_left_.size(); ++i) {
+      if (whole_frame || changed_macroblocks_[i])
+        refinement_frames_left_[i] = kActiveMapRefinementFrames;
+      else if (refinement_frames_left_[i] > 0)
+        --refinement_frames_left_[i];
+    }
+  }
+  std::fill(changed_macroblocks_.begin(), changed_macroblocks_.end(), 0);
 }
 
 // TODO(pbos): Make sure this works for properly for >1 encoders.
@@ -906,6 +1009,7 @@ int VP8EncoderImpl::UpdateCodecFrameSize(const VideoFrame& input_image) {
   if (vpx_codec_enc_config_set(&encoders_[0], &configurations_[0])) {
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
+  ResetChangedMacroblocks();
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -1043,8 +1147,9 @@ int VP8EncoderImpl::RegisterEncodeCompleteCallback(
 }
 
 
-VP8DecoderImpl::VP8DecoderImpl()
-    : decode_complete_callback_(NULL),
+VP8DecoderImpl::VP8DecoderImpl(const VideoDecoderThreading& threading)
+    : buffer_pool_(DecoderBufferPool::Shared()),
+      decode_complete_callback_(NULL),
       inited_(false),
       feedback_mode_(false),
       decoder_(NULL),
@@ -1054,7 +1159,9 @@ VP8DecoderImpl::VP8DecoderImpl()
       propagation_cnt_(-1),
       last_frame_width_(0),
       last_frame_height_(0),
-      key_frame_required_(true) {
+      key_frame_required_(true),
+      threading_(threading),
+      number_of_cores_(1) {
 }
 
 VP8DecoderImpl::~VP8DecoderImpl() {
@@ -1066,7 +1173,7 @@ int VP8DecoderImpl::Reset() {
   if (!inited_) {
     return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
   }
-  InitDecode(&codec_, 1);
+  InitDecode(&codec_, number_of_cores_);
   propagation_cnt_ = -1;
   return WEBRTC_VIDEO_CODEC_OK;
 }
@@ -1083,9 +1190,10 @@ int VP8DecoderImpl::InitDecode(const VideoCodec* inst,
   if (inst && inst->codecType == kVideoCodecVP8) {
     feedback_mode_ = inst->codecSpecific.VP8.feedbackModeOn;
   }
+  number_of_cores_ = number_of_cores;
   vpx_codec_dec_cfg_t  cfg;
-  // Setting number of threads to a constant value (1)
-  cfg.threads = 1;
+  // libvpx decodes the macroblock rows of a frame in parallel.
+  cfg.threads = std::max(1, std::min(threading_.max_threads, number_of_cores));
   cfg.h = cfg.w = 0;  // set after decode
 
 vpx_codec_flags_t flags = 0;
@@ -1329,17 +1437,29 @@ int VP8DecoderImpl::ReturnFrame(const vpx_image_t* img,
   }
   last_frame_width_ = img->d_w;
   last_frame_height_ = img->d_h;
-  // Allocate memory for decoded image.
-  VideoFrame decoded_image(buffer_pool_.CreateBuffer(img->d_w, img->d_h),
-                           timestamp, 0, kVideoRotation_0);
+  // libvpx reuses |img| for later frames and, unlike for VP9, can't decode
+  // into external buffers, so copy the image into a buffer of the shared pool.
+  const int width = img->d_w;
+  const int height = img->d_h;
+  const int stride_y = width;
+  const int stride_uv = (width + 1) / 2;
+  const size_t size_y = stride_y * height;
+  const size_t size_uv = stride_uv * ((height + 1) / 2);
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer =
+      buffer_pool_->GetBuffer(size_y + 2 * size_uv);
+  uint8_t* y_plane = buffer->data();
+  uint8_t* u_plane = y_plane + size_y;
+  uint8_t* v_plane = u_plane + size_uv;
   libyuv::I420Copy(
       img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
       img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
       img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V],
-      decoded_image.buffer(kYPlane), decoded_image.stride(kYPlane),
-      decoded_image.buffer(kUPlane), decoded_image.stride(kUPlane),
-      decoded_image.buffer(kVPlane), decoded_image.stride(kVPlane),
-      img->d_w, img->d_h);
+      y_plane, stride_y, u_plane, stride_uv, v_plane, stride_uv,
+      width, height);
+  VideoFrame decoded_image(
+      buffer->WrapI420(width, height, y_plane, stride_y, u_plane, stride_uv,
+                       v_plane, stride_uv),
+      timestamp, 0, kVideoRotation_0);
   decoded_image.set_ntp_time_ms(ntp_time_ms);
   int ret = decode_complete_callback_->Decoded(decoded_image);
   if (ret != 0)
@@ -1373,7 +1493,7 @@ int VP8DecoderImpl::Release() {
     delete ref_frame_;
     ref_frame_ = NULL;
   }
-  buffer_pool_.Release();
+  buffer_pool_->TrimIdleBuffers();
   inited_ = false;
   return WEBRTC_VIDEO_CODEC_OK;
 }
@@ -22,10 +22,10 @@
 #include "vpx/vp8cx.h"
 #include "vpx/vp8dx.h"
 
-#include "webrtc/common_video/interface/i420_buffer_pool.h"
 #include "webrtc/modules/video_coding/codecs/interface/video_codec_interface.h"
 #include "webrtc/modules/video_coding/codecs/vp8/include/vp8.h"
 #include "webrtc/modules/video_coding/codecs/vp8/reference_picture_selection.h"
+#include "webrtc/modules/video_coding/utility/include/decoder_buffer_pool.h"
 #include "webrtc/modules/video_coding/utility/include/frame_dropper.h"
 #include "webrtc/modules/video_coding/utility/include/quality_scaler.h"
 #include "webrtc/video_frame.h"
@@ -88,6 +88,25 @@ class VP8EncoderImpl : public VP8Encoder {
 
   uint32_t MaxIntraTarget(uint32_t optimal_buffer_size);
 
+  // Mark all macroblocks as changed, e.g. after the frame size changed.
+  void ResetChangedMacroblocks();
+
+  // Add the area of |frame| that changed since the previous input frame to
+  // |changed_macroblocks_|. The whole frame is considered changed if the
+  // area isn't known, if input frames were dropped before reaching the
+  // encoder, or if |frame| was scaled.
+  void AccumulateChangedMacroblocks(const VideoFrame& frame, bool scaled);
+
+  // Use the changed macroblocks and those still being refined as the active
+  // map of the next frame, so that libvpx skips the static macroblocks, if
+  // the frame predicts from LAST.
+  void SetActiveMap(vpx_enc_frame_flags_t flags);
+
+  // Called when an encoded frame updated LAST. Starts the refinement of the
+  // macroblocks coded in it, counts down the others and clears
+  // |changed_macroblocks_|.
+  void UpdateRefinement(bool whole_frame, int qp);
+
   EncodedImageCallback* encoded_complete_callback_;
   VideoCodec codec_;
   bool inited_;
@@ -114,11 +133,20 @@ class VP8EncoderImpl : public VP8Encoder {
   std::vector<vpx_codec_enc_cfg_t> configurations_;
   std::vector<vpx_rational_t> downsampling_factors_;
   QualityScaler quality_scaler_;
+  // Macroblocks of a single stream that changed since the LAST reference
+  // frame was updated, 1 if changed.
+  std::vector<uint8_t> changed_macroblocks_;
+  // Frames updating LAST each macroblock is still refined in.
+  std::vector<uint8_t> refinement_frames_left_;
+  // The active map passed to libvpx, 1 if active.
+  std::vector<uint8_t> active_macroblocks_;
+  bool has_updated_rects_sequence_number_;
+  uint32_t updated_rects_sequence_number_;
 };  // end of VP8EncoderImpl class
 
 class VP8DecoderImpl : public VP8Decoder {
  public:
-  VP8DecoderImpl();
+  explicit VP8DecoderImpl(const VideoDecoderThreading& threading);
 
   virtual ~VP8DecoderImpl();
 
@@ -147,7 +175,7 @@ class VP8DecoderImpl : public VP8Decoder {
                   uint32_t timeStamp,
                   int64_t ntp_time_ms);
 
-  I420BufferPool buffer_pool_;
+  DecoderBufferPool* const buffer_pool_;
   DecodedImageCallback* decode_complete_callback_;
   bool inited_;
   bool feedback_mode_;
@@ -160,6 +188,8 @@ class VP8DecoderImpl : public VP8Decoder {
   int last_frame_width_;
   int last_frame_height_;
   bool key_frame_required_;
+  const VideoDecoderThreading threading_;
+  int number_of_cores_;
 };  // end of VP8DecoderImpl class
 }  // namespace webrtc
 
@@ -27,6 +27,7 @@ class VP9Encoder : public VideoEncoder {
 class VP9Decoder : public VideoDecoder {
  public:
   static VP9Decoder* Create();
+  static VP9Decoder* Create(const VideoDecoderThreading& threading);
 
   virtual ~VP9Decoder() {}
 };
@@ -16,4 +16,7 @@
 namespace webrtc {
 VP9Encoder* VP9Encoder::Create() { return nullptr; }
 VP9Decoder* VP9Decoder::Create() { return nullptr; }
+VP9Decoder* VP9Decoder::Create(const VideoDecoderThreading& threading) {
+  return nullptr;
+}
 }
@@ -20,16 +20,20 @@
 
 namespace webrtc {
 
-uint8_t* Vp9FrameBufferPool::Vp9FrameBuffer::GetData() {
-  return data_.data<uint8_t>();
-}
+namespace {
+// Plenty for serial decoding, where libvpx keeps ~3-4 buffers alive at a time.
+const size_t kDefaultMaxNumBuffers = 10;
+}  // namespace
 
-size_t Vp9FrameBufferPool::Vp9FrameBuffer::GetDataSize() const {
-  return data_.size();
+Vp9FrameBufferPool::Vp9FrameBufferPool()
+    : Vp9FrameBufferPool(DecoderBufferPool::Shared()) {
 }
 
-void Vp9FrameBufferPool::Vp9FrameBuffer::SetSize(size_t size) {
-  data_.SetSize(size);
+Vp9FrameBufferPool::Vp9FrameBufferPool(DecoderBufferPool* pool)
+    : pool_(pool),
+      num_buffers_in_use_(0),
+      max_num_buffers_(kDefaultMaxNumBuffers) {
+  DCHECK(pool_);
 }
 
 bool Vp9FrameBufferPool::InitializeVpxUsePool(
@@ -54,47 +58,21 @@ bool Vp9FrameBufferPool::InitializeVpxUsePool(
 rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer>
 Vp9FrameBufferPool::GetFrameBuffer(size_t min_size) {
   DCHECK_GT(min_size, 0u);
-  rtc::scoped_refptr<Vp9FrameBuffer> available_buffer = nullptr;
-  {
-    rtc::CritScope cs(&buffers_lock_);
-    // Do we have a buffer we can recycle?
-    for (const auto& buffer : allocated_buffers_) {
-      if (buffer->HasOneRef()) {
-        available_buffer = buffer;
-        break;
-      }
-    }
-    // Otherwise create one.
-    if (available_buffer == nullptr) {
-      available_buffer = new rtc::RefCountedObject<Vp9FrameBuffer>();
-      allocated_buffers_.push_back(available_buffer);
-      if (allocated_buffers_.size() > max_num_buffers_) {
-        LOG(LS_WARNING)
-            << allocated_buffers_.size() << " Vp9FrameBuffers have been "
-            << "allocated by a Vp9FrameBufferPool (exceeding what is "
-            << "considered reasonable, " << max_num_buffers_ << ").";
-        RTC_NOTREACHED();
-      }
-    }
-  }
-
-  available_buffer->SetSize(min_size);
-  return available_buffer;
+  return pool_->GetBuffer(min_size);
 }
 
 int Vp9FrameBufferPool::GetNumBuffersInUse() const {
-  int num_buffers_in_use = 0;
   rtc::CritScope cs(&buffers_lock_);
-  for (const auto& buffer : allocated_buffers_) {
-    if (!buffer->HasOneRef())
-      ++num_buffers_in_use;
-  }
-  return num_buffers_in_use;
+  return static_cast<int>(num_buffers_in_use_);
 }
 
 void Vp9FrameBufferPool::ClearPool() {
+  pool_->TrimIdleBuffers();
+}
+
+void Vp9FrameBufferPool::SetMaxNumBuffers(size_t max_num_buffers) {
   rtc::CritScope cs(&buffers_lock_);
-  allocated_buffers_.clear();
+  max_num_buffers_ = max_num_buffers;
 }
 
 // static
@@ -106,8 +84,18 @@ int32 Vp9FrameBufferPool::VpxGetFrameBuffer(void* user_priv,
   Vp9FrameBufferPool* pool = static_cast<Vp9FrameBufferPool*>(user_priv);
 
   rtc::scoped_refptr<Vp9FrameBuffer> buffer = pool->GetFrameBuffer(min_size);
-  fb->data = buffer->GetData();
-  fb->size = buffer->GetDataSize();
+  {
+    rtc::CritScope cs(&pool->buffers_lock_);
+    if (++pool->num_buffers_in_use_ > pool->max_num_buffers_) {
+      LOG(LS_WARNING)
+          << pool->num_buffers_in_use_ << " Vp9FrameBuffers are held by "
+          << "libvpx (exceeding what is considered reasonable, "
+          << pool->max_num_buffers_ << ").";
+      RTC_NOTREACHED();
+    }
+  }
+  fb->data = buffer->data();
+  fb->size = buffer->size();
   // Store Vp9FrameBuffer* in |priv| for use in VpxReleaseFrameBuffer.
   // This also makes vpx_codec_get_frame return images with their |fb_priv| set
   // to |buffer| which is important for external reference counting.
@@ -122,6 +110,7 @@ int32 Vp9FrameBufferPool::VpxReleaseFrameBuffer(void* user_priv,
                                                 vpx_codec_frame_buffer* fb) {
   DCHECK(user_priv);
   DCHECK(fb);
+  Vp9FrameBufferPool* pool = static_cast<Vp9FrameBufferPool*>(user_priv);
   Vp9FrameBuffer* buffer = static_cast<Vp9FrameBuffer*>(fb->priv);
   if (buffer != nullptr) {
     buffer->Release();
@@ -129,6 +118,9 @@ int32 Vp9FrameBufferPool::VpxReleaseFrameBuffer(void* user_priv,
     // libvpx can for some reason try to release the same buffer multiple times.
     // Setting |priv| to null protects against trying to Release multiple times.
     fb->priv = nullptr;
+    rtc::CritScope cs(&pool->buffers_lock_);
+    DCHECK_GT(pool->num_buffers_in_use_, 0u);
+    --pool->num_buffers_in_use_;
   }
   return 0;
 }
@@ -12,13 +12,10 @@
 #ifndef WEBRTC_MODULES_VIDEO_CODING_CODECS_VP9_FRAME_BUFFER_POOL_H_
 #define WEBRTC_MODULES_VIDEO_CODING_CODECS_VP9_FRAME_BUFFER_POOL_H_
 
-#include <vector>
-
 #include "webrtc/base/basictypes.h"
-#include "webrtc/base/buffer.h"
 #include "webrtc/base/criticalsection.h"
-#include "webrtc/base/refcount.h"
 #include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/modules/video_coding/utility/include/decoder_buffer_pool.h"
 
 struct vpx_codec_ctx;
 struct vpx_codec_frame_buffer;
@@ -35,6 +32,10 @@ namespace webrtc {
 // using scoped_refptr, the image buffer can be reused by VideoFrames and no
 // frame copy has to occur during decoding and frame delivery.
 //
+// The buffers themselves come from a DecoderBufferPool, by default the one
+// shared by all decoders, so this class only connects libvpx to it and keeps
+// track of the buffers held by one decoder.
+//
 // Pseudo example usage case:
 //    Vp9FrameBufferPool pool;
 //    pool.InitializeVpxUsePool(decoder_ctx);
@@ -53,18 +54,11 @@ namespace webrtc {
 //    vpx_codec_destroy(decoder_ctx);
 class Vp9FrameBufferPool {
  public:
-  class Vp9FrameBuffer : public rtc::RefCountInterface {
-   public:
-    uint8_t* GetData();
-    size_t GetDataSize() const;
-    void SetSize(size_t size);
-
-    virtual bool HasOneRef() const = 0;
+  typedef DecoderBufferPool::Buffer Vp9FrameBuffer;
 
-   private:
-    // Data as an easily resizable buffer.
-    rtc::Buffer data_;
-  };
+  // Uses DecoderBufferPool::Shared().
+  Vp9FrameBufferPool();
+  explicit Vp9FrameBufferPool(DecoderBufferPool* pool);
 
   // Configures libvpx to, in the specified context, use this memory pool for
   // buffers used to decompress frames. This is only supported for VP9.
@@ -74,11 +68,14 @@ class Vp9FrameBufferPool {
   // creating a new one. When no longer referenced from the outside the buffer
   // becomes recyclable.
   rtc::scoped_refptr<Vp9FrameBuffer> GetFrameBuffer(size_t min_size);
-  // Gets the number of buffers currently in use (not ready to be recycled).
+  // Gets the number of buffers libvpx got from the pool and hasn't released.
   int GetNumBuffersInUse() const;
-  // Releases allocated buffers, deleting available buffers. Buffers in use are
-  // not deleted until they are no longer referenced.
+  // Frees the idle buffers of the underlying pool. Buffers in use are not
+  // deleted until they are no longer referenced.
   void ClearPool();
+  // Sets how many buffers libvpx may hold before warning. Decoders holding
+  // more frames at a time, like frame-parallel decoders, need more buffers.
+  void SetMaxNumBuffers(size_t max_num_buffers);
 
   // InitializeVpxUsePool configures libvpx to call this function when it needs
   // a new frame buffer. Parameters:
@@ -97,19 +94,18 @@ class Vp9FrameBufferPool {
   // |user_priv| Private data passed to libvpx, InitializeVpxUsePool sets it up
   //             to be a pointer to the pool.
   // |fb|        Pointer to the libvpx frame buffer object, its |priv| will be
-  //             a pointer to one of the pool's Vp9FrameBuffer.
+  //             a pointer to one of the pool's Vp9FrameBuffers.
   static int32 VpxReleaseFrameBuffer(void* user_priv,
                                      vpx_codec_frame_buffer* fb);
 
  private:
-  // Protects |allocated_buffers_|.
+  DecoderBufferPool* const pool_;
+  // libvpx may get and release buffers on its decoder threads.
   mutable rtc::CriticalSection buffers_lock_;
-  // All buffers, in use or ready to be recycled.
-  std::vector<rtc::scoped_refptr<Vp9FrameBuffer>> allocated_buffers_
-      GUARDED_BY(buffers_lock_);
-  // If more buffers than this are allocated we print warnings, and crash if
+  size_t num_buffers_in_use_ GUARDED_BY(buffers_lock_);
+  // If libvpx holds more buffers than this we print warnings, and crash if
   // in debug mode.
-  static const size_t max_num_buffers_ = 10;
+  size_t max_num_buffers_ GUARDED_BY(buffers_lock_);
 };
 
 }  // namespace webrtc
@@ -11,9 +11,12 @@
 
 #include "webrtc/modules/video_coding/codecs/vp9/vp9_impl.h"
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "vpx/vpx_encoder.h"
@@ -21,7 +24,6 @@
 #include "vpx/vp8cx.h"
 #include "vpx/vp8dx.h"
 
-#include "webrtc/base/bind.h"
 #include "webrtc/base/checks.h"
 #include "webrtc/common.h"
 #include "webrtc/common_video/libyuv/include/webrtc_libyuv.h"
@@ -32,11 +34,10 @@
 
 namespace {
 
-// VP9DecoderImpl::ReturnFrame helper function used with WrappedI420Buffer.
-static void WrappedI420BufferNoLongerUsedCb(
-    webrtc::Vp9FrameBufferPool::Vp9FrameBuffer* img_buffer) {
-  img_buffer->Release();
-}
+// Frame buffers libvpx may hold at a time when frames are decoded serially.
+const size_t kMaxNumBuffersSerial = 10;
+// Upper bound on the frame-parallel pipeline depth.
+const unsigned int kMaxFrameParallelThreads = 8;
 
 }  // anonymous namespace
 
@@ -386,35 +387,37 @@ int VP9EncoderImpl::RegisterEncodeCompleteCallback(
 }
 
 VP9Decoder* VP9Decoder::Create() {
-  return new VP9DecoderImpl();
+  return new VP9DecoderImpl(VideoDecoderThreading());
 }
 
-VP9DecoderImpl::VP9DecoderImpl()
+VP9Decoder* VP9Decoder::Create(const VideoDecoderThreading& threading) {
+  return new VP9DecoderImpl(threading);
+}
+
+VP9DecoderImpl::VP9DecoderImpl(const VideoDecoderThreading& threading)
     : decode_complete_callback_(NULL),
       inited_(false),
       decoder_(NULL),
-      key_frame_required_(true) {
+      key_frame_required_(true),
+      threading_(threading),
+      number_of_cores_(1),
+      frame_parallel_(false) {
   memset(&codec_, 0, sizeof(codec_));
 }
 
 VP9DecoderImpl::~VP9DecoderImpl() {
   inited_ = true;  // in order to do the actual release
   Release();
-  int num_buffers_in_use = frame_buffer_pool_.GetNumBuffersInUse();
-  if (num_buffers_in_use > 0) {
-    // The frame buffers are reference counted and frames are exposed after
-    // decoding. There may be valid usage cases where previous frames are still
-    // referenced after ~VP9DecoderImpl that is not a leak.
-    LOG(LS_INFO) << num_buffers_in_use << " Vp9FrameBuffers are still "
-                 << "referenced during ~VP9DecoderImpl.";
-  }
+  // Decoded frames may still reference their buffers after ~VP9DecoderImpl,
+  // those return to the shared pool once released. libvpx must not hold any.
+  DCHECK_EQ(0, frame_buffer_pool_.GetNumBuffersInUse());
 }
 
 int VP9DecoderImpl::Reset() {
   if (!inited_) {
     return WEBRTC_VIDEO_CODEC_UNINITIALIZED;
   }
-  InitDecode(&codec_, 1);
+  InitDecode(&codec_, number_of_cores_);
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -429,11 +432,22 @@ int VP9DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
   if (decoder_ == NULL) {
     decoder_ = new vpx_codec_ctx_t;
   }
+  number_of_cores_ = number_of_cores;
   vpx_codec_dec_cfg_t  cfg;
-  // Setting number of threads to a constant value (1)
-  cfg.threads = 1;
+  // Threads decode tiles of a frame, or whole frames in frame-parallel mode.
+  cfg.threads = std::max(1, std::min(threading_.max_threads, number_of_cores));
   cfg.h = cfg.w = 0;  // set after decode
   vpx_codec_flags_t flags = 0;
+  frame_parallel_ = false;
+#ifdef VPX_CODEC_USE_FRAME_THREADING
+  if (threading_.frame_parallel && cfg.threads > 1) {
+    // VCMGenericDecoder keeps track of up to kDecoderFrameMemoryLength frames
+    // in the decoder, so limit the pipeline depth well below that.
+    cfg.threads = std::min(cfg.threads, kMaxFrameParallelThreads);
+    flags |= VPX_CODEC_USE_FRAME_THREADING;
+    frame_parallel_ = true;
+  }
+#endif
   if (vpx_codec_dec_init(decoder_, vpx_codec_vp9_dx(), &cfg, flags)) {
     return WEBRTC_VIDEO_CODEC_MEMORY;
   }
@@ -445,6 +459,12 @@ int VP9DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
   if (!frame_buffer_pool_.InitializeVpxUsePool(decoder_)) {
     return WEBRTC_VIDEO_CODEC_MEMORY;
   }
+  if (frame_parallel_) {
+    // Each frame thread holds the frame it decodes on top of the references.
+    frame_buffer_pool_.SetMaxNumBuffers(kMaxNumBuffersSerial + cfg.threads);
+  } else {
+    frame_buffer_pool_.SetMaxNumBuffers(kMaxNumBuffersSerial);
+  }
 
   inited_ = true;
   // Always start with a complete key frame.
@@ -478,14 +498,22 @@ int VP9DecoderImpl::Decode(const EncodedImage& input_image,
   vpx_image_t* img;
   uint8_t* buffer = input_image._buffer;
   if (input_image._length == 0) {
-    buffer = NULL;  // Triggers full frame concealment.
-  }
+    // Triggers full frame concealment, except for a frame-parallel decoder,
+    // which treats it as a request to output every frame in its pipeline.
+    if (frame_parallel_)
+      return Flush();
+    buffer = NULL;
+  }
+  // The timestamp travels with the frame through libvpx, since a
+  // frame-parallel decoder outputs it during a later call.
+  void* user_priv =
+      reinterpret_cast<void*>(static_cast<uintptr_t>(input_image._timeStamp));
   // During decode libvpx may get and release buffers from |frame_buffer_pool_|.
   // In practice libvpx keeps a few (~3-4) buffers alive at a time.
   if (vpx_codec_decode(decoder_,
                        buffer,
                        static_cast<unsigned int>(input_image._length),
-                       0,
+                       user_priv,
                        VPX_DL_REALTIME)) {
     return WEBRTC_VIDEO_CODEC_ERROR;
   }
@@ -493,39 +521,51 @@ int VP9DecoderImpl::Decode(const EncodedImage& input_image,
   // It may be released by libvpx during future vpx_codec_decode or
   // vpx_codec_destroy calls.
   img = vpx_codec_get_frame(decoder_, &iter);
-  int ret = ReturnFrame(img, input_image._timeStamp);
-  if (ret != 0) {
-    return ret;
+  if (img == NULL) {
+    // Decoder OK and NULL image => No show frame, or, in frame-parallel mode,
+    // the frame is still being decoded.
+    return frame_parallel_ ? WEBRTC_VIDEO_CODEC_OK
+                           : WEBRTC_VIDEO_CODEC_NO_OUTPUT;
+  }
+  // A frame-parallel decoder may have completed several frames.
+  for (; img != NULL; img = vpx_codec_get_frame(decoder_, &iter)) {
+    int ret = ReturnFrame(img);
+    if (ret != 0)
+      return ret;
   }
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
-int VP9DecoderImpl::ReturnFrame(const vpx_image_t* img, uint32_t timestamp) {
-  if (img == NULL) {
-    // Decoder OK and NULL image => No show frame.
+int VP9DecoderImpl::Flush() {
+  if (vpx_codec_decode(decoder_, NULL, 0, NULL, VPX_DL_REALTIME))
+    return WEBRTC_VIDEO_CODEC_ERROR;
+  vpx_codec_iter_t iter = NULL;
+  vpx_image_t* img = vpx_codec_get_frame(decoder_, &iter);
+  if (img == NULL)
     return WEBRTC_VIDEO_CODEC_NO_OUTPUT;
+  for (; img != NULL; img = vpx_codec_get_frame(decoder_, &iter)) {
+    int ret = ReturnFrame(img);
+    if (ret != 0)
+      return ret;
   }
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
+int VP9DecoderImpl::ReturnFrame(const vpx_image_t* img) {
+  const uint32_t timestamp =
+      static_cast<uint32_t>(reinterpret_cast<uintptr_t>(img->user_priv));
 
   // This buffer contains all of |img|'s image data, a reference counted
-  // Vp9FrameBuffer. Performing AddRef/Release ensures it is not released and
-  // recycled during use (libvpx is done with the buffers after a few
-  // vpx_codec_decode calls or vpx_codec_destroy).
+  // Vp9FrameBuffer. Wrapping it keeps it from being recycled while the frame
+  // is in use (libvpx is done with the buffers after a few vpx_codec_decode
+  // calls or vpx_codec_destroy), so no copy is needed.
   Vp9FrameBufferPool::Vp9FrameBuffer* img_buffer =
       static_cast<Vp9FrameBufferPool::Vp9FrameBuffer*>(img->fb_priv);
-  img_buffer->AddRef();
-  // The buffer can be used directly by the VideoFrame (without copy) by
-  // using a WrappedI420Buffer.
-  rtc::scoped_refptr<WrappedI420Buffer> img_wrapped_buffer(
-      new rtc::RefCountedObject<webrtc::WrappedI420Buffer>(
-          img->d_w, img->d_h,
-          img->d_w, img->d_h,
-          img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
-          img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
-          img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V],
-          // WrappedI420Buffer's mechanism for allowing the release of its frame
-          // buffer is through a callback function. This is where we should
-          // release |img_buffer|.
-          rtc::Bind(&WrappedI420BufferNoLongerUsedCb, img_buffer)));
+  rtc::scoped_refptr<VideoFrameBuffer> img_wrapped_buffer =
+      img_buffer->WrapI420(img->d_w, img->d_h,
+                           img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y],
+                           img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U],
+                           img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V]);
 
   VideoFrame decoded_image;
   decoded_image.set_video_frame_buffer(img_wrapped_buffer);
@@ -544,6 +584,9 @@ int VP9DecoderImpl::RegisterDecodeCompleteCallback(
 
 int VP9DecoderImpl::Release() {
   if (decoder_ != NULL) {
+    // Deliver the frames still in the pipeline rather than dropping them.
+    if (inited_ && frame_parallel_ && decode_complete_callback_ != NULL)
+      Flush();
     // When a codec is destroyed libvpx will release any buffers of
     // |frame_buffer_pool_| it is currently using.
     if (vpx_codec_destroy(decoder_)) {
@@ -552,9 +595,8 @@ int VP9DecoderImpl::Release() {
     delete decoder_;
     decoder_ = NULL;
   }
-  // Releases buffers from the pool. Any buffers not in use are deleted. Buffers
-  // still referenced externally are deleted once fully released, not returning
-  // to the pool.
+  // Frees idle buffers of the shared pool. Buffers still referenced by decoded
+  // frames return to the pool once released.
   frame_buffer_pool_.ClearPool();
   inited_ = false;
   return WEBRTC_VIDEO_CODEC_OK;
@@ -81,7 +81,7 @@ class VP9EncoderImpl : public VP9Encoder {
 
 class VP9DecoderImpl : public VP9Decoder {
  public:
-  VP9DecoderImpl();
+  explicit VP9DecoderImpl(const VideoDecoderThreading& threading);
 
   virtual ~VP9DecoderImpl();
 
@@ -100,7 +100,9 @@ class VP9DecoderImpl : public VP9Decoder {
   int Reset() override;
 
  private:
-  int ReturnFrame(const vpx_image_t* img, uint32_t timeStamp);
+  int ReturnFrame(const vpx_image_t* img);
+  // Outputs the frames still being decoded by a frame-parallel decoder.
+  int Flush();
 
   // Memory pool used to share buffers between libvpx and webrtc.
   Vp9FrameBufferPool frame_buffer_pool_;
@@ -109,6 +111,10 @@ class VP9DecoderImpl : public VP9Decoder {
   vpx_codec_ctx_t* decoder_;
   VideoCodec codec_;
   bool key_frame_required_;
+  const VideoDecoderThreading threading_;
+  int number_of_cores_;
+  // True if libvpx decodes frames in parallel, see VideoDecoderThreading.
+  bool frame_parallel_;
 };
 }  // namespace webrtc
 
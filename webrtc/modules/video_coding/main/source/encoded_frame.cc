@@ -99,6 +99,7 @@ void VCMEncodedFrame::Reset()
     _codec = kVideoCodecUnknown;
     _rotation = kVideoRotation_0;
     _rotation_set = false;
+    qp_ = -1;
 }
 
 void VCMEncodedFrame::CopyCodecSpecific(const RTPVideoHeader* header)
@@ -74,6 +74,14 @@ public:
     */
     VideoRotation rotation() const { return _rotation; }
     /**
+    *   Set the QP of the frame
+    */
+    void SetQp(int qp) { qp_ = qp; }
+    /**
+    *   Get the QP of the frame, or -1 if it isn't known
+    */
+    int qp() const { return qp_; }
+    /**
     *   True if this frame is complete, false otherwise
     */
     bool Complete() const { return _completeFrame; }
@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
+
 #include "webrtc/modules/video_coding/main/interface/video_coding.h"
 #include "webrtc/modules/video_coding/main/source/generic_decoder.h"
 #include "webrtc/modules/video_coding/main/source/internal_defines.h"
@@ -24,6 +26,7 @@ _clock(clock),
 _receiveCallback(NULL),
 _timing(timing),
 _timestampMap(kDecoderFrameMemoryLength),
+_lastDecodeStartTimeMs(0),
 _lastReceivedPictureID(0)
 {
 }
@@ -51,11 +54,13 @@ int32_t VCMDecodedFrameCallback::Decoded(VideoFrame& decodedImage) {
     // callbacks from one call to Decode().
     VCMFrameInformation* frameInfo;
     VCMReceiveCallback* callback;
+    int64_t lastDecodeStartTimeMs;
     {
         CriticalSectionScoped cs(_critSect);
         frameInfo = static_cast<VCMFrameInformation*>(
             _timestampMap.Pop(decodedImage.timestamp()));
         callback = _receiveCallback;
+        lastDecodeStartTimeMs = _lastDecodeStartTimeMs;
     }
 
     if (frameInfo == NULL) {
@@ -64,9 +69,16 @@ int32_t VCMDecodedFrameCallback::Decoded(VideoFrame& decodedImage) {
       return WEBRTC_VIDEO_CODEC_OK;
     }
 
+    // A pipelined decoder outputs the frame during a later call to Decode().
+    // The time until that call is pipeline delay, the time spent in it is the
+    // decode time.
+    const int64_t decodeStartTimeMs =
+        std::max(frameInfo->decodeStartTimeMs, lastDecodeStartTimeMs);
+    _timing.set_decoder_pipeline_delay(static_cast<uint32_t>(
+        decodeStartTimeMs - frameInfo->decodeStartTimeMs));
     _timing.StopDecodeTimer(
         decodedImage.timestamp(),
-        frameInfo->decodeStartTimeMs,
+        decodeStartTimeMs,
         _clock->TimeInMilliseconds(),
         frameInfo->renderTimeMs);
 
@@ -106,6 +118,7 @@ uint64_t VCMDecodedFrameCallback::LastReceivedPictureID() const
 int32_t VCMDecodedFrameCallback::Map(uint32_t timestamp, VCMFrameInformation* frameInfo)
 {
     CriticalSectionScoped cs(_critSect);
+    _lastDecodeStartTimeMs = frameInfo->decodeStartTimeMs;
     return _timestampMap.Add(timestamp, frameInfo);
 }
 
@@ -171,6 +184,9 @@ int32_t VCMGenericDecoder::Decode(const VCMEncodedFrame& frame,
         // No output
         _callback->Pop(frame.TimeStamp());
     }
+    // Otherwise the frame information stays mapped until the decoder outputs
+    // the frame, which a frame-parallel decoder does during a later call or
+    // when it is flushed.
     return ret;
 }
 
@@ -56,6 +56,8 @@ private:
     VCMReceiveCallback* _receiveCallback;  // Guarded by |_critSect|.
     VCMTiming& _timing;
     VCMTimestampMap _timestampMap;  // Guarded by |_critSect|.
+    // Start time of the latest call to Decode(). Guarded by |_critSect|.
+    int64_t _lastDecodeStartTimeMs;
     uint64_t _lastReceivedPictureID;
 };
 
@@ -0,0 +1,166 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <deque>
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/modules/video_coding/main/interface/video_coding_defines.h"
+#include "webrtc/modules/video_coding/main/source/encoded_frame.h"
+#include "webrtc/modules/video_coding/main/source/generic_decoder.h"
+#include "webrtc/modules/video_coding/main/source/timing.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+
+namespace webrtc {
+namespace {
+
+const int kFrameIntervalMs = 33;
+const uint32_t kTimestampDelta = 90 * kFrameIntervalMs;
+const int64_t kStartTimeMs = 1000;
+const int64_t kRenderDelayMs = 100;
+
+// Outputs every frame |pipeline_depth| calls to Decode() after it was
+// submitted, like a frame-parallel decoder does.
+class PipelinedDecoder : public VideoDecoder {
+ public:
+  explicit PipelinedDecoder(size_t pipeline_depth)
+      : pipeline_depth_(pipeline_depth), callback_(NULL) {}
+
+  int32_t InitDecode(const VideoCodec* codec_settings,
+                     int32_t number_of_cores) override {
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Decode(const EncodedImage& input_image,
+                 bool missing_frames,
+                 const RTPFragmentationHeader* fragmentation,
+                 const CodecSpecificInfo* codec_specific_info,
+                 int64_t render_time_ms) override {
+    pending_.push_back(input_image._timeStamp);
+    if (pending_.size() <= pipeline_depth_)
+      return WEBRTC_VIDEO_CODEC_OK;
+    VideoFrame frame;
+    frame.CreateEmptyFrame(2, 2, 2, 1, 1);
+    frame.set_timestamp(pending_.front());
+    pending_.pop_front();
+    return callback_->Decoded(frame);
+  }
+
+  int32_t RegisterDecodeCompleteCallback(
+      DecodedImageCallback* callback) override {
+    callback_ = callback;
+    return WEBRTC_VIDEO_CODEC_OK;
+  }
+
+  int32_t Release() override { return WEBRTC_VIDEO_CODEC_OK; }
+  int32_t Reset() override { return WEBRTC_VIDEO_CODEC_OK; }
+
+ private:
+  const size_t pipeline_depth_;
+  DecodedImageCallback* callback_;
+  std::deque<uint32_t> pending_;
+};
+
+class FrameCollector : public VCMReceiveCallback {
+ public:
+  int32_t FrameToRender(VideoFrame& frame) override {
+    frames_.push_back(frame);
+    return 0;
+  }
+
+  const std::vector<VideoFrame>& frames() const { return frames_; }
+
+ private:
+  std::vector<VideoFrame> frames_;
+};
+
+class GenericDecoderTest : public ::testing::Test {
+ protected:
+  GenericDecoderTest()
+      : clock_(kStartTimeMs * 1000),
+        timing_(&clock_),
+        callback_(timing_, &clock_) {
+    callback_.SetUserReceiveCallback(&collector_);
+  }
+
+  // Decodes |num_frames| frames, one every |kFrameIntervalMs|, each to be
+  // rendered |kRenderDelayMs| after it was submitted.
+  void DecodeFrames(VCMGenericDecoder* decoder, int num_frames) {
+    for (int i = 0; i < num_frames; ++i) {
+      EncodedImage image;
+      image._timeStamp = static_cast<uint32_t>(i) * kTimestampDelta;
+      VCMEncodedFrame frame(image);
+      frame.SetRenderTime(clock_.TimeInMilliseconds() + kRenderDelayMs);
+      EXPECT_EQ(WEBRTC_VIDEO_CODEC_OK,
+                decoder->Decode(frame, clock_.TimeInMilliseconds()));
+      clock_.AdvanceTimeMilliseconds(kFrameIntervalMs);
+    }
+  }
+
+  SimulatedClock clock_;
+  VCMTiming timing_;
+  FrameCollector collector_;
+  VCMDecodedFrameCallback callback_;
+};
+
+}  // namespace
+
+TEST_F(GenericDecoderTest, DeliversFramesOutputByLaterDecodeCalls) {
+  const size_t kPipelineDepth = 3;
+  const int kNumFrames = 20;
+  PipelinedDecoder pipelined_decoder(kPipelineDepth);
+  VCMGenericDecoder decoder(pipelined_decoder);
+  decoder.RegisterDecodeCompleteCallback(&callback_);
+
+  DecodeFrames(&decoder, kNumFrames);
+
+  // Every frame but the ones still in the pipeline comes out in order, with
+  // the render time of the frame it was decoded from.
+  ASSERT_EQ(kNumFrames - kPipelineDepth, collector_.frames().size());
+  const int64_t first_render_time_ms = kStartTimeMs + kRenderDelayMs;
+  for (size_t i = 0; i < collector_.frames().size(); ++i) {
+    const VideoFrame& frame = collector_.frames()[i];
+    EXPECT_EQ(i * kTimestampDelta, frame.timestamp());
+    EXPECT_EQ(first_render_time_ms + static_cast<int64_t>(i) * kFrameIntervalMs,
+              frame.render_time_ms());
+  }
+}
+
+TEST_F(GenericDecoderTest, TargetDelayIncludesPipelineDelay) {
+  const size_t kPipelineDepth = 2;
+  PipelinedDecoder pipelined_decoder(kPipelineDepth);
+  VCMGenericDecoder decoder(pipelined_decoder);
+  decoder.RegisterDecodeCompleteCallback(&callback_);
+
+  DecodeFrames(&decoder, 20);
+
+  // Decoding takes no time, yet each frame waits for |kPipelineDepth| more
+  // frames to arrive before it is output. The timing must account for that
+  // as pipeline delay rather than as decode time.
+  int decode_ms, max_decode_ms, current_delay_ms, target_delay_ms,
+      jitter_buffer_ms, min_playout_delay_ms, render_delay_ms;
+  timing_.GetTimings(&decode_ms, &max_decode_ms, &current_delay_ms,
+                     &target_delay_ms, &jitter_buffer_ms, &min_playout_delay_ms,
+                     &render_delay_ms);
+  const int kPipelineDelayMs = static_cast<int>(kPipelineDepth) *
+                               kFrameIntervalMs;
+  EXPECT_EQ(0, decode_ms);
+  EXPECT_EQ(0, max_decode_ms);
+  EXPECT_EQ(kPipelineDelayMs + render_delay_ms, target_delay_ms);
+
+  // A frame must be given to the decoder early enough to leave the pipeline
+  // before it is rendered.
+  const int64_t render_time_ms = clock_.TimeInMilliseconds() + 200;
+  EXPECT_EQ(200u - kPipelineDelayMs - render_delay_ms,
+            timing_.MaxWaitingTime(render_time_ms,
+                                   clock_.TimeInMilliseconds()));
+}
+
+}  // namespace webrtc
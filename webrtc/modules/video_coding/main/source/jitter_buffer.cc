@@ -142,7 +142,7 @@ VCMJitterBuffer::VCMJitterBuffer(Clock* clock,
       nack_mode_(kNoNack),
       low_rtt_nack_threshold_ms_(-1),
       high_rtt_nack_threshold_ms_(-1),
-      missing_sequence_numbers_(SequenceNumberLessThan()),
+      missing_sequence_numbers_(NackBitmap::kMaxCapacity),
       max_nack_list_size_(0),
       max_packet_age_to_nack_(0),
       max_incomplete_time_ms_(0),
@@ -265,7 +265,7 @@ void VCMJitterBuffer::Flush() {
   waiting_for_completion_.timestamp = 0;
   waiting_for_completion_.latest_packet_time = -1;
   first_packet_since_reset_ = true;
-  missing_sequence_numbers_.clear();
+  missing_sequence_numbers_.Clear();
 }
 
 // Get received key and delta frames
@@ -487,6 +487,15 @@ VCMEncodedFrame* VCMJitterBuffer::ExtractAndSetDecode(uint32_t timestamp) {
   // decoder. Propagates the missing_frame bit.
   frame->PrepareForDecode(continuous);
 
+  // Slice headers refer to the SPS and PPS sent with earlier frames, so all
+  // H.264 frames go through the same parser, in decode order.
+  if (frame->CodecSpecific()->codecType == kVideoCodecH264) {
+    h264_bitstream_parser_.ParseBitstream(frame->Buffer(), frame->Length());
+    int qp;
+    if (h264_bitstream_parser_.GetLastSliceQp(&qp))
+      frame->SetQp(qp);
+  }
+
   // We have a frame - update the last decoded state and nack list.
   last_decoded_state_.SetState(frame);
   DropPacketsFromNackList(last_decoded_state_.sequence_num());
@@ -812,7 +821,7 @@ void VCMJitterBuffer::SetNackMode(VCMNackMode mode,
   CriticalSectionScoped cs(crit_sect_);
   nack_mode_ = mode;
   if (mode == kNoNack) {
-    missing_sequence_numbers_.clear();
+    missing_sequence_numbers_.Clear();
   }
   assert(low_rtt_nack_threshold_ms >= -1 && high_rtt_nack_threshold_ms >= -1);
   assert(high_rtt_nack_threshold_ms == -1 ||
@@ -921,8 +930,8 @@ std::vector<uint16_t> VCMJitterBuffer::GetNackList(bool* request_key_frame) {
       }
     }
   }
-  std::vector<uint16_t> nack_list(missing_sequence_numbers_.begin(),
-                                  missing_sequence_numbers_.end());
+  std::vector<uint16_t> nack_list;
+  missing_sequence_numbers_.GetSequenceNumbers(&nack_list);
   return nack_list;
 }
 
@@ -952,11 +961,12 @@ bool VCMJitterBuffer::UpdateNackList(uint16_t sequence_number) {
   if (IsNewerSequenceNumber(sequence_number,
                             latest_received_sequence_number_)) {
     // Push any missing sequence numbers to the NACK list.
-    for (uint16_t i = latest_received_sequence_number_ + 1;
-         IsNewerSequenceNumber(sequence_number, i); ++i) {
-      missing_sequence_numbers_.insert(missing_sequence_numbers_.end(), i);
-      TRACE_EVENT_INSTANT1(TRACE_DISABLED_BY_DEFAULT("webrtc_rtp"), "AddNack",
-                           "seqnum", i);
+    const uint16_t first_missing = latest_received_sequence_number_ + 1;
+    if (first_missing != sequence_number) {
+      missing_sequence_numbers_.AddMissing(first_missing, sequence_number);
+      TRACE_EVENT_INSTANT2(TRACE_DISABLED_BY_DEFAULT("webrtc_rtp"), "AddNack",
+                           "first_seqnum", first_missing,
+                           "last_seqnum", sequence_number - 1);
     }
     if (TooLargeNackList() && !HandleTooLargeNackList()) {
       LOG(LS_WARNING) << "Requesting key frame due to too large NACK list.";
@@ -968,7 +978,7 @@ bool VCMJitterBuffer::UpdateNackList(uint16_t sequence_number) {
       return false;
     }
   } else {
-    missing_sequence_numbers_.erase(sequence_number);
+    missing_sequence_numbers_.Remove(sequence_number);
     TRACE_EVENT_INSTANT1(TRACE_DISABLED_BY_DEFAULT("webrtc_rtp"), "RemoveNack",
                          "seqnum", sequence_number);
   }
@@ -998,7 +1008,7 @@ bool VCMJitterBuffer::MissingTooOldPacket(
     return false;
   }
   const uint16_t age_of_oldest_missing_packet = latest_sequence_number -
-      *missing_sequence_numbers_.begin();
+      missing_sequence_numbers_.Oldest();
   // Recycle frames if the NACK list contains too old sequence numbers as
   // the packets may have already been dropped by the sender.
   return age_of_oldest_missing_packet > max_packet_age_to_nack_;
@@ -1007,7 +1017,7 @@ bool VCMJitterBuffer::MissingTooOldPacket(
 bool VCMJitterBuffer::HandleTooOldPackets(uint16_t latest_sequence_number) {
   bool key_frame_found = false;
   const uint16_t age_of_oldest_missing_packet = latest_sequence_number -
-      *missing_sequence_numbers_.begin();
+      missing_sequence_numbers_.Oldest();
   LOG_F(LS_WARNING) << "NACK list contains too old sequence numbers: "
                     << age_of_oldest_missing_packet << " > "
                     << max_packet_age_to_nack_;
@@ -1021,9 +1031,7 @@ void VCMJitterBuffer::DropPacketsFromNackList(
     uint16_t last_decoded_sequence_number) {
   // Erase all sequence numbers from the NACK list which we won't need any
   // longer.
-  missing_sequence_numbers_.erase(missing_sequence_numbers_.begin(),
-                                  missing_sequence_numbers_.upper_bound(
-                                      last_decoded_sequence_number));
+  missing_sequence_numbers_.RemoveUpTo(last_decoded_sequence_number);
 }
 
 int64_t VCMJitterBuffer::LastDecodedTimestamp() const {
@@ -1097,7 +1105,7 @@ bool VCMJitterBuffer::RecycleFramesUntilKeyFrame() {
     // All frames dropped. Reset the decoding state and clear missing sequence
     // numbers as we're starting fresh.
     last_decoded_state_.Reset();
-    missing_sequence_numbers_.clear();
+    missing_sequence_numbers_.Clear();
   }
   return key_frame_found;
 }
@@ -1156,8 +1164,7 @@ void VCMJitterBuffer::CleanUpOldOrEmptyFrames() {
 
 // Must be called from within |crit_sect_|.
 bool VCMJitterBuffer::IsPacketRetransmitted(const VCMPacket& packet) const {
-  return missing_sequence_numbers_.find(packet.seqNum) !=
-      missing_sequence_numbers_.end();
+  return missing_sequence_numbers_.Contains(packet.seqNum);
 }
 
 // Must be called under the critical section |crit_sect_|. Should never be
@@ -13,18 +13,19 @@
 
 #include <list>
 #include <map>
-#include <set>
 #include <vector>
 
 #include "webrtc/base/constructormagic.h"
 #include "webrtc/base/thread_annotations.h"
 #include "webrtc/modules/interface/module_common_types.h"
+#include "webrtc/modules/interface/nack_bitmap.h"
 #include "webrtc/modules/video_coding/main/interface/video_coding.h"
 #include "webrtc/modules/video_coding/main/interface/video_coding_defines.h"
 #include "webrtc/modules/video_coding/main/source/decoding_state.h"
 #include "webrtc/modules/video_coding/main/source/inter_frame_delay.h"
 #include "webrtc/modules/video_coding/main/source/jitter_buffer_common.h"
 #include "webrtc/modules/video_coding/main/source/jitter_estimator.h"
+#include "webrtc/modules/video_coding/utility/include/h264_bitstream_parser.h"
 #include "webrtc/system_wrappers/interface/critical_section_wrapper.h"
 #include "webrtc/typedefs.h"
 
@@ -187,15 +188,6 @@ class VCMJitterBuffer {
   void RegisterStatsCallback(VCMReceiveStatisticsCallback* callback);
 
  private:
-  class SequenceNumberLessThan {
-   public:
-    bool operator() (const uint16_t& sequence_number1,
-                     const uint16_t& sequence_number2) const {
-      return IsNewerSequenceNumber(sequence_number2, sequence_number1);
-    }
-  };
-  typedef std::set<uint16_t, SequenceNumberLessThan> SequenceNumberSet;
-
   // Gets the frame assigned to the timestamp of the packet. May recycle
   // existing frames if no free frames are available. Returns an error code if
   // failing, or kNoError on success. |frame_list| contains which list the
@@ -307,6 +299,8 @@ class VCMJitterBuffer {
   FrameList incomplete_frames_ GUARDED_BY(crit_sect_);
   VCMDecodingState last_decoded_state_ GUARDED_BY(crit_sect_);
   bool first_packet_since_reset_;
+  // Reads the QP of H.264 frames as they are extracted for decoding.
+  H264BitstreamParser h264_bitstream_parser_ GUARDED_BY(crit_sect_);
 
   // Statistics.
   VCMReceiveStatisticsCallback* stats_callback_ GUARDED_BY(crit_sect_);
@@ -344,7 +338,7 @@ class VCMJitterBuffer {
   int64_t low_rtt_nack_threshold_ms_;
   int64_t high_rtt_nack_threshold_ms_;
   // Holds the internal NACK list (the missing sequence numbers).
-  SequenceNumberSet missing_sequence_numbers_;
+  NackBitmap missing_sequence_numbers_;
   uint16_t latest_received_sequence_number_;
   size_t max_nack_list_size_;
   int max_packet_age_to_nack_;  // Measured in sequence numbers.
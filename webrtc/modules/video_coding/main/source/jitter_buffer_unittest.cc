@@ -738,6 +738,40 @@ TEST_F(TestBasicJitterBuffer, H264InsertStartCode) {
   jitter_buffer_->ReleaseFrame(frame_out);
 }
 
+TEST_F(TestBasicJitterBuffer, H264FrameQp) {
+  // SPS, PPS and an IDR slice with a QP of 25.
+  uint8_t key_frame[] = {
+      0x67, 0x42, 0x00, 0x28, 0xed, 0x00, 0xf0, 0x04, 0x4c, 0x80,
+      0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x04, 0xf2,
+      0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00, 0xcb, 0x4b, 0x50};
+  VCMPacket packet(key_frame, sizeof(key_frame), seq_num_, timestamp_, true);
+  packet.frameType = kVideoFrameKey;
+  packet.isFirstPacket = true;
+  packet.insertStartCode = true;
+  packet.codec = kVideoCodecH264;
+  packet.codecSpecificHeader.codec = kRtpVideoH264;
+
+  bool retransmitted = false;
+  EXPECT_EQ(kCompleteSession, jitter_buffer_->InsertPacket(packet,
+                                                           &retransmitted));
+  VCMEncodedFrame* frame_out = DecodeCompleteFrame();
+  ASSERT_TRUE(frame_out != NULL);
+  EXPECT_EQ(25, frame_out->qp());
+  jitter_buffer_->ReleaseFrame(frame_out);
+
+  // The QP of frames of other codecs isn't known.
+  packet_->seqNum = ++seq_num_;
+  packet_->timestamp = timestamp_ += 3000;
+  packet_->frameType = kVideoFrameDelta;
+  packet_->isFirstPacket = true;
+  EXPECT_EQ(kCompleteSession, jitter_buffer_->InsertPacket(*packet_,
+                                                           &retransmitted));
+  frame_out = DecodeCompleteFrame();
+  ASSERT_TRUE(frame_out != NULL);
+  EXPECT_EQ(-1, frame_out->qp());
+  jitter_buffer_->ReleaseFrame(frame_out);
+}
+
 // Test threshold conditions of decodable state.
 TEST_F(TestBasicJitterBuffer, PacketLossWithSelectiveErrorsThresholdCheck) {
   jitter_buffer_->SetDecodeErrorMode(kSelectiveErrors);
@@ -27,6 +27,7 @@ VCMTiming::VCMTiming(Clock* clock,
       ts_extrapolator_(),
       codec_timer_(),
       render_delay_ms_(kDefaultRenderDelayMs),
+      decoder_pipeline_delay_ms_(0),
       min_playout_delay_ms_(0),
       jitter_delay_ms_(0),
       current_delay_ms_(0),
@@ -78,6 +79,7 @@ void VCMTiming::Reset() {
   ts_extrapolator_->Reset(clock_->TimeInMilliseconds());
   codec_timer_.Reset();
   render_delay_ms_ = kDefaultRenderDelayMs;
+  decoder_pipeline_delay_ms_ = 0;
   min_playout_delay_ms_ = 0;
   jitter_delay_ms_ = 0;
   current_delay_ms_ = 0;
@@ -94,6 +96,11 @@ void VCMTiming::set_render_delay(uint32_t render_delay_ms) {
   render_delay_ms_ = render_delay_ms;
 }
 
+void VCMTiming::set_decoder_pipeline_delay(uint32_t pipeline_delay_ms) {
+  CriticalSectionScoped cs(crit_sect_);
+  decoder_pipeline_delay_ms_ = pipeline_delay_ms;
+}
+
 void VCMTiming::set_min_playout_delay(uint32_t min_playout_delay_ms) {
   CriticalSectionScoped cs(crit_sect_);
   min_playout_delay_ms_ = min_playout_delay_ms;
@@ -153,7 +160,8 @@ void VCMTiming::UpdateCurrentDelay(int64_t render_time_ms,
   CriticalSectionScoped cs(crit_sect_);
   uint32_t target_delay_ms = TargetDelayInternal();
   int64_t delayed_ms = actual_decode_time_ms -
-      (render_time_ms - MaxDecodeTimeMs() - render_delay_ms_);
+      (render_time_ms - MaxDecodeTimeMs() - decoder_pipeline_delay_ms_ -
+       render_delay_ms_);
   if (delayed_ms < 0) {
     return;
   }
@@ -224,7 +232,7 @@ uint32_t VCMTiming::MaxWaitingTime(int64_t render_time_ms, int64_t now_ms)
   CriticalSectionScoped cs(crit_sect_);
 
   const int64_t max_wait_time_ms = render_time_ms - now_ms -
-      MaxDecodeTimeMs() - render_delay_ms_;
+      MaxDecodeTimeMs() - decoder_pipeline_delay_ms_ - render_delay_ms_;
 
   if (max_wait_time_ms < 0) {
     return 0;
@@ -256,7 +264,8 @@ uint32_t VCMTiming::TargetVideoDelay() const {
 
 uint32_t VCMTiming::TargetDelayInternal() const {
   return std::max(min_playout_delay_ms_,
-      jitter_delay_ms_ + MaxDecodeTimeMs() + render_delay_ms_);
+      jitter_delay_ms_ + MaxDecodeTimeMs() + decoder_pipeline_delay_ms_ +
+      render_delay_ms_);
 }
 
 void VCMTiming::GetTimings(int* decode_ms,
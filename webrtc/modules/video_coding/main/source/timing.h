@@ -55,6 +55,11 @@ class VCMTiming {
   void UpdateCurrentDelay(int64_t render_time_ms,
                           int64_t actual_decode_time_ms);
 
+  // Set the time a frame waits in a pipelined (frame-parallel) decoder for
+  // the frames submitted after it, on top of its decode time. Zero for
+  // decoders that output every frame from the Decode() call it was given to.
+  void set_decoder_pipeline_delay(uint32_t pipeline_delay_ms);
+
   // Stops the decoder timer, should be called when the decoder returns a frame
   // or when the decoded frame callback is called.
   int32_t StopDecodeTimer(uint32_t time_stamp,
@@ -75,7 +80,7 @@ class VCMTiming {
   uint32_t MaxWaitingTime(int64_t render_time_ms, int64_t now_ms) const;
 
   // Returns the current target delay which is required delay + decode time +
-  // render delay.
+  // decoder pipeline delay + render delay.
   uint32_t TargetVideoDelay() const;
 
   // Calculates whether or not there is enough time to decode a frame given a
@@ -110,6 +115,7 @@ class VCMTiming {
   TimestampExtrapolator* ts_extrapolator_ GUARDED_BY(crit_sect_);
   VCMCodecTimer codec_timer_ GUARDED_BY(crit_sect_);
   uint32_t render_delay_ms_ GUARDED_BY(crit_sect_);
+  uint32_t decoder_pipeline_delay_ms_ GUARDED_BY(crit_sect_);
   uint32_t min_playout_delay_ms_ GUARDED_BY(crit_sect_);
   uint32_t jitter_delay_ms_ GUARDED_BY(crit_sect_);
   uint32_t current_delay_ms_ GUARDED_BY(crit_sect_);
@@ -0,0 +1,174 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/utility/include/decoder_buffer_pool.h"
+
+#include "webrtc/base/bind.h"
+#include "webrtc/base/checks.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+#include "webrtc/system_wrappers/interface/logging.h"
+
+namespace webrtc {
+
+namespace {
+
+const size_t kBufferAlignment = 64;
+// Smallest bucket; anything smaller isn't worth pooling separately.
+const size_t kMinBucketSize = 4096;
+// How often GetBuffer() looks for idle buffers.
+const int64_t kTrimIntervalMs = 1000;
+
+void ReleaseBuffer(DecoderBufferPool::Buffer* buffer) {
+  buffer->Release();
+}
+
+}  // namespace
+
+const int64_t DecoderBufferPool::kIdleTimeoutMs = 10000;
+
+DecoderBufferPool::Buffer::Buffer(size_t capacity)
+    : capacity_(capacity),
+      size_(0),
+      last_use_ms_(0),
+      data_(static_cast<uint8_t*>(AlignedMalloc(capacity, kBufferAlignment))) {
+}
+
+rtc::scoped_refptr<VideoFrameBuffer> DecoderBufferPool::Buffer::WrapI420(
+    int width,
+    int height,
+    const uint8_t* y_plane,
+    int y_stride,
+    const uint8_t* u_plane,
+    int u_stride,
+    const uint8_t* v_plane,
+    int v_stride) {
+  DCHECK(y_plane >= data() && y_plane < data() + size_);
+  // Released by the WrappedI420Buffer when it is destroyed.
+  AddRef();
+  return new rtc::RefCountedObject<WrappedI420Buffer>(
+      width, height, width, height, y_plane, y_stride, u_plane, u_stride,
+      v_plane, v_stride, rtc::Bind(&ReleaseBuffer, this));
+}
+
+// static
+DecoderBufferPool* DecoderBufferPool::Shared() {
+  static DecoderBufferPool* const pool =
+      new DecoderBufferPool(Clock::GetRealTimeClock());
+  return pool;
+}
+
+DecoderBufferPool::DecoderBufferPool(Clock* clock)
+    : clock_(clock),
+      allocated_bytes_(0),
+      max_allocated_bytes_(0),
+      last_trim_ms_(clock->TimeInMilliseconds()) {
+}
+
+DecoderBufferPool::~DecoderBufferPool() {
+  DCHECK_EQ(0u, GetStats().num_buffers_in_use);
+}
+
+// static
+size_t DecoderBufferPool::BucketSize(size_t size) {
+  size_t bucket = kMinBucketSize;
+  while (bucket < size)
+    bucket *= 2;
+  if (bucket == kMinBucketSize)
+    return bucket;
+  // Split every doubling into four steps, so that at most a fifth of a buffer
+  // is wasted while frames of similar sizes still share buckets.
+  const size_t step = bucket / 8;
+  bucket /= 2;
+  while (bucket < size)
+    bucket += step;
+  return bucket;
+}
+
+rtc::scoped_refptr<DecoderBufferPool::Buffer> DecoderBufferPool::GetBuffer(
+    size_t min_size) {
+  DCHECK_GT(min_size, 0u);
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  const size_t capacity = BucketSize(min_size);
+  rtc::scoped_refptr<Buffer> buffer;
+  rtc::CritScope cs(&buffers_lock_);
+  if (now_ms - last_trim_ms_ >= kTrimIntervalMs)
+    TrimIdleBuffersLocked(now_ms);
+
+  BufferList& bucket = buckets_[capacity];
+  for (const rtc::scoped_refptr<Buffer>& candidate : bucket) {
+    // Only the pool references free buffers.
+    if (candidate->HasOneRef()) {
+      buffer = candidate;
+      break;
+    }
+  }
+  if (!buffer) {
+    buffer = new rtc::RefCountedObject<Buffer>(capacity);
+    bucket.push_back(buffer);
+    allocated_bytes_ += capacity;
+    if (allocated_bytes_ > max_allocated_bytes_)
+      max_allocated_bytes_ = allocated_bytes_;
+  }
+  buffer->size_ = min_size;
+  buffer->last_use_ms_ = now_ms;
+  return buffer;
+}
+
+void DecoderBufferPool::TrimIdleBuffers() {
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  rtc::CritScope cs(&buffers_lock_);
+  TrimIdleBuffersLocked(now_ms);
+}
+
+void DecoderBufferPool::TrimIdleBuffersLocked(int64_t now_ms) {
+  last_trim_ms_ = now_ms;
+  const size_t allocated_bytes_before = allocated_bytes_;
+  for (auto bucket = buckets_.begin(); bucket != buckets_.end();) {
+    BufferList& buffers = bucket->second;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+      if ((*it)->HasOneRef() &&
+          now_ms - (*it)->last_use_ms_ >= kIdleTimeoutMs) {
+        allocated_bytes_ -= (*it)->capacity();
+        it = buffers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (buffers.empty())
+      bucket = buckets_.erase(bucket);
+    else
+      ++bucket;
+  }
+  if (allocated_bytes_ != allocated_bytes_before) {
+    LOG(LS_INFO) << "Freed " << allocated_bytes_before - allocated_bytes_
+                 << " bytes of idle decoder buffers, " << allocated_bytes_
+                 << " bytes remain allocated (peak " << max_allocated_bytes_
+                 << " bytes).";
+  }
+}
+
+DecoderBufferPool::Stats DecoderBufferPool::GetStats() const {
+  Stats stats;
+  rtc::CritScope cs(&buffers_lock_);
+  for (const auto& bucket : buckets_) {
+    for (const rtc::scoped_refptr<Buffer>& buffer : bucket.second) {
+      ++stats.num_buffers;
+      if (!buffer->HasOneRef()) {
+        ++stats.num_buffers_in_use;
+        stats.in_use_bytes += buffer->capacity();
+      }
+    }
+  }
+  stats.allocated_bytes = allocated_bytes_;
+  stats.max_allocated_bytes = max_allocated_bytes_;
+  return stats;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,130 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/utility/include/decoder_buffer_pool.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/system_wrappers/interface/clock.h"
+
+namespace webrtc {
+
+class DecoderBufferPoolTest : public ::testing::Test {
+ protected:
+  DecoderBufferPoolTest() : clock_(0), pool_(&clock_) {}
+
+  SimulatedClock clock_;
+  DecoderBufferPool pool_;
+};
+
+TEST_F(DecoderBufferPoolTest, RecyclesReleasedBuffer) {
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer = pool_.GetBuffer(1000);
+  EXPECT_EQ(1000u, buffer->size());
+  EXPECT_GE(buffer->capacity(), 1000u);
+  uint8_t* data = buffer->data();
+  buffer = nullptr;
+  buffer = pool_.GetBuffer(1000);
+  EXPECT_EQ(data, buffer->data());
+  EXPECT_EQ(1u, pool_.GetStats().num_buffers);
+}
+
+TEST_F(DecoderBufferPoolTest, DoesNotRecycleBufferInUse) {
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer1 =
+      pool_.GetBuffer(1000);
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer2 =
+      pool_.GetBuffer(1000);
+  EXPECT_NE(buffer1->data(), buffer2->data());
+
+  DecoderBufferPool::Stats stats = pool_.GetStats();
+  EXPECT_EQ(2u, stats.num_buffers);
+  EXPECT_EQ(2u, stats.num_buffers_in_use);
+  EXPECT_EQ(stats.allocated_bytes, stats.in_use_bytes);
+}
+
+TEST_F(DecoderBufferPoolTest, SimilarSizesShareBucket) {
+  const size_t kFrameSize = 640 * 480 * 3 / 2;
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer =
+      pool_.GetBuffer(kFrameSize);
+  uint8_t* data = buffer->data();
+  buffer = nullptr;
+  // A slightly larger frame fits in the same bucket.
+  buffer = pool_.GetBuffer(kFrameSize + 100);
+  EXPECT_EQ(data, buffer->data());
+  EXPECT_GE(buffer->capacity(), kFrameSize + 100);
+  // At most a fifth of a buffer is wasted.
+  EXPECT_LE(buffer->capacity(), (kFrameSize + 100) * 5 / 4);
+
+  // A frame twice as large does not.
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> large_buffer =
+      pool_.GetBuffer(2 * kFrameSize);
+  EXPECT_NE(data, large_buffer->data());
+}
+
+TEST_F(DecoderBufferPoolTest, WrappedFrameKeepsBufferInUse) {
+  const int kWidth = 16;
+  const int kHeight = 8;
+  const size_t kSizeY = kWidth * kHeight;
+  const size_t kSizeUv = (kWidth / 2) * (kHeight / 2);
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer =
+      pool_.GetBuffer(kSizeY + 2 * kSizeUv);
+  uint8_t* y_plane = buffer->data();
+  uint8_t* u_plane = y_plane + kSizeY;
+  uint8_t* v_plane = u_plane + kSizeUv;
+  rtc::scoped_refptr<VideoFrameBuffer> frame_buffer = buffer->WrapI420(
+      kWidth, kHeight, y_plane, kWidth, u_plane, kWidth / 2, v_plane,
+      kWidth / 2);
+  buffer = nullptr;
+
+  EXPECT_EQ(kWidth, frame_buffer->width());
+  EXPECT_EQ(kHeight, frame_buffer->height());
+  const VideoFrameBuffer* const_frame_buffer = frame_buffer.get();
+  EXPECT_EQ(y_plane, const_frame_buffer->data(kYPlane));
+  EXPECT_EQ(v_plane, const_frame_buffer->data(kVPlane));
+  EXPECT_EQ(kWidth / 2, frame_buffer->stride(kUPlane));
+  // The frame holds the buffer, so a new one is allocated.
+  EXPECT_EQ(1u, pool_.GetStats().num_buffers_in_use);
+  EXPECT_NE(y_plane, pool_.GetBuffer(kSizeY + 2 * kSizeUv)->data());
+
+  frame_buffer = nullptr;
+  EXPECT_EQ(0u, pool_.GetStats().num_buffers_in_use);
+  EXPECT_EQ(y_plane, pool_.GetBuffer(kSizeY + 2 * kSizeUv)->data());
+}
+
+TEST_F(DecoderBufferPoolTest, TrimsIdleBuffers) {
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> idle_buffer =
+      pool_.GetBuffer(100000);
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> busy_buffer =
+      pool_.GetBuffer(100000);
+  const size_t capacity = idle_buffer->capacity();
+  idle_buffer = nullptr;
+
+  clock_.AdvanceTimeMilliseconds(DecoderBufferPool::kIdleTimeoutMs - 1);
+  pool_.TrimIdleBuffers();
+  EXPECT_EQ(2u, pool_.GetStats().num_buffers);
+
+  clock_.AdvanceTimeMilliseconds(1);
+  pool_.TrimIdleBuffers();
+  // Buffers in use are never freed, however long ago they were handed out.
+  DecoderBufferPool::Stats stats = pool_.GetStats();
+  EXPECT_EQ(1u, stats.num_buffers);
+  EXPECT_EQ(1u, stats.num_buffers_in_use);
+  EXPECT_EQ(capacity, stats.allocated_bytes);
+  EXPECT_EQ(2 * capacity, stats.max_allocated_bytes);
+}
+
+TEST_F(DecoderBufferPoolTest, GetBufferTrimsPeriodically) {
+  pool_.GetBuffer(100000);
+  clock_.AdvanceTimeMilliseconds(DecoderBufferPool::kIdleTimeoutMs);
+  // Buffers of another size are trimmed while getting this one.
+  rtc::scoped_refptr<DecoderBufferPool::Buffer> buffer = pool_.GetBuffer(1000);
+  EXPECT_EQ(1u, pool_.GetStats().num_buffers);
+  EXPECT_EQ(buffer->capacity(), pool_.GetStats().allocated_bytes);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,608 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/utility/include/h264_bitstream_parser.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "webrtc/base/bitbuffer.h"
+
+#define RETURN_FALSE_ON_FAIL(x) \
+  if (!(x)) {                   \
+    return false;               \
+  }
+
+namespace webrtc {
+namespace {
+
+// Section and table numbers below refer to the 02/2014 version of the H.264
+// standard, http://www.itu.int/rec/T-REC-H.264.
+
+enum NaluType { kSlice = 1, kIdr = 5, kSps = 7, kPps = 8 };
+// Table 7-6, modulo 5.
+enum SliceType {
+  kSliceP = 0,
+  kSliceB = 1,
+  kSliceI = 2,
+  kSliceSp = 3,
+  kSliceSi = 4
+};
+
+const uint8_t kNaluTypeMask = 0x1F;
+const uint8_t kNalRefIdcMask = 0x60;
+const size_t kNaluHeaderSize = 1;
+
+// Slice headers are much shorter than this, except for the odd one with a
+// long prediction weight table, so only this much of a slice is unescaped
+// before trying to parse its header.
+const size_t kSliceHeaderPrefixSize = 256;
+
+// Limits from section 7.4.2.
+const uint32_t kMaxSpsId = 31;
+const uint32_t kMaxPpsId = 255;
+const uint32_t kMaxLog2Minus4 = 12;
+const uint32_t kMaxNumSliceGroupsMinus1 = 7;
+const uint32_t kMaxNumRefFramesInPicOrderCntCycle = 255;
+const uint32_t kMaxNumRefIdxActiveMinus1 = 31;
+
+// Returns the first position at which |start| to |end| holds the bytes 0x00,
+// 0x00, |third_byte|, or |end| if there is none. Zero bytes are rare in
+// entropy coded data, so the memchr() of the C library, which compares many
+// bytes at a time, skips over most of the buffer.
+const uint8_t* FindZeroZeroSequence(const uint8_t* start,
+                                    const uint8_t* end,
+                                    uint8_t third_byte) {
+  const uint8_t* position = start;
+  while (end - position >= 3) {
+    position = static_cast<const uint8_t*>(
+        memchr(position, 0, end - position - 2));
+    if (position == NULL)
+      return end;
+    if (position[1] != 0) {
+      position += 2;
+    } else if (position[2] == third_byte) {
+      return position;
+    } else {
+      ++position;
+    }
+  }
+  return end;
+}
+
+// scaling_list(), section 7.3.2.1.1.1.
+bool SkipScalingList(rtc::BitBuffer* parser, size_t size_of_scaling_list) {
+  int32_t last_scale = 8;
+  int32_t next_scale = 8;
+  for (size_t j = 0; j < size_of_scaling_list; ++j) {
+    if (next_scale != 0) {
+      int32_t delta_scale;
+      RETURN_FALSE_ON_FAIL(parser->ReadSignedExponentialGolomb(&delta_scale));
+      next_scale = (last_scale + delta_scale + 256) % 256;
+    }
+    if (next_scale != 0)
+      last_scale = next_scale;
+  }
+  return true;
+}
+
+// ref_pic_list_modification() for one list, section 7.3.3.1.
+bool SkipRefPicListModification(rtc::BitBuffer* parser) {
+  uint32_t ref_pic_list_modification_flag;
+  RETURN_FALSE_ON_FAIL(parser->ReadBits(&ref_pic_list_modification_flag, 1));
+  if (!ref_pic_list_modification_flag)
+    return true;
+  uint32_t modification_of_pic_nums_idc;
+  do {
+    RETURN_FALSE_ON_FAIL(
+        parser->ReadExponentialGolomb(&modification_of_pic_nums_idc));
+    if (modification_of_pic_nums_idc <= 2) {
+      // abs_diff_pic_num_minus1 or long_term_pic_num: ue(v)
+      uint32_t golomb_ignored;
+      RETURN_FALSE_ON_FAIL(parser->ReadExponentialGolomb(&golomb_ignored));
+    } else if (modification_of_pic_nums_idc != 3) {
+      // Values above 3 are only used by the MVC extension.
+      return false;
+    }
+  } while (modification_of_pic_nums_idc != 3);
+  return true;
+}
+
+// The weights of one list in pred_weight_table(), section 7.3.3.2.
+bool SkipPredWeights(rtc::BitBuffer* parser,
+                     uint32_t chroma_array_type,
+                     uint32_t num_ref_idx_active_minus1) {
+  int32_t signed_golomb_ignored;
+  for (uint32_t i = 0; i <= num_ref_idx_active_minus1; ++i) {
+    uint32_t luma_weight_flag;
+    RETURN_FALSE_ON_FAIL(parser->ReadBits(&luma_weight_flag, 1));
+    if (luma_weight_flag) {
+      // luma_weight and luma_offset: se(v)
+      RETURN_FALSE_ON_FAIL(
+          parser->ReadSignedExponentialGolomb(&signed_golomb_ignored));
+      RETURN_FALSE_ON_FAIL(
+          parser->ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    }
+    if (chroma_array_type != 0) {
+      uint32_t chroma_weight_flag;
+      RETURN_FALSE_ON_FAIL(parser->ReadBits(&chroma_weight_flag, 1));
+      if (chroma_weight_flag) {
+        // chroma_weight and chroma_offset for both chroma planes: se(v)
+        for (int j = 0; j < 4; ++j) {
+          RETURN_FALSE_ON_FAIL(
+              parser->ReadSignedExponentialGolomb(&signed_golomb_ignored));
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+H264BitstreamParser::SpsState::SpsState()
+    : chroma_array_type(1),
+      separate_colour_plane_flag(0),
+      log2_max_frame_num_minus4(0),
+      pic_order_cnt_type(0),
+      log2_max_pic_order_cnt_lsb_minus4(0),
+      delta_pic_order_always_zero_flag(0),
+      frame_mbs_only_flag(0) {}
+
+H264BitstreamParser::PpsState::PpsState()
+    : sps_id(0),
+      entropy_coding_mode_flag(0),
+      bottom_field_pic_order_in_frame_present_flag(0),
+      num_ref_idx_l0_default_active_minus1(0),
+      num_ref_idx_l1_default_active_minus1(0),
+      weighted_pred_flag(0),
+      weighted_bipred_idc(0),
+      pic_init_qp_minus26(0),
+      redundant_pic_cnt_present_flag(0) {}
+
+std::vector<H264BitstreamParser::NaluIndex>
+H264BitstreamParser::FindNaluIndices(const uint8_t* buffer, size_t length) {
+  std::vector<NaluIndex> indices;
+  const uint8_t* const end = buffer + length;
+  const uint8_t* start_code = FindZeroZeroSequence(buffer, end, 1);
+  while (start_code != end) {
+    NaluIndex index;
+    index.offset = start_code + 3 - buffer;
+    start_code = FindZeroZeroSequence(buffer + index.offset, end, 1);
+    // Drop the zero byte of a four byte start code, and any trailing zeros,
+    // from the end of the NAL unit.
+    size_t nalu_end = start_code - buffer;
+    while (nalu_end > index.offset && buffer[nalu_end - 1] == 0)
+      --nalu_end;
+    index.length = nalu_end - index.offset;
+    indices.push_back(index);
+  }
+  return indices;
+}
+
+void H264BitstreamParser::ParseRbsp(const uint8_t* data,
+                                    size_t length,
+                                    std::vector<uint8_t>* rbsp) {
+  // Section 7.4.1: the 0x03 of every 0x00 0x00 0x03 is an emulation prevention
+  // byte, which is dropped.
+  rbsp->clear();
+  rbsp->reserve(length);
+  const uint8_t* const end = data + length;
+  const uint8_t* run_start = data;
+  while (run_start != end) {
+    const uint8_t* emulation = FindZeroZeroSequence(run_start, end, 3);
+    if (emulation == end) {
+      rbsp->insert(rbsp->end(), run_start, end);
+      break;
+    }
+    rbsp->insert(rbsp->end(), run_start, emulation + 2);
+    run_start = emulation + 3;
+  }
+}
+
+H264BitstreamParser::H264BitstreamParser()
+    : last_slice_qp_valid_(false), last_slice_qp_(0) {}
+
+H264BitstreamParser::~H264BitstreamParser() {}
+
+void H264BitstreamParser::ParseBitstream(const uint8_t* bitstream,
+                                         size_t length) {
+  last_slice_qp_valid_ = false;
+  std::vector<NaluIndex> indices = FindNaluIndices(bitstream, length);
+  for (const NaluIndex& index : indices) {
+    if (index.length <= kNaluHeaderSize)
+      continue;
+    const uint8_t nalu_header = bitstream[index.offset];
+    const uint8_t* payload = bitstream + index.offset + kNaluHeaderSize;
+    const size_t payload_length = index.length - kNaluHeaderSize;
+    switch (nalu_header & kNaluTypeMask) {
+      case kSps:
+        ParseRbsp(payload, payload_length, &rbsp_buffer_);
+        ParseSps(&rbsp_buffer_[0], rbsp_buffer_.size());
+        break;
+      case kPps:
+        ParseRbsp(payload, payload_length, &rbsp_buffer_);
+        ParsePps(&rbsp_buffer_[0], rbsp_buffer_.size());
+        break;
+      case kSlice:
+      case kIdr:
+        // Only the header is parsed, so try not to unescape the whole slice.
+        ParseRbsp(payload, std::min(payload_length, kSliceHeaderPrefixSize),
+                  &rbsp_buffer_);
+        if (!ParseSlice(nalu_header, &rbsp_buffer_[0], rbsp_buffer_.size()) &&
+            payload_length > kSliceHeaderPrefixSize) {
+          ParseRbsp(payload, payload_length, &rbsp_buffer_);
+          ParseSlice(nalu_header, &rbsp_buffer_[0], rbsp_buffer_.size());
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+bool H264BitstreamParser::GetLastSliceQp(int* qp) const {
+  if (!last_slice_qp_valid_)
+    return false;
+  *qp = last_slice_qp_;
+  return true;
+}
+
+bool H264BitstreamParser::ParseSps(const uint8_t* rbsp, size_t length) {
+  // Section 7.3.2.1.1, seq_parameter_set_data(), up to frame_mbs_only_flag.
+  rtc::BitBuffer parser(rbsp, length);
+  SpsState sps;
+  uint32_t golomb_ignored;
+  int32_t signed_golomb_ignored;
+
+  // profile_idc: u(8)
+  uint8_t profile_idc;
+  RETURN_FALSE_ON_FAIL(parser.ReadUInt8(&profile_idc));
+  // constraint_set0_flag through reserved_zero_2bits, and level_idc: u(8) each
+  RETURN_FALSE_ON_FAIL(parser.ConsumeBytes(2));
+  // seq_parameter_set_id: ue(v)
+  uint32_t sps_id;
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&sps_id));
+  RETURN_FALSE_ON_FAIL(sps_id <= kMaxSpsId);
+  uint32_t chroma_format_idc = 1;
+  if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 ||
+      profile_idc == 244 || profile_idc == 44 || profile_idc == 83 ||
+      profile_idc == 86 || profile_idc == 118 || profile_idc == 128 ||
+      profile_idc == 138 || profile_idc == 139 || profile_idc == 134) {
+    // chroma_format_idc: ue(v)
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&chroma_format_idc));
+    if (chroma_format_idc == 3) {
+      // separate_colour_plane_flag: u(1)
+      RETURN_FALSE_ON_FAIL(parser.ReadBits(&sps.separate_colour_plane_flag, 1));
+    }
+    // bit_depth_luma_minus8 and bit_depth_chroma_minus8: ue(v)
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+    // qpprime_y_zero_transform_bypass_flag: u(1)
+    RETURN_FALSE_ON_FAIL(parser.ConsumeBits(1));
+    // seq_scaling_matrix_present_flag: u(1)
+    uint32_t seq_scaling_matrix_present_flag;
+    RETURN_FALSE_ON_FAIL(parser.ReadBits(&seq_scaling_matrix_present_flag, 1));
+    if (seq_scaling_matrix_present_flag) {
+      const int num_scaling_lists = chroma_format_idc != 3 ? 8 : 12;
+      for (int i = 0; i < num_scaling_lists; ++i) {
+        // seq_scaling_list_present_flag[i]: u(1)
+        uint32_t seq_scaling_list_present_flag;
+        RETURN_FALSE_ON_FAIL(
+            parser.ReadBits(&seq_scaling_list_present_flag, 1));
+        if (seq_scaling_list_present_flag)
+          RETURN_FALSE_ON_FAIL(SkipScalingList(&parser, i < 6 ? 16 : 64));
+      }
+    }
+  }
+  sps.chroma_array_type =
+      sps.separate_colour_plane_flag ? 0 : chroma_format_idc;
+  // log2_max_frame_num_minus4: ue(v)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadExponentialGolomb(&sps.log2_max_frame_num_minus4));
+  RETURN_FALSE_ON_FAIL(sps.log2_max_frame_num_minus4 <= kMaxLog2Minus4);
+  // pic_order_cnt_type: ue(v)
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&sps.pic_order_cnt_type));
+  if (sps.pic_order_cnt_type == 0) {
+    // log2_max_pic_order_cnt_lsb_minus4: ue(v)
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadExponentialGolomb(&sps.log2_max_pic_order_cnt_lsb_minus4));
+    RETURN_FALSE_ON_FAIL(sps.log2_max_pic_order_cnt_lsb_minus4 <=
+                         kMaxLog2Minus4);
+  } else if (sps.pic_order_cnt_type == 1) {
+    // delta_pic_order_always_zero_flag: u(1)
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadBits(&sps.delta_pic_order_always_zero_flag, 1));
+    // offset_for_non_ref_pic and offset_for_top_to_bottom_field: se(v)
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    // num_ref_frames_in_pic_order_cnt_cycle: ue(v)
+    uint32_t num_ref_frames_in_pic_order_cnt_cycle;
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadExponentialGolomb(&num_ref_frames_in_pic_order_cnt_cycle));
+    RETURN_FALSE_ON_FAIL(num_ref_frames_in_pic_order_cnt_cycle <=
+                         kMaxNumRefFramesInPicOrderCntCycle);
+    for (uint32_t i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; ++i) {
+      // offset_for_ref_frame[i]: se(v)
+      RETURN_FALSE_ON_FAIL(
+          parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    }
+  }
+  // max_num_ref_frames: ue(v)
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  // gaps_in_frame_num_value_allowed_flag: u(1)
+  RETURN_FALSE_ON_FAIL(parser.ConsumeBits(1));
+  // pic_width_in_mbs_minus1 and pic_height_in_map_units_minus1: ue(v)
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  // frame_mbs_only_flag: u(1)
+  RETURN_FALSE_ON_FAIL(parser.ReadBits(&sps.frame_mbs_only_flag, 1));
+
+  sps_[sps_id] = sps;
+  return true;
+}
+
+bool H264BitstreamParser::ParsePps(const uint8_t* rbsp, size_t length) {
+  // Section 7.3.2.2, pic_parameter_set_rbsp(), up to
+  // redundant_pic_cnt_present_flag.
+  rtc::BitBuffer parser(rbsp, length);
+  PpsState pps;
+  uint32_t golomb_ignored;
+  int32_t signed_golomb_ignored;
+
+  // pic_parameter_set_id and seq_parameter_set_id: ue(v)
+  uint32_t pps_id;
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&pps_id));
+  RETURN_FALSE_ON_FAIL(pps_id <= kMaxPpsId);
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&pps.sps_id));
+  // entropy_coding_mode_flag: u(1)
+  RETURN_FALSE_ON_FAIL(parser.ReadBits(&pps.entropy_coding_mode_flag, 1));
+  // bottom_field_pic_order_in_frame_present_flag: u(1)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadBits(&pps.bottom_field_pic_order_in_frame_present_flag, 1));
+  // num_slice_groups_minus1: ue(v)
+  uint32_t num_slice_groups_minus1;
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&num_slice_groups_minus1));
+  RETURN_FALSE_ON_FAIL(num_slice_groups_minus1 <= kMaxNumSliceGroupsMinus1);
+  if (num_slice_groups_minus1 > 0) {
+    // slice_group_map_type: ue(v)
+    uint32_t slice_group_map_type;
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&slice_group_map_type));
+    if (slice_group_map_type == 0) {
+      for (uint32_t i = 0; i <= num_slice_groups_minus1; ++i) {
+        // run_length_minus1[i]: ue(v)
+        RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+      }
+    } else if (slice_group_map_type == 2) {
+      for (uint32_t i = 0; i < num_slice_groups_minus1; ++i) {
+        // top_left[i] and bottom_right[i]: ue(v)
+        RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+        RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+      }
+    } else if (slice_group_map_type >= 3 && slice_group_map_type <= 5) {
+      // slice_group_change_direction_flag: u(1)
+      RETURN_FALSE_ON_FAIL(parser.ConsumeBits(1));
+      // slice_group_change_rate_minus1: ue(v)
+      RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+    } else if (slice_group_map_type == 6) {
+      // pic_size_in_map_units_minus1: ue(v)
+      uint32_t pic_size_in_map_units_minus1;
+      RETURN_FALSE_ON_FAIL(
+          parser.ReadExponentialGolomb(&pic_size_in_map_units_minus1));
+      // slice_group_id[i]: u(v), Ceil(Log2(num_slice_groups_minus1 + 1)) bits
+      size_t slice_group_id_bits = 0;
+      while ((1u << slice_group_id_bits) < num_slice_groups_minus1 + 1)
+        ++slice_group_id_bits;
+      const uint64_t bits = static_cast<uint64_t>(slice_group_id_bits) *
+                            (pic_size_in_map_units_minus1 + 1ull);
+      RETURN_FALSE_ON_FAIL(bits <= length * 8);
+      RETURN_FALSE_ON_FAIL(parser.ConsumeBits(static_cast<size_t>(bits)));
+    }
+  }
+  // num_ref_idx_l0_default_active_minus1: ue(v)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadExponentialGolomb(&pps.num_ref_idx_l0_default_active_minus1));
+  // num_ref_idx_l1_default_active_minus1: ue(v)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadExponentialGolomb(&pps.num_ref_idx_l1_default_active_minus1));
+  RETURN_FALSE_ON_FAIL(pps.num_ref_idx_l0_default_active_minus1 <=
+                           kMaxNumRefIdxActiveMinus1 &&
+                       pps.num_ref_idx_l1_default_active_minus1 <=
+                           kMaxNumRefIdxActiveMinus1);
+  // weighted_pred_flag: u(1)
+  RETURN_FALSE_ON_FAIL(parser.ReadBits(&pps.weighted_pred_flag, 1));
+  // weighted_bipred_idc: u(2)
+  RETURN_FALSE_ON_FAIL(parser.ReadBits(&pps.weighted_bipred_idc, 2));
+  // pic_init_qp_minus26: se(v)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadSignedExponentialGolomb(&pps.pic_init_qp_minus26));
+  // pic_init_qs_minus26 and chroma_qp_index_offset: se(v)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+  // deblocking_filter_control_present_flag and constrained_intra_pred_flag:
+  // u(1) each
+  RETURN_FALSE_ON_FAIL(parser.ConsumeBits(2));
+  // redundant_pic_cnt_present_flag: u(1)
+  RETURN_FALSE_ON_FAIL(
+      parser.ReadBits(&pps.redundant_pic_cnt_present_flag, 1));
+
+  pps_[pps_id] = pps;
+  return true;
+}
+
+bool H264BitstreamParser::ParseSlice(uint8_t nalu_header,
+                                     const uint8_t* rbsp,
+                                     size_t length) {
+  // Section 7.3.3, slice_header(), up to slice_qp_delta.
+  rtc::BitBuffer parser(rbsp, length);
+  const bool is_idr = (nalu_header & kNaluTypeMask) == kIdr;
+  const bool is_reference = (nalu_header & kNalRefIdcMask) != 0;
+  uint32_t golomb_ignored;
+  int32_t signed_golomb_ignored;
+
+  // first_mb_in_slice: ue(v)
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  // slice_type: ue(v)
+  uint32_t slice_type;
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&slice_type));
+  slice_type %= 5;
+  // pic_parameter_set_id: ue(v)
+  uint32_t pps_id;
+  RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&pps_id));
+  std::map<uint32_t, PpsState>::const_iterator pps_it = pps_.find(pps_id);
+  RETURN_FALSE_ON_FAIL(pps_it != pps_.end());
+  const PpsState& pps = pps_it->second;
+  std::map<uint32_t, SpsState>::const_iterator sps_it = sps_.find(pps.sps_id);
+  RETURN_FALSE_ON_FAIL(sps_it != sps_.end());
+  const SpsState& sps = sps_it->second;
+
+  if (sps.separate_colour_plane_flag) {
+    // colour_plane_id: u(2)
+    RETURN_FALSE_ON_FAIL(parser.ConsumeBits(2));
+  }
+  // frame_num: u(v)
+  RETURN_FALSE_ON_FAIL(parser.ConsumeBits(sps.log2_max_frame_num_minus4 + 4));
+  uint32_t field_pic_flag = 0;
+  if (!sps.frame_mbs_only_flag) {
+    // field_pic_flag: u(1)
+    RETURN_FALSE_ON_FAIL(parser.ReadBits(&field_pic_flag, 1));
+    if (field_pic_flag) {
+      // bottom_field_flag: u(1)
+      RETURN_FALSE_ON_FAIL(parser.ConsumeBits(1));
+    }
+  }
+  if (is_idr) {
+    // idr_pic_id: ue(v)
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  }
+  const bool has_delta_pic_order_cnt_bottom =
+      pps.bottom_field_pic_order_in_frame_present_flag && !field_pic_flag;
+  if (sps.pic_order_cnt_type == 0) {
+    // pic_order_cnt_lsb: u(v)
+    RETURN_FALSE_ON_FAIL(
+        parser.ConsumeBits(sps.log2_max_pic_order_cnt_lsb_minus4 + 4));
+    if (has_delta_pic_order_cnt_bottom) {
+      // delta_pic_order_cnt_bottom: se(v)
+      RETURN_FALSE_ON_FAIL(
+          parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    }
+  } else if (sps.pic_order_cnt_type == 1 &&
+             !sps.delta_pic_order_always_zero_flag) {
+    // delta_pic_order_cnt[0]: se(v)
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    if (has_delta_pic_order_cnt_bottom) {
+      // delta_pic_order_cnt[1]: se(v)
+      RETURN_FALSE_ON_FAIL(
+          parser.ReadSignedExponentialGolomb(&signed_golomb_ignored));
+    }
+  }
+  if (pps.redundant_pic_cnt_present_flag) {
+    // redundant_pic_cnt: ue(v)
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  }
+  if (slice_type == kSliceB) {
+    // direct_spatial_mv_pred_flag: u(1)
+    RETURN_FALSE_ON_FAIL(parser.ConsumeBits(1));
+  }
+  uint32_t num_ref_idx_l0_active_minus1 =
+      pps.num_ref_idx_l0_default_active_minus1;
+  uint32_t num_ref_idx_l1_active_minus1 =
+      pps.num_ref_idx_l1_default_active_minus1;
+  if (slice_type == kSliceP || slice_type == kSliceSp ||
+      slice_type == kSliceB) {
+    // num_ref_idx_active_override_flag: u(1)
+    uint32_t num_ref_idx_active_override_flag;
+    RETURN_FALSE_ON_FAIL(
+        parser.ReadBits(&num_ref_idx_active_override_flag, 1));
+    if (num_ref_idx_active_override_flag) {
+      // num_ref_idx_l0_active_minus1: ue(v)
+      RETURN_FALSE_ON_FAIL(
+          parser.ReadExponentialGolomb(&num_ref_idx_l0_active_minus1));
+      if (slice_type == kSliceB) {
+        // num_ref_idx_l1_active_minus1: ue(v)
+        RETURN_FALSE_ON_FAIL(
+            parser.ReadExponentialGolomb(&num_ref_idx_l1_active_minus1));
+      }
+    }
+  }
+  RETURN_FALSE_ON_FAIL(
+      num_ref_idx_l0_active_minus1 <= kMaxNumRefIdxActiveMinus1 &&
+      num_ref_idx_l1_active_minus1 <= kMaxNumRefIdxActiveMinus1);
+  if (slice_type != kSliceI && slice_type != kSliceSi) {
+    RETURN_FALSE_ON_FAIL(SkipRefPicListModification(&parser));
+    if (slice_type == kSliceB)
+      RETURN_FALSE_ON_FAIL(SkipRefPicListModification(&parser));
+  }
+  if ((pps.weighted_pred_flag &&
+       (slice_type == kSliceP || slice_type == kSliceSp)) ||
+      (pps.weighted_bipred_idc == 1 && slice_type == kSliceB)) {
+    // luma_log2_weight_denom: ue(v)
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+    if (sps.chroma_array_type != 0) {
+      // chroma_log2_weight_denom: ue(v)
+      RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+    }
+    RETURN_FALSE_ON_FAIL(SkipPredWeights(&parser, sps.chroma_array_type,
+                                         num_ref_idx_l0_active_minus1));
+    if (slice_type == kSliceB) {
+      RETURN_FALSE_ON_FAIL(SkipPredWeights(&parser, sps.chroma_array_type,
+                                           num_ref_idx_l1_active_minus1));
+    }
+  }
+  if (is_reference) {
+    // dec_ref_pic_marking(), section 7.3.3.3.
+    if (is_idr) {
+      // no_output_of_prior_pics_flag and long_term_reference_flag: u(1) each
+      RETURN_FALSE_ON_FAIL(parser.ConsumeBits(2));
+    } else {
+      // adaptive_ref_pic_marking_mode_flag: u(1)
+      uint32_t adaptive_ref_pic_marking_mode_flag;
+      RETURN_FALSE_ON_FAIL(
+          parser.ReadBits(&adaptive_ref_pic_marking_mode_flag, 1));
+      if (adaptive_ref_pic_marking_mode_flag) {
+        uint32_t memory_management_control_operation;
+        do {
+          RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(
+              &memory_management_control_operation));
+          RETURN_FALSE_ON_FAIL(memory_management_control_operation <= 6);
+          // Each operation other than 0 and 5 has one argument, except for
+          // 3 which has two: ue(v) each.
+          if (memory_management_control_operation != 0 &&
+              memory_management_control_operation != 5) {
+            RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+          }
+          if (memory_management_control_operation == 3) {
+            RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+          }
+        } while (memory_management_control_operation != 0);
+      }
+    }
+  }
+  if (pps.entropy_coding_mode_flag && slice_type != kSliceI &&
+      slice_type != kSliceSi) {
+    // cabac_init_idc: ue(v)
+    RETURN_FALSE_ON_FAIL(parser.ReadExponentialGolomb(&golomb_ignored));
+  }
+  // slice_qp_delta: se(v)
+  int32_t slice_qp_delta;
+  RETURN_FALSE_ON_FAIL(parser.ReadSignedExponentialGolomb(&slice_qp_delta));
+
+  last_slice_qp_ = 26 + pps.pic_init_qp_minus26 + slice_qp_delta;
+  last_slice_qp_valid_ = true;
+  return true;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,365 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "webrtc/modules/video_coding/utility/include/h264_bitstream_parser.h"
+
+#include <vector>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "webrtc/base/bitbuffer.h"
+
+namespace webrtc {
+namespace {
+
+const uint8_t kSpsHeader = 0x67;
+const uint8_t kPpsHeader = 0x68;
+const uint8_t kIdrHeader = 0x65;
+const uint8_t kReferenceSliceHeader = 0x41;
+const uint8_t kNonReferenceSliceHeader = 0x01;
+
+const uint32_t kSliceTypeP = 5;
+const uint32_t kSliceTypeB = 6;
+const uint32_t kSliceTypeI = 7;
+
+// Writes the syntax elements of a NAL unit, and appends the NAL unit to an
+// Annex B byte stream with emulation prevention bytes added.
+class NaluWriter {
+ public:
+  explicit NaluWriter(uint8_t nalu_header)
+      : nalu_header_(nalu_header),
+        rbsp_(1024, 0),
+        writer_(&rbsp_[0], rbsp_.size()) {}
+
+  NaluWriter& Bits(uint32_t value, size_t bit_count) {
+    EXPECT_TRUE(writer_.WriteBits(value, bit_count));
+    return *this;
+  }
+  NaluWriter& Ue(uint32_t value) {
+    EXPECT_TRUE(writer_.WriteExponentialGolomb(value));
+    return *this;
+  }
+  NaluWriter& Se(int32_t value) {
+    EXPECT_TRUE(writer_.WriteSignedExponentialGolomb(value));
+    return *this;
+  }
+
+  void AppendTo(std::vector<uint8_t>* stream) {
+    // rbsp_stop_one_bit, followed by zero bits up to the next byte.
+    Bits(1, 1);
+    size_t byte_offset;
+    size_t bit_offset;
+    writer_.GetCurrentOffset(&byte_offset, &bit_offset);
+    const size_t rbsp_length = byte_offset + (bit_offset > 0 ? 1 : 0);
+
+    const uint8_t kStartCode[] = {0, 0, 0, 1};
+    stream->insert(stream->end(), kStartCode, kStartCode + sizeof(kStartCode));
+    stream->push_back(nalu_header_);
+    int zeros = 0;
+    for (size_t i = 0; i < rbsp_length; ++i) {
+      if (zeros == 2 && rbsp_[i] <= 3) {
+        stream->push_back(3);
+        zeros = 0;
+      }
+      stream->push_back(rbsp_[i]);
+      zeros = rbsp_[i] == 0 ? zeros + 1 : 0;
+    }
+  }
+
+ private:
+  const uint8_t nalu_header_;
+  std::vector<uint8_t> rbsp_;
+  rtc::BitBufferWriter writer_;
+};
+
+// A baseline profile SPS for 1920x1088 with 4 bit frame numbers and 6 bit
+// picture order count LSBs.
+void AppendSps(std::vector<uint8_t>* stream) {
+  NaluWriter(kSpsHeader)
+      .Bits(66, 8)  // profile_idc
+      .Bits(0, 8)   // constraint flags
+      .Bits(40, 8)  // level_idc
+      .Ue(0)        // seq_parameter_set_id
+      .Ue(0)        // log2_max_frame_num_minus4
+      .Ue(0)        // pic_order_cnt_type
+      .Ue(2)        // log2_max_pic_order_cnt_lsb_minus4
+      .Ue(1)        // max_num_ref_frames
+      .Bits(0, 1)   // gaps_in_frame_num_value_allowed_flag
+      .Ue(119)      // pic_width_in_mbs_minus1
+      .Ue(67)       // pic_height_in_map_units_minus1
+      .Bits(1, 1)   // frame_mbs_only_flag
+      .Bits(1, 1)   // direct_8x8_inference_flag
+      .Bits(0, 1)   // frame_cropping_flag
+      .Bits(0, 1)   // vui_parameters_present_flag
+      .AppendTo(stream);
+}
+
+void AppendPps(uint32_t pps_id,
+               bool cabac,
+               uint32_t weighted_bipred_idc,
+               int32_t pic_init_qp_minus26,
+               std::vector<uint8_t>* stream) {
+  NaluWriter(kPpsHeader)
+      .Ue(pps_id)                    // pic_parameter_set_id
+      .Ue(0)                         // seq_parameter_set_id
+      .Bits(cabac ? 1 : 0, 1)        // entropy_coding_mode_flag
+      .Bits(0, 1)                    // bottom_field_pic_order_in_frame...
+      .Ue(0)                         // num_slice_groups_minus1
+      .Ue(0)                         // num_ref_idx_l0_default_active_minus1
+      .Ue(0)                         // num_ref_idx_l1_default_active_minus1
+      .Bits(0, 1)                    // weighted_pred_flag
+      .Bits(weighted_bipred_idc, 2)  // weighted_bipred_idc
+      .Se(pic_init_qp_minus26)       // pic_init_qp_minus26
+      .Se(0)                         // pic_init_qs_minus26
+      .Se(0)                         // chroma_qp_index_offset
+      .Bits(1, 1)                    // deblocking_filter_control_present_flag
+      .Bits(0, 1)                    // constrained_intra_pred_flag
+      .Bits(0, 1)                    // redundant_pic_cnt_present_flag
+      .AppendTo(stream);
+}
+
+void AppendIdrSlice(int32_t slice_qp_delta, std::vector<uint8_t>* stream) {
+  NaluWriter(kIdrHeader)
+      .Ue(0)            // first_mb_in_slice
+      .Ue(kSliceTypeI)  // slice_type
+      .Ue(0)            // pic_parameter_set_id
+      .Bits(0, 4)       // frame_num
+      .Ue(0)            // idr_pic_id
+      .Bits(0, 6)       // pic_order_cnt_lsb
+      .Bits(0, 2)       // dec_ref_pic_marking()
+      .Se(slice_qp_delta)
+      .Bits(0x5a5a, 16)  // Slice data.
+      .AppendTo(stream);
+}
+
+void AppendIdr(int32_t pic_init_qp_minus26,
+               int32_t slice_qp_delta,
+               std::vector<uint8_t>* stream) {
+  AppendSps(stream);
+  AppendPps(0, false, 0, pic_init_qp_minus26, stream);
+  AppendIdrSlice(slice_qp_delta, stream);
+}
+
+TEST(H264BitstreamParserTest, FindsNaluIndices) {
+  const uint8_t kStream[] = {
+      0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x00,  // 4 byte start code.
+      0x03, 0x01, 0x00, 0x00, 0x01, 0x68, 0xce,        // 3 byte start code.
+      0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x80,        // 4 byte start code.
+      0x00, 0x00,                                      // Trailing zeros.
+      0x00, 0x00, 0x01, 0x41,                          // One byte NAL unit.
+  };
+  std::vector<H264BitstreamParser::NaluIndex> indices =
+      H264BitstreamParser::FindNaluIndices(kStream, sizeof(kStream));
+  ASSERT_EQ(4u, indices.size());
+  EXPECT_EQ(4u, indices[0].offset);
+  EXPECT_EQ(6u, indices[0].length);
+  EXPECT_EQ(13u, indices[1].offset);
+  EXPECT_EQ(2u, indices[1].length);
+  EXPECT_EQ(19u, indices[2].offset);
+  EXPECT_EQ(3u, indices[2].length);
+  EXPECT_EQ(27u, indices[3].offset);
+  EXPECT_EQ(1u, indices[3].length);
+
+  EXPECT_TRUE(H264BitstreamParser::FindNaluIndices(kStream, 2).empty());
+  EXPECT_TRUE(H264BitstreamParser::FindNaluIndices(kStream + 4, 8).empty());
+}
+
+TEST(H264BitstreamParserTest, RemovesEmulationPreventionBytes) {
+  const uint8_t kPayload[] = {0x42, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03,
+                              0x01, 0x00, 0x03, 0x00, 0x00, 0x03};
+  const uint8_t kRbsp[] = {0x42, 0x00, 0x00, 0x00, 0x00, 0x01,
+                           0x00, 0x03, 0x00, 0x00};
+  std::vector<uint8_t> rbsp;
+  H264BitstreamParser::ParseRbsp(kPayload, sizeof(kPayload), &rbsp);
+  EXPECT_EQ(std::vector<uint8_t>(kRbsp, kRbsp + sizeof(kRbsp)), rbsp);
+
+  // The output is replaced, not appended to.
+  H264BitstreamParser::ParseRbsp(kPayload, 3, &rbsp);
+  EXPECT_EQ(std::vector<uint8_t>(kPayload, kPayload + 3), rbsp);
+}
+
+TEST(H264BitstreamParserTest, ReportsQpOfIdrSlice) {
+  std::vector<uint8_t> stream;
+  AppendIdr(-4, 3, &stream);
+  H264BitstreamParser parser;
+  int qp = 0;
+  EXPECT_FALSE(parser.GetLastSliceQp(&qp));
+  parser.ParseBitstream(&stream[0], stream.size());
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(25, qp);
+}
+
+TEST(H264BitstreamParserTest, NeedsPpsToParseSlice) {
+  std::vector<uint8_t> stream;
+  AppendSps(&stream);
+  AppendIdrSlice(3, &stream);
+  H264BitstreamParser parser;
+  parser.ParseBitstream(&stream[0], stream.size());
+  int qp;
+  EXPECT_FALSE(parser.GetLastSliceQp(&qp));
+}
+
+TEST(H264BitstreamParserTest, KeepsParameterSetsBetweenFrames) {
+  std::vector<uint8_t> key_frame;
+  AppendIdr(2, -10, &key_frame);
+
+  // A P frame with an adaptive reference picture marking of two operations.
+  std::vector<uint8_t> delta_frame;
+  NaluWriter(kReferenceSliceHeader)
+      .Ue(0)            // first_mb_in_slice
+      .Ue(kSliceTypeP)  // slice_type
+      .Ue(0)            // pic_parameter_set_id
+      .Bits(1, 4)       // frame_num
+      .Bits(2, 6)       // pic_order_cnt_lsb
+      .Bits(1, 1)       // num_ref_idx_active_override_flag
+      .Ue(0)            // num_ref_idx_l0_active_minus1
+      .Bits(1, 1)       // ref_pic_list_modification_flag_l0
+      .Ue(0)            // modification_of_pic_nums_idc
+      .Ue(0)            // abs_diff_pic_num_minus1
+      .Ue(3)            // modification_of_pic_nums_idc
+      .Bits(1, 1)       // adaptive_ref_pic_marking_mode_flag
+      .Ue(3)            // memory_management_control_operation
+      .Ue(0)            // difference_of_pic_nums_minus1
+      .Ue(0)            // long_term_frame_idx
+      .Ue(0)            // memory_management_control_operation
+      .Se(5)            // slice_qp_delta
+      .AppendTo(&delta_frame);
+
+  H264BitstreamParser parser;
+  int qp;
+  parser.ParseBitstream(&key_frame[0], key_frame.size());
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(18, qp);
+  parser.ParseBitstream(&delta_frame[0], delta_frame.size());
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(33, qp);
+
+  // A bitstream without slices doesn't report the QP of the previous one.
+  std::vector<uint8_t> parameter_sets;
+  AppendSps(&parameter_sets);
+  parser.ParseBitstream(&parameter_sets[0], parameter_sets.size());
+  EXPECT_FALSE(parser.GetLastSliceQp(&qp));
+}
+
+TEST(H264BitstreamParserTest, ParsesCabacBSliceWithWeightTable) {
+  std::vector<uint8_t> stream;
+  AppendSps(&stream);
+  AppendPps(3, true, 1, 0, &stream);
+  NaluWriter(kNonReferenceSliceHeader)
+      .Ue(0)            // first_mb_in_slice
+      .Ue(kSliceTypeB)  // slice_type
+      .Ue(3)            // pic_parameter_set_id
+      .Bits(2, 4)       // frame_num
+      .Bits(4, 6)       // pic_order_cnt_lsb
+      .Bits(1, 1)       // direct_spatial_mv_pred_flag
+      .Bits(0, 1)       // num_ref_idx_active_override_flag
+      .Bits(0, 1)       // ref_pic_list_modification_flag_l0
+      .Bits(0, 1)       // ref_pic_list_modification_flag_l1
+      .Ue(5)            // luma_log2_weight_denom
+      .Ue(5)            // chroma_log2_weight_denom
+      .Bits(1, 1)       // luma_weight_l0_flag
+      .Se(-3)           // luma_weight_l0
+      .Se(7)            // luma_offset_l0
+      .Bits(1, 1)       // chroma_weight_l0_flag
+      .Se(1).Se(-1).Se(2).Se(-2)
+      .Bits(0, 1)       // luma_weight_l1_flag
+      .Bits(0, 1)       // chroma_weight_l1_flag
+      .Ue(2)            // cabac_init_idc
+      .Se(-7)           // slice_qp_delta
+      .AppendTo(&stream);
+
+  H264BitstreamParser parser;
+  parser.ParseBitstream(&stream[0], stream.size());
+  int qp;
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(19, qp);
+}
+
+TEST(H264BitstreamParserTest, ParsesSpsWithScalingLists) {
+  std::vector<uint8_t> stream;
+  NaluWriter sps(kSpsHeader);
+  sps.Bits(100, 8)  // profile_idc
+      .Bits(0, 8)   // constraint flags
+      .Bits(40, 8)  // level_idc
+      .Ue(0)        // seq_parameter_set_id
+      .Ue(1)        // chroma_format_idc
+      .Ue(0)        // bit_depth_luma_minus8
+      .Ue(0)        // bit_depth_chroma_minus8
+      .Bits(0, 1)   // qpprime_y_zero_transform_bypass_flag
+      .Bits(1, 1)   // seq_scaling_matrix_present_flag
+      .Bits(1, 1);  // seq_scaling_list_present_flag[0]
+  // A 4x4 list of all 16s, and then one that ends early by a next_scale of 0.
+  sps.Se(8);
+  for (int i = 1; i < 16; ++i)
+    sps.Se(0);
+  sps.Bits(1, 1).Se(-8);
+  for (int i = 2; i < 8; ++i)
+    sps.Bits(0, 1);
+  sps.Ue(0)         // log2_max_frame_num_minus4
+      .Ue(0)        // pic_order_cnt_type
+      .Ue(2)        // log2_max_pic_order_cnt_lsb_minus4
+      .Ue(1)        // max_num_ref_frames
+      .Bits(0, 1)   // gaps_in_frame_num_value_allowed_flag
+      .Ue(119)      // pic_width_in_mbs_minus1
+      .Ue(67)       // pic_height_in_map_units_minus1
+      .Bits(1, 1)   // frame_mbs_only_flag
+      .AppendTo(&stream);
+  AppendPps(0, true, 0, 0, &stream);
+  AppendIdrSlice(12, &stream);
+
+  H264BitstreamParser parser;
+  parser.ParseBitstream(&stream[0], stream.size());
+  int qp;
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(38, qp);
+}
+
+TEST(H264BitstreamParserTest, ParsesHeaderOfLongEscapedSlice) {
+  std::vector<uint8_t> stream;
+  AppendSps(&stream);
+  AppendPps(0, false, 0, 0, &stream);
+  // A slice header with emulation prevention bytes, and a kilobyte of slice
+  // data which is mostly zeros.
+  NaluWriter slice(kIdrHeader);
+  slice.Ue(0)            // first_mb_in_slice
+      .Ue(kSliceTypeI)   // slice_type
+      .Ue(0)             // pic_parameter_set_id
+      .Bits(0, 4)        // frame_num
+      .Ue(0)             // idr_pic_id
+      .Bits(0, 6)        // pic_order_cnt_lsb
+      .Bits(0, 2)        // dec_ref_pic_marking()
+      .Se(-6);           // slice_qp_delta
+  for (int i = 0; i < 1000; ++i)
+    slice.Bits(i % 7 == 0 ? 1 : 0, 8);
+  slice.AppendTo(&stream);
+
+  H264BitstreamParser parser;
+  parser.ParseBitstream(&stream[0], stream.size());
+  int qp;
+  ASSERT_TRUE(parser.GetLastSliceQp(&qp));
+  EXPECT_EQ(20, qp);
+}
+
+TEST(H264BitstreamParserTest, IgnoresTruncatedSlices) {
+  std::vector<uint8_t> stream;
+  AppendIdr(0, 0, &stream);
+  std::vector<H264BitstreamParser::NaluIndex> indices =
+      H264BitstreamParser::FindNaluIndices(&stream[0], stream.size());
+  ASSERT_EQ(3u, indices.size());
+  // Keep only the NAL unit header and first byte of the slice.
+  stream.resize(indices[2].offset + 2);
+
+  H264BitstreamParser parser;
+  parser.ParseBitstream(&stream[0], stream.size());
+  int qp;
+  EXPECT_FALSE(parser.GetLastSliceQp(&qp));
+}
+
+}  // namespace
+}  // namespace webrtc
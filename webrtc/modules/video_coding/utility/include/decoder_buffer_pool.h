@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_VIDEO_CODING_UTILITY_DECODER_BUFFER_POOL_H_
+#define WEBRTC_MODULES_VIDEO_CODING_UTILITY_DECODER_BUFFER_POOL_H_
+
+#include <list>
+#include <map>
+
+#include "webrtc/base/criticalsection.h"
+#include "webrtc/base/refcount.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/scoped_ref_ptr.h"
+#include "webrtc/base/thread_annotations.h"
+#include "webrtc/common_video/interface/video_frame_buffer.h"
+#include "webrtc/system_wrappers/interface/aligned_malloc.h"
+
+namespace webrtc {
+
+class Clock;
+
+// Pool of frame buffers shared by the video decoders of the process. Buffers
+// are grouped by size into buckets, so that decoders of different resolutions
+// recycle each other's memory instead of each keeping a private pool sized for
+// its own peak. A buffer is recycled once the pool holds its only reference,
+// and buffers that have not been used for a while are freed again.
+//
+// Decoded images living in pool buffers are handed out without copies by
+// wrapping them with Buffer::WrapI420(); the buffer stays out of the pool
+// until the last VideoFrame referencing it is gone.
+class DecoderBufferPool {
+ public:
+  class Buffer : public rtc::RefCountInterface {
+   public:
+    uint8_t* data() { return data_.get(); }
+    // The size requested from GetBuffer(), at most capacity().
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    // Returns a VideoFrameBuffer of the I420 planes stored in this buffer,
+    // which keeps the buffer referenced for as long as it lives.
+    rtc::scoped_refptr<VideoFrameBuffer> WrapI420(int width,
+                                                  int height,
+                                                  const uint8_t* y_plane,
+                                                  int y_stride,
+                                                  const uint8_t* u_plane,
+                                                  int u_stride,
+                                                  const uint8_t* v_plane,
+                                                  int v_stride);
+
+    virtual bool HasOneRef() const = 0;
+
+   protected:
+    explicit Buffer(size_t capacity);
+    ~Buffer() override {}
+
+   private:
+    friend class DecoderBufferPool;
+
+    const size_t capacity_;
+    size_t size_;
+    // When the buffer was last handed out by GetBuffer().
+    int64_t last_use_ms_;
+    rtc::scoped_ptr<uint8_t, AlignedFreeDeleter> data_;
+  };
+
+  struct Stats {
+    Stats()
+        : num_buffers(0),
+          num_buffers_in_use(0),
+          allocated_bytes(0),
+          in_use_bytes(0),
+          max_allocated_bytes(0) {}
+
+    size_t num_buffers;
+    size_t num_buffers_in_use;
+    size_t allocated_bytes;
+    size_t in_use_bytes;
+    // High-water mark of |allocated_bytes|.
+    size_t max_allocated_bytes;
+  };
+
+  // Buffers unused for this long are freed.
+  static const int64_t kIdleTimeoutMs;
+
+  // The pool used by the VP8 and VP9 decoders. Never destroyed.
+  static DecoderBufferPool* Shared();
+
+  explicit DecoderBufferPool(Clock* clock);
+  // All buffers must have been released.
+  ~DecoderBufferPool();
+
+  // Returns a buffer of at least |min_size| bytes, recycled if possible.
+  rtc::scoped_refptr<Buffer> GetBuffer(size_t min_size);
+
+  // Frees buffers that have been idle for |kIdleTimeoutMs|. Also done
+  // periodically by GetBuffer().
+  void TrimIdleBuffers();
+
+  Stats GetStats() const;
+
+ private:
+  typedef std::list<rtc::scoped_refptr<Buffer>> BufferList;
+
+  static size_t BucketSize(size_t size);
+  void TrimIdleBuffersLocked(int64_t now_ms)
+      EXCLUSIVE_LOCKS_REQUIRED(buffers_lock_);
+
+  Clock* const clock_;
+  mutable rtc::CriticalSection buffers_lock_;
+  // Buffers by capacity, both the ones in use and the free ones.
+  std::map<size_t, BufferList> buckets_ GUARDED_BY(buffers_lock_);
+  size_t allocated_bytes_ GUARDED_BY(buffers_lock_);
+  size_t max_allocated_bytes_ GUARDED_BY(buffers_lock_);
+  int64_t last_trim_ms_ GUARDED_BY(buffers_lock_);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_VIDEO_CODING_UTILITY_DECODER_BUFFER_POOL_H_
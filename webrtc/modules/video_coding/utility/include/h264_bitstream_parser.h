@@ -0,0 +1,104 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_MODULES_VIDEO_CODING_UTILITY_H264_BITSTREAM_PARSER_H_
+#define WEBRTC_MODULES_VIDEO_CODING_UTILITY_H264_BITSTREAM_PARSER_H_
+
+#include <stddef.h>
+
+#include <map>
+#include <vector>
+
+#include "webrtc/base/constructormagic.h"
+#include "webrtc/typedefs.h"
+
+namespace webrtc {
+
+// Reads the QP of H.264 slices out of Annex B byte streams, without decoding
+// them. Slice headers can only be parsed with the SPS and PPS they refer to,
+// so the parser keeps the ones it has seen between calls to ParseBitstream().
+// Feed it every frame of a stream, in decode order.
+class H264BitstreamParser {
+ public:
+  struct NaluIndex {
+    // Offset of the first byte of the NAL unit header, after the start code.
+    size_t offset;
+    // Length of the NAL unit, header included.
+    size_t length;
+  };
+
+  // Finds the NAL units in the Annex B byte stream |buffer|, which are
+  // preceded by three or four byte start codes.
+  static std::vector<NaluIndex> FindNaluIndices(const uint8_t* buffer,
+                                                size_t length);
+
+  // Writes the raw byte sequence payload of the NAL unit payload |data| to
+  // |rbsp|, i.e. |data| without its emulation prevention bytes.
+  static void ParseRbsp(const uint8_t* data,
+                        size_t length,
+                        std::vector<uint8_t>* rbsp);
+
+  H264BitstreamParser();
+  ~H264BitstreamParser();
+
+  // Parses the SPSs, PPSs and slice headers in |bitstream|.
+  void ParseBitstream(const uint8_t* bitstream, size_t length);
+
+  // Gets the QP of the last slice in the last bitstream parsed. Returns false
+  // if that bitstream had no slice whose header could be parsed, e.g. because
+  // its SPS or PPS hasn't been seen.
+  bool GetLastSliceQp(int* qp) const;
+
+ private:
+  // The fields of the SPS a slice header needs to be parsed.
+  struct SpsState {
+    SpsState();
+
+    uint32_t chroma_array_type;
+    uint32_t separate_colour_plane_flag;
+    uint32_t log2_max_frame_num_minus4;
+    uint32_t pic_order_cnt_type;
+    uint32_t log2_max_pic_order_cnt_lsb_minus4;
+    uint32_t delta_pic_order_always_zero_flag;
+    uint32_t frame_mbs_only_flag;
+  };
+
+  // The fields of the PPS a slice header needs to be parsed.
+  struct PpsState {
+    PpsState();
+
+    uint32_t sps_id;
+    uint32_t entropy_coding_mode_flag;
+    uint32_t bottom_field_pic_order_in_frame_present_flag;
+    uint32_t num_ref_idx_l0_default_active_minus1;
+    uint32_t num_ref_idx_l1_default_active_minus1;
+    uint32_t weighted_pred_flag;
+    uint32_t weighted_bipred_idc;
+    int32_t pic_init_qp_minus26;
+    uint32_t redundant_pic_cnt_present_flag;
+  };
+
+  bool ParseSps(const uint8_t* rbsp, size_t length);
+  bool ParsePps(const uint8_t* rbsp, size_t length);
+  bool ParseSlice(uint8_t nalu_header, const uint8_t* rbsp, size_t length);
+
+  std::map<uint32_t, SpsState> sps_;
+  std::map<uint32_t, PpsState> pps_;
+  // Reused between NAL units to avoid an allocation for each of them.
+  std::vector<uint8_t> rbsp_buffer_;
+  bool last_slice_qp_valid_;
+  int last_slice_qp_;
+
+  DISALLOW_COPY_AND_ASSIGN(H264BitstreamParser);
+};
+
+}  // namespace webrtc
+
+#endif  // WEBRTC_MODULES_VIDEO_CODING_UTILITY_H264_BITSTREAM_PARSER_H_
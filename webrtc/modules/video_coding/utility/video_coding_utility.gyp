@@ -15,11 +15,17 @@
       'target_name': 'video_coding_utility',
       'type': 'static_library',
       'dependencies': [
+        '<(webrtc_root)/base/base.gyp:rtc_base_approved',
+        '<(webrtc_root)/common_video/common_video.gyp:common_video',
         '<(webrtc_root)/system_wrappers/system_wrappers.gyp:system_wrappers',
       ],
       'sources': [
+        'decoder_buffer_pool.cc',
         'frame_dropper.cc',
+        'h264_bitstream_parser.cc',
+        'include/decoder_buffer_pool.h',
         'include/frame_dropper.h',
+        'include/h264_bitstream_parser.h',
         'include/moving_average.h',
         'include/quality_scaler.h',
         'include/vp8_header_parser.h',
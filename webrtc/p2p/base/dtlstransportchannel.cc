@@ -345,6 +345,26 @@ bool DtlsTransportChannelWrapper::GetSrtpCipher(std::string* cipher) {
   return dtls_->GetDtlsSrtpCipher(cipher);
 }
 
+void DtlsTransportChannelWrapper::SetSrtpPacketSink(
+    SrtpPacketSink* sink, TransportChannel* channel) {
+  ASSERT(rtc::Thread::Current() == worker_thread_);
+  for (std::vector<SrtpPacketSinkPair>::iterator it =
+           srtp_packet_sinks_.begin();
+       it != srtp_packet_sinks_.end(); ++it) {
+    if (it->first == channel) {
+      if (sink) {
+        it->second = sink;
+      } else {
+        srtp_packet_sinks_.erase(it);
+      }
+      return;
+    }
+  }
+  if (sink) {
+    srtp_packet_sinks_.push_back(SrtpPacketSinkPair(channel, sink));
+  }
+}
+
 
 // Called from upper layers to send a media packet.
 int DtlsTransportChannelWrapper::SendPacket(
@@ -509,8 +529,16 @@ void DtlsTransportChannelWrapper::OnReadPacket(
         // Sanity check.
         ASSERT(!srtp_ciphers_.empty());
 
-        // Signal this upwards as a bypass packet.
-        SignalReadPacket(this, data, size, packet_time, PF_SRTP_BYPASS);
+        // Hand this to the sinks, or signal it upwards, as a bypass packet.
+        if (!srtp_packet_sinks_.empty()) {
+          for (size_t i = 0; i < srtp_packet_sinks_.size(); ++i) {
+            srtp_packet_sinks_[i].second->OnSrtpPacket(
+                srtp_packet_sinks_[i].first, data, size, packet_time,
+                PF_SRTP_BYPASS);
+          }
+        } else {
+          SignalReadPacket(this, data, size, packet_time, PF_SRTP_BYPASS);
+        }
       }
       break;
     case STATE_CLOSED:
@@ -12,6 +12,7 @@
 #define WEBRTC_P2P_BASE_DTLSTRANSPORTCHANNEL_H_
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "webrtc/p2p/base/transportchannelimpl.h"
@@ -139,6 +140,12 @@ class DtlsTransportChannelWrapper : public TransportChannelImpl {
   // Find out which DTLS-SRTP cipher was negotiated
   virtual bool GetSrtpCipher(std::string* cipher);
 
+  // Once DTLS-SRTP is established, SRTP packets from the wrapped channel go
+  // straight to the registered sinks rather than through SignalReadPacket.
+  // Each channel bundled on this one registers its own sink.
+  virtual void SetSrtpPacketSink(SrtpPacketSink* sink,
+                                 TransportChannel* channel);
+
   virtual bool GetSslRole(rtc::SSLRole* role) const;
   virtual bool SetSslRole(rtc::SSLRole role);
 
@@ -230,6 +237,9 @@ class DtlsTransportChannelWrapper : public TransportChannelImpl {
   rtc::scoped_ptr<rtc::SSLStreamAdapter> dtls_;  // The DTLS stream
   StreamInterfaceChannel* downward_;  // Wrapper for channel_, owned by dtls_.
   std::vector<std::string> srtp_ciphers_;  // SRTP ciphers to use with DTLS.
+  // The sinks that get the SRTP packets, with the channel each is told.
+  typedef std::pair<TransportChannel*, SrtpPacketSink*> SrtpPacketSinkPair;
+  std::vector<SrtpPacketSinkPair> srtp_packet_sinks_;
   State dtls_state_;
   rtc::SSLIdentity* local_identity_;
   rtc::SSLRole ssl_role_;
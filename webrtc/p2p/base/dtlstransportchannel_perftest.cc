@@ -0,0 +1,216 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "webrtc/p2p/base/dtlstransport.h"
+#include "webrtc/p2p/base/fakesession.h"
+#include "webrtc/p2p/base/transportchannelproxy.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/ssladapter.h"
+#include "webrtc/base/sslfingerprint.h"
+#include "webrtc/base/sslidentity.h"
+#include "webrtc/base/sslstreamadapter.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+const char kSrtpCipher[] = "AES_CM_128_HMAC_SHA1_80";
+const char kIceUfrag[] = "TESTICEUFRAG0001";
+const char kIcePwd[] = "TESTICEPWD00000000000001";
+const int kComponent = 1;
+const int kConnectTimeoutMs = 10000;
+const int kNumPackets = 1000000;
+const size_t kPacketLen = 1200;
+
+// Receives the SRTP packets of one end, either from the proxy's
+// SignalReadPacket as BaseChannel used to, or through the packet sink.
+class PacketReceiver : public sigslot::has_slots<>, public SrtpPacketSink {
+ public:
+  PacketReceiver() : num_packets_(0), stack_depth_(0), stack_top_(NULL) {}
+
+  int num_packets() const { return num_packets_; }
+  // Stack bytes between the last MarkStack call and the last packet.
+  size_t stack_depth() const { return stack_depth_; }
+  void MarkStack(const char* top) { stack_top_ = top; }
+
+  void OnReadPacket(TransportChannel* channel, const char* data, size_t size,
+                    const rtc::PacketTime& packet_time, int flags) {
+    OnPacket(flags);
+  }
+  void OnSrtpPacket(TransportChannel* channel, const char* data, size_t size,
+                    const rtc::PacketTime& packet_time, int flags) override {
+    OnPacket(flags);
+  }
+
+ private:
+  void OnPacket(int flags) {
+    char bottom;
+    EXPECT_EQ(PF_SRTP_BYPASS, flags);
+    ++num_packets_;
+    stack_depth_ = reinterpret_cast<uintptr_t>(stack_top_) -
+                   reinterpret_cast<uintptr_t>(&bottom);
+  }
+
+  int num_packets_;
+  size_t stack_depth_;
+  const char* stack_top_;
+};
+
+// One end of a DTLS-SRTP connection, with a TransportChannelProxy on top of
+// the DtlsTransportChannelWrapper, the way BaseChannel sees it.
+class DtlsSrtpEndpoint {
+ public:
+  explicit DtlsSrtpEndpoint(const std::string& name)
+      : identity_(rtc::SSLIdentity::Generate(name)),
+        transport_(new DtlsTransport<FakeTransport>(
+            rtc::Thread::Current(), rtc::Thread::Current(), "content", NULL,
+            identity_.get())),
+        proxy_("content", kComponent) {
+    transport_->SetAsync(true);
+    wrapper_ = static_cast<DtlsTransportChannelWrapper*>(
+        transport_->CreateChannel(kComponent));
+    std::vector<std::string> ciphers;
+    ciphers.push_back(kSrtpCipher);
+    wrapper_->SetSrtpCiphers(ciphers);
+    proxy_.SetImplementation(wrapper_);
+    proxy_.SignalReadPacket.connect(&receiver_,
+                                    &PacketReceiver::OnReadPacket);
+  }
+
+  TransportChannelProxy* proxy() { return &proxy_; }
+  PacketReceiver* receiver() { return &receiver_; }
+  // The channel that stands in for the socket.
+  FakeTransportChannel* fake_channel() {
+    return static_cast<FakeTransportChannel*>(wrapper_->channel());
+  }
+
+  bool Negotiate(DtlsSrtpEndpoint* peer, ContentAction action) {
+    rtc::scoped_ptr<rtc::SSLFingerprint> local_fingerprint(
+        rtc::SSLFingerprint::Create(rtc::DIGEST_SHA_256, identity_.get()));
+    rtc::scoped_ptr<rtc::SSLFingerprint> remote_fingerprint(
+        rtc::SSLFingerprint::Create(rtc::DIGEST_SHA_256,
+                                    peer->identity_.get()));
+    ConnectionRole local_role =
+        (action == CA_OFFER) ? CONNECTIONROLE_ACTPASS : CONNECTIONROLE_ACTIVE;
+    ConnectionRole remote_role =
+        (action == CA_OFFER) ? CONNECTIONROLE_ACTIVE : CONNECTIONROLE_ACTPASS;
+    TransportDescription local_desc(
+        NS_GINGLE_P2P, std::vector<std::string>(), kIceUfrag, kIcePwd,
+        ICEMODE_FULL, local_role, local_fingerprint.get(), Candidates());
+    TransportDescription remote_desc(
+        NS_GINGLE_P2P, std::vector<std::string>(), kIceUfrag, kIcePwd,
+        ICEMODE_FULL, remote_role, remote_fingerprint.get(), Candidates());
+    if (action == CA_OFFER) {
+      return transport_->SetLocalTransportDescription(local_desc, CA_OFFER,
+                                                      NULL) &&
+             transport_->SetRemoteTransportDescription(remote_desc, CA_ANSWER,
+                                                       NULL);
+    }
+    return transport_->SetRemoteTransportDescription(remote_desc, CA_OFFER,
+                                                     NULL) &&
+           transport_->SetLocalTransportDescription(local_desc, CA_ANSWER,
+                                                    NULL);
+  }
+
+  void Connect(DtlsSrtpEndpoint* peer) {
+    transport_->ConnectChannels();
+    transport_->SetDestination(peer->transport_.get());
+  }
+
+ private:
+  rtc::scoped_ptr<rtc::SSLIdentity> identity_;
+  rtc::scoped_ptr<FakeTransport> transport_;
+  DtlsTransportChannelWrapper* wrapper_;
+  TransportChannelProxy proxy_;
+  PacketReceiver receiver_;
+};
+
+class DtlsTransportChannelPerfTest : public testing::Test {
+ public:
+  static void SetUpTestCase() { rtc::InitializeSSL(); }
+  static void TearDownTestCase() { rtc::CleanupSSL(); }
+
+  DtlsTransportChannelPerfTest() : caller_("caller"), callee_("callee") {}
+
+  bool Connect() {
+    if (!caller_.Negotiate(&callee_, CA_OFFER) ||
+        !callee_.Negotiate(&caller_, CA_ANSWER)) {
+      return false;
+    }
+    caller_.Connect(&callee_);
+    callee_.Connect(&caller_);
+    EXPECT_TRUE_WAIT(caller_.proxy()->writable() &&
+                     callee_.proxy()->writable(), kConnectTimeoutMs);
+    std::string cipher;
+    return callee_.proxy()->writable() &&
+           callee_.proxy()->GetSrtpCipher(&cipher) && cipher == kSrtpCipher;
+  }
+
+  // Feeds |kNumPackets| SRTP packets to the callee as if they came off its
+  // socket, and prints the time and stack it takes each to reach the
+  // receiver.
+  void MeasureDemux(const std::string& trace) {
+    std::vector<char> packet(kPacketLen, 0x5a);
+    packet[0] = static_cast<char>(0x80);
+    packet[1] = 96;
+    FakeTransportChannel* channel = callee_.fake_channel();
+    PacketReceiver* receiver = callee_.receiver();
+    const int num_packets_before = receiver->num_packets();
+    rtc::PacketTime packet_time;
+
+    char top;
+    receiver->MarkStack(&top);
+    uint64 start_us = rtc::TimeMicros();
+    for (int i = 0; i < kNumPackets; ++i) {
+      channel->SignalReadPacket(channel, &packet[0], packet.size(),
+                                packet_time, 0);
+    }
+    uint64 elapsed_us = rtc::TimeMicros() - start_us;
+    EXPECT_EQ(kNumPackets, receiver->num_packets() - num_packets_before);
+
+    webrtc::test::PrintResult("dtls_srtp_demux_latency", "", trace,
+                              1000.0 * elapsed_us / kNumPackets, "ns", true);
+    webrtc::test::PrintResult("dtls_srtp_demux_stack_depth", "", trace,
+                              receiver->stack_depth(), "bytes", true);
+  }
+
+ protected:
+  DtlsSrtpEndpoint caller_;
+  DtlsSrtpEndpoint callee_;
+};
+
+}  // namespace
+
+// Compares the two ways an SRTP packet can get from the socket's channel to
+// the media channel: up through the DTLS wrapper's and the proxy's signals,
+// or straight from the DTLS wrapper to the sink that the media channel
+// registered.
+TEST_F(DtlsTransportChannelPerfTest, SrtpPacketDemux) {
+  if (!rtc::SSLStreamAdapter::HaveDtlsSrtp()) {
+    LOG(LS_INFO) << "Feature disabled... skipping";
+    return;
+  }
+  ASSERT_TRUE(Connect());
+  MeasureDemux("signal");
+
+  TransportChannelProxy* proxy = callee_.proxy();
+  proxy->SetSrtpPacketSink(callee_.receiver(), proxy);
+  MeasureDemux("sink");
+  proxy->SetSrtpPacketSink(NULL, proxy);
+}
+
+}  // namespace cricket
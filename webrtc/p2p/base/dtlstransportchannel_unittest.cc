@@ -8,10 +8,12 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
 #include <set>
 
 #include "webrtc/p2p/base/dtlstransport.h"
 #include "webrtc/p2p/base/fakesession.h"
+#include "webrtc/p2p/base/transportchannelproxy.h"
 #include "webrtc/base/common.h"
 #include "webrtc/base/dscp.h"
 #include "webrtc/base/gunit.h"
@@ -43,7 +45,8 @@ using cricket::ConnectionRole;
 
 enum Flags { NF_REOFFER = 0x1, NF_EXPECT_FAILURE = 0x2 };
 
-class DtlsTestClient : public sigslot::has_slots<> {
+class DtlsTestClient : public sigslot::has_slots<>,
+                       public cricket::SrtpPacketSink {
  public:
   DtlsTestClient(const std::string& name,
                  rtc::Thread* signaling_thread,
@@ -53,6 +56,8 @@ class DtlsTestClient : public sigslot::has_slots<> {
       worker_thread_(worker_thread),
       protocol_(cricket::ICEPROTO_GOOGLE),
       packet_size_(0),
+      num_sink_packets_(0),
+      use_srtp_packet_sink_(false),
       use_dtls_srtp_(false),
       ssl_max_version_(rtc::SSL_PROTOCOL_DTLS_10),
       negotiated_dtls_(false),
@@ -70,6 +75,10 @@ class DtlsTestClient : public sigslot::has_slots<> {
     ASSERT(identity_.get() != NULL);
     use_dtls_srtp_ = true;
   }
+  // Receive SRTP packets through SetSrtpPacketSink rather than the signal.
+  void SetupSrtpPacketSink() {
+    use_srtp_packet_sink_ = true;
+  }
   void SetupMaxProtocolVersion(rtc::SSLProtocolVersion version) {
     ASSERT(transport_.get() == NULL);
     ssl_max_version_ = version;
@@ -95,6 +104,9 @@ class DtlsTestClient : public sigslot::has_slots<> {
         &DtlsTestClient::OnTransportChannelWritableState);
       channel->SignalReadPacket.connect(this,
         &DtlsTestClient::OnTransportChannelReadPacket);
+      if (use_srtp_packet_sink_) {
+        channel->SetSrtpPacketSink(this, channel);
+      }
       channels_.push_back(channel);
 
       // Hook the raw packets so that we can verify they are encrypted.
@@ -288,6 +300,10 @@ class DtlsTestClient : public sigslot::has_slots<> {
     return received_.size();
   }
 
+  int NumSinkPacketsReceived() {
+    return num_sink_packets_;
+  }
+
   bool VerifyPacket(const char* data, size_t size, uint32* out_num) {
     if (size != packet_size_ ||
         (data[0] != 0 && static_cast<uint8>(data[0]) != 0x80)) {
@@ -342,6 +358,22 @@ class DtlsTestClient : public sigslot::has_slots<> {
     int expected_flags = (identity_.get() && IsRtpLeadByte(data[0])) ?
         cricket::PF_SRTP_BYPASS : 0;
     ASSERT_EQ(expected_flags, flags);
+    // And those should have gone to the sink, if there is one.
+    ASSERT_FALSE(use_srtp_packet_sink_ && expected_flags);
+  }
+
+  // SrtpPacketSink implementation.
+  void OnSrtpPacket(cricket::TransportChannel* channel,
+                    const char* data, size_t size,
+                    const rtc::PacketTime& packet_time,
+                    int flags) override {
+    ASSERT_TRUE(std::find(channels_.begin(), channels_.end(), channel) !=
+                channels_.end());
+    ASSERT_EQ(cricket::PF_SRTP_BYPASS, flags);
+    uint32 packet_num = 0;
+    ASSERT_TRUE(VerifyPacket(data, size, &packet_num));
+    received_.insert(packet_num);
+    ++num_sink_packets_;
   }
 
   // Hook into the raw packet stream to make sure DTLS packets are encrypted.
@@ -382,6 +414,8 @@ class DtlsTestClient : public sigslot::has_slots<> {
   std::vector<cricket::DtlsTransportChannelWrapper*> channels_;
   size_t packet_size_;
   std::set<int> received_;
+  int num_sink_packets_;
+  bool use_srtp_packet_sink_;
   bool use_dtls_srtp_;
   rtc::SSLProtocolVersion ssl_max_version_;
   bool negotiated_dtls_;
@@ -389,6 +423,28 @@ class DtlsTestClient : public sigslot::has_slots<> {
   bool received_dtls_server_hello_;
 };
 
+// Counts the SRTP packets that a media channel gets through its sink.
+class SrtpPacketCounter : public cricket::SrtpPacketSink {
+ public:
+  explicit SrtpPacketCounter(cricket::TransportChannel* channel)
+      : channel_(channel), num_packets_(0) {}
+
+  int num_packets() const { return num_packets_; }
+
+  // SrtpPacketSink implementation.
+  void OnSrtpPacket(cricket::TransportChannel* channel,
+                    const char* data, size_t size,
+                    const rtc::PacketTime& packet_time,
+                    int flags) override {
+    EXPECT_EQ(channel_, channel);
+    EXPECT_EQ(cricket::PF_SRTP_BYPASS, flags);
+    ++num_packets_;
+  }
+
+ private:
+  cricket::TransportChannel* channel_;
+  int num_packets_;
+};
 
 class DtlsTransportChannelTest : public testing::Test {
  public:
@@ -690,6 +746,54 @@ TEST_F(DtlsTransportChannelTest, TestTransferDtlsSrtp) {
   TestTransfer(0, 1000, 100, true);
 }
 
+// Connect with DTLS-SRTP and check that the bypass packets go to the sink
+// that the receiver registered, rather than to SignalReadPacket.
+TEST_F(DtlsTransportChannelTest, TestTransferDtlsSrtpToPacketSink) {
+  MAYBE_SKIP_TEST(HaveDtlsSrtp);
+  SetChannelCount(2);
+  PrepareDtls(true, true);
+  PrepareDtlsSrtp(true, true);
+  client2_.SetupSrtpPacketSink();
+  ASSERT_TRUE(Connect());
+  TestTransfer(0, 1000, 100, true);
+  TestTransfer(1, 1000, 100, true);
+  EXPECT_EQ(200, client2_.NumSinkPacketsReceived());
+  // Packets that aren't SRTP still use the signal.
+  TestTransfer(0, 1000, 100, false);
+  EXPECT_EQ(200, client2_.NumSinkPacketsReceived());
+}
+
+// Connect with DTLS-SRTP and check that two proxies bundled on the same
+// channel, like the audio and video channels with BUNDLE, each get the
+// bypass packets through their own sink, and can unregister independently.
+TEST_F(DtlsTransportChannelTest, TestTransferDtlsSrtpToBundledPacketSinks) {
+  MAYBE_SKIP_TEST(HaveDtlsSrtp);
+  PrepareDtls(true, true);
+  PrepareDtlsSrtp(true, true);
+  ASSERT_TRUE(Connect());
+
+  cricket::TransportChannelProxy audio_proxy("audio", 0);
+  cricket::TransportChannelProxy video_proxy("video", 0);
+  audio_proxy.SetImplementation(client2_.transport()->CreateChannel(0));
+  video_proxy.SetImplementation(client2_.transport()->CreateChannel(0));
+  SrtpPacketCounter audio_sink(&audio_proxy);
+  SrtpPacketCounter video_sink(&video_proxy);
+  audio_proxy.SetSrtpPacketSink(&audio_sink, &audio_proxy);
+  video_proxy.SetSrtpPacketSink(&video_sink, &video_proxy);
+
+  client2_.ExpectPackets(0, 1000);
+  client1_.SendPackets(0, 1000, 100, true);
+  EXPECT_EQ_WAIT(100, audio_sink.num_packets(), 10000);
+  EXPECT_EQ_WAIT(100, video_sink.num_packets(), 10000);
+
+  // Disconnecting the audio channel leaves the video sink in place.
+  audio_proxy.SetSrtpPacketSink(NULL, &audio_proxy);
+  client1_.SendPackets(0, 1000, 100, true);
+  EXPECT_EQ_WAIT(200, video_sink.num_packets(), 10000);
+  EXPECT_EQ(100, audio_sink.num_packets());
+  EXPECT_EQ(0U, client2_.NumPacketsReceived());
+}
+
 // Connect with DTLS-SRTP, transfer an invalid SRTP packet, and expects -1
 // returned.
 TEST_F(DtlsTransportChannelTest, TestTransferDtlsInvalidSrtpPacket) {
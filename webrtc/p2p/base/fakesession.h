@@ -237,6 +237,10 @@ class FakeTransportChannel : public TransportChannelImpl,
     return true;
   }
 
+  const std::vector<std::string>& srtp_ciphers() const {
+    return srtp_ciphers_;
+  }
+
   virtual bool GetSrtpCipher(std::string* cipher) {
     if (!chosen_srtp_cipher_.empty()) {
       *cipher = chosen_srtp_cipher_;
@@ -10,6 +10,7 @@
 
 #include "webrtc/p2p/base/p2ptransportchannel.h"
 
+#include <algorithm>
 #include <set>
 #include "webrtc/p2p/base/common.h"
 #include "webrtc/p2p/base/relayport.h"  // For RELAY_PORT_TYPE.
@@ -174,6 +175,42 @@ bool ShouldSwitch(cricket::Connection* a_conn, cricket::Connection* b_conn) {
 
 namespace cricket {
 
+bool ConnectionQueue::Entry::operator<(const Entry& other) const {
+  if (time != other.time)
+    return time < other.time;
+  if (priority != other.priority)
+    return priority > other.priority;
+  return connection < other.connection;
+}
+
+void ConnectionQueue::Set(Connection* connection, uint32 time) {
+  Entry entry = {time, connection->priority(), connection};
+  std::map<Connection*, std::set<Entry>::iterator>::iterator it =
+      positions_.find(connection);
+  if (it != positions_.end()) {
+    if (it->second->time == time && it->second->priority == entry.priority)
+      return;
+    entries_.erase(it->second);
+  }
+  positions_[connection] = entries_.insert(entry).first;
+}
+
+void ConnectionQueue::Remove(Connection* connection) {
+  std::map<Connection*, std::set<Entry>::iterator>::iterator it =
+      positions_.find(connection);
+  if (it == positions_.end())
+    return;
+  entries_.erase(it->second);
+  positions_.erase(it);
+}
+
+bool P2PTransportChannel::ConnectionRank::operator==(
+    const ConnectionRank& other) const {
+  return write_state == other.write_state && connected == other.connected &&
+         priority == other.priority && generation == other.generation &&
+         rtt == other.rtt;
+}
+
 P2PTransportChannel::P2PTransportChannel(const std::string& content_name,
                                          int component,
                                          P2PTransport* transport,
@@ -187,6 +224,7 @@ P2PTransportChannel::P2PTransportChannel(const std::string& content_name,
     error_(0),
     best_connection_(NULL),
     pending_best_connection_(NULL),
+    connections_added_(0),
     sort_dirty_(false),
     was_writable_(false),
     protocol_type_(ICEPROTO_HYBRID),
@@ -224,6 +262,7 @@ void P2PTransportChannel::AddAllocatorSession(PortAllocatorSession* session) {
 
 void P2PTransportChannel::AddConnection(Connection* connection) {
   connections_.push_back(connection);
+  connection_order_[connection] = connections_added_++;
   connection->set_remote_ice_mode(remote_ice_mode_);
   connection->SignalReadPacket.connect(
       this, &P2PTransportChannel::OnReadPacket);
@@ -231,10 +270,13 @@ void P2PTransportChannel::AddConnection(Connection* connection) {
       this, &P2PTransportChannel::OnReadyToSend);
   connection->SignalStateChange.connect(
       this, &P2PTransportChannel::OnConnectionStateChange);
+  connection->SignalPingReceived.connect(
+      this, &P2PTransportChannel::OnConnectionPingReceived);
   connection->SignalDestroyed.connect(
       this, &P2PTransportChannel::OnConnectionDestroyed);
   connection->SignalUseCandidate.connect(
       this, &P2PTransportChannel::OnUseCandidate);
+  UpdatePingQueues(connection);
 }
 
 void P2PTransportChannel::SetIceRole(IceRole ice_role) {
@@ -341,6 +383,8 @@ void P2PTransportChannel::SetRemoteIceCredentials(const std::string& ice_ufrag,
   for (; it != connections_.end(); ++it) {
     (*it)->MaybeSetRemoteIceCredentials(ice_ufrag, ice_pwd);
   }
+  // Connections without credentials may be pingable now.
+  UpdateAllPingQueues();
 
   if (ice_restart) {
     // |candidate.generation()| is not signaled in ICEPROTO_RFC5245.
@@ -978,9 +1022,42 @@ void P2PTransportChannel::SortConnections() {
   // that amongst equal preference, writable connections, this will choose the
   // one whose estimated latency is lowest.  So it is the only one that we
   // need to consider switching to.
-
+  //
+  // The connections were in order as of the last sort, and most of them have
+  // not changed since, so only the ones that have are taken out and put back
+  // in place.
+  std::vector<Connection*> moved;
+  std::vector<Connection*>::iterator kept = connections_.begin();
+  for (uint32 i = 0; i < connections_.size(); ++i) {
+    Connection* conn = connections_[i];
+    ConnectionRank rank = {conn->write_state(), conn->connected(),
+                           conn->priority(),
+                           conn->remote_candidate().generation() +
+                               conn->port()->generation(),
+                           conn->rtt()};
+    std::map<Connection*, ConnectionRank>::iterator old_rank =
+        connection_ranks_.find(conn);
+    if (old_rank == connection_ranks_.end() || !(old_rank->second == rank)) {
+      connection_ranks_[conn] = rank;
+      moved.push_back(conn);
+    } else {
+      *kept++ = conn;
+    }
+  }
+  connections_.erase(kept, connections_.end());
   ConnectionCompare cmp;
-  std::stable_sort(connections_.begin(), connections_.end(), cmp);
+  for (uint32 i = 0; i < moved.size(); ++i) {
+    std::vector<Connection*>::iterator pos = std::lower_bound(
+        connections_.begin(), connections_.end(), moved[i], cmp);
+    std::vector<Connection*>::iterator end =
+        std::upper_bound(pos, connections_.end(), moved[i], cmp);
+    // Among connections that rank the same, keep the order they were added
+    // in, as repeated stable sorts would.
+    const uint32 order = connection_order_[moved[i]];
+    while (pos != end && connection_order_[*pos] < order)
+      ++pos;
+    connections_.insert(pos, moved[i]);
+  }
   LOG(LS_VERBOSE) << "Sorting available connections:";
   for (uint32 i = 0; i < connections_.size(); ++i) {
     LOG(LS_VERBOSE) << connections_[i]->ToString();
@@ -1105,7 +1182,10 @@ void P2PTransportChannel::HandleWritable() {
   }
 
   was_writable_ = true;
-  set_writable(true);
+  if (!writable()) {
+    set_writable(true);
+    UpdateAllPingQueues();
+  }
 }
 
 // Notify upper layer about channel not writable state, if it was before.
@@ -1114,6 +1194,7 @@ void P2PTransportChannel::HandleNotWritable() {
   if (was_writable_) {
     was_writable_ = false;
     set_writable(false);
+    UpdateAllPingQueues();
   }
 }
 
@@ -1210,8 +1291,29 @@ bool P2PTransportChannel::IsPingable(Connection* conn) {
   }
 }
 
+// Puts |conn| in the ping queues it belongs in, and takes it out of the
+// others. Called whenever anything IsPingable() looks at may have changed.
+void P2PTransportChannel::UpdatePingQueues(Connection* conn) {
+  if (!IsPingable(conn)) {
+    triggered_checks_.Remove(conn);
+    ping_queue_.Remove(conn);
+    return;
+  }
+  ping_queue_.Set(conn, conn->last_ping_sent());
+  if (!conn->writable() && conn->last_ping_received() > conn->last_ping_sent())
+    triggered_checks_.Set(conn, conn->last_ping_received());
+  else
+    triggered_checks_.Remove(conn);
+}
+
+void P2PTransportChannel::UpdateAllPingQueues() {
+  for (uint32 i = 0; i < connections_.size(); ++i)
+    UpdatePingQueues(connections_[i]);
+}
+
 // Returns the next pingable connection to ping.  This will be the oldest
-// pingable connection unless we have a connected, writable connection that is
+// pingable connection (the highest priority one if several were pinged at the
+// same time) unless we have a connected, writable connection that is
 // past the maximum acceptable ping delay. When reconnecting a TCP connection,
 // the best connection is disconnected, although still WRITABLE while
 // reconnecting. The newly created connection should be selected as the ping
@@ -1229,33 +1331,24 @@ Connection* P2PTransportChannel::FindNextPingableConnection() {
   // that have received a ping but have not sent a ping since receiving
   // it (last_received_ping > last_sent_ping).  But we shouldn't do
   // triggered checks if the connection is already writable.
-  Connection* oldest_needing_triggered_check = nullptr;
-  Connection* oldest = nullptr;
-  for (Connection* conn : connections_) {
-    if (!IsPingable(conn)) {
-      continue;
-    }
-    bool needs_triggered_check =
-        (protocol_type_ == ICEPROTO_RFC5245 &&
-         !conn->writable() &&
-         conn->last_ping_received() > conn->last_ping_sent());
-    if (needs_triggered_check &&
-        (!oldest_needing_triggered_check ||
-         (conn->last_ping_received() <
-          oldest_needing_triggered_check->last_ping_received()))) {
-      oldest_needing_triggered_check = conn;
-    }
-    if (!oldest || (conn->last_ping_sent() < oldest->last_ping_sent())) {
-      oldest = conn;
-    }
+  if (protocol_type_ == ICEPROTO_RFC5245 && triggered_checks_.size() > 0) {
+    Connection* conn = triggered_checks_.begin()->connection;
+    ASSERT(!conn->writable() &&
+           conn->last_ping_received() > conn->last_ping_sent() &&
+           IsPingable(conn));
+    LOG(LS_INFO) << "Selecting connection for triggered check: " <<
+        conn->ToString();
+    return conn;
   }
 
-  if (oldest_needing_triggered_check) {
-    LOG(LS_INFO) << "Selecting connection for triggered check: " <<
-        oldest_needing_triggered_check->ToString();
-    return oldest_needing_triggered_check;
+  // Otherwise, the one pinged the longest ago.
+  if (ping_queue_.size() > 0) {
+    Connection* conn = ping_queue_.begin()->connection;
+    ASSERT(ping_queue_.begin()->time == conn->last_ping_sent());
+    ASSERT(IsPingable(conn));
+    return conn;
   }
-  return oldest;
+  return nullptr;
 }
 
 // Apart from sending ping from |conn| this method also updates
@@ -1283,7 +1376,9 @@ void P2PTransportChannel::PingConnection(Connection* conn) {
     }
   }
   conn->set_use_candidate_attr(use_candidate);
-  conn->Ping(rtc::Time());
+  uint32 now = rtc::Time();
+  conn->Ping(now);
+  UpdatePingQueues(conn);
 }
 
 // When a connection's state changes, we need to figure out who to use as
@@ -1302,11 +1397,19 @@ void P2PTransportChannel::OnConnectionStateChange(Connection* connection) {
     }
   }
 
+  UpdatePingQueues(connection);
+
   // We have to unroll the stack before doing this because we may be changing
   // the state of connections while sorting.
   RequestSort();
 }
 
+// A ping from the other side may call for a triggered check.
+void P2PTransportChannel::OnConnectionPingReceived(Connection* connection) {
+  ASSERT(worker_thread_ == rtc::Thread::Current());
+  UpdatePingQueues(connection);
+}
+
 // When a connection is removed, edit it out, and then update our best
 // connection.
 void P2PTransportChannel::OnConnectionDestroyed(Connection* connection) {
@@ -1320,6 +1423,10 @@ void P2PTransportChannel::OnConnectionDestroyed(Connection* connection) {
       std::find(connections_.begin(), connections_.end(), connection);
   ASSERT(iter != connections_.end());
   connections_.erase(iter);
+  connection_ranks_.erase(connection);
+  connection_order_.erase(connection);
+  triggered_checks_.Remove(connection);
+  ping_queue_.Remove(connection);
 
   LOG_J(LS_INFO, this) << "Removed connection ("
     << static_cast<int>(connections_.size()) << " remaining)";
@@ -21,6 +21,7 @@
 #define WEBRTC_P2P_BASE_P2PTRANSPORTCHANNEL_H_
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include "webrtc/p2p/base/candidate.h"
@@ -46,6 +47,36 @@ class RemoteCandidate : public Candidate {
   PortInterface* origin_port_;
 };
 
+// Keeps connections ordered by a time, the earliest first, and amongst the
+// ones with the same time by priority, the highest first. This lets
+// P2PTransportChannel find the next connection to ping without looking at all
+// of them.
+class ConnectionQueue {
+ public:
+  struct Entry {
+    uint32 time;
+    uint64 priority;
+    Connection* connection;
+
+    bool operator<(const Entry& other) const;
+  };
+  typedef std::set<Entry>::const_iterator const_iterator;
+
+  // Queues |connection| at |time|, or moves it there if it is queued already.
+  // It is ordered by the priority it has at that point.
+  void Set(Connection* connection, uint32 time);
+  void Remove(Connection* connection);
+
+  const_iterator begin() const { return entries_.begin(); }
+  const_iterator end() const { return entries_.end(); }
+  size_t size() const { return entries_.size(); }
+
+ private:
+  std::set<Entry> entries_;
+  // Where each connection is in |entries_|.
+  std::map<Connection*, std::set<Entry>::iterator> positions_;
+};
+
 // P2PTransportChannel manages the candidates and connection process to keep
 // two P2P clients connected to each other.
 class P2PTransportChannel : public TransportChannelImpl,
@@ -184,6 +215,8 @@ class P2PTransportChannel : public TransportChannelImpl,
   void RememberRemoteCandidate(const Candidate& remote_candidate,
                                PortInterface* origin_port);
   bool IsPingable(Connection* conn);
+  void UpdatePingQueues(Connection* conn);
+  void UpdateAllPingQueues();
   void PingConnection(Connection* conn);
   void AddAllocatorSession(PortAllocatorSession* session);
   void AddConnection(Connection* connection);
@@ -202,6 +235,7 @@ class P2PTransportChannel : public TransportChannelImpl,
   void OnRoleConflict(PortInterface* port);
 
   void OnConnectionStateChange(Connection* connection);
+  void OnConnectionPingReceived(Connection* connection);
   void OnReadPacket(Connection *connection, const char *data, size_t len,
                     const rtc::PacketTime& packet_time);
   void OnReadyToSend(Connection* connection);
@@ -222,6 +256,28 @@ class P2PTransportChannel : public TransportChannelImpl,
   std::vector<PortAllocatorSession*> allocator_sessions_;
   std::vector<PortInterface *> ports_;
   std::vector<Connection *> connections_;
+  // What the order of |connections_| depends on, as of the last sort. Only
+  // the connections for which this has changed need to be moved.
+  struct ConnectionRank {
+    int write_state;
+    bool connected;
+    uint64 priority;
+    uint32 generation;
+    uint32 rtt;
+
+    bool operator==(const ConnectionRank& other) const;
+  };
+  std::map<Connection*, ConnectionRank> connection_ranks_;
+  // The order in which the connections were added. Connections that rank the
+  // same are kept in this order.
+  std::map<Connection*, uint32> connection_order_;
+  uint32 connections_added_;
+  // Pingable connections are looked for in these, in order: the unwritable
+  // ones which have been pinged by the other side since we last pinged them,
+  // and then all of them by the time we last pinged them. Connections are
+  // only in these while they are pingable, so the first one is picked.
+  ConnectionQueue triggered_checks_;
+  ConnectionQueue ping_queue_;
   Connection* best_connection_;
   // Connection selected by the controlling agent. This should be used only
   // at controlled side when protocol type is RFC5245.
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "webrtc/p2p/base/p2ptransportchannel.h"
+#include "webrtc/p2p/client/fakeportallocator.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/base/virtualsocketserver.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+// Many interfaces times many TURN servers on the remote side.
+const int kNumRemoteCandidates = 512;
+const int kNumSelections = 100000;
+const int kTimeoutMs = 3000;
+const char kIceUfrag[] = "UF00";
+const char kIcePwd[] = "TESTICEPWD00000000000000";
+const char kRemoteIceUfrag[] = "UF01";
+const char kRemoteIcePwd[] = "TESTICEPWD00000000000001";
+
+// A single channel with a connection to each of |kNumRemoteCandidates|
+// candidates.
+class P2PTransportChannelPerfTest : public testing::Test,
+                                    public sigslot::has_slots<> {
+ public:
+  P2PTransportChannelPerfTest()
+      : pss_(new rtc::PhysicalSocketServer),
+        vss_(new rtc::VirtualSocketServer(pss_.get())),
+        ss_scope_(vss_.get()),
+        allocator_(rtc::Thread::Current(), nullptr),
+        channel_("perf", 1, nullptr, &allocator_) {}
+
+ protected:
+  void CreateConnections() {
+    channel_.SignalRequestSignaling.connect(
+        this, &P2PTransportChannelPerfTest::OnRequestSignaling);
+    channel_.SetIceProtocolType(ICEPROTO_RFC5245);
+    channel_.SetIceRole(ICEROLE_CONTROLLING);
+    channel_.SetIceCredentials(kIceUfrag, kIcePwd);
+    channel_.SetRemoteIceCredentials(kRemoteIceUfrag, kRemoteIcePwd);
+    channel_.Connect();
+    for (int i = 0; i < kNumRemoteCandidates; ++i) {
+      Candidate candidate;
+      candidate.set_address(rtc::SocketAddress(
+          "10.0." + rtc::ToString(i / 256) + "." + rtc::ToString(i % 256),
+          1000 + i));
+      candidate.set_component(1);
+      candidate.set_protocol(UDP_PROTOCOL_NAME);
+      candidate.set_priority(1000 + i);
+      channel_.OnCandidate(candidate);
+    }
+    EXPECT_TRUE_WAIT(GetConnections() == kNumRemoteCandidates, kTimeoutMs);
+  }
+
+  int GetConnections() {
+    connections_.clear();
+    if (channel_.ports().empty())
+      return 0;
+    Port* port = static_cast<Port*>(channel_.ports()[0]);
+    for (int i = 0; i < kNumRemoteCandidates; ++i) {
+      Connection* conn = port->GetConnection(rtc::SocketAddress(
+          "10.0." + rtc::ToString(i / 256) + "." + rtc::ToString(i % 256),
+          1000 + i));
+      if (conn)
+        connections_.push_back(conn);
+    }
+    return static_cast<int>(connections_.size());
+  }
+
+  void OnRequestSignaling(TransportChannelImpl* channel) {
+    channel->OnSignalingReady();
+  }
+
+  rtc::scoped_ptr<rtc::PhysicalSocketServer> pss_;
+  rtc::scoped_ptr<rtc::VirtualSocketServer> vss_;
+  rtc::SocketServerScope ss_scope_;
+  FakePortAllocator allocator_;
+  P2PTransportChannel channel_;
+  std::vector<Connection*> connections_;
+};
+
+}  // namespace
+
+TEST_F(P2PTransportChannelPerfTest, PingSelectionAndSorting) {
+  CreateConnections();
+  ASSERT_EQ(kNumRemoteCandidates, static_cast<int>(connections_.size()));
+
+  uint64 start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumSelections; ++i)
+    EXPECT_TRUE(channel_.FindNextPingableConnection() != nullptr);
+  uint64 elapsed_us = rtc::TimeMicros() - start_us;
+  webrtc::test::PrintResult("ice_ping_selection_rate", "", "512_pairs",
+                            1e6 * kNumSelections /
+                                std::max<uint64>(elapsed_us, 1),
+                            "selections/s", true);
+
+  // Each ping received makes a connection readable, which is followed by a
+  // sort.
+  start_us = rtc::TimeMicros();
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    connections_[i]->ReceivedPing();
+    rtc::Thread::Current()->ProcessMessages(0);
+  }
+  elapsed_us = rtc::TimeMicros() - start_us;
+  webrtc::test::PrintResult("ice_sort_rate", "", "512_pairs",
+                            1e6 * connections_.size() /
+                                std::max<uint64>(elapsed_us, 1),
+                            "sorts/s", true);
+}
+
+}  // namespace cricket
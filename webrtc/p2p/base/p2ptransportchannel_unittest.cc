@@ -1712,12 +1712,17 @@ class P2PTransportChannelPingTest : public testing::Test,
 
  protected:
   void PrepareChannel(cricket::P2PTransportChannel* ch) {
+    PrepareChannelWithoutRemoteCredentials(ch);
+    ch->SetRemoteIceCredentials(kIceUfrag[1], kIcePwd[1]);
+  }
+
+  void PrepareChannelWithoutRemoteCredentials(
+      cricket::P2PTransportChannel* ch) {
     ch->SignalRequestSignaling.connect(
         this, &P2PTransportChannelPingTest::OnChannelRequestSignaling);
     ch->SetIceProtocolType(cricket::ICEPROTO_RFC5245);
     ch->SetIceRole(cricket::ICEROLE_CONTROLLING);
     ch->SetIceCredentials(kIceUfrag[0], kIcePwd[0]);
-    ch->SetRemoteIceCredentials(kIceUfrag[1], kIcePwd[1]);
   }
 
   void OnChannelRequestSignaling(cricket::TransportChannelImpl* channel) {
@@ -1813,6 +1818,54 @@ TEST_F(P2PTransportChannelPingTest, TestNoTriggeredChecksWhenWritable) {
   EXPECT_EQ(conn2, ch.FindNextPingableConnection());
 }
 
+// Connections are only queued for pinging while they are pingable, so check
+// that one is queued again once it becomes pingable.
+TEST_F(P2PTransportChannelPingTest, TestConnectionBecomesPingable) {
+  cricket::FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  cricket::P2PTransportChannel ch("becomes pingable", 1, nullptr, &pa);
+  PrepareChannelWithoutRemoteCredentials(&ch);
+  ch.Connect();
+  cricket::Candidate candidate = CreateCandidate("1.1.1.1", 1, 1);
+  candidate.set_username(kIceUfrag[1]);
+  ch.OnCandidate(candidate);
+
+  cricket::Connection* conn1 = WaitForConnectionTo(&ch, "1.1.1.1", 1);
+  ASSERT_TRUE(conn1 != nullptr);
+  // Without the remote password, it can't be pinged.
+  EXPECT_EQ(nullptr, ch.FindNextPingableConnection());
+
+  ch.SetRemoteIceCredentials(kIceUfrag[1], kIcePwd[1]);
+  EXPECT_EQ(conn1, ch.FindNextPingableConnection());
+}
+
+// Connections are only moved when their state changes, so check that the best
+// connection still follows the state changes.
+TEST_F(P2PTransportChannelPingTest, TestBestConnectionFollowsStateChanges) {
+  cricket::FakePortAllocator pa(rtc::Thread::Current(), nullptr);
+  cricket::P2PTransportChannel ch("state changes", 1, nullptr, &pa);
+  PrepareChannel(&ch);
+  ch.Connect();
+  ch.OnCandidate(CreateCandidate("1.1.1.1", 1, 1));
+  ch.OnCandidate(CreateCandidate("2.2.2.2", 2, 2));
+  ch.OnCandidate(CreateCandidate("3.3.3.3", 3, 3));
+
+  cricket::Connection* conn1 = WaitForConnectionTo(&ch, "1.1.1.1", 1);
+  cricket::Connection* conn2 = WaitForConnectionTo(&ch, "2.2.2.2", 2);
+  cricket::Connection* conn3 = WaitForConnectionTo(&ch, "3.3.3.3", 3);
+  ASSERT_TRUE(conn1 != nullptr);
+  ASSERT_TRUE(conn2 != nullptr);
+  ASSERT_TRUE(conn3 != nullptr);
+  EXPECT_EQ(conn3, ch.FindNextPingableConnection());
+
+  // A writable connection beats higher priority ones which aren't.
+  conn1->ReceivedPingResponse();
+  EXPECT_EQ_WAIT(conn1, ch.best_connection(), 1000);
+
+  // Once it is writable too, the higher priority one takes over.
+  conn2->ReceivedPingResponse();
+  EXPECT_EQ_WAIT(conn2, ch.best_connection(), 1000);
+}
+
 TEST_F(P2PTransportChannelPingTest, ConnectionResurrection) {
   cricket::FakePortAllocator pa(rtc::Thread::Current(), nullptr);
   cricket::P2PTransportChannel ch("connection resurrection", 1, nullptr, &pa);
@@ -26,6 +26,10 @@
 
 namespace {
 
+// The header plus RETRANSMIT-COUNT, an IPv6 XOR-MAPPED-ADDRESS,
+// MESSAGE-INTEGRITY and FINGERPRINT, with room to spare.
+const size_t kMaxIceBindingResponseSize = 128;
+
 // Determines whether we have seen at least the given maximum number of
 // pings fail to have a response.
 inline bool TooManyFailures(
@@ -368,9 +372,16 @@ bool Port::GetStunMessage(const char* data, size_t size,
   out_username->clear();
 
   // Don't bother parsing the packet if we can tell it's not STUN.
-  // In ICE mode, all STUN packets will have a valid fingerprint.
-  if (IsStandardIce() && !StunMessage::ValidateFingerprint(data, size)) {
-    return false;
+  // In ICE mode, all STUN packets will have a valid fingerprint. Otherwise,
+  // check the framing without allocating anything, as media packets come
+  // through here too.
+  if (IsStandardIce()) {
+    if (!StunMessage::ValidateFingerprint(data, size))
+      return false;
+  } else {
+    StunMessageView view;
+    if (!view.Parse(data, size))
+      return false;
   }
 
   // Parse the request message.  If the packet is not a complete and correct
@@ -608,37 +619,61 @@ void Port::SendBindingResponse(StunMessage* request,
     return;
   }
 
-  // Fill in the response message.
+  // ICE responses are written straight into a buffer on the stack; they are
+  // sent for every connectivity check received.
+  char ice_response[kMaxIceBindingResponseSize];
+  StunMessageBuilder builder(ice_response, sizeof(ice_response));
   StunMessage response;
-  response.SetType(STUN_BINDING_RESPONSE);
-  response.SetTransactionID(request->transaction_id());
+  rtc::ByteBuffer buf;
+  const char* data = ice_response;
+  size_t size = 0;
+  const std::string& transaction_id = request->transaction_id();
   const StunUInt32Attribute* retransmit_attr =
       request->GetUInt32(STUN_ATTR_RETRANSMIT_COUNT);
-  if (retransmit_attr) {
-    // Inherit the incoming retransmit value in the response so the other side
-    // can see our view of lost pings.
-    response.AddAttribute(new StunUInt32Attribute(
-        STUN_ATTR_RETRANSMIT_COUNT, retransmit_attr->value()));
-
-    if (retransmit_attr->value() > CONNECTION_WRITE_CONNECT_FAILURES) {
-      LOG_J(LS_INFO, this)
-          << "Received a remote ping with high retransmit count: "
-          << retransmit_attr->value();
-    }
+  if (retransmit_attr &&
+      retransmit_attr->value() > CONNECTION_WRITE_CONNECT_FAILURES) {
+    LOG_J(LS_INFO, this)
+        << "Received a remote ping with high retransmit count: "
+        << retransmit_attr->value();
   }
 
   // Only GICE messages have USERNAME and MAPPED-ADDRESS in the response.
   // ICE messages use XOR-MAPPED-ADDRESS, and add MESSAGE-INTEGRITY.
+  // Both inherit the incoming retransmit value in the response so the other
+  // side can see our view of lost pings.
   if (IsStandardIce()) {
-    response.AddAttribute(
-        new StunXorAddressAttribute(STUN_ATTR_XOR_MAPPED_ADDRESS, addr));
-    response.AddMessageIntegrity(password_);
-    response.AddFingerprint();
-  } else if (IsGoogleIce()) {
-    response.AddAttribute(
-        new StunAddressAttribute(STUN_ATTR_MAPPED_ADDRESS, addr));
-    response.AddAttribute(new StunByteStringAttribute(
-        STUN_ATTR_USERNAME, username_attr->GetString()));
+    bool built = builder.Start(STUN_BINDING_RESPONSE, transaction_id.data(),
+                               transaction_id.size());
+    if (retransmit_attr) {
+      built = built && builder.AddUInt32(STUN_ATTR_RETRANSMIT_COUNT,
+                                         retransmit_attr->value());
+    }
+    built = built &&
+        builder.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, addr) &&
+        builder.AddMessageIntegrity(password_) &&
+        builder.AddFingerprint();
+    if (!built) {
+      LOG_J(LS_ERROR, this) << "Failed to build STUN ping response"
+                            << ", to=" << addr.ToSensitiveString();
+      return;
+    }
+    size = builder.size();
+  } else {
+    response.SetType(STUN_BINDING_RESPONSE);
+    response.SetTransactionID(transaction_id);
+    if (retransmit_attr) {
+      response.AddAttribute(new StunUInt32Attribute(
+          STUN_ATTR_RETRANSMIT_COUNT, retransmit_attr->value()));
+    }
+    if (IsGoogleIce()) {
+      response.AddAttribute(
+          new StunAddressAttribute(STUN_ATTR_MAPPED_ADDRESS, addr));
+      response.AddAttribute(new StunByteStringAttribute(
+          STUN_ATTR_USERNAME, username_attr->GetString()));
+    }
+    response.Write(&buf);
+    data = buf.Data();
+    size = buf.Length();
   }
 
   // The fact that we received a successful request means that this connection
@@ -646,16 +681,14 @@ void Port::SendBindingResponse(StunMessage* request,
   Connection* conn = GetConnection(addr);
 
   // Send the response message.
-  rtc::ByteBuffer buf;
-  response.Write(&buf);
   rtc::PacketOptions options(DefaultDscpValue());
-  auto err = SendTo(buf.Data(), buf.Length(), addr, options, false);
+  auto err = SendTo(data, size, addr, options, false);
   if (err < 0) {
     LOG_J(LS_ERROR, this)
         << "Failed to send STUN ping response"
         << ", to=" << addr.ToSensitiveString()
         << ", err=" << err
-        << ", id=" << rtc::hex_encode(response.transaction_id());
+        << ", id=" << rtc::hex_encode(transaction_id);
   } else {
     // Log at LS_INFO if we send a stun ping response on an unwritable
     // connection.
@@ -664,7 +697,7 @@ void Port::SendBindingResponse(StunMessage* request,
     LOG_JV(sev, this)
         << "Sent STUN ping response"
         << ", to=" << addr.ToSensitiveString()
-        << ", id=" << rtc::hex_encode(response.transaction_id());
+        << ", id=" << rtc::hex_encode(transaction_id);
   }
 
   ASSERT(conn != NULL);
@@ -972,6 +1005,7 @@ void Connection::set_connected(bool value) {
   if (value != old_value) {
     LOG_J(LS_VERBOSE, this) << "set_connected from: " << old_value << " to "
                             << value;
+    SignalStateChange(this);
   }
 }
 
@@ -1238,6 +1272,7 @@ void Connection::Ping(uint32 now) {
 void Connection::ReceivedPing() {
   last_ping_received_ = rtc::Time();
   set_read_state(STATE_READABLE);
+  SignalPingReceived(this);
 }
 
 void Connection::ReceivedPingResponse() {
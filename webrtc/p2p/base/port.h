@@ -525,6 +525,8 @@ class Connection : public rtc::MessageHandler,
   // public because the connection intercepts the first ping for us.
   uint32 last_ping_received() const { return last_ping_received_; }
   void ReceivedPing();
+  // Sent by ReceivedPing().
+  sigslot::signal1<Connection*> SignalPingReceived;
 
   // Debugging description of this connection
   std::string ToDebugId() const;
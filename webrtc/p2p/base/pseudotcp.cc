@@ -71,8 +71,10 @@ const uint32 UDP_HEADER_SIZE = 8;
 const uint32 JINGLE_HEADER_SIZE = 64; // when relay framing is in use
 
 // Default size for receive and send buffer.
-const uint32 DEFAULT_RCV_BUF_SIZE = 60 * 1024;
-const uint32 DEFAULT_SND_BUF_SIZE = 90 * 1024;
+const uint32 DEFAULT_RCV_BUF_SIZE = 256 * 1024;
+const uint32 DEFAULT_SND_BUF_SIZE = 384 * 1024;
+// Receive buffer size to fall back to if the peer can't scale windows.
+const uint32 UNSCALED_RCV_BUF_SIZE = 60 * 1024;
 
 //////////////////////////////////////////////////////////////////////
 // Global Constants and Functions
@@ -112,6 +114,8 @@ const uint32 DEF_ACK_DELAY = 100; // 100 milliseconds
 
 const uint8 FLAG_CTL = 0x02;
 const uint8 FLAG_RST = 0x04;
+// The payload is SACK blocks rather than data.
+const uint8 FLAG_SACK = 0x08;
 
 const uint8 CTL_CONNECT = 0;
 
@@ -120,6 +124,15 @@ const uint8 TCP_OPT_EOL = 0;  // End of list.
 const uint8 TCP_OPT_NOOP = 1;  // No-op.
 const uint8 TCP_OPT_MSS = 2;  // Maximum segment size.
 const uint8 TCP_OPT_WND_SCALE = 3;  // Window scale factor.
+const uint8 TCP_OPT_SACK_PERMITTED = 4;  // Selective acknowledgement.
+
+// The largest window scale factor (RFC 7323, Sec 2.3).
+const uint8 MAX_WND_SCALE = 14;
+
+// A SACK block is the first and one past the last sequence number of a range
+// of received data. Up to 4 are sent, from the lowest sequence number up.
+const uint32 SACK_BLOCK_SIZE = 8;
+const uint32 MAX_SACK_BLOCKS = 4;
 
 const long DEFAULT_TIMEOUT = 4000; // If there are no pending clocks, wake up every 4 seconds
 const long CLOSED_TIMEOUT = 60 * 1000; // If the connection is closed, once per minute
@@ -220,8 +233,10 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32 conv)
 
   m_state = TCP_LISTEN;
   m_conv = conv;
-  m_rcv_wnd = m_rbuf_len;
-  m_rwnd_scale = m_swnd_scale = 0;
+  // Sets |m_rwnd_scale| and |m_rcv_wnd| for the default buffer size.
+  resizeReceiveBuffer(m_rbuf_len);
+  m_swnd_scale = 0;
+  m_slist_unsent = 0;
   m_snd_nxt = 0;
   m_snd_wnd = 1;
   m_snd_una = m_rcv_nxt = 0;
@@ -244,6 +259,7 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32 conv)
 
   m_dup_acks = 0;
   m_recover = 0;
+  m_sack_high = m_sack_rexmit = 0;
 
   m_ts_recent = m_ts_lastack = 0;
 
@@ -253,6 +269,8 @@ PseudoTcp::PseudoTcp(IPseudoTcpNotify* notify, uint32 conv)
   m_use_nagling = true;
   m_ack_delay = DEF_ACK_DELAY;
   m_support_wnd_scale = true;
+  m_support_sack = true;
+  m_use_sack = false;
 }
 
 PseudoTcp::~PseudoTcp() {
@@ -298,7 +316,7 @@ void PseudoTcp::NotifyClock(uint32 now) {
                    << ") (dup_acks: " << static_cast<unsigned>(m_dup_acks)
                    << ")";
 #endif // _DEBUGMSG
-      if (!transmit(m_slist.begin(), now)) {
+      if (!transmit(0, now)) {
         closedown(ECONNABORTED);
         return;
       }
@@ -436,7 +454,9 @@ int PseudoTcp::Recv(char* buffer, size_t len) {
   if (uint32(available_space) - m_rcv_wnd >=
       std::min<uint32>(m_rbuf_len / 2, m_mss)) {
     // TODO(jbeda): !?! Not sure about this was closed business
-    bool bWasClosed = (m_rcv_wnd == 0);
+    // With window scaling, a window smaller than the scale unit reads as
+    // closed to the peer.
+    bool bWasClosed = ((m_rcv_wnd >> m_rwnd_scale) == 0);
     m_rcv_wnd = static_cast<uint32>(available_space);
 
     if (bWasClosed) {
@@ -513,6 +533,12 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32 seq, uint8 flags,
   uint32 now = Now();
 
   rtc::scoped_ptr<uint8[]> buffer(new uint8[MAX_PACKET]);
+  // Tell the peer about out-of-order data on ACKs.
+  uint32 sack_len = 0;
+  if (len == 0 && m_use_sack && !m_rlist.empty()) {
+    flags |= FLAG_SACK;
+    sack_len = writeSackBlocks(buffer.get() + HEADER_SIZE);
+  }
   long_to_bytes(m_conv, buffer.get());
   long_to_bytes(seq, buffer.get() + 4);
   long_to_bytes(m_rcv_nxt, buffer.get() + 8);
@@ -547,7 +573,8 @@ IPseudoTcpNotify::WriteResult PseudoTcp::packet(uint32 seq, uint8 flags,
 #endif // _DEBUGMSG
 
   IPseudoTcpNotify::WriteResult wres = m_notify->TcpWritePacket(
-      this, reinterpret_cast<char *>(buffer.get()), len + HEADER_SIZE);
+      this, reinterpret_cast<char *>(buffer.get()),
+      len + sack_len + HEADER_SIZE);
   // Note: When len is 0, this is an ACK packet.  We don't read the return value for those,
   // and thus we won't retry.  So go ahead and treat the packet as a success (basically simulate
   // as if it were dropped), which will prevent our timers from being messed up.
@@ -663,6 +690,14 @@ bool PseudoTcp::process(Segment& seg) {
     return false;
   }
 
+  // SACK blocks take the place of data, so this is an ACK like any other.
+  if (seg.flags & FLAG_SACK) {
+    if (m_use_sack) {
+      applySackBlocks(seg.data, seg.len);
+    }
+    seg.len = 0;
+  }
+
   // Check for control data
   bool bConnect = false;
   if (seg.flags & FLAG_CTL) {
@@ -740,6 +775,7 @@ bool PseudoTcp::process(Segment& seg) {
     for (uint32 nFree = nAcked; nFree > 0; ) {
       ASSERT(!m_slist.empty());
       if (nFree < m_slist.front().len) {
+        m_slist.front().seq += nFree;
         m_slist.front().len -= nFree;
         nFree = 0;
       } else {
@@ -748,6 +784,8 @@ bool PseudoTcp::process(Segment& seg) {
         }
         nFree -= m_slist.front().len;
         m_slist.pop_front();
+        ASSERT(m_slist_unsent > 0);
+        --m_slist_unsent;
       }
     }
 
@@ -763,7 +801,9 @@ bool PseudoTcp::process(Segment& seg) {
 #if _DEBUGMSG >= _DBG_NORMAL
         LOG(LS_INFO) << "recovery retransmit";
 #endif // _DEBUGMSG
-        if (!transmit(m_slist.begin(), now)) {
+        // With SACK, the segment at |m_snd_una| may have been retransmitted
+        // as a hole already.
+        if (!(m_use_sack ? retransmitNextHole(now) : transmit(0, now))) {
           closedown(ECONNABORTED);
           return false;
         }
@@ -792,10 +832,11 @@ bool PseudoTcp::process(Segment& seg) {
         LOG(LS_INFO) << "enter recovery";
         LOG(LS_INFO) << "recovery retransmit";
 #endif // _DEBUGMSG
-        if (!transmit(m_slist.begin(), now)) {
+        if (!transmit(0, now)) {
           closedown(ECONNABORTED);
           return false;
         }
+        m_sack_rexmit = m_slist.front().seq + m_slist.front().len;
         m_recover = m_snd_nxt;
         uint32 nInFlight = m_snd_nxt - m_snd_una;
         m_ssthresh = std::max(nInFlight / 2, 2 * m_mss);
@@ -803,6 +844,12 @@ bool PseudoTcp::process(Segment& seg) {
         m_cwnd = m_ssthresh + 3 * m_mss;
       } else if (m_dup_acks > 3) {
         m_cwnd += m_mss;
+        // Each further ACK may SACK data above another hole, so that we can
+        // repair more than one loss per round trip.
+        if (m_use_sack && !retransmitNextHole(now)) {
+          closedown(ECONNABORTED);
+          return false;
+        }
       }
     } else {
       m_dup_acks = 0;
@@ -950,7 +997,9 @@ bool PseudoTcp::process(Segment& seg) {
   return true;
 }
 
-bool PseudoTcp::transmit(const SList::iterator& seg, uint32 now) {
+bool PseudoTcp::transmit(size_t index, uint32 now) {
+  ASSERT(index < m_slist.size());
+  SSegment* seg = &m_slist[index];
   if (seg->xmit >= ((m_state == TCP_ESTABLISHED) ? 15 : 30)) {
     LOG_F(LS_VERBOSE) << "too many retransmits";
     return false;
@@ -1003,12 +1052,17 @@ bool PseudoTcp::transmit(const SList::iterator& seg, uint32 now) {
     subseg.xmit = seg->xmit;
     seg->len = nTransmit;
 
-    SList::iterator next = seg;
-    m_slist.insert(++next, subseg);
+    m_slist.insert(m_slist.begin() + index + 1, subseg);
+    seg = &m_slist[index];
+    if (subseg.xmit > 0) {
+      ++m_slist_unsent;
+    }
   }
 
   if (seg->xmit == 0) {
+    ASSERT(index == m_slist_unsent);
     m_snd_nxt += seg->len;
+    ++m_slist_unsent;
   }
   seg->xmit += 1;
   //seg->tstamp = now;
@@ -1091,22 +1145,19 @@ void PseudoTcp::attemptSend(SendFlags sflags) {
       return;
     }
 
-    // Find the next segment to transmit
-    SList::iterator it = m_slist.begin();
-    while (it->xmit > 0) {
-      ++it;
-      ASSERT(it != m_slist.end());
-    }
-    SList::iterator seg = it;
+    // The next segment to transmit
+    ASSERT(m_slist_unsent < m_slist.size());
+    size_t index = m_slist_unsent;
 
     // If the segment is too large, break it into two
-    if (seg->len > nAvailable) {
-      SSegment subseg(seg->seq + nAvailable, seg->len - nAvailable, seg->bCtrl);
-      seg->len = nAvailable;
-      m_slist.insert(++it, subseg);
+    SSegment& seg = m_slist[index];
+    if (seg.len > nAvailable) {
+      SSegment subseg(seg.seq + nAvailable, seg.len - nAvailable, seg.bCtrl);
+      seg.len = nAvailable;
+      m_slist.insert(m_slist.begin() + index + 1, subseg);
     }
 
-    if (!transmit(seg, now)) {
+    if (!transmit(index, now)) {
       LOG_F(LS_VERBOSE) << "transmit failed";
       // TODO: consider closing socket
       return;
@@ -1156,6 +1207,11 @@ PseudoTcp::disableWindowScale() {
   m_support_wnd_scale = false;
 }
 
+void
+PseudoTcp::disableSack() {
+  m_support_sack = false;
+}
+
 void
 PseudoTcp::queueConnectMessage() {
   rtc::ByteBuffer buf(rtc::ByteBuffer::ORDER_NETWORK);
@@ -1166,6 +1222,10 @@ PseudoTcp::queueConnectMessage() {
     buf.WriteUInt8(1);
     buf.WriteUInt8(m_rwnd_scale);
   }
+  if (m_support_sack) {
+    buf.WriteUInt8(TCP_OPT_SACK_PERMITTED);
+    buf.WriteUInt8(0);
+  }
   m_snd_wnd = static_cast<uint32>(buf.Length());
   queue(buf.Data(), static_cast<uint32>(buf.Length()), true);
 }
@@ -1211,11 +1271,16 @@ PseudoTcp::parseOptions(const char* data, uint32 len) {
 
     if (m_rwnd_scale > 0) {
       // Peer doesn't support TCP options and window scaling.
-      // Revert receive buffer size to default value.
-      resizeReceiveBuffer(DEFAULT_RCV_BUF_SIZE);
+      // Revert receive buffer size to one that needs no scaling.
+      resizeReceiveBuffer(UNSCALED_RCV_BUF_SIZE);
       m_swnd_scale = 0;
     }
   }
+
+  // Only use SACK if both sides offer it.
+  m_use_sack = m_support_sack &&
+      (options_specified.find(TCP_OPT_SACK_PERMITTED) !=
+       options_specified.end());
 }
 
 void
@@ -1236,9 +1301,88 @@ PseudoTcp::applyOption(char kind, const char* data, uint32 len) {
 
 void
 PseudoTcp::applyWindowScaleOption(uint8 scale_factor) {
+  if (scale_factor > MAX_WND_SCALE) {
+    LOG(LS_WARNING) << "Window scale factor "
+                    << static_cast<int>(scale_factor) << " is too large, using "
+                    << static_cast<int>(MAX_WND_SCALE);
+    scale_factor = MAX_WND_SCALE;
+  }
   m_swnd_scale = scale_factor;
 }
 
+uint32
+PseudoTcp::writeSackBlocks(uint8* buffer) const {
+  uint32 num_blocks = 0;
+  RList::const_iterator it = m_rlist.begin();
+  while ((it != m_rlist.end()) && (num_blocks < MAX_SACK_BLOCKS)) {
+    uint32 start = it->seq;
+    uint32 end = it->seq + it->len;
+    // Merge the segments that overlap or adjoin this one.
+    for (++it; (it != m_rlist.end()) && (it->seq <= end); ++it) {
+      end = std::max(end, it->seq + it->len);
+    }
+    long_to_bytes(start, buffer + num_blocks * SACK_BLOCK_SIZE);
+    long_to_bytes(end, buffer + num_blocks * SACK_BLOCK_SIZE + 4);
+    ++num_blocks;
+  }
+  return num_blocks * SACK_BLOCK_SIZE;
+}
+
+void
+PseudoTcp::applySackBlocks(const char* data, uint32 len) {
+  for (; len >= SACK_BLOCK_SIZE;
+       data += SACK_BLOCK_SIZE, len -= SACK_BLOCK_SIZE) {
+    uint32 start = bytes_to_long(data);
+    uint32 end = bytes_to_long(data + 4);
+    // Skip blocks that are stale, or aren't for data we sent.
+    if ((start <= m_snd_una) || (start >= end) || (end > m_snd_nxt)) {
+      continue;
+    }
+    m_sack_high = std::max(m_sack_high, end);
+    // Only mark whole segments; a partly SACKed one is still a hole.
+    for (size_t i = findSentSegment(start);
+         (i < m_slist_unsent) && (m_slist[i].seq + m_slist[i].len <= end);
+         ++i) {
+      m_slist[i].bSacked = true;
+    }
+  }
+}
+
+bool
+PseudoTcp::retransmitNextHole(uint32 now) {
+  for (size_t i = findSentSegment(m_sack_rexmit); i < m_slist_unsent; ++i) {
+    if (m_slist[i].bSacked) {
+      continue;
+    }
+    // Past the SACKed data, segments may just be in flight still.
+    if ((i > 0) && (m_slist[i].seq >= m_sack_high)) {
+      break;
+    }
+    if (!transmit(i, now)) {
+      return false;
+    }
+    m_sack_rexmit = m_slist[i].seq + m_slist[i].len;
+    break;
+  }
+  return true;
+}
+
+size_t
+PseudoTcp::findSentSegment(uint32 seq) const {
+  // Sent segments are in sequence order, so do a binary search.
+  size_t low = 0;
+  size_t high = m_slist_unsent;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (m_slist[mid].seq < seq) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
 void
 PseudoTcp::resizeSendBuffer(uint32 new_size) {
   m_sbuf_len = new_size;
@@ -1250,11 +1394,13 @@ PseudoTcp::resizeReceiveBuffer(uint32 new_size) {
   uint8 scale_factor = 0;
 
   // Determine the scale factor such that the scaled window size can fit
-  // in a 16-bit unsigned integer.
-  while (new_size > 0xFFFF) {
+  // in a 16-bit unsigned integer. Beyond the largest scale factor, the
+  // buffer is capped to what the window can advertise.
+  while ((new_size > 0xFFFF) && (scale_factor < MAX_WND_SCALE)) {
     ++scale_factor;
     new_size >>= 1;
   }
+  new_size = std::min<uint32>(new_size, 0xFFFF);
 
   // Determine the proper size of the buffer.
   new_size <<= scale_factor;
@@ -11,6 +11,7 @@
 #ifndef WEBRTC_P2P_BASE_PSEUDOTCP_H_
 #define WEBRTC_P2P_BASE_PSEUDOTCP_H_
 
+#include <deque>
 #include <list>
 
 #include "webrtc/base/basictypes.h"
@@ -121,14 +122,18 @@ class PseudoTcp {
 
   struct SSegment {
     SSegment(uint32 s, uint32 l, bool c)
-        : seq(s), len(l), /*tstamp(0),*/ xmit(0), bCtrl(c) {
+        : seq(s), len(l), /*tstamp(0),*/ xmit(0), bCtrl(c), bSacked(false) {
     }
     uint32 seq, len;
     //uint32 tstamp;
     uint8 xmit;
     bool bCtrl;
+    bool bSacked;  // Whether the peer has selectively acknowledged it.
   };
-  typedef std::list<SSegment> SList;
+  // Segments in sequence order: the sent ones, then the unsent ones. Acked
+  // segments are popped off the front, and the sequence order allows binary
+  // searches.
+  typedef std::deque<SSegment> SList;
 
   struct RSegment {
     uint32 seq, len;
@@ -155,7 +160,8 @@ class PseudoTcp {
   bool clock_check(uint32 now, long& nTimeout);
 
   bool process(Segment& seg);
-  bool transmit(const SList::iterator& seg, uint32 now);
+  // Transmits the segment at |index| in |m_slist|.
+  bool transmit(size_t index, uint32 now);
 
   void adjustMTU();
 
@@ -167,6 +173,10 @@ class PseudoTcp {
   // support for testing backward compatibility.
   void disableWindowScale();
 
+  // This method is only used in tests, to disable selective
+  // acknowledgement support for testing backward compatibility.
+  void disableSack();
+
  private:
   // Queue the connect message with TCP options.
   void queueConnectMessage();
@@ -180,6 +190,23 @@ class PseudoTcp {
   // Apply window scale option.
   void applyWindowScaleOption(uint8 scale_factor);
 
+  // Write SACK blocks for the out-of-order data in |m_rlist| to |buffer|.
+  // Returns the number of bytes written.
+  uint32 writeSackBlocks(uint8* buffer) const;
+
+  // Mark the segments covered by the SACK blocks in |data|.
+  void applySackBlocks(const char* data, uint32 len);
+
+  // Retransmit the first segment at or after |m_sack_rexmit| that the peer
+  // is missing: either the one at |m_snd_una|, or one below data that the
+  // peer has selectively acknowledged. Returns false if the retransmission
+  // failed.
+  bool retransmitNextHole(uint32 now);
+
+  // Returns the index of the first sent segment with a sequence number of at
+  // least |seq|.
+  size_t findSentSegment(uint32 seq) const;
+
   // Resize the send buffer with |new_size| in bytes.
   void resizeSendBuffer(uint32 new_size);
 
@@ -206,6 +233,7 @@ class PseudoTcp {
 
   // Outgoing data
   SList m_slist;
+  size_t m_slist_unsent;  // Index of the first unsent segment in |m_slist|.
   uint32 m_sbuf_len, m_snd_nxt, m_snd_wnd, m_lastsend, m_snd_una;
   uint8 m_swnd_scale;  // Window scale factor.
   rtc::FifoBuffer m_sbuf;
@@ -223,10 +251,15 @@ class PseudoTcp {
 
   // Congestion avoidance, Fast retransmit/recovery, Delayed ACKs
   uint32 m_ssthresh, m_cwnd;
-  uint8 m_dup_acks;
+  uint32 m_dup_acks;
   uint32 m_recover;
   uint32 m_t_ack;
 
+  // Selective acknowledgement: the highest sequence number that the peer has
+  // SACKed, and the one up to which we've retransmitted holes during this
+  // recovery.
+  uint32 m_sack_high, m_sack_rexmit;
+
   // Configuration options
   bool m_use_nagling;
   uint32 m_ack_delay;
@@ -234,6 +267,11 @@ class PseudoTcp {
   // This is used by unit tests to test backward compatibility of
   // PseudoTcp implementations that don't support window scaling.
   bool m_support_wnd_scale;
+
+  // Whether we offer SACK, which unit tests can turn off, and whether the
+  // peer offered it too.
+  bool m_support_sack;
+  bool m_use_sack;
 };
 
 }  // namespace cricket
@@ -0,0 +1,226 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "webrtc/p2p/base/pseudotcp.h"
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/messagehandler.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/base/virtualsocketserver.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+const uint32 kConv = 1;
+const uint16 kMtu = 1500;
+const int kTransferBytes = 2 * 1024 * 1024;
+const int kBlockSize = 4096;
+const int kTransferTimeoutMs = 120000;
+const int kLargeBufferSize = 1024 * 1024;
+
+struct NetworkConditions {
+  int delay_ms;  // One way.
+  int loss_percent;
+};
+
+const NetworkConditions kNetworkConditions[] = {
+  {0, 0},
+  {25, 0},
+  {25, 1},
+  {25, 3},
+  {50, 1},
+};
+
+class PseudoTcpForTest : public PseudoTcp {
+ public:
+  PseudoTcpForTest(IPseudoTcpNotify* notify, uint32 conv)
+      : PseudoTcp(notify, conv) {}
+
+  void disableSack() { PseudoTcp::disableSack(); }
+};
+
+// One end of a PseudoTcp connection, over a UDP socket on the virtual
+// network. The end that connects writes |kTransferBytes| as fast as it can,
+// and the other end reads them.
+class PseudoTcpEndpoint : public IPseudoTcpNotify,
+                          public rtc::MessageHandler,
+                          public sigslot::has_slots<> {
+ public:
+  PseudoTcpEndpoint(rtc::SocketFactory* factory,
+                    const rtc::SocketAddress& address)
+      : tcp_(this, kConv),
+        socket_(rtc::AsyncUDPSocket::Create(factory, address)),
+        sending_(false),
+        bytes_sent_(0),
+        bytes_received_(0) {
+    socket_->SignalReadPacket.connect(this, &PseudoTcpEndpoint::OnReadPacket);
+    tcp_.NotifyMTU(kMtu);
+  }
+
+  PseudoTcpForTest* tcp() { return &tcp_; }
+  int bytes_received() const { return bytes_received_; }
+  bool done() const { return bytes_received_ == kTransferBytes; }
+  rtc::SocketAddress address() const { return socket_->GetLocalAddress(); }
+  void set_remote_address(const rtc::SocketAddress& address) {
+    remote_address_ = address;
+  }
+
+  void Start() {
+    sending_ = true;
+    tcp_.Connect();
+    UpdateClock();
+  }
+
+  // IPseudoTcpNotify implementation.
+  void OnTcpOpen(PseudoTcp* tcp) override { OnTcpWriteable(tcp); }
+  void OnTcpReadable(PseudoTcp* tcp) override {
+    char block[kBlockSize];
+    int read;
+    while ((read = tcp_.Recv(block, sizeof(block))) > 0)
+      bytes_received_ += read;
+  }
+  void OnTcpWriteable(PseudoTcp* tcp) override {
+    if (!sending_)
+      return;
+    char block[kBlockSize];
+    memset(block, 0x5a, sizeof(block));
+    while (bytes_sent_ < kTransferBytes) {
+      int sent = tcp_.Send(block, std::min<int>(sizeof(block),
+                                                kTransferBytes - bytes_sent_));
+      if (sent <= 0)
+        break;
+      bytes_sent_ += sent;
+    }
+    UpdateClock();
+  }
+  void OnTcpClosed(PseudoTcp* tcp, uint32 error) override {
+    EXPECT_EQ(0U, error);
+  }
+  WriteResult TcpWritePacket(PseudoTcp* tcp, const char* buffer,
+                             size_t len) override {
+    // A failed send is just another lost packet.
+    socket_->SendTo(buffer, len, remote_address_, rtc::PacketOptions());
+    return WR_SUCCESS;
+  }
+
+  // MessageHandler implementation.
+  void OnMessage(rtc::Message* msg) override {
+    tcp_.NotifyClock(PseudoTcp::Now());
+    UpdateClock();
+  }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket, const char* data,
+                    size_t size, const rtc::SocketAddress& remote_address,
+                    const rtc::PacketTime& packet_time) {
+    tcp_.NotifyPacket(data, size);
+    UpdateClock();
+  }
+
+  void UpdateClock() {
+    long timeout = 0;  // NOLINT
+    if (!tcp_.GetNextClock(PseudoTcp::Now(), timeout))
+      return;
+    rtc::Thread::Current()->Clear(this);
+    rtc::Thread::Current()->PostDelayed(std::max<long>(timeout, 0), this);
+  }
+
+  PseudoTcpForTest tcp_;
+  rtc::scoped_ptr<rtc::AsyncUDPSocket> socket_;
+  rtc::SocketAddress remote_address_;
+  bool sending_;
+  int bytes_sent_;
+  int bytes_received_;
+};
+
+class PseudoTcpPerfTest : public testing::Test {
+ public:
+  PseudoTcpPerfTest()
+      : pss_(new rtc::PhysicalSocketServer),
+        vss_(new rtc::VirtualSocketServer(pss_.get())),
+        ss_scope_(vss_.get()) {}
+
+ protected:
+  // Transfers |kTransferBytes| over a network with the given delay and loss,
+  // and prints the throughput.
+  void MeasureThroughput(const NetworkConditions& conditions, bool sack,
+                         int buffer_size) {
+    vss_->set_delay_mean(conditions.delay_ms);
+    vss_->set_delay_stddev(0);
+    vss_->UpdateDelayDistribution();
+    vss_->set_drop_probability(conditions.loss_percent / 100.0);
+    // The virtual network drops packets based on rand().
+    srand(1);
+
+    PseudoTcpEndpoint sender(vss_.get(), rtc::SocketAddress("1.1.1.1", 0));
+    PseudoTcpEndpoint receiver(vss_.get(), rtc::SocketAddress("2.2.2.2", 0));
+    sender.set_remote_address(receiver.address());
+    receiver.set_remote_address(sender.address());
+    if (!sack) {
+      sender.tcp()->disableSack();
+      receiver.tcp()->disableSack();
+    }
+    if (buffer_size) {
+      sender.tcp()->SetOption(PseudoTcp::OPT_SNDBUF, buffer_size * 3 / 2);
+      sender.tcp()->SetOption(PseudoTcp::OPT_RCVBUF, buffer_size);
+      receiver.tcp()->SetOption(PseudoTcp::OPT_RCVBUF, buffer_size);
+    }
+
+    uint64 start_us = rtc::TimeMicros();
+    sender.Start();
+    EXPECT_TRUE_WAIT(receiver.done(), kTransferTimeoutMs);
+    uint64 elapsed_us = std::max<uint64>(rtc::TimeMicros() - start_us, 1);
+
+    std::string trace = rtc::ToString(conditions.delay_ms) + "ms_" +
+                        rtc::ToString(conditions.loss_percent) + "pct_" +
+                        (sack ? "sack" : "no_sack");
+    if (buffer_size)
+      trace += "_" + rtc::ToString(buffer_size / 1024) + "kb";
+    webrtc::test::PrintResult("pseudotcp_throughput", "", trace,
+                              8000.0 * receiver.bytes_received() / elapsed_us,
+                              "kbps", true);
+  }
+
+  rtc::scoped_ptr<rtc::PhysicalSocketServer> pss_;
+  rtc::scoped_ptr<rtc::VirtualSocketServer> vss_;
+  rtc::SocketServerScope ss_scope_;
+};
+
+}  // namespace
+
+// Compares the throughput with and without selective acknowledgements, over
+// networks that lose more than one packet in a window.
+TEST_F(PseudoTcpPerfTest, Throughput) {
+  for (size_t i = 0; i < ARRAY_SIZE(kNetworkConditions); ++i) {
+    MeasureThroughput(kNetworkConditions[i], true, 0);
+    MeasureThroughput(kNetworkConditions[i], false, 0);
+  }
+}
+
+// Larger windows than the default, for long, fat networks.
+TEST_F(PseudoTcpPerfTest, ThroughputLargeWindow) {
+  const NetworkConditions kLongFatNetwork = {50, 0};
+  MeasureThroughput(kLongFatNetwork, true, 0);
+  MeasureThroughput(kLongFatNetwork, true, kLargeBufferSize);
+}
+
+}  // namespace cricket
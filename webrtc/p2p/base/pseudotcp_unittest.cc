@@ -38,6 +38,10 @@ class PseudoTcpForTest : public cricket::PseudoTcp {
   void disableWindowScale() {
     PseudoTcp::disableWindowScale();
   }
+
+  void disableSack() {
+    PseudoTcp::disableSack();
+  }
 };
 
 class PseudoTcpTestBase : public testing::Test,
@@ -98,6 +102,12 @@ class PseudoTcpTestBase : public testing::Test,
   void DisableLocalWindowScale() {
     local_.disableWindowScale();
   }
+  void DisableRemoteSack() {
+    remote_.disableSack();
+  }
+  void DisableLocalSack() {
+    local_.disableSack();
+  }
 
  protected:
   int Connect() {
@@ -661,6 +671,37 @@ TEST_F(PseudoTcpTest, TestSendWithDelayAndOptAckDelayOff) {
   TestTransfer(100000);  // less data so test runs faster
 }
 
+// Test sending data with packet loss to a receiver that doesn't support SACK.
+TEST_F(PseudoTcpTest, TestSendWithLossRemoteNoSack) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  DisableRemoteSack();
+  TestTransfer(100000);
+}
+
+// Test sending data with packet loss from a sender that doesn't support SACK.
+TEST_F(PseudoTcpTest, TestSendWithLossLocalNoSack) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetLoss(10);
+  DisableLocalSack();
+  TestTransfer(100000);
+}
+
+// Test sending data with a 50 ms RTT and packet loss, through large windows,
+// so that several segments are lost in each window and SACK repairs them.
+TEST_F(PseudoTcpTest, TestSendWithDelayAndLossLargeWindow) {
+  SetLocalMtu(1500);
+  SetRemoteMtu(1500);
+  SetDelay(50);
+  SetLoss(2);
+  SetRemoteOptRcvBuf(1000000);
+  SetLocalOptRcvBuf(1000000);
+  SetOptSndBuf(1500000);
+  TestTransfer(500000);
+}
+
 // Test a large receive buffer with a sender that doesn't support scaling.
 TEST_F(PseudoTcpTest, TestSendRemoteNoWindowScale) {
   SetLocalMtu(1500);
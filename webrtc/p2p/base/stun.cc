@@ -40,6 +40,36 @@ const char TURN_MAGIC_COOKIE_VALUE[] = { '\x72', '\xC6', '\x4B', '\xC6' };
 const char EMPTY_TRANSACTION_ID[] = "0000000000000000";
 const uint32 STUN_FINGERPRINT_XOR_VALUE = 0x5354554E;
 
+// Returns |length| rounded up to a multiple of four, as attributes are padded.
+static size_t PaddedLength(size_t length) {
+  return (length + 3) & ~static_cast<size_t>(3);
+}
+
+// Computes the value of a MESSAGE-INTEGRITY attribute which starts at |mi_pos|
+// in |data|: the HMAC of everything before it, as if it was the last
+// attribute. Only the header is copied, to adjust its length field.
+static bool ComputeMessageIntegrity(const char* data, size_t mi_pos,
+                                    const char* key, size_t keylen,
+                                    char* hmac) {
+  ASSERT(mi_pos >= kStunHeaderSize);
+  char header[kStunHeaderSize];
+  memcpy(header, data, kStunHeaderSize);
+  rtc::SetBE16(header + 2, static_cast<uint16>(
+      mi_pos - kStunHeaderSize + kStunAttributeHeaderSize +
+      kStunMessageIntegritySize));
+  rtc::scoped_ptr<rtc::MessageDigest> digest(
+      rtc::MessageDigestFactory::Create(rtc::DIGEST_SHA_1));
+  if (!digest)
+    return false;
+  size_t ret = rtc::ComputeHmac(digest.get(), key, keylen,
+                                header, sizeof(header),
+                                data + kStunHeaderSize,
+                                mi_pos - kStunHeaderSize,
+                                hmac, kStunMessageIntegritySize);
+  ASSERT(ret == kStunMessageIntegritySize);
+  return ret == kStunMessageIntegritySize;
+}
+
 // StunMessage
 
 StunMessage::StunMessage()
@@ -170,35 +200,11 @@ bool StunMessage::ValidateMessageIntegrity(const char* data, size_t size,
     return false;
   }
 
-  // Getting length of the message to calculate Message Integrity.
-  size_t mi_pos = current_pos;
-  rtc::scoped_ptr<char[]> temp_data(new char[current_pos]);
-  memcpy(temp_data.get(), data, current_pos);
-  if (size > mi_pos + kStunAttributeHeaderSize + kStunMessageIntegritySize) {
-    // Stun message has other attributes after message integrity.
-    // Adjust the length parameter in stun message to calculate HMAC.
-    size_t extra_offset = size -
-        (mi_pos + kStunAttributeHeaderSize + kStunMessageIntegritySize);
-    size_t new_adjusted_len = size - extra_offset - kStunHeaderSize;
-
-    // Writing new length of the STUN message @ Message Length in temp buffer.
-    //      0                   1                   2                   3
-    //      0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
-    //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    //     |0 0|     STUN Message Type     |         Message Length        |
-    //     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
-    rtc::SetBE16(temp_data.get() + 2,
-                       static_cast<uint16>(new_adjusted_len));
-  }
-
   char hmac[kStunMessageIntegritySize];
-  size_t ret = rtc::ComputeHmac(rtc::DIGEST_SHA_1,
-                                      password.c_str(), password.size(),
-                                      temp_data.get(), mi_pos,
-                                      hmac, sizeof(hmac));
-  ASSERT(ret == sizeof(hmac));
-  if (ret != sizeof(hmac))
+  if (!ComputeMessageIntegrity(data, current_pos, password.c_str(),
+                               password.size(), hmac)) {
     return false;
+  }
 
   // Comparing the calculated HMAC with the one present in the message.
   return memcmp(data + current_pos + kStunAttributeHeaderSize,
@@ -864,6 +870,258 @@ bool StunUInt16ListAttribute::Write(ByteBuffer* buf) const {
   return true;
 }
 
+// StunMessageView
+
+StunMessageView::StunMessageView()
+    : data_(NULL),
+      size_(0),
+      transaction_id_(NULL),
+      transaction_id_length_(0) {
+}
+
+bool StunMessageView::Parse(const char* data, size_t size) {
+  data_ = NULL;
+  size_ = 0;
+  if (size < kStunHeaderSize)
+    return false;
+  // RTP and RTCP set the MSB of first byte, since first two bits are version,
+  // and version is always 2 (10). If set, this is not a STUN packet.
+  if (data[0] & 0x80)
+    return false;
+  if (rtc::GetBE16(data + 2) != size - kStunHeaderSize)
+    return false;
+
+  // The padding of the last attribute may be left out.
+  size_t pos = kStunHeaderSize;
+  while (pos < size) {
+    if (pos + kStunAttributeHeaderSize > size)
+      return false;
+    size_t length = rtc::GetBE16(data + pos + 2);
+    if (pos + kStunAttributeHeaderSize + length > size)
+      return false;
+    pos += kStunAttributeHeaderSize + PaddedLength(length);
+  }
+
+  if (rtc::GetBE32(data + kStunTransactionIdOffset - kStunMagicCookieLength) ==
+      kStunMagicCookie) {
+    transaction_id_ = data + kStunTransactionIdOffset;
+    transaction_id_length_ = kStunTransactionIdLength;
+  } else {
+    // Without the magic cookie, it is a part of the transaction ID.
+    transaction_id_ = data + kStunTransactionIdOffset - kStunMagicCookieLength;
+    transaction_id_length_ = kStunLegacyTransactionIdLength;
+  }
+  data_ = data;
+  size_ = size;
+  return true;
+}
+
+bool StunMessageView::GetAttribute(int type, const char** value,
+                                   size_t* length) const {
+  ASSERT(data_ != NULL);
+  size_t pos = kStunHeaderSize;
+  while (pos < size_) {
+    size_t attr_length = rtc::GetBE16(data_ + pos + 2);
+    if (rtc::GetBE16(data_ + pos) == type) {
+      *value = data_ + pos + kStunAttributeHeaderSize;
+      *length = attr_length;
+      return true;
+    }
+    pos += kStunAttributeHeaderSize + PaddedLength(attr_length);
+  }
+  return false;
+}
+
+bool StunMessageView::HasAttribute(int type) const {
+  const char* value;
+  size_t length;
+  return GetAttribute(type, &value, &length);
+}
+
+bool StunMessageView::GetUInt32(int type, uint32* value) const {
+  const char* bytes;
+  size_t length;
+  if (!GetAttribute(type, &bytes, &length) ||
+      length != StunUInt32Attribute::SIZE) {
+    return false;
+  }
+  *value = rtc::GetBE32(bytes);
+  return true;
+}
+
+bool StunMessageView::ValidateMessageIntegrity(
+    const std::string& password) const {
+  ASSERT(data_ != NULL);
+  return StunMessage::ValidateMessageIntegrity(data_, size_, password);
+}
+
+bool StunMessageView::ValidateFingerprint() const {
+  ASSERT(data_ != NULL);
+  return StunMessage::ValidateFingerprint(data_, size_);
+}
+
+// StunMessageBuilder
+
+StunMessageBuilder::StunMessageBuilder(char* buffer, size_t capacity)
+    : buffer_(buffer), capacity_(capacity), size_(0) {
+}
+
+bool StunMessageBuilder::Start(int type, const char* transaction_id,
+                               size_t transaction_id_length) {
+  size_ = 0;
+  if (capacity_ < kStunHeaderSize)
+    return false;
+  rtc::SetBE16(buffer_, static_cast<uint16>(type));
+  rtc::SetBE16(buffer_ + 2, 0);
+  if (transaction_id_length == kStunTransactionIdLength) {
+    rtc::SetBE32(buffer_ + kStunTransactionIdOffset - kStunMagicCookieLength,
+                 kStunMagicCookie);
+    memcpy(buffer_ + kStunTransactionIdOffset, transaction_id,
+           transaction_id_length);
+  } else if (transaction_id_length == kStunLegacyTransactionIdLength) {
+    memcpy(buffer_ + kStunTransactionIdOffset - kStunMagicCookieLength,
+           transaction_id, transaction_id_length);
+  } else {
+    return false;
+  }
+  size_ = kStunHeaderSize;
+  return true;
+}
+
+char* StunMessageBuilder::AppendAttribute(int type, size_t length) {
+  size_t padded_length = PaddedLength(length);
+  size_t new_size = size_ + kStunAttributeHeaderSize + padded_length;
+  if (size_ < kStunHeaderSize || length > 0xFFFF || new_size > capacity_ ||
+      new_size - kStunHeaderSize > 0xFFFF) {
+    return NULL;
+  }
+  char* attr = buffer_ + size_;
+  rtc::SetBE16(attr, static_cast<uint16>(type));
+  rtc::SetBE16(attr + 2, static_cast<uint16>(length));
+  memset(attr + kStunAttributeHeaderSize + length, 0, padded_length - length);
+  size_ = new_size;
+  rtc::SetBE16(buffer_ + 2, static_cast<uint16>(size_ - kStunHeaderSize));
+  return attr + kStunAttributeHeaderSize;
+}
+
+bool StunMessageBuilder::AddUInt32(int type, uint32 value) {
+  char* bytes = AppendAttribute(type, StunUInt32Attribute::SIZE);
+  if (!bytes)
+    return false;
+  rtc::SetBE32(bytes, value);
+  return true;
+}
+
+bool StunMessageBuilder::AddByteString(int type, const char* bytes,
+                                       size_t length) {
+  char* value = AppendAttribute(type, length);
+  if (!value)
+    return false;
+  memcpy(value, bytes, length);
+  return true;
+}
+
+bool StunMessageBuilder::AddAddress(int type,
+                                    const rtc::SocketAddress& address) {
+  return WriteAddress(type, address, false);
+}
+
+bool StunMessageBuilder::AddXorAddress(int type,
+                                       const rtc::SocketAddress& address) {
+  return WriteAddress(type, address, true);
+}
+
+bool StunMessageBuilder::WriteAddress(int type,
+                                      const rtc::SocketAddress& address,
+                                      bool xor_address) {
+  const rtc::IPAddress& ip = address.ipaddr();
+  size_t length;
+  uint8 family;
+  if (ip.family() == AF_INET) {
+    length = StunAddressAttribute::SIZE_IP4;
+    family = STUN_ADDRESS_IPV4;
+  } else if (ip.family() == AF_INET6) {
+    length = StunAddressAttribute::SIZE_IP6;
+    family = STUN_ADDRESS_IPV6;
+  } else {
+    return false;
+  }
+  // IPv6 addresses are also XORed with the transaction ID of RFC 5389
+  // messages, which RFC3489 ones don't have.
+  if (xor_address && family == STUN_ADDRESS_IPV6 &&
+      (size_ < kStunHeaderSize ||
+       rtc::GetBE32(buffer_ + kStunTransactionIdOffset -
+                    kStunMagicCookieLength) != kStunMagicCookie)) {
+    return false;
+  }
+  char* value = AppendAttribute(type, length);
+  if (!value)
+    return false;
+
+  uint16 port = address.port();
+  if (xor_address)
+    port ^= (kStunMagicCookie >> 16);
+  value[0] = 0;
+  value[1] = family;
+  rtc::SetBE16(value + 2, port);
+  char* ip_bytes = value + 4;
+  if (family == STUN_ADDRESS_IPV4) {
+    in_addr v4addr = ip.ipv4_address();
+    memcpy(ip_bytes, &v4addr, sizeof(v4addr));
+  } else {
+    in6_addr v6addr = ip.ipv6_address();
+    memcpy(ip_bytes, &v6addr, sizeof(v6addr));
+  }
+  if (xor_address) {
+    char mask[kStunMagicCookieLength + kStunTransactionIdLength];
+    rtc::SetBE32(mask, kStunMagicCookie);
+    memcpy(mask + kStunMagicCookieLength, buffer_ + kStunTransactionIdOffset,
+           kStunTransactionIdLength);
+    for (size_t i = 0; i < length - 4; ++i)
+      ip_bytes[i] ^= mask[i];
+  }
+  return true;
+}
+
+bool StunMessageBuilder::AddErrorCode(int code, const std::string& reason) {
+  char* value = AppendAttribute(STUN_ATTR_ERROR_CODE,
+                                StunErrorCodeAttribute::MIN_SIZE +
+                                    reason.size());
+  if (!value)
+    return false;
+  rtc::SetBE32(value, ((code / 100) << 8) | (code % 100));
+  memcpy(value + StunErrorCodeAttribute::MIN_SIZE, reason.data(),
+         reason.size());
+  return true;
+}
+
+bool StunMessageBuilder::AddMessageIntegrity(const std::string& password) {
+  size_t mi_pos = size_;
+  char* value = AppendAttribute(STUN_ATTR_MESSAGE_INTEGRITY,
+                                kStunMessageIntegritySize);
+  if (!value)
+    return false;
+  if (!ComputeMessageIntegrity(buffer_, mi_pos, password.c_str(),
+                               password.size(), value)) {
+    size_ = mi_pos;
+    rtc::SetBE16(buffer_ + 2, static_cast<uint16>(size_ - kStunHeaderSize));
+    return false;
+  }
+  return true;
+}
+
+bool StunMessageBuilder::AddFingerprint() {
+  size_t fingerprint_pos = size_;
+  char* value = AppendAttribute(STUN_ATTR_FINGERPRINT,
+                                StunUInt32Attribute::SIZE);
+  if (!value)
+    return false;
+  // The CRC-32 covers the header with the length of the complete message.
+  uint32 crc = rtc::ComputeCrc32(buffer_, fingerprint_pos);
+  rtc::SetBE32(value, crc ^ STUN_FINGERPRINT_XOR_VALUE);
+  return true;
+}
+
 int GetStunSuccessResponseType(int req_type) {
   return IsStunRequestType(req_type) ? (req_type | 0x100) : -1;
 }
@@ -19,6 +19,7 @@
 
 #include "webrtc/base/basictypes.h"
 #include "webrtc/base/bytebuffer.h"
+#include "webrtc/base/byteorder.h"
 #include "webrtc/base/socketaddress.h"
 
 namespace cricket {
@@ -464,6 +465,86 @@ class StunUInt16ListAttribute : public StunAttribute {
   std::vector<uint16>* attr_types_;
 };
 
+// A read-only view of a STUN message in a buffer owned by the caller, for the
+// places where messages are received in bulk. Unlike StunMessage::Read(),
+// parsing neither allocates nor copies: Parse() only checks the framing, and
+// attributes are looked up in the buffer when asked for. The buffer must
+// outlive the view.
+class StunMessageView {
+ public:
+  StunMessageView();
+
+  // Checks that |data| holds exactly one STUN message whose attributes fit
+  // in it. Returns false if it doesn't.
+  bool Parse(const char* data, size_t size);
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  int type() const { return rtc::GetBE16(data_); }
+  // Returns true if the message is a RFC3489 one, i.e. has no magic cookie.
+  bool IsLegacy() const {
+    return transaction_id_length_ != kStunTransactionIdLength;
+  }
+  // The transaction ID is 12 bytes long, or 16 for RFC3489 messages.
+  const char* transaction_id() const { return transaction_id_; }
+  size_t transaction_id_length() const { return transaction_id_length_; }
+
+  // Finds the first attribute of |type|, and points |value| at its |length|
+  // bytes. Returns false if there's none.
+  bool GetAttribute(int type, const char** value, size_t* length) const;
+  bool HasAttribute(int type) const;
+  // Returns false if there's no attribute of |type| or it isn't 32 bits.
+  bool GetUInt32(int type, uint32* value) const;
+
+  // Same checks as the static StunMessage methods, on the parsed message.
+  bool ValidateMessageIntegrity(const std::string& password) const;
+  bool ValidateFingerprint() const;
+
+ private:
+  const char* data_;
+  size_t size_;
+  const char* transaction_id_;
+  size_t transaction_id_length_;
+};
+
+// Writes a STUN message straight into a buffer owned by the caller, for
+// messages that are sent as soon as they are built. Attributes are appended
+// in the order they're added; MESSAGE-INTEGRITY and FINGERPRINT cover what
+// has been written before them. The Add methods return false and leave the
+// message as it was if the attribute doesn't fit in the buffer.
+class StunMessageBuilder {
+ public:
+  StunMessageBuilder(char* buffer, size_t capacity);
+
+  // Writes the header. |transaction_id| must be 12 bytes long, or 16 for a
+  // RFC3489 message.
+  bool Start(int type, const char* transaction_id,
+             size_t transaction_id_length);
+
+  bool AddUInt32(int type, uint32 value);
+  bool AddByteString(int type, const char* bytes, size_t length);
+  bool AddAddress(int type, const rtc::SocketAddress& address);
+  bool AddXorAddress(int type, const rtc::SocketAddress& address);
+  bool AddErrorCode(int code, const std::string& reason);
+  bool AddMessageIntegrity(const std::string& password);
+  bool AddFingerprint();
+
+  const char* data() const { return buffer_; }
+  size_t size() const { return size_; }
+
+ private:
+  // Appends the header of an attribute with a |length| byte value, and the
+  // padding after the value. Returns where the value goes, or NULL if it
+  // doesn't fit.
+  char* AppendAttribute(int type, size_t length);
+  bool WriteAddress(int type, const rtc::SocketAddress& address,
+                    bool xor_address);
+
+  char* buffer_;
+  size_t capacity_;
+  size_t size_;
+};
+
 // Returns the (successful) response type for the given request type.
 // Returns -1 if |request_type| is not a valid request type.
 int GetStunSuccessResponseType(int request_type);
@@ -0,0 +1,117 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <string>
+
+#include "webrtc/p2p/base/stun.h"
+#include "webrtc/base/bytebuffer.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+const int kNumChecks = 100000;
+const char kUsername[] = "abcd:efgh";
+const char kPassword[] = "0123456789abcdefghijklmn";
+const char kTransactionId[] = "0123456789ab";
+const rtc::SocketAddress kRemoteAddress("192.168.1.2", 5000);
+
+// Builds a connectivity check like the ones Connection sends.
+std::string CreateBindingRequest() {
+  IceMessage request;
+  request.SetType(STUN_BINDING_REQUEST);
+  request.SetTransactionID(kTransactionId);
+  request.AddAttribute(new StunByteStringAttribute(STUN_ATTR_USERNAME,
+                                                   kUsername));
+  request.AddAttribute(new StunUInt32Attribute(STUN_ATTR_PRIORITY,
+                                               0x6e0001ff));
+  request.AddAttribute(new StunUInt64Attribute(STUN_ATTR_ICE_CONTROLLING,
+                                               0x123456789abcdefULL));
+  request.AddAttribute(new StunByteStringAttribute(STUN_ATTR_USE_CANDIDATE));
+  request.AddMessageIntegrity(kPassword);
+  request.AddFingerprint();
+  rtc::ByteBuffer buf;
+  request.Write(&buf);
+  return std::string(buf.Data(), buf.Length());
+}
+
+// Answers a check with StunMessage: the request is parsed into attribute
+// objects, and the response is built from new ones and copied out.
+bool AnswerWithStunMessage(const std::string& packet) {
+  if (!StunMessage::ValidateFingerprint(packet.data(), packet.size()))
+    return false;
+  IceMessage request;
+  rtc::ByteBuffer in(packet.data(), packet.size());
+  if (!request.Read(&in) || !request.GetByteString(STUN_ATTR_USERNAME) ||
+      !StunMessage::ValidateMessageIntegrity(packet.data(), packet.size(),
+                                             kPassword)) {
+    return false;
+  }
+
+  StunMessage response;
+  response.SetType(STUN_BINDING_RESPONSE);
+  response.SetTransactionID(request.transaction_id());
+  response.AddAttribute(
+      new StunXorAddressAttribute(STUN_ATTR_XOR_MAPPED_ADDRESS,
+                                  kRemoteAddress));
+  response.AddMessageIntegrity(kPassword);
+  response.AddFingerprint();
+  rtc::ByteBuffer out;
+  return response.Write(&out);
+}
+
+// Answers a check with StunMessageView and StunMessageBuilder, in place.
+bool AnswerWithView(const std::string& packet) {
+  StunMessageView request;
+  if (!request.Parse(packet.data(), packet.size()) ||
+      !request.ValidateFingerprint() ||
+      !request.HasAttribute(STUN_ATTR_USERNAME) ||
+      !request.ValidateMessageIntegrity(kPassword)) {
+    return false;
+  }
+
+  char buffer[128];
+  StunMessageBuilder response(buffer, sizeof(buffer));
+  return response.Start(STUN_BINDING_RESPONSE, request.transaction_id(),
+                        request.transaction_id_length()) &&
+      response.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, kRemoteAddress) &&
+      response.AddMessageIntegrity(kPassword) &&
+      response.AddFingerprint();
+}
+
+// Returns the number of checks answered per second.
+double MeasureCheckRate(bool (*answer)(const std::string&)) {
+  const std::string packet = CreateBindingRequest();
+  int num_answered = 0;
+  const uint64 start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumChecks; ++i) {
+    if (answer(packet))
+      ++num_answered;
+  }
+  const uint64 elapsed_us = rtc::TimeMicros() - start_us;
+  EXPECT_EQ(kNumChecks, num_answered);
+  return 1e6 * kNumChecks / std::max<uint64>(elapsed_us, 1);
+}
+
+}  // namespace
+
+TEST(StunPerfTest, AnswerConnectivityChecks) {
+  webrtc::test::PrintResult("stun_check_rate", "_stun_message", "",
+                            MeasureCheckRate(&AnswerWithStunMessage),
+                            "checks/s", false);
+  webrtc::test::PrintResult("stun_check_rate", "_view", "",
+                            MeasureCheckRate(&AnswerWithView),
+                            "checks/s", true);
+}
+
+}  // namespace cricket
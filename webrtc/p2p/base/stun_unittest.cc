@@ -1443,4 +1443,163 @@ TEST_F(StunTest, ReadRelayMessage) {
   EXPECT_EQ(0, memcmp(outstring2.c_str(), input, len2));
 }
 
+// Check that a StunMessageView sees the same message as StunMessage::Read().
+TEST_F(StunTest, ParseMessageView) {
+  const char* input = reinterpret_cast<const char*>(kRfc5769SampleRequest);
+  StunMessageView view;
+  ASSERT_TRUE(view.Parse(input, sizeof(kRfc5769SampleRequest)));
+  EXPECT_EQ(STUN_BINDING_REQUEST, view.type());
+  EXPECT_FALSE(view.IsLegacy());
+  ASSERT_EQ(kStunTransactionIdLength, view.transaction_id_length());
+  EXPECT_EQ(0, memcmp(kRfc5769SampleMsgTransactionId, view.transaction_id(),
+                      kStunTransactionIdLength));
+
+  uint32 priority;
+  EXPECT_TRUE(view.GetUInt32(STUN_ATTR_PRIORITY, &priority));
+  EXPECT_EQ(0x6e0001ffU, priority);
+  const char* username;
+  size_t username_length;
+  ASSERT_TRUE(view.GetAttribute(STUN_ATTR_USERNAME, &username,
+                                &username_length));
+  EXPECT_EQ(kRfc5769SampleMsgUsername,
+            std::string(username, username_length));
+  EXPECT_TRUE(view.HasAttribute(STUN_ATTR_FINGERPRINT));
+  EXPECT_FALSE(view.HasAttribute(STUN_ATTR_XOR_MAPPED_ADDRESS));
+
+  EXPECT_TRUE(view.ValidateMessageIntegrity(kRfc5769SampleMsgPassword));
+  EXPECT_FALSE(view.ValidateMessageIntegrity("InvalidPassword"));
+  EXPECT_TRUE(view.ValidateFingerprint());
+}
+
+TEST_F(StunTest, ParseLegacyMessageView) {
+  unsigned char rfc3489_packet[sizeof(kStunMessageWithIPv4MappedAddress)];
+  memcpy(rfc3489_packet, kStunMessageWithIPv4MappedAddress,
+      sizeof(kStunMessageWithIPv4MappedAddress));
+  memcpy(&rfc3489_packet[4], "ABCD", 4);
+
+  StunMessageView view;
+  ASSERT_TRUE(view.Parse(reinterpret_cast<const char*>(rfc3489_packet),
+                         sizeof(rfc3489_packet)));
+  EXPECT_EQ(STUN_BINDING_RESPONSE, view.type());
+  EXPECT_TRUE(view.IsLegacy());
+  ASSERT_EQ(kStunLegacyTransactionIdLength, view.transaction_id_length());
+  EXPECT_EQ(0, memcmp(&rfc3489_packet[4], view.transaction_id(),
+                      kStunLegacyTransactionIdLength));
+}
+
+void CheckFailureToParse(const unsigned char* testcase, size_t length) {
+  StunMessageView view;
+  ASSERT_FALSE(view.Parse(reinterpret_cast<const char*>(testcase), length));
+}
+
+TEST_F(StunTest, FailToParseInvalidMessageViews) {
+  CheckFailureToParse(kStunMessageWithZeroLength,
+                      kRealLengthOfInvalidLengthTestCases);
+  CheckFailureToParse(kStunMessageWithSmallLength,
+                      kRealLengthOfInvalidLengthTestCases);
+  CheckFailureToParse(kStunMessageWithExcessLength,
+                      kRealLengthOfInvalidLengthTestCases);
+  CheckFailureToParse(kRtcpPacket, sizeof(kRtcpPacket));
+  // The message length is right, but USERNAME claims more bytes than that.
+  unsigned char truncated[sizeof(kStunMessageWithByteStringAttribute)];
+  memcpy(truncated, kStunMessageWithByteStringAttribute, sizeof(truncated));
+  truncated[23] = 0x0c;
+  CheckFailureToParse(truncated, sizeof(truncated));
+}
+
+// Check that StunMessageBuilder writes the same bytes as StunMessage.
+TEST_F(StunTest, BuildMessageLikeStunMessage) {
+  const std::string transaction_id(
+      reinterpret_cast<const char*>(kRfc5769SampleMsgTransactionId),
+      sizeof(kRfc5769SampleMsgTransactionId));
+  TurnMessage msg;
+  msg.SetType(STUN_BINDING_ERROR_RESPONSE);
+  msg.SetTransactionID(transaction_id);
+  EXPECT_TRUE(msg.AddAttribute(new StunUInt32Attribute(
+      STUN_ATTR_RETRANSMIT_COUNT, 3)));
+  EXPECT_TRUE(msg.AddAttribute(new StunByteStringAttribute(
+      STUN_ATTR_USERNAME, kRfc5769SampleMsgUsername)));
+  EXPECT_TRUE(msg.AddAttribute(new StunAddressAttribute(
+      STUN_ATTR_MAPPED_ADDRESS, kRfc5769SampleMsgMappedAddress)));
+  EXPECT_TRUE(msg.AddAttribute(new StunXorAddressAttribute(
+      STUN_ATTR_XOR_MAPPED_ADDRESS, kRfc5769SampleMsgMappedAddress)));
+  EXPECT_TRUE(msg.AddAttribute(new StunXorAddressAttribute(
+      STUN_ATTR_XOR_PEER_ADDRESS, kRfc5769SampleMsgIPv6MappedAddress)));
+  StunErrorCodeAttribute* error_code = StunAttribute::CreateErrorCode();
+  error_code->SetCode(STUN_ERROR_UNAUTHORIZED);
+  error_code->SetReason(STUN_ERROR_REASON_UNAUTHORIZED);
+  EXPECT_TRUE(msg.AddAttribute(error_code));
+  EXPECT_TRUE(msg.AddMessageIntegrity(kRfc5769SampleMsgPassword));
+  EXPECT_TRUE(msg.AddFingerprint());
+  rtc::ByteBuffer expected;
+  EXPECT_TRUE(msg.Write(&expected));
+
+  char buffer[256];
+  StunMessageBuilder builder(buffer, sizeof(buffer));
+  EXPECT_TRUE(builder.Start(STUN_BINDING_ERROR_RESPONSE,
+                            transaction_id.data(), transaction_id.size()));
+  EXPECT_TRUE(builder.AddUInt32(STUN_ATTR_RETRANSMIT_COUNT, 3));
+  EXPECT_TRUE(builder.AddByteString(STUN_ATTR_USERNAME,
+                                    kRfc5769SampleMsgUsername,
+                                    strlen(kRfc5769SampleMsgUsername)));
+  EXPECT_TRUE(builder.AddAddress(STUN_ATTR_MAPPED_ADDRESS,
+                                 kRfc5769SampleMsgMappedAddress));
+  EXPECT_TRUE(builder.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS,
+                                    kRfc5769SampleMsgMappedAddress));
+  EXPECT_TRUE(builder.AddXorAddress(STUN_ATTR_XOR_PEER_ADDRESS,
+                                    kRfc5769SampleMsgIPv6MappedAddress));
+  EXPECT_TRUE(builder.AddErrorCode(STUN_ERROR_UNAUTHORIZED,
+                                   STUN_ERROR_REASON_UNAUTHORIZED));
+  EXPECT_TRUE(builder.AddMessageIntegrity(kRfc5769SampleMsgPassword));
+  EXPECT_TRUE(builder.AddFingerprint());
+
+  ASSERT_EQ(expected.Length(), builder.size());
+  EXPECT_EQ(0, memcmp(expected.Data(), builder.data(), builder.size()));
+  EXPECT_TRUE(StunMessage::ValidateMessageIntegrity(
+      builder.data(), builder.size(), kRfc5769SampleMsgPassword));
+  EXPECT_TRUE(StunMessage::ValidateFingerprint(builder.data(),
+                                               builder.size()));
+}
+
+TEST_F(StunTest, BuildLegacyMessage) {
+  const char kLegacyTransactionId[] = "0123456789abcdef";
+  char buffer[64];
+  StunMessageBuilder builder(buffer, sizeof(buffer));
+  EXPECT_TRUE(builder.Start(STUN_BINDING_RESPONSE, kLegacyTransactionId,
+                            kStunLegacyTransactionIdLength));
+  EXPECT_TRUE(builder.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS,
+                                    kRfc5769SampleMsgMappedAddress));
+  // IPv6 addresses can't be XORed without the magic cookie.
+  EXPECT_FALSE(builder.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS,
+                                     kRfc5769SampleMsgIPv6MappedAddress));
+
+  StunMessage msg;
+  rtc::ByteBuffer buf(builder.data(), builder.size());
+  ASSERT_TRUE(msg.Read(&buf));
+  EXPECT_TRUE(msg.IsLegacy());
+  EXPECT_EQ(kLegacyTransactionId, msg.transaction_id());
+  const StunAddressAttribute* addr =
+      msg.GetAddress(STUN_ATTR_XOR_MAPPED_ADDRESS);
+  ASSERT_TRUE(addr != NULL);
+  EXPECT_EQ(kRfc5769SampleMsgMappedAddress, addr->GetAddress());
+}
+
+// Attributes that don't fit must leave the message as it was.
+TEST_F(StunTest, BuildMessageInSmallBuffer) {
+  char buffer[kStunHeaderSize + 8 + 20];
+  StunMessageBuilder builder(buffer, sizeof(buffer));
+  EXPECT_FALSE(builder.AddUInt32(STUN_ATTR_PRIORITY, 1));
+  EXPECT_TRUE(builder.Start(
+      STUN_BINDING_REQUEST,
+      reinterpret_cast<const char*>(kRfc5769SampleMsgTransactionId),
+      kStunTransactionIdLength));
+  EXPECT_TRUE(builder.AddUInt32(STUN_ATTR_PRIORITY, 1));
+  EXPECT_FALSE(builder.AddMessageIntegrity(kRfc5769SampleMsgPassword));
+  EXPECT_EQ(kStunHeaderSize + 8, builder.size());
+  EXPECT_EQ(8, rtc::GetBE16(builder.data() + 2));
+  EXPECT_TRUE(builder.AddFingerprint());
+  EXPECT_TRUE(StunMessage::ValidateFingerprint(builder.data(),
+                                               builder.size()));
+}
+
 }  // namespace cricket
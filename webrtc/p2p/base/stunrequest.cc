@@ -10,30 +10,65 @@
 
 #include "webrtc/p2p/base/stunrequest.h"
 
+#include <string.h>
+
 #include <algorithm>
+#include "webrtc/base/byteorder.h"
 #include "webrtc/base/common.h"
 #include "webrtc/base/helpers.h"
 #include "webrtc/base/logging.h"
 #include "webrtc/base/stringencode.h"
+#include "webrtc/base/timeutils.h"
 
 namespace cricket {
 
 const uint32 MSG_STUN_SEND = 1;
+const uint32 MSG_STUN_TIMER = 2;
 
 const int MAX_SENDS = 9;
 const int DELAY_UNIT = 100;  // 100 milliseconds
 const int DELAY_MAX_FACTOR = 16;
 
+// The request table grows to keep its load factor at or below 1/2.
+const size_t kMinTableSize = 16;
+
+namespace {
+
+// Like rtc::Time(), but does not wrap around.
+uint64 TimeMillis() {
+  return rtc::TimeNanos() / rtc::kNumNanosecsPerMillisec;
+}
+
+// Returns the slot of a table of |table_size| slots that a transaction ID
+// hashes to.  Transaction IDs are random, so it is enough to fold their words
+// together and spread the result with a multiplicative hash, whose high bits
+// pick the slot.
+size_t HashTransactionId(const char* id, size_t table_size) {
+  uint32 hash = rtc::GetBE32(id) ^ rtc::GetBE32(id + 4) ^
+      rtc::GetBE32(id + 8);
+  hash *= 2654435761U;
+  return static_cast<size_t>((static_cast<uint64>(hash) * table_size) >> 32);
+}
+
+}  // namespace
+
 StunRequestManager::StunRequestManager(rtc::Thread* thread)
-    : thread_(thread) {
+    : thread_(thread), num_requests_(0) {
 }
 
 StunRequestManager::~StunRequestManager() {
-  while (requests_.begin() != requests_.end()) {
-    StunRequest *request = requests_.begin()->second;
-    requests_.erase(requests_.begin());
-    delete request;
+  std::vector<StunRequest*> requests;
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    if (requests_[i].request)
+      requests.push_back(requests_[i].request);
   }
+  // Forget the requests first so that their destructors find nothing to
+  // remove.
+  requests_.clear();
+  num_requests_ = 0;
+  send_queue_.clear();
+  for (size_t i = 0; i < requests.size(); ++i)
+    delete requests[i];
 }
 
 void StunRequestManager::Send(StunRequest* request) {
@@ -42,31 +77,37 @@ void StunRequestManager::Send(StunRequest* request) {
 
 void StunRequestManager::SendDelayed(StunRequest* request, int delay) {
   request->set_manager(this);
-  ASSERT(requests_.find(request->id()) == requests_.end());
   request->set_origin(origin_);
   request->Construct();
-  requests_[request->id()] = request;
+  Insert(request);
   if (delay > 0) {
-    thread_->PostDelayed(delay, request, MSG_STUN_SEND, NULL);
+    Schedule(request, delay);
+    UpdateTimer();
+  } else if (thread_->IsCurrent()) {
+    request->SendOrTimeout();
+    UpdateTimer();
   } else {
-    thread_->Send(request, MSG_STUN_SEND, NULL);
+    thread_->Send(this, MSG_STUN_SEND,
+                  new rtc::TypedMessageData<StunRequest*>(request));
   }
 }
 
 void StunRequestManager::Remove(StunRequest* request) {
   ASSERT(request->manager() == this);
-  RequestMap::iterator iter = requests_.find(request->id());
-  if (iter != requests_.end()) {
-    ASSERT(iter->second == request);
-    requests_.erase(iter);
-    thread_->Clear(request);
+  int index = Find(request->id().data(), request->id().size());
+  if (index >= 0) {
+    ASSERT(requests_[index].request == request);
+    Erase(index);
+    send_queue_.erase(std::make_pair(request->send_time_, request));
   }
 }
 
 void StunRequestManager::Clear() {
   std::vector<StunRequest*> requests;
-  for (RequestMap::iterator i = requests_.begin(); i != requests_.end(); ++i)
-    requests.push_back(i->second);
+  for (size_t i = 0; i < requests_.size(); ++i) {
+    if (requests_[i].request)
+      requests.push_back(requests_[i].request);
+  }
 
   for (uint32 i = 0; i < requests.size(); ++i) {
     // StunRequest destructor calls Remove() which deletes requests
@@ -76,14 +117,15 @@ void StunRequestManager::Clear() {
 }
 
 bool StunRequestManager::CheckResponse(StunMessage* msg) {
-  RequestMap::iterator iter = requests_.find(msg->transaction_id());
-  if (iter == requests_.end()) {
+  int index = Find(msg->transaction_id().data(),
+                   msg->transaction_id().size());
+  if (index < 0) {
     // TODO(pthatcher): Log unknown responses without being too spammy
     // in the logs.
     return false;
   }
 
-  StunRequest* request = iter->second;
+  StunRequest* request = requests_[index].request;
   if (msg->type() == GetStunSuccessResponseType(request->type())) {
     request->OnResponse(msg);
   } else if (msg->type() == GetStunErrorResponseType(request->type())) {
@@ -106,11 +148,9 @@ bool StunRequestManager::CheckResponse(const char* data, size_t size) {
   if (size < 20)
     return false;
 
-  std::string id;
-  id.append(data + kStunTransactionIdOffset, kStunTransactionIdLength);
-
-  RequestMap::iterator iter = requests_.find(id);
-  if (iter == requests_.end()) {
+  const char* id = data + kStunTransactionIdOffset;
+  int index = Find(id, kStunTransactionIdLength);
+  if (index < 0) {
     // TODO(pthatcher): Log unknown responses without being too spammy
     // in the logs.
     return false;
@@ -119,35 +159,138 @@ bool StunRequestManager::CheckResponse(const char* data, size_t size) {
   // Parse the STUN message and continue processing as usual.
 
   rtc::ByteBuffer buf(data, size);
-  rtc::scoped_ptr<StunMessage> response(iter->second->msg_->CreateNew());
+  rtc::scoped_ptr<StunMessage> response(
+      requests_[index].request->msg_->CreateNew());
   if (!response->Read(&buf)) {
-    LOG(LS_WARNING) << "Failed to read STUN response " << rtc::hex_encode(id);
+    LOG(LS_WARNING) << "Failed to read STUN response "
+                    << rtc::hex_encode(id, kStunTransactionIdLength);
     return false;
   }
 
   return CheckResponse(response.get());
 }
 
+int StunRequestManager::Find(const char* id, size_t length) const {
+  if (length != kStunTransactionIdLength || requests_.empty())
+    return -1;
+  const size_t mask = requests_.size() - 1;
+  for (size_t i = HashTransactionId(id, requests_.size());
+       requests_[i].request; i = (i + 1) & mask) {
+    if (memcmp(requests_[i].id, id, kStunTransactionIdLength) == 0)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+void StunRequestManager::Insert(StunRequest* request) {
+  // Our own requests always have IDs of the standard length.
+  ASSERT(request->id().size() == kStunTransactionIdLength);
+  ASSERT(Find(request->id().data(), request->id().size()) < 0);
+  if (2 * (num_requests_ + 1) > requests_.size())
+    Resize(std::max(2 * requests_.size(), kMinTableSize));
+
+  const size_t mask = requests_.size() - 1;
+  size_t i = HashTransactionId(request->id().data(), requests_.size());
+  while (requests_[i].request)
+    i = (i + 1) & mask;
+  memcpy(requests_[i].id, request->id().data(), kStunTransactionIdLength);
+  requests_[i].request = request;
+  ++num_requests_;
+}
+
+void StunRequestManager::Erase(size_t index) {
+  // Shift the following slots of the probe sequence back into the hole,
+  // unless that would move them in front of the slot they hash to.
+  const size_t mask = requests_.size() - 1;
+  size_t hole = index;
+  for (size_t i = (index + 1) & mask; requests_[i].request;
+       i = (i + 1) & mask) {
+    size_t home = HashTransactionId(requests_[i].id, requests_.size());
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      requests_[hole] = requests_[i];
+      hole = i;
+    }
+  }
+  requests_[hole].request = NULL;
+  --num_requests_;
+}
+
+void StunRequestManager::Resize(size_t size) {
+  std::vector<Slot> slots(size);
+  slots.swap(requests_);
+  num_requests_ = 0;
+  for (size_t i = 0; i < slots.size(); ++i) {
+    if (slots[i].request)
+      Insert(slots[i].request);
+  }
+}
+
+void StunRequestManager::Schedule(StunRequest* request, int delay) {
+  // A request due right away is still sent by the next timer, not by the
+  // one currently running.
+  request->send_time_ = TimeMillis() + std::max(delay, 1);
+  send_queue_.insert(std::make_pair(request->send_time_, request));
+}
+
+void StunRequestManager::UpdateTimer() {
+  if (send_queue_.empty())
+    return;
+  uint64 send_time = send_queue_.begin()->first;
+  if (!timers_.empty() && *timers_.begin() <= send_time)
+    return;
+
+  // The timers that are already pending stay, and do nothing if no request
+  // is due when they fire.
+  uint64 now = TimeMillis();
+  int delay = send_time > now ? static_cast<int>(send_time - now) : 0;
+  timers_.insert(send_time);
+  thread_->PostDelayed(delay, this, MSG_STUN_TIMER, NULL);
+}
+
+void StunRequestManager::OnMessage(rtc::Message* pmsg) {
+  if (pmsg->message_id == MSG_STUN_SEND) {
+    rtc::TypedMessageData<StunRequest*>* data =
+        static_cast<rtc::TypedMessageData<StunRequest*>*>(pmsg->pdata);
+    data->data()->SendOrTimeout();
+    delete data;
+    UpdateTimer();
+    return;
+  }
+
+  ASSERT(pmsg->message_id == MSG_STUN_TIMER);
+  // Timers fire in order, so this is the first one.
+  if (!timers_.empty())
+    timers_.erase(timers_.begin());
+
+  // Sending may delete any request, so the queue is looked at afresh each
+  // time.
+  uint64 now = TimeMillis();
+  while (!send_queue_.empty() && send_queue_.begin()->first <= now) {
+    StunRequest* request = send_queue_.begin()->second;
+    send_queue_.erase(send_queue_.begin());
+    request->SendOrTimeout();
+  }
+  UpdateTimer();
+}
+
 StunRequest::StunRequest()
     : count_(0), timeout_(false), manager_(0),
-      msg_(new StunMessage()), tstamp_(0) {
+      msg_(new StunMessage()), tstamp_(0), send_time_(0) {
   msg_->SetTransactionID(
       rtc::CreateRandomString(kStunTransactionIdLength));
 }
 
 StunRequest::StunRequest(StunMessage* request)
     : count_(0), timeout_(false), manager_(0),
-      msg_(request), tstamp_(0) {
+      msg_(request), tstamp_(0), send_time_(0) {
   msg_->SetTransactionID(
       rtc::CreateRandomString(kStunTransactionIdLength));
 }
 
 StunRequest::~StunRequest() {
   ASSERT(manager_ != NULL);
-  if (manager_) {
+  if (manager_)
     manager_->Remove(this);
-    manager_->thread_->Clear(this);
-  }
   delete msg_;
 }
 
@@ -181,9 +324,8 @@ void StunRequest::set_manager(StunRequestManager* manager) {
   manager_ = manager;
 }
 
-void StunRequest::OnMessage(rtc::Message* pmsg) {
+void StunRequest::SendOrTimeout() {
   ASSERT(manager_ != NULL);
-  ASSERT(pmsg->message_id == MSG_STUN_SEND);
 
   if (timeout_) {
     OnTimeout();
@@ -198,7 +340,7 @@ void StunRequest::OnMessage(rtc::Message* pmsg) {
   manager_->SignalSendPacket(buf.Data(), buf.Length(), this);
 
   OnSent();
-  manager_->thread_->PostDelayed(resend_delay(), this, MSG_STUN_SEND, NULL);
+  manager_->Schedule(this, resend_delay());
 }
 
 void StunRequest::OnSent() {
@@ -11,8 +11,10 @@
 #ifndef WEBRTC_P2P_BASE_STUNREQUEST_H_
 #define WEBRTC_P2P_BASE_STUNREQUEST_H_
 
-#include <map>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 #include "webrtc/p2p/base/stun.h"
 #include "webrtc/base/sigslot.h"
 #include "webrtc/base/thread.h"
@@ -22,8 +24,10 @@ namespace cricket {
 class StunRequest;
 
 // Manages a set of STUN requests, sending and resending until we receive a
-// response or determine that the request has timed out.
-class StunRequestManager {
+// response or determine that the request has timed out.  All retransmissions
+// are driven by a single timer, so the thread's message queue holds at most a
+// few messages for the manager no matter how many requests are outstanding.
+class StunRequestManager : public rtc::MessageHandler {
  public:
   StunRequestManager(rtc::Thread* thread);
   ~StunRequestManager();
@@ -44,7 +48,7 @@ class StunRequestManager {
   bool CheckResponse(StunMessage* msg);
   bool CheckResponse(const char* data, size_t size);
 
-  bool empty() { return requests_.empty(); }
+  bool empty() { return num_requests_ == 0; }
 
   // Set the Origin header for outgoing stun messages.
   void set_origin(const std::string& origin) { origin_ = origin; }
@@ -53,10 +57,39 @@ class StunRequestManager {
   sigslot::signal3<const void*, size_t, StunRequest*> SignalSendPacket;
 
  private:
-  typedef std::map<std::string, StunRequest*> RequestMap;
+  // A slot of the request table.  The transaction ID is copied into the slot
+  // so that probing does not have to touch the requests.
+  struct Slot {
+    char id[kStunTransactionIdLength];
+    StunRequest* request;
+  };
+  // Requests ordered by the time (in ms) at which they are next sent.
+  typedef std::set<std::pair<uint64, StunRequest*> > SendQueue;
+
+  // Returns the index of the slot holding the request with the given
+  // transaction ID, or -1 if there is none.
+  int Find(const char* id, size_t length) const;
+  void Insert(StunRequest* request);
+  void Erase(size_t index);
+  void Resize(size_t size);
+
+  // Queues |request| to be sent |delay| ms from now.  UpdateTimer() must be
+  // called afterwards for the send to happen.
+  void Schedule(StunRequest* request, int delay);
+  // Makes sure that a timer is pending for the first request in
+  // |send_queue_|.
+  void UpdateTimer();
+
+  void OnMessage(rtc::Message* pmsg) override;
 
   rtc::Thread* thread_;
-  RequestMap requests_;
+  // Outstanding requests, in an open-addressed hash table indexed by the
+  // transaction ID and probed linearly.  Its size is a power of two.
+  std::vector<Slot> requests_;
+  size_t num_requests_;
+  SendQueue send_queue_;
+  // Times (in ms) at which the timer messages posted to |thread_| fire.
+  std::set<uint64> timers_;
   std::string origin_;
 
   friend class StunRequest;
@@ -64,7 +97,7 @@ class StunRequestManager {
 
 // Represents an individual request to be sent.  The STUN message can either be
 // constructed beforehand or built on demand.
-class StunRequest : public rtc::MessageHandler {
+class StunRequest {
  public:
   StunRequest();
   StunRequest(StunMessage* request);
@@ -113,12 +146,15 @@ class StunRequest : public rtc::MessageHandler {
  private:
   void set_manager(StunRequestManager* manager);
 
-  // Handles messages for sending and timeout.
-  void OnMessage(rtc::Message* pmsg);
+  // Sends the request, or times it out once it has been sent for the last
+  // time.
+  void SendOrTimeout();
 
   StunRequestManager* manager_;
   StunMessage* msg_;
   uint32 tstamp_;
+  // When the request is next sent, if it is in the manager's send queue.
+  uint64 send_time_;
 
   friend class StunRequestManager;
 };
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "webrtc/p2p/base/stunrequest.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+const int kNumRequests = 10000;
+// Long enough for the sends at 100 and 300 ms, but not the one at 700 ms.
+const int kRetransmitMs = 500;
+
+class BindingRequest : public StunRequest {
+ private:
+  void Prepare(StunMessage* request) override {
+    request->SetType(STUN_BINDING_REQUEST);
+  }
+};
+
+class PacketCounter : public sigslot::has_slots<> {
+ public:
+  PacketCounter() : num_packets_(0) {}
+  int num_packets() const { return num_packets_; }
+  void OnSendPacket(const void* data, size_t size, StunRequest* request) {
+    ++num_packets_;
+  }
+
+ private:
+  int num_packets_;
+};
+
+}  // namespace
+
+TEST(StunRequestPerfTest, ManyOutstandingRequests) {
+  rtc::Thread* thread = rtc::Thread::Current();
+  StunRequestManager manager(thread);
+  PacketCounter counter;
+  manager.SignalSendPacket.connect(&counter, &PacketCounter::OnSendPacket);
+
+  std::vector<StunRequest*> requests;
+  for (int i = 0; i < kNumRequests; ++i)
+    requests.push_back(new BindingRequest());
+  std::vector<std::string> responses;
+  for (int i = 0; i < kNumRequests; ++i) {
+    StunMessage response;
+    response.SetType(STUN_BINDING_RESPONSE);
+    response.SetTransactionID(requests[i]->id());
+    rtc::ByteBuffer buf;
+    response.Write(&buf);
+    responses.push_back(std::string(buf.Data(), buf.Length()));
+  }
+  std::random_shuffle(responses.begin(), responses.end());
+
+  const size_t queued_before = thread->size();
+  uint64 start_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumRequests; ++i)
+    manager.Send(requests[i]);
+  uint64 elapsed_us = rtc::TimeMicros() - start_us;
+  EXPECT_EQ(kNumRequests, counter.num_packets());
+  webrtc::test::PrintResult("stun_request_send_rate", "", "10k_requests",
+                            1e6 * kNumRequests /
+                                std::max<uint64>(elapsed_us, 1),
+                            "requests/s", true);
+  webrtc::test::PrintResult("stun_request_queued_messages", "",
+                            "10k_requests", thread->size() - queued_before,
+                            "messages", false);
+
+  // Only the time spent retransmitting counts, not the time waiting.
+  clock_t start_clock = clock();
+  thread->ProcessMessages(kRetransmitMs);
+  double cpu_ns = 1e9 * (clock() - start_clock) / CLOCKS_PER_SEC;
+  const int num_retransmits = counter.num_packets() - kNumRequests;
+  EXPECT_EQ(2 * kNumRequests, num_retransmits);
+  webrtc::test::PrintResult("stun_retransmit_cost", "", "10k_requests",
+                            cpu_ns / std::max(num_retransmits, 1),
+                            "ns/retransmit", false);
+
+  start_us = rtc::TimeMicros();
+  for (size_t i = 0; i < responses.size(); ++i) {
+    EXPECT_TRUE(manager.CheckResponse(responses[i].data(),
+                                      responses[i].size()));
+  }
+  elapsed_us = rtc::TimeMicros() - start_us;
+  EXPECT_TRUE(manager.empty());
+  webrtc::test::PrintResult("stun_response_match_rate", "", "10k_requests",
+                            1e6 * kNumRequests /
+                                std::max<uint64>(elapsed_us, 1),
+                            "responses/s", true);
+}
+
+}  // namespace cricket
@@ -8,6 +8,9 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string>
+#include <vector>
+
 #include "webrtc/p2p/base/stunrequest.h"
 #include "webrtc/base/gunit.h"
 #include "webrtc/base/helpers.h"
@@ -182,6 +185,51 @@ TEST_F(StunRequestTest, TestTimeout) {
   delete res;
 }
 
+// Test that responses are matched among many outstanding requests, in
+// whichever order they come, and that all the requests get resent.
+TEST_F(StunRequestTest, TestManyRequests) {
+  const int kNumRequests = 1000;
+  std::vector<std::string> ids;
+  for (int i = 0; i < kNumRequests; ++i) {
+    StunRequestThunker* request = new StunRequestThunker(this);
+    ids.push_back(request->id());
+    manager_.Send(request);
+  }
+  EXPECT_EQ(kNumRequests, request_count_);
+  EXPECT_TRUE_WAIT(request_count_ >= 2 * kNumRequests, 1000);
+
+  // Respond to every other request, then to the rest.
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int i = pass; i < kNumRequests; i += 2) {
+      StunMessage res;
+      res.SetType(STUN_BINDING_RESPONSE);
+      res.SetTransactionID(ids[i]);
+      rtc::ByteBuffer buf;
+      res.Write(&buf);
+      EXPECT_TRUE(manager_.CheckResponse(buf.Data(), buf.Length()));
+      EXPECT_FALSE(manager_.CheckResponse(buf.Data(), buf.Length()));
+    }
+  }
+  EXPECT_TRUE(manager_.empty());
+  EXPECT_TRUE(success_);
+  EXPECT_FALSE(timeout_);
+}
+
+// Test that a deleted request is not sent, while the others still are.
+TEST_F(StunRequestTest, TestDeletedRequestIsNotSent) {
+  StunRequestThunker* request1 = new StunRequestThunker(this);
+  StunRequestThunker* request2 = new StunRequestThunker(this);
+  manager_.SendDelayed(request1, 100);
+  manager_.SendDelayed(request2, 200);
+  delete request1;
+
+  EXPECT_TRUE_WAIT(request_count_ > 0, 1000);
+  EXPECT_EQ(1, request_count_);
+  EXPECT_FALSE(manager_.empty());
+  manager_.Clear();
+  EXPECT_TRUE(manager_.empty());
+}
+
 // Regression test for specific crash where we receive a response with the
 // same id as a request that doesn't have an underlying StunMessage yet.
 TEST_F(StunRequestTest, TestNoEmptyRequest) {
@@ -10,11 +10,13 @@
 
 #include "webrtc/p2p/base/stunserver.h"
 
-#include "webrtc/base/bytebuffer.h"
 #include "webrtc/base/logging.h"
 
 namespace cricket {
 
+// Responses are built on the stack; none of them comes close to this.
+static const size_t kMaxResponseSize = 512;
+
 StunServer::StunServer(rtc::AsyncUDPSocket* socket) : socket_(socket) {
   socket_->SignalReadPacket.connect(this, &StunServer::OnPacket);
 }
@@ -27,10 +29,10 @@ void StunServer::OnPacket(
     rtc::AsyncPacketSocket* socket, const char* buf, size_t size,
     const rtc::SocketAddress& remote_addr,
     const rtc::PacketTime& packet_time) {
-  // Parse the STUN message; eat any messages that fail to parse.
-  rtc::ByteBuffer bbuf(buf, size);
-  StunMessage msg;
-  if (!msg.Read(&bbuf)) {
+  // Parse the STUN message; eat any messages that fail to parse. The server
+  // only looks at the header, so the message isn't copied.
+  StunMessageView msg;
+  if (!msg.Parse(buf, size)) {
     return;
   }
 
@@ -40,7 +42,7 @@ void StunServer::OnPacket(
   // Send the message to the appropriate handler function.
   switch (msg.type()) {
     case STUN_BINDING_REQUEST:
-      OnBindingRequest(&msg, remote_addr);
+      OnBindingRequest(msg, remote_addr);
       break;
 
     default:
@@ -49,51 +51,49 @@ void StunServer::OnPacket(
 }
 
 void StunServer::OnBindingRequest(
-    StunMessage* msg, const rtc::SocketAddress& remote_addr) {
-  StunMessage response;
-  GetStunBindReqponse(msg, remote_addr, &response);
-  SendResponse(response, remote_addr);
+    const StunMessageView& msg, const rtc::SocketAddress& remote_addr) {
+  SendBindingResponse(msg, remote_addr, remote_addr);
 }
 
 void StunServer::SendErrorResponse(
-    const StunMessage& msg, const rtc::SocketAddress& addr,
+    const StunMessageView& msg, const rtc::SocketAddress& addr,
     int error_code, const char* error_desc) {
-  StunMessage err_msg;
-  err_msg.SetType(GetStunErrorResponseType(msg.type()));
-  err_msg.SetTransactionID(msg.transaction_id());
-
-  StunErrorCodeAttribute* err_code = StunAttribute::CreateErrorCode();
-  err_code->SetCode(error_code);
-  err_code->SetReason(error_desc);
-  err_msg.AddAttribute(err_code);
-
+  char buffer[kMaxResponseSize];
+  StunMessageBuilder err_msg(buffer, sizeof(buffer));
+  if (!err_msg.Start(GetStunErrorResponseType(msg.type()),
+                     msg.transaction_id(), msg.transaction_id_length()) ||
+      !err_msg.AddErrorCode(error_code, error_desc)) {
+    return;
+  }
   SendResponse(err_msg, addr);
 }
 
-void StunServer::SendResponse(
-    const StunMessage& msg, const rtc::SocketAddress& addr) {
-  rtc::ByteBuffer buf;
-  msg.Write(&buf);
-  rtc::PacketOptions options;
-  if (socket_->SendTo(buf.Data(), buf.Length(), addr, options) < 0)
-    LOG_ERR(LS_ERROR) << "sendto";
-}
-
-void StunServer::GetStunBindReqponse(StunMessage* request,
-                                     const rtc::SocketAddress& remote_addr,
-                                     StunMessage* response) const {
-  response->SetType(STUN_BINDING_RESPONSE);
-  response->SetTransactionID(request->transaction_id());
+void StunServer::SendBindingResponse(const StunMessageView& request,
+                                     const rtc::SocketAddress& mapped_addr,
+                                     const rtc::SocketAddress& addr) {
+  char buffer[kMaxResponseSize];
+  StunMessageBuilder response(buffer, sizeof(buffer));
+  if (!response.Start(STUN_BINDING_RESPONSE, request.transaction_id(),
+                      request.transaction_id_length())) {
+    return;
+  }
 
   // Tell the user the address that we received their request from.
-  StunAddressAttribute* mapped_addr;
-  if (!request->IsLegacy()) {
-    mapped_addr = StunAttribute::CreateAddress(STUN_ATTR_MAPPED_ADDRESS);
+  bool added;
+  if (!request.IsLegacy()) {
+    added = response.AddAddress(STUN_ATTR_MAPPED_ADDRESS, mapped_addr);
   } else {
-    mapped_addr = StunAttribute::CreateXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS);
+    added = response.AddXorAddress(STUN_ATTR_XOR_MAPPED_ADDRESS, mapped_addr);
   }
-  mapped_addr->SetAddress(remote_addr);
-  response->AddAttribute(mapped_addr);
+  if (added)
+    SendResponse(response, addr);
+}
+
+void StunServer::SendResponse(
+    const StunMessageBuilder& msg, const rtc::SocketAddress& addr) {
+  rtc::PacketOptions options;
+  if (socket_->SendTo(msg.data(), msg.size(), addr, options) < 0)
+    LOG_ERR(LS_ERROR) << "sendto";
 }
 
 }  // namespace cricket
@@ -34,7 +34,7 @@ class StunServer : public sigslot::has_slots<> {
       const rtc::PacketTime& packet_time);
 
   // Handlers for the different types of STUN/TURN requests:
-  virtual void OnBindingRequest(StunMessage* msg,
+  virtual void OnBindingRequest(const StunMessageView& msg,
       const rtc::SocketAddress& addr);
   void OnAllocateRequest(StunMessage* msg,
       const rtc::SocketAddress& addr);
@@ -45,18 +45,19 @@ class StunServer : public sigslot::has_slots<> {
 
   // Sends an error response to the given message back to the user.
   void SendErrorResponse(
-      const StunMessage& msg, const rtc::SocketAddress& addr,
+      const StunMessageView& msg, const rtc::SocketAddress& addr,
       int error_code, const char* error_desc);
 
+  // Sends a binding response to |request|, telling the user that its
+  // request came from |mapped_addr|.
+  void SendBindingResponse(const StunMessageView& request,
+                           const rtc::SocketAddress& mapped_addr,
+                           const rtc::SocketAddress& addr);
+
   // Sends the given message to the appropriate destination.
-  void SendResponse(const StunMessage& msg,
+  void SendResponse(const StunMessageBuilder& msg,
        const rtc::SocketAddress& addr);
 
-  // A helper method to compose a STUN binding response.
-  void GetStunBindReqponse(StunMessage* request,
-                           const rtc::SocketAddress& remote_addr,
-                           StunMessage* response) const;
-
  private:
   rtc::scoped_ptr<rtc::AsyncUDPSocket> socket_;
 };
@@ -0,0 +1,170 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef WEBRTC_P2P_BASE_TESTTURNCLIENT_H_
+#define WEBRTC_P2P_BASE_TESTTURNCLIENT_H_
+
+#include <string>
+
+#include "webrtc/p2p/base/stun.h"
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/bytebuffer.h"
+#include "webrtc/base/helpers.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/sigslot.h"
+
+namespace cricket {
+
+// A bare-bones TURN client for testing TurnServer without a TurnPort: it
+// makes a UDP allocation, binds a channel to a peer, and sends and receives
+// channel data. The password is the username, as with TestTurnServer.
+// Requests aren't retransmitted, so it is only meant for loopback.
+class TestTurnClient : public sigslot::has_slots<> {
+ public:
+  TestTurnClient(rtc::SocketFactory* factory,
+                 const rtc::SocketAddress& server_address,
+                 const std::string& username)
+      : socket_(rtc::AsyncUDPSocket::Create(
+            factory, rtc::SocketAddress(server_address.ipaddr(), 0))),
+        server_address_(server_address),
+        username_(username),
+        pending_request_(0),
+        allocated_(false),
+        channel_id_(0),
+        channel_bound_(false) {
+    socket_->SignalReadPacket.connect(this, &TestTurnClient::OnReadPacket);
+  }
+
+  bool allocated() const { return allocated_; }
+  const rtc::SocketAddress& relayed_address() const {
+    return relayed_address_;
+  }
+  bool channel_bound() const { return channel_bound_; }
+
+  void Allocate() {
+    pending_request_ = STUN_ALLOCATE_REQUEST;
+    SendRequest();
+  }
+
+  void BindChannel(int channel_id, const rtc::SocketAddress& peer) {
+    channel_id_ = channel_id;
+    peer_ = peer;
+    channel_bound_ = false;
+    pending_request_ = TURN_CHANNEL_BIND_REQUEST;
+    SendRequest();
+  }
+
+  // Sends |data| on the channel last bound.
+  void SendChannelData(const char* data, size_t size) {
+    rtc::ByteBuffer buf;
+    buf.WriteUInt16(static_cast<uint16>(channel_id_));
+    buf.WriteUInt16(static_cast<uint16>(size));
+    buf.WriteBytes(data, size);
+    Send(buf.Data(), buf.Length());
+  }
+
+  // Sends a datagram to the server as is.
+  void Send(const char* data, size_t size) {
+    rtc::PacketOptions options;
+    socket_->SendTo(data, size, server_address_, options);
+  }
+
+  // Signals the application data of the channel data received.
+  sigslot::signal3<TestTurnClient*, const char*, size_t> SignalChannelData;
+
+ private:
+  void SendRequest() {
+    TurnMessage msg;
+    msg.SetType(pending_request_);
+    msg.SetTransactionID(rtc::CreateRandomString(kStunTransactionIdLength));
+    if (pending_request_ == STUN_ALLOCATE_REQUEST) {
+      VERIFY(msg.AddAttribute(new StunUInt32Attribute(
+          STUN_ATTR_REQUESTED_TRANSPORT, IPPROTO_UDP << 24)));
+    } else {
+      VERIFY(msg.AddAttribute(new StunUInt32Attribute(
+          STUN_ATTR_CHANNEL_NUMBER, channel_id_ << 16)));
+      VERIFY(msg.AddAttribute(new StunXorAddressAttribute(
+          STUN_ATTR_XOR_PEER_ADDRESS, peer_)));
+    }
+    // The first request goes without credentials, to learn the realm and
+    // nonce from the 401 response.
+    if (!nonce_.empty()) {
+      VERIFY(msg.AddAttribute(new StunByteStringAttribute(
+          STUN_ATTR_USERNAME, username_)));
+      VERIFY(msg.AddAttribute(new StunByteStringAttribute(
+          STUN_ATTR_REALM, realm_)));
+      VERIFY(msg.AddAttribute(new StunByteStringAttribute(
+          STUN_ATTR_NONCE, nonce_)));
+      VERIFY(msg.AddMessageIntegrity(key_));
+    }
+    rtc::ByteBuffer buf;
+    msg.Write(&buf);
+    Send(buf.Data(), buf.Length());
+  }
+
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data, size_t size,
+                    const rtc::SocketAddress& addr,
+                    const rtc::PacketTime& packet_time) {
+    if (size < 4)
+      return;
+    // The first two bits of a channel data message are 0b01.
+    if ((rtc::GetBE16(data) & 0xC000) == 0x4000) {
+      size_t length = rtc::GetBE16(data + 2);
+      if (size >= 4 + length)
+        SignalChannelData(this, data + 4, length);
+      return;
+    }
+
+    TurnMessage msg;
+    rtc::ByteBuffer buf(data, size);
+    if (!msg.Read(&buf))
+      return;
+    if (msg.type() == GetStunErrorResponseType(pending_request_)) {
+      const StunErrorCodeAttribute* error = msg.GetErrorCode();
+      const StunByteStringAttribute* realm = msg.GetByteString(STUN_ATTR_REALM);
+      const StunByteStringAttribute* nonce = msg.GetByteString(STUN_ATTR_NONCE);
+      if (error && realm && nonce &&
+          (error->code() == STUN_ERROR_UNAUTHORIZED ||
+           error->code() == STUN_ERROR_STALE_NONCE)) {
+        realm_ = realm->GetString();
+        nonce_ = nonce->GetString();
+        ComputeStunCredentialHash(username_, realm_, username_, &key_);
+        SendRequest();
+      }
+    } else if (msg.type() == STUN_ALLOCATE_RESPONSE) {
+      const StunAddressAttribute* relayed_address =
+          msg.GetAddress(STUN_ATTR_XOR_RELAYED_ADDRESS);
+      if (relayed_address) {
+        relayed_address_ = relayed_address->GetAddress();
+        allocated_ = true;
+      }
+    } else if (msg.type() == TURN_CHANNEL_BIND_RESPONSE) {
+      channel_bound_ = true;
+    }
+  }
+
+  rtc::scoped_ptr<rtc::AsyncUDPSocket> socket_;
+  rtc::SocketAddress server_address_;
+  std::string username_;
+  std::string realm_;
+  std::string nonce_;
+  std::string key_;
+  int pending_request_;
+  bool allocated_;
+  rtc::SocketAddress relayed_address_;
+  int channel_id_;
+  rtc::SocketAddress peer_;
+  bool channel_bound_;
+};
+
+}  // namespace cricket
+
+#endif  // WEBRTC_P2P_BASE_TESTTURNCLIENT_H_
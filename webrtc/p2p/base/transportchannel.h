@@ -39,6 +39,20 @@ enum PacketFlags {
 // Used to indicate channel's connection state.
 enum TransportChannelState { STATE_CONNECTING, STATE_COMPLETED, STATE_FAILED };
 
+class TransportChannel;
+
+// Receives packets straight from the channel that reads them, without going
+// through SignalReadPacket. See TransportChannel::SetSrtpPacketSink.
+class SrtpPacketSink {
+ public:
+  virtual void OnSrtpPacket(TransportChannel* channel, const char* data,
+                            size_t size, const rtc::PacketTime& packet_time,
+                            int flags) = 0;
+
+ protected:
+  virtual ~SrtpPacketSink() {}
+};
+
 // A TransportChannel represents one logical stream of packets that are sent
 // between the two sides of a session.
 class TransportChannel : public sigslot::has_slots<> {
@@ -124,6 +138,18 @@ class TransportChannel : public sigslot::has_slots<> {
   sigslot::signal5<TransportChannel*, const char*,
                    size_t, const rtc::PacketTime&, int> SignalReadPacket;
 
+  // Registers |sink| to be called directly with the SRTP packets that would
+  // otherwise be signalled with PF_SRTP_BYPASS, once DTLS-SRTP is
+  // established. The sink is told they come from |channel|, which is the
+  // channel the sink's owner holds. This skips the signals of the
+  // intermediate channels on the media path; channels without such a path
+  // keep using SignalReadPacket. There is one sink per |channel|, so that
+  // channels bundled on the same transport channel each get the packets,
+  // as they would from the signal. Pass a NULL |sink| to unregister the
+  // sink of |channel|.
+  virtual void SetSrtpPacketSink(SrtpPacketSink* sink,
+                                 TransportChannel* channel) {}
+
   // This signal occurs when there is a change in the way that packets are
   // being routed, i.e. to a different remote location. The candidate
   // indicates where and how we are currently sending media.
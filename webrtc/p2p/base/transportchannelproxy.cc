@@ -24,7 +24,9 @@ enum {
 TransportChannelProxy::TransportChannelProxy(const std::string& content_name,
                                              int component)
     : TransportChannel(content_name, component),
-      impl_(NULL) {
+      impl_(NULL),
+      srtp_packet_sink_(NULL),
+      srtp_packet_sink_channel_(NULL) {
   worker_thread_ = rtc::Thread::Current();
 }
 
@@ -32,6 +34,7 @@ TransportChannelProxy::~TransportChannelProxy() {
   // Clearing any pending signal.
   worker_thread_->Clear(this);
   if (impl_) {
+    ClearSrtpPacketSink();
     impl_->GetTransport()->DestroyChannel(impl_->component());
   }
 }
@@ -46,8 +49,10 @@ void TransportChannelProxy::SetImplementation(TransportChannelImpl* impl) {
     return;
   }
 
-  // Destroy any existing impl_.
+  // Destroy any existing impl_. It may live on if it is bundled with other
+  // proxies, so take our sink off it first.
   if (impl_) {
+    ClearSrtpPacketSink();
     impl_->GetTransport()->DestroyChannel(impl_->component());
   }
 
@@ -73,6 +78,11 @@ void TransportChannelProxy::SetImplementation(TransportChannelImpl* impl) {
     if (!pending_srtp_ciphers_.empty()) {
       impl_->SetSrtpCiphers(pending_srtp_ciphers_);
     }
+
+    // And the SRTP packet sink.
+    if (srtp_packet_sink_) {
+      impl_->SetSrtpPacketSink(srtp_packet_sink_, srtp_packet_sink_channel_);
+    }
   }
 
   // Post ourselves a message to see if we need to fire state callbacks.
@@ -173,6 +183,24 @@ bool TransportChannelProxy::SetSrtpCiphers(const std::vector<std::string>&
   return true;
 }
 
+void TransportChannelProxy::SetSrtpPacketSink(SrtpPacketSink* sink,
+                                              TransportChannel* channel) {
+  ASSERT(rtc::Thread::Current() == worker_thread_);
+  ClearSrtpPacketSink();
+  // Cache so we can set it on a later impl.
+  srtp_packet_sink_ = sink;
+  srtp_packet_sink_channel_ = channel;
+  if (impl_ && srtp_packet_sink_) {
+    impl_->SetSrtpPacketSink(sink, channel);
+  }
+}
+
+void TransportChannelProxy::ClearSrtpPacketSink() {
+  if (impl_ && srtp_packet_sink_) {
+    impl_->SetSrtpPacketSink(NULL, srtp_packet_sink_channel_);
+  }
+}
+
 bool TransportChannelProxy::GetSrtpCipher(std::string* cipher) {
   ASSERT(rtc::Thread::Current() == worker_thread_);
   if (!impl_) {
@@ -68,6 +68,8 @@ class TransportChannelProxy : public TransportChannel,
                             bool use_context,
                             uint8* result,
                             size_t result_len);
+  virtual void SetSrtpPacketSink(SrtpPacketSink* sink,
+                                 TransportChannel* channel);
 
  private:
   // Catch signals from the implementation channel.  These just forward to the
@@ -80,6 +82,8 @@ class TransportChannelProxy : public TransportChannel,
   void OnRouteChange(TransportChannel* channel, const Candidate& candidate);
 
   void OnMessage(rtc::Message* message);
+  // Takes our SRTP packet sink, if any, off the current impl.
+  void ClearSrtpPacketSink();
 
   typedef std::pair<rtc::Socket::Option, int> OptionPair;
   typedef std::vector<OptionPair> OptionList;
@@ -87,6 +91,8 @@ class TransportChannelProxy : public TransportChannel,
   TransportChannelImpl* impl_;
   OptionList options_;
   std::vector<std::string> pending_srtp_ciphers_;
+  SrtpPacketSink* srtp_packet_sink_;
+  TransportChannel* srtp_packet_sink_channel_;
 
   DISALLOW_COPY_AND_ASSIGN(TransportChannelProxy);
 };
@@ -11,9 +11,12 @@
 #include "webrtc/p2p/base/turnserver.h"
 
 #include "webrtc/p2p/base/asyncstuntcpsocket.h"
+#include "webrtc/p2p/base/basicpacketsocketfactory.h"
 #include "webrtc/p2p/base/common.h"
 #include "webrtc/p2p/base/packetsocketfactory.h"
 #include "webrtc/p2p/base/stun.h"
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/bind.h"
 #include "webrtc/base/bytebuffer.h"
 #include "webrtc/base/helpers.h"
 #include "webrtc/base/logging.h"
@@ -495,8 +498,13 @@ void TurnServer::SendStun(TurnServerConnection* conn, StunMessage* msg) {
 
 void TurnServer::Send(TurnServerConnection* conn,
                       const rtc::ByteBuffer& buf) {
+  Send(conn, buf.Data(), buf.Length());
+}
+
+void TurnServer::Send(TurnServerConnection* conn,
+                      const char* data, size_t size) {
   rtc::PacketOptions options;
-  conn->socket()->SendTo(buf.Data(), buf.Length(), conn->src(), options);
+  conn->socket()->SendTo(data, size, conn->src(), options);
 }
 
 void TurnServer::OnAllocationDestroyed(TurnServerAllocation* allocation) {
@@ -540,7 +548,11 @@ bool TurnServerConnection::operator==(const TurnServerConnection& c) const {
 }
 
 bool TurnServerConnection::operator<(const TurnServerConnection& c) const {
-  return src_ < c.src_ || dst_ < c.dst_ || proto_ < c.proto_;
+  if (src_ != c.src_)
+    return src_ < c.src_;
+  if (dst_ != c.dst_)
+    return dst_ < c.dst_;
+  return proto_ < c.proto_;
 }
 
 std::string TurnServerConnection::ToString() const {
@@ -567,13 +579,13 @@ TurnServerAllocation::TurnServerAllocation(TurnServer* server,
 }
 
 TurnServerAllocation::~TurnServerAllocation() {
-  for (ChannelList::iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    delete *it;
+  for (ChannelIdMap::iterator it = channels_by_id_.begin();
+       it != channels_by_id_.end(); ++it) {
+    delete it->second;
   }
-  for (PermissionList::iterator it = perms_.begin();
+  for (PermissionMap::iterator it = perms_.begin();
        it != perms_.end(); ++it) {
-    delete *it;
+    delete it->second;
   }
   thread_->Clear(this, MSG_ALLOCATION_TIMEOUT);
   LOG_J(LS_INFO, this) << "Allocation destroyed";
@@ -742,7 +754,8 @@ void TurnServerAllocation::HandleChannelBindRequest(const TurnMessage* msg) {
     channel1 = new Channel(thread_, channel_id, peer_attr->GetAddress());
     channel1->SignalDestroyed.connect(this,
         &TurnServerAllocation::OnChannelDestroyed);
-    channels_.push_back(channel1);
+    channels_by_id_[channel_id] = channel1;
+    channels_by_peer_[channel1->peer()] = channel1;
   } else {
     channel1->Refresh();
   }
@@ -760,13 +773,19 @@ void TurnServerAllocation::HandleChannelBindRequest(const TurnMessage* msg) {
 }
 
 void TurnServerAllocation::HandleChannelData(const char* data, size_t size) {
-  // Extract the channel number from the data.
+  // Extract the channel number and the length of the application data, which
+  // may be followed by padding (RFC 5766, section 11.5).
   uint16 channel_id = rtc::GetBE16(data);
+  size_t length = rtc::GetBE16(data + 2);
+  if (size < TURN_CHANNEL_HEADER_SIZE + length) {
+    LOG_J(LS_WARNING, this) << "Received truncated channel data, id="
+                            << channel_id;
+    return;
+  }
   Channel* channel = FindChannel(channel_id);
   if (channel) {
     // Send the data to the peer address.
-    SendExternal(data + TURN_CHANNEL_HEADER_SIZE,
-                 size - TURN_CHANNEL_HEADER_SIZE, channel->peer());
+    SendExternal(data + TURN_CHANNEL_HEADER_SIZE, length, channel->peer());
   } else {
     LOG_J(LS_WARNING, this) << "Received channel data for invalid channel, id="
                             << channel_id;
@@ -782,11 +801,12 @@ void TurnServerAllocation::OnExternalPacket(
   Channel* channel = FindChannel(addr);
   if (channel) {
     // There is a channel bound to this address. Send as a channel message.
-    rtc::ByteBuffer buf;
-    buf.WriteUInt16(channel->id());
-    buf.WriteUInt16(static_cast<uint16>(size));
-    buf.WriteBytes(data, size);
-    server_->Send(&conn_, buf);
+    channel_data_.SetSize(TURN_CHANNEL_HEADER_SIZE + size);
+    char* buf = channel_data_.data<char>();
+    rtc::SetBE16(buf, static_cast<uint16>(channel->id()));
+    rtc::SetBE16(buf + 2, static_cast<uint16>(size));
+    memcpy(buf + TURN_CHANNEL_HEADER_SIZE, data, size);
+    server_->Send(&conn_, buf, channel_data_.size());
   } else if (HasPermission(addr.ipaddr())) {
     // No channel, but a permission exists. Send as a data indication.
     TurnMessage msg;
@@ -824,7 +844,7 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
     perm = new Permission(thread_, addr);
     perm->SignalDestroyed.connect(
         this, &TurnServerAllocation::OnPermissionDestroyed);
-    perms_.push_back(perm);
+    perms_[addr] = perm;
   } else {
     perm->Refresh();
   }
@@ -832,32 +852,20 @@ void TurnServerAllocation::AddPermission(const rtc::IPAddress& addr) {
 
 TurnServerAllocation::Permission* TurnServerAllocation::FindPermission(
     const rtc::IPAddress& addr) const {
-  for (PermissionList::const_iterator it = perms_.begin();
-       it != perms_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  PermissionMap::const_iterator it = perms_.find(addr);
+  return (it != perms_.end()) ? it->second : NULL;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     int channel_id) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->id() == channel_id)
-      return *it;
-  }
-  return NULL;
+  ChannelIdMap::const_iterator it = channels_by_id_.find(channel_id);
+  return (it != channels_by_id_.end()) ? it->second : NULL;
 }
 
 TurnServerAllocation::Channel* TurnServerAllocation::FindChannel(
     const rtc::SocketAddress& addr) const {
-  for (ChannelList::const_iterator it = channels_.begin();
-       it != channels_.end(); ++it) {
-    if ((*it)->peer() == addr)
-      return *it;
-  }
-  return NULL;
+  ChannelPeerMap::const_iterator it = channels_by_peer_.find(addr);
+  return (it != channels_by_peer_.end()) ? it->second : NULL;
 }
 
 void TurnServerAllocation::SendResponse(TurnMessage* msg) {
@@ -888,16 +896,18 @@ void TurnServerAllocation::OnMessage(rtc::Message* msg) {
 }
 
 void TurnServerAllocation::OnPermissionDestroyed(Permission* perm) {
-  PermissionList::iterator it = std::find(perms_.begin(), perms_.end(), perm);
-  ASSERT(it != perms_.end());
+  PermissionMap::iterator it = perms_.find(perm->peer());
+  ASSERT(it != perms_.end() && it->second == perm);
   perms_.erase(it);
 }
 
 void TurnServerAllocation::OnChannelDestroyed(Channel* channel) {
-  ChannelList::iterator it =
-      std::find(channels_.begin(), channels_.end(), channel);
-  ASSERT(it != channels_.end());
-  channels_.erase(it);
+  ChannelIdMap::iterator id_it = channels_by_id_.find(channel->id());
+  ASSERT(id_it != channels_by_id_.end() && id_it->second == channel);
+  channels_by_id_.erase(id_it);
+  ChannelPeerMap::iterator peer_it = channels_by_peer_.find(channel->peer());
+  ASSERT(peer_it != channels_by_peer_.end() && peer_it->second == channel);
+  channels_by_peer_.erase(peer_it);
 }
 
 TurnServerAllocation::Permission::Permission(rtc::Thread* thread,
@@ -942,4 +952,144 @@ void TurnServerAllocation::Channel::OnMessage(rtc::Message* msg) {
   delete this;
 }
 
+// A TurnServer and the thread it runs on. Apart from construction and
+// destruction, the methods must be invoked on that thread.
+class ShardedTurnServer::Shard {
+ public:
+  Shard() : thread_(new rtc::Thread()) {
+    thread_->Start();
+    server_.reset(new TurnServer(thread_.get()));
+  }
+  ~Shard() {
+    // The allocations and their sockets must be destroyed on the thread that
+    // reads them.
+    thread_->Invoke<void>(rtc::Bind(&Shard::DestroyServer, this));
+    thread_->Stop();
+  }
+
+  rtc::Thread* thread() { return thread_.get(); }
+
+  void SetRealm(const std::string& realm) { server_->set_realm(realm); }
+  void SetSoftware(const std::string& software) {
+    server_->set_software(software);
+  }
+  void SetAuthHook(TurnAuthInterface* auth_hook) {
+    server_->set_auth_hook(auth_hook);
+  }
+
+  // Returns the address the socket is bound to, or a nil address if it
+  // couldn't be created.
+  rtc::SocketAddress AddInternalUdpSocket(const rtc::SocketAddress& address,
+                                          bool reuse_port) {
+    rtc::AsyncSocket* socket = thread_->socketserver()->CreateAsyncSocket(
+        address.family(), SOCK_DGRAM);
+    if (!socket)
+      return rtc::SocketAddress();
+    if (reuse_port && socket->SetOption(rtc::Socket::OPT_REUSEPORT, 1) != 0) {
+      delete socket;
+      return rtc::SocketAddress();
+    }
+    rtc::AsyncUDPSocket* udp_socket =
+        rtc::AsyncUDPSocket::Create(socket, address);
+    if (!udp_socket)
+      return rtc::SocketAddress();
+    server_->AddInternalSocket(udp_socket, PROTO_UDP);
+    return udp_socket->GetLocalAddress();
+  }
+
+  void SetExternalAddress(const rtc::SocketAddress& address) {
+    server_->SetExternalSocketFactory(
+        new rtc::BasicPacketSocketFactory(thread_.get()), address);
+  }
+
+  size_t GetNumAllocations() const { return server_->allocations().size(); }
+
+ private:
+  void DestroyServer() { server_.reset(); }
+
+  rtc::scoped_ptr<rtc::Thread> thread_;
+  rtc::scoped_ptr<TurnServer> server_;
+};
+
+ShardedTurnServer::ShardedTurnServer(int num_shards) {
+  ASSERT(num_shards > 0);
+  for (int i = 0; i < num_shards; ++i)
+    shards_.push_back(new Shard());
+}
+
+ShardedTurnServer::~ShardedTurnServer() {
+  for (size_t i = 0; i < shards_.size(); ++i)
+    delete shards_[i];
+}
+
+void ShardedTurnServer::set_realm(const std::string& realm) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->thread()->Invoke<void>(
+        rtc::Bind(&Shard::SetRealm, shards_[i], realm));
+  }
+}
+
+void ShardedTurnServer::set_software(const std::string& software) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->thread()->Invoke<void>(
+        rtc::Bind(&Shard::SetSoftware, shards_[i], software));
+  }
+}
+
+void ShardedTurnServer::set_auth_hook(TurnAuthInterface* auth_hook) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->thread()->Invoke<void>(
+        rtc::Bind(&Shard::SetAuthHook, shards_[i], auth_hook));
+  }
+}
+
+bool ShardedTurnServer::AddInternalUdpSocket(
+    const rtc::SocketAddress& address,
+    rtc::SocketAddress* bound_address) {
+  Shard* first = shards_[0];
+  bool reuse_port = shards_.size() > 1;
+  rtc::SocketAddress local_address = first->thread()->Invoke<
+      rtc::SocketAddress>(rtc::Bind(&Shard::AddInternalUdpSocket, first,
+                                    address, reuse_port));
+  if (local_address.IsNil() && reuse_port) {
+    LOG(LS_WARNING) << "Failed to share " << address.ToSensitiveString()
+                    << " between " << shards_.size()
+                    << " threads, relaying on one thread only.";
+    reuse_port = false;
+    local_address = first->thread()->Invoke<rtc::SocketAddress>(
+        rtc::Bind(&Shard::AddInternalUdpSocket, first, address, reuse_port));
+  }
+  if (local_address.IsNil())
+    return false;
+
+  // The other shards bind to the port the first one got, in case |address|
+  // had none.
+  for (size_t i = 1; reuse_port && i < shards_.size(); ++i) {
+    rtc::SocketAddress shard_address =
+        shards_[i]->thread()->Invoke<rtc::SocketAddress>(
+            rtc::Bind(&Shard::AddInternalUdpSocket, shards_[i],
+                      local_address, reuse_port));
+    if (shard_address.IsNil()) {
+      LOG(LS_WARNING) << "Shard " << i << " failed to bind to "
+                      << local_address.ToSensitiveString();
+    }
+  }
+  if (bound_address)
+    *bound_address = local_address;
+  return true;
+}
+
+void ShardedTurnServer::SetExternalAddress(const rtc::SocketAddress& address) {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->thread()->Invoke<void>(
+        rtc::Bind(&Shard::SetExternalAddress, shards_[i], address));
+  }
+}
+
+size_t ShardedTurnServer::GetNumAllocations(int shard) {
+  ASSERT(shard >= 0 && shard < num_shards());
+  return shards_[shard]->thread()->Invoke<size_t>(
+      rtc::Bind(&Shard::GetNumAllocations, shards_[shard]));
+}
+
 }  // namespace cricket
@@ -11,13 +11,14 @@
 #ifndef WEBRTC_P2P_BASE_TURNSERVER_H_
 #define WEBRTC_P2P_BASE_TURNSERVER_H_
 
-#include <list>
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "webrtc/p2p/base/portinterface.h"
 #include "webrtc/base/asyncpacketsocket.h"
+#include "webrtc/base/buffer.h"
 #include "webrtc/base/messagequeue.h"
 #include "webrtc/base/sigslot.h"
 #include "webrtc/base/socketaddress.h"
@@ -90,8 +91,9 @@ class TurnServerAllocation : public rtc::MessageHandler,
  private:
   class Channel;
   class Permission;
-  typedef std::list<Permission*> PermissionList;
-  typedef std::list<Channel*> ChannelList;
+  typedef std::map<rtc::IPAddress, Permission*> PermissionMap;
+  typedef std::map<int, Channel*> ChannelIdMap;
+  typedef std::map<rtc::SocketAddress, Channel*> ChannelPeerMap;
 
   void HandleAllocateRequest(const TurnMessage* msg);
   void HandleRefreshRequest(const TurnMessage* msg);
@@ -131,8 +133,14 @@ class TurnServerAllocation : public rtc::MessageHandler,
   std::string username_;
   std::string origin_;
   std::string last_nonce_;
-  PermissionList perms_;
-  ChannelList channels_;
+  PermissionMap perms_;
+  // Every channel is in both maps; channel data is looked up by channel id
+  // when it comes from the client, and by peer address when it comes from
+  // the peer.
+  ChannelIdMap channels_by_id_;
+  ChannelPeerMap channels_by_peer_;
+  // Reused to frame the channel data sent to the client.
+  rtc::Buffer channel_data_;
 };
 
 // An interface through which the MD5 credential hash can be retrieved.
@@ -237,6 +245,7 @@ class TurnServer : public sigslot::has_slots<> {
 
   void SendStun(TurnServerConnection* conn, StunMessage* msg);
   void Send(TurnServerConnection* conn, const rtc::ByteBuffer& buf);
+  void Send(TurnServerConnection* conn, const char* data, size_t size);
 
   void OnAllocationDestroyed(TurnServerAllocation* allocation);
   void DestroyInternalSocket(rtc::AsyncPacketSocket* socket);
@@ -267,6 +276,45 @@ class TurnServer : public sigslot::has_slots<> {
   friend class TurnServerAllocation;
 };
 
+// Runs a TurnServer on each of |num_shards| worker threads, each with its own
+// socket server, so that a relay can use more than one core. The internal UDP
+// sockets of all the shards are bound to the same address with
+// Socket::OPT_REUSEPORT, which makes the kernel hash the packets of each
+// client to one of them; an allocation and its permissions and channels are
+// therefore only ever touched by the shard that owns it. Where the option
+// isn't supported, only the first shard listens and the relay runs on a
+// single thread.
+// Only UDP clients are supported.
+class ShardedTurnServer {
+ public:
+  explicit ShardedTurnServer(int num_shards);
+  ~ShardedTurnServer();
+
+  int num_shards() const { return static_cast<int>(shards_.size()); }
+
+  void set_realm(const std::string& realm);
+  void set_software(const std::string& software);
+  // Sets the authentication callback; does not take ownership. It is called
+  // on all the worker threads, so it must be thread safe.
+  void set_auth_hook(TurnAuthInterface* auth_hook);
+
+  // Starts listening for packets from internal clients on |address|, on every
+  // shard. If |address| has no port, one is picked for all the shards and
+  // returned in |bound_address|, which may be NULL.
+  bool AddInternalUdpSocket(const rtc::SocketAddress& address,
+                            rtc::SocketAddress* bound_address);
+  // Makes every shard create its external sockets on |address|.
+  void SetExternalAddress(const rtc::SocketAddress& address);
+
+  // Returns the number of allocations owned by |shard|.
+  size_t GetNumAllocations(int shard);
+
+ private:
+  class Shard;
+
+  std::vector<Shard*> shards_;
+};
+
 }  // namespace cricket
 
 #endif  // WEBRTC_P2P_BASE_TURNSERVER_H_
@@ -0,0 +1,194 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "webrtc/p2p/base/testturnclient.h"
+#include "webrtc/p2p/base/turnserver.h"
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/event.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/scopedptrcollection.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/systeminfo.h"
+#include "webrtc/base/thread.h"
+#include "webrtc/base/timeutils.h"
+#include "webrtc/test/testsupport/perf_test.h"
+
+namespace cricket {
+namespace {
+
+const char kRealm[] = "example.org";
+const int kChannelId = 0x4000;
+const int kTimeoutMs = 5000;
+const int kNumClients = 64;
+// Packets each client keeps in flight.
+const int kWindow = 4;
+const size_t kPacketSize = 200;
+const int kDurationMs = 2000;
+
+// The password of every user is its username.
+class TestAuth : public TurnAuthInterface {
+ public:
+  // Called on the threads of the server.
+  virtual bool GetKey(const std::string& username, const std::string& realm,
+                      std::string* key) {
+    return ComputeStunCredentialHash(username, realm, username, key);
+  }
+};
+
+// Generates load on a ShardedTurnServer from a thread of its own: each of
+// its clients keeps |kWindow| packets going back and forth through the relay
+// between itself and a peer that echoes them. One generator can't keep more
+// than one shard busy, so there is one per shard.
+class RelayLoadGenerator : public rtc::Runnable,
+                           public sigslot::has_slots<> {
+ public:
+  RelayLoadGenerator(const rtc::SocketAddress& server_address,
+                     int first_client,
+                     int num_clients,
+                     rtc::Event* start)
+      : server_address_(server_address),
+        first_client_(first_client),
+        num_clients_(num_clients),
+        start_(start),
+        ready_(false, false),
+        done_(false, false),
+        payload_(kPacketSize, 'x'),
+        num_echoes_(0),
+        elapsed_ms_(0),
+        pss_(new rtc::PhysicalSocketServer),
+        thread_(pss_.get()) {}
+
+  ~RelayLoadGenerator() { thread_.Stop(); }
+
+  // Allocates on the relay, and waits for |start| before generating load.
+  void Start() { EXPECT_TRUE(thread_.Start(this)); }
+  // Blocks until all clients have a channel bound.
+  void WaitUntilReady() { EXPECT_TRUE(ready_.Wait(kTimeoutMs)); }
+  // Blocks until the load has been generated, and returns the number of
+  // packets relayed per second.
+  double Stop() {
+    EXPECT_TRUE(done_.Wait(kDurationMs + kTimeoutMs));
+    thread_.Stop();
+    // Every echo went through the relay twice.
+    return 2000.0 * num_echoes_ / std::max(elapsed_ms_, 1);
+  }
+
+  void Run(rtc::Thread* thread) override {
+    rtc::scoped_ptr<rtc::AsyncUDPSocket> peer(rtc::AsyncUDPSocket::Create(
+        pss_.get(), rtc::SocketAddress("127.0.0.1", 0)));
+    peer->SignalReadPacket.connect(this, &RelayLoadGenerator::OnPeerPacket);
+    rtc::ScopedPtrCollection<TestTurnClient> clients;
+    for (int i = first_client_; i < first_client_ + num_clients_; ++i) {
+      TestTurnClient* client = new TestTurnClient(
+          pss_.get(), server_address_, "user" + rtc::ToString(i));
+      clients.PushBack(client);
+      client->SignalChannelData.connect(
+          this, &RelayLoadGenerator::OnClientPacket);
+      client->Allocate();
+      EXPECT_TRUE_WAIT(client->allocated(), kTimeoutMs);
+      client->BindChannel(kChannelId, peer->GetLocalAddress());
+      EXPECT_TRUE_WAIT(client->channel_bound(), kTimeoutMs);
+    }
+    ready_.Set();
+    start_->Wait(rtc::Event::kForever);
+
+    const uint32 start_ms = rtc::Time();
+    for (TestTurnClient* client : clients.collection()) {
+      for (int j = 0; j < kWindow; ++j)
+        client->SendChannelData(payload_.data(), payload_.size());
+    }
+    thread->ProcessMessages(kDurationMs);
+    elapsed_ms_ = rtc::TimeSince(start_ms);
+    EXPECT_GT(num_echoes_, 0);
+    done_.Set();
+  }
+
+ private:
+  void OnPeerPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data, size_t size,
+                    const rtc::SocketAddress& addr,
+                    const rtc::PacketTime& packet_time) {
+    rtc::PacketOptions options;
+    socket->SendTo(data, size, addr, options);
+  }
+
+  void OnClientPacket(TestTurnClient* client, const char* data, size_t size) {
+    ++num_echoes_;
+    client->SendChannelData(data, size);
+  }
+
+  const rtc::SocketAddress server_address_;
+  const int first_client_;
+  const int num_clients_;
+  rtc::Event* const start_;
+  rtc::Event ready_;
+  rtc::Event done_;
+  const std::string payload_;
+  int num_echoes_;
+  int elapsed_ms_;
+  rtc::scoped_ptr<rtc::PhysicalSocketServer> pss_;
+  rtc::Thread thread_;
+};
+
+// Returns the number of packets relayed per second with one server and one
+// load generating thread per shard.
+double RunRelay(int num_shards) {
+  TestAuth auth;
+  ShardedTurnServer server(num_shards);
+  server.set_realm(kRealm);
+  server.set_auth_hook(&auth);
+  server.SetExternalAddress(rtc::SocketAddress("127.0.0.1", 0));
+  rtc::SocketAddress server_address;
+  EXPECT_TRUE(server.AddInternalUdpSocket(
+      rtc::SocketAddress("127.0.0.1", 0), &server_address));
+
+  rtc::Event start(true, false);
+  rtc::ScopedPtrCollection<RelayLoadGenerator> generators;
+  const int clients_per_generator = kNumClients / num_shards;
+  for (int i = 0; i < num_shards; ++i) {
+    generators.PushBack(new RelayLoadGenerator(
+        server_address, i * clients_per_generator, clients_per_generator,
+        &start));
+    generators.collection().back()->Start();
+  }
+  for (RelayLoadGenerator* generator : generators.collection())
+    generator->WaitUntilReady();
+  start.Set();
+  double packets_per_second = 0;
+  for (RelayLoadGenerator* generator : generators.collection())
+    packets_per_second += generator->Stop();
+
+  webrtc::test::PrintResult("turn_relay_rate", "",
+                            rtc::ToString(num_shards) + "_threads",
+                            packets_per_second, "packets/s", true);
+  return packets_per_second;
+}
+
+}  // namespace
+
+// Both the relay and the load generator use a thread per shard, so the
+// speedup is bounded by the number of cores, half of which go to the load.
+TEST(TurnServerPerfTest, ChannelDataRelay) {
+  const double one_thread_rate = RunRelay(1);
+  const double four_thread_rate = RunRelay(4);
+  webrtc::test::PrintResult("turn_relay_speedup", "",
+                            rtc::ToString(rtc::SystemInfo().GetMaxCpus()) +
+                                "_cores",
+                            100 * four_thread_rate / one_thread_rate, "%",
+                            false);
+}
+
+}  // namespace cricket
@@ -0,0 +1,201 @@
+/*
+ *  Copyright (c) 2015 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <string>
+#include <vector>
+
+#include "webrtc/p2p/base/testturnclient.h"
+#include "webrtc/p2p/base/turnserver.h"
+#include "webrtc/base/asyncudpsocket.h"
+#include "webrtc/base/gunit.h"
+#include "webrtc/base/physicalsocketserver.h"
+#include "webrtc/base/scoped_ptr.h"
+#include "webrtc/base/stringencode.h"
+#include "webrtc/base/thread.h"
+
+namespace cricket {
+
+static const char kRealm[] = "example.org";
+static const int kChannelId = 0x4000;
+static const int kTimeout = 5000;
+
+// Receives the packets relayed to a peer.
+class TestPeer : public sigslot::has_slots<> {
+ public:
+  explicit TestPeer(rtc::SocketFactory* factory)
+      : socket_(rtc::AsyncUDPSocket::Create(
+            factory, rtc::SocketAddress("127.0.0.1", 0))) {
+    socket_->SignalReadPacket.connect(this, &TestPeer::OnReadPacket);
+  }
+
+  rtc::SocketAddress address() const { return socket_->GetLocalAddress(); }
+  const std::vector<std::string>& packets() const { return packets_; }
+
+  void SendTo(const std::string& data, const rtc::SocketAddress& addr) {
+    rtc::PacketOptions options;
+    socket_->SendTo(data.data(), data.size(), addr, options);
+  }
+
+ private:
+  void OnReadPacket(rtc::AsyncPacketSocket* socket,
+                    const char* data, size_t size,
+                    const rtc::SocketAddress& addr,
+                    const rtc::PacketTime& packet_time) {
+    packets_.push_back(std::string(data, size));
+  }
+
+  rtc::scoped_ptr<rtc::AsyncUDPSocket> socket_;
+  std::vector<std::string> packets_;
+};
+
+class TurnServerTest : public testing::Test,
+                       public TurnAuthInterface,
+                       public sigslot::has_slots<> {
+ public:
+  TurnServerTest()
+      : pss_(new rtc::PhysicalSocketServer),
+        ss_scope_(pss_.get()) {}
+
+  // Called on the threads of the server; the password is the username.
+  virtual bool GetKey(const std::string& username, const std::string& realm,
+                      std::string* key) {
+    return ComputeStunCredentialHash(username, realm, username, key);
+  }
+
+ protected:
+  void CreateServer(int num_shards) {
+    server_.reset(new ShardedTurnServer(num_shards));
+    server_->set_realm(kRealm);
+    server_->set_auth_hook(this);
+    server_->SetExternalAddress(rtc::SocketAddress("127.0.0.1", 0));
+    ASSERT_TRUE(server_->AddInternalUdpSocket(
+        rtc::SocketAddress("127.0.0.1", 0), &server_address_));
+  }
+
+  // Creates a client with an allocation and a channel bound to |peer|.
+  TestTurnClient* CreateClient(const std::string& username, TestPeer* peer) {
+    TestTurnClient* client =
+        new TestTurnClient(pss_.get(), server_address_, username);
+    client->SignalChannelData.connect(this, &TurnServerTest::OnChannelData);
+    client->Allocate();
+    EXPECT_TRUE_WAIT(client->allocated(), kTimeout);
+    client->BindChannel(kChannelId, peer->address());
+    EXPECT_TRUE_WAIT(client->channel_bound(), kTimeout);
+    return client;
+  }
+
+  void OnChannelData(TestTurnClient* client, const char* data, size_t size) {
+    received_.push_back(std::string(data, size));
+  }
+
+  size_t GetNumAllocations() {
+    size_t num_allocations = 0;
+    for (int i = 0; i < server_->num_shards(); ++i)
+      num_allocations += server_->GetNumAllocations(i);
+    return num_allocations;
+  }
+
+  rtc::scoped_ptr<rtc::PhysicalSocketServer> pss_;
+  rtc::SocketServerScope ss_scope_;
+  rtc::scoped_ptr<ShardedTurnServer> server_;
+  rtc::SocketAddress server_address_;
+  std::vector<std::string> received_;
+};
+
+TEST_F(TurnServerTest, RelaysChannelData) {
+  CreateServer(1);
+  TestPeer peer(pss_.get());
+  rtc::scoped_ptr<TestTurnClient> client(CreateClient("alice", &peer));
+
+  client->SendChannelData("hello", 5);
+  ASSERT_TRUE_WAIT(peer.packets().size() == 1, kTimeout);
+  EXPECT_EQ("hello", peer.packets()[0]);
+
+  peer.SendTo("world", client->relayed_address());
+  ASSERT_TRUE_WAIT(received_.size() == 1, kTimeout);
+  EXPECT_EQ("world", received_[0]);
+}
+
+// Channel data may be padded up to a multiple of four bytes, and the padding
+// must not be relayed.
+TEST_F(TurnServerTest, StripsChannelDataPadding) {
+  CreateServer(1);
+  TestPeer peer(pss_.get());
+  rtc::scoped_ptr<TestTurnClient> client(CreateClient("alice", &peer));
+
+  const char kPadded[] = {0x40, 0x00, 0x00, 0x05, 'h', 'e', 'l', 'l', 'o',
+                          0, 0, 0};
+  client->Send(kPadded, sizeof(kPadded));
+  ASSERT_TRUE_WAIT(peer.packets().size() == 1, kTimeout);
+  EXPECT_EQ("hello", peer.packets()[0]);
+}
+
+TEST_F(TurnServerTest, DropsTruncatedChannelData) {
+  CreateServer(1);
+  TestPeer peer(pss_.get());
+  rtc::scoped_ptr<TestTurnClient> client(CreateClient("alice", &peer));
+
+  const char kTruncated[] = {0x40, 0x00, 0x00, 0x10, 'b', 'a', 'd'};
+  client->Send(kTruncated, sizeof(kTruncated));
+  // Packets are relayed in order, so the truncated one must be gone once the
+  // next one has arrived.
+  client->SendChannelData("hello", 5);
+  ASSERT_TRUE_WAIT(peer.packets().size() == 1, kTimeout);
+  EXPECT_EQ("hello", peer.packets()[0]);
+}
+
+TEST_F(TurnServerTest, RelaysOnEveryChannel) {
+  CreateServer(1);
+  TestPeer peer1(pss_.get());
+  TestPeer peer2(pss_.get());
+  rtc::scoped_ptr<TestTurnClient> client(CreateClient("alice", &peer1));
+  client->BindChannel(kChannelId + 1, peer2.address());
+  ASSERT_TRUE_WAIT(client->channel_bound(), kTimeout);
+
+  client->SendChannelData("two", 3);
+  ASSERT_TRUE_WAIT(peer2.packets().size() == 1, kTimeout);
+  EXPECT_EQ("two", peer2.packets()[0]);
+  EXPECT_TRUE(peer1.packets().empty());
+
+  peer1.SendTo("one", client->relayed_address());
+  peer2.SendTo("two", client->relayed_address());
+  ASSERT_TRUE_WAIT(received_.size() == 2, kTimeout);
+  EXPECT_EQ("one", received_[0]);
+  EXPECT_EQ("two", received_[1]);
+}
+
+TEST_F(TurnServerTest, ShardsShareTheServerAddress) {
+  const int kNumShards = 2;
+  const size_t kNumClients = 32;
+  CreateServer(kNumShards);
+  TestPeer peer(pss_.get());
+  std::vector<TestTurnClient*> clients;
+  for (size_t i = 0; i < kNumClients; ++i)
+    clients.push_back(CreateClient("user" + rtc::ToString(i), &peer));
+  EXPECT_EQ(kNumClients, GetNumAllocations());
+
+  for (size_t i = 0; i < kNumClients; ++i)
+    clients[i]->SendChannelData("hello", 5);
+  EXPECT_TRUE_WAIT(peer.packets().size() == kNumClients, kTimeout);
+  for (size_t i = 0; i < kNumClients; ++i)
+    peer.SendTo("world", clients[i]->relayed_address());
+  EXPECT_TRUE_WAIT(received_.size() == kNumClients, kTimeout);
+
+#if defined(WEBRTC_LINUX)
+  // The kernel spreads the clients between the shards.
+  for (int i = 0; i < kNumShards; ++i)
+    EXPECT_LT(0u, server_->GetNumAllocations(i));
+#endif
+
+  for (size_t i = 0; i < kNumClients; ++i)
+    delete clients[i];
+}
+
+}  // namespace cricket
@@ -56,7 +56,8 @@ class YuvFileGenerator : public FrameGenerator {
   YuvFileGenerator(std::vector<FILE*> files,
                    size_t width,
                    size_t height,
-                   int frame_repeat_count)
+                   int frame_repeat_count,
+                   bool tag_updated_rects)
       : file_index_(0),
         files_(files),
         width_(width),
@@ -66,7 +67,9 @@ class YuvFileGenerator : public FrameGenerator {
                                    static_cast<int>(height_))),
         frame_buffer_(new uint8_t[frame_size_]),
         frame_display_count_(frame_repeat_count),
-        current_display_count_(0) {
+        current_display_count_(0),
+        tag_updated_rects_(tag_updated_rects),
+        sequence_number_(0) {
     assert(width > 0);
     assert(height > 0);
     assert(frame_repeat_count > 0);
@@ -78,18 +81,33 @@ class YuvFileGenerator : public FrameGenerator {
   }
 
   VideoFrame* NextFrame() override {
-    if (current_display_count_ == 0)
+    bool read_new_frame = false;
+    if (current_display_count_ == 0) {
       ReadNextFrame();
+      read_new_frame = true;
+    }
     if (++current_display_count_ >= frame_display_count_)
       current_display_count_ = 0;
 
     // If this is the last repeatition of this frame, it's OK to use the
     // original instance, otherwise use a copy.
-    if (current_display_count_ == frame_display_count_)
-      return &last_read_frame_;
-
-    temp_frame_copy_.CopyFrame(last_read_frame_);
-    return &temp_frame_copy_;
+    VideoFrame* frame = &last_read_frame_;
+    if (current_display_count_ != frame_display_count_) {
+      temp_frame_copy_.CopyFrame(last_read_frame_);
+      frame = &temp_frame_copy_;
+    }
+    if (tag_updated_rects_) {
+      // Repeated frames are reported as unchanged, the way a screen capturer
+      // reports its updated region.
+      std::vector<VideoFrame::UpdatedRect> updated_rects;
+      if (read_new_frame) {
+        VideoFrame::UpdatedRect rect = {0, 0, static_cast<int>(width_),
+                                        static_cast<int>(height_)};
+        updated_rects.push_back(rect);
+      }
+      frame->set_updated_rects(sequence_number_++, updated_rects);
+    }
+    return frame;
   }
 
   void ReadNextFrame() {
@@ -123,6 +141,8 @@ class YuvFileGenerator : public FrameGenerator {
   const rtc::scoped_ptr<uint8_t[]> frame_buffer_;
   const int frame_display_count_;
   int current_display_count_;
+  const bool tag_updated_rects_;
+  uint32_t sequence_number_;
   VideoFrame last_read_frame_;
   VideoFrame temp_frame_copy_;
 };
@@ -133,11 +153,14 @@ FrameGenerator* FrameGenerator::CreateChromaGenerator(size_t width,
   return new ChromaGenerator(width, height);
 }
 
-FrameGenerator* FrameGenerator::CreateFromYuvFile(
-    std::vector<std::string> filenames,
+namespace {
+
+FrameGenerator* CreateYuvFileGenerator(
+    const std::vector<std::string>& filenames,
     size_t width,
     size_t height,
-    int frame_repeat_count) {
+    int frame_repeat_count,
+    bool tag_updated_rects) {
   assert(!filenames.empty());
   std::vector<FILE*> files;
   for (const std::string& filename : filenames) {
@@ -146,7 +169,28 @@ FrameGenerator* FrameGenerator::CreateFromYuvFile(
     files.push_back(file);
   }
 
-  return new YuvFileGenerator(files, width, height, frame_repeat_count);
+  return new YuvFileGenerator(files, width, height, frame_repeat_count,
+                              tag_updated_rects);
+}
+
+}  // namespace
+
+FrameGenerator* FrameGenerator::CreateFromYuvFile(
+    std::vector<std::string> filenames,
+    size_t width,
+    size_t height,
+    int frame_repeat_count) {
+  return CreateYuvFileGenerator(filenames, width, height, frame_repeat_count,
+                                false);
+}
+
+FrameGenerator* FrameGenerator::CreateFromYuvFileWithUpdatedRects(
+    std::vector<std::string> filenames,
+    size_t width,
+    size_t height,
+    int frame_repeat_count) {
+  return CreateYuvFileGenerator(filenames, width, height, frame_repeat_count,
+                                true);
 }
 
 }  // namespace test
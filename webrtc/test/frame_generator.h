@@ -38,6 +38,15 @@ class FrameGenerator {
                                            size_t width,
                                            size_t height,
                                            int frame_repeat_count);
+
+  // Like CreateFromYuvFile(), but also tags the frames with
+  // VideoFrame::set_updated_rects(): a newly read frame as fully changed and
+  // a repeated frame as unchanged.
+  static FrameGenerator* CreateFromYuvFileWithUpdatedRects(
+      std::vector<std::string> files,
+      size_t width,
+      size_t height,
+      int frame_repeat_count);
 };
 }  // namespace test
 }  // namespace webrtc
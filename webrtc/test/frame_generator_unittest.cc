@@ -145,5 +145,35 @@ TEST_F(FrameGeneratorTest, MultipleFrameFilesWithRepeat) {
   CheckFrameAndMutate(generator->NextFrame(), 0, 0, 0);
 }
 
+TEST_F(FrameGeneratorTest, DoesNotTagUpdatedRectsByDefault) {
+  rtc::scoped_ptr<FrameGenerator> generator(FrameGenerator::CreateFromYuvFile(
+      std::vector<std::string>(1, two_frame_filename_), kFrameWidth,
+      kFrameHeight, 2));
+  for (int i = 0; i < 4; ++i)
+    EXPECT_FALSE(generator->NextFrame()->has_updated_rects());
+}
+
+TEST_F(FrameGeneratorTest, TagsRepeatedFramesAsUnchanged) {
+  const int kRepeatCount = 3;
+  rtc::scoped_ptr<FrameGenerator> generator(
+      FrameGenerator::CreateFromYuvFileWithUpdatedRects(
+          std::vector<std::string>(1, two_frame_filename_), kFrameWidth,
+          kFrameHeight, kRepeatCount));
+  for (uint32_t i = 0; i < 2 * kRepeatCount; ++i) {
+    VideoFrame* frame = generator->NextFrame();
+    ASSERT_TRUE(frame->has_updated_rects());
+    EXPECT_EQ(i, frame->updated_rects_sequence_number());
+    if (i % kRepeatCount == 0) {
+      ASSERT_EQ(1u, frame->updated_rects().size());
+      EXPECT_EQ(0, frame->updated_rects()[0].x);
+      EXPECT_EQ(0, frame->updated_rects()[0].y);
+      EXPECT_EQ(kFrameWidth, frame->updated_rects()[0].width);
+      EXPECT_EQ(kFrameHeight, frame->updated_rects()[0].height);
+    } else {
+      EXPECT_TRUE(frame->updated_rects().empty());
+    }
+  }
+}
+
 }  // namespace test
 }  // namespace webrtc
@@ -42,6 +42,20 @@ static const uint32_t kReceiverLocalSsrc = 0x123456;
 static const uint8_t kRtxVideoPayloadType = 96;
 static const uint8_t kVideoPayloadType = 124;
 
+// Prints what the sender spent on encoding, to compare encoder settings.
+static void PrintSendStats(const VideoSendStream::Stats& stats,
+                           int64_t duration_ms) {
+  size_t payload_bytes = 0;
+  auto it = stats.substreams.find(kSendSsrc);
+  if (it != stats.substreams.end())
+    payload_bytes = it->second.rtp_stats.MediaPayloadBytes();
+  printf("Average encode time: %d ms\n", stats.avg_encode_time_ms);
+  printf("Encode usage: %d %%\n", stats.encode_usage_percent);
+  printf("Average media bitrate: %d kbps\n",
+         duration_ms > 0 ? static_cast<int>(payload_bytes * 8 / duration_ms)
+                         : 0);
+}
+
 Loopback::Loopback(const Config& config)
     : config_(config), clock_(Clock::GetRealTimeClock()) {
 }
@@ -131,9 +145,13 @@ void Loopback::Run() {
   receive_stream->Start();
   send_stream->Start();
   capturer->Start();
+  const int64_t start_ms = clock_->TimeInMilliseconds();
 
   test::PressEnterToContinue();
 
+  PrintSendStats(send_stream->GetStats(),
+                 clock_->TimeInMilliseconds() - start_ms);
+
   capturer->Stop();
   send_stream->Stop();
   receive_stream->Stop();
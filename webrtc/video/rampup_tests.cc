@@ -27,6 +27,10 @@ namespace {
 
 static const int kMaxPacketSize = 1500;
 const uint32_t kRemoteBitrateEstimatorMinBitrateBps = 30000;
+// Long enough for the link to only add delay when it is overused.
+const size_t kLongQueueLengthPackets = 100;
+// Short enough for the link to drop packets when it is overused.
+const size_t kShortQueueLengthPackets = 5;
 
 std::vector<uint32_t> GenerateSsrcs(size_t num_streams,
                                     uint32_t ssrc_offset) {
@@ -192,10 +196,12 @@ LowRateStreamObserver::LowRateStreamObserver(
     newapi::Transport* feedback_transport,
     Clock* clock,
     size_t number_of_streams,
-    bool rtx_used)
+    bool rtx_used,
+    size_t queue_length_packets)
     : clock_(clock),
       number_of_streams_(number_of_streams),
       rtx_used_(rtx_used),
+      queue_length_packets_(queue_length_packets),
       test_done_(EventWrapper::Create()),
       rtp_parser_(RtpHeaderParser::Create()),
       feedback_transport_(feedback_transport),
@@ -222,7 +228,7 @@ LowRateStreamObserver::LowRateStreamObserver(
       this, clock, kRemoteBitrateEstimatorMinBitrateBps));
   forward_transport_config_.link_capacity_kbps =
       kHighBandwidthLimitBps / 1000;
-  forward_transport_config_.queue_length_packets = 100;  // Something large.
+  forward_transport_config_.queue_length_packets = queue_length_packets;
   test::DirectTransport::SetConfig(forward_transport_config_);
   test::DirectTransport::SetReceiver(this);
 }
@@ -293,6 +299,8 @@ std::string LowRateStreamObserver::GetModifierString() {
   str += "_";
   str += (rtx_used_ ? "" : "no");
   str += "rtx";
+  if (queue_length_packets_ < kLongQueueLengthPackets)
+    str += "_shortqueue";
   return str;
 }
 
@@ -456,10 +464,13 @@ void RampUpTest::RunRampUpTest(size_t num_streams,
 
 void RampUpTest::RunRampUpDownUpTest(size_t number_of_streams,
                                      bool rtx,
-                                     bool red) {
+                                     bool red,
+                                     size_t queue_length_packets) {
   test::DirectTransport receiver_transport;
-  LowRateStreamObserver stream_observer(
-      &receiver_transport, Clock::GetRealTimeClock(), number_of_streams, rtx);
+  LowRateStreamObserver stream_observer(&receiver_transport,
+                                        Clock::GetRealTimeClock(),
+                                        number_of_streams, rtx,
+                                        queue_length_packets);
 
   Call::Config call_config(&stream_observer);
   CreateSenderCall(call_config);
@@ -515,27 +526,33 @@ TEST_F(RampUpTest, SingleStreamWithHighStartBitrate) {
 }
 
 TEST_F(RampUpTest, UpDownUpOneStream) {
-  RunRampUpDownUpTest(1, false, false);
+  RunRampUpDownUpTest(1, false, false, kLongQueueLengthPackets);
 }
 
 TEST_F(RampUpTest, UpDownUpThreeStreams) {
-  RunRampUpDownUpTest(3, false, false);
+  RunRampUpDownUpTest(3, false, false, kLongQueueLengthPackets);
 }
 
 TEST_F(RampUpTest, UpDownUpOneStreamRtx) {
-  RunRampUpDownUpTest(1, true, false);
+  RunRampUpDownUpTest(1, true, false, kLongQueueLengthPackets);
 }
 
 TEST_F(RampUpTest, UpDownUpThreeStreamsRtx) {
-  RunRampUpDownUpTest(3, true, false);
+  RunRampUpDownUpTest(3, true, false, kLongQueueLengthPackets);
 }
 
 TEST_F(RampUpTest, UpDownUpOneStreamByRedRtx) {
-  RunRampUpDownUpTest(1, true, true);
+  RunRampUpDownUpTest(1, true, true, kLongQueueLengthPackets);
 }
 
 TEST_F(RampUpTest, UpDownUpThreeStreamsByRedRtx) {
-  RunRampUpDownUpTest(3, true, true);
+  RunRampUpDownUpTest(3, true, true, kLongQueueLengthPackets);
+}
+
+// The short queue makes the ramp-down loss-based, after which the sender
+// probes for the old bitrate as soon as the loss clears.
+TEST_F(RampUpTest, UpDownUpOneStreamShortQueue) {
+  RunRampUpDownUpTest(1, false, false, kShortQueueLengthPackets);
 }
 
 TEST_F(RampUpTest, AbsSendTimeSingleStream) {
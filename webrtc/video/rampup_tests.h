@@ -93,7 +93,8 @@ class LowRateStreamObserver : public test::DirectTransport,
   LowRateStreamObserver(newapi::Transport* feedback_transport,
                         Clock* clock,
                         size_t number_of_streams,
-                        bool rtx_used);
+                        bool rtx_used,
+                        size_t queue_length_packets);
 
   virtual void SetSendStream(VideoSendStream* send_stream);
 
@@ -108,7 +109,8 @@ class LowRateStreamObserver : public test::DirectTransport,
   bool SendRtcp(const uint8_t* packet, size_t length) override;
 
   // Produces a string similar to "1stream_nortx", depending on the values of
-  // number_of_streams_ and rtx_used_;
+  // number_of_streams_ and rtx_used_, with a "_shortqueue" suffix if the link
+  // queue is short enough for the ramp-down to be loss-based.
   std::string GetModifierString();
 
   // This method defines the state machine for the ramp up-down-up test.
@@ -126,6 +128,7 @@ class LowRateStreamObserver : public test::DirectTransport,
   Clock* const clock_;
   const size_t number_of_streams_;
   const bool rtx_used_;
+  const size_t queue_length_packets_;
   const rtc::scoped_ptr<EventWrapper> test_done_;
   const rtc::scoped_ptr<RtpHeaderParser> rtp_parser_;
   rtc::scoped_ptr<RtpRtcp> rtp_rtcp_;
@@ -153,7 +156,10 @@ class RampUpTest : public test::CallTest {
                      bool rtx,
                      bool red);
 
-  void RunRampUpDownUpTest(size_t number_of_streams, bool rtx, bool red);
+  void RunRampUpDownUpTest(size_t number_of_streams,
+                           bool rtx,
+                           bool red,
+                           size_t queue_length_packets);
 };
 }  // namespace webrtc
 #endif  // WEBRTC_VIDEO_RAMPUP_TESTS_H_
@@ -11,6 +11,7 @@
 #include <stdio.h>
 
 #include <map>
+#include <vector>
 
 #include "gflags/gflags.h"
 #include "testing/gtest/include/gtest/gtest.h"
@@ -96,6 +97,11 @@ int StdPropagationDelayMs() {
   return static_cast<int>(FLAGS_std_propagation_delay_ms);
 }
 
+DEFINE_bool(updated_rects,
+            false,
+            "Tag captured frames with the area that changed since the "
+            "previous frame, letting the encoder skip static macroblocks.");
+
 DEFINE_bool(logs, false, "print logs to stderr");
 
 DEFINE_string(
@@ -139,8 +145,11 @@ class ScreenshareLoopback : public test::Loopback {
     slides.push_back(test::ResourcePath("difficult_photo_1850_1110", "yuv"));
 
     test::FrameGenerator* frame_generator =
-        test::FrameGenerator::CreateFromYuvFile(
-            slides, flags::Width(), flags::Height(), 10 * flags::Fps());
+        flags::FLAGS_updated_rects
+            ? test::FrameGenerator::CreateFromYuvFileWithUpdatedRects(
+                  slides, flags::Width(), flags::Height(), 10 * flags::Fps())
+            : test::FrameGenerator::CreateFromYuvFile(
+                  slides, flags::Width(), flags::Height(), 10 * flags::Fps());
     test::FrameGeneratorCapturer* capturer(new test::FrameGeneratorCapturer(
         clock_, send_stream->Input(), frame_generator, flags::Fps()));
     EXPECT_TRUE(capturer->Init());
@@ -11,6 +11,9 @@
 #ifndef WEBRTC_VIDEO_FRAME_H_
 #define WEBRTC_VIDEO_FRAME_H_
 
+#include <vector>
+
+#include "webrtc/base/refcount.h"
 #include "webrtc/base/scoped_ref_ptr.h"
 #include "webrtc/common_video/interface/video_frame_buffer.h"
 #include "webrtc/common_video/rotation.h"
@@ -20,6 +23,15 @@ namespace webrtc {
 
 class VideoFrame {
  public:
+  // A rectangle, in pixels, of the frame that changed since the previous frame
+  // produced by the same source.
+  struct UpdatedRect {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
   VideoFrame();
   VideoFrame(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer,
              uint32_t timestamp,
@@ -138,6 +150,28 @@ class VideoFrame {
   // Get render time in miliseconds.
   int64_t render_time_ms() const { return render_time_ms_; }
 
+  // Optional description of the area that changed since the previous frame of
+  // the same source, e.g. the updated region of a captured screen. An empty
+  // list means that nothing changed. Sources must increase |sequence_number|
+  // by one for every frame they produce, so that consumers can detect frames
+  // dropped in between and treat the whole frame as changed instead.
+  // The description is immutable and shared by copies of the frame.
+  void set_updated_rects(uint32_t sequence_number,
+                         const std::vector<UpdatedRect>& rects);
+
+  // Forget the updated area, e.g. after the frame has been modified.
+  void clear_updated_rects() { updated_rects_ = nullptr; }
+
+  // Return true if the updated area of the frame is known.
+  bool has_updated_rects() const { return updated_rects_ != nullptr; }
+
+  uint32_t updated_rects_sequence_number() const {
+    return updated_rects_ ? updated_rects_->sequence_number : 0;
+  }
+
+  // Return the updated area, empty if it is not known.
+  const std::vector<UpdatedRect>& updated_rects() const;
+
   // Return true if underlying plane buffers are of zero size, false if not.
   bool IsZeroSize() const;
 
@@ -158,12 +192,22 @@ class VideoFrame {
   VideoFrame ConvertNativeToI420Frame() const;
 
  private:
+  struct UpdatedRects {
+    UpdatedRects(uint32_t sequence_number,
+                 const std::vector<UpdatedRect>& rects)
+        : sequence_number(sequence_number), rects(rects) {}
+
+    const uint32_t sequence_number;
+    const std::vector<UpdatedRect> rects;
+  };
+
   // An opaque reference counted handle that stores the pixel data.
   rtc::scoped_refptr<webrtc::VideoFrameBuffer> video_frame_buffer_;
   uint32_t timestamp_;
   int64_t ntp_time_ms_;
   int64_t render_time_ms_;
   VideoRotation rotation_;
+  rtc::scoped_refptr<rtc::RefCountedObject<UpdatedRects>> updated_rects_;
 };
 
 enum VideoFrameType {
@@ -193,6 +237,8 @@ class EncodedImage {
   size_t _length;
   size_t _size;
   bool _completeFrame = false;
+  // The QP of the frame, or -1 if it isn't known.
+  int qp_ = -1;
 };
 
 }  // namespace webrtc